@@ -70,6 +70,11 @@ def edit_config_file(args: List[str]) -> None:
     f()
 
 
+def bench_parser(args: List[str]) -> None:
+    from kitty_tests.bench_parser import main as bench_main
+    bench_main(args[1:])
+
+
 def namespaced(args: List[str]) -> None:
     func = namespaced_entry_points[args[1]]
     func(args[1:])
@@ -90,6 +95,7 @@ entry_points = {
 namespaced_entry_points = {k: v for k, v in entry_points.items() if k[0] not in '+@'}
 namespaced_entry_points['hold'] = hold
 namespaced_entry_points['complete'] = complete
+namespaced_entry_points['bench-parser'] = bench_parser
 
 
 def setup_openssl_environment() -> None:
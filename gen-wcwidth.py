@@ -279,36 +279,61 @@ def gen_emoji() -> None:
         p('\treturn false;\n}')
 
 
-def category_test(
-    name: str,
-    p: Callable,
+def chars_for_classes(
     classes: Iterable[str],
-    comment: str,
-    use_static: bool = False,
     extra_chars: Union[FrozenSet[int], Set[int]] = frozenset(),
     exclude: Union[Set[int], FrozenSet[int]] = frozenset(),
-    least_check_return: Optional[str] = None,
-    ascii_range: Optional[str] = None
-) -> None:
-    static = 'static inline ' if use_static else ''
+) -> Set[int]:
     chars: Set[int] = set()
     for c in classes:
         chars |= class_maps[c]
     chars |= extra_chars
     chars -= exclude
-    p(f'{static}bool\n{name}(char_type code) {{')
-    p(f'\t// {comment} ({len(chars)} codepoints)' + ' {{' '{')
-    if least_check_return is not None:
-        least = min(chars)
-        p(f'\tif (LIKELY(code < {least})) return {least_check_return};')
-    if ascii_range is not None:
-        p(f'\tif (LIKELY(0x20 <= code && code <= 0x7e)) return {ascii_range};')
-    p('\tswitch(code) {')
-    for spec in get_ranges(list(chars)):
-        write_case(spec, p)
-        p('\t\t\treturn true;')
-    p('\t} // }}}\n')
-    p('\treturn false;\n}\n')
+    return chars
+
+
+def classification_tables(p: Callable, categories: List[Tuple[int, Set[int], str]]) -> None:
+    # A two stage lookup table mapping codepoint to a mask of category bits,
+    # the high byte of the codepoint selects a block of 256 per codepoint
+    # masks, with identical blocks shared. All the categories a codepoint
+    # belongs to are fetched with two dependent loads and no branching on the
+    # codepoint value, replacing one large switch per category.
+    max_unicode = 0x10ffff
+    masks = bytearray(max_unicode + 1)
+    for bit, chars, comment in categories:
+        for c in chars:
+            masks[c] |= bit
+    blocks: List[bytes] = []
+    block_ids: Dict[bytes, int] = {}
+    index: List[int] = []
+    for b in range((max_unicode + 1) >> 8):
+        blk = bytes(masks[b << 8:(b << 8) + 256])
+        i = block_ids.get(blk)
+        if i is None:
+            i = block_ids[blk] = len(blocks)
+            blocks.append(blk)
+        index.append(i)
+    itype = 'uint8_t' if len(blocks) < 256 else 'uint16_t'
+    p('// Combined category classification for all of unicode, used by the inline')
+    p('// category testers in unicode-data.h. A two stage table keeps it compact:')
+    p('// the high byte of the codepoint selects a block of per codepoint masks via')
+    p('// category_block_index, most blocks being shared. Queries are two dependent')
+    p('// loads with no branching on the codepoint value.')
+    for bit, chars, comment in categories:
+        p(f'// {comment}: {len(chars)} codepoints')
+    p()
+    p(f'static const uint8_t category_blocks[{len(blocks)}][256] = {{' ' // {{{')
+    for blk in blocks:
+        p('\t{' + ', '.join(map(str, blk)) + '},')
+    p('}; // }}}\n')
+    p(f'static const {itype} category_block_index[{len(index)}] = {{' ' // {{{')
+    p(', '.join(map(str, index)))
+    p('}; // }}}\n')
+    p('uint8_t')
+    p('unicode_classification(char_type code) {')
+    p(f'\tif (UNLIKELY(code > 0x{max_unicode:x})) return 0;')
+    p('\treturn category_blocks[category_block_index[code >> 8]][code & 0xff];')
+    p('}\n')
 
 
 def codepoint_to_mark_map(p: Callable, mark_map: List[int]) -> Dict[int, int]:
@@ -351,23 +376,21 @@ def gen_ucd() -> None:
     cz = {c for c in class_maps if c[0] in 'CZ'}
     with create_header('kitty/unicode-data.c') as p:
         p('#include "unicode-data.h"')
-        category_test(
-                'is_combining_char', p,
+        p()
+        classification_tables(p, [
+            # the bits must match the UNICODE_CATEGORY_* defines in unicode-data.h
+            (1, chars_for_classes(
                 {c for c in class_maps if c.startswith('M')},
-                'M category (marks)',
                 # See https://github.com/harfbuzz/harfbuzz/issues/169
                 extra_chars=emoji_skin_tone_modifiers | {zwj},
-                least_check_return='false'
-        )
-        category_test(
-            'is_ignored_char', p, 'Cc Cf Cs'.split(),
-            'Control characters and non-characters',
-            extra_chars=non_characters, exclude={zwj},
-            ascii_range='false'
-        )
-        category_test('is_word_char', p, {c for c in class_maps if c[0] in 'LN'}, 'L and N categories')
-        category_test('is_CZ_category', p, cz, 'C and Z categories')
-        category_test('is_P_category', p, {c for c in class_maps if c[0] == 'P'}, 'P category (punctuation)')
+            ), 'M category (marks)'),
+            (2, chars_for_classes(
+                'Cc Cf Cs'.split(), extra_chars=non_characters, exclude={zwj},
+            ), 'Control characters and non-characters'),
+            (4, chars_for_classes({c for c in class_maps if c[0] in 'LN'}), 'L and N categories'),
+            (8, chars_for_classes(cz), 'C and Z categories'),
+            (16, chars_for_classes({c for c in class_maps if c[0] == 'P'}), 'P category (punctuation)'),
+        ])
         mark_map = [0] + list(sorted(marks))
         p('char_type codepoint_for_mark(combining_type m) {')
         p(f'\tstatic char_type map[{len(mark_map)}] =', '{', ', '.join(map(str, mark_map)), '}; // {{{ mapping }}}')
@@ -423,34 +446,21 @@ def gen_names() -> None:
         p(', '.join(f'"{w}"' for w in cwords))
         p('}; // }}}\n')
 
-        # Array of sets of marks for each word
+        # Map of word to the set of marks for codepoints whose name contains it
         word_to_marks = {word_rmap[w]: frozenset(map(cp_to_mark.__getitem__, cps)) for w, cps in word_search_map.items()}
-        all_mark_groups = frozenset(word_to_marks.values())
-        array = [0]
-        mg_to_offset = {}
-        for mg in all_mark_groups:
-            mg_to_offset[mg] = len(array)
-            array.append(len(mg))
-            array.extend(sorted(mg))
-        p(f'static const char_type mark_groups[{len(array)}] = {{' ' // {{{')
-        p(', '.join(map(str, array)))
-        p('}; // }}}\n')
-        offsets_array = []
-        for wi, w in enumerate(word_map):
-            mg = word_to_marks[wi]
-            offsets_array.append(mg_to_offset[mg])
-        p(f'static const char_type mark_to_offset[{len(offsets_array)}] = {{' ' // {{{')
-        p(', '.join(map(str, offsets_array)))
-        p('}; // }}}\n')
 
-        # The trie
-        p('typedef struct { uint32_t children_offset; uint32_t match_offset; } word_trie;\n')
+        # The trie. Marks are laid out in depth-first order so that the
+        # matches for any prefix are the contiguous range covering its
+        # node's entire sub-trie, which makes prefix lookup a simple walk
+        # followed by a single range read, no traversal of the sub-trie.
         all_trie_nodes: List['TrieNode'] = []  # noqa
 
         class TrieNode:
 
             def __init__(self) -> None:
+                self.marks: FrozenSet[int] = frozenset()
                 self.match_offset = 0
+                self.match_count = 0
                 self.children_offset = 0
                 self.children: Dict[int, int] = {}
 
@@ -461,7 +471,7 @@ def gen_names() -> None:
                 return self.children[letter]
 
             def __str__(self) -> str:
-                return f'{{ .children_offset={self.children_offset}, .match_offset={self.match_offset} }}'
+                return f'{{ .children_offset={self.children_offset}, .match_offset={self.match_offset}, .match_count={self.match_count} }}'
 
         root = TrieNode()
         all_trie_nodes.append(root)
@@ -471,10 +481,27 @@ def gen_names() -> None:
             for letter in map(ord, word):
                 idx = parent.add_letter(letter)
                 parent = all_trie_nodes[idx]
-            parent.match_offset = offsets_array[word_idx]
+            parent.marks = word_to_marks[word_idx]
 
         for i, word in enumerate(word_map):
             add_word(i, word)
+
+        match_marks: List[int] = []
+
+        def layout_matches(node: TrieNode) -> None:
+            # A mark can appear under more than one descendant word, the
+            # duplicates are harmless as lookup results form a set
+            node.match_offset = len(match_marks)
+            match_marks.extend(sorted(node.marks))
+            for child_offset in node.children.values():
+                layout_matches(all_trie_nodes[child_offset])
+            node.match_count = len(match_marks) - node.match_offset
+
+        sys.setrecursionlimit(max(sys.getrecursionlimit(), 10 * max(map(len, word_map))))
+        layout_matches(root)
+        if len(mark_to_cp) > 0xffff:
+            raise SystemExit('Too many marks for the uint16_t match_marks array')
+
         children_array = [0]
         for node in all_trie_nodes:
             if node.children:
@@ -483,6 +510,10 @@ def gen_names() -> None:
                 for letter, child_offset in node.children.items():
                     children_array.append((child_offset << 8) | (letter & 0xff))
 
+        p(f'static const uint16_t match_marks[{len(match_marks)}] = {{' ' // {{{')
+        p(', '.join(map(str, match_marks)))
+        p('}; // }}}\n')
+        p('typedef struct { uint32_t children_offset; uint32_t match_offset; uint32_t match_count; } word_trie;\n')
         p(f'static const word_trie all_trie_nodes[{len(all_trie_nodes)}] = {{' ' // {{{')
         p(',\n'.join(map(str, all_trie_nodes)))
         p('\n}; // }}}\n')
@@ -84,15 +84,47 @@ toggleWatch(EventLoopData *eld, id_type watch_id, int enabled) {
 
 static id_type timer_counter = 0;
 
-static int
-compare_timers(const void *a_, const void *b_) {
-    const Timer *a = (const Timer*)a_, *b = (const Timer*)b_;
-    return (a->trigger_at > b->trigger_at) ? 1 : (a->trigger_at < b->trigger_at) ? -1 : 0;
+// The timers are kept as a binary min-heap on trigger_at, so finding the next
+// deadline is O(1) and re-scheduling is O(log n) instead of a qsort of the
+// whole array on every change. Deadlines of slow timers (cursor blink, repaint
+// delay, etc.) are additionally quantized to a common grain, so that such
+// timers across many windows collapse into a single wakeup instead of each
+// waking the event loop a few hundred microseconds apart.
+
+#define TIMER_COALESCE_GRAIN ms_to_monotonic_t(2ll)
+
+static inline monotonic_t
+quantize_trigger_at(monotonic_t trigger_at, monotonic_t interval) {
+    // only timers slow enough to tolerate a couple of ms of jitter are coalesced
+    if (interval < 8 * TIMER_COALESCE_GRAIN || trigger_at == MONOTONIC_T_MAX) return trigger_at;
+    return ((trigger_at + TIMER_COALESCE_GRAIN - 1) / TIMER_COALESCE_GRAIN) * TIMER_COALESCE_GRAIN;
 }
 
 static inline void
-update_timers(EventLoopData *eld) {
-    if (eld->timers_count > 1) qsort(eld->timers, eld->timers_count, sizeof(eld->timers[0]), compare_timers);
+timer_swap(EventLoopData *eld, nfds_t x, nfds_t y) {
+    Timer t = eld->timers[x]; eld->timers[x] = eld->timers[y]; eld->timers[y] = t;
+}
+
+static void
+sift_up(EventLoopData *eld, nfds_t i) {
+    while (i > 0) {
+        nfds_t parent = (i - 1) / 2;
+        if (eld->timers[parent].trigger_at <= eld->timers[i].trigger_at) break;
+        timer_swap(eld, parent, i);
+        i = parent;
+    }
+}
+
+static void
+sift_down(EventLoopData *eld, nfds_t i) {
+    while (true) {
+        nfds_t smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < eld->timers_count && eld->timers[left].trigger_at < eld->timers[smallest].trigger_at) smallest = left;
+        if (right < eld->timers_count && eld->timers[right].trigger_at < eld->timers[smallest].trigger_at) smallest = right;
+        if (smallest == i) break;
+        timer_swap(eld, i, smallest);
+        i = smallest;
+    }
 }
 
 id_type
@@ -104,19 +136,32 @@ addTimer(EventLoopData *eld, const char *name, monotonic_t interval, int enabled
     Timer *t = eld->timers + eld->timers_count++;
     t->interval = interval;
     t->name = name;
-    t->trigger_at = enabled ? monotonic() + interval : MONOTONIC_T_MAX;
+    t->trigger_at = enabled ? quantize_trigger_at(monotonic() + interval, interval) : MONOTONIC_T_MAX;
     t->repeats = repeats;
     t->callback = cb;
     t->callback_data = cb_data;
     t->free = free;
     t->id = ++timer_counter;
-    update_timers(eld);
+    sift_up(eld, eld->timers_count - 1);
     return timer_counter;
 }
 
 void
 removeTimer(EventLoopData *eld, id_type timer_id) {
-    removeX(timers, timer_id, update_timers);
+    for (nfds_t i = 0; i < eld->timers_count; i++) {
+        if (eld->timers[i].id == timer_id) {
+            if (eld->timers[i].callback_data && eld->timers[i].free) {
+                eld->timers[i].free(eld->timers[i].id, eld->timers[i].callback_data);
+                eld->timers[i].callback_data = NULL; eld->timers[i].free = NULL;
+            }
+            eld->timers_count--;
+            if (i < eld->timers_count) {
+                eld->timers[i] = eld->timers[eld->timers_count];
+                sift_down(eld, i); sift_up(eld, i);
+            }
+            break;
+        }
+    }
 }
 
 void
@@ -131,10 +176,10 @@ void
 toggleTimer(EventLoopData *eld, id_type timer_id, int enabled) {
     for (nfds_t i = 0; i < eld->timers_count; i++) {
         if (eld->timers[i].id == timer_id) {
-            monotonic_t trigger_at = enabled ? (monotonic() + eld->timers[i].interval) : MONOTONIC_T_MAX;
+            monotonic_t trigger_at = enabled ? quantize_trigger_at(monotonic() + eld->timers[i].interval, eld->timers[i].interval) : MONOTONIC_T_MAX;
             if (trigger_at != eld->timers[i].trigger_at) {
                 eld->timers[i].trigger_at = trigger_at;
-                update_timers(eld);
+                sift_down(eld, i); sift_up(eld, i);
             }
             break;
         }
@@ -195,13 +240,19 @@ dispatchTimers(EventLoopData *eld) {
     static struct { timer_callback_func func; id_type id; void* data; bool repeats; } dispatches[sizeof(eld->timers)/sizeof(eld->timers[0])];
     unsigned num_dispatches = 0;
     monotonic_t now = monotonic();
-    for (nfds_t i = 0; i < eld->timers_count && eld->timers[i].trigger_at <= now; i++) {
-        eld->timers[i].trigger_at = now + eld->timers[i].interval;
-        dispatches[num_dispatches].func = eld->timers[i].callback;
-        dispatches[num_dispatches].id = eld->timers[i].id;
-        dispatches[num_dispatches].data = eld->timers[i].callback_data;
-        dispatches[num_dispatches].repeats = eld->timers[i].repeats;
+    // quantized deadlines make timers that are due close together all fire
+    // during this single wakeup
+    while (eld->timers_count && eld->timers[0].trigger_at <= now && num_dispatches < arraysz(dispatches)) {
+        Timer *t = eld->timers;
+        dispatches[num_dispatches].func = t->callback;
+        dispatches[num_dispatches].id = t->id;
+        dispatches[num_dispatches].data = t->callback_data;
+        dispatches[num_dispatches].repeats = t->repeats;
         num_dispatches++;
+        monotonic_t trigger_at = quantize_trigger_at(now + t->interval, t->interval);
+        // a zero interval timer fires once per dispatch, not in an endless loop
+        t->trigger_at = trigger_at > now ? trigger_at : now + 1;
+        sift_down(eld, 0);
     }
     // we dispatch separately so that the callbacks can modify timers
     for (unsigned i = 0; i < num_dispatches; i++) {
@@ -210,7 +261,6 @@ dispatchTimers(EventLoopData *eld) {
             removeTimer(eld, dispatches[i].id);
         }
     }
-    if (num_dispatches) update_timers(eld);
     return num_dispatches;
 }
 
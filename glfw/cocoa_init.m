@@ -862,3 +862,13 @@ void _glfwPlatformUpdateTimer(unsigned long long timer_id, monotonic_t interval,
         }
     }
 }
+
+// The Cocoa main loop is a CFRunLoop, not the poll() based one used on
+// Linux, so fd watches are not supported here
+unsigned long long _glfwPlatformAddLoopWatch(int fd UNUSED, int events UNUSED, GLFWloopwatchfun callback UNUSED, void *callback_data UNUSED) {
+    return 0;
+}
+
+void _glfwPlatformRemoveLoopWatch(unsigned long long watch_id UNUSED) { }
+
+void _glfwPlatformToggleLoopWatch(unsigned long long watch_id UNUSED, bool enabled UNUSED) { }
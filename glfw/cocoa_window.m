@@ -2142,6 +2142,21 @@ const char* _glfwPlatformGetClipboardString(void)
     return _glfw.ns.clipboardString;
 }
 
+bool _glfwPlatformRequestClipboardString(bool primary UNUSED, GLFWclipboardchunkfun callback, void* user_data)
+{
+    // There is no primary selection and no incremental transfer protocol on
+    // Cocoa, so just deliver the pasteboard contents as a single chunk
+    const char* text = _glfwPlatformGetClipboardString();
+    if (text && text[0])
+        callback(text, strlen(text), user_data);
+    callback(NULL, 0, user_data);
+    return true;
+}
+
+void _glfwPlatformResumeClipboardRequest(void)
+{
+}
+
 EGLenum _glfwPlatformGetEGLPlatform(EGLint** attribs)
 {
     if (_glfw.egl.ANGLE_platform_angle)
@@ -489,6 +489,28 @@ GLFWAPI void glfwSwapBuffers(GLFWwindow* handle)
     window->context.swapBuffers(window);
 }
 
+GLFWAPI bool glfwSwapBuffersWithDamage(GLFWwindow* handle, const GLFWDamageRect* rects, int count)
+{
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    assert(window != NULL);
+
+    _GLFW_REQUIRE_INIT_OR_RETURN(false);
+
+    if (window->context.client == GLFW_NO_API)
+    {
+        _glfwInputError(GLFW_NO_WINDOW_CONTEXT,
+                        "Cannot swap buffers of a window that has no OpenGL or OpenGL ES context");
+        return false;
+    }
+
+    if (count > 0 && window->context.swapBuffersWithDamage &&
+        window->context.swapBuffersWithDamage(window, rects, count))
+        return true;
+
+    window->context.swapBuffers(window);
+    return false;
+}
+
 GLFWAPI void glfwSwapInterval(int interval)
 {
     _GLFWwindow* window;
@@ -203,6 +203,24 @@ static void swapBuffersEGL(_GLFWwindow* window)
     eglSwapBuffers(_glfw.egl.display, window->context.egl.surface);
 }
 
+static bool swapBuffersWithDamageEGL(_GLFWwindow* window, const GLFWDamageRect* rects, int count)
+{
+    if (!_glfw.egl.SwapBuffersWithDamageKHR)
+        return false;
+
+    if (window != _glfwPlatformGetTls(&_glfw.contextSlot))
+    {
+        _glfwInputError(GLFW_PLATFORM_ERROR,
+                        "EGL: The context must be current on the calling thread when swapping buffers");
+        return false;
+    }
+
+    // GLFWDamageRect is four ints laid out the way the extension expects
+    return eglSwapBuffersWithDamageKHR(_glfw.egl.display,
+                                       window->context.egl.surface,
+                                       (const EGLint*) rects, count) == EGL_TRUE;
+}
+
 static void swapIntervalEGL(int interval)
 {
     eglSwapInterval(_glfw.egl.display, interval);
@@ -428,6 +446,13 @@ bool _glfwInitEGL(void)
         extensionSupportedEGL("EGL_KHR_get_all_proc_addresses");
     _glfw.egl.KHR_context_flush_control =
         extensionSupportedEGL("EGL_KHR_context_flush_control");
+    _glfw.egl.KHR_swap_buffers_with_damage =
+        extensionSupportedEGL("EGL_KHR_swap_buffers_with_damage");
+    if (_glfw.egl.KHR_swap_buffers_with_damage)
+    {
+        _glfw.egl.SwapBuffersWithDamageKHR = (PFN_eglSwapBuffersWithDamageKHR)
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    }
 
     return true;
 }
@@ -714,6 +739,7 @@ bool _glfwCreateContextEGL(_GLFWwindow* window,
 
     window->context.makeCurrent = makeContextCurrentEGL;
     window->context.swapBuffers = swapBuffersEGL;
+    window->context.swapBuffersWithDamage = swapBuffersWithDamageEGL;
     window->context.swapInterval = swapIntervalEGL;
     window->context.extensionSupported = extensionSupportedEGL;
     window->context.getProcAddress = getProcAddressEGL;
@@ -184,6 +184,24 @@ class Function:
             )
         return ans
 
+    def static_declaration(self) -> str:
+        # the wrapper macros rename the public names, so the statically
+        # linked symbols are referenced via asm labels; weak, as the symbols
+        # of other platforms backends are absent
+        return 'extern {restype} {name}_static({args}) __asm__(SYM("{name}")) WEAK;'.format(
+            restype=self.restype,
+            name=self.name,
+            args=', '.join(a.type for a in self.args)
+        )
+
+    def static_bind(self) -> str:
+        ans = '{name}_impl = {name}_static;'.format(name=self.name)
+        if self.check_fail:
+            ans += '\n    if ({name}_impl == NULL) fail("The statically linked GLFW is missing the function %s", "{name}");'.format(
+                name=self.name
+            )
+        return ans
+
 
 def generate_wrappers(glfw_header: str) -> None:
     with open(glfw_header) as f:
@@ -214,6 +232,8 @@ def generate_wrappers(glfw_header: str) -> None:
     const char* glfwGetPrimarySelectionString(GLFWwindow* window, void)
     int glfwGetNativeKeyForName(const char* key_name, int case_sensitive)
     void glfwRequestWaylandFrameEvent(GLFWwindow *handle, unsigned long long id, GLFWwaylandframecallbackfunc callback)
+    int glfwX11FrameEventsAvailable(void)
+    void glfwRequestX11FrameEvent(GLFWwindow *handle, unsigned long long id, GLFWwaylandframecallbackfunc callback)
     unsigned long long glfwDBusUserNotify(const char *app_name, const char* icon, const char *summary, const char *body, \
 const char *action_text, int32_t timeout, GLFWDBusnotificationcreatedfun callback, void *data)
     void glfwDBusSetUserNotificationHandler(GLFWDBusnotificationactivatedfun handler)
@@ -261,12 +281,41 @@ const char* load_glfw(const char* path);
 #define GFW_EXTERN
 #include "data-types.h"
 #include "glfw-wrapper.h"
+
+#define fail(msg, ...) { snprintf(buf, sizeof(buf), msg, __VA_ARGS__); return buf; }
+
+#ifdef KITTY_STATIC_GLFW
+// The GLFW backend is linked into this binary, bind the wrapper pointers
+// directly to its symbols instead of dlopen()ing a backend library,
+// removing the dlsym indirection and letting LTO see across the boundary.
+
+#ifdef __APPLE__
+#define SYM(x) "_" x
+#else
+#define SYM(x) x
+#endif
+#define WEAK __attribute__((weak))
+
+STATIC_DECLS
+
+const char*
+load_glfw(const char* path UNUSED) {
+    static char buf[2048];
+
+    STATIC_BIND
+
+    return NULL;
+}
+
+void
+unload_glfw(void) {}
+
+#else  // dlopen based loading
+
 #include <dlfcn.h>
 
 static void* handle = NULL;
 
-#define fail(msg, ...) { snprintf(buf, sizeof(buf), msg, __VA_ARGS__); return buf; }
-
 const char*
 load_glfw(const char* path) {
     static char buf[2048];
@@ -283,7 +332,10 @@ void
 unload_glfw(void) {
     if (handle) { dlclose(handle); handle = NULL; }
 }
-'''.replace('LOAD', '\n\n    '.join(f.load() for f in functions))
+#endif
+'''.replace('LOAD', '\n\n    '.join(f.load() for f in functions)).replace(
+        'STATIC_DECLS', '\n'.join(f.static_declaration() for f in functions)).replace(
+        'STATIC_BIND', '\n\n    '.join(f.static_bind() for f in functions))
     with open('../kitty/glfw-wrapper.c', 'w') as f:
         f.write(code)
 
@@ -1761,6 +1761,8 @@ typedef void (* GLFWjoystickfun)(int,int);
 
 typedef void (* GLFWuserdatafun)(unsigned long long, void*);
 typedef void (* GLFWtickcallback)(void*);
+typedef void (* GLFWloopwatchfun)(int fd, int events, void *data);
+typedef bool (* GLFWclipboardchunkfun)(const char *data, size_t sz, void *user_data);
 
 /*! @brief Video mode type.
  *
@@ -1851,6 +1853,26 @@ typedef struct GLFWimage
     unsigned char* pixels;
 } GLFWimage;
 
+/*! @brief Damage rectangle
+ *
+ *  This describes a rectangular region of a window's framebuffer that
+ *  changed since the previous swap, in framebuffer coordinates with the
+ *  origin at the bottom-left, matching OpenGL and EGL conventions.
+ *
+ *  @sa @ref glfwSwapBuffersWithDamage
+ *
+ *  @ingroup window
+ */
+typedef struct GLFWDamageRect
+{
+    /*! The bottom-left corner of this rectangle, in pixels.
+     */
+    int x, y;
+    /*! The size, in pixels, of this rectangle.
+     */
+    int width, height;
+} GLFWDamageRect;
+
 /*! @brief Gamepad input state
  *
  *  This describes the input state of a gamepad.
@@ -1917,6 +1939,14 @@ GLFWAPI void glfwStopMainLoop(void);
 GLFWAPI unsigned long long glfwAddTimer(monotonic_t interval, bool repeats, GLFWuserdatafun callback, void * callback_data, GLFWuserdatafun free_callback);
 GLFWAPI void glfwUpdateTimer(unsigned long long timer_id, monotonic_t interval, bool enabled);
 GLFWAPI void glfwRemoveTimer(unsigned long long);
+/* Register an fd with the main loop poller, so that one wait syscall covers
+ * display events, timers and application fds. events is a poll(2) events
+ * mask, the callback is invoked from the main thread with the revents that
+ * fired. Returns 0 on platforms whose main loop is not poller based (macOS).
+ */
+GLFWAPI unsigned long long glfwAddLoopWatch(int fd, int events, GLFWloopwatchfun callback, void *callback_data);
+GLFWAPI void glfwRemoveLoopWatch(unsigned long long watch_id);
+GLFWAPI void glfwToggleLoopWatch(unsigned long long watch_id, bool enabled);
 
 /*! @brief Terminates the GLFW library.
  *
@@ -5408,6 +5438,57 @@ GLFWAPI void glfwSetClipboardString(GLFWwindow* window, const char* string);
  */
 GLFWAPI const char* glfwGetClipboardString(GLFWwindow* window);
 
+/*! @brief Requests the contents of the clipboard, delivered in chunks.
+ *
+ *  This function requests the contents of the system clipboard, or of the
+ *  primary selection where one exists, as a UTF-8 encoded string.  The data
+ *  is delivered by calling the specified callback zero or more times with
+ *  non-empty chunks, followed by exactly one call with a size of zero to
+ *  mark the end of the transfer.  On X11 the data is read incrementally via
+ *  the INCR protocol, so only one chunk is held in memory at a time and the
+ *  event loop keeps running while the transfer is in progress; on other
+ *  platforms the whole string is delivered as a single chunk, possibly
+ *  before this function returns.
+ *
+ *  The callback returns whether the caller is ready for more data.  When it
+ *  returns `false` the transfer is paused, leaving the source client
+ *  waiting, until @ref glfwResumeClipboardRequest is called.  The return
+ *  value is ignored for the final, empty call.
+ *
+ *  Only one request may be in progress at a time and @ref
+ *  glfwGetClipboardString must not be called while one is.
+ *
+ *  @param[in] window Deprecated.  Any valid window or `NULL`.
+ *  @param[in] primary Whether to read the primary selection instead of the
+ *  clipboard, on platforms that have one.
+ *  @param[in] callback The function to deliver the data to.
+ *  @param[in] user_data Passed through to the callback.
+ *  @return `true` if the request was started, `false` if a request is
+ *  already in progress.
+ *
+ *  @thread_safety This function must only be called from the main thread.
+ *
+ *  @sa @ref clipboard
+ *  @sa @ref glfwGetClipboardString
+ *
+ *  @ingroup input
+ */
+GLFWAPI bool glfwRequestClipboardString(GLFWwindow* window, bool primary, GLFWclipboardchunkfun callback, void* user_data);
+
+/*! @brief Resumes a paused clipboard request.
+ *
+ *  This function resumes a transfer started by @ref
+ *  glfwRequestClipboardString that was paused by its callback returning
+ *  `false`.  It is a no-op when no transfer is paused.
+ *
+ *  @thread_safety This function must only be called from the main thread.
+ *
+ *  @sa @ref glfwRequestClipboardString
+ *
+ *  @ingroup input
+ */
+GLFWAPI void glfwResumeClipboardRequest(void);
+
 /*! @brief Returns the GLFW time.
  *
  *  This function returns the current GLFW time, in seconds.  Unless the time
@@ -5528,6 +5609,38 @@ GLFWAPI GLFWwindow* glfwGetCurrentContext(void);
  */
 GLFWAPI void glfwSwapBuffers(GLFWwindow* window);
 
+/*! @brief Swaps the buffers of the specified window, reporting damage.
+ *
+ *  This function is like @ref glfwSwapBuffers but additionally reports the
+ *  regions of the framebuffer that changed since the previous swap, so that
+ *  the compositor can recomposite only those instead of the whole surface.
+ *  The pixels outside the given rectangles must be identical to the frame
+ *  presented by the previous swap of this window.
+ *
+ *  When the context does not support reporting damage (currently only EGL
+ *  with `EGL_KHR_swap_buffers_with_damage` does) this falls back to a full
+ *  swap and returns `false`.
+ *
+ *  @param[in] window The window whose buffers to swap.
+ *  @param[in] rects The damaged regions, in framebuffer coordinates with the
+ *  origin at the bottom-left.
+ *  @param[in] count The number of damaged regions.
+ *  @return `true` if the damage information was passed to the platform.
+ *
+ *  @errors Possible errors include @ref GLFW_NOT_INITIALIZED, @ref
+ *  GLFW_NO_WINDOW_CONTEXT and @ref GLFW_PLATFORM_ERROR.
+ *
+ *  @remark __EGL:__ The context of the specified window must be current on the
+ *  calling thread.
+ *
+ *  @thread_safety This function may be called from any thread.
+ *
+ *  @sa @ref glfwSwapBuffers
+ *
+ *  @ingroup window
+ */
+GLFWAPI bool glfwSwapBuffersWithDamage(GLFWwindow* window, const GLFWDamageRect* rects, int count);
+
 /*! @brief Sets the swap interval for the current context.
  *
  *  This function sets the swap interval for the current OpenGL or OpenGL ES
@@ -125,24 +125,30 @@ message_handler(DBusConnection *conn UNUSED, DBusMessage *msg, void *user_data)
     // To monitor signals from IBUS, use
     //  dbus-monitor --address `ibus address` "type='signal',interface='org.freedesktop.IBus.InputContext'"
     _GLFWIBUSData *ibus = (_GLFWIBUSData*)user_data;
-    (void)ibus;
     const char *text;
     switch(glfw_dbus_match_signal(msg, IBUS_INPUT_INTERFACE, "CommitText", "UpdatePreeditText", "HidePreeditText", "ShowPreeditText", NULL)) {
         case 0:
             text = get_ibus_text_from_message(msg);
             debug("IBUS: CommitText: '%s'\n", text ? text : "(nil)");
+            ibus->preedit_active = false;
+            ibus->engine_has_composed = true;
             send_text(text, 2);
             break;
         case 1:
             text = get_ibus_text_from_message(msg);
+            ibus->preedit_active = text && text[0];
+            if (ibus->preedit_active) ibus->engine_has_composed = true;
             send_text(text, 1);
             debug("IBUS: UpdatePreeditText: '%s'\n", text ? text : "(nil)");
             break;
         case 2:
             debug("IBUS: HidePreeditText\n");
+            ibus->preedit_active = false;
             break;
         case 3:
             debug("IBUS: ShowPreeditText\n");
+            ibus->preedit_active = true;
+            ibus->engine_has_composed = true;
             break;
     }
     return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
@@ -243,6 +249,8 @@ input_context_created(DBusMessage *msg, const char* errmsg, void *data) {
     _GLFWIBUSData *ibus = (_GLFWIBUSData*)data;
     free((void*)ibus->input_ctx_path);
     ibus->input_ctx_path = _glfw_strdup(path);
+    ibus->preedit_active = false;
+    ibus->pending_key_replies = 0;
     if (!ibus->input_ctx_path) return;
     dbus_bus_add_match(ibus->conn, "type='signal',interface='org.freedesktop.IBus.InputContext'", NULL);
     DBusObjectPathVTable ibus_vtable = {.message_function = message_handler};
@@ -398,6 +406,7 @@ void
 key_event_processed(DBusMessage *msg, const char* errmsg, void *data) {
     uint32_t handled = 0;
     _GLFWIBUSKeyEvent *ev = (_GLFWIBUSKeyEvent*)data;
+    if (ev->ibus && ev->ibus->pending_key_replies) ev->ibus->pending_key_replies--;
     // Restore key's text from the text embedded in the structure.
     ev->glfw_ev.text = ev->__embedded_text;
     bool is_release = ev->glfw_ev.action == GLFW_RELEASE;
@@ -409,16 +418,38 @@ key_event_processed(DBusMessage *msg, const char* errmsg, void *data) {
         glfw_dbus_get_args(msg, "Failed to get IBUS handled key from reply", DBUS_TYPE_BOOLEAN, &handled, DBUS_TYPE_INVALID);
         debug("IBUS processed native_key: 0x%x release: %d handled: %u\n", ev->glfw_ev.native_key, is_release, handled);
     }
+    if (handled && ev->ibus) ev->ibus->engine_has_composed = true;
     glfw_xkb_key_from_ime(ev, handled ? true : false, failed);
     free(ev);
 }
 
+static inline bool
+is_fast_path_key(const _GLFWIBUSKeyEvent *ev) {
+    // Printable ASCII without the modifiers that engines use for their
+    // trigger shortcuts, such as ctrl+space
+    if (ev->ibus_keysym < 0x20 || ev->ibus_keysym > 0x7e) return false;
+    return (ev->glfw_ev.mods & (GLFW_MOD_CONTROL | GLFW_MOD_ALT | GLFW_MOD_SUPER)) == 0;
+}
+
 bool
 ibus_process_key(const _GLFWIBUSKeyEvent *ev_, _GLFWIBUSData *ibus) {
     if (!check_connection(ibus)) return false;
+    // Fast path: while the engine is passive, deliver plain ASCII keys
+    // directly instead of paying a daemon round trip per keystroke. The
+    // engine is considered passive until it handles a key or shows pre-edit
+    // text, both of which disable the fast path for the life of the
+    // process. Keys an engine could be interested in, such as its trigger
+    // shortcut, are always forwarded, and so is everything while a reply is
+    // outstanding, which keeps delivery ordered whenever the daemon is
+    // involved at all.
+    if (!ibus->engine_has_composed && !ibus->preedit_active && !ibus->pending_key_replies && is_fast_path_key(ev_)) {
+        debug("IBUS: delivering key without daemon round trip\n");
+        return false;
+    }
     _GLFWIBUSKeyEvent *ev = calloc(1, sizeof(_GLFWIBUSKeyEvent));
     if (!ev) return false;
     memcpy(ev, ev_, sizeof(_GLFWIBUSKeyEvent));
+    ev->ibus = ibus;
     // Put the key's text in a field IN the structure, for proper serialization.
     if (ev->glfw_ev.text) strncpy(ev->__embedded_text, ev->glfw_ev.text, sizeof(ev->__embedded_text) - 1);
     ev->glfw_ev.text = NULL;
@@ -431,5 +462,6 @@ ibus_process_key(const _GLFWIBUSKeyEvent *ev_, _GLFWIBUSData *ibus) {
         free(ev);
         return false;
     }
+    ibus->pending_key_replies++;
     return true;
 }
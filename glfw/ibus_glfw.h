@@ -33,6 +33,14 @@
 
 typedef struct {
     bool ok, inited;
+    // true while the engine is showing pre-edit text, all keys must go
+    // through it to keep composition ordering intact
+    bool preedit_active;
+    // set once the engine handles a key or shows pre-edit text, which
+    // permanently disables the fast path that skips the daemon round trip
+    bool engine_has_composed;
+    // number of ProcessKeyEvent calls whose replies are still outstanding
+    unsigned pending_key_replies;
     time_t address_file_mtime;
     DBusConnection *conn;
     const char *input_ctx_path, *address_file_name, *address;
@@ -42,6 +50,7 @@ typedef struct {
     xkb_keycode_t ibus_keycode;
     xkb_keysym_t ibus_keysym;
     GLFWid window_id;
+    _GLFWIBUSData *ibus;
     GLFWkeyevent glfw_ev;
     char __embedded_text[64];
 } _GLFWIBUSKeyEvent;
@@ -369,6 +369,19 @@ GLFWAPI void glfwRemoveTimer(unsigned long long timer_id) {
     _glfwPlatformRemoveTimer(timer_id);
 }
 
+GLFWAPI unsigned long long glfwAddLoopWatch(int fd, int events, GLFWloopwatchfun callback, void *callback_data)
+{
+    return _glfwPlatformAddLoopWatch(fd, events, callback, callback_data);
+}
+
+GLFWAPI void glfwRemoveLoopWatch(unsigned long long watch_id) {
+    _glfwPlatformRemoveLoopWatch(watch_id);
+}
+
+GLFWAPI void glfwToggleLoopWatch(unsigned long long watch_id, bool enabled) {
+    _glfwPlatformToggleLoopWatch(watch_id, enabled);
+}
+
 GLFWAPI GLFWapplicationclosefun glfwSetApplicationCloseCallback(GLFWapplicationclosefun cbfun)
 {
     _GLFW_REQUIRE_INIT_OR_RETURN(NULL);
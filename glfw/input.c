@@ -1545,6 +1545,20 @@ GLFWAPI const char* glfwGetClipboardString(GLFWwindow* handle UNUSED)
     return _glfwPlatformGetClipboardString();
 }
 
+GLFWAPI bool glfwRequestClipboardString(GLFWwindow* handle UNUSED, bool primary, GLFWclipboardchunkfun callback, void* user_data)
+{
+    assert(callback != NULL);
+
+    _GLFW_REQUIRE_INIT_OR_RETURN(false);
+    return _glfwPlatformRequestClipboardString(primary, callback, user_data);
+}
+
+GLFWAPI void glfwResumeClipboardRequest(void)
+{
+    _GLFW_REQUIRE_INIT();
+    _glfwPlatformResumeClipboardRequest();
+}
+
 #if defined(_GLFW_X11) || defined(_GLFW_WAYLAND)
 GLFWAPI void glfwSetPrimarySelectionString(GLFWwindow* handle UNUSED, const char* string)
 {
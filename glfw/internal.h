@@ -82,6 +82,7 @@ typedef struct _GLFWmutex       _GLFWmutex;
 
 typedef void (* _GLFWmakecontextcurrentfun)(_GLFWwindow*);
 typedef void (* _GLFWswapbuffersfun)(_GLFWwindow*);
+typedef bool (* _GLFWswapbufferswithdamagefun)(_GLFWwindow*,const GLFWDamageRect*,int);
 typedef void (* _GLFWswapintervalfun)(int);
 typedef int (* _GLFWextensionsupportedfun)(const char*);
 typedef GLFWglproc (* _GLFWgetprocaddressfun)(const char*);
@@ -388,6 +389,7 @@ struct _GLFWcontext
 
     _GLFWmakecontextcurrentfun  makeCurrent;
     _GLFWswapbuffersfun         swapBuffers;
+    _GLFWswapbufferswithdamagefun swapBuffersWithDamage;
     _GLFWswapintervalfun        swapInterval;
     _GLFWextensionsupportedfun  extensionSupported;
     _GLFWgetprocaddressfun      getProcAddress;
@@ -667,6 +669,8 @@ const char* _glfwPlatformGetClipboardString(void);
 void _glfwPlatformSetPrimarySelectionString(const char* string);
 const char* _glfwPlatformGetPrimarySelectionString(void);
 #endif
+bool _glfwPlatformRequestClipboardString(bool primary, GLFWclipboardchunkfun callback, void* user_data);
+void _glfwPlatformResumeClipboardRequest(void);
 
 bool _glfwPlatformInitJoysticks(void);
 void _glfwPlatformTerminateJoysticks(void);
@@ -839,5 +843,8 @@ void _glfwPlatformStopMainLoop(void);
 unsigned long long _glfwPlatformAddTimer(monotonic_t interval, bool repeats, GLFWuserdatafun callback, void *callback_data, GLFWuserdatafun free_callback);
 void _glfwPlatformUpdateTimer(unsigned long long timer_id, monotonic_t interval, bool enabled);
 void _glfwPlatformRemoveTimer(unsigned long long timer_id);
+unsigned long long _glfwPlatformAddLoopWatch(int fd, int events, GLFWloopwatchfun callback, void *callback_data);
+void _glfwPlatformRemoveLoopWatch(unsigned long long watch_id);
+void _glfwPlatformToggleLoopWatch(unsigned long long watch_id, bool enabled);
 
 char* _glfw_strdup(const char* source);
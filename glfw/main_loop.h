@@ -49,3 +49,15 @@ void _glfwPlatformUpdateTimer(unsigned long long timer_id, monotonic_t interval,
     changeTimerInterval(&_glfw.GLFW_LOOP_BACKEND.eventLoopData, timer_id, interval);
     toggleTimer(&_glfw.GLFW_LOOP_BACKEND.eventLoopData, timer_id, enabled);
 }
+
+unsigned long long _glfwPlatformAddLoopWatch(int fd, int events, GLFWloopwatchfun callback, void *callback_data) {
+    return addWatch(&_glfw.GLFW_LOOP_BACKEND.eventLoopData, "user watch", fd, events, 1, callback, callback_data);
+}
+
+void _glfwPlatformRemoveLoopWatch(unsigned long long watch_id) {
+    removeWatch(&_glfw.GLFW_LOOP_BACKEND.eventLoopData, watch_id);
+}
+
+void _glfwPlatformToggleLoopWatch(unsigned long long watch_id, bool enabled) {
+    toggleWatch(&_glfw.GLFW_LOOP_BACKEND.eventLoopData, watch_id, enabled);
+}
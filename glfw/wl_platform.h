@@ -164,8 +164,13 @@ typedef struct _GLFWwindowWayland
         unsigned long long id;
         void(*callback)(unsigned long long id);
         struct wl_callback *current_wl_callback;
+        monotonic_t requested_at;
     } frameCallbackData;
 
+    // Inferred from frame callback starvation, since Wayland has no
+    // explicit occlusion protocol, see _glfwPlatformWindowOccluded()
+    bool                        occluded;
+
 
 } _GLFWwindowWayland;
 
@@ -1201,9 +1201,19 @@ int _glfwPlatformWindowFocused(_GLFWwindow* window)
     return _glfw.wl.keyboardFocus == window;
 }
 
-int _glfwPlatformWindowOccluded(_GLFWwindow* window UNUSED)
+int _glfwPlatformWindowOccluded(_GLFWwindow* window)
 {
-    return false;
+    // There is no occlusion protocol, but compositors stop sending frame
+    // callbacks for surfaces that are fully covered or on an invisible
+    // workspace, so prolonged starvation of a pending callback means the
+    // surface is not being presented. The pending callback stays registered
+    // and fires when the surface is next presented, which clears the flag
+    // and notifies, see frame_handle_redraw()
+    if (!window->wl.occluded &&
+        window->wl.frameCallbackData.current_wl_callback &&
+        monotonic() - window->wl.frameCallbackData.requested_at > ms_to_monotonic_t(600ll))
+        window->wl.occluded = true;
+    return window->wl.occluded;
 }
 
 int _glfwPlatformWindowIconified(_GLFWwindow* window UNUSED)
@@ -2017,6 +2027,22 @@ const char* _glfwPlatformGetPrimarySelectionString(void)
     return NULL;
 }
 
+bool _glfwPlatformRequestClipboardString(bool primary, GLFWclipboardchunkfun callback, void* user_data)
+{
+    // Wayland offers are already read through a pipe, so just deliver the
+    // result as a single chunk
+    const char* text = primary ?
+        _glfwPlatformGetPrimarySelectionString() : _glfwPlatformGetClipboardString();
+    if (text && text[0])
+        callback(text, strlen(text), user_data);
+    callback(NULL, 0, user_data);
+    return true;
+}
+
+void _glfwPlatformResumeClipboardRequest(void)
+{
+}
+
 EGLenum _glfwPlatformGetEGLPlatform(EGLint** attribs UNUSED)
 {
     if (_glfw.egl.EXT_platform_base && _glfw.egl.EXT_platform_wayland)
@@ -2109,6 +2135,11 @@ frame_handle_redraw(void *data, struct wl_callback *callback, uint32_t time UNUS
     if (callback == window->wl.frameCallbackData.current_wl_callback) {
         window->wl.frameCallbackData.callback(window->wl.frameCallbackData.id);
         window->wl.frameCallbackData.current_wl_callback = NULL;
+        if (window->wl.occluded) {
+            // the surface is being presented again
+            window->wl.occluded = false;
+            _glfwInputWindowOcclusion(window, false);
+        }
     }
     wl_callback_destroy(callback);
 }
@@ -2141,6 +2172,7 @@ GLFWAPI void glfwRequestWaylandFrameEvent(GLFWwindow *handle, unsigned long long
     if (window->wl.frameCallbackData.current_wl_callback) wl_callback_destroy(window->wl.frameCallbackData.current_wl_callback);
     window->wl.frameCallbackData.id = id;
     window->wl.frameCallbackData.callback = callback;
+    window->wl.frameCallbackData.requested_at = monotonic();
     window->wl.frameCallbackData.current_wl_callback = wl_surface_frame(window->wl.surface);
     if (window->wl.frameCallbackData.current_wl_callback) {
         wl_callback_add_listener(window->wl.frameCallbackData.current_wl_callback, &frame_listener, window);
@@ -197,6 +197,36 @@ static bool initExtensions(void)
         }
     }
 
+#if defined(__CYGWIN__)
+    _glfw.x11.present.handle = _glfw_dlopen("libXpresent-1.so");
+#else
+    _glfw.x11.present.handle = _glfw_dlopen("libXpresent.so.1");
+#endif
+    if (_glfw.x11.present.handle)
+    {
+        glfw_dlsym(_glfw.x11.present.QueryExtension, _glfw.x11.present.handle, "XPresentQueryExtension");
+        glfw_dlsym(_glfw.x11.present.QueryVersion, _glfw.x11.present.handle, "XPresentQueryVersion");
+        glfw_dlsym(_glfw.x11.present.SelectInput, _glfw.x11.present.handle, "XPresentSelectInput");
+        glfw_dlsym(_glfw.x11.present.NotifyMSC, _glfw.x11.present.handle, "XPresentNotifyMSC");
+
+        if (_glfw.x11.present.QueryExtension &&
+            _glfw.x11.present.QueryVersion &&
+            _glfw.x11.present.SelectInput &&
+            _glfw.x11.present.NotifyMSC &&
+            XPresentQueryExtension(_glfw.x11.display,
+                                   &_glfw.x11.present.majorOpcode,
+                                   &_glfw.x11.present.eventBase,
+                                   &_glfw.x11.present.errorBase))
+        {
+            if (XPresentQueryVersion(_glfw.x11.display,
+                                     &_glfw.x11.present.major,
+                                     &_glfw.x11.present.minor))
+            {
+                _glfw.x11.present.available = true;
+            }
+        }
+    }
+
 #if defined(__CYGWIN__)
     _glfw.x11.randr.handle = _glfw_dlopen("libXrandr-2.so");
 #else
@@ -726,6 +756,12 @@ void _glfwPlatformTerminate(void)
         _glfw.x11.xi.handle = NULL;
     }
 
+    if (_glfw.x11.present.handle)
+    {
+        _glfw_dlclose(_glfw.x11.present.handle);
+        _glfw.x11.present.handle = NULL;
+    }
+
     // NOTE: These need to be unloaded after XCloseDisplay, as they register
     //       cleanup callbacks that get called by that function
     _glfwTerminateEGL();
@@ -138,6 +138,35 @@ typedef void (* PFN_XShapeCombineMask)(Display*,Window,int,int,int,Pixmap,int);
 #define XShapeCombineRegion _glfw.x11.xshape.ShapeCombineRegion
 #define XShapeCombineMask _glfw.x11.xshape.ShapeCombineMask
 
+// Minimal XPresent declarations, avoiding a build time dependency on the
+// libXpresent headers; the library itself is loaded at runtime
+#define PresentCompleteNotifyMask (1 << 1)
+#define PresentCompleteNotify 1
+typedef struct
+{
+    int             type;
+    unsigned long   serial;
+    Bool            send_event;
+    Display*        display;
+    int             extension;
+    int             evtype;
+    uint32_t        eid;
+    Window          window;
+    uint32_t        serial_number;
+    uint64_t        ust;
+    uint64_t        msc;
+    uint32_t        kind;
+    uint32_t        mode;
+} XPresentCompleteNotifyEvent;
+typedef Bool (* PFN_XPresentQueryExtension)(Display*,int*,int*,int*);
+typedef Status (* PFN_XPresentQueryVersion)(Display*,int*,int*);
+typedef XID (* PFN_XPresentSelectInput)(Display*,Window,unsigned);
+typedef Status (* PFN_XPresentNotifyMSC)(Display*,Window,uint32_t,uint64_t,uint64_t,uint64_t);
+#define XPresentQueryExtension _glfw.x11.present.QueryExtension
+#define XPresentQueryVersion _glfw.x11.present.QueryVersion
+#define XPresentSelectInput _glfw.x11.present.SelectInput
+#define XPresentNotifyMSC _glfw.x11.present.NotifyMSC
+
 typedef VkFlags VkXlibSurfaceCreateFlagsKHR;
 typedef VkFlags VkXcbSurfaceCreateFlagsKHR;
 
@@ -192,6 +221,8 @@ typedef struct _GLFWwindowX11
 
     bool            iconified;
     bool            maximized;
+    // Tracked from VisibilityNotify events, see processEvent()
+    bool            occluded;
 
     // Whether the visual supports framebuffer transparency
     bool            transparent;
@@ -205,6 +236,13 @@ typedef struct _GLFWwindowX11
     // The last position the cursor was warped to by GLFW
     int             warpCursorPosX, warpCursorPosY;
 
+    // XPresent based render frame events
+    XID             presentEventId;  // 0 until PresentSelectInput has been done
+    uint32_t        presentSerial;
+    bool            presentNotifyPending;
+    unsigned long long frameCallbackId;
+    void            (*frameCallback)(unsigned long long id);
+
 } _GLFWwindowX11;
 
 // X11-specific global data
@@ -229,6 +267,26 @@ typedef struct _GLFWlibraryX11
     char*           primarySelectionString;
     // Clipboard string (while the selection is owned)
     char*           clipboardString;
+    // In-progress incremental (INCR) transfers of our selections to other
+    // clients, one slot per requestor
+    struct {
+        Window      requestor;
+        Atom        property;
+        Atom        target;
+        Atom        selection;
+        size_t      offset;
+    } incrSends[8];
+    // In-progress incremental read of another client's selection
+    struct {
+        GLFWclipboardchunkfun callback;
+        void*       user_data;
+        Atom        selection;
+        Atom        target;
+        bool        pending;      // waiting for the SelectionNotify reply
+        bool        incr;         // an INCR transfer is running
+        bool        paused;       // the consumer asked us to wait
+        bool        chunk_ready;  // a chunk arrived while we were paused
+    } clipboardReceive;
     // Where to place the cursor when re-enabled
     double          restoreCursorPosX, restoreCursorPosY;
     // The window whose disabled cursor mode is active
@@ -403,6 +461,20 @@ typedef struct _GLFWlibraryX11
         PFN_XShapeCombineMask ShapeCombineMask;
     } xshape;
 
+    struct {
+        bool        available;
+        void*       handle;
+        int         majorOpcode;
+        int         eventBase;
+        int         errorBase;
+        int         major;
+        int         minor;
+        PFN_XPresentQueryExtension QueryExtension;
+        PFN_XPresentQueryVersion QueryVersion;
+        PFN_XPresentSelectInput SelectInput;
+        PFN_XPresentNotifyMSC NotifyMSC;
+    } present;
+
     EventLoopData eventLoopData;
 
 } _GLFWlibraryX11;
@@ -149,6 +149,10 @@ static int getWindowState(_GLFWwindow* window)
 //
 static Bool isSelectionEvent(Display* display UNUSED, XEvent* event, XPointer pointer UNUSED)
 {
+    // Property deletions by a requestor drive in-progress INCR transfers
+    if (event->type == PropertyNotify)
+        return event->xproperty.state == PropertyDelete;
+
     if (event->xany.window != _glfw.x11.helperWindowHandle)
         return False;
 
@@ -709,6 +713,139 @@ static bool createNativeWindow(_GLFWwindow* window,
     return true;
 }
 
+// Returns the largest amount of selection data we can send in one request
+//
+static size_t maxSelectionChunkSize(void)
+{
+    size_t size = (size_t) XExtendedMaxRequestSize(_glfw.x11.display);
+    if (!size)
+        size = (size_t) XMaxRequestSize(_glfw.x11.display);
+    size *= 4;  // convert from 4-byte units
+    // leave room for the request header
+    return size > 4096 ? size - 4096 : size;
+}
+
+// Returns the slot of the in-progress INCR transfer to the specified
+// requestor window and property, if any
+//
+static size_t findIncrSend(Window requestor, Atom property)
+{
+    size_t i;
+    const size_t count = sizeof(_glfw.x11.incrSends) / sizeof(_glfw.x11.incrSends[0]);
+    for (i = 0;  i < count;  i++)
+    {
+        if (_glfw.x11.incrSends[i].requestor == requestor &&
+            _glfw.x11.incrSends[i].property == property)
+            break;
+    }
+    return i;
+}
+
+// Cancels any in-progress INCR transfers of the specified selection, used
+// when the selection data is about to be freed or replaced
+//
+static void cancelIncrSends(Atom selection)
+{
+    const size_t count = sizeof(_glfw.x11.incrSends) / sizeof(_glfw.x11.incrSends[0]);
+    for (size_t i = 0;  i < count;  i++)
+    {
+        if (_glfw.x11.incrSends[i].requestor &&
+            _glfw.x11.incrSends[i].selection == selection)
+        {
+            XSelectInput(_glfw.x11.display, _glfw.x11.incrSends[i].requestor, NoEventMask);
+            memset(&_glfw.x11.incrSends[i], 0, sizeof(_glfw.x11.incrSends[i]));
+        }
+    }
+}
+
+// Cancels any in-progress INCR transfers to the specified window, used when
+// the requestor is destroyed mid-transfer
+//
+static bool cancelIncrSendsToWindow(Window window)
+{
+    bool found = false;
+    const size_t count = sizeof(_glfw.x11.incrSends) / sizeof(_glfw.x11.incrSends[0]);
+    for (size_t i = 0;  i < count;  i++)
+    {
+        if (_glfw.x11.incrSends[i].requestor == window)
+        {
+            memset(&_glfw.x11.incrSends[i], 0, sizeof(_glfw.x11.incrSends[i]));
+            found = true;
+        }
+    }
+    return found;
+}
+
+// Begins an incremental (INCR) transfer of the selection to the requestor,
+// used when the data is too large for a single X request (ICCCM section 2.7.2)
+//
+static bool beginIncrSend(const XSelectionRequestEvent* request, size_t size)
+{
+    const size_t count = sizeof(_glfw.x11.incrSends) / sizeof(_glfw.x11.incrSends[0]);
+    size_t i;
+    for (i = 0;  i < count && _glfw.x11.incrSends[i].requestor;  i++);
+    if (i == count)
+        return false;
+
+    _glfw.x11.incrSends[i].requestor = request->requestor;
+    _glfw.x11.incrSends[i].property = request->property;
+    _glfw.x11.incrSends[i].target = request->target;
+    _glfw.x11.incrSends[i].selection = request->selection;
+    _glfw.x11.incrSends[i].offset = 0;
+
+    // The requestor deleting the property is what drives the transfer
+    XSelectInput(_glfw.x11.display, request->requestor,
+                 PropertyChangeMask | StructureNotifyMask);
+
+    long total = (long) size;
+    XChangeProperty(_glfw.x11.display,
+                    request->requestor,
+                    request->property,
+                    _glfw.x11.INCR,
+                    32,
+                    PropModeReplace,
+                    (unsigned char*) &total,
+                    1);
+    return true;
+}
+
+// Sends the next chunk of an INCR transfer after the requestor has read and
+// deleted the previous one
+//
+static bool handleIncrSendEvent(const XPropertyEvent* event)
+{
+    const size_t i = findIncrSend(event->window, event->atom);
+    if (i == sizeof(_glfw.x11.incrSends) / sizeof(_glfw.x11.incrSends[0]))
+        return false;
+
+    const char* string = _glfw.x11.incrSends[i].selection == _glfw.x11.PRIMARY ?
+        _glfw.x11.primarySelectionString : _glfw.x11.clipboardString;
+    const size_t size = string ? strlen(string) : 0;
+    const size_t offset = _glfw.x11.incrSends[i].offset > size ?
+        size : _glfw.x11.incrSends[i].offset;
+    const size_t max = maxSelectionChunkSize();
+    const size_t chunk = size - offset > max ? max : size - offset;
+
+    XChangeProperty(_glfw.x11.display,
+                    event->window,
+                    event->atom,
+                    _glfw.x11.incrSends[i].target,
+                    8,
+                    PropModeReplace,
+                    (unsigned char*) string + offset,
+                    chunk);
+
+    if (chunk)
+        _glfw.x11.incrSends[i].offset = offset + chunk;
+    else
+    {
+        // The zero length chunk ends the transfer
+        XSelectInput(_glfw.x11.display, event->window, NoEventMask);
+        memset(&_glfw.x11.incrSends[i], 0, sizeof(_glfw.x11.incrSends[i]));
+    }
+    return true;
+}
+
 // Set the specified property to the selection converted to the requested target
 //
 static Atom writeTargetToProperty(const XSelectionRequestEvent* request)
@@ -827,14 +964,26 @@ static Atom writeTargetToProperty(const XSelectionRequestEvent* request)
         {
             // The requested target is one we support
 
-            if (selectionString) XChangeProperty(_glfw.x11.display,
+            if (selectionString)
+            {
+                const size_t size = strlen(selectionString);
+
+                // Large selections are sent incrementally, both because they
+                // do not fit in a single X request and to avoid the requestor
+                // having to buffer them whole
+                if (size > maxSelectionChunkSize() &&
+                    beginIncrSend(request, size))
+                    return request->property;
+
+                XChangeProperty(_glfw.x11.display,
                             request->requestor,
                             request->property,
                             request->target,
                             8,
                             PropModeReplace,
                             (unsigned char *) selectionString,
-                            strlen(selectionString));
+                            size);
+            }
 
             return request->property;
         }
@@ -847,6 +996,7 @@ static Atom writeTargetToProperty(const XSelectionRequestEvent* request)
 
 static void handleSelectionClear(XEvent* event)
 {
+    cancelIncrSends(event->xselectionclear.selection);
     if (event->xselectionclear.selection == _glfw.x11.PRIMARY)
     {
         free(_glfw.x11.primarySelectionString);
@@ -946,7 +1096,7 @@ static const char* getSelectionString(Atom selection)
 
         if (actualType == _glfw.x11.INCR)
         {
-            size_t size = 1;
+            size_t size = 0, capacity = 0;
             char* string = NULL;
 
             for (;;)
@@ -981,10 +1131,15 @@ static const char* getSelectionString(Atom selection)
 
                 if (itemCount)
                 {
+                    if (size + itemCount + 1 > capacity)
+                    {
+                        capacity = capacity * 2 > size + itemCount + 1 ?
+                            capacity * 2 : size + itemCount + 1;
+                        string = realloc(string, capacity);
+                    }
+                    memcpy(string + size, data, itemCount);
                     size += itemCount;
-                    string = realloc(string, size);
-                    string[size - itemCount - 1] = '\0';
-                    strcat(string, data);
+                    string[size] = '\0';
                 }
 
                 if (!itemCount)
@@ -1024,6 +1179,154 @@ static const char* getSelectionString(Atom selection)
     return *selectionString;
 }
 
+// Delivers a chunk of selection data to the pending clipboard request,
+// returning whether the consumer is ready for more
+//
+static bool deliverClipboardChunk(const char* data, size_t size)
+{
+    if (_glfw.x11.clipboardReceive.target == XA_STRING)
+    {
+        char* utf8 = convertLatin1toUTF8(data);
+        const bool keep_going = _glfw.x11.clipboardReceive.callback(
+            utf8, strlen(utf8), _glfw.x11.clipboardReceive.user_data);
+        free(utf8);
+        return keep_going;
+    }
+    return _glfw.x11.clipboardReceive.callback(
+        data, size, _glfw.x11.clipboardReceive.user_data);
+}
+
+// Ends the pending clipboard request, notifying the consumer
+//
+static void finishClipboardReceive(void)
+{
+    GLFWclipboardchunkfun callback = _glfw.x11.clipboardReceive.callback;
+    void* user_data = _glfw.x11.clipboardReceive.user_data;
+    memset(&_glfw.x11.clipboardReceive, 0, sizeof(_glfw.x11.clipboardReceive));
+    if (callback)
+        callback(NULL, 0, user_data);
+}
+
+// Reads and deletes the next chunk of an INCR selection transfer, the
+// deletion being what tells the owner to send the one after it
+//
+static void readClipboardIncrChunk(void)
+{
+    char* data = NULL;
+    Atom actualType;
+    int actualFormat;
+    unsigned long itemCount, bytesAfter;
+
+    XGetWindowProperty(_glfw.x11.display,
+                       _glfw.x11.helperWindowHandle,
+                       _glfw.x11.GLFW_SELECTION,
+                       0,
+                       LONG_MAX,
+                       True,
+                       AnyPropertyType,
+                       &actualType,
+                       &actualFormat,
+                       &itemCount,
+                       &bytesAfter,
+                       (unsigned char**) &data);
+
+    if (itemCount)
+    {
+        if (!deliverClipboardChunk(data, itemCount))
+            _glfw.x11.clipboardReceive.paused = true;
+    }
+    else
+    {
+        // The zero length chunk ends the transfer
+        finishClipboardReceive();
+    }
+
+    if (data)
+        XFree(data);
+}
+
+// Handles the SelectionNotify reply to the conversion requested by
+// _glfwPlatformRequestClipboardString
+//
+static void handleClipboardReceiveNotify(const XSelectionEvent* event)
+{
+    _glfw.x11.clipboardReceive.pending = false;
+
+    if (event->property == None)
+    {
+        if (_glfw.x11.clipboardReceive.target == _glfw.x11.UTF8_STRING)
+        {
+            // The owner cannot provide UTF-8, fall back to Latin-1
+            _glfw.x11.clipboardReceive.target = XA_STRING;
+            _glfw.x11.clipboardReceive.pending = true;
+            XConvertSelection(_glfw.x11.display,
+                              _glfw.x11.clipboardReceive.selection,
+                              XA_STRING,
+                              _glfw.x11.GLFW_SELECTION,
+                              _glfw.x11.helperWindowHandle,
+                              CurrentTime);
+            return;
+        }
+
+        _glfwInputError(GLFW_FORMAT_UNAVAILABLE,
+                        "X11: Failed to convert selection to string");
+        finishClipboardReceive();
+        return;
+    }
+
+    char* data = NULL;
+    Atom actualType;
+    int actualFormat;
+    unsigned long itemCount, bytesAfter;
+
+    XGetWindowProperty(_glfw.x11.display,
+                       _glfw.x11.helperWindowHandle,
+                       _glfw.x11.GLFW_SELECTION,
+                       0,
+                       LONG_MAX,
+                       True,
+                       AnyPropertyType,
+                       &actualType,
+                       &actualFormat,
+                       &itemCount,
+                       &bytesAfter,
+                       (unsigned char**) &data);
+
+    if (actualType == _glfw.x11.INCR)
+    {
+        // Deleting the INCR property is what tells the owner to start
+        // sending, the chunks then arrive as PropertyNotify events
+        _glfw.x11.clipboardReceive.incr = true;
+    }
+    else
+    {
+        if (itemCount)
+            deliverClipboardChunk(data, itemCount);
+        finishClipboardReceive();
+    }
+
+    if (data)
+        XFree(data);
+}
+
+// Handles a new chunk arriving for an in-progress INCR read
+//
+static void handleClipboardReceiveProperty(void)
+{
+    if (!_glfw.x11.clipboardReceive.incr)
+        return;
+
+    if (_glfw.x11.clipboardReceive.paused)
+    {
+        // Leave the property in place, the owner waits until we delete it,
+        // so a paused transfer holds at most one chunk in flight
+        _glfw.x11.clipboardReceive.chunk_ready = true;
+        return;
+    }
+
+    readClipboardIncrChunk();
+}
+
 // Make the specified window and its video mode active on its monitor
 //
 static void acquireMonitor(_GLFWwindow* window)
@@ -1133,6 +1436,34 @@ static void processEvent(XEvent *event)
 
     if (event->type == GenericEvent)
     {
+        if (_glfw.x11.present.available &&
+            event->xcookie.extension == _glfw.x11.present.majorOpcode)
+        {
+            if (XGetEventData(_glfw.x11.display, &event->xcookie) &&
+                event->xcookie.evtype == PresentCompleteNotify)
+            {
+                XPresentCompleteNotifyEvent* pe = event->xcookie.data;
+                _GLFWwindow* window = NULL;
+
+                if (XFindContext(_glfw.x11.display,
+                                 pe->window,
+                                 _glfw.x11.context,
+                                 (XPointer*) &window) == 0 && window)
+                {
+                    window->x11.presentNotifyPending = false;
+                    if (window->x11.frameCallback)
+                    {
+                        void (*callback)(unsigned long long) = window->x11.frameCallback;
+                        window->x11.frameCallback = NULL;
+                        callback(window->x11.frameCallbackId);
+                    }
+                }
+            }
+
+            XFreeEventData(_glfw.x11.display, &event->xcookie);
+            return;
+        }
+
         if (_glfw.x11.xi.available)
         {
             _GLFWwindow* window = _glfw.x11.disabledCursorWindow;
@@ -1179,6 +1510,33 @@ static void processEvent(XEvent *event)
         handleSelectionRequest(event);
         return;
     }
+    else if (event->type == SelectionNotify &&
+             event->xselection.requestor == _glfw.x11.helperWindowHandle)
+    {
+        if (_glfw.x11.clipboardReceive.pending &&
+            event->xselection.selection == _glfw.x11.clipboardReceive.selection)
+            handleClipboardReceiveNotify(&event->xselection);
+        return;
+    }
+    else if (event->type == PropertyNotify &&
+             event->xproperty.window == _glfw.x11.helperWindowHandle)
+    {
+        if (event->xproperty.atom == _glfw.x11.GLFW_SELECTION &&
+            event->xproperty.state == PropertyNewValue)
+            handleClipboardReceiveProperty();
+        return;
+    }
+    else if (event->type == PropertyNotify &&
+             event->xproperty.state == PropertyDelete &&
+             handleIncrSendEvent(&event->xproperty))
+    {
+        return;
+    }
+    else if (event->type == DestroyNotify &&
+             cancelIncrSendsToWindow(event->xdestroywindow.window))
+    {
+        return;
+    }
     else if (event->type == _glfw.x11.xkb.eventBase)
     {
         XkbEvent *kb_event = (XkbEvent*)event;
@@ -1711,6 +2069,21 @@ static void processEvent(XEvent *event)
             return;
         }
 
+        case VisibilityNotify:
+        {
+            // Sent because VisibilityChangeMask is selected on our windows.
+            // Fully obscured windows are not worth rendering, windows on
+            // another workspace are unmapped and caught by GLFW_VISIBLE
+            const bool occluded =
+                event->xvisibility.state == VisibilityFullyObscured;
+            if (window->x11.occluded != occluded)
+            {
+                window->x11.occluded = occluded;
+                _glfwInputWindowOcclusion(window, occluded);
+            }
+            return;
+        }
+
         case PropertyNotify:
         {
             if (event->xproperty.state != PropertyNewValue)
@@ -1825,6 +2198,10 @@ void _glfwPushSelectionToManagerX11(void)
                     handleSelectionClear(&event);
                     break;
 
+                case PropertyNotify:
+                    handleIncrSendEvent(&event.xproperty);
+                    break;
+
                 case SelectionNotify:
                 {
                     if (event.xselection.target == _glfw.x11.SAVE_TARGETS)
@@ -2405,9 +2782,9 @@ int _glfwPlatformWindowFocused(_GLFWwindow* window)
     return window->x11.handle == focused;
 }
 
-int _glfwPlatformWindowOccluded(_GLFWwindow* window UNUSED)
+int _glfwPlatformWindowOccluded(_GLFWwindow* window)
 {
-    return false;
+    return window->x11.occluded;
 }
 
 int _glfwPlatformWindowIconified(_GLFWwindow* window)
@@ -2843,6 +3220,7 @@ void _glfwPlatformSetCursor(_GLFWwindow* window, _GLFWcursor* cursor UNUSED)
 void _glfwPlatformSetClipboardString(const char* string)
 {
     char* copy = _glfw_strdup(string);
+    cancelIncrSends(_glfw.x11.CLIPBOARD);
     free(_glfw.x11.clipboardString);
     _glfw.x11.clipboardString = copy;
 
@@ -2866,6 +3244,7 @@ const char* _glfwPlatformGetClipboardString(void)
 
 void _glfwPlatformSetPrimarySelectionString(const char* string)
 {
+    cancelIncrSends(_glfw.x11.PRIMARY);
     free(_glfw.x11.primarySelectionString);
     _glfw.x11.primarySelectionString = _glfw_strdup(string);
 
@@ -2887,6 +3266,61 @@ const char* _glfwPlatformGetPrimarySelectionString(void)
     return getSelectionString(_glfw.x11.PRIMARY);
 }
 
+bool _glfwPlatformRequestClipboardString(bool primary, GLFWclipboardchunkfun callback, void* user_data)
+{
+    const Atom selection = primary ? _glfw.x11.PRIMARY : _glfw.x11.CLIPBOARD;
+
+    if (_glfw.x11.clipboardReceive.callback)
+        return false;
+
+    const Window owner = XGetSelectionOwner(_glfw.x11.display, selection);
+    if (owner == _glfw.x11.helperWindowHandle)
+    {
+        // We own the selection, no need for any X round-trips
+        const char* string = primary ?
+            _glfw.x11.primarySelectionString : _glfw.x11.clipboardString;
+        if (string && string[0])
+            callback(string, strlen(string), user_data);
+        callback(NULL, 0, user_data);
+        return true;
+    }
+
+    if (owner == None)
+    {
+        callback(NULL, 0, user_data);
+        return true;
+    }
+
+    _glfw.x11.clipboardReceive.callback = callback;
+    _glfw.x11.clipboardReceive.user_data = user_data;
+    _glfw.x11.clipboardReceive.selection = selection;
+    _glfw.x11.clipboardReceive.target = _glfw.x11.UTF8_STRING;
+    _glfw.x11.clipboardReceive.pending = true;
+
+    XConvertSelection(_glfw.x11.display,
+                      selection,
+                      _glfw.x11.UTF8_STRING,
+                      _glfw.x11.GLFW_SELECTION,
+                      _glfw.x11.helperWindowHandle,
+                      CurrentTime);
+    XFlush(_glfw.x11.display);
+    return true;
+}
+
+void _glfwPlatformResumeClipboardRequest(void)
+{
+    if (!_glfw.x11.clipboardReceive.paused)
+        return;
+
+    _glfw.x11.clipboardReceive.paused = false;
+    if (_glfw.x11.clipboardReceive.chunk_ready)
+    {
+        _glfw.x11.clipboardReceive.chunk_ready = false;
+        readClipboardIncrChunk();
+        XFlush(_glfw.x11.display);
+    }
+}
+
 EGLenum _glfwPlatformGetEGLPlatform(EGLint** attribs)
 {
     if (_glfw.egl.ANGLE_platform_angle)
@@ -3111,6 +3545,37 @@ GLFWAPI int glfwGetNativeKeyForName(const char* keyName, bool caseSensitive) {
     return glfw_xkb_keysym_from_name(keyName, caseSensitive);
 }
 
+GLFWAPI int glfwX11FrameEventsAvailable(void)
+{
+    _GLFW_REQUIRE_INIT_OR_RETURN(false);
+    return _glfw.x11.present.available;
+}
+
+GLFWAPI void glfwRequestX11FrameEvent(GLFWwindow *handle, unsigned long long id, void(*callback)(unsigned long long id)) {
+    _GLFWwindow* window = (_GLFWwindow*) handle;
+    if (!_glfw.x11.present.available)
+        return;
+    if (!window->x11.presentEventId)
+    {
+        window->x11.presentEventId =
+            XPresentSelectInput(_glfw.x11.display,
+                                window->x11.handle,
+                                PresentCompleteNotifyMask);
+    }
+    window->x11.frameCallback = callback;
+    window->x11.frameCallbackId = id;
+    if (!window->x11.presentNotifyPending)
+    {
+        // ask for a notify at the next vblank; an already pending request is
+        // reused, the server answers each request exactly once
+        window->x11.presentNotifyPending = true;
+        XPresentNotifyMSC(_glfw.x11.display,
+                          window->x11.handle,
+                          ++window->x11.presentSerial, 0, 1, 0);
+        XFlush(_glfw.x11.display);
+    }
+}
+
 GLFWAPI unsigned long long glfwDBusUserNotify(const char *app_name, const char* icon, const char *summary, const char *body, const char *action_name, int32_t timeout, GLFWDBusnotificationcreatedfun callback, void *data) {
     return glfw_dbus_send_user_notification(app_name, icon, summary, body, action_name, timeout, callback, data);
 }
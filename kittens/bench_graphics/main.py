@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+# vim:fileencoding=utf-8
+# License: GPL v3 Copyright: 2021, Kovid Goyal <kovid at kovidgoyal.net>
+
+import os
+import re
+import struct
+import sys
+import zlib
+from base64 import standard_b64encode
+from contextlib import suppress
+from itertools import count
+from statistics import mean
+from tempfile import NamedTemporaryFile
+from time import monotonic
+from typing import List, Optional, Tuple
+
+from kitty.cli import parse_args
+from kitty.cli_stub import BenchGraphicsCLIOptions
+from kitty.constants import appname
+from kitty.utils import TTYIO
+
+from ..tui.images import GraphicsCommand
+
+all_formats = ('rgba', 'rgb', 'png', 'zlib')
+all_modes = ('direct', 'file', 'memory')
+image_id_counter = count(7891000)
+shm_name_counter = count()
+response_pat = re.compile(br'\x1b_Gi=(\d+)[^;]*;([^\x1b]*)\x1b\\')
+
+
+def next_shm_name() -> str:
+    return '/{}-bench-{}-{}'.format(appname, os.getpid(), next(shm_name_counter))
+
+
+def make_png(width: int, height: int) -> bytes:
+    # A minimal 8-bit RGBA PNG with random pixel data
+
+    def chunk(tag: bytes, data: bytes) -> bytes:
+        return struct.pack('>I', len(data)) + tag + data + struct.pack('>I', zlib.crc32(tag + data) & 0xffffffff)
+
+    raw = b''.join(b'\x00' + os.urandom(width * 4) for _ in range(height))
+    ihdr = struct.pack('>IIBBBBB', width, height, 8, 6, 0, 0, 0)
+    return b'\x89PNG\r\n\x1a\n' + chunk(b'IHDR', ihdr) + chunk(b'IDAT', zlib.compress(raw)) + chunk(b'IEND', b'')
+
+
+def make_payload(fmt: str, width: int, height: int) -> Tuple[bytes, GraphicsCommand]:
+    cmd = GraphicsCommand()
+    cmd.a = 't'
+    if fmt == 'png':
+        cmd.f = 100
+        payload = make_png(width, height)
+    else:
+        cmd.f = 24 if fmt == 'rgb' else 32
+        cmd.s, cmd.v = width, height
+        payload = os.urandom(width * height * (cmd.f // 8))
+        if fmt == 'zlib':
+            payload = zlib.compress(payload)
+            cmd.o = 'z'
+    return payload, cmd
+
+
+def send_direct(ttyio: TTYIO, cmd: GraphicsCommand, payload: bytes) -> None:
+    data = standard_b64encode(payload)
+    first = True
+    while data:
+        chunk, data = data[:4096], data[4096:]
+        m = 1 if data else 0
+        if first:
+            cmd.m = m
+            ttyio.send(cmd.serialize(chunk))
+            first = False
+        else:
+            cont = GraphicsCommand()
+            cont.a, cont.t = cmd.a, cmd.t
+            cont.m = m
+            ttyio.send(cont.serialize(chunk))
+    if first:
+        ttyio.send(cmd.serialize())
+
+
+def transmit(ttyio: TTYIO, mode: str, cmd: GraphicsCommand, payload: bytes) -> Optional[str]:
+    # returns the name of a temporary resource the terminal is responsible
+    # for cleaning up, if any
+    if mode == 'direct':
+        send_direct(ttyio, cmd, payload)
+        return None
+    if mode == 'file':
+        with NamedTemporaryFile(delete=False) as f:
+            f.write(payload)
+        cmd.t = 't'
+        ttyio.send(cmd.serialize(standard_b64encode(f.name.encode('utf-8'))))
+        return f.name
+    from kitty.fast_data_types import shm_write
+    name = next_shm_name()
+    shm_write(name, payload)
+    cmd.t = 's'
+    cmd.S = len(payload)
+    ttyio.send(cmd.serialize(standard_b64encode(name.encode('utf-8'))))
+    return name
+
+
+def wait_for_response(ttyio: TTYIO, image_id: int, timeout: float) -> str:
+    ans = ''
+    received = b''
+
+    def more_needed(data: bytes) -> bool:
+        nonlocal ans, received
+        received += data
+        for m in response_pat.finditer(received):
+            if int(m.group(1)) == image_id:
+                ans = m.group(2).decode('ascii', 'replace')
+                return False
+        return True
+
+    ttyio.recv(more_needed, timeout=timeout)
+    return ans
+
+
+def delete_image(ttyio: TTYIO, image_id: int) -> None:
+    cmd = GraphicsCommand()
+    cmd.a = 'd'
+    cmd.d = 'I'
+    cmd.i = image_id
+    ttyio.send(cmd.serialize())
+
+
+class Result:
+
+    def __init__(self, fmt: str, mode: str, width: int, height: int, payload_sz: int, times: List[float], error: str = ''):
+        self.fmt, self.mode, self.width, self.height = fmt, mode, width, height
+        self.payload_sz, self.times, self.error = payload_sz, times, error
+
+    @property
+    def throughput(self) -> float:
+        total = sum(self.times)
+        return (self.payload_sz * len(self.times)) / (total * 1024 * 1024) if total else 0
+
+    @property
+    def p99(self) -> float:
+        q = sorted(self.times)
+        return q[min(len(q) - 1, int(0.99 * len(q)))]
+
+    def __str__(self) -> str:
+        desc = f'{self.fmt:5} {self.mode:7} {self.width}x{self.height}'
+        if self.error:
+            return f'{desc}: failed with: {self.error}'
+        return f'{desc}: {self.throughput:8.1f} MB/s  mean: {mean(self.times) * 1000:7.2f} ms  p99: {self.p99 * 1000:7.2f} ms  payload: {self.payload_sz / 1024:.0f} KB'
+
+
+def bench(ttyio: TTYIO, fmt: str, mode: str, width: int, height: int, repetitions: int, timeout: float) -> Result:
+    payload, cmd = make_payload(fmt, width, height)
+    times: List[float] = []
+    for _ in range(repetitions):
+        image_id = next(image_id_counter)
+        c = GraphicsCommand()
+        c.a, c.f, c.s, c.v, c.o = cmd.a, cmd.f, cmd.s, cmd.v, cmd.o
+        c.i = image_id
+        resource = None
+        start = monotonic()
+        try:
+            resource = transmit(ttyio, mode, c, payload)
+            response = wait_for_response(ttyio, image_id, timeout)
+        finally:
+            if resource is not None and mode == 'file':
+                with suppress(OSError):
+                    os.unlink(resource)
+        if not response:
+            return Result(fmt, mode, width, height, len(payload), times, 'timed out waiting for a response')
+        if response != 'OK':
+            return Result(fmt, mode, width, height, len(payload), times, response)
+        times.append(monotonic() - start)
+        delete_image(ttyio, image_id)
+    return Result(fmt, mode, width, height, len(payload), times)
+
+
+def parse_sizes(raw: str) -> List[int]:
+    ans = []
+    for x in raw.split(','):
+        sz = int(x)
+        if sz < 1 or sz > 10000:
+            raise SystemExit(f'Invalid image size: {sz}')
+        ans.append(sz)
+    return ans
+
+
+def options_spec() -> str:
+    return '''\
+--sizes
+default=64,512,1024
+Comma separated list of square image sizes, in pixels, to benchmark with.
+
+
+--format
+default=all
+Comma separated list of payload formats to benchmark. One or more of:
+rgba, rgb, png or zlib (zlib compressed rgba). The default is all of them.
+
+
+--transfer-mode
+default=all
+Comma separated list of transmission mediums to benchmark. One or more of:
+direct, file or memory (POSIX shared memory). The default is all of them.
+
+
+--repetitions
+type=int
+default=20
+The number of times to transmit each payload. Throughput and latency are
+aggregated over all repetitions.
+
+
+--wait-for
+type=float
+default=10
+The amount of time (in seconds) to wait for a response from the terminal
+before giving up.
+'''
+
+
+help_text = '''\
+Benchmark the terminal graphics protocol as a whole. Synthetic image payloads
+of the specified formats and sizes are transmitted through each transmission
+medium, timing from the first byte of the escape code until the response code
+is received, and throughput and p99 latency are reported for each
+combination. Note that this must be run inside kitty and that the payloads
+are random data, representing the worst case for compression.
+'''
+usage = ''
+
+
+def main(args: List[str] = sys.argv) -> None:
+    cli_opts, items = parse_args(
+        args[1:], options_spec, usage, help_text, '{} +kitten bench_graphics'.format(appname),
+        result_class=BenchGraphicsCLIOptions)
+    if items:
+        raise SystemExit('Unrecognized extra arguments: {}'.format(' '.join(items)))
+    if not sys.stdout.isatty():
+        raise SystemExit('Must be run in a terminal')
+    sizes = parse_sizes(cli_opts.sizes)
+    formats = all_formats if cli_opts.format == 'all' else tuple(cli_opts.format.split(','))
+    for fmt in formats:
+        if fmt not in all_formats:
+            raise SystemExit(f'Unknown format: {fmt}')
+    modes = all_modes if cli_opts.transfer_mode == 'all' else tuple(cli_opts.transfer_mode.split(','))
+    for mode in modes:
+        if mode not in all_modes:
+            raise SystemExit(f'Unknown transfer mode: {mode}')
+    if 'memory' in modes:
+        try:
+            from kitty.fast_data_types import shm_write
+            del shm_write
+        except ImportError:
+            print('Skipping the memory transfer mode, shared memory is unavailable', file=sys.stderr)
+            modes = tuple(m for m in modes if m != 'memory')
+    results: List[Result] = []
+    with TTYIO() as ttyio:
+        for fmt in formats:
+            for mode in modes:
+                for sz in sizes:
+                    results.append(bench(ttyio, fmt, mode, sz, sz, cli_opts.repetitions, cli_opts.wait_for))
+    for r in results:
+        print(r)
+
+
+if __name__ == '__main__':
+    main()
+elif __name__ == '__doc__':
+    cd = sys.cli_docs  # type: ignore
+    cd['usage'] = usage
+    cd['options'] = options_spec
+    cd['help_text'] = help_text
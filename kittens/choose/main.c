@@ -18,20 +18,134 @@
 #include <unistd.h>
 #endif
 
+// Parallel scoring: threads pull chunks of candidates off a shared atomic
+// cursor, so fast and slow chunks balance out without any static partitioning.
+// When a result limit is set, each thread keeps a min-heap of the best scores
+// it has produced and publishes its k-th best into a shared monotonic bound;
+// candidates whose cheap score upper bound cannot beat that are skipped
+// without running the full scoring loop.
+
+#define SCORE_CHUNK_SIZE 1024
+
+#ifdef ISWINDOWS
+#include <intrin.h>
+typedef struct {
+    volatile __int64 next;         // next unclaimed candidate index
+    volatile __int64 score_bound;  // bit pattern of a lower bound on the k-th best score
+    size_t limit;
+} ScoringQueue;
+
+static inline size_t
+queue_grab(ScoringQueue *q, size_t n) {
+    return (size_t)_InterlockedExchangeAdd64(&q->next, (__int64)n);
+}
+
+static inline uint64_t
+load_score_bound(ScoringQueue *q) {
+    return (uint64_t)_InterlockedCompareExchange64(&q->score_bound, 0, 0);
+}
+
+static inline void
+raise_score_bound(ScoringQueue *q, uint64_t val) {
+    __int64 cur = q->score_bound;
+    while ((uint64_t)cur < val && _InterlockedCompareExchange64(&q->score_bound, (__int64)val, cur) != cur) cur = q->score_bound;
+}
+#else
+#include <stdatomic.h>
+typedef struct {
+    atomic_size_t next;
+    atomic_uint_fast64_t score_bound;
+    size_t limit;
+} ScoringQueue;
+
+static inline size_t
+queue_grab(ScoringQueue *q, size_t n) {
+    return atomic_fetch_add_explicit(&q->next, n, memory_order_relaxed);
+}
+
+static inline uint64_t
+load_score_bound(ScoringQueue *q) {
+    return atomic_load_explicit(&q->score_bound, memory_order_relaxed);
+}
+
+static inline void
+raise_score_bound(ScoringQueue *q, uint64_t val) {
+    uint64_t cur = atomic_load_explicit(&q->score_bound, memory_order_relaxed);
+    while (cur < val && !atomic_compare_exchange_weak_explicit(&q->score_bound, &cur, val, memory_order_relaxed, memory_order_relaxed));
+}
+#endif
+
+// Scores are non-negative, so their IEEE bit patterns order the same way the
+// doubles do, letting the shared bound be a plain 64-bit integer max.
+static inline uint64_t
+score_to_bits(double s) { uint64_t b; memcpy(&b, &s, sizeof(b)); return b; }
+
+typedef struct {
+    double *scores;  // min-heap of the best scores this thread has produced
+    size_t count, capacity;
+} TopK;
+
 typedef struct {
-    size_t start, count;
     void *workspace;
-    len_t max_haystack_len;
     bool started;
+    TopK topk;
+    ScoringQueue *queue;
     GlobalData *global;
 } JobData;
 
+static void
+topk_add(TopK *h, double score, ScoringQueue *q) {
+    if (h->count < h->capacity) {
+        size_t i = h->count++;
+        h->scores[i] = score;
+        while (i && h->scores[(i - 1) / 2] > h->scores[i]) {
+            double t = h->scores[(i - 1) / 2]; h->scores[(i - 1) / 2] = h->scores[i]; h->scores[i] = t;
+            i = (i - 1) / 2;
+        }
+    } else if (score > h->scores[0]) {
+        h->scores[0] = score;
+        size_t i = 0;
+        while (true) {
+            size_t smallest = i, l = 2 * i + 1, r = 2 * i + 2;
+            if (l < h->count && h->scores[l] < h->scores[smallest]) smallest = l;
+            if (r < h->count && h->scores[r] < h->scores[smallest]) smallest = r;
+            if (smallest == i) break;
+            double t = h->scores[smallest]; h->scores[smallest] = h->scores[i]; h->scores[i] = t;
+            i = smallest;
+        }
+    } else return;
+    // once the heap is full its minimum is a lower bound on the k-th best
+    // score overall, publish it for the early-out check in other threads
+    if (h->count == h->capacity) raise_score_bound(q, score_to_bits(h->scores[0]));
+}
+
+static inline double
+score_upper_bound(const Candidate *c, const GlobalData *global) {
+    // From calc_score(): each needle char contributes at most
+    // (100 / 70) * max_score_per_char, at a level 3 special location
+    double max_score_per_char = (1.0 / c->haystack_len + 1.0 / global->needle_len) / 2.0;
+    return global->needle_len * max_score_per_char * (100.0 / 70.0);
+}
 
 static unsigned int STDCALL
 run_scoring(JobData *job_data) {
     GlobalData *global = job_data->global;
-    for (size_t i = job_data->start; i < job_data->start + job_data->count; i++) {
-        global->haystack[i].score = score_item(job_data->workspace, global->haystack[i].src, global->haystack[i].haystack_len, global->haystack[i].positions);
+    ScoringQueue *q = job_data->queue;
+    while (true) {
+        size_t start = queue_grab(q, SCORE_CHUNK_SIZE);
+        if (start >= global->haystack_count) break;
+        size_t end = MIN(start + SCORE_CHUNK_SIZE, global->haystack_count);
+        for (size_t i = start; i < end; i++) {
+            Candidate *c = global->haystack + i;
+            if (q->limit && score_to_bits(score_upper_bound(c, global)) < load_score_bound(q)) {
+                // cannot beat the k-th best score already found, and only the
+                // top limit results are output
+                c->score = 0;
+                continue;
+            }
+            c->score = score_item(job_data->workspace, c->src, c->haystack_len, c->positions);
+            if (q->limit && c->score > 0) topk_add(&job_data->topk, c->score, q);
+        }
     }
     return 0;
 }
@@ -48,18 +162,19 @@ run_scoring_pthreads(void *job_data) {
 #endif
 
 static JobData*
-create_job(size_t i, size_t blocksz, GlobalData *global) {
+create_job(len_t max_haystack_len, ScoringQueue *queue, GlobalData *global) {
     JobData *ans = (JobData*)calloc(1, sizeof(JobData));
     if (ans == NULL) return NULL;
-    ans->start = i * blocksz;
-    if (ans->start >= global->haystack_count) ans->count = 0;
-    else ans->count = global->haystack_count - ans->start;
-    ans->max_haystack_len = 0;
-    for (size_t i = ans->start; i < ans->start + ans->count; i++) ans->max_haystack_len = MAX(ans->max_haystack_len, global->haystack[i].haystack_len);
-    if (ans->count > 0) {
-        ans->workspace = alloc_workspace(ans->max_haystack_len, global);
+    if (global->haystack_count > 0) {
+        ans->workspace = alloc_workspace(max_haystack_len, global);
         if (!ans->workspace) { free(ans); return NULL; }
     }
+    if (queue->limit) {
+        ans->topk.capacity = queue->limit;
+        ans->topk.scores = (double*)malloc(ans->topk.capacity * sizeof(double));
+        if (!ans->topk.scores) { free_workspace(ans->workspace); free(ans); return NULL; }
+    }
+    ans->queue = queue;
     ans->global = global;
     return ans;
 }
@@ -68,6 +183,7 @@ static JobData*
 free_job(JobData *job) {
     if (job) {
         if (job->workspace) free_workspace(job->workspace);
+        free(job->topk.scores);
         free(job);
     }
     return NULL;
@@ -75,21 +191,26 @@ free_job(JobData *job) {
 
 
 static int
-run_threaded(int num_threads_asked, GlobalData *global) {
+run_threaded(Options *opts, GlobalData *global) {
     int ret = 0;
-    size_t i, blocksz;
-    size_t num_threads = MAX(1, num_threads_asked > 0 ? num_threads_asked : cpu_count());
+    size_t i;
+    size_t num_threads = MAX(1, opts->num_threads > 0 ? opts->num_threads : cpu_count());
     if (global->haystack_size < 10000) num_threads = 1;
-    /* printf("num_threads: %lu asked: %d sysconf: %ld\n", num_threads, num_threads_asked, sysconf(_SC_NPROCESSORS_ONLN)); */
+    /* printf("num_threads: %lu asked: %d sysconf: %ld\n", num_threads, opts->num_threads, sysconf(_SC_NPROCESSORS_ONLN)); */
+
+    ScoringQueue queue = {0};
+    // the top-K machinery only pays off when most candidates are discarded
+    if (opts->limit > 0 && opts->limit < global->haystack_count) queue.limit = opts->limit;
+
+    len_t max_haystack_len = 0;
+    for (i = 0; i < global->haystack_count; i++) max_haystack_len = MAX(max_haystack_len, global->haystack[i].haystack_len);
 
     void *threads = alloc_threads(num_threads);
     JobData **job_data = calloc(num_threads, sizeof(JobData*));
     if (threads == NULL || job_data == NULL) { ret = 1; goto end; }
 
-    blocksz = global->haystack_count / num_threads + global->haystack_count % num_threads;
-
     for (i = 0; i < num_threads; i++) {
-        job_data[i] = create_job(i, blocksz, global);
+        job_data[i] = create_job(max_haystack_len, &queue, global);
         if (job_data[i] == NULL) { ret = 1; goto end; }
     }
 
@@ -98,10 +219,8 @@ run_threaded(int num_threads_asked, GlobalData *global) {
     } else {
         for (i = 0; i < num_threads; i++) {
             job_data[i]->started = false;
-            if (job_data[i]->count > 0) {
-                if (!start_thread(threads, i, START_FUNC, job_data[i])) ret = 1;
-                else job_data[i]->started = true;
-            }
+            if (!start_thread(threads, i, START_FUNC, job_data[i])) ret = 1;
+            else job_data[i]->started = true;
         }
     }
 
@@ -160,7 +279,7 @@ run_search(Options *opts, GlobalData *global, const char * const *lines, const s
         }
         global->haystack = haystack;
         global->haystack_count = SIZE(candidates);
-        ret = run_threaded(opts->num_threads, global);
+        ret = run_threaded(opts, global);
         if (ret == 0) output_results(global, haystack, SIZE(candidates), opts, global->needle_len);
         else { REPORT_OOM; }
     } else { ret = 1; REPORT_OOM; }
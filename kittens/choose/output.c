@@ -93,11 +93,56 @@ output_result(GlobalData *global, Candidate *c, Options *opts, len_t needle_len)
 }
 
 
+static int
+cmpscore_ptr(const void *a, const void *b) {
+    return cmpscore(*(Candidate* const*)a, *(Candidate* const*)b);
+}
+
+// Heap ordered so that the worst candidate (by cmpscore) is at the root
+static void
+sift_down(Candidate **heap, size_t count, size_t i) {
+    while (true) {
+        size_t worst = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < count && cmpscore(heap[l], heap[worst]) > 0) worst = l;
+        if (r < count && cmpscore(heap[r], heap[worst]) > 0) worst = r;
+        if (worst == i) break;
+        Candidate *t = heap[worst]; heap[worst] = heap[i]; heap[i] = t;
+        i = worst;
+    }
+}
+
 void
 output_results(GlobalData *global, Candidate *haystack, size_t count, Options *opts, len_t needle_len) {
     Candidate *c;
+    size_t limit = opts->limit;
+    if (limit > 0 && limit < count) {
+        // Select the top limit candidates with a heap instead of sorting the
+        // entire haystack, only the selected few need ordering
+        Candidate **heap = malloc(limit * sizeof(Candidate*));
+        if (!heap) { global->oom = 1; return; }
+        size_t heap_count = 0;
+        for (size_t i = 0; i < count; i++) {
+            c = haystack + i;
+            if (c->score <= 0) continue;
+            if (heap_count < limit) {
+                size_t j = heap_count++;
+                heap[j] = c;
+                while (j && cmpscore(heap[j], heap[(j - 1) / 2]) > 0) {
+                    Candidate *t = heap[(j - 1) / 2]; heap[(j - 1) / 2] = heap[j]; heap[j] = t;
+                    j = (j - 1) / 2;
+                }
+            } else if (cmpscore(c, heap[0]) < 0) {
+                heap[0] = c;
+                sift_down(heap, limit, 0);
+            }
+        }
+        qsort(heap, heap_count, sizeof(Candidate*), cmpscore_ptr);
+        for (size_t i = 0; i < heap_count; i++) output_result(global, heap[i], opts, needle_len);
+        free(heap);
+        return;
+    }
     qsort(haystack, count, sizeof(*haystack), cmpscore);
-    size_t left = opts->limit > 0 ? opts->limit : count;
+    size_t left = limit > 0 ? limit : count;
     for (size_t i = 0; i < left; i++) {
         c = haystack + i;
         if (c->score > 0) output_result(global, c, opts, needle_len);
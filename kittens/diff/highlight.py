@@ -5,7 +5,9 @@
 import concurrent
 import os
 import re
-from typing import IO, Dict, Iterable, List, Optional, Tuple, Union, cast
+from typing import (
+    IO, Callable, Dict, Iterable, List, Optional, Sequence, Tuple, Union, cast
+)
 
 from pygments import highlight  # type: ignore
 from pygments.formatter import Formatter  # type: ignore
@@ -137,17 +139,27 @@ def highlight_for_diff(path: str, aliases: Dict[str, str]) -> DiffHighlight:
     return ans
 
 
-def highlight_collection(collection: Collection, aliases: Optional[Dict[str, str]] = None) -> Union[str, Dict[str, DiffHighlight]]:
+def highlight_collection(
+    collection: Collection, aliases: Optional[Dict[str, str]] = None,
+    result_callback: Optional[Callable[[str, DiffHighlight], None]] = None,
+    priority_paths: Sequence[str] = ()
+) -> Union[str, Dict[str, DiffHighlight]]:
+    # Files in priority_paths (the ones currently on screen) are submitted
+    # first so their highlighting is available soonest, and result_callback,
+    # when provided, is invoked with (path, highlights) as each file finishes
     jobs = {}
     ans: Dict[str, DiffHighlight] = {}
+    pending: List[str] = []
+    for path, item_type, other_path in collection:
+        if item_type != 'rename':
+            for p in (path, other_path):
+                if p and not isinstance(data_for_path(p), bytes):
+                    pending.append(p)
+    priority = frozenset(priority_paths)
+    pending.sort(key=lambda p: p not in priority)
     with get_process_pool_executor(prefer_fork=True) as executor:
-        for path, item_type, other_path in collection:
-            if item_type != 'rename':
-                for p in (path, other_path):
-                    if p:
-                        is_binary = isinstance(data_for_path(p), bytes)
-                        if not is_binary:
-                            jobs[executor.submit(highlight_for_diff, p, aliases)] = p
+        for p in pending:
+            jobs[executor.submit(highlight_for_diff, p, aliases)] = p
         for future in concurrent.futures.as_completed(jobs):
             path = jobs[future]
             try:
@@ -155,6 +167,8 @@ def highlight_collection(collection: Collection, aliases: Optional[Dict[str, str
             except Exception as e:
                 return 'Running syntax highlighting for {} generated an exception: {}'.format(path, e)
             ans[path] = highlights
+            if result_callback is not None:
+                result_callback(path, highlights)
     return ans
 
 
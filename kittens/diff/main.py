@@ -13,8 +13,10 @@ from collections import defaultdict
 from contextlib import suppress
 from functools import partial
 from gettext import gettext as _
+from time import monotonic
 from typing import (
-    Any, DefaultDict, Dict, Iterable, List, Optional, Tuple, Union
+    Any, Callable, DefaultDict, Dict, Iterable, List, Optional, Set, Tuple,
+    Union
 )
 
 from kitty.cli import CONFIG_HELP, parse_args
@@ -52,7 +54,11 @@ try:
 except ImportError:
     has_highlighter = False
 
-    def highlight_collection(collection: 'Collection', aliases: Optional[Dict[str, str]] = None) -> Union[str, Dict[str, 'DiffHighlight']]:
+    def highlight_collection(
+        collection: 'Collection', aliases: Optional[Dict[str, str]] = None,
+        result_callback: Optional[Callable[[str, 'DiffHighlight'], None]] = None,
+        priority_paths: Tuple[str, ...] = ()
+    ) -> Union[str, Dict[str, 'DiffHighlight']]:
         return ''
 
 
@@ -60,7 +66,10 @@ INITIALIZING, COLLECTED, DIFFED, COMMAND, MESSAGE = range(5)
 ESCAPE = K['ESCAPE']
 
 
-def generate_diff(collection: Collection, context: int) -> Union[str, Dict[str, Patch]]:
+def generate_diff(
+    collection: Collection, context: int,
+    result_callback: Optional[Callable[[str, Patch], None]] = None
+) -> Union[str, Dict[str, Patch]]:
     d = Differ()
 
     for path, item_type, changed_path in collection:
@@ -70,7 +79,7 @@ def generate_diff(collection: Collection, context: int) -> Union[str, Dict[str,
                 assert changed_path is not None
                 d.add_diff(path, changed_path)
 
-    return d(context)
+    return d(context, result_callback)
 
 
 class DiffHandler(Handler):
@@ -93,6 +102,13 @@ class DiffHandler(Handler):
             self.current_context_count = self.original_context_count = self.opts.num_context_lines
         self.highlighting_done = False
         self.restore_position: Optional[Reference] = None
+        # streaming state for progressive rendering while diffing/highlighting
+        self.diff_generation = 0
+        self.partial_diff_map: Dict[str, Patch] = {}
+        self.partial_rendered = False
+        self.last_partial_render_at = 0.
+        self.partial_highlight_data: Dict[str, 'DiffHighlight'] = {}
+        self.highlight_path_map: Dict[str, str] = {}
         for key_def, action in self.opts.key_definitions.items():
             self.add_shortcut(action, *key_def)
 
@@ -143,12 +159,39 @@ class DiffHandler(Handler):
         self.asyncio_loop.run_in_executor(None, collect, self.left, self.right)
 
     def generate_diff(self) -> None:
+        self.diff_generation += 1
+        generation = self.diff_generation
+        self.partial_diff_map = {}
+        self.partial_rendered = False
+        self.last_partial_render_at = 0.
+
+        def partial_diff(key: str, patch: Patch) -> None:
+            # runs on the main loop as each file pair finishes diffing, so the
+            # first screenful can be shown long before the full diff is done
+            if generation != self.diff_generation or self.state > COLLECTED:
+                return
+            self.partial_diff_map[key] = patch
+            now = monotonic()
+            if self.partial_rendered and now - self.last_partial_render_at < 0.25:
+                return
+            self.last_partial_render_at = now
+            self.diff_map = dict(self.partial_diff_map)
+            self.render_diff()
+            if self.diff_lines:
+                self.partial_rendered = True
+                self.draw_screen()
 
         def diff_done(diff_map: Union[str, Dict[str, Patch]]) -> None:
+            if generation != self.diff_generation:
+                return
             if isinstance(diff_map, str):
                 self.report_traceback_on_exit = diff_map
                 self.quit_loop(1)
                 return
+            if self.partial_rendered and self.restore_position is None:
+                # keep the position the user scrolled to while results were
+                # still streaming in
+                self.restore_position = self.current_position
             self.state = DIFFED
             self.diff_map = diff_map
             self.calculate_statistics()
@@ -170,12 +213,34 @@ class DiffHandler(Handler):
                 self.syntax_highlight()
 
         def diff(collection: Collection, current_context_count: int) -> None:
-            diff_map = generate_diff(collection, current_context_count)
+
+            def result_callback(key: str, patch: Patch) -> None:
+                self.asyncio_loop.call_soon_threadsafe(partial_diff, key, patch)
+
+            diff_map = generate_diff(collection, current_context_count, result_callback)
             self.asyncio_loop.call_soon_threadsafe(diff_done, diff_map)
 
         self.asyncio_loop.run_in_executor(None, diff, self.collection, self.current_context_count)
 
+    def visible_paths(self) -> Set[str]:
+        lines = getattr(self, 'diff_lines', ())
+        return {ln.ref.path for ln in lines[self.scroll_pos:self.scroll_pos + self.num_lines]}
+
     def syntax_highlight(self) -> None:
+        self.partial_highlight_data = {}
+        # files are highlighted individually, map both sides of a pair to the
+        # left path used by line references so visibility can be checked
+        self.highlight_path_map = {}
+        for path, item_type, other_path in self.collection:
+            if item_type != 'rename':
+                for p in (path, other_path):
+                    if p:
+                        self.highlight_path_map[p] = path
+        # Pygments has to process a file from the top, so the lazy unit is the
+        # file: visible files are highlighted first and each one is displayed
+        # as soon as it is ready, the rest fill in in the background
+        visible = self.visible_paths()
+        priority = tuple(p for p, ref in self.highlight_path_map.items() if ref in visible)
 
         def highlighting_done(hdata: Union[str, Dict[str, 'DiffHighlight']]) -> None:
             if isinstance(hdata, str):
@@ -186,8 +251,19 @@ class DiffHandler(Handler):
             self.render_diff()
             self.draw_screen()
 
+        def partial_highlight(path: str, highlights: 'DiffHighlight') -> None:
+            self.partial_highlight_data[path] = highlights
+            set_highlight_data(dict(self.partial_highlight_data))
+            if self.state == DIFFED and self.highlight_path_map.get(path) in self.visible_paths():
+                self.render_diff()
+                self.draw_screen()
+
         def highlight(collection: Collection, aliases: Optional[Dict[str, str]] = None) -> None:
-            result = highlight_collection(collection, aliases)
+
+            def result_callback(path: str, highlights: 'DiffHighlight') -> None:
+                self.asyncio_loop.call_soon_threadsafe(partial_highlight, path, highlights)
+
+            result = highlight_collection(collection, aliases, result_callback, priority)
             self.asyncio_loop.call_soon_threadsafe(highlighting_done, result)
 
         self.asyncio_loop.run_in_executor(None, highlight, self.collection, self.opts.syntax_aliases)
@@ -409,7 +485,7 @@ class DiffHandler(Handler):
 
     def draw_screen(self) -> None:
         self.enforce_cursor_state()
-        if self.state < DIFFED:
+        if self.state < DIFFED and not self.partial_rendered:
             self.cmd.clear_screen()
             self.write(_('Calculating diff, please wait...'))
             return
@@ -7,7 +7,9 @@ import os
 import shlex
 import shutil
 import subprocess
-from typing import Dict, Iterator, List, Optional, Sequence, Tuple, Union
+from typing import (
+    Callable, Dict, Iterator, List, Optional, Sequence, Tuple, Union
+)
 
 from . import global_data
 from .collect import lines_for_path
@@ -228,7 +230,12 @@ class Differ:
         self.jmap[file1] = file2
         self.jobs.append(file1)
 
-    def __call__(self, context: int = 3) -> Union[str, Dict[str, Patch]]:
+    def __call__(
+        self, context: int = 3,
+        result_callback: Optional[Callable[[str, Patch], None]] = None
+    ) -> Union[str, Dict[str, Patch]]:
+        # result_callback, when provided, is invoked with (path, patch) as
+        # each individual file pair finishes, before the full map is returned
         global left_lines, right_lines
         ans: Dict[str, Patch] = {}
         executor = self.diff_executor
@@ -254,4 +261,6 @@ class Differ:
                 return traceback.format_exc() + '\nParsing diff for {} vs. {} failed'.format(left_path, right_path)
             else:
                 ans[key] = patch
+                if result_callback is not None:
+                    result_callback(key, patch)
         return ans
@@ -508,6 +508,11 @@ class RenderDiff:
             is_binary = isinstance(data_for_path(path), bytes)
             if not is_binary and item_type == 'diff' and isinstance(data_for_path(other_path), bytes):
                 is_binary = True
+            if item_type == 'diff' and not is_binary and path not in diff_map:
+                # rendering a partial diff map, stop at the first file whose
+                # diff has not been computed yet so that display order is
+                # preserved as results stream in
+                return
             is_img = is_binary and (is_image(path) or is_image(other_path)) and images_supported()
             yield from yield_lines_from(title_lines(path, other_path, args, columns, margin_size), item_ref, False)
             if item_type == 'diff':
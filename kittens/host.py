@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+# vim:fileencoding=utf-8
+# License: GPL v3 Copyright: 2021, Kovid Goyal <kovid at kovidgoyal.net>
+
+# A resident process that runs kittens on behalf of kitty, so that the
+# interpreter startup and framework import costs are paid only once per kitty
+# instance instead of on every kitten invocation. kitty creates the pty and
+# sends the slave end here over a UNIX socket, the kitten runs in a child
+# forked from this process with its stdio connected to that pty, so all the
+# existing overlay window plumbing in kitty continues to work unchanged.
+
+import array
+import fcntl
+import json
+import os
+import signal
+import socket
+import struct
+import sys
+import termios
+from contextlib import suppress
+from typing import Any, Dict, List, Optional, Tuple
+
+msg_header = struct.Struct('!I')
+
+
+def send_msg_with_fds(sock: socket.socket, msg: bytes, fds: List[int]) -> None:
+    ancdata = []
+    if fds:
+        ancdata.append((socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array('i', fds).tobytes()))
+    sock.sendmsg([msg_header.pack(len(msg)), msg], ancdata)
+
+
+def recv_msg_with_fds(sock: socket.socket, maxfds: int = 8) -> Tuple[bytes, List[int]]:
+    fds: array.array = array.array('i')
+    data, ancdata, flags, addr = sock.recvmsg(msg_header.size, socket.CMSG_LEN(maxfds * fds.itemsize))
+    if not data:
+        return b'', []
+    for cmsg_level, cmsg_type, cmsg_data in ancdata:
+        if cmsg_level == socket.SOL_SOCKET and cmsg_type == socket.SCM_RIGHTS:
+            fds.frombytes(cmsg_data[:len(cmsg_data) - (len(cmsg_data) % fds.itemsize)])
+    while len(data) < msg_header.size:
+        chunk = sock.recv(msg_header.size - len(data))
+        if not chunk:
+            return b'', list(fds)
+        data += chunk
+    msg_len = msg_header.unpack(data)[0]
+    msg = b''
+    while len(msg) < msg_len:
+        chunk = sock.recv(msg_len - len(msg))
+        if not chunk:
+            break
+        msg += chunk
+    return msg, list(fds)
+
+
+# The host process {{{
+
+def preimport_kitten_framework() -> None:
+    for mod in (
+        'kittens.runner', 'kittens.tui.loop', 'kittens.tui.handler',
+        'kittens.tui.operations', 'kitty.cli', 'kitty.config', 'kitty.keys',
+    ):
+        with suppress(Exception):
+            __import__(mod)
+
+
+def reap_children(*a: Any) -> None:
+    with suppress(ChildProcessError):
+        while True:
+            pid, _ = os.waitpid(-1, os.WNOHANG)
+            if pid <= 0:
+                break
+
+
+def run_kitten_in_child(request: Dict[str, Any], slave: int, ready_fd: int, stdin_fd: int) -> None:
+    # Mirrors the setup done by spawn() in child.c for exec'ed kittens
+    for sig in (signal.SIGINT, signal.SIGTERM, signal.SIGCHLD, signal.SIGPIPE):
+        signal.signal(sig, signal.SIG_DFL)
+    signal.pthread_sigmask(signal.SIG_SETMASK, ())
+    with suppress(OSError):
+        os.chdir(request.get('cwd') or '/')
+    os.setsid()
+    fcntl.ioctl(slave, termios.TIOCSCTTY, 0)
+    os.dup2(slave, 1)
+    os.dup2(slave, 2)
+    os.dup2(stdin_fd if stdin_fd > -1 else slave, 0)
+    # Wait for the READY_SIGNAL (an EOF) which indicates kitty has setup the
+    # screen object
+    with suppress(OSError):
+        os.read(ready_fd, 1)
+    os.closerange(3, 256)
+    os.environ.clear()
+    os.environ.update(request['env'])
+    # The inherited stdio objects still refer to the host's file descriptors,
+    # recreate them over the pty, the tui framework uses them directly
+    sys.stdin = sys.__stdin__ = open(0, 'r', closefd=False)
+    sys.stdout = sys.__stdout__ = open(1, 'w', closefd=False)
+    sys.stderr = sys.__stderr__ = open(2, 'w', closefd=False)
+    sys.argv = ['kitten'] + list(request['args'])
+    from kittens.runner import main as runner_main
+    runner_main()
+    with suppress(Exception):
+        sys.stdout.flush()
+        sys.stderr.flush()
+    os._exit(0)
+
+
+def handle_launch_request(sock: socket.socket, request: Dict[str, Any], fds: List[int]) -> None:
+    try:
+        if len(fds) < 2:
+            raise ValueError('launch request without pty and ready file descriptors')
+        slave, ready_fd = fds[0], fds[1]
+        stdin_fd = fds[2] if len(fds) > 2 else -1
+        pid = os.fork()
+        if pid == 0:
+            try:
+                run_kitten_in_child(request, slave, ready_fd, stdin_fd)
+            except BaseException:
+                import traceback
+                traceback.print_exc()
+            finally:
+                os._exit(1)
+        response = {'pid': pid}
+    except Exception as err:
+        response = {'error': str(err) or repr(err)}
+    finally:
+        for fd in fds:
+            with suppress(OSError):
+                os.close(fd)
+    send_msg_with_fds(sock, json.dumps(response).encode('utf-8'), [])
+
+
+def main() -> None:
+    signal.signal(signal.SIGCHLD, reap_children)
+    sock = socket.socket(fileno=os.dup(0))
+    os.close(0)
+    preimport_kitten_framework()
+    while True:
+        try:
+            msg, fds = recv_msg_with_fds(sock)
+        except OSError:
+            break
+        if not msg:
+            break  # kitty closed the socket, we are done
+        try:
+            request = json.loads(msg)
+        except Exception:
+            for fd in fds:
+                with suppress(OSError):
+                    os.close(fd)
+            continue
+        handle_launch_request(sock, request, fds)
+# }}}
+
+
+# The client, used by kitty to talk to the host process {{{
+
+class KittenHost:
+
+    def __init__(self) -> None:
+        self.process: Optional[Any] = None
+        self.sock: Optional[socket.socket] = None
+
+    def ensure_running(self) -> bool:
+        if self.process is not None and self.process.poll() is None:
+            return True
+        self.close()
+        import subprocess
+        from kitty.constants import kitty_exe
+        try:
+            ours, theirs = socket.socketpair()
+            try:
+                self.process = subprocess.Popen(
+                    [kitty_exe(), '+runpy', 'from kittens.host import main; main()'],
+                    stdin=theirs.fileno(), stdout=subprocess.DEVNULL, close_fds=True
+                )
+            finally:
+                theirs.close()
+            ours.settimeout(5)
+            self.sock = ours
+            return True
+        except Exception as err:
+            print('Failed to start kitten host process with error:', err, file=sys.stderr)
+            self.close()
+            return False
+
+    def launch(self, args: List[str], env: Dict[str, str], cwd: str, slave_fd: int, ready_fd: int, stdin_fd: int = -1) -> int:
+        if not self.ensure_running() or self.sock is None:
+            raise OSError('The kitten host process could not be started')
+        msg = json.dumps({'args': args, 'env': env, 'cwd': cwd}).encode('utf-8')
+        fds = [slave_fd, ready_fd]
+        if stdin_fd > -1:
+            fds.append(stdin_fd)
+        try:
+            send_msg_with_fds(self.sock, msg, fds)
+            response, _ = recv_msg_with_fds(self.sock)
+        except Exception:
+            # the host process is broken, get rid of it so the next launch
+            # starts a fresh one
+            self.close()
+            raise
+        if not response:
+            self.close()
+            raise OSError('The kitten host process died')
+        ans = json.loads(response)
+        if 'error' in ans:
+            raise OSError('Failed to launch kitten in host process: {}'.format(ans['error']))
+        pid: int = ans['pid']
+        return pid
+
+    def close(self) -> None:
+        if self.sock is not None:
+            with suppress(OSError):
+                self.sock.close()
+            self.sock = None
+        if self.process is not None:
+            if self.process.poll() is None:
+                with suppress(OSError):
+                    self.process.terminate()
+            with suppress(Exception):
+                self.process.wait(1)
+            self.process = None
+
+
+def kitten_host() -> Optional[KittenHost]:
+    if os.environ.get('KITTY_DISABLE_KITTEN_HOST'):
+        return None
+    ans: Optional[KittenHost] = getattr(kitten_host, 'ans', None)
+    if ans is None:
+        ans = KittenHost()
+        setattr(kitten_host, 'ans', ans)
+    return ans
+# }}}
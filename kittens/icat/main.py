@@ -11,6 +11,7 @@ import sys
 import zlib
 from base64 import standard_b64encode
 from functools import lru_cache
+from itertools import count
 from math import ceil
 from tempfile import NamedTemporaryFile
 from typing import (
@@ -62,13 +63,13 @@ Remove all images currently displayed on the screen.
 
 --transfer-mode
 type=choices
-choices=detect,file,stream
+choices=detect,file,memory,stream
 default=detect
 Which mechanism to use to transfer images to the terminal. The default is to
-auto-detect. :italic:`file` means to use a temporary file and :italic:`stream` means to
-send the data via terminal escape codes. Note that if you use the :italic:`file`
-transfer mode and you are connecting over a remote session then image display
-will not work.
+auto-detect. :italic:`file` means to use a temporary file, :italic:`memory` means to use
+a POSIX shared memory object and :italic:`stream` means to send the data via terminal
+escape codes. Note that if you use the :italic:`file` or :italic:`memory` transfer modes
+and you are connecting over a remote session then image display will not work.
 
 
 --detect-support
@@ -120,6 +121,12 @@ Wait for keypress before exiting after displaying the images.
 
 screen_size: Optional[ScreenSizeGetter] = None
 can_transfer_with_files = False
+can_transfer_with_memory = False
+shm_name_counter = count()
+
+
+def next_shm_name() -> str:
+    return '/{}-icat-{}-{}'.format(appname, os.getpid(), next(shm_name_counter))
 
 
 def get_screen_size_function() -> ScreenSizeGetter:
@@ -219,7 +226,19 @@ def show(
         set_cursor_for_place(place, cmd, width, height, align)
     else:
         set_cursor(cmd, width, height, align)
-    if can_transfer_with_files:
+    if can_transfer_with_memory:
+        # Post the pixel data into a shared memory object, the terminal maps
+        # it directly and unlinks it once read, nothing goes over the pty
+        with open(outfile, 'rb') as f:
+            data = f.read()
+        if transmit_mode == 't':
+            os.unlink(outfile)
+        from kitty.fast_data_types import shm_write
+        name = next_shm_name()
+        shm_write(name, data)
+        cmd.t = 's'
+        write_gr_cmd(cmd, standard_b64encode(name.encode(fsenc)))
+    elif can_transfer_with_files:
         cmd.t = transmit_mode
         write_gr_cmd(cmd, standard_b64encode(os.path.abspath(outfile).encode(fsenc)))
     else:
@@ -279,18 +298,19 @@ def scan(d: str) -> Generator[Tuple[str, str], None, None]:
 
 
 def detect_support(wait_for: float = 10, silent: bool = False) -> bool:
-    global can_transfer_with_files
+    global can_transfer_with_files, can_transfer_with_memory
     if not silent:
         print('Checking for graphics ({}s max. wait)...'.format(wait_for), end='\r')
     sys.stdout.flush()
+    shm_name = ''
     try:
         received = b''
         responses: Dict[int, bool] = {}
 
         def parse_responses() -> None:
-            for m in re.finditer(b'\033_Gi=([1|2]);(.+?)\033\\\\', received):
+            for m in re.finditer(b'\033_Gi=([123]);(.+?)\033\\\\', received):
                 iid = m.group(1)
-                if iid in (b'1', b'2'):
+                if iid in (b'1', b'2', b'3'):
                     iid_ = int(iid.decode('ascii'))
                     if iid_ not in responses:
                         responses[iid_] = m.group(2) == b'OK'
@@ -299,7 +319,7 @@ def detect_support(wait_for: float = 10, silent: bool = False) -> bool:
             nonlocal received
             received += data
             parse_responses()
-            return 1 not in responses or 2 not in responses
+            return 1 not in responses or 2 not in responses or (bool(shm_name) and 3 not in responses)
 
         with NamedTemporaryFile() as f:
             f.write(b'abcd'), f.flush()
@@ -310,12 +330,27 @@ def detect_support(wait_for: float = 10, silent: bool = False) -> bool:
             gc.t = 'f'
             gc.i = 2
             write_gr_cmd(gc, standard_b64encode(f.name.encode(fsenc)))
+            try:
+                from kitty.fast_data_types import shm_write
+                shm_name = next_shm_name()
+                shm_write(shm_name, b'abcd')
+                gc.t = 's'
+                gc.i = 3
+                write_gr_cmd(gc, standard_b64encode(shm_name.encode(fsenc)))
+            except (ImportError, OSError):
+                shm_name = ''
             with TTYIO() as io:
                 io.recv(more_needed, timeout=wait_for)
     finally:
         if not silent:
             sys.stdout.buffer.write(b'\033[J'), sys.stdout.flush()
+    if shm_name and not responses.get(3):
+        # the terminal did not read (and therefore unlink) the probe object
+        with contextlib.suppress(Exception):
+            from kitty.fast_data_types import shm_unlink
+            shm_unlink(shm_name)
     can_transfer_with_files = bool(responses.get(2))
+    can_transfer_with_memory = bool(responses.get(3))
     return responses.get(1, False)
 
 
@@ -404,7 +439,7 @@ def process_single_item(
 
 
 def main(args: List[str] = sys.argv) -> None:
-    global can_transfer_with_files
+    global can_transfer_with_files, can_transfer_with_memory
     cli_opts, items_ = parse_args(args[1:], options_spec, usage, help_text, '{} +kitten icat'.format(appname), result_class=IcatCLIOptions)
     items: List[Union[str, bytes]] = list(items_)
 
@@ -448,13 +483,14 @@ def main(args: List[str] = sys.argv) -> None:
     if cli_opts.detect_support:
         if not detect_support(wait_for=cli_opts.detection_timeout, silent=True):
             raise SystemExit(1)
-        print('file' if can_transfer_with_files else 'stream', end='', file=sys.stderr)
+        print('memory' if can_transfer_with_memory else ('file' if can_transfer_with_files else 'stream'), end='', file=sys.stderr)
         return
     if cli_opts.transfer_mode == 'detect':
         if not detect_support(wait_for=cli_opts.detection_timeout, silent=cli_opts.silent):
             raise SystemExit('This terminal emulator does not support the graphics protocol, use a terminal emulator such as kitty that does support it')
     else:
         can_transfer_with_files = cli_opts.transfer_mode == 'file'
+        can_transfer_with_memory = cli_opts.transfer_mode == 'memory'
     errors = []
     if cli_opts.clear:
         sys.stdout.write(clear_images_on_screen(delete_data=True))
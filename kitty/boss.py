@@ -10,22 +10,23 @@ from contextlib import suppress
 from functools import partial
 from gettext import gettext as _
 from typing import (
-    Any, Callable, Dict, Generator, Iterable, List, Optional, Tuple, Union,
-    cast
+    Any, Callable, Container, Dict, Generator, Iterable, List, Optional, Tuple,
+    Union, cast
 )
 from weakref import WeakValueDictionary
 
 from .child import cached_process_data, cwd_of_process
-from .cli import create_opts, parse_args
+from .cli import SYSTEM_CONF, create_opts, parse_args
 from .cli_stub import CLIOptions
-from .conf.utils import BadLine, to_cmdline
+from .conf.utils import BadLine, resolve_config, to_cmdline
 from .config import (
     KeyAction, SubSequenceMap, common_opts_as_dict,
     prepare_config_file_for_editing
 )
 from .config_data import MINIMUM_FONT_SIZE
 from .constants import (
-    appname, config_dir, is_macos, kitty_exe, supports_primary_selection
+    appname, config_dir, defconf, is_macos, kitty_exe,
+    supports_primary_selection
 )
 from .fast_data_types import (
     CLOSE_BEING_CONFIRMED, IMPERATIVE_CLOSE_REQUESTED, NO_CLOSE_REQUESTED,
@@ -33,8 +34,10 @@ from .fast_data_types import (
     change_os_window_state, cocoa_set_menubar_title, create_os_window,
     current_application_quit_request, current_os_window, destroy_global_data,
     focus_os_window, get_clipboard_string, global_font_size,
-    mark_os_window_for_close, os_window_font_size, patch_global_colors,
-    safe_pipe, set_application_quit_request, set_background_image, set_boss,
+    mark_os_window_for_close, os_window_font_size, patch_color_profiles,
+    patch_global_colors,
+    request_clipboard_string, safe_pipe, set_application_quit_request,
+    set_background_image, set_boss,
     set_clipboard_string, set_in_sequence_mode, thread_write,
     toggle_fullscreen, toggle_maximized
 )
@@ -43,7 +46,7 @@ from .layout.base import set_layout_options
 from .notify import notification_activated
 from .options_stub import Options
 from .os_window_size import initial_window_size_func
-from .rgb import Color, color_from_int
+from .rgb import Color, color_as_int, color_from_int
 from .session import Session, create_sessions, get_os_window_sizing_data
 from .tabs import (
     SpecialWindow, SpecialWindowInstance, Tab, TabDict, TabManager
@@ -144,6 +147,7 @@ class Boss:
     ):
         set_layout_options(opts)
         self.clipboard_buffers: Dict[str, str] = {}
+        self.clipboard_paste_window_id: Optional[int] = None
         self.update_check_process: Optional[PopenType] = None
         self.window_id_map: WeakValueDictionary[int, Window] = WeakValueDictionary()
         self.startup_colors = {k: opts[k] for k in opts if isinstance(opts[k], Color)}
@@ -152,6 +156,7 @@ class Boss:
         self.cached_values = cached_values
         self.os_window_map: Dict[int, TabManager] = {}
         self.os_window_death_actions: Dict[int, Callable[[], None]] = {}
+        self.peer_opts_cache: Optional[Tuple[Any, Options]] = None
         self.cursor_blinking = True
         self.shutting_down = False
         talk_fd = getattr(single_instance, 'socket', None)
@@ -215,7 +220,7 @@ class Boss:
         self.os_window_map[os_window_id] = tm
         return os_window_id
 
-    def list_os_windows(self) -> Generator[OSWindowDict, None, None]:
+    def list_os_windows(self, window_fields: Optional[Container[str]] = None) -> Generator[OSWindowDict, None, None]:
         with cached_process_data():
             active_tab, active_window = self.active_tab, self.active_window
             active_tab_manager = self.active_tab_manager
@@ -224,7 +229,7 @@ class Boss:
                     'id': os_window_id,
                     'platform_window_id': platform_window_id(os_window_id),
                     'is_focused': tm is active_tab_manager,
-                    'tabs': list(tm.list_tabs(active_tab, active_window)),
+                    'tabs': list(tm.list_tabs(active_tab, active_window, window_fields)),
                     'wm_class': tm.wm_class,
                     'wm_name': tm.wm_name
                 }
@@ -391,7 +396,49 @@ class Boss:
             tb = traceback.format_exc()
             self.show_error(_('remote_control mapping failed'), tb)
 
+    def opts_for_new_instance(self, args: CLIOptions) -> Options:
+        # Opening a new OS window in the single instance process is our most
+        # frequent operation and everything expensive, imports, GLFW init,
+        # compiled shaders, font group caches, is already resident and
+        # shared. The one remaining Python side cost that matters is
+        # re-parsing the configuration, so cache the parsed options keyed on
+        # the resolved config files, their modification times and any command
+        # line overrides.
+        config = tuple(resolve_config(SYSTEM_CONF, defconf, args.config))
+
+        def mtime(path: str) -> Optional[float]:
+            with suppress(OSError):
+                return os.path.getmtime(path)
+            return None
+
+        key = config, tuple(args.override or ()), tuple(map(mtime, config))
+        if self.peer_opts_cache is not None and self.peer_opts_cache[0] == key:
+            return self.peer_opts_cache[1]
+        opts = create_opts(args)
+        self.peer_opts_cache = key, opts
+        return opts
+
     def peer_message_received(self, msg_bytes: bytes) -> Optional[bytes]:
+        if msg_bytes.startswith(b'\x00'):
+            # a length prefixed binary frame, see remote_control.encode_frame().
+            # A response frame is sent only for commands that carry an id, with
+            # the id echoed back, so that a client pipelining many commands
+            # over a single connection can correlate responses as they arrive.
+            # Commands without an id are fire-and-forget and generate no
+            # response traffic at all
+            cmd = msg_bytes[5:].decode('utf-8')
+            response = self._handle_remote_command(cmd, from_peer=True)
+            try:
+                cmd_id = json.loads(cmd).get('id')
+            except Exception:
+                cmd_id = None
+            if cmd_id is None:
+                return None
+            if response is None:
+                response = {'ok': True}
+            response['id'] = cmd_id
+            payload = json.dumps(response).encode('utf-8')
+            return b'\x00' + len(payload).to_bytes(4, 'little') + payload
         cmd_prefix = b'\x1bP@kitty-cmd'
         terminator = b'\x1b\\'
         if msg_bytes.startswith(cmd_prefix) and msg_bytes.endswith(terminator):
@@ -407,7 +454,7 @@ class Boss:
             startup_id = data.get('startup_id')
             args, rest = parse_args(data['args'][1:], result_class=CLIOptions)
             args.args = rest
-            opts = create_opts(args)
+            opts = self.opts_for_new_instance(args)
             if not os.path.isabs(args.directory):
                 args.directory = os.path.join(data['cwd'], args.directory)
             for session in create_sessions(opts, args, respect_cwd=True):
@@ -938,7 +985,8 @@ class Boss:
                         'OVERLAID_WINDOW_COLS': str(w.screen.columns),
                     },
                     cwd=w.cwd_of_child,
-                    overlay_for=w.id
+                    overlay_for=w.id,
+                    hosted_kitten=True
                 ),
                 copy_colors_from=w
             )
@@ -1070,6 +1118,10 @@ class Boss:
 
     def destroy(self) -> None:
         self.shutting_down = True
+        from kittens.host import kitten_host
+        host = kitten_host()
+        if host is not None:
+            host.close()
         self.child_monitor.shutdown_monitor()
         self.set_update_check_process()
         self.update_check_process = None
@@ -1079,19 +1131,50 @@ class Boss:
         self.os_window_map = {}
         destroy_global_data()
 
+    def on_child_write_drain(self, window_id: int) -> None:
+        # called when a window's write buffer, for which a drain notification
+        # was requested, has drained below the watermark
+        w = self.window_id_map.get(window_id)
+        if w is not None:
+            w.on_write_buffer_drained()
+
     def paste_to_active_window(self, text: str) -> None:
         if text:
             w = self.active_window
             if w is not None:
                 w.paste(text)
 
+    def stream_paste_to_active_window(self, primary: bool) -> None:
+        # Stream the clipboard into the active window rather than reading it
+        # whole, so that huge pastes are never buffered in memory. Chunks are
+        # delivered to clipboard_chunk_received(), possibly before
+        # request_clipboard_string() returns.
+        w = self.active_window
+        if w is None or w.destroyed:
+            return
+        if self.clipboard_paste_window_id is not None:
+            return  # a paste is already streaming
+        w.start_clipboard_paste()
+        self.clipboard_paste_window_id = w.id
+        if not request_clipboard_string(primary):
+            self.clipboard_paste_window_id = None
+
+    def clipboard_chunk_received(self, data: Optional[bytes]) -> bool:
+        wid = self.clipboard_paste_window_id
+        if data is None:
+            self.clipboard_paste_window_id = None
+        if wid is None:
+            return True
+        w = self.window_id_map.get(wid)
+        if w is None:
+            return True  # let the transfer complete, discarding the data
+        return w.clipboard_paste_chunk(data)
+
     def paste_from_clipboard(self) -> None:
-        text = get_clipboard_string()
-        self.paste_to_active_window(text)
+        self.stream_paste_to_active_window(primary=False)
 
     def paste_from_selection(self) -> None:
-        text = get_primary_selection() if supports_primary_selection else get_clipboard_string()
-        self.paste_to_active_window(text)
+        self.stream_paste_to_active_window(primary=supports_primary_selection)
 
     def set_primary_selection(self) -> None:
         w = self.active_window
@@ -1374,6 +1457,77 @@ class Boss:
             tm.tab_bar.patch_colors(spec)
         patch_global_colors(spec, configured)
 
+    def on_config_reload_signal(self) -> None:
+        # Reload the config files on SIGUSR1 without blocking the render
+        # loop. Parsing is cheap thanks to the binary config cache, but it
+        # still hits the filesystem, so run it on a worker thread and poll
+        # for the result with a timer.
+        from threading import Thread
+        result: Dict[str, Any] = {}
+
+        def parse() -> None:
+            try:
+                result['opts'] = create_opts(self.args)
+            except Exception:
+                import traceback
+                result['error'] = traceback.format_exc()
+
+        thread = Thread(target=parse, name='ConfigReload', daemon=True)
+        thread.start()
+
+        def check_result(timer_id: Optional[int]) -> None:
+            if thread.is_alive():
+                add_timer(check_result, 0.05, False)
+                return
+            err = result.get('error')
+            if err is not None:
+                log_error('Failed to reload config, with error:')
+                log_error(err)
+                return
+            self.apply_reloaded_options(result['opts'])
+
+        add_timer(check_result, 0.05, False)
+
+    def apply_reloaded_options(self, opts: Options) -> None:
+        # Apply what can change in a running instance, spread over frames
+        # so that sessions with many OS windows do not stall. Font changes
+        # need a font group rebuild, which only happens at startup, so they
+        # are reported rather than applied.
+        font_keys = (
+            'font_family', 'bold_font', 'italic_font', 'bold_italic_font',
+            'font_size', 'font_features', 'symbol_map', 'adjust_line_height',
+            'adjust_column_width'
+        )
+        if any(getattr(opts, k) != getattr(self.opts, k) for k in font_keys):
+            log_error('Changing font settings of a running instance is not supported, ignoring font related config changes')
+        spec = {k: color_as_int(opts[k]) for k in opts if isinstance(opts[k], Color)}
+        ctc = opts.cursor_text_color
+        cursor_text_color = color_as_int(ctc) if isinstance(ctc, Color) else None
+        default_bg_changed = spec.get('background') != color_as_int(self.opts.background)
+        for k, v in spec.items():
+            setattr(self.opts, k, color_from_int(v))
+        self.opts.cursor_text_color = ctc
+        patch_global_colors(spec, True)
+        os_window_ids = list(self.os_window_map)
+
+        def patch_one_os_window(timer_id: Optional[int] = None) -> None:
+            while os_window_ids:
+                tm = self.os_window_map.get(os_window_ids.pop(0))
+                if tm is None:
+                    continue
+                windows = [w for tab in tm for w in tab]
+                patch_color_profiles(spec, cursor_text_color, tuple(w.screen.color_profile for w in windows), True)
+                tm.tab_bar.patch_colors(spec)
+                for w in windows:
+                    if default_bg_changed:
+                        self.default_bg_changed_for(w.id)
+                    w.refresh()
+                break
+            if os_window_ids:
+                add_timer(patch_one_os_window, 0, False)
+
+        patch_one_os_window()
+
     def safe_delete_temp_file(self, path: str) -> None:
         if is_path_in_temp_dir(path):
             with suppress(FileNotFoundError):
@@ -26,10 +26,14 @@ uniform uint draw_bg_bitfield;
 #endif
 
 // Have to use fixed locations here as all variants of the cell program share the same VAO
-layout(location=0) in uvec3 colors;
+layout(location=0) in uint packed_colors;
 layout(location=1) in uvec4 sprite_coords;
 layout(location=2) in uint is_selected;
 
+// side table of (fg, bg, decoration_fg) triples for truecolor cells, which
+// do not fit in the packed colors word
+uniform usamplerBuffer truecolor_table;
+
 
 const int fg_index_map[] = int[3](0, 1, 0);
 const uvec2 cell_pos_map[] = uvec2[4](
@@ -111,6 +115,23 @@ vec3 to_color(uint c, uint defval) {
     return color_to_vec(resolve_color(c, defval));
 }
 
+const uint TRUECOLOR_ESCAPE = uint(1) << 31;
+const uint TEN_BIT_MASK = uint(0x3FF);
+
+uint unpack_cell_color(uint p) {
+    // a packed color is 10 bits: the low byte is the payload and bits 8-9
+    // the color type, convert back to the encoding resolve_color expects
+    return ((p & BYTE_MASK) << 8) | (p >> 8);
+}
+
+uvec3 unpack_colors(uint p) {
+    if ((p & TRUECOLOR_ESCAPE) != ZERO) {
+        int i = 3 * int(p & ~TRUECOLOR_ESCAPE);
+        return uvec3(texelFetch(truecolor_table, i).r, texelFetch(truecolor_table, i + 1).r, texelFetch(truecolor_table, i + 2).r);
+    }
+    return uvec3(unpack_cell_color(p & TEN_BIT_MASK), unpack_cell_color((p >> 10) & TEN_BIT_MASK), unpack_cell_color((p >> 20) & TEN_BIT_MASK));
+}
+
 vec3 to_sprite_pos(uvec2 pos, uint x, uint y, uint z) {
     vec2 s_xpos = vec2(x, float(x) + 1.0) * sprite_dx;
     vec2 s_ypos = vec2(y, float(y) + 1.0) * sprite_dy;
@@ -156,6 +177,7 @@ void main() {
     // }}}
 
     // set cell color indices {{{
+    uvec3 colors = unpack_colors(packed_colors);
     uvec2 default_colors = uvec2(default_fg, default_bg);
     uint text_attrs = sprite_coords[3];
     uint is_reversed = ((text_attrs >> REVERSE_SHIFT) & ONE);
@@ -9,6 +9,16 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
 #define UTF8_ACCEPT 0
 #define UTF8_REJECT 1
 
@@ -262,6 +272,67 @@ decode_utf8_string(const char *src, size_t sz, uint32_t *dest) {
     return d;
 }
 
+size_t
+decode_utf8_chunk(const uint8_t *src, size_t sz, uint32_t *dest, size_t *consumed) {
+    // Bulk decoder for runs of text, used by the parser's normal mode fast
+    // path. Decodes sequences directly instead of pumping the DFA one byte at
+    // a time, validating as it goes. Stops before a trailing incomplete
+    // sequence, setting *consumed so the caller can feed the remaining bytes
+    // to decode_utf8(). Malformed sequences are skipped with resynchronization
+    // at the next possible lead byte, matching the DFA's error recovery. Also
+    // stops before any decoded C1 control codepoint (0x80 - 0x9f) so that the
+    // caller's escape code state machine can process it, which means all
+    // returned codepoints are guaranteed to be plain text.
+    size_t i = 0, d = 0;
+    while (i < sz) {
+        uint8_t b = src[i];
+        if (b < 0x80) {
+#ifdef __SSE2__
+            // consume whole blocks of ASCII at a time
+            while (i + 16 <= sz) {
+                __m128i chunk = _mm_loadu_si128((const __m128i*)(src + i));
+                int mask = _mm_movemask_epi8(chunk);
+                unsigned int num = mask ? __builtin_ctz(mask) : 16;
+                for (unsigned int j = 0; j < num; j++) dest[d++] = src[i + j];
+                i += num;
+                if (mask) break;
+            }
+            if (i >= sz || src[i] >= 0x80) continue;
+            b = src[i];
+#endif
+            dest[d++] = b; i++;
+        } else if (b < 0xc2) {
+            i++;  // stray continuation byte or overlong lead, skip it
+        } else if (b < 0xe0) {
+            if (i + 2 > sz) break;
+            if ((src[i+1] & 0xc0) != 0x80) { i++; continue; }
+            uint32_t cp = ((b & 0x1f) << 6) | (src[i+1] & 0x3f);
+            if (cp < 0xa0) break;  // C1 control, leave for the caller
+            dest[d++] = cp;
+            i += 2;
+        } else if (b < 0xf0) {
+            if (i + 3 > sz) break;
+            if ((src[i+1] & 0xc0) != 0x80 || (src[i+2] & 0xc0) != 0x80) { i++; continue; }
+            uint32_t cp = ((b & 0xf) << 12) | ((src[i+1] & 0x3f) << 6) | (src[i+2] & 0x3f);
+            // reject overlong encodings and surrogates
+            if (cp < 0x800 || (0xd800 <= cp && cp <= 0xdfff)) { i++; continue; }
+            dest[d++] = cp;
+            i += 3;
+        } else if (b < 0xf5) {
+            if (i + 4 > sz) break;
+            if ((src[i+1] & 0xc0) != 0x80 || (src[i+2] & 0xc0) != 0x80 || (src[i+3] & 0xc0) != 0x80) { i++; continue; }
+            uint32_t cp = ((b & 0x7) << 18) | ((src[i+1] & 0x3f) << 12) | ((src[i+2] & 0x3f) << 6) | (src[i+3] & 0x3f);
+            if (cp < 0x10000 || cp > 0x10ffff) { i++; continue; }
+            dest[d++] = cp;
+            i += 4;
+        } else {
+            i++;  // invalid lead byte
+        }
+    }
+    *consumed = i;
+    return d;
+}
+
 unsigned int
 encode_utf8(uint32_t ch, char* dest) {
     if (ch < 0x80) {
@@ -292,6 +363,78 @@ encode_utf8(uint32_t ch, char* dest) {
 
 // Base64
 // standard decoding using + and / with = being the padding character
+
+#if defined(__SSSE3__) || defined(__ARM_NEON)
+#define HAS_SIMD_BASE64 1
+#endif
+
+#ifdef __SSSE3__
+// Decode 16 base64 characters from the parser buffer into 12 bytes, using
+// Wojciech Mula's nibble lookup-shuffle technique. Returns false without
+// writing anything if any of the 16 codepoints is not a base64 alphabet
+// character, in which case the caller must fall back to the scalar decoder.
+// Note: writes 16 bytes to dest, of which only the first 12 are meaningful.
+static inline bool
+base64_decode16(const uint32_t *src, uint8_t *dest) {
+    // Pack the 16 codepoints down to 16 bytes. Codepoints > 0xff saturate to
+    // 0xff and are rejected by the validation below.
+    __m128i chars = _mm_packus_epi16(
+        _mm_packs_epi32(_mm_loadu_si128((const __m128i*)src), _mm_loadu_si128((const __m128i*)(src + 4))),
+        _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(src + 8)), _mm_loadu_si128((const __m128i*)(src + 12))));
+    // Validity bitmasks and translation offsets indexed by character nibbles
+    const __m128i lut_lo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lut_hi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), _mm_set1_epi8(0x0f));
+    __m128i lo_nibbles = _mm_and_si128(chars, _mm_set1_epi8(0x0f));
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff) return false;
+    __m128i eq_2f = _mm_cmpeq_epi8(chars, _mm_set1_epi8(0x2f));
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+    __m128i values = _mm_add_epi8(chars, roll);
+    // Pack the 16 six bit values into 12 bytes
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128((__m128i*)dest, merged);
+    return true;
+}
+#elif defined(__ARM_NEON)
+// NEON variant of the above, same contract
+static inline bool
+base64_decode16(const uint32_t *src, uint8_t *dest) {
+    static const uint8_t lut_lo_[16] = {
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a};
+    static const uint8_t lut_hi_[16] = {
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10};
+    static const uint8_t lut_roll_[16] = {0, 16, 19, 4, 0xbf, 0xbf, 0xb9, 0xb9, 0, 0, 0, 0, 0, 0, 0, 0};
+    static const uint8_t pack_idx_[16] = {0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0xff, 0xff, 0xff, 0xff};
+    // Saturating narrow, codepoints > 0xff become 0xff and fail validation
+    uint16x8_t w0 = vcombine_u16(vqmovn_u32(vld1q_u32(src)), vqmovn_u32(vld1q_u32(src + 4)));
+    uint16x8_t w1 = vcombine_u16(vqmovn_u32(vld1q_u32(src + 8)), vqmovn_u32(vld1q_u32(src + 12)));
+    uint8x16_t chars = vcombine_u8(vqmovn_u16(w0), vqmovn_u16(w1));
+    uint8x16_t hi_nibbles = vshrq_n_u8(chars, 4);
+    uint8x16_t lo_nibbles = vandq_u8(chars, vdupq_n_u8(0x0f));
+    uint8x16_t lo = vqtbl1q_u8(vld1q_u8(lut_lo_), lo_nibbles);
+    uint8x16_t hi = vqtbl1q_u8(vld1q_u8(lut_hi_), hi_nibbles);
+    if (vmaxvq_u8(vandq_u8(lo, hi))) return false;
+    uint8x16_t eq_2f = vceqq_u8(chars, vdupq_n_u8(0x2f));
+    uint8x16_t roll = vqtbl1q_u8(vld1q_u8(lut_roll_), vaddq_u8(hi_nibbles, eq_2f));
+    uint32x4_t x = vreinterpretq_u32_u8(vaddq_u8(chars, roll));
+    // Pack the four six bit values in every 32 bit lane into three bytes,
+    // then compress the lanes to give 12 contiguous output bytes
+    uint32x4_t b0 = vorrq_u32(vshlq_n_u32(vandq_u32(x, vdupq_n_u32(0x3f)), 2), vandq_u32(vshrq_n_u32(x, 12), vdupq_n_u32(0x03)));
+    uint32x4_t b1 = vorrq_u32(vandq_u32(vshrq_n_u32(x, 4), vdupq_n_u32(0xf0)), vandq_u32(vshrq_n_u32(x, 18), vdupq_n_u32(0x0f)));
+    uint32x4_t b2 = vandq_u32(vshrq_n_u32(x, 10), vdupq_n_u32(0xc0));
+    uint32x4_t out = vorrq_u32(vorrq_u32(b0, vshlq_n_u32(b1, 8)), vshlq_n_u32(vorrq_u32(b2, vshrq_n_u32(x, 24)), 16));
+    vst1q_u8(dest, vqtbl1q_u8(vreinterpretq_u8_u32(out), vld1q_u8(pack_idx_)));
+    return true;
+}
+#endif
+
 static uint8_t b64_decoding_table[256] = {
 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 62, 0, 0, 0, 63, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 0, 0, 0, 0, 0, 0, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
@@ -305,7 +448,19 @@ base64_decode(const uint32_t *src, size_t src_sz, uint8_t *dest, size_t dest_cap
     if (src[src_sz - 1] == '=') (*dest_sz)--;
     if (src[src_sz - 2] == '=') (*dest_sz)--;
     if (*dest_sz > dest_capacity) return "output buffer too small";
-    for (size_t i = 0, j = 0; i < src_sz;) {
+    size_t i = 0, j = 0;
+#ifdef HAS_SIMD_BASE64
+    // Fast path: 16 characters -> 12 bytes per iteration. Stop before the
+    // final quad, which can contain padding, and keep 16 bytes of headroom in
+    // dest since base64_decode16 overwrites 4 bytes past its 12 byte output.
+    // Invalid characters make it return false, the scalar loop below then
+    // handles them the same way as before.
+    while (i + 16 <= src_sz - 4 && j + 16 <= dest_capacity) {
+        if (!base64_decode16(src + i, dest + j)) break;
+        i += 16; j += 12;
+    }
+#endif
+    while (i < src_sz) {
         uint32_t sextet_a = src[i] == '=' ? 0 & i++ : b64_decoding_table[src[i++] & 0xff];
         uint32_t sextet_b = src[i] == '=' ? 0 & i++ : b64_decoding_table[src[i++] & 0xff];
         uint32_t sextet_c = src[i] == '=' ? 0 & i++ : b64_decoding_table[src[i++] & 0xff];
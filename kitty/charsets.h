@@ -11,4 +11,5 @@
 
 uint32_t decode_utf8(uint32_t*, uint32_t*, uint8_t byte);
 size_t decode_utf8_string(const char *src, size_t sz, uint32_t *dest);
+size_t decode_utf8_chunk(const uint8_t *src, size_t sz, uint32_t *dest, size_t *consumed);
 unsigned int encode_utf8(uint32_t ch, char* dest);
@@ -12,11 +12,13 @@
 #include "fonts.h"
 #include "charsets.h"
 #include "monotonic.h"
+#include "tracepoints.h"
 #include <termios.h>
 #include <unistd.h>
 #include <float.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <sys/socket.h>
 #include <signal.h>
@@ -28,14 +30,13 @@ extern PyTypeObject Screen_Type;
 #define EVDBG(...)
 #endif
 
-#define EXTRA_FDS 2
 #ifndef MSG_NOSIGNAL
 // Apple does not implement MSG_NOSIGNAL
 #define MSG_NOSIGNAL 0
 #endif
 #define USE_RENDER_FRAMES (global_state.has_render_frames && OPT(sync_to_monitor))
 
-static void (*parse_func)(Screen*, PyObject*, monotonic_t);
+static void (*parse_func)(Screen*, PyObject*, monotonic_t, size_t);
 
 typedef struct {
     char *data;
@@ -64,6 +65,8 @@ typedef struct {
     int fd;
     unsigned long id;
     pid_t pid;
+    // the events currently registered with the I/O poller for this fd
+    short poll_events;
 } Child;
 
 static const Child EMPTY_CHILD = {0};
@@ -80,9 +83,10 @@ static Child scratch[MAX_CHILDREN] = {{0}};
 static Child add_queue[MAX_CHILDREN] = {{0}}, remove_queue[MAX_CHILDREN] = {{0}};
 static unsigned long remove_notify[MAX_CHILDREN] = {0};
 static size_t add_queue_count = 0, remove_queue_count = 0;
-static struct pollfd fds[MAX_CHILDREN + EXTRA_FDS] = {{0}};
+static Poller io_poller = {.fd = -1};
 static pthread_mutex_t children_lock, talk_lock;
 static bool kill_signal_received = false;
+static bool reload_config_signal_received = false;
 static ChildMonitor *the_monitor = NULL;
 static uint8_t drain_buf[1024];
 
@@ -97,6 +101,40 @@ static size_t monitored_pids_count = 0;
 static ReapedPID reaped_pids[arraysz(monitored_pids)] = {{0}};
 static size_t reaped_pids_count = 0;
 
+// Performance counters {{{
+// Plain counters, each written by exactly one thread and read without locks
+// when reporting, so a report may see slightly torn values, which is fine
+// for monitoring. Cheap enough to be always on.
+typedef struct {
+    uint64_t sum_ns, max_ns, count;
+    uint64_t hist[16];  // histogram over log2(microsecond) buckets
+} PerfTimeDist;
+
+static inline void
+perf_time_sample(PerfTimeDist *d, monotonic_t duration) {
+    uint64_t ns = duration > 0 ? (uint64_t)duration : 0;
+    d->sum_ns += ns; d->count++;
+    if (ns > d->max_ns) d->max_ns = ns;
+    uint64_t us = ns / 1000;
+    unsigned bucket = 0;
+    while (us > 1 && bucket < arraysz(d->hist) - 1) { us >>= 1; bucket++; }
+    d->hist[bucket]++;
+}
+
+static struct {
+    // written by the io thread
+    uint64_t io_wakeups, read_calls, bytes_read, bytes_written;
+    monotonic_t last_main_wakeup_at;  // set by the io thread, cleared by the main thread
+    // written by the talk thread
+    uint64_t talk_wakeups, peer_messages, peer_bytes_read, peer_bytes_written;
+    // written by the main thread
+    uint64_t ticks, frames_rendered, timer_fires;
+    PerfTimeDist parse_time, wakeup_latency, input_latency;
+    // startup milestones, set once and left alone
+    monotonic_t first_parse_at, first_frame_at;
+} perf = {0};
+// }}}
+
 
 
 // Main thread functions {{{
@@ -117,6 +155,20 @@ set_maximum_wait(monotonic_t val) {
     if (val >= 0 && (val < maximum_wait || maximum_wait < 0)) maximum_wait = val;
 }
 
+// Wakeups for blink and visual bell animation are rounded up onto a shared
+// clock whose ticks are multiples of the render cadence, measured from the
+// monotonic epoch. That way the animation timers of every window fire on the
+// same tick and one wakeup serves all of them, instead of each window waking
+// the loop at its own phase.
+static inline void
+set_animation_wait(monotonic_t now, monotonic_t delay) {
+    if (delay < 0) return;
+    monotonic_t q = OPT(repaint_delay) > 0 ? OPT(repaint_delay) : ms_to_monotonic_t(10ll);
+    monotonic_t target = now + delay;
+    target = ((target + q - 1) / q) * q;
+    set_maximum_wait(target - now);
+}
+
 static PyObject *
 new(PyTypeObject *type, PyObject *args, PyObject UNUSED *kwds) {
     ChildMonitor *self;
@@ -146,8 +198,6 @@ new(PyTypeObject *type, PyObject *args, PyObject UNUSED *kwds) {
         parse_func = parse_worker_dump;
     } else parse_func = parse_worker;
     self->count = 0;
-    fds[0].fd = self->io_loop_data.wakeup_read_fd; fds[1].fd = self->io_loop_data.signal_read_fd;
-    fds[0].events = POLLIN; fds[1].events = POLLIN;
     the_monitor = self;
 
     return (PyObject*) self;
@@ -230,6 +280,23 @@ add_child(ChildMonitor *self, PyObject *args) {
     Py_RETURN_NONE;
 }
 
+// A Python producer that requests it is notified once the write buffer
+// drains below this, so multi-MB writes can be streamed in instead of
+// being buffered whole
+#define WRITE_BUF_LOW_WATERMARK (64u * 1024u)
+
+static inline void
+resize_write_buf(Screen *screen, size_t new_sz) {
+    // resizing linearizes the ring, which must be done with the write lock held
+    uint8_t *new_buf = PyMem_RawMalloc(new_sz);
+    if (new_buf == NULL) fatal("Out of memory.");
+    size_t first = MIN(screen->write_buf_used, screen->write_buf_sz - screen->write_buf_start);
+    memcpy(new_buf, screen->write_buf + screen->write_buf_start, first);
+    if (first < screen->write_buf_used) memcpy(new_buf + first, screen->write_buf, screen->write_buf_used - first);
+    PyMem_RawFree(screen->write_buf);
+    screen->write_buf = new_buf; screen->write_buf_sz = new_sz; screen->write_buf_start = 0;
+}
+
 bool
 schedule_write_to_child(unsigned long id, unsigned int num, ...) {
     ChildMonitor *self = the_monitor;
@@ -256,22 +323,23 @@ schedule_write_to_child(unsigned long id, unsigned int num, ...) {
                     screen_mutex(unlock, write);
                     break;
                 }
-                screen->write_buf_sz = screen->write_buf_used + sz;
-                screen->write_buf = PyMem_RawRealloc(screen->write_buf, screen->write_buf_sz);
-                if (screen->write_buf == NULL) { fatal("Out of memory."); }
+                resize_write_buf(screen, screen->write_buf_used + sz);
             }
             va_start(ap, num);
             for (unsigned int i = 0; i < num; i++) {
                 data = va_arg(ap, const char*);
                 size_t dsz = va_arg(ap, size_t);
-                memcpy(screen->write_buf + screen->write_buf_used, data, dsz);
-                screen->write_buf_used += dsz;
+                while (dsz) {
+                    // append at the ring write position, wrapping as needed
+                    size_t wpos = (screen->write_buf_start + screen->write_buf_used) % screen->write_buf_sz;
+                    size_t limit = MIN(dsz, screen->write_buf_sz - wpos);
+                    memcpy(screen->write_buf + wpos, data, limit);
+                    data += limit; dsz -= limit; screen->write_buf_used += limit;
+                }
             }
             va_end(ap);
             if (screen->write_buf_sz > BUFSIZ && screen->write_buf_used < BUFSIZ) {
-                screen->write_buf_sz = BUFSIZ;
-                screen->write_buf = PyMem_RawRealloc(screen->write_buf, screen->write_buf_sz);
-                if (screen->write_buf == NULL) { fatal("Out of memory."); }
+                resize_write_buf(screen, BUFSIZ);
             }
             if (screen->write_buf_used) wakeup_io_loop(self, false);
             screen_mutex(unlock, write);
@@ -292,6 +360,30 @@ needs_write(ChildMonitor UNUSED *self, PyObject *args) {
     Py_RETURN_FALSE;
 }
 
+static PyObject *
+request_write_drain_notify(ChildMonitor *self, PyObject *args) {
+#define request_write_drain_notify_doc "request_write_drain_notify(id) -> Ask for Boss.on_child_write_drain() to be called once the write buffer for the specified child drains below the watermark. Returns True if a notification was scheduled, False if the buffer is already drained or the child does not exist."
+    unsigned long id;
+    bool scheduled = false;
+    if (!PyArg_ParseTuple(args, "k", &id)) return NULL;
+    children_mutex(lock);
+    for (size_t i = 0; i < self->count; i++) {
+        if (children[i].id == id) {
+            Screen *screen = children[i].screen;
+            screen_mutex(lock, write);
+            if (screen->write_buf_used >= WRITE_BUF_LOW_WATERMARK) {
+                screen->write_drain_notify.requested = true;
+                scheduled = true;
+            }
+            screen_mutex(unlock, write);
+            break;
+        }
+    }
+    children_mutex(unlock);
+    if (scheduled) { Py_RETURN_TRUE; }
+    Py_RETURN_FALSE;
+}
+
 static PyObject *
 shutdown_monitor(ChildMonitor *self, PyObject *a UNUSED) {
 #define shutdown_monitor_doc "shutdown_monitor() -> Shutdown the monitor loop."
@@ -317,9 +409,43 @@ do_parse(ChildMonitor *self, Screen *screen, monotonic_t now) {
         if (time_since_new_input >= OPT(input_delay)) {
             bool read_buf_full = screen->read_buf_sz >= READ_BUF_SZ;
             input_read = true;
-            parse_func(screen, self->dump_callback, now);
+            // optionally cap the parse quantum of unfocused windows, held
+            // back bytes stay in the ring and backpressure the pty once it
+            // fills, so a runaway background window cannot degrade input
+            // latency in the focused one
+            size_t max_sz = screen->read_buf_sz;
+            bool held_back = false;
+            if (OPT(unfocused_output_limit) && !screen->has_focus && screen->read_buf_sz > OPT(unfocused_output_limit)) {
+                // passed as a cap rather than by shrinking read_buf_sz, since
+                // the parser drops the read lock while parsing and the I/O
+                // thread would see the held back bytes as free space
+                max_sz = OPT(unfocused_output_limit);
+                held_back = true;
+            }
+            monotonic_t parse_started_at = monotonic();
+            if (self->dump_callback) {
+                // dump builds call into Python for every command, keep the GIL
+                parse_func(screen, self->dump_callback, now, max_sz);
+            } else {
+                // the parse hot path is pure C, the rare dispatches that need
+                // Python re-acquire the GIL for just their duration via
+                // PyGILState_Ensure()
+                Py_BEGIN_ALLOW_THREADS;
+                parse_func(screen, NULL, now, max_sz);
+                Py_END_ALLOW_THREADS;
+            }
+            perf_time_sample(&perf.parse_time, monotonic() - parse_started_at);
+            if (!perf.first_parse_at) perf.first_parse_at = monotonic();
+            // treat the first output parsed after a keystroke as its echo,
+            // the swap of the frame drawn from this damage completes the
+            // keypress-to-pixel measurement, see render_os_window()
+            if (screen->key_latency.pressed_at && !screen->key_latency.echoed) screen->key_latency.echoed = true;
             if (read_buf_full) wakeup_io_loop(self, false);  // Ensure the read fd has POLLIN set
             screen->new_input_at = 0;
+            // the parser ran out of its time budget, continue on the next
+            // tick, or after a full input delay when the leftover is due to
+            // the unfocused window limit, making the limit per tick
+            if (screen->read_buf_sz) set_maximum_wait(held_back ? OPT(input_delay) : 0);
             if (screen->pending_mode.activated_at) {
                 monotonic_t time_since_pending = MAX(0, now - screen->pending_mode.activated_at);
                 set_maximum_wait(screen->pending_mode.wait_time - time_since_pending);
@@ -334,8 +460,8 @@ static bool
 parse_input(ChildMonitor *self) {
     // Parse all available input that was read in the I/O thread.
     size_t count = 0, remove_count = 0;
-    bool input_read = false;
-    monotonic_t now = monotonic();
+    bool input_read = false, reload_config = false;
+    monotonic_t now = coarse_monotonic();
     children_mutex(lock);
     while (remove_queue_count) {
         remove_queue_count--;
@@ -356,7 +482,10 @@ parse_input(ChildMonitor *self) {
             INCREF_CHILD(scratch[i]);
         }
     }
+    if (UNLIKELY(reload_config_signal_received)) { reload_config = true; reload_config_signal_received = false; }
     children_mutex(unlock);
+    // no locks held, as the python code can call back into this module
+    if (UNLIKELY(reload_config)) call_boss(on_config_reload_signal, NULL);
 
     Message *msgs = NULL;
     size_t msgs_count = 0;
@@ -397,12 +526,27 @@ parse_input(ChildMonitor *self) {
         else Py_DECREF(t);
     }
 
+    unsigned long drain_notify[MAX_CHILDREN];
+    size_t drain_notify_count = 0;
     for (size_t i = 0; i < count; i++) {
         if (!scratch[i].needs_removal) {
             if (do_parse(self, scratch[i].screen, now)) input_read = true;
+            Screen *screen = scratch[i].screen;
+            screen_free_stale_alt_linebuf(screen, now);
+            screen_mutex(lock, write);
+            if (screen->write_drain_notify.pending) {
+                screen->write_drain_notify.pending = false;
+                drain_notify[drain_notify_count++] = scratch[i].id;
+            }
+            screen_mutex(unlock, write);
         }
         DECREF_CHILD(scratch[i]);
     }
+    while (drain_notify_count) {
+        // no locks held, as the python code can call back into this module
+        drain_notify_count--;
+        call_boss(on_child_write_drain, "k", drain_notify[drain_notify_count]);
+    }
     return input_read;
 }
 
@@ -491,7 +635,7 @@ pyset_iutf8(ChildMonitor *self, PyObject *args) {
     for (size_t i = 0; i < self->count; i++) {
         if (children[i].id == window_id) {
             found = Py_True;
-            if (!set_iutf8(fds[EXTRA_FDS + i].fd, on & 1)) PyErr_SetFromErrno(PyExc_OSError);
+            if (!set_iutf8(children[i].fd, on & 1)) PyErr_SetFromErrno(PyExc_OSError);
             break;
         }
     }
@@ -524,7 +668,7 @@ collect_cursor_info(CursorRenderInfo *ans, Window *w, monotonic_t now, OSWindow
         do_draw_cursor = n % 2 == 0 ? true : false;
         monotonic_t bucket = ms_to_monotonic_t((monotonic_t)(n + 1) * d);
         monotonic_t delay = bucket - time_since_start_blink;
-        set_maximum_wait(delay);
+        set_animation_wait(now, delay);
     }
     if (!do_draw_cursor) { ans->is_visible = false; return; }
     ans->is_visible = true;
@@ -545,17 +689,37 @@ change_menubar_title(PyObject *title UNUSED) {
 #endif
 }
 
+static inline void
+damage_whole_frame(OSWindow *os_window) { os_window->frame_damage.full = true; }
+
+// Record that the cell region of the given screen changed since the last
+// swap, so the compositor need only recomposite it instead of the whole
+// surface. Coordinates are converted from normalized device coordinates to
+// pixels with a pixel of slop on every side against rounding.
+static inline void
+damage_cell_region(OSWindow *os_window, const ScreenRenderData *rd) {
+    if (os_window->frame_damage.full || !rd->screen) return;
+    if (os_window->frame_damage.count >= arraysz(os_window->frame_damage.rects)) { damage_whole_frame(os_window); return; }
+    float vw = (float)os_window->viewport_width / 2.f, vh = (float)os_window->viewport_height / 2.f;
+    size_t i = os_window->frame_damage.count++;
+    os_window->frame_damage.rects[i].x = (int)((rd->xstart + 1.f) * vw) - 1;
+    os_window->frame_damage.rects[i].y = (int)((1.f - rd->ystart) * vh) - 1;
+    os_window->frame_damage.rects[i].width = (int)(rd->screen->columns * rd->dx * vw) + 2;
+    os_window->frame_damage.rects[i].height = (int)(rd->screen->lines * rd->dy * vh) + 2;
+}
+
 static inline bool
 prepare_to_render_os_window(OSWindow *os_window, monotonic_t now, unsigned int *active_window_id, color_type *active_window_bg, unsigned int *num_visible_windows, bool *all_windows_have_same_bg) {
 #define TD os_window->tab_bar_render_data
     bool needs_render = os_window->needs_render;
     os_window->needs_render = false;
+    if (needs_render) damage_whole_frame(os_window);
     if (TD.screen && os_window->num_tabs >= OPT(tab_bar_min_tabs)) {
         if (!os_window->tab_bar_data_updated) {
             call_boss(update_tab_bar_data, "K", os_window->id);
             os_window->tab_bar_data_updated = true;
         }
-        if (send_cell_data_to_gpu(TD.vao_idx, 0, TD.xstart, TD.ystart, TD.dx, TD.dy, TD.screen, os_window)) needs_render = true;
+        if (send_cell_data_to_gpu(TD.vao_idx, 0, TD.xstart, TD.ystart, TD.dx, TD.dy, TD.screen, os_window)) { needs_render = true; damage_cell_region(os_window, &TD); }
     }
     if (OPT(mouse_hide_wait) > 0 && !is_mouse_hidden(os_window)) {
         if (now - os_window->last_mouse_activity_at >= OPT(mouse_hide_wait)) hide_mouse(os_window);
@@ -580,6 +744,7 @@ prepare_to_render_os_window(OSWindow *os_window, monotonic_t now, unsigned int *
                         w->last_drag_scroll_at = now;
                         set_maximum_wait(ms_to_monotonic_t(20ll));
                         needs_render = true;
+                        damage_cell_region(os_window, &WD);
                     } else w->last_drag_scroll_at = 0;
                 } else set_maximum_wait(now - w->last_drag_scroll_at);
             }
@@ -587,12 +752,25 @@ prepare_to_render_os_window(OSWindow *os_window, monotonic_t now, unsigned int *
             if (is_active_window) {
                 *active_window_id = w->id;
                 collect_cursor_info(&WD.screen->cursor_render_info, w, now, os_window);
-                if (w->cursor_visible_at_last_render != WD.screen->cursor_render_info.is_visible || w->last_cursor_x != WD.screen->cursor_render_info.x || w->last_cursor_y != WD.screen->cursor_render_info.y || w->last_cursor_shape != WD.screen->cursor_render_info.shape) needs_render = true;
+                if (w->cursor_visible_at_last_render != WD.screen->cursor_render_info.is_visible || w->last_cursor_x != WD.screen->cursor_render_info.x || w->last_cursor_y != WD.screen->cursor_render_info.y || w->last_cursor_shape != WD.screen->cursor_render_info.shape) { needs_render = true; damage_cell_region(os_window, &WD); }
                 set_os_window_title_from_window(w, os_window);
                 *active_window_bg = window_bg;
             } else WD.screen->cursor_render_info.is_visible = false;
-            if (send_cell_data_to_gpu(WD.vao_idx, WD.gvao_idx, WD.xstart, WD.ystart, WD.dx, WD.dy, WD.screen, os_window)) needs_render = true;
-            if (WD.screen->start_visual_bell_at != 0) needs_render = true;
+            if (WD.screen->start_visual_bell_at != 0) { needs_render = true; damage_cell_region(os_window, &WD); }
+        }
+    }
+    // Prepare cell data for all visible windows first, so that the packing of
+    // cell data into the mapped GPU buffers can proceed for all of them in
+    // parallel on the worker pool, then send, consuming the prepared data.
+    for (unsigned int i = 0; i < tab->num_windows; i++) {
+        Window *w = tab->windows + i;
+        if (w->visible && WD.screen) start_cell_data_prep(WD.vao_idx, WD.gvao_idx, WD.xstart, WD.ystart, WD.dx, WD.dy, WD.screen, os_window);
+    }
+    finish_cell_data_prep();
+    for (unsigned int i = 0; i < tab->num_windows; i++) {
+        Window *w = tab->windows + i;
+        if (w->visible && WD.screen) {
+            if (send_cell_data_to_gpu(WD.vao_idx, WD.gvao_idx, WD.xstart, WD.ystart, WD.dx, WD.dy, WD.screen, os_window)) { needs_render = true; damage_cell_region(os_window, &WD); }
         }
     }
     return needs_render;
@@ -600,8 +778,22 @@ prepare_to_render_os_window(OSWindow *os_window, monotonic_t now, unsigned int *
 
 static inline void
 render_os_window(OSWindow *os_window, monotonic_t now, unsigned int active_window_id, color_type active_window_bg, unsigned int num_visible_windows, bool all_windows_have_same_bg) {
+    // Every window in the tab is drawn in full even when only one of them
+    // changed: with double/triple buffering the back buffer being rendered
+    // into holds the frame from two or more swaps ago, so restricting
+    // drawing to the damaged region (e.g. just the blinking cursor's
+    // window) would present stale pixels everywhere else. Doing better
+    // needs EGL_EXT_buffer_age/partial swap support from the windowing
+    // layer so that accumulated damage for the specific back buffer in use
+    // can be computed. Per line damage is still tracked and used on the
+    // upload side, only clean rows are skipped when refreshing cell data,
+    // and the regions that changed since the last swap are collected and
+    // reported to the compositor at swap time (see swap_window_buffers) so
+    // it can limit recompositing even though we redraw in full.
     // ensure all pixels are cleared to background color at least once in every buffer
-    if (os_window->clear_count++ < 3) blank_os_window(os_window);
+    perf.frames_rendered++;
+    TRACE_EVENT1(render_frame_start, os_window->id);
+    if (os_window->clear_count++ < 3) { blank_os_window(os_window); damage_whole_frame(os_window); }
     Tab *tab = os_window->tabs + os_window->active_tab;
     BorderRects *br = &tab->border_rects;
     bool static_live_resize_in_progress = os_window->live_resize.in_progress && OPT(resize_draw_strategy) == RESIZE_DRAW_STATIC;
@@ -611,6 +803,9 @@ render_os_window(OSWindow *os_window, monotonic_t now, unsigned int active_windo
         y_ratio = (float) os_window->viewport_height / (float) os_window->live_resize.height;
     }
     if (!static_live_resize_in_progress) {
+        commit_pending_border_rects(br);
+        // border rects can be anywhere in the frame
+        if (br->is_dirty) damage_whole_frame(os_window);
         draw_borders(br->vao_idx, br->num_border_rects, br->rect_buf, br->is_dirty, os_window->viewport_width, os_window->viewport_height, active_window_bg, num_visible_windows, all_windows_have_same_bg, os_window);
         br->is_dirty = false;
     }
@@ -622,16 +817,31 @@ render_os_window(OSWindow *os_window, monotonic_t now, unsigned int active_windo
             draw_cells(WD.vao_idx, WD.gvao_idx, WD.xstart, WD.ystart, WD.dx * x_ratio, WD.dy * y_ratio, WD.screen, os_window, is_active_window, true);
             if (WD.screen->start_visual_bell_at != 0) {
                 monotonic_t bell_left = OPT(visual_bell_duration) - (now - WD.screen->start_visual_bell_at);
-                set_maximum_wait(bell_left);
+                set_animation_wait(now, bell_left);
             }
             w->cursor_visible_at_last_render = WD.screen->cursor_render_info.is_visible; w->last_cursor_x = WD.screen->cursor_render_info.x; w->last_cursor_y = WD.screen->cursor_render_info.y; w->last_cursor_shape = WD.screen->cursor_render_info.shape;
         }
     }
+    // capture the finished frame so interim frames during a future live
+    // resize can be drawn by scaling it
+    if (OPT(resize_draw_strategy) == RESIZE_DRAW_SCALED && !os_window->live_resize.in_progress) snapshot_frame_for_resize(os_window);
     swap_window_buffers(os_window);
+    monotonic_t swapped_at = monotonic();
+    if (!perf.first_frame_at) perf.first_frame_at = swapped_at;
+    // keystrokes whose echo was parsed before this frame was drawn became
+    // visible pixels at the swap that just happened
+    for (unsigned int i = 0; i < tab->num_windows; i++) {
+        Window *w = tab->windows + i;
+        if (w->visible && WD.screen && WD.screen->key_latency.echoed) {
+            perf_time_sample(&perf.input_latency, swapped_at - WD.screen->key_latency.pressed_at);
+            WD.screen->key_latency.pressed_at = 0; WD.screen->key_latency.echoed = false;
+        }
+    }
     os_window->last_active_tab = os_window->active_tab; os_window->last_num_tabs = os_window->num_tabs; os_window->last_active_window_id = active_window_id;
     os_window->focused_at_last_render = os_window->is_focused;
     os_window->is_damaged = false;
     if (USE_RENDER_FRAMES) request_frame_render(os_window);
+    TRACE_EVENT1(render_frame_end, os_window->id);
 #undef WD
 #undef TD
 }
@@ -664,13 +874,6 @@ no_render_frame_received_recently(OSWindow *w, monotonic_t now, monotonic_t max_
 static inline void
 render(monotonic_t now, bool input_read) {
     EVDBG("input_read: %d", input_read);
-    static monotonic_t last_render_at = MONOTONIC_T_MIN;
-    monotonic_t time_since_last_render = last_render_at == MONOTONIC_T_MIN ? OPT(repaint_delay) : now - last_render_at;
-    if (!input_read && time_since_last_render < OPT(repaint_delay)) {
-        set_maximum_wait(OPT(repaint_delay) - time_since_last_render);
-        return;
-    }
-
     for (size_t i = 0; i < global_state.num_os_windows; i++) {
         OSWindow *w = global_state.os_windows + i;
         w->render_calls++;
@@ -680,11 +883,39 @@ render(monotonic_t now, bool input_read) {
             if (w->is_focused) change_menubar_title(w->window_title);
             continue;
         }
+        // when render frames are in use the compositor's frame callbacks
+        // already pace rendering at the refresh rate, a repaint delay timer
+        // on top of that only adds latency
+        if (!USE_RENDER_FRAMES && !input_read) {
+            // pace each window from the refresh rate of the monitor it is
+            // actually on, at half cadence when not focused, falling back to
+            // repaint_delay when the monitor is unknown
+            monotonic_t delay = w->refresh_period ? w->refresh_period : OPT(repaint_delay);
+            if (!w->is_focused) delay *= 2;
+            if (w->last_render_at && now - w->last_render_at < delay) {
+                set_maximum_wait(delay - (now - w->last_render_at));
+                continue;
+            }
+        }
         if (USE_RENDER_FRAMES && w->render_state != RENDER_FRAME_READY) {
             if (w->render_state == RENDER_FRAME_NOT_REQUESTED || no_render_frame_received_recently(w, now, ms_to_monotonic_t(250ll))) request_frame_render(w);
+            // the frame callback wakes the loop when the compositor is
+            // presenting, this wakeup only serves the re-request fallback
+            // above, for compositors that drop frame events
+            else set_maximum_wait(w->last_render_frame_received_at + ms_to_monotonic_t(250ll) - now);
             continue;
         }
         make_os_window_context_current(w);
+        if (w->live_resize.in_progress && OPT(resize_draw_strategy) == RESIZE_DRAW_SCALED && w->resize_snapshot_texture_id) {
+            // scale the last fully rendered frame to the new size instead of
+            // redrawing, the full render with rewrap happens once the drag
+            // settles, see process_pending_resizes()
+            damage_whole_frame(w);
+            draw_resize_snapshot(w);
+            swap_window_buffers(w);
+            if (USE_RENDER_FRAMES) request_frame_render(w);
+            continue;
+        }
         if (w->live_resize.in_progress && OPT(resize_draw_strategy) >= RESIZE_DRAW_BLANK) {
             blank_os_window(w);
             if (OPT(resize_draw_strategy) == RESIZE_DRAW_SIZE) draw_resizing_text(w);
@@ -694,23 +925,25 @@ render(monotonic_t now, bool input_read) {
         }
         if (w->live_resize.in_progress && OPT(resize_draw_strategy) == RESIZE_DRAW_STATIC) blank_os_window(w);
         bool needs_render = w->is_damaged || w->live_resize.in_progress;
+        if (needs_render) damage_whole_frame(w);
         if (w->viewport_size_dirty) {
             w->clear_count = 0;
             update_surface_size(w->viewport_width, w->viewport_height, w->offscreen_texture_id);
             w->viewport_size_dirty = false;
             needs_render = true;
+            damage_whole_frame(w);
         }
         unsigned int active_window_id = 0, num_visible_windows = 0;
         bool all_windows_have_same_bg;
         color_type active_window_bg = 0;
         if (!w->fonts_data) { log_error("No fonts data found for window id: %llu", w->id); continue; }
         if (prepare_to_render_os_window(w, now, &active_window_id, &active_window_bg, &num_visible_windows, &all_windows_have_same_bg)) needs_render = true;
-        if (w->last_active_window_id != active_window_id || w->last_active_tab != w->active_tab || w->focused_at_last_render != w->is_focused) needs_render = true;
-        if (w->render_calls < 3 && w->bgimage && w->bgimage->texture_id) needs_render = true;
+        if (w->last_active_window_id != active_window_id || w->last_active_tab != w->active_tab || w->focused_at_last_render != w->is_focused) { needs_render = true; damage_whole_frame(w); }
+        if (w->render_calls < 3 && w->bgimage && w->bgimage->texture_id) { needs_render = true; damage_whole_frame(w); }
         if (needs_render) render_os_window(w, now, active_window_id, active_window_bg, num_visible_windows, all_windows_have_same_bg);
+        w->last_render_at = now;
         if (w->is_focused) change_menubar_title(w->window_title);
     }
-    last_render_at = now;
 #undef TD
 }
 
@@ -809,6 +1042,7 @@ cm_thread_write(PyObject UNUSED *self, PyObject *args) {
 
 static void
 python_timer_callback(id_type timer_id, void *data) {
+    perf.timer_fires++;
     PyObject *callback = (PyObject*)data;
     unsigned long long id = timer_id;
     PyObject *ret = PyObject_CallFunction(callback, "K", id);
@@ -854,8 +1088,9 @@ process_pending_resizes(monotonic_t now) {
                 monotonic_t debounce_time = OPT(resize_debounce_time);
                 // if more than one resize event has occurred, wait at least 0.2 secs
                 // before repainting, to avoid rapid transitions between the cells banner
-                // and the normal screen
-                if (w->live_resize.num_of_resize_events > 1 && OPT(resize_draw_strategy) == RESIZE_DRAW_SIZE) debounce_time = MAX(ms_to_monotonic_t(200ll), debounce_time);
+                // and the normal screen, and to avoid repeated rewraps mid-drag when
+                // interim frames are drawn by scaling the last frame
+                if (w->live_resize.num_of_resize_events > 1 && (OPT(resize_draw_strategy) == RESIZE_DRAW_SIZE || OPT(resize_draw_strategy) == RESIZE_DRAW_SCALED)) debounce_time = MAX(ms_to_monotonic_t(200ll), debounce_time);
                 if (now - w->live_resize.last_resize_event_at >= debounce_time) update_viewport = true;
                 else {
                     global_state.has_pending_resizes = true;
@@ -941,10 +1176,25 @@ set_cocoa_pending_action(CocoaPendingAction action, const char *wd) {
 }
 #endif
 
+static void
+flush_pending_title_updates(void) {
+    // coalesced OSC title updates, at most one crosses into Python per tick
+    for (size_t o = 0; o < global_state.num_os_windows; o++) {
+        OSWindow *os_window = global_state.os_windows + o;
+        for (size_t t = 0; t < os_window->num_tabs; t++) {
+            Tab *tab = os_window->tabs + t;
+            for (size_t w = 0; w < tab->num_windows; w++) {
+                if (tab->windows[w].render_data.screen) screen_flush_pending_title(tab->windows[w].render_data.screen);
+            }
+        }
+    }
+}
+
 static void process_global_state(void *data);
 
 static void
 do_state_check(id_type timer_id UNUSED, void *data) {
+    perf.timer_fires++;
     EVDBG("State check timer fired");
     process_global_state(data);
 }
@@ -959,12 +1209,21 @@ process_global_state(void *data) {
     bool state_check_timer_enabled = false;
     bool input_read = false;
 
-    monotonic_t now = monotonic();
+    monotonic_t now = stamp_coarse_monotonic();
+    perf.ticks++;
+    monotonic_t wakeup_at = perf.last_main_wakeup_at;
+    if (wakeup_at) {
+        perf.last_main_wakeup_at = 0;
+        perf_time_sample(&perf.wakeup_latency, now - wakeup_at);
+    }
     if (global_state.has_pending_resizes) {
         process_pending_resizes(now);
         input_read = true;
     }
     if (parse_input(self)) input_read = true;
+    grman_process_decoded_images();
+    send_pending_mouse_motion_reports();
+    flush_pending_title_updates();
     render(now, input_read);
 #ifdef __APPLE__
         if (cocoa_pending_actions) {
@@ -1015,8 +1274,8 @@ add_children(ChildMonitor *self) {
         add_queue_count--;
         children[self->count] = add_queue[add_queue_count];
         add_queue[add_queue_count] = EMPTY_CHILD;
-        fds[EXTRA_FDS + self->count].fd = children[self->count].fd;
-        fds[EXTRA_FDS + self->count].events = POLLIN;
+        children[self->count].poll_events = POLLIN;
+        poller_add(&io_poller, children[self->count].fd, POLLIN);
         self->count++;
     }
 }
@@ -1048,15 +1307,14 @@ remove_children(ChildMonitor *self) {
         for (ssize_t i = self->count - 1; i >= 0; i--) {
             if (children[i].needs_removal) {
                 count++;
+                poller_remove(&io_poller, children[i].fd);
                 cleanup_child(i);
                 remove_queue[remove_queue_count] = children[i];
                 remove_queue_count++;
                 children[i] = EMPTY_CHILD;
-                fds[EXTRA_FDS + i].fd = -1;
                 size_t num_to_right = self->count - 1 - i;
                 if (num_to_right > 0) {
                     memmove(children + i, children + i + 1, num_to_right * sizeof(Child));
-                    memmove(fds + EXTRA_FDS + i, fds + EXTRA_FDS + i + 1, num_to_right * sizeof(struct pollfd));
                 }
             }
         }
@@ -1065,36 +1323,91 @@ remove_children(ChildMonitor *self) {
 }
 
 
+// Move bytes spilled into the spare buffer back into the ring. Must be called
+// with the read lock held. Returns true if the ring went from empty to
+// non-empty, i.e. the main loop needs a wakeup.
+static inline bool
+drain_spare_read_buf(Screen *screen) {
+    if (!screen->spare_read_buf_sz || screen->read_buf_sz >= READ_BUF_SZ) return false;
+    bool was_empty = screen->read_buf_sz == 0;
+    size_t copied = 0;
+    while (copied < screen->spare_read_buf_sz && screen->read_buf_sz < READ_BUF_SZ) {
+        size_t write_pos = (screen->read_buf_start + screen->read_buf_sz) % READ_BUF_SZ;
+        size_t chunk = MIN(screen->spare_read_buf_sz - copied, MIN(READ_BUF_SZ - screen->read_buf_sz, READ_BUF_SZ - write_pos));
+        memcpy(screen->read_buf + write_pos, screen->spare_read_buf + copied, chunk);
+        screen->read_buf_sz += chunk; copied += chunk;
+    }
+    screen->spare_read_buf_sz -= copied;
+    if (screen->spare_read_buf_sz) memmove(screen->spare_read_buf, screen->spare_read_buf + copied, screen->spare_read_buf_sz);
+    if (screen->new_input_at == 0) screen->new_input_at = coarse_monotonic();
+    return was_empty && copied > 0;
+}
+
 static bool
-read_bytes(int fd, Screen *screen) {
+read_bytes(int fd, Screen *screen, bool *needs_wakeup) {
     ssize_t len;
-    size_t available_buffer_space, orig_sz;
-
-    screen_mutex(lock, read);
-    orig_sz = screen->read_buf_sz;
-    if (orig_sz >= READ_BUF_SZ) { screen_mutex(unlock, read); return true; }  // screen read buffer is full
-    available_buffer_space = READ_BUF_SZ - orig_sz;
-    screen_mutex(unlock, read);
-
-    while(true) {
-        len = read(fd, screen->read_buf + orig_sz, available_buffer_space);
-        if (len < 0) {
-            if (errno == EINTR || errno == EAGAIN) continue;
-            if (errno != EIO) perror("Call to read() from child fd failed");
-            return false;
+    size_t available_buffer_space, ring_space;
+    // Batch multiple reads into one call so that a fast producer does not
+    // cost a full poll+wakeup cycle per PIPE_BUF of data, bounding the
+    // batching so a flood cannot delay a wakeup by more than half the input delay
+    monotonic_t batch_until = monotonic() + OPT(input_delay) / 2;
+    struct iovec iov[3];
+    int iovcnt;
+    *needs_wakeup = false;
+
+    do {
+        screen_mutex(lock, read);
+        drain_spare_read_buf(screen);
+        // The read buffer is a ring. The main thread only consumes from the
+        // head, which leaves the write position and free regions valid, so the
+        // lock can be dropped during the readv() and newly read bytes never
+        // need to be shifted. A single readv() fills both ring segments and
+        // then spills into the spare buffer, which only this thread touches,
+        // so a fast producer's pty stays drained while the parser is busy.
+        iovcnt = 0; available_buffer_space = 0;
+        ring_space = READ_BUF_SZ - screen->read_buf_sz;
+        if (ring_space) {
+            size_t write_pos = (screen->read_buf_start + screen->read_buf_sz) % READ_BUF_SZ;
+            size_t contiguous = MIN(ring_space, READ_BUF_SZ - write_pos);
+            iov[iovcnt].iov_base = screen->read_buf + write_pos; iov[iovcnt++].iov_len = contiguous;
+            if (ring_space > contiguous) { iov[iovcnt].iov_base = screen->read_buf; iov[iovcnt++].iov_len = ring_space - contiguous; }
+        } else if (!screen->spare_read_buf) {
+            screen->spare_read_buf = malloc(READ_BUF_SZ);
+            if (!screen->spare_read_buf) fatal("Out of memory.");
         }
-        break;
-    }
-    if (UNLIKELY(len == 0)) return false;
-
-    screen_mutex(lock, read);
-    if (screen->new_input_at == 0) screen->new_input_at = monotonic();
-    if (orig_sz != screen->read_buf_sz) {
-        // The other thread consumed some of the screen read buffer
-        memmove(screen->read_buf + screen->read_buf_sz, screen->read_buf + orig_sz, len);
-    }
-    screen->read_buf_sz += len;
-    screen_mutex(unlock, read);
+        if (screen->spare_read_buf && screen->spare_read_buf_sz < READ_BUF_SZ) {
+            iov[iovcnt].iov_base = screen->spare_read_buf + screen->spare_read_buf_sz;
+            iov[iovcnt++].iov_len = READ_BUF_SZ - screen->spare_read_buf_sz;
+        }
+        for (int n = 0; n < iovcnt; n++) available_buffer_space += iov[n].iov_len;
+        screen_mutex(unlock, read);
+        if (!available_buffer_space) break;  // both buffers are full
+
+        while(true) {
+            len = readv(fd, iov, iovcnt);
+            if (len < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN) { len = -1; break; }  // no more data for now, poll() will tell us when there is
+                if (errno != EIO) perror("Call to read() from child fd failed");
+                return false;
+            }
+            break;
+        }
+        if (len < 0) break;
+        if (UNLIKELY(len == 0)) return false;
+        perf.read_calls++; perf.bytes_read += len;
+        TRACE_EVENT2(read_bytes, screen->window_id, len);
+
+        screen_mutex(lock, read);
+        if (screen->new_input_at == 0) screen->new_input_at = coarse_monotonic();
+        size_t to_ring = MIN((size_t)len, ring_space);
+        // the main thread keeps re-scheduling itself as long as the buffer is
+        // non-empty, so only an empty -> non-empty transition needs a wakeup
+        if (screen->read_buf_sz == 0 && to_ring) *needs_wakeup = true;
+        screen->read_buf_sz += to_ring;
+        screen->spare_read_buf_sz += len - to_ring;
+        screen_mutex(unlock, read);
+    } while ((size_t)len == available_buffer_space && monotonic() < batch_until);
     return true;
 }
 
@@ -1112,7 +1425,7 @@ drain_fd(int fd) {
     }
 }
 
-typedef struct { bool kill_signal, child_died; } SignalSet;
+typedef struct { bool kill_signal, child_died, reload_config; } SignalSet;
 
 static void
 handle_signal(int signum, void *data) {
@@ -1125,6 +1438,9 @@ handle_signal(int signum, void *data) {
         case SIGCHLD:
             ss->child_died = true;
             break;
+        case SIGUSR1:
+            ss->reload_config = true;
+            break;
         default:
             break;
     }
@@ -1173,13 +1489,22 @@ reap_children(ChildMonitor *self, bool enable_close_on_child_death) {
     }
 }
 
-static inline void
+static inline bool
 write_to_child(int fd, Screen *screen) {
+    // returns true if the main loop needs to be woken to deliver a drain notification
     size_t written = 0;
     ssize_t ret = 0;
+    bool notify = false;
     screen_mutex(lock, write);
     while (written < screen->write_buf_used) {
-        ret = write(fd, screen->write_buf + written, screen->write_buf_used - written);
+        size_t pending = screen->write_buf_used - written;
+        size_t pos = (screen->write_buf_start + written) % screen->write_buf_sz;
+        size_t first = MIN(pending, screen->write_buf_sz - pos);
+        struct iovec iov[2] = {
+            {.iov_base = screen->write_buf + pos, .iov_len = first},
+            {.iov_base = screen->write_buf, .iov_len = pending - first},
+        };
+        ret = writev(fd, iov, iov[1].iov_len ? 2 : 1);
         if (ret > 0) { written += ret; }
         else if (ret == 0) {
             // could mean anything, ignore
@@ -1187,17 +1512,29 @@ write_to_child(int fd, Screen *screen) {
         } else {
             if (errno == EINTR) continue;
             if (errno == EWOULDBLOCK || errno == EAGAIN) break;
-            perror("Call to write() to child fd failed, discarding data.");
+            perror("Call to writev() to child fd failed, discarding data.");
             written = screen->write_buf_used;
         }
     }
     if (written) {
+        perf.bytes_written += written;
         screen->write_buf_used -= written;
-        if (screen->write_buf_used) {
-            memmove(screen->write_buf, screen->write_buf + written, screen->write_buf_used);
+        // consumption just advances the start of the ring, the remainder stays put
+        screen->write_buf_start = screen->write_buf_used ? (screen->write_buf_start + written) % screen->write_buf_sz : 0;
+        if (screen->write_drain_notify.requested && screen->write_buf_used < WRITE_BUF_LOW_WATERMARK) {
+            screen->write_drain_notify.requested = false;
+            screen->write_drain_notify.pending = true;
+            notify = true;
         }
     }
     screen_mutex(unlock, write);
+    return notify;
+}
+
+static inline ssize_t
+child_index_for_fd(ChildMonitor *self, int fd) {
+    for (size_t i = 0; i < self->count; i++) { if (children[i].fd == fd) return i; }
+    return -1;
 }
 
 static void*
@@ -1210,6 +1547,9 @@ io_loop(void *data) {
     Screen *screen;
     ChildMonitor *self = (ChildMonitor*)data;
     set_thread_name("KittyChildMon");
+    poller_init(&io_poller);
+    poller_add(&io_poller, self->io_loop_data.wakeup_read_fd, POLLIN);
+    poller_add(&io_poller, self->io_loop_data.signal_read_fd, POLLIN);
 
     while (LIKELY(!self->shutting_down)) {
         children_mutex(lock);
@@ -1217,35 +1557,53 @@ io_loop(void *data) {
         add_children(self);
         children_mutex(unlock);
         data_received = false;
-        for (i = 0; i < self->count + EXTRA_FDS; i++) fds[i].revents = 0;
         for (i = 0; i < self->count; i++) {
             screen = children[i].screen;
             /* printf("i:%lu id:%lu fd: %d read_buf_sz: %lu write_buf_used: %lu\n", i, children[i].id, children[i].fd, screen->read_buf_sz, screen->write_buf_used); */
             screen_mutex(lock, read); screen_mutex(lock, write);
-            fds[EXTRA_FDS + i].events = (screen->read_buf_sz < READ_BUF_SZ ? POLLIN : 0) | (screen->write_buf_used ? POLLOUT  : 0);
+            if (drain_spare_read_buf(screen)) data_received = true;
+            short events = ((screen->read_buf_sz < READ_BUF_SZ || screen->spare_read_buf_sz < READ_BUF_SZ) ? POLLIN : 0) | (screen->write_buf_used ? POLLOUT  : 0);
             screen_mutex(unlock, read); screen_mutex(unlock, write);
+            // registrations are persistent, only buffer state transitions
+            // need a kernel round trip
+            if (events != children[i].poll_events && poller_modify(&io_poller, children[i].fd, events)) children[i].poll_events = events;
         }
         if (has_pending_wakeups) {
             now = monotonic();
             monotonic_t time_delta = OPT(input_delay) - (now - last_main_loop_wakeup_at);
-            if (time_delta >= 0) ret = poll(fds, self->count + EXTRA_FDS, monotonic_t_to_ms(time_delta));
+            if (time_delta >= 0) ret = poller_wait(&io_poller, time_delta);
             else ret = 0;
         } else {
-            ret = poll(fds, self->count + EXTRA_FDS, -1);
+            ret = poller_wait(&io_poller, -1);
         }
+        perf.io_wakeups++;
+        stamp_coarse_monotonic();
         if (ret > 0) {
-            if (fds[0].revents && POLLIN) drain_fd(fds[0].fd); // wakeup
-            if (fds[1].revents && POLLIN) {
-                SignalSet ss = {0};
-                data_received = true;
-                read_signals(fds[1].fd, handle_signal, &ss);
-                if (ss.kill_signal) { children_mutex(lock); kill_signal_received = true; children_mutex(unlock); }
-                if (ss.child_died) reap_children(self, OPT(close_on_child_death));
-            }
-            for (i = 0; i < self->count; i++) {
-                if (fds[EXTRA_FDS + i].revents & (POLLIN | POLLHUP)) {
-                    data_received = true;
-                    has_more = read_bytes(fds[EXTRA_FDS + i].fd, children[i].screen);
+            for (size_t n = 0; n < io_poller.num_ready; n++) {
+                const struct pollfd *pfd = io_poller.ready + n;
+                if (pfd->fd == self->io_loop_data.wakeup_read_fd) {
+                    if (pfd->revents & POLLIN) drain_fd(pfd->fd); // wakeup
+                    continue;
+                }
+                if (pfd->fd == self->io_loop_data.signal_read_fd) {
+                    if (pfd->revents & POLLIN) {
+                        SignalSet ss = {0};
+                        data_received = true;
+                        read_signals(pfd->fd, handle_signal, &ss);
+                        if (ss.kill_signal) { children_mutex(lock); kill_signal_received = true; children_mutex(unlock); }
+                        if (ss.reload_config) { children_mutex(lock); reload_config_signal_received = true; children_mutex(unlock); }
+                        if (ss.child_died) reap_children(self, OPT(close_on_child_death));
+                    }
+                    continue;
+                }
+                ssize_t idx = child_index_for_fd(self, pfd->fd);
+                if (idx < 0) continue;  // the child was already removed
+                i = idx;
+                if (pfd->revents & (POLLIN | POLLHUP)) {
+                    bool needs_wakeup;
+                    has_more = read_bytes(children[i].fd, children[i].screen, &needs_wakeup);
+                    // a dead child must wake the main loop so it gets removed
+                    if (needs_wakeup || !has_more) data_received = true;
                     if (!has_more) {
                         // child is dead
                         children_mutex(lock);
@@ -1253,30 +1611,28 @@ io_loop(void *data) {
                         children_mutex(unlock);
                     }
                 }
-                if (fds[EXTRA_FDS + i].revents & POLLOUT) {
-                    write_to_child(children[i].fd, children[i].screen);
+                if (pfd->revents & POLLOUT) {
+                    if (write_to_child(children[i].fd, children[i].screen)) data_received = true;
                 }
-                if (fds[EXTRA_FDS + i].revents & POLLNVAL) {
+                if (pfd->revents & POLLNVAL) {
                     // fd was closed
                     children_mutex(lock);
                     children[i].needs_removal = true;
                     children_mutex(unlock);
                     log_error("The child %lu had its fd unexpectedly closed", children[i].id);
                 }
-            }
 #ifdef DEBUG_POLL_EVENTS
-            for (i = 0; i < self->count + EXTRA_FDS; i++) {
-#define P(w) if (fds[i].revents & w) printf("i:%lu %s\n", i, #w);
+#define P(w) if (pfd->revents & w) printf("fd:%d %s\n", pfd->fd, #w);
                 P(POLLIN); P(POLLPRI); P(POLLOUT); P(POLLERR); P(POLLHUP); P(POLLNVAL);
 #undef P
-            }
 #endif
+            }
         } else if (ret < 0) {
             if (errno != EAGAIN && errno != EINTR) {
                 perror("Call to poll() failed");
             }
         }
-#define WAKEUP { wakeup_main_loop(); last_main_loop_wakeup_at = now; has_pending_wakeups = false; }
+#define WAKEUP { wakeup_main_loop(); last_main_loop_wakeup_at = now; has_pending_wakeups = false; if (!perf.last_main_wakeup_at) perf.last_main_wakeup_at = now; }
         // we only wakeup the main loop after input_delay as wakeup is an expensive operation
         // on some platforms, such as cocoa
         if (data_received) {
@@ -1291,6 +1647,7 @@ io_loop(void *data) {
     for (i = 0; i < self->count; i++) children[i].needs_removal = true;
     remove_children(self);
     children_mutex(unlock);
+    poller_free(&io_poller);
     return 0;
 }
 // }}}
@@ -1355,9 +1712,17 @@ free_peer(Peer *peer) {
 }
 
 #define KITTY_CMD_PREFIX "\x1bP@kitty-cmd{"
+// A length prefixed binary frame: 0x00 followed by a 32-bit little endian
+// payload size. Unlike the escape code format, frames need no terminator
+// scan and clients can batch many commands over a single connection,
+// reading one response frame per command.
+#define FRAME_PREFIX_BYTE 0
+#define FRAME_HEADER_SZ 5
+#define MAX_PEER_MESSAGE_SZ (64u * 1024u)
 
 static inline void
 queue_peer_message(ChildMonitor *self, Peer *peer) {
+    perf.peer_messages++;
     talk_mutex(lock);
     ensure_space_for(self, messages, Message, self->messages_count + 16, messages_capacity, 16, true);
     Message *m = self->messages + self->messages_count++;
@@ -1378,7 +1743,16 @@ queue_peer_message(ChildMonitor *self, Peer *peer) {
 static inline bool
 has_complete_peer_command(Peer *peer) {
     peer->read.command_end = 0;
-    if (peer->read.used > sizeof(KITTY_CMD_PREFIX) && memcmp(peer->read.data, KITTY_CMD_PREFIX, sizeof(KITTY_CMD_PREFIX)-1) == 0) {
+    if (peer->read.used && (uint8_t)peer->read.data[0] == FRAME_PREFIX_BYTE) {
+        if (peer->read.used >= FRAME_HEADER_SZ) {
+            const uint8_t *d = (const uint8_t*)peer->read.data;
+            uint32_t payload_sz = d[1] | (d[2] << 8) | (d[3] << 16) | ((uint32_t)d[4] << 24);
+            // an oversize frame can never complete, the read buffer cap
+            // kills the peer when it fills up
+            if (payload_sz <= MAX_PEER_MESSAGE_SZ - FRAME_HEADER_SZ && peer->read.used >= FRAME_HEADER_SZ + (size_t)payload_sz)
+                peer->read.command_end = FRAME_HEADER_SZ + payload_sz;
+        }
+    } else if (peer->read.used > sizeof(KITTY_CMD_PREFIX) && memcmp(peer->read.data, KITTY_CMD_PREFIX, sizeof(KITTY_CMD_PREFIX)-1) == 0) {
         for (size_t i = sizeof(KITTY_CMD_PREFIX)-1; i < peer->read.used - 1; i++) {
             if (peer->read.data[i] == 0x1b && peer->read.data[i+1] == '\\') {
                 peer->read.command_end = i + 2;
@@ -1409,7 +1783,7 @@ static inline void
 read_from_peer(ChildMonitor *self, Peer *peer) {
 #define failed(msg) { log_error("Reading from peer failed: %s", msg); shutdown(peer->fd, SHUT_RD); peer->read.finished = true; return; }
     if (peer->read.used >= peer->read.capacity) {
-        if (peer->read.capacity >= 64 * 1024) failed("Ignoring too large message from peer");
+        if (peer->read.capacity >= MAX_PEER_MESSAGE_SZ) failed("Ignoring too large message from peer");
         peer->read.capacity = MAX(8192u, peer->read.capacity * 2);
         peer->read.data = realloc(peer->read.data, peer->read.capacity);
         if (!peer->read.data) failed("Out of memory");
@@ -1425,6 +1799,7 @@ read_from_peer(ChildMonitor *self, Peer *peer) {
     } else if (n < 0) {
         if (errno != EINTR) failed(strerror(errno));
     } else {
+        perf.peer_bytes_read += n;
         peer->read.used += n;
         while (has_complete_peer_command(peer)) dispatch_peer_command(self, peer);
     }
@@ -1439,6 +1814,7 @@ write_to_peer(Peer *peer) {
     else if (n < 0) {
         if (errno != EINTR) { log_error("write() to peer socket failed with error: %s", strerror(errno)); peer->write.used = 0; peer->write.failed = true; }
     } else {
+        perf.peer_bytes_written += n;
         if ((size_t)n > peer->write.used) memmove(peer->write.data, peer->write.data + n, peer->write.used - n);
         peer->write.used -= n;
     }
@@ -1499,6 +1875,7 @@ talk_loop(void *data) {
         }
         for (size_t i = 0; i < num_listen_fds; i++) fds[i].revents = 0;
         int ret = poll(fds, num_listen_fds + num_peer_fds, -1);
+        perf.talk_wakeups++;
         if (ret > 0) {
             for (size_t i = 0; i < num_listen_fds - 1; i++) {
                 if (fds[i].revents & POLLIN) {
@@ -1559,6 +1936,7 @@ send_response(id_type peer_id, const char *msg, size_t msg_sz) {
 static PyMethodDef methods[] = {
     METHOD(add_child, METH_VARARGS)
     METHOD(needs_write, METH_VARARGS)
+    METHOD(request_write_drain_notify, METH_VARARGS)
     METHOD(start, METH_NOARGS)
     METHOD(wakeup, METH_NOARGS)
     METHOD(shutdown_monitor, METH_NOARGS)
@@ -1592,6 +1970,57 @@ safe_pipe(PyObject *self UNUSED, PyObject *args) {
     return Py_BuildValue("ii", fds[0], fds[1]);
 }
 
+static PyObject*
+time_dist_as_dict(const PerfTimeDist *d) {
+    PyObject *hist = PyList_New(arraysz(d->hist));
+    if (!hist) return NULL;
+    for (size_t i = 0; i < arraysz(d->hist); i++) {
+        PyObject *v = PyLong_FromUnsignedLongLong(d->hist[i]);
+        if (!v) { Py_DECREF(hist); return NULL; }
+        PyList_SET_ITEM(hist, i, v);
+    }
+    PyObject *ans = Py_BuildValue("{sK sK sK sN}",
+        "sum_ns", (unsigned long long)d->sum_ns, "max_ns", (unsigned long long)d->max_ns,
+        "count", (unsigned long long)d->count, "hist_log2_us", hist);
+    if (!ans) Py_DECREF(hist);
+    return ans;
+}
+
+static PyObject*
+perf_counters(PyObject *self UNUSED, PyObject *args UNUSED) {
+    // counters are read without synchronization, a snapshot taken while the
+    // other threads are running may be slightly torn, see the perf struct
+    PyObject *parse_time = time_dist_as_dict(&perf.parse_time);
+    if (!parse_time) return NULL;
+    PyObject *wakeup_latency = time_dist_as_dict(&perf.wakeup_latency);
+    if (!wakeup_latency) { Py_DECREF(parse_time); return NULL; }
+    PyObject *input_latency = time_dist_as_dict(&perf.input_latency);
+    if (!input_latency) { Py_DECREF(parse_time); Py_DECREF(wakeup_latency); return NULL; }
+    PyObject *ans = Py_BuildValue(
+        "{s{sK sK sK sK} s{sK sK sK sK} s{sK sK sK sK sK sN sN sN}}",
+        "io",
+            "wakeups", (unsigned long long)perf.io_wakeups,
+            "read_calls", (unsigned long long)perf.read_calls,
+            "bytes_read", (unsigned long long)perf.bytes_read,
+            "bytes_written", (unsigned long long)perf.bytes_written,
+        "talk",
+            "wakeups", (unsigned long long)perf.talk_wakeups,
+            "peer_messages", (unsigned long long)perf.peer_messages,
+            "peer_bytes_read", (unsigned long long)perf.peer_bytes_read,
+            "peer_bytes_written", (unsigned long long)perf.peer_bytes_written,
+        "main",
+            "ticks", (unsigned long long)perf.ticks,
+            "frames_rendered", (unsigned long long)perf.frames_rendered,
+            "timer_fires", (unsigned long long)perf.timer_fires,
+            "first_parse_at_ns", (unsigned long long)perf.first_parse_at,
+            "first_frame_at_ns", (unsigned long long)perf.first_frame_at,
+            "parse_time", parse_time,
+            "wakeup_latency", wakeup_latency,
+            "input_latency", input_latency);
+    if (!ans) { Py_DECREF(parse_time); Py_DECREF(wakeup_latency); Py_DECREF(input_latency); }
+    return ans;
+}
+
 static PyObject*
 cocoa_set_menubar_title(PyObject *self UNUSED, PyObject *args UNUSED) {
 #ifdef __APPLE__
@@ -1607,6 +2036,7 @@ static PyMethodDef module_methods[] = {
     {"add_timer", (PyCFunction)add_python_timer, METH_VARARGS, ""},
     {"remove_timer", (PyCFunction)remove_python_timer, METH_VARARGS, ""},
     METHODB(monitor_pid, METH_VARARGS),
+    METHODB(perf_counters, METH_NOARGS),
     METHODB(cocoa_set_menubar_title, METH_VARARGS),
     {NULL}  /* Sentinel */
 };
@@ -5,6 +5,9 @@
  * Distributed under terms of the GPL3 license.
  */
 
+// Need _GNU_SOURCE for posix_spawn extensions (POSIX_SPAWN_SETSID,
+// posix_spawn_file_actions_addchdir_np)
+#define _GNU_SOURCE
 #include "data-types.h"
 #include <unistd.h>
 #include <sys/stat.h>
@@ -14,6 +17,11 @@
 #include <signal.h>
 #include <sys/ioctl.h>
 #include <termios.h>
+#include <stdio.h>
+#if defined(__linux__) && defined(__GLIBC__) && defined(__GLIBC_PREREQ) && __GLIBC_PREREQ(2, 29)
+#define HAS_POSIX_SPAWN_LAUNCH 1
+#include <spawn.h>
+#endif
 
 static inline char**
 serialize_string_tuple(PyObject *src) {
@@ -67,6 +75,82 @@ wait_for_terminal_ready(int fd) {
     }
 }
 
+#ifdef HAS_POSIX_SPAWN_LAUNCH
+// Launch the child with posix_spawn(), which glibc implements with
+// clone(CLONE_VM|CLONE_VFORK) and therefore without copying the parent's
+// page tables. A loaded instance with deep scrollback and many images can
+// sit at multi-GB RSS, where plain fork() makes opening a new window
+// noticeably slower than on a fresh instance. The fd/pty setup is expressed
+// as spawn file actions. The terminal-ready handshake has to block before
+// the command runs and cannot be a file action (glibc suspends the caller
+// until the spawned process execs, so the child may not wait on the parent
+// pre-exec), so a tiny /bin/sh trampoline waits for the ready pipe to close
+// and then execs the real command, leaving the final process tree identical
+// to the fork() path. Returns -1 on setup failure, in which case the caller
+// falls back to fork().
+static pid_t
+posix_spawn_child(const char *cwd, char **argv, char **env, int master, int slave, int stdin_read_fd, int stdin_write_fd, int ready_read_fd, const char *tty_name) {
+    pid_t pid = -1;
+    int err;
+    posix_spawn_file_actions_t fa;
+    posix_spawnattr_t attr;
+    if ((err = posix_spawn_file_actions_init(&fa)) != 0) { errno = err; return -1; }
+    if ((err = posix_spawnattr_init(&attr)) != 0) { posix_spawn_file_actions_destroy(&fa); errno = err; return -1; }
+    sigset_t all_signals, no_signals;
+    sigfillset(&all_signals); sigemptyset(&no_signals);
+#define A(x) if (err == 0) err = (x)
+    // reset all signal dispositions and the signal mask, the fork() path
+    // only resets the handful kitty changes but default-everything is what
+    // a freshly launched program expects
+    A(posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK));
+    A(posix_spawnattr_setsigdefault(&attr, &all_signals));
+    A(posix_spawnattr_setsigmask(&attr, &no_signals));
+    A(posix_spawn_file_actions_addchdir_np(&fa, cwd));
+    // opening the tty by name rather than dup()ing the slave makes it the
+    // controlling terminal, as the child is a session leader and this is
+    // its first terminal
+    A(posix_spawn_file_actions_addopen(&fa, 1, tty_name, O_RDWR, 0));
+    A(posix_spawn_file_actions_adddup2(&fa, 1, 2));
+    if (stdin_read_fd > -1) { A(posix_spawn_file_actions_adddup2(&fa, stdin_read_fd, 0)); }
+    else { A(posix_spawn_file_actions_adddup2(&fa, 1, 0)); }
+    A(posix_spawn_file_actions_addclose(&fa, slave));
+    A(posix_spawn_file_actions_addclose(&fa, master));
+    if (stdin_read_fd > -1) {
+        A(posix_spawn_file_actions_addclose(&fa, stdin_read_fd));
+        A(posix_spawn_file_actions_addclose(&fa, stdin_write_fd));
+    }
+    A(posix_spawn_file_actions_adddup2(&fa, ready_read_fd, 3));
+#if __GLIBC_PREREQ(2, 34)
+    // close any extra inherited fds; on older glibc the remaining fds are
+    // all close-on-exec anyway, the mass close is belt-and-braces
+    A(posix_spawn_file_actions_addclosefrom_np(&fa, 4));
+#endif
+    if (err == 0) {
+        size_t argc = 0;
+        while (argv[argc]) argc++;
+        char **targv = calloc(argc + 5, sizeof(char*));
+        if (!targv) { err = ENOMEM; }
+        else {
+            size_t i = 0;
+            targv[i++] = "sh";
+            targv[i++] = "-c";
+            // wait for kitty to signal that the screen is set up and the pty
+            // has its size, then replace the trampoline with the command
+            targv[i++] = "read -r kitty_terminal_ready <&3; exec 3<&-; exec \"$@\"";
+            targv[i++] = "sh";
+            for (size_t a = 0; argv[a]; a++) targv[i++] = argv[a];
+            err = posix_spawn(&pid, "/bin/sh", &fa, &attr, targv, env);
+            free(targv);
+        }
+    }
+#undef A
+    posix_spawn_file_actions_destroy(&fa);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) { errno = err; return -1; }
+    return pid;
+}
+#endif
+
 static PyObject*
 spawn(PyObject *self UNUSED, PyObject *args) {
     PyObject *argv_p, *env_p;
@@ -78,6 +162,19 @@ spawn(PyObject *self UNUSED, PyObject *args) {
     char **argv = serialize_string_tuple(argv_p);
     char **env = serialize_string_tuple(env_p);
 
+#ifdef HAS_POSIX_SPAWN_LAUNCH
+    // the trampoline execs argv directly, so it is only usable when argv[0]
+    // is the executable itself; it always is on Linux, the login shell
+    // hyphen trick for argv[0] is macOS only
+    if (strcmp(exe, argv[0]) == 0) {
+        pid_t spid = posix_spawn_child(cwd, argv, env, master, slave, stdin_read_fd, stdin_write_fd, ready_read_fd, name);
+        if (spid > 0) {
+            free_string_tuple(argv); free_string_tuple(env);
+            return PyLong_FromLong(spid);
+        }
+        // setting up the spawn failed, fall back to fork()
+    }
+#endif
     pid_t pid = fork();
     switch(pid) {
         case 0: {
@@ -7,8 +7,10 @@ import os
 import sys
 from collections import defaultdict
 from contextlib import contextmanager, suppress
+from time import monotonic
 from typing import (
-    DefaultDict, Dict, Generator, List, Optional, Sequence, Tuple
+    TYPE_CHECKING, Any, Callable, DefaultDict, Dict, Generator, List,
+    Optional, Sequence, Tuple
 )
 
 import kitty.fast_data_types as fast_data_types
@@ -21,6 +23,9 @@ try:
 except ImportError:
     TypedDict = dict
 
+if TYPE_CHECKING:
+    from kittens.host import KittenHost
+
 
 if is_macos:
     from kitty.fast_data_types import (
@@ -81,13 +86,34 @@ def checked_terminfo_dir() -> Optional[str]:
     return ans
 
 
+# Process info (cwd/cmdline) is read from /proc (proc_pidinfo on macOS),
+# which with hundreds of windows shows up as a storm of stat calls in system
+# CPU time, since tab titles and close confirmation query it on every
+# render. The answers are cached and invalidated on the events we can
+# observe: the pty's foreground process group changing (one cheap ioctl to
+# check) and the child dying (its Child object is discarded). A short TTL
+# backstops the unobservable cases, such as the foreground shell
+# chdir()ing, which no event reports.
+PROCESS_INFO_TTL = 2.0  # seconds
+
+
+def invalidate_process_group_map() -> None:
+    with suppress(AttributeError):
+        delattr(process_group_map, 'ttl_map')
+
+
 def processes_in_group(grp: int) -> List[int]:
     gmap: Optional[DefaultDict[int, List[int]]] = getattr(process_group_map, 'cached_map', None)
     if gmap is None:
-        try:
-            gmap = process_group_map()
-        except Exception:
-            gmap = defaultdict(list)
+        q = getattr(process_group_map, 'ttl_map', None)
+        if q is not None and monotonic() - q[0] <= PROCESS_INFO_TTL:
+            gmap = q[1]
+        else:
+            try:
+                gmap = process_group_map()
+            except Exception:
+                gmap = defaultdict(list)
+            setattr(process_group_map, 'ttl_map', (monotonic(), gmap))
     return gmap.get(grp, [])
 
 
@@ -278,6 +304,20 @@ class Child:
         os.close(self.terminal_ready_fd)
         self.terminal_ready_fd = -1
 
+    def invalidate_process_info_cache(self) -> None:
+        self._process_info_cache: Dict[Tuple[str, int], Any] = {}
+        self._process_info_cache_at = monotonic()
+
+    def _process_info(self, key: str, pid: int, getter: Callable[[int], Any]) -> Any:
+        cache = getattr(self, '_process_info_cache', None)
+        if cache is None or monotonic() - self._process_info_cache_at > PROCESS_INFO_TTL:
+            self.invalidate_process_info_cache()
+            cache = self._process_info_cache
+        k = (key, pid)
+        if k not in cache:
+            cache[k] = getter(pid)
+        return cache[k]
+
     @property
     def foreground_processes(self) -> List[ProcessDesc]:
         if self.child_fd is None:
@@ -289,9 +329,9 @@ class Child:
             def process_desc(pid: int) -> ProcessDesc:
                 ans: ProcessDesc = {'pid': pid, 'cmdline': None, 'cwd': None}
                 with suppress(Exception):
-                    ans['cmdline'] = cmdline_of_process(pid)
+                    ans['cmdline'] = self._process_info('cmdline', pid, cmdline_of_process)
                 with suppress(Exception):
-                    ans['cwd'] = cwd_of_process(pid) or None
+                    ans['cwd'] = self._process_info('cwd', pid, cwd_of_process) or None
                 return ans
 
             return [process_desc(x) for x in foreground_processes]
@@ -302,7 +342,7 @@ class Child:
     def cmdline(self) -> List[str]:
         try:
             assert self.pid is not None
-            return cmdline_of_process(self.pid) or list(self.argv)
+            return self._process_info('cmdline', self.pid, cmdline_of_process) or list(self.argv)
         except Exception:
             return list(self.argv)
 
@@ -310,7 +350,7 @@ class Child:
     def foreground_cmdline(self) -> List[str]:
         try:
             assert self.pid_for_cwd is not None
-            return cmdline_of_process(self.pid_for_cwd) or self.cmdline
+            return self._process_info('cmdline', self.pid_for_cwd, cmdline_of_process) or self.cmdline
         except Exception:
             return self.cmdline
 
@@ -326,13 +366,19 @@ class Child:
     def current_cwd(self) -> Optional[str]:
         with suppress(Exception):
             assert self.pid is not None
-            return cwd_of_process(self.pid)
+            return self._process_info('cwd', self.pid, cwd_of_process)
 
     @property
     def pid_for_cwd(self) -> Optional[int]:
         with suppress(Exception):
             assert self.child_fd is not None
             pgrp = os.tcgetpgrp(self.child_fd)
+            if pgrp != getattr(self, '_last_foreground_pgrp', None):
+                # pty state transition: a new process group took over the
+                # terminal, whatever was known about the old one is stale
+                self._last_foreground_pgrp = pgrp
+                self.invalidate_process_info_cache()
+                invalidate_process_group_map()
             foreground_processes = processes_in_group(pgrp) if pgrp >= 0 else []
             if len(foreground_processes) == 1:
                 return foreground_processes[0]
@@ -342,7 +388,7 @@ class Child:
     def foreground_cwd(self) -> Optional[str]:
         with suppress(Exception):
             assert self.pid_for_cwd is not None
-            return cwd_of_process(self.pid_for_cwd) or None
+            return self._process_info('cwd', self.pid_for_cwd, cwd_of_process) or None
 
     @property
     def foreground_environ(self) -> Dict[str, str]:
@@ -356,3 +402,54 @@ class Child:
             except Exception:
                 pass
         return {}
+
+
+class KittenChild(Child):
+    '''A child process forked from the resident kitten host process instead of
+    being spawned, avoiding interpreter startup and import costs. The pty is
+    still created here and its master end handled exactly as for ordinary
+    children, only the slave end is shipped to the host process, so the rest
+    of kitty cannot tell the difference.'''
+
+    def fork(self) -> Optional[int]:
+        if self.forked:
+            return None
+        from kittens.host import kitten_host
+        host = kitten_host()
+        if host is not None:
+            try:
+                return self.hosted_fork(host)
+            except Exception as err:
+                print('Failed to run kitten in host process with error:', err, file=sys.stderr)
+        return super().fork()
+
+    def hosted_fork(self, host: 'KittenHost') -> Optional[int]:
+        master, slave = openpty()
+        stdin = self.stdin
+        ready_read_fd, ready_write_fd = os.pipe()
+        if stdin is not None:
+            stdin_read_fd, stdin_write_fd = os.pipe()
+        else:
+            stdin_read_fd = stdin_write_fd = -1
+        try:
+            # the +runpy bootstrap from the argv is not needed in the host,
+            # only the arguments meant for kittens/runner.py
+            pid = host.launch(list(self.argv[3:]), self.final_env, self.cwd, slave, ready_read_fd, stdin_read_fd)
+        except Exception:
+            for fd in (master, slave, ready_read_fd, ready_write_fd, stdin_read_fd, stdin_write_fd):
+                if fd > -1:
+                    with suppress(OSError):
+                        os.close(fd)
+            raise
+        self.forked = True
+        self.stdin = None
+        os.close(slave)
+        os.close(ready_read_fd)
+        self.pid = pid
+        self.child_fd = master
+        if stdin is not None:
+            os.close(stdin_read_fd)
+            fast_data_types.thread_write(stdin_write_fd, stdin)
+        self.terminal_ready_fd = ready_write_fd
+        remove_blocking(self.child_fd)
+        return pid
@@ -704,6 +704,12 @@ type=bool-set
 Print out information about the system and kitty configuration.
 
 
+--profile-startup
+Profile startup: write a machine readable trace of startup phase timings, in
+the Chrome trace event JSON format, to the specified path when kitty exits.
+Use :code:`-` to print the trace to :file:`stderr` instead.
+
+
 --execute -e
 type=bool-set
 !
@@ -834,7 +840,7 @@ def compare_opts(opts: OptionsStub) -> None:
 
 
 def create_opts(args: CLIOptions, debug_config: bool = False, accumulate_bad_lines: Optional[List[BadLineType]] = None) -> OptionsStub:
-    from .config import load_config
+    from .config import load_config, load_config_cached
     config = tuple(resolve_config(SYSTEM_CONF, defconf, args.config))
     if debug_config:
         print(version(add_rev=True))
@@ -852,7 +858,10 @@ def create_opts(args: CLIOptions, debug_config: bool = False, accumulate_bad_lin
         if config:
             print(green('Loaded config files:'), ', '.join(config))
     overrides = (a.replace('=', ' ', 1) for a in args.override or ())
-    opts = load_config(*config, overrides=overrides, accumulate_bad_lines=accumulate_bad_lines)
+    # when debugging the full parse is wanted, so the printed diagnostics
+    # reflect what the parser actually does
+    loader = load_config if debug_config else load_config_cached
+    opts = loader(*config, overrides=overrides, accumulate_bad_lines=accumulate_bad_lines)
     if debug_config:
         if not is_macos:
             print('Running under:', green('Wayland' if is_wayland(opts) else 'X11'))
@@ -13,7 +13,7 @@ class CLIOptions:
 LaunchCLIOptions = AskCLIOptions = ClipboardCLIOptions = DiffCLIOptions = CLIOptions
 HintsCLIOptions = IcatCLIOptions = PanelCLIOptions = ResizeCLIOptions = CLIOptions
 ErrorCLIOptions = UnicodeCLIOptions = RCOptions = RemoteFileCLIOptions = CLIOptions
-QueryTerminalCLIOptions = BroadcastCLIOptions = CLIOptions
+QueryTerminalCLIOptions = BroadcastCLIOptions = BenchGraphicsCLIOptions = CLIOptions
 
 
 def generate_stub() -> None:
@@ -57,6 +57,9 @@ def generate_stub() -> None:
     from kittens.query_terminal.main import options_spec
     do(options_spec(), 'QueryTerminalCLIOptions')
 
+    from kittens.bench_graphics.main import options_spec
+    do(options_spec(), 'BenchGraphicsCLIOptions')
+
     from kittens.panel.main import OPTIONS
     do(OPTIONS(), 'PanelCLIOptions')
 
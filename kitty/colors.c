@@ -72,7 +72,7 @@ new(PyTypeObject *type, PyObject UNUSED *args, PyObject UNUSED *kwds) {
 #define S(which) self->mark_foregrounds[which] = OPT(mark##which##_foreground); self->mark_backgrounds[which] = OPT(mark##which##_background)
         S(1); S(2); S(3);
 #undef S
-        self->dirty = true;
+        self->generation++;
     }
     return (PyObject*) self;
 }
@@ -98,7 +98,7 @@ update_ansi_color_table(ColorProfile *self, PyObject *val) {
         self->color_table[i] = PyLong_AsUnsignedLong(PyList_GET_ITEM(val, i));
         self->orig_color_table[i] = self->color_table[i];
     }
-    self->dirty = true;
+    self->generation++;
     Py_RETURN_NONE;
 }
 
@@ -108,7 +108,7 @@ copy_color_profile(ColorProfile *dest, ColorProfile *src) {
     memcpy(dest->orig_color_table, src->orig_color_table, sizeof(dest->color_table));
     memcpy(&dest->configured, &src->configured, sizeof(dest->configured));
     memcpy(&dest->overridden, &src->overridden, sizeof(dest->overridden));
-    dest->dirty = true;
+    dest->generation++;
 }
 
 static inline void
@@ -118,9 +118,13 @@ patch_color_table(const char *key, PyObject *profiles, PyObject *spec, size_t wh
         color_type color = PyLong_AsUnsignedLong(v);
         for (Py_ssize_t j = 0; j < PyTuple_GET_SIZE(profiles); j++) {
             ColorProfile *self = (ColorProfile*)PyTuple_GET_ITEM(profiles, j);
-            self->color_table[which] = color;
+            // skip unchanged profiles so they keep their generation and the
+            // renderer does not re-upload them
+            if (self->color_table[which] != color) {
+                self->color_table[which] = color;
+                self->generation++;
+            }
             if (change_configured) self->orig_color_table[which] = color;
-            self->dirty = true;
         }
     }
 
@@ -132,8 +136,10 @@ patch_color_table(const char *key, PyObject *profiles, PyObject *spec, size_t wh
         color_type color = PyLong_AsUnsignedLong(v); \
         for (Py_ssize_t j = 0; j < PyTuple_GET_SIZE(profiles); j++) { \
             ColorProfile *self = (ColorProfile*)PyTuple_GET_ITEM(profiles, j); \
-            self->array[i] = color; \
-            self->dirty = true; \
+            if (self->array[i] != color) { \
+                self->array[i] = color; \
+                self->generation++; \
+            } \
 } } }
 
 
@@ -157,9 +163,12 @@ patch_color_profiles(PyObject *module UNUSED, PyObject *args) {
         color_type color = PyLong_AsUnsignedLong(v); \
         for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(profiles); i++) { \
             self = (ColorProfile*)PyTuple_GET_ITEM(profiles, i); \
-            self->overridden.profile_name = (color << 8) | 2; \
-            if (change_configured) self->configured.profile_name = color; \
-            self->dirty = true; \
+            color_type full = (color << 8) | 2; \
+            if (self->overridden.profile_name != full || (change_configured && self->configured.profile_name != color)) { \
+                self->overridden.profile_name = full; \
+                if (change_configured) self->configured.profile_name = color; \
+                self->generation++; \
+            } \
         } \
     } \
 }
@@ -179,7 +188,7 @@ patch_color_profiles(PyObject *module UNUSED, PyObject *args) {
                 self->configured.cursor_text_color = self->overridden.cursor_text_color;
                 self->configured.cursor_text_uses_bg = self->overridden.cursor_text_uses_bg;
             }
-            self->dirty = true;
+            self->generation++;
         }
     }
 
@@ -268,7 +277,7 @@ static PyObject*
 reset_color_table(ColorProfile *self, PyObject *a UNUSED) {
 #define reset_color_table_doc "Reset all customized colors back to defaults"
     memcpy(self->color_table, self->orig_color_table, sizeof(FG_BG_256));
-    self->dirty = true;
+    self->generation++;
     Py_RETURN_NONE;
 }
 
@@ -277,7 +286,7 @@ reset_color(ColorProfile *self, PyObject *val) {
 #define reset_color_doc "Reset the specified color"
     uint8_t i = PyLong_AsUnsignedLong(val) & 0xff;
     self->color_table[i] = self->orig_color_table[i];
-    self->dirty = true;
+    self->generation++;
     Py_RETURN_NONE;
 }
 
@@ -288,7 +297,7 @@ set_color(ColorProfile *self, PyObject *args) {
     unsigned long val;
     if (!PyArg_ParseTuple(args, "Bk", &i, &val)) return NULL;
     self->color_table[i] = val;
-    self->dirty = true;
+    self->generation++;
     Py_RETURN_NONE;
 }
 
@@ -300,7 +309,7 @@ set_configured_colors(ColorProfile *self, PyObject *args) {
                 &(self->configured.default_fg), &(self->configured.default_bg),
                 &(self->configured.cursor_color), &(self->configured.cursor_text_color), &(self->configured.cursor_text_uses_bg),
                 &(self->configured.highlight_fg), &(self->configured.highlight_bg))) return NULL;
-    self->dirty = true;
+    self->generation++;
     Py_RETURN_NONE;
 }
 
@@ -316,7 +325,6 @@ copy_color_table_to_buffer(ColorProfile *self, color_type *buf, int offset, size
     for (i = 0; i < arraysz(self->mark_foregrounds); i++) {
         *buf = self->mark_foregrounds[i]; buf += stride;
     }
-    self->dirty = false;
 }
 
 static void
@@ -329,6 +337,7 @@ static void
 copy_from_color_stack_at(ColorProfile *self, unsigned int i) {
     self->overridden = self->color_stack[i].dynamic_colors;
     memcpy(self->color_table, self->color_stack[i].color_table, sizeof(self->color_table));
+    self->generation++;
 }
 
 bool
@@ -395,7 +404,7 @@ default_color_table(PyObject *self UNUSED, PyObject *args UNUSED) {
 
 #define CGETSET(name) \
     static PyObject* name##_get(ColorProfile *self, void UNUSED *closure) { return PyLong_FromUnsignedLong(colorprofile_to_color(self, self->overridden.name, self->configured.name));  } \
-    static int name##_set(ColorProfile *self, PyObject *val, void UNUSED *closure) { if (val == NULL) { PyErr_SetString(PyExc_TypeError, "Cannot delete attribute"); return -1; } self->overridden.name = (color_type) PyLong_AsUnsignedLong(val); self->dirty = true; return 0; }
+    static int name##_set(ColorProfile *self, PyObject *val, void UNUSED *closure) { if (val == NULL) { PyErr_SetString(PyExc_TypeError, "Cannot delete attribute"); return -1; } self->overridden.name = (color_type) PyLong_AsUnsignedLong(val); self->generation++; return 0; }
 
 CGETSET(default_fg)
 CGETSET(default_bg)
@@ -0,0 +1,83 @@
+/*
+ * combining-chars.c
+ * Copyright (C) 2026 Kovid Goyal <kovid at kovidgoyal.net>
+ *
+ * Distributed under terms of the GPL3 license.
+ */
+
+// Cells with more than one combining character are rare, so instead of
+// reserving space for several marks in every CPUCell, chains of two or more
+// marks are interned here, keyed on their content, and the cell stores a
+// single id. Because the id is derived purely from content, cells remain
+// plain data: the bulk row copies done by scrolling, rewrap, history push and
+// scrollback compression need no fixups, and deduplication keeps the pool
+// tiny for real text. Chains live for the lifetime of the process, like the
+// mark tables in unicode-data.c they extend.
+
+#include "combining-chars.h"
+#include "uthash.h"
+
+#undef uthash_fatal
+#define uthash_fatal(msg) fatal(msg)
+
+typedef struct {
+    combining_type *marks;
+    unsigned len;
+    combining_type id;
+    UT_hash_handle hh;  // keyed by the mark sequence bytes
+} ChainEntry;
+
+static ChainEntry *chains_by_key = NULL;
+static struct {
+    ChainEntry **ids;  // indexed by id - COMBINING_CHAIN_BASE, for O(1) lookups
+    size_t count, capacity;
+} chain_pool = {0};
+
+unsigned
+num_combining_marks(combining_type cc) {
+    if (cc < COMBINING_CHAIN_BASE) return cc ? 1 : 0;
+    size_t idx = cc - COMBINING_CHAIN_BASE;
+    return idx < chain_pool.count ? chain_pool.ids[idx]->len : 0;
+}
+
+combining_type
+combining_mark_at(combining_type cc, unsigned i) {
+    if (cc < COMBINING_CHAIN_BASE) return i == 0 ? cc : 0;
+    size_t idx = cc - COMBINING_CHAIN_BASE;
+    if (idx >= chain_pool.count) return 0;
+    ChainEntry *e = chain_pool.ids[idx];
+    return i < e->len ? e->marks[i] : 0;
+}
+
+combining_type
+add_combining_mark(combining_type cc, combining_type mark) {
+    if (!mark) return cc;
+    if (!cc) return mark;  // a single mark is stored directly
+    combining_type buf[MAX_COMBINING_CHARS_PER_CELL];
+    unsigned n = num_combining_marks(cc);
+    if (n >= MAX_COMBINING_CHARS_PER_CELL) return cc;
+    for (unsigned i = 0; i < n; i++) buf[i] = combining_mark_at(cc, i);
+    buf[n++] = mark;
+    ChainEntry *e = NULL;
+    HASH_FIND(hh, chains_by_key, buf, n * sizeof(buf[0]), e);
+    if (e) return e->id;
+    if (COMBINING_CHAIN_BASE + chain_pool.count > UINT16_MAX) {
+        static bool warned = false;
+        if (!warned) {
+            log_error("Too many distinct combining character chains, dropping combining characters");
+            warned = true;
+        }
+        return cc;
+    }
+    e = malloc(sizeof(ChainEntry));
+    if (!e) fatal("Out of memory");
+    e->marks = malloc(n * sizeof(combining_type));
+    if (!e->marks) fatal("Out of memory");
+    memcpy(e->marks, buf, n * sizeof(combining_type));
+    e->len = n;
+    e->id = (combining_type)(COMBINING_CHAIN_BASE + chain_pool.count);
+    ensure_space_for(&chain_pool, ids, ChainEntry*, chain_pool.count + 1, capacity, 256, false);
+    chain_pool.ids[chain_pool.count++] = e;
+    HASH_ADD_KEYPTR(hh, chains_by_key, e->marks, n * sizeof(buf[0]), e);
+    return e->id;
+}
@@ -0,0 +1,32 @@
+/*
+ * combining-chars.h
+ * Copyright (C) 2026 Kovid Goyal <kovid at kovidgoyal.net>
+ *
+ * Distributed under terms of the GPL3 license.
+ */
+
+#pragma once
+
+#include "data-types.h"
+#include "unicode-data.h"
+
+// CPUCell.cc_idx encoding: 0 means no combining characters, values below
+// COMBINING_CHAIN_BASE are a single mark index (codepoint_for_mark()), values
+// at or above it are ids of interned chains of two or more marks, see
+// combining-chars.c. Must be larger than the size of the mark table in
+// unicode-data.c. As a special case, cells containing a '\t' re-use cc_idx to
+// store the number of spaces the tab expanded to, always below
+// COMBINING_CHAIN_BASE since it is bounded by the screen width.
+#define COMBINING_CHAIN_BASE 8192
+
+// Bounds the codepoints a single cell can contribute to the shaping buffers
+#define MAX_COMBINING_CHARS_PER_CELL 16
+
+combining_type add_combining_mark(combining_type cc, combining_type mark);
+unsigned num_combining_marks(combining_type cc);
+combining_type combining_mark_at(combining_type cc, unsigned i);
+
+static inline combining_type
+first_combining_mark(combining_type cc) {
+    return cc < COMBINING_CHAIN_BASE ? cc : combining_mark_at(cc, 0);
+}
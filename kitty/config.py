@@ -20,7 +20,7 @@ from .conf.utils import (
     parse_config_base, python_string, to_bool, to_cmdline
 )
 from .config_data import all_options, parse_mods, type_convert
-from .constants import cache_dir, defconf, is_macos
+from .constants import cache_dir, defconf, is_macos, str_version
 from .fonts import FontFeature
 from .key_names import get_key_name_lookup, key_name_aliases
 from .options_stub import Options as OptionsStub
@@ -778,6 +778,50 @@ def load_config(*paths: str, overrides: Optional[Iterable[str]] = None, accumula
     return opts
 
 
+def config_cache_signature(paths: Tuple[str, ...], overrides: Tuple[str, ...]) -> Tuple:
+
+    def stat_sig(path: str) -> Tuple[str, Optional[float], Optional[int]]:
+        try:
+            st = os.stat(path)
+        except OSError:
+            return path, None, None
+        return path, st.st_mtime, st.st_size
+
+    # Options._fields guards against the option definitions changing without
+    # a version bump, as happens when running from a source checkout
+    return str_version, Options._fields, tuple(map(stat_sig, paths)), overrides
+
+
+def load_config_cached(*paths: str, overrides: Optional[Iterable[str]] = None, accumulate_bad_lines: Optional[List[BadLine]] = None) -> OptionsStub:
+    # Parsing and validating the full option set is one of the largest
+    # chunks of startup time after interpreter boot, and the config rarely
+    # changes between startups. Keep the fully resolved options pickled in
+    # the cache dir, keyed on the config file paths, their stat signatures
+    # and any command line overrides, falling back to a full parse on miss.
+    # Failures to read or write the cache are never fatal.
+    import pickle
+    overrides = tuple(overrides) if overrides is not None else ()
+    sig = config_cache_signature(tuple(paths), overrides)
+    cache_path = os.path.join(cache_dir(), 'kitty.conf.cache')
+    with suppress(Exception):
+        with open(cache_path, 'rb') as f:
+            stored_sig, opts_dict, bad_lines = pickle.load(f)
+        # a cached parse that had bad lines cannot serve a caller that wants
+        # them raised, fall through to a full parse for that case
+        if stored_sig == sig and (accumulate_bad_lines is not None or not bad_lines):
+            if accumulate_bad_lines is not None:
+                accumulate_bad_lines.extend(bad_lines)
+            return Options(opts_dict)
+    opts = load_config(*paths, overrides=overrides, accumulate_bad_lines=accumulate_bad_lines)
+    with suppress(Exception):
+        data = pickle.dumps((sig, opts._asdict(), list(accumulate_bad_lines or ())), pickle.HIGHEST_PROTOCOL)
+        tmp = cache_path + '.tmp-{}'.format(os.getpid())
+        with open(tmp, 'wb') as f:
+            f.write(data)
+        os.replace(tmp, cache_path)
+    return opts
+
+
 class KittyCommonOpts(TypedDict):
     select_by_word_characters: str
     open_url_with: List[str]
@@ -613,6 +613,18 @@ increase CPU usage and might cause flicker in full screen programs that
 redraw the entire screen on each loop, because kitty is so fast that partial
 screen updates will be drawn.'''))
 
+def unfocused_output_limit(x: str) -> int:
+    return int(max(0, float(x)) * 1024)
+
+
+o('unfocused_output_limit', 0, option_type=unfocused_output_limit, long_text=_('''
+Limit (in KB) on the amount of output from the program running in an unfocused
+window that is processed per input tick. Output beyond the limit is left in
+the read buffer, eventually causing the program to block on writes to its tty,
+so that one window running a flood, such as a build log, cannot degrade input
+latency in the focused window. The focused window is never limited. A value of
+zero (the default) disables the limit.'''))
+
 o('sync_to_monitor', True, long_text=_('''
 Sync screen updates to the refresh rate of the monitor. This prevents
 tearing (https://en.wikipedia.org/wiki/Screen_tearing) when scrolling. However,
@@ -8,6 +8,7 @@
 #include "state.h"
 #include "fonts.h"
 #include "unicode-data.h"
+#include "combining-chars.h"
 #include <structmember.h>
 #include <stdint.h>
 #include <math.h>
@@ -201,8 +202,8 @@ manually_search_fallback_fonts(CTFontRef current_font, CPUCell *cell) {
                 char_type ch = cell->ch ? cell->ch : ' ';
                 bool found = true;
                 if (!glyph_id_for_codepoint_ctfont(new_font, ch)) found = false;
-                for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i] && found; i++) {
-                    ch = codepoint_for_mark(cell->cc_idx[i]);
+                for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn && found; i++) {
+                    ch = codepoint_for_mark(combining_mark_at(cell->cc_idx, i));
                     if (!glyph_id_for_codepoint_ctfont(new_font, ch)) found = false;
                 }
                 if (found) {
@@ -390,19 +391,30 @@ static size_t render_buf_sz = 0;
 static CGGlyph glyphs[128];
 static CGRect boxes[128];
 static CGPoint positions[128];
+// Creating a bitmap context and its color space on every render call is by
+// far the most expensive part of rasterizing a cell group, so they are cached
+// and re-used. The gray context is recreated only when the canvas dimensions
+// change, which during a paint of dense text is rare since most cell groups
+// share the same width.
+static CGColorSpaceRef gray_color_space = NULL, srgb_color_space = NULL;
+static CGContextRef render_ctx = NULL;
+static size_t render_ctx_width = 0, render_ctx_height = 0;
 
 static void
 finalize(void) {
     free(render_buf);
+    if (render_ctx) CGContextRelease(render_ctx);
+    if (gray_color_space) CGColorSpaceRelease(gray_color_space);
+    if (srgb_color_space) CGColorSpaceRelease(srgb_color_space);
     if (all_fonts_collection_data) CFRelease(all_fonts_collection_data);
 }
 
 
 static inline void
 render_color_glyph(CTFontRef font, uint8_t *buf, int glyph_id, unsigned int width, unsigned int height, unsigned int baseline) {
-    CGColorSpaceRef color_space = CGColorSpaceCreateDeviceRGB();
-    if (color_space == NULL) fatal("Out of memory");
-    CGContextRef ctx = CGBitmapContextCreate(buf, width, height, 8, 4 * width, color_space, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrderDefault);
+    if (srgb_color_space == NULL) srgb_color_space = CGColorSpaceCreateDeviceRGB();
+    if (srgb_color_space == NULL) fatal("Out of memory");
+    CGContextRef ctx = CGBitmapContextCreate(buf, width, height, 8, 4 * width, srgb_color_space, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrderDefault);
     if (ctx == NULL) fatal("Out of memory");
     CGContextSetShouldAntialias(ctx, true);
     CGContextSetShouldSmoothFonts(ctx, true);  // sub-pixel antialias
@@ -415,7 +427,6 @@ render_color_glyph(CTFontRef font, uint8_t *buf, int glyph_id, unsigned int widt
     CGPoint p = CGPointMake(0, 0);
     CTFontDrawGlyphs(font, &glyph, &p, 1, ctx);
     CGContextRelease(ctx);
-    CGColorSpaceRelease(color_space);
     for (size_t r = 0; r < width; r++) {
         for (size_t c = 0; c < height; c++, buf += 4) {
             uint32_t px = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
@@ -426,31 +437,36 @@ render_color_glyph(CTFontRef font, uint8_t *buf, int glyph_id, unsigned int widt
 
 static inline void
 ensure_render_space(size_t width, size_t height) {
-    if (render_buf_sz >= width * height) return;
-    free(render_buf);
-    render_buf_sz = width * height;
-    render_buf = malloc(render_buf_sz);
-    if (render_buf == NULL) fatal("Out of memory");
+    if (render_buf_sz < width * height) {
+        free(render_buf);
+        render_buf_sz = width * height;
+        render_buf = malloc(render_buf_sz);
+        if (render_buf == NULL) fatal("Out of memory");
+        // the context draws into render_buf, so it must be recreated
+        if (render_ctx) { CGContextRelease(render_ctx); render_ctx = NULL; }
+    }
+    if (render_ctx == NULL || render_ctx_width != width || render_ctx_height != height) {
+        if (render_ctx) CGContextRelease(render_ctx);
+        if (gray_color_space == NULL) gray_color_space = CGColorSpaceCreateDeviceGray();
+        if (gray_color_space == NULL) fatal("Out of memory");
+        render_ctx = CGBitmapContextCreate(render_buf, width, height, 8, width, gray_color_space, (kCGBitmapAlphaInfoMask & kCGImageAlphaNone));
+        if (render_ctx == NULL) fatal("Out of memory");
+        render_ctx_width = width; render_ctx_height = height;
+        CGContextSetShouldAntialias(render_ctx, true);
+        CGContextSetShouldSmoothFonts(render_ctx, true);
+        CGContextSetGrayFillColor(render_ctx, 1, 1); // white glyphs
+        CGContextSetGrayStrokeColor(render_ctx, 1, 1);
+        CGContextSetTextDrawingMode(render_ctx, kCGTextFillStroke);
+        CGContextSetTextMatrix(render_ctx, CGAffineTransformIdentity);
+    }
 }
 
 static inline void
 render_glyphs(CTFontRef font, unsigned int width, unsigned int height, unsigned int baseline, unsigned int num_glyphs) {
     memset(render_buf, 0, width * height);
-    CGColorSpaceRef gray_color_space = CGColorSpaceCreateDeviceGray();
-    if (gray_color_space == NULL) fatal("Out of memory");
-    CGContextRef render_ctx = CGBitmapContextCreate(render_buf, width, height, 8, width, gray_color_space, (kCGBitmapAlphaInfoMask & kCGImageAlphaNone));
-    if (render_ctx == NULL) fatal("Out of memory");
-    CGContextSetShouldAntialias(render_ctx, true);
-    CGContextSetShouldSmoothFonts(render_ctx, true);
-    CGContextSetGrayFillColor(render_ctx, 1, 1); // white glyphs
-    CGContextSetGrayStrokeColor(render_ctx, 1, 1);
     CGContextSetLineWidth(render_ctx, OPT(macos_thicken_font));
-    CGContextSetTextDrawingMode(render_ctx, kCGTextFillStroke);
-    CGContextSetTextMatrix(render_ctx, CGAffineTransformIdentity);
     CGContextSetTextPosition(render_ctx, 0, height - baseline);
     CTFontDrawGlyphs(font, glyphs, positions, num_glyphs, render_ctx);
-    CGContextRelease(render_ctx);
-    CGColorSpaceRelease(gray_color_space);
 }
 
 StringCanvas
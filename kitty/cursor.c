@@ -136,23 +136,25 @@ END_ALLOW_CASE_RANGE
 }
 
 void
-apply_sgr_to_cells(GPUCell *first_cell, unsigned int cell_count, unsigned int *params, unsigned int count) {
-#define RANGE for(unsigned c = 0; c < cell_count; c++, cell++)
-#define SET(shift) RANGE { cell->attrs |= (1 << shift); } break;
-#define RESET(shift) RANGE { cell->attrs &= ~(1 << shift); } break;
-#define RESET2(shift1, shift2) RANGE { cell->attrs &= ~((1 << shift1) | (1 << shift2)); } break;
-#define SETM(val, mask, shift) { RANGE { cell->attrs &= ~(mask << shift); cell->attrs |= ((val) << shift); } break; }
-#define SET_COLOR(which) { color_type color = 0; parse_color(params, &i, count, &color); if (color) { RANGE { cell->which = color; }} } break;
-#define SIMPLE(which, val) RANGE { cell->which = (val); } break;
+sgr_transform_from_params(SGRTransform *t, unsigned int *params, unsigned int count) {
+    memset(t, 0, sizeof(SGRTransform));
+    // later params override earlier ones for the same bits, so accumulate
+    // into the mask+value pair instead of applying as we go
+#define SETM(val, mask, shift) { attrs_type m = (attrs_type)((mask) << (shift)); t->attrs_mask |= m; t->attrs_value = (t->attrs_value & ~m) | (attrs_type)((val) << (shift)); } break;
+#define SET(shift) SETM(1, 1, shift)
+#define RESET(shift) SETM(0, 1, shift)
+#define RESET2(shift1, shift2) { attrs_type m = (attrs_type)((1 << (shift1)) | (1 << (shift2))); t->attrs_mask |= m; t->attrs_value &= ~m; } break;
+#define SET_COLOR(which) { color_type color = 0; parse_color(params, &i, count, &color); if (color) { t->which = color; t->set_##which = true; } } break;
+#define SIMPLE(which, val) { t->which = (val); t->set_##which = true; } break;
 
     unsigned int i = 0, attr;
     if (!count) { params[0] = 0; count = 1; }
     while (i < count) {
-        GPUCell *cell = first_cell;
         attr = params[i++];
         switch(attr) {
             case 0:
-                RANGE { cell->attrs &= WIDTH_MASK; cell->fg = 0; cell->bg = 0; cell->decoration_fg = 0; }
+                t->attrs_mask = (attrs_type)~WIDTH_MASK; t->attrs_value = 0;
+                t->fg = 0; t->set_fg = true; t->bg = 0; t->set_bg = true; t->decoration_fg = 0; t->set_decoration_fg = true;
                 break;
             case 1:
                 SET(BOLD_SHIFT);
@@ -208,7 +210,26 @@ END_ALLOW_CASE_RANGE
 #undef SET_COLOR
 #undef SET
 #undef SETM
-#undef RANGE
+#undef SIMPLE
+}
+
+void
+sgr_transform_apply(const SGRTransform *t, GPUCell *cells, unsigned int count) {
+    const attrs_type keep = (attrs_type)~t->attrs_mask;
+    for (unsigned int c = 0; c < count; c++) {
+        GPUCell *cell = cells + c;
+        cell->attrs = (cell->attrs & keep) | t->attrs_value;
+        if (t->set_fg) cell->fg = t->fg;
+        if (t->set_bg) cell->bg = t->bg;
+        if (t->set_decoration_fg) cell->decoration_fg = t->decoration_fg;
+    }
+}
+
+void
+apply_sgr_to_cells(GPUCell *first_cell, unsigned int cell_count, unsigned int *params, unsigned int count) {
+    SGRTransform t;
+    sgr_transform_from_params(&t, params, count);
+    sgr_transform_apply(&t, first_cell, cell_count);
 }
 
 const char*
@@ -155,8 +155,22 @@ wcwidth_wrap(PyObject UNUSED *self, PyObject *chr) {
     return PyLong_FromLong(wcwidth_std(PyLong_AsLong(chr)));
 }
 
+// the same clock and epoch as the C side monotonic(), so timestamps taken in
+// Python are directly comparable to ones taken in C
+static PyObject*
+monotonic_ns_wrap(PyObject UNUSED *self, PyObject *args UNUSED) {
+    return PyLong_FromLongLong(monotonic());
+}
+
+static PyObject*
+monotonic_start_time_ns_wrap(PyObject UNUSED *self, PyObject *args UNUSED) {
+    return PyLong_FromLongLong(monotonic_start_time);
+}
+
 
 static PyMethodDef module_methods[] = {
+    {"monotonic_ns", (PyCFunction)monotonic_ns_wrap, METH_NOARGS, ""},
+    {"monotonic_start_time_ns", (PyCFunction)monotonic_start_time_ns_wrap, METH_NOARGS, ""},
     {"wcwidth", (PyCFunction)wcwidth_wrap, METH_O, ""},
     {"wcswidth", (PyCFunction)wcswidth_std, METH_O, ""},
     {"open_tty", open_tty, METH_VARARGS, ""},
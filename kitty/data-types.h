@@ -82,6 +82,13 @@ typedef enum { TILING, SCALED, MIRRORED } BackgroundImageLayout;
 #define CHAR_IS_BLANK(ch) ((ch) == 32 || (ch) == 0)
 #define CONTINUED_MASK 1
 #define TEXT_DIRTY_MASK 2
+// the line changed on screen (moved or cleared) without its text changing, so
+// it needs re-uploading to the GPU but not re-shaping
+#define GPU_DIRTY_MASK 4
+// lazily computed summary of whether the line can contain a URL, invalidated
+// whenever the line text is dirtied, used to short circuit hover detection
+#define URL_SCANNED_MASK 8
+#define HAS_URL_ANCHOR_MASK 16
 
 #define FG 1
 #define BG 2
@@ -159,9 +166,21 @@ typedef struct {
     attrs_type attrs;
 } GPUCell;
 
+// The per-cell record actually uploaded to the GPU. The three cell colors are
+// packed into a single word: palette colors inline in 10-bit fields, with an
+// escape bit diverting truecolor cells to an index into a per-screen side
+// table, shrinking the record from 20 to 12 bytes.
+typedef struct {
+    sprite_index sprite_x, sprite_y, sprite_z;
+    attrs_type attrs;
+    uint32_t colors;
+} PackedGPUCell;
+
+// Combining characters are kept out of the cell: cc_idx is either a single
+// mark index or the id of an interned chain of marks, see combining-chars.h
 typedef struct {
     char_type ch;
-    combining_type cc_idx[2];
+    combining_type cc_idx;
     hyperlink_id_type hyperlink_id;
 } CPUCell;
 
@@ -190,14 +209,38 @@ typedef struct {
     GPUCell *gpu_cells;
     CPUCell *cpu_cells;
     line_attrs_type *line_attrs;
+    // non-NULL when the cells live in a file backed mmap instead of on the
+    // heap, so that the kernel can page out cold scrollback
+    void *mmap_block;
+    size_t mmap_block_sz;
+    // non-NULL when the cell storage has been replaced by an RLE compressed
+    // copy, see compress_cold_segments(). line_attrs are never compressed.
+    uint8_t *compressed;
+    size_t compressed_sz;
+    bool recently_used;
 } HistoryBufSegment;
 
 typedef struct {
     void *ringbuf;
     size_t maximum_size;
     bool rewrap_needed;
+    // non-NULL while a chunked rewrap is in progress, see
+    // pagerhist_rewrap_step() in history.c
+    void *rewrap_state;
 } PagerHistoryBuf;
 
+typedef struct {
+    char_type *needle;
+    size_t needle_len;
+    bool no_case;
+    // match coordinates as (y, x) pairs, y in the same visual order the
+    // buffer uses for text extraction (0 is the oldest line)
+    index_type *matches;
+    size_t num_matches, capacity;
+    // buffer state the cached matches are valid for
+    index_type count_snapshot, start_snapshot;
+} IncrementalSearch;
+
 typedef struct {int x;} *HYPERLINK_POOL_HANDLE;
 typedef struct {
     Py_UCS4 *buf;
@@ -206,7 +249,7 @@ typedef struct {
     hyperlink_id_type active_hyperlink_id;
 } ANSIBuf;
 
-typedef struct {
+typedef struct HistoryBuf {
     PyObject_HEAD
 
     index_type xnum, ynum, num_segments;
@@ -214,6 +257,21 @@ typedef struct {
     PagerHistoryBuf *pagerhist;
     Line *line;
     index_type start_of_data, count;
+    // intrusive list of all history buffers, most recently grown first, used
+    // by the process wide scrollback memory budget
+    struct HistoryBuf *lru_next;
+    // segment currently being written to by historybuf_push(), segments that
+    // have not been touched since it last changed are compressed
+    index_type active_segment;
+    // cached matches for incremental scrollback search, see find_text()
+    IncrementalSearch search;
+    // HistoryBuf at a previous width whose contents still have to be
+    // rewrapped into this one, see historybuf_resolve_deferred_rewrap()
+    PyObject *deferred_rewrap_src;
+    // set on orphaned buffers waiting to be rewrapped into their
+    // replacement, so the rewrap can free their segments as it consumes
+    // them instead of keeping two full copies of the scrollback alive
+    bool free_segments_as_rewrap_consumes;
 } HistoryBuf;
 
 typedef struct {
@@ -246,7 +304,10 @@ typedef struct {
 typedef struct {
     PyObject_HEAD
 
-    bool dirty;
+    // bumped on every color change, the renderer compares it against the
+    // generation its GPU side copy was built from instead of a dirty flag
+    // that uploading would have to reset
+    uint32_t generation;
     uint32_t color_table[256];
     uint32_t orig_color_table[256];
     ColorStackEntry *color_stack;
@@ -299,6 +360,17 @@ Cursor* cursor_copy(Cursor*);
 void cursor_copy_to(Cursor *src, Cursor *dest);
 void cursor_reset_display_attrs(Cursor*);
 void cursor_from_sgr(Cursor *self, unsigned int *params, unsigned int count);
+// Precomputed effect of a set of SGR params on a GPUCell: the attrs change is
+// a single mask+value pair and each color is an optional overwrite. Computing
+// this once lets a rectangle be swept with one pass per cell instead of one
+// pass per cell per param.
+typedef struct {
+    attrs_type attrs_mask, attrs_value;
+    color_type fg, bg, decoration_fg;
+    bool set_fg, set_bg, set_decoration_fg;
+} SGRTransform;
+void sgr_transform_from_params(SGRTransform *t, unsigned int *params, unsigned int count);
+void sgr_transform_apply(const SGRTransform *t, GPUCell *cells, unsigned int count);
 void apply_sgr_to_cells(GPUCell *first_cell, unsigned int cell_count, unsigned int *params, unsigned int count);
 const char* cell_as_sgr(const GPUCell *, const GPUCell *);
 const char* cursor_as_sgr(const Cursor *);
@@ -7,12 +7,17 @@
 
 #define EXTRA_INIT if (PyModule_AddFunctions(module, module_methods) != 0) return false;
 
+// for fallocate()
+#define _GNU_SOURCE
 #include "disk-cache.h"
 #include "uthash.h"
 #include "loop-utils.h"
+#include "tracepoints.h"
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
+#include <poll.h>
 
 
 typedef struct {
@@ -21,35 +26,129 @@ typedef struct {
     size_t hash_keylen, data_sz;
     bool written_to_disk;
     uint8_t encryption_key[64];
-    char filename[8];
+    // position in the single cache file, on_disk_capacity is zero until disk
+    // space has been reserved for this entry
+    off_t offset;
+    size_t on_disk_capacity;
     UT_hash_handle hh;
 } CacheEntry;
 
+// A snapshot of an entry taken by the write thread. It owns data (stolen from
+// the entry under the lock, so adds cannot free it mid-write), which stays
+// unencrypted for its whole lifetime, allowing readers to copy from it
+// directly while the write is in flight.
+typedef struct {
+    const void *hash_key;
+    uint8_t *data;
+    size_t hash_keylen, data_sz;
+    uint8_t encryption_key[64];
+    off_t offset;
+} WriteJob;
+
+// A hole in the single cache file, available for re-use by a future entry
+typedef struct {
+    off_t offset;
+    size_t sz;
+} FreeExtent;
 
 typedef struct {
     PyObject_HEAD
     char *path;
-    int path_fd;
+    int path_fd, cache_file_fd;
     pthread_mutex_t lock;
     pthread_t write_thread;
     bool thread_started, lock_inited, loop_data_inited, shutting_down, fully_initialized;
     LoopData loop_data;
     PyObject *rmtree;
-    CacheEntry *entries, currently_writing;
+    CacheEntry *entries;
+    // entries currently being written out, mutated only under the lock
+    struct { WriteJob *jobs; size_t count, capacity; } inflight;
+    // holes in the cache file left behind by entries that were re-written at
+    // a new size, mutated only under the lock
+    struct { FreeExtent *extents; size_t count, capacity; } free_list;
+    off_t cache_file_size;
 } DiskCache;
 
 
 void
 free_cache_entry(const DiskCache *self, CacheEntry *e) {
+    (void)self;
     if (e->hash_key) { free(e->hash_key); e->hash_key = NULL; }
     if (e->data) { free(e->data); e->data = NULL; }
-    if (self->path_fd > -1 && e->filename[0]) {
-        unlinkat(self->path_fd, e->filename, 0);
-        e->filename[0] = 0;
-    }
     free(e);
 }
 
+// Reserve sz bytes in the cache file, re-using the first hole that is large
+// enough, extending the file only when there is none. Must be called with the
+// lock held.
+static off_t
+allocate_extent(DiskCache *self, size_t sz) {
+    for (size_t i = 0; i < self->free_list.count; i++) {
+        FreeExtent *e = self->free_list.extents + i;
+        if (e->sz >= sz) {
+            off_t ans = e->offset;
+            e->offset += sz; e->sz -= sz;
+            if (!e->sz) {
+                memmove(e, e + 1, (self->free_list.count - i - 1) * sizeof(FreeExtent));
+                self->free_list.count--;
+            }
+            return ans;
+        }
+    }
+    off_t ans = self->cache_file_size;
+    self->cache_file_size += sz;
+    return ans;
+}
+
+// Return the blocks backing the extent to the filesystem. The file size is
+// unchanged, so offsets of other entries remain valid.
+static void
+punch_hole(DiskCache *self, off_t offset, size_t sz) {
+    if (self->cache_file_fd < 0) return;
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+    fallocate(self->cache_file_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, sz);
+#elif defined(F_PUNCHHOLE)
+    struct fpunchhole fp = {.fp_offset = offset, .fp_length = sz};
+    fcntl(self->cache_file_fd, F_PUNCHHOLE, &fp);
+#else
+    (void)offset; (void)sz;
+#endif
+}
+
+// Give an extent back to the free list, merging it with adjacent holes so
+// that large entries can re-use the space of several evicted small ones.
+// Must be called with the lock held.
+static void
+return_extent(DiskCache *self, off_t offset, size_t sz) {
+    if (!sz) return;
+    punch_hole(self, offset, sz);
+    if (offset + (off_t)sz == self->cache_file_size) { self->cache_file_size = offset; return; }
+    FreeExtent *before = NULL, *after = NULL;
+    for (size_t i = 0; i < self->free_list.count; i++) {
+        FreeExtent *e = self->free_list.extents + i;
+        if (e->offset + (off_t)e->sz == offset) before = e;
+        else if (offset + (off_t)sz == e->offset) after = e;
+    }
+    if (before) {
+        before->sz += sz;
+        if (after) {
+            before->sz += after->sz;
+            size_t idx = after - self->free_list.extents;
+            memmove(after, after + 1, (self->free_list.count - idx - 1) * sizeof(FreeExtent));
+            self->free_list.count--;
+        }
+        return;
+    }
+    if (after) { after->offset = offset; after->sz += sz; return; }
+    if (self->free_list.count >= self->free_list.capacity) {
+        size_t c = MAX(64u, 2 * self->free_list.capacity);
+        FreeExtent *e = realloc(self->free_list.extents, c * sizeof(FreeExtent));
+        if (!e) return;  // the hole is leaked until the cache is destroyed, not worth failing over
+        self->free_list.extents = e; self->free_list.capacity = c;
+    }
+    self->free_list.extents[self->free_list.count++] = (FreeExtent){.offset=offset, .sz=sz};
+}
+
 #define mutex(op) pthread_mutex_##op(&self->lock)
 
 static PyObject*
@@ -57,7 +156,7 @@ new(PyTypeObject *type, PyObject UNUSED *args, PyObject UNUSED *kwds) {
     DiskCache *self;
     self = (DiskCache*)type->tp_alloc(type, 0);
     if (self) {
-        self->path_fd = -1;
+        self->path_fd = -1; self->cache_file_fd = -1;
         PyObject *shutil = PyImport_ImportModule("shutil");
         if (!shutil) { Py_CLEAR(self); return NULL; }
         self->rmtree = PyObject_GetAttrString(shutil, "rmtree");
@@ -67,11 +166,175 @@ new(PyTypeObject *type, PyObject UNUSED *args, PyObject UNUSED *kwds) {
     return (PyObject*) self;
 }
 
+static void
+xor_data(const uint8_t* restrict key, const size_t key_sz, uint8_t* restrict data, const size_t data_sz) {
+    size_t unaligned_sz = data_sz % key_sz;
+    size_t aligned_sz = data_sz - unaligned_sz;
+    for (size_t offset = 0; offset < aligned_sz; offset += key_sz) {
+        for (size_t i = 0; i < key_sz; i++) data[offset + i] ^= key[i];
+    }
+    for (size_t i = 0; i < unaligned_sz; i++) data[aligned_sz + i] ^= key[i];
+}
+
+// Same as xor_data() except that it reads from src and writes to dest,
+// combining the copy out of a source buffer and the decryption into one pass
+static void
+xor_data_into(const uint8_t* restrict key, const size_t key_sz, const uint8_t* restrict src, uint8_t* restrict dest, const size_t data_sz) {
+    size_t unaligned_sz = data_sz % key_sz;
+    size_t aligned_sz = data_sz - unaligned_sz;
+    for (size_t offset = 0; offset < aligned_sz; offset += key_sz) {
+        for (size_t i = 0; i < key_sz; i++) dest[offset + i] = src[offset + i] ^ key[i];
+    }
+    for (size_t i = 0; i < unaligned_sz; i++) dest[aligned_sz + i] = src[aligned_sz + i] ^ key[i];
+}
+
+static void
+generate_encryption_key(uint8_t *key, size_t key_sz) {
+    memset(key, 0, key_sz);
+    int fd = -1;
+    while (fd < 0) {
+        fd = open("/dev/urandom", O_CLOEXEC | O_RDONLY);
+        if (fd > -1 || errno != EINTR) break;
+    }
+    if (fd < 0) { log_error("Failed to open /dev/urandom for the disk cache encryption key, storing data unencrypted"); return; }
+    size_t pos = 0;
+    while (pos < key_sz) {
+        ssize_t n = read(fd, key + pos, key_sz - pos);
+        if (n < 1) {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+            log_error("Failed to read from /dev/urandom for the disk cache encryption key");
+            break;
+        }
+        pos += n;
+    }
+    safe_close(fd, __FILE__, __LINE__);
+}
+
+static void
+drain_fd(int fd) {
+    static uint8_t drain_buf[1024];
+    while(true) {
+        ssize_t len = read(fd, drain_buf, sizeof(drain_buf));
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (len == 0) break;
+    }
+}
+
+static bool
+write_encrypted(int fd, const uint8_t *data, size_t sz, off_t offset) {
+    while (sz) {
+        ssize_t n = pwrite(fd, data, sz, offset);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+        data += n; sz -= n; offset += n;
+    }
+    return true;
+}
+
+// Take a snapshot, under the lock, of all entries that need writing, stealing
+// their data pointers so that a concurrent overwrite of an entry cannot free
+// the data from under us. Returns the number of entries snapshotted.
+static size_t
+gather_pending_entries(DiskCache *self) {
+    size_t num_pending = 0;
+    mutex(lock);
+    CacheEntry *s, *tmp;
+    HASH_ITER(hh, self->entries, s, tmp) {
+        if (!s->data || s->written_to_disk) continue;
+        if (num_pending >= self->inflight.capacity) {
+            size_t c = MAX(64u, 2 * self->inflight.capacity);
+            WriteJob *j = realloc(self->inflight.jobs, c * sizeof(WriteJob));
+            if (!j) break;  // write what we have, remaining entries stay pending for the next pass
+            self->inflight.jobs = j; self->inflight.capacity = c;
+        }
+        if (s->on_disk_capacity != s->data_sz) {
+            // an exact size re-use keeps its place, otherwise the old space
+            // goes back to the free list and new space is reserved
+            return_extent(self, s->offset, s->on_disk_capacity);
+            s->offset = allocate_extent(self, s->data_sz);
+            s->on_disk_capacity = s->data_sz;
+        }
+        generate_encryption_key(s->encryption_key, sizeof(s->encryption_key));
+        WriteJob *j = self->inflight.jobs + num_pending++;
+        j->hash_key = s->hash_key; j->hash_keylen = s->hash_keylen;
+        j->data = s->data; j->data_sz = s->data_sz;
+        memcpy(j->encryption_key, s->encryption_key, sizeof(j->encryption_key));
+        j->offset = s->offset;
+        s->data = NULL;
+    }
+    self->inflight.count = num_pending;
+    mutex(unlock);
+    return num_pending;
+}
+
+// Write out one snapshotted entry, encrypting into the scratch buffer rather
+// than in place so the snapshot stays readable while the write is in flight.
+// Called without the lock held, the lock is taken only to publish the result.
+static void
+write_job(DiskCache *self, WriteJob *j, uint8_t **scratch, size_t *scratch_sz) {
+    bool ok = false;
+    TRACE_EVENT1(disk_cache_write, j->data_sz);
+    if (*scratch_sz < j->data_sz) {
+        uint8_t *q = realloc(*scratch, j->data_sz);
+        if (q) { *scratch = q; *scratch_sz = j->data_sz; }
+    }
+    if (*scratch_sz >= j->data_sz && self->cache_file_fd > -1) {
+        memcpy(*scratch, j->data, j->data_sz);
+        xor_data(j->encryption_key, sizeof(j->encryption_key), *scratch, j->data_sz);
+        // a single positioned write into the entry's reserved extent, no
+        // per-entry open/create/unlink traffic on the cache directory
+        ok = write_encrypted(self->cache_file_fd, *scratch, j->data_sz, j->offset);
+        if (!ok) log_error("Failed to write to disk cache file with error: %s", strerror(errno));
+    }
+    mutex(lock);
+    CacheEntry *s = NULL;
+    HASH_FIND(hh, self->entries, j->hash_key, j->hash_keylen, s);
+    // if the entry was overwritten while we were writing, its data pointer is
+    // no longer NULL and what we wrote is stale, leave it pending
+    if (s && s->data == NULL) {
+        if (ok) s->written_to_disk = true;
+        else { s->data = j->data; j->data = NULL; }  // restore, so the data is not lost
+    }
+    if (j->data) { free(j->data); j->data = NULL; }
+    mutex(unlock);
+}
+
 static void*
 write_loop(void *data) {
     DiskCache *self = (DiskCache*)data;
+    struct pollfd fds[1] = {{.fd = self->loop_data.wakeup_read_fd, .events = POLLIN}};
+    uint8_t *scratch = NULL; size_t scratch_sz = 0;
     while (!self->shutting_down) {
+        int ret = poll(fds, 1, -1);
+        if (ret < 0) { if (errno == EINTR || errno == EAGAIN) continue; break; }
+        if (fds[0].revents & POLLIN) drain_fd(fds[0].fd);
+        // process all entries that are pending at each wakeup in one batch,
+        // taking the lock once per batch rather than once per entry
+        while (!self->shutting_down && gather_pending_entries(self)) {
+            for (size_t i = 0; i < self->inflight.count && !self->shutting_down; i++) {
+                write_job(self, self->inflight.jobs + i, &scratch, &scratch_sz);
+            }
+            mutex(lock);
+            for (size_t i = 0; i < self->inflight.count; i++) {
+                WriteJob *j = self->inflight.jobs + i;
+                if (j->data) {  // skipped because of shutdown, give the data back to its entry
+                    CacheEntry *s = NULL;
+                    HASH_FIND(hh, self->entries, j->hash_key, j->hash_keylen, s);
+                    if (s && s->data == NULL) s->data = j->data;
+                    else free(j->data);
+                    j->data = NULL;
+                }
+            }
+            self->inflight.count = 0;
+            mutex(unlock);
+        }
     }
+    free(scratch);
     return 0;
 }
 
@@ -125,6 +388,19 @@ ensure_state(DiskCache *self) {
         }
     }
 
+    if (self->cache_file_fd < 0) {
+        // all entries live in this one file, at offsets handed out by
+        // allocate_extent()
+        while (self->cache_file_fd < 0) {
+            self->cache_file_fd = openat(self->path_fd, "cache", O_CLOEXEC | O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+            if (self->cache_file_fd > -1 || errno != EINTR) break;
+        }
+        if (self->cache_file_fd < 0) {
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, self->path);
+            return false;
+        }
+    }
+
     self->fully_initialized = true;
     return true;
 }
@@ -158,16 +434,26 @@ dealloc(DiskCache* self) {
         }
         self->entries = NULL;
     }
+    if (self->cache_file_fd > -1) {
+        safe_close(self->cache_file_fd, __FILE__, __LINE__);
+        self->cache_file_fd = -1;
+    }
     if (self->path_fd > -1) {
         safe_close(self->path_fd, __FILE__, __LINE__);
         self->path_fd = -1;
     }
+    if (self->free_list.extents) {
+        free(self->free_list.extents); self->free_list.extents = NULL;
+        self->free_list.count = 0; self->free_list.capacity = 0;
+    }
     if (self->path) {
         PyObject_CallFunction(self->rmtree, "sO", self->path, Py_True);
         free(self->path); self->path = NULL;
     }
-    if (self->currently_writing.hash_key) free(self->currently_writing.hash_key);
-    if (self->currently_writing.data) free(self->currently_writing.data);
+    if (self->inflight.jobs) {
+        free(self->inflight.jobs); self->inflight.jobs = NULL;
+        self->inflight.count = 0; self->inflight.capacity = 0;
+    }
     Py_CLEAR(self->rmtree);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -205,48 +491,81 @@ end:
     return true;
 }
 
-static void
-xor_data(const uint8_t* restrict key, const size_t key_sz, uint8_t* restrict data, const size_t data_sz) {
-    size_t unaligned_sz = data_sz % key_sz;
-    size_t aligned_sz = data_sz - unaligned_sz;
-    for (size_t offset = 0; offset < aligned_sz; offset += key_sz) {
-        for (size_t i = 0; i < key_sz; i++) data[offset + i] ^= key[i];
-    }
-    for (size_t i = 0; i < unaligned_sz; i++) data[aligned_sz + i] ^= key[i];
-}
-
 static void
 read_from_cache_entry(const DiskCache *self, const CacheEntry *s, uint8_t *dest) {
-    int fd = -1;
-    while (fd < 0) {
-        fd = openat(self->path_fd, s->filename, O_CLOEXEC | O_RDONLY);
-        if (fd > 0 || errno != EINTR) break;
-    }
+    int fd = self->cache_file_fd;
     if (fd < 0) {
-        PyErr_SetFromErrnoWithFilename(PyExc_OSError, s->filename);
+        PyErr_SetString(PyExc_OSError, "Disk cache file not open");
         return;
     }
+#ifdef POSIX_FADV_WILLNEED
+    // ask the kernel to read the whole entry in, upfront, instead of
+    // waiting for its readahead window to ramp up
+    posix_fadvise(fd, s->offset, s->data_sz, POSIX_FADV_WILLNEED);
+#endif
+    // map the entry's extent and decrypt straight from the page cache into
+    // dest, so the data is touched only once instead of being copied by
+    // pread() and then decrypted in a second pass
+    if (s->data_sz) {
+        static long page_size = 0;
+        if (!page_size) page_size = sysconf(_SC_PAGESIZE);
+        off_t map_start = s->offset - (s->offset % page_size);
+        size_t delta = s->offset - map_start;
+        void *map = mmap(NULL, s->data_sz + delta, PROT_READ, MAP_PRIVATE, fd, map_start);
+        if (map != MAP_FAILED) {
+            xor_data_into(s->encryption_key, sizeof(s->encryption_key), (uint8_t*)map + delta, dest, s->data_sz);
+            munmap(map, s->data_sz + delta);
+            return;
+        }
+    }
+    // fallback for filesystems where mmap fails
     uint8_t *p = dest;
     size_t sz = s->data_sz;
+    off_t offset = s->offset;
     while (sz) {
-        ssize_t n = read(fd, p, sz);
+        ssize_t n = pread(fd, p, sz, offset);
         if (n > 0) {
             sz -= n;
             p += n;
+            offset += n;
             continue;
         }
         if (n < 0) {
             if (errno == EINTR || errno == EAGAIN) continue;
-            PyErr_SetFromErrnoWithFilename(PyExc_OSError, s->filename);
-            goto end;
+            PyErr_SetFromErrno(PyExc_OSError);
+            return;
         }
         if (n == 0) {
             PyErr_SetString(PyExc_OSError, "Disk cache file truncated");
-            goto end;
+            return;
         }
     }
-end:
-    safe_close(fd, __FILE__, __LINE__);
+    xor_data(s->encryption_key, sizeof(s->encryption_key), dest, s->data_sz);
+}
+
+// Look for the key in the batch of entries the write thread is currently
+// writing out. Must be called with the lock held. The in-flight data is
+// plaintext, so no decryption is needed.
+static bool
+find_inflight_data(const DiskCache *self, const void *key, size_t key_sz, uint8_t *dest) {
+    for (size_t i = 0; i < self->inflight.count; i++) {
+        const WriteJob *j = self->inflight.jobs + i;
+        if (j->data && j->hash_keylen == key_sz && memcmp(j->hash_key, key, key_sz) == 0) {
+            memcpy(dest, j->data, j->data_sz);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Copy the entry's data into dest, decrypting if it has to come from disk.
+// Must be called with the lock held.
+static void
+read_entry_into(DiskCache *self, CacheEntry *s, uint8_t *dest) {
+    TRACE_EVENT2(disk_cache_read, s->data_sz, s->data == NULL);
+    if (s->data) { memcpy(dest, s->data, s->data_sz); return; }
+    if (!s->written_to_disk && find_inflight_data(self, s->hash_key, s->hash_keylen, dest)) return;
+    read_from_cache_entry(self, s, dest);
 }
 
 bool
@@ -261,22 +580,47 @@ read_from_disk_cache(PyObject *self_, const void *key, size_t key_sz, uint8_t **
     *data = (uint8_t*)malloc(s->data_sz);
     if (!*data) { PyErr_NoMemory(); goto end; }
     *data_sz = s->data_sz;
+    read_entry_into(self, s, *data);
+end:
+    mutex(unlock);
+    if (PyErr_Occurred()) return false;
+    return true;
+}
 
-    if (s->data) { memcpy(*data, s->data, *data_sz); }
-    else if (self->currently_writing.hash_key && self->currently_writing.hash_keylen == key_sz && memcmp(self->currently_writing.hash_key, key, key_sz) == 0) {
-        memcpy(*data, self->currently_writing.data, *data_sz);
-        xor_data(self->currently_writing.encryption_key, sizeof(self->currently_writing.encryption_key), *data, *data_sz);
-    }
-    else {
-        read_from_cache_entry(self, s, *data);
-        xor_data(s->encryption_key, sizeof(s->encryption_key), *data, *data_sz);
-    }
+bool
+read_from_disk_cache_into(PyObject *self_, const void *key, size_t key_sz, uint8_t *dest, size_t dest_sz) {
+    DiskCache *self = (DiskCache*)self_;
+    if (!ensure_state(self)) return false;
+    mutex(lock);
+    CacheEntry *s = NULL;
+    HASH_FIND(hh, self->entries, key, key_sz, s);
+    if (!s) { PyErr_SetString(PyExc_KeyError, "No cached entry with specified key found"); goto end; }
+    if (s->data_sz != dest_sz) { PyErr_SetString(PyExc_ValueError, "Cached entry does not match the size of the destination buffer"); goto end; }
+    read_entry_into(self, s, dest);
 end:
     mutex(unlock);
     if (PyErr_Occurred()) return false;
     return true;
 }
 
+void
+disk_cache_size_of(PyObject *self_, size_t *in_ram, size_t *on_disk) {
+    DiskCache *self = (DiskCache*)self_;
+    *in_ram = 0; *on_disk = 0;
+    if (!self->lock_inited) return;
+    mutex(lock);
+    CacheEntry *s, *tmp;
+    HASH_ITER(hh, self->entries, s, tmp) {
+        if (s->data) *in_ram += s->data_sz;
+        else if (s->written_to_disk) *on_disk += s->data_sz;
+    }
+    // data stolen by the write thread is still in RAM until its write finishes
+    for (size_t i = 0; i < self->inflight.count; i++) {
+        if (self->inflight.jobs[i].data) *in_ram += self->inflight.jobs[i].data_sz;
+    }
+    mutex(unlock);
+}
+
 #define PYWRAP(name) static PyObject* py##name(DiskCache *self, PyObject *args)
 #define PA(fmt, ...) if (!PyArg_ParseTuple(args, fmt, __VA_ARGS__)) return NULL;
 PYWRAP(ensure_state) {
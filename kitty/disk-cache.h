@@ -10,3 +10,9 @@
 
 PyObject* create_disk_cache(void);
 bool add_to_disk_cache(PyObject *self, const void *key, size_t key_sz, const uint8_t *data, size_t data_sz);
+bool read_from_disk_cache(PyObject *self, const void *key, size_t key_sz, uint8_t **data, size_t *data_sz);
+// Read into a caller supplied buffer, such as a mapped PBO, avoiding an
+// allocation and copy. dest_sz must exactly match the size of the stored data.
+bool read_from_disk_cache_into(PyObject *self, const void *key, size_t key_sz, uint8_t *dest, size_t dest_sz);
+// Total bytes of cached data held in RAM and evicted to disk, for memory accounting
+void disk_cache_size_of(PyObject *self, size_t *in_ram, size_t *on_disk);
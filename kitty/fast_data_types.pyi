@@ -480,6 +480,18 @@ def monitor_pid(pid: int) -> None:
     pass
 
 
+def perf_counters() -> Dict[str, Dict[str, Any]]:
+    pass
+
+
+def monotonic_ns() -> int:
+    pass
+
+
+def monotonic_start_time_ns() -> int:
+    pass
+
+
 def add_window(os_window_id: int, tab_id: int, title: str) -> int:
     pass
 
@@ -736,6 +748,14 @@ def get_clipboard_string() -> str:
     pass
 
 
+def request_clipboard_string(primary: bool = False) -> bool:
+    pass
+
+
+def resume_clipboard_request() -> None:
+    pass
+
+
 def focus_os_window(os_window_id: int, also_raise: bool = True) -> bool:
     pass
 
@@ -918,6 +938,22 @@ def sprite_map_set_limits(w: int, h: int) -> None:
     pass
 
 
+def get_render_timings(os_window_id: int) -> Optional[Dict[str, Any]]:
+    pass
+
+
+def set_shader_program_cache_directory(path: str) -> None:
+    pass
+
+
+def shm_write(name: str, data: bytes) -> None:
+    pass
+
+
+def shm_unlink(name: str) -> None:
+    pass
+
+
 def set_send_sprite_to_gpu(
     func: Optional[Callable[[int, int, int, bytes], None]]
 ) -> None:
@@ -958,6 +994,20 @@ class HistoryBuf:
     def pagerhist_as_bytes(self) -> bytes:
         pass
 
+    def find_text(self, needle: str, no_case: bool = False) -> Tuple[Tuple[int, int], ...]:
+        pass
+
+    def memory_used(self) -> int:
+        pass
+
+
+def set_scrollback_memory_budget(budget: int) -> None:
+    pass
+
+
+def scrollback_memory_used() -> int:
+    pass
+
 
 class LineBuf:
 
@@ -967,6 +1017,9 @@ class LineBuf:
     def line(self, num: int) -> Line:
         pass
 
+    def find_text(self, needle: str, no_case: bool = False) -> Tuple[Tuple[int, int], ...]:
+        pass
+
 
 class Cursor:
     x: int
@@ -1057,7 +1110,7 @@ class Screen:
     def refresh_sprite_positions(self) -> None:
         pass
 
-    def set_marker(self, marker: Optional[Callable] = None) -> None:
+    def set_marker(self, marker: Optional[Union[Callable, Tuple[int, str]]] = None) -> None:
         pass
 
     def paste_bytes(self, data: bytes) -> None:
@@ -1069,6 +1122,9 @@ class Screen:
     as_text_non_visual = as_text
     as_text_alternate = as_text
 
+    def scan_text(self, patterns: Tuple[str, ...], scrollback_lines: int = 0) -> List[Tuple[int, int, int, str]]:
+        pass
+
     def scroll_until_cursor(self) -> None:
         pass
 
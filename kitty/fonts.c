@@ -10,6 +10,8 @@
 #include "state.h"
 #include "emoji.h"
 #include "unicode-data.h"
+#include "combining-chars.h"
+#include "disk-cache.h"
 
 #define MISSING_GLYPH 4
 #define MAX_NUM_EXTRA_GLYPHS 8u
@@ -31,7 +33,6 @@ typedef struct {
 
 typedef struct SpritePosition SpritePosition;
 struct SpritePosition {
-    SpritePosition *next;
     bool filled, rendered, colored;
     sprite_index x, y, z;
     uint8_t ligature_index;
@@ -39,6 +40,14 @@ struct SpritePosition {
     ExtraGlyphs extra_glyphs;
 };
 
+typedef struct {
+    // Growable open addressing table. Entries are individually allocated so
+    // that growing the table does not invalidate the SpritePosition pointers
+    // the render path holds on to.
+    SpritePosition **entries;
+    size_t capacity, count;  // capacity is a power of two
+} SpriteMap;
+
 #define SPECIAL_FILLED_MASK 1
 #define SPECIAL_VALUE_MASK 2
 #define EMPTY_FILLED_MASK 4
@@ -46,11 +55,27 @@ struct SpritePosition {
 #define SPECIAL_GLYPH_CACHE_SIZE 1024
 
 struct SpecialGlyphCache {
-    SpecialGlyphCache *next;
     glyph_index glyph;
     uint8_t data;
 };
 
+typedef struct {
+    SpecialGlyphCache **entries;
+    size_t capacity, count;  // capacity is a power of two
+} SpecialGlyphMap;
+
+typedef struct {
+    char_type ch;
+    combining_type cc_idx;
+    bool bold, italic, emoji_presentation;
+    ssize_t font_idx;  // can be MISSING_FONT
+} FallbackFontEntry;
+
+typedef struct {
+    FallbackFontEntry **entries;
+    size_t capacity, count;  // capacity is a power of two
+} FallbackFontMap;
+
 typedef struct {
     size_t max_y;
     unsigned int x, y, z, xnum, ynum;
@@ -74,11 +99,14 @@ static size_t num_symbol_maps = 0;
 
 typedef struct {
     PyObject *face;
+    // hash of the face identity (postscript name + style), used to key the
+    // rendered glyph bitmap cache. Zero means do not cache.
+    uint64_t face_key;
     // Map glyphs to sprite map co-ords
-    SpritePosition sprite_map[1024];
+    SpriteMap sprite_map;
     hb_feature_t* ffs_hb_features;
     size_t num_ffs_hb_features;
-    SpecialGlyphCache special_glyph_cache[SPECIAL_GLYPH_CACHE_SIZE];
+    SpecialGlyphMap special_glyph_cache;
     bool bold, italic, emoji_presentation;
 } Font;
 
@@ -89,8 +117,10 @@ typedef struct {
     size_t fonts_capacity, fonts_count, fallback_fonts_count;
     ssize_t medium_font_idx, bold_font_idx, italic_font_idx, bi_font_idx, first_symbol_font_idx, first_fallback_font_idx;
     Font *fonts;
+    FallbackFontMap fallback_font_map;
     pixel *canvas;
     GPUSpriteTracker sprite_tracker;
+    monotonic_t unused_since;  // 0 while some window uses this group
 } FontGroup;
 
 static FontGroup* font_groups = NULL;
@@ -132,20 +162,13 @@ font_group_is_unused(FontGroup *fg) {
 
 void
 free_maps(Font *font) {
-#define free_a_map(type, attr) {\
-    type *s, *t; \
-    for (size_t i = 0; i < sizeof(font->attr)/sizeof(font->attr[0]); i++) { \
-        s = font->attr[i].next; \
-        while (s) { \
-            t = s; \
-            s = s->next; \
-            free(t); \
-        } \
-    }\
-    memset(font->attr, 0, sizeof(font->attr)); \
-}
-    free_a_map(SpritePosition, sprite_map);
-    free_a_map(SpecialGlyphCache, special_glyph_cache);
+#define free_a_map(attr) {\
+    for (size_t i = 0; i < font->attr.capacity; i++) free(font->attr.entries[i]); \
+    free(font->attr.entries); \
+    zero_at_ptr(&font->attr); \
+}
+    free_a_map(sprite_map);
+    free_a_map(special_glyph_cache);
 #undef free_a_map
 }
 
@@ -163,26 +186,36 @@ del_font_group(FontGroup *fg) {
     fg->sprite_map = free_sprite_map(fg->sprite_map);
     for (size_t i = 0; i < fg->fonts_count; i++) del_font(fg->fonts + i);
     free(fg->fonts); fg->fonts = NULL;
+    for (size_t i = 0; i < fg->fallback_font_map.capacity; i++) free(fg->fallback_font_map.entries[i]);
+    free(fg->fallback_font_map.entries);
+    zero_at_ptr(&fg->fallback_font_map);
 }
 
+// How long a font group no window uses anymore is kept alive. Short lived OS
+// windows at a previously seen size/dpi then find their fully warmed up group
+// (fonts, sprite textures, caches) still present instead of rebuilding it.
+#define UNUSED_FONT_GROUP_LINGER s_double_to_monotonic_t(30.0)
+
 static inline void
 trim_unused_font_groups(void) {
     save_window_font_groups();
+    monotonic_t now = monotonic();
     size_t i = 0;
     while (i < num_font_groups) {
-        if (font_group_is_unused(font_groups + i)) {
-            del_font_group(font_groups + i);
-            size_t num_to_right = (--num_font_groups) - i;
-            if (!num_to_right) break;
-            memmove(font_groups + i, font_groups + 1 + i, num_to_right * sizeof(FontGroup));
-        } else i++;
+        FontGroup *fg = font_groups + i;
+        if (!font_group_is_unused(fg)) { fg->unused_since = 0; i++; continue; }
+        if (!fg->unused_since) { fg->unused_since = now; i++; continue; }
+        if (now - fg->unused_since < UNUSED_FONT_GROUP_LINGER) { i++; continue; }
+        del_font_group(fg);
+        size_t num_to_right = (--num_font_groups) - i;
+        if (!num_to_right) break;
+        memmove(font_groups + i, font_groups + 1 + i, num_to_right * sizeof(FontGroup));
     }
     restore_window_font_groups();
 }
 
 static inline void
 add_font_group(void) {
-    if (num_font_groups) trim_unused_font_groups();
     if (num_font_groups >= font_groups_capacity) {
         save_window_font_groups();
         font_groups_capacity += 5;
@@ -195,9 +228,10 @@ add_font_group(void) {
 
 static inline FontGroup*
 font_group_for(double font_sz_in_pts, double logical_dpi_x, double logical_dpi_y) {
+    if (num_font_groups) trim_unused_font_groups();
     for (size_t i = 0; i < num_font_groups; i++) {
         FontGroup *fg = font_groups + i;
-        if (fg->font_sz_in_pts == font_sz_in_pts && fg->logical_dpi_x == logical_dpi_x && fg->logical_dpi_y == logical_dpi_y) return fg;
+        if (fg->font_sz_in_pts == font_sz_in_pts && fg->logical_dpi_x == logical_dpi_x && fg->logical_dpi_y == logical_dpi_y) { fg->unused_since = 0; return fg; }
     }
     add_font_group();
     FontGroup *fg = font_groups + num_font_groups - 1;
@@ -261,55 +295,97 @@ extra_glyphs_equal(ExtraGlyphs *a, ExtraGlyphs *b) {
 }
 
 
+static inline uint64_t
+sprite_key_hash(glyph_index glyph, const ExtraGlyphs *extra_glyphs, uint8_t ligature_index) {
+    // FNV-1a over (glyph, extra_glyphs up to the first zero, ligature_index),
+    // consistent with extra_glyphs_equal() which stops at the first zero
+    uint64_t h = 0xcbf29ce484222325ull;
+#define STEP(x) { h ^= (uint64_t)(x); h *= 0x100000001b3ull; }
+    STEP(glyph);
+    for (size_t i = 0; i < MAX_NUM_EXTRA_GLYPHS && extra_glyphs->data[i]; i++) STEP(extra_glyphs->data[i]);
+    STEP(ligature_index);
+#undef STEP
+    return h;
+}
+
+static bool
+sprite_map_grow(SpriteMap *map) {
+    size_t capacity = map->capacity ? 2 * map->capacity : 1024u;
+    SpritePosition **entries = calloc(capacity, sizeof(SpritePosition*));
+    if (entries == NULL) return false;
+    for (size_t i = 0; i < map->capacity; i++) {
+        SpritePosition *s = map->entries[i];
+        if (!s) continue;
+        size_t j = sprite_key_hash(s->glyph, &s->extra_glyphs, s->ligature_index) & (capacity - 1);
+        while (entries[j]) j = (j + 1) & (capacity - 1);
+        entries[j] = s;
+    }
+    free(map->entries);
+    map->entries = entries; map->capacity = capacity;
+    return true;
+}
+
 static SpritePosition*
 sprite_position_for(FontGroup *fg, Font *font, glyph_index glyph, ExtraGlyphs *extra_glyphs, uint8_t ligature_index, int *error) {
-    glyph_index idx = glyph & (SPECIAL_GLYPH_CACHE_SIZE - 1);
-    SpritePosition *s = font->sprite_map + idx;
-    // Optimize for the common case of glyph under 1024 already in the cache
-    if (LIKELY(s->glyph == glyph && s->filled && extra_glyphs_equal(&s->extra_glyphs, extra_glyphs) && s->ligature_index == ligature_index)) return s;  // Cache hit
-    while(true) {
-        if (s->filled) {
-            if (s->glyph == glyph && extra_glyphs_equal(&s->extra_glyphs, extra_glyphs) && s->ligature_index == ligature_index) return s;  // Cache hit
-        } else {
-            break;
-        }
-        if (!s->next) {
-            s->next = calloc(1, sizeof(SpritePosition));
-            if (s->next == NULL) { *error = 1; return NULL; }
+    SpriteMap *map = &font->sprite_map;
+    // grow at 3/4 occupancy to keep probe sequences short
+    if (UNLIKELY(4 * (map->count + 1) > 3 * map->capacity)) {
+        if (!sprite_map_grow(map)) { *error = 1; return NULL; }
+    }
+    const size_t mask = map->capacity - 1;
+    for (size_t i = sprite_key_hash(glyph, extra_glyphs, ligature_index) & mask; ; i = (i + 1) & mask) {
+        SpritePosition *s = map->entries[i];
+        if (s == NULL) {  // Cache miss
+            s = calloc(1, sizeof(SpritePosition));
+            if (s == NULL) { *error = 1; return NULL; }
+            map->entries[i] = s; map->count++;
+            s->glyph = glyph;
+            memcpy(&s->extra_glyphs, extra_glyphs, sizeof(ExtraGlyphs));
+            s->ligature_index = ligature_index;
+            s->filled = true;
+            s->x = fg->sprite_tracker.x; s->y = fg->sprite_tracker.y; s->z = fg->sprite_tracker.z;
+            do_increment(fg, error);
+            return s;
         }
-        s = s->next;
+        if (s->glyph == glyph && extra_glyphs_equal(&s->extra_glyphs, extra_glyphs) && s->ligature_index == ligature_index) return s;  // Cache hit
     }
-    s->glyph = glyph;
-    memcpy(&s->extra_glyphs, extra_glyphs, sizeof(ExtraGlyphs));
-    s->ligature_index = ligature_index;
-    s->filled = true;
-    s->rendered = false;
-    s->colored = false;
-    s->x = fg->sprite_tracker.x; s->y = fg->sprite_tracker.y; s->z = fg->sprite_tracker.z;
-    do_increment(fg, error);
-    return s;
+}
+
+static bool
+special_glyph_map_grow(SpecialGlyphMap *map) {
+    size_t capacity = map->capacity ? 2 * map->capacity : SPECIAL_GLYPH_CACHE_SIZE;
+    SpecialGlyphCache **entries = calloc(capacity, sizeof(SpecialGlyphCache*));
+    if (entries == NULL) return false;
+    for (size_t i = 0; i < map->capacity; i++) {
+        SpecialGlyphCache *s = map->entries[i];
+        if (!s) continue;
+        size_t j = sprite_key_hash(s->glyph, &(ExtraGlyphs){{0}}, 0) & (capacity - 1);
+        while (entries[j]) j = (j + 1) & (capacity - 1);
+        entries[j] = s;
+    }
+    free(map->entries);
+    map->entries = entries; map->capacity = capacity;
+    return true;
 }
 
 static inline SpecialGlyphCache*
-special_glyph_cache_for(Font *font, glyph_index glyph, uint8_t filled_mask) {
-    SpecialGlyphCache *s = font->special_glyph_cache + (glyph & 0x3ff);
-    // Optimize for the common case of glyph under SPECIAL_GLYPH_CACHE_SIZE already in the cache
-    if (LIKELY(s->glyph == glyph && s->data & filled_mask)) return s;  // Cache hit
-    while(true) {
-        if (s->data & filled_mask) {
-            if (s->glyph == glyph) return s;  // Cache hit
-        } else {
-            if (!s->glyph) break;  // Empty cache slot
-            else if (s->glyph == glyph) return s;  // Cache slot that contains other data than the data indicated by filled_mask
-        }
-        if (!s->next) {
-            s->next = calloc(1, sizeof(SpecialGlyphCache));
-            if (s->next == NULL) return NULL;
+special_glyph_cache_for(Font *font, glyph_index glyph, uint8_t filled_mask UNUSED) {
+    SpecialGlyphMap *map = &font->special_glyph_cache;
+    if (UNLIKELY(4 * (map->count + 1) > 3 * map->capacity)) {
+        if (!special_glyph_map_grow(map)) return NULL;
+    }
+    const size_t mask = map->capacity - 1;
+    for (size_t i = sprite_key_hash(glyph, &(ExtraGlyphs){{0}}, 0) & mask; ; i = (i + 1) & mask) {
+        SpecialGlyphCache *s = map->entries[i];
+        if (s == NULL) {  // Cache miss, the caller fills in data
+            s = calloc(1, sizeof(SpecialGlyphCache));
+            if (s == NULL) return NULL;
+            map->entries[i] = s; map->count++;
+            s->glyph = glyph;
+            return s;
         }
-        s = s->next;
+        if (s->glyph == glyph) return s;  // Cache hit, possibly with data other than what filled_mask indicates
     }
-    s->glyph = glyph;
-    return s;
 }
 
 void
@@ -320,30 +396,16 @@ sprite_tracker_current_layout(FONTS_DATA_HANDLE data, unsigned int *x, unsigned
 
 void
 clear_sprite_map(Font *font) {
-#define CLEAR(s) s->filled = false; s->rendered = false; s->colored = false; s->glyph = 0; zero_at_ptr(&s->extra_glyphs); s->x = 0; s->y = 0; s->z = 0; s->ligature_index = 0;
-    SpritePosition *s;
-    for (size_t i = 0; i < sizeof(font->sprite_map)/sizeof(font->sprite_map[0]); i++) {
-        s = font->sprite_map + i;
-        CLEAR(s);
-        while ((s = s->next)) {
-            CLEAR(s);
-        }
-    }
-#undef CLEAR
+    SpriteMap *map = &font->sprite_map;
+    for (size_t i = 0; i < map->capacity; i++) { free(map->entries[i]); map->entries[i] = NULL; }
+    map->count = 0;
 }
 
 void
 clear_special_glyph_cache(Font *font) {
-#define CLEAR(s) s->data = 0; s->glyph = 0;
-    SpecialGlyphCache *s;
-    for (size_t i = 0; i < sizeof(font->special_glyph_cache)/sizeof(font->special_glyph_cache[0]); i++) {
-        s = font->special_glyph_cache + i;
-        CLEAR(s);
-        while ((s = s->next)) {
-            CLEAR(s);
-        }
-    }
-#undef CLEAR
+    SpecialGlyphMap *map = &font->special_glyph_cache;
+    for (size_t i = 0; i < map->capacity; i++) { free(map->entries[i]); map->entries[i] = NULL; }
+    map->count = 0;
 }
 
 static void
@@ -370,6 +432,9 @@ init_font(Font *f, PyObject *face, bool bold, bool italic, bool emoji_presentati
     f->bold = bold; f->italic = italic; f->emoji_presentation = emoji_presentation;
     f->num_ffs_hb_features = 0;
     const char *psname = postscript_name_for_face(face);
+    f->face_key = 0xcbf29ce484222325ull;
+    for (const char *p = psname; *p; p++) { f->face_key ^= (uint64_t)(uint8_t)*p; f->face_key *= 0x100000001b3ull; }
+    f->face_key ^= (bold ? 1u : 0u) | (italic ? 2u : 0u); f->face_key *= 0x100000001b3ull;
     if (font_feature_settings != NULL){
         PyObject* o = PyDict_GetItemString(font_feature_settings, psname);
         if (o != NULL && PyTuple_Check(o)) {
@@ -469,17 +534,18 @@ face_has_codepoint(PyObject* face, char_type cp) {
 
 static inline bool
 has_emoji_presentation(CPUCell *cpu_cell, GPUCell *gpu_cell) {
-    return (gpu_cell->attrs & WIDTH_MASK) == 2 && is_emoji(cpu_cell->ch) && cpu_cell->cc_idx[0] != VS15;
+    return (gpu_cell->attrs & WIDTH_MASK) == 2 && is_emoji(cpu_cell->ch) && first_combining_mark(cpu_cell->cc_idx) != VS15;
 }
 
 static inline bool
 has_cell_text(Font *self, CPUCell *cell) {
     if (!face_has_codepoint(self->face, cell->ch)) return false;
-    char_type combining_chars[arraysz(cell->cc_idx)];
+    char_type combining_chars[MAX_COMBINING_CHARS_PER_CELL];
     unsigned num_cc = 0;
-    for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) {
-        if (cell->cc_idx[i] == VS15 || cell->cc_idx[i] == VS16) continue;
-        combining_chars[num_cc++] = codepoint_for_mark(cell->cc_idx[i]);
+    for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) {
+        combining_type m = combining_mark_at(cell->cc_idx, i);
+        if (m == VS15 || m == VS16) continue;
+        combining_chars[num_cc++] = codepoint_for_mark(m);
     }
     if (num_cc == 0) return true;
     if (num_cc == 1) {
@@ -497,8 +563,8 @@ has_cell_text(Font *self, CPUCell *cell) {
 static inline void
 output_cell_fallback_data(CPUCell *cell, bool bold, bool italic, bool emoji_presentation, PyObject *face, bool new_face) {
     printf("U+%x ", cell->ch);
-    for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) {
-        printf("U+%x ", codepoint_for_mark(cell->cc_idx[i]));
+    for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) {
+        printf("U+%x ", codepoint_for_mark(combining_mark_at(cell->cc_idx, i)));
     }
     if (bold) printf("bold ");
     if (italic) printf("italic ");
@@ -532,8 +598,8 @@ load_fallback_font(FontGroup *fg, CPUCell *cell, bool bold, bool italic, bool em
         if (global_state.debug_font_fallback) {
             printf("The font chosen by the OS for the text: ");
             printf("U+%x ", cell->ch);
-            for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) {
-                printf("U+%x ", codepoint_for_mark(cell->cc_idx[i]));
+            for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) {
+                printf("U+%x ", codepoint_for_mark(combining_mark_at(cell->cc_idx, i)));
             }
             printf("is ");
             PyObject_Print(af->face, stdout, 0);
@@ -547,22 +613,93 @@ load_fallback_font(FontGroup *fg, CPUCell *cell, bool bold, bool italic, bool em
     return ans;
 }
 
+// Fallback font resolution is expensive: a linear scan over the loaded
+// fallback fonts probing each face and, on a complete miss, a fontconfig
+// query through Python. Without memoization both costs recur every time a
+// cell with the same text is re-shaped, so resolved indices (including
+// MISSING_FONT) are cached per font group, keyed on the cell text and style.
+
+static inline uint64_t
+fallback_key_hash(const CPUCell *cell, bool bold, bool italic, bool emoji_presentation) {
+    uint64_t h = 0xcbf29ce484222325ull;
+#define STEP(x) { h ^= (uint64_t)(x); h *= 0x100000001b3ull; }
+    STEP(cell->ch);
+    STEP(cell->cc_idx);
+    STEP((bold ? 4 : 0) | (italic ? 2 : 0) | (emoji_presentation ? 1 : 0));
+#undef STEP
+    return h;
+}
+
+static bool
+fallback_font_map_grow(FallbackFontMap *map) {
+    size_t capacity = map->capacity ? 2 * map->capacity : 256u;
+    FallbackFontEntry **entries = calloc(capacity, sizeof(FallbackFontEntry*));
+    if (entries == NULL) return false;
+    for (size_t i = 0; i < map->capacity; i++) {
+        FallbackFontEntry *e = map->entries[i];
+        if (!e) continue;
+        CPUCell cell = {.ch=e->ch, .cc_idx=e->cc_idx};
+        size_t j = fallback_key_hash(&cell, e->bold, e->italic, e->emoji_presentation) & (capacity - 1);
+        while (entries[j]) j = (j + 1) & (capacity - 1);
+        entries[j] = e;
+    }
+    free(map->entries);
+    map->entries = entries;
+    map->capacity = capacity;
+    return true;
+}
+
+static FallbackFontEntry*
+fallback_font_map_for(FontGroup *fg, const CPUCell *cell, bool bold, bool italic, bool emoji_presentation, bool *created) {
+    FallbackFontMap *map = &fg->fallback_font_map;
+    *created = false;
+    if (4 * (map->count + 1) > 3 * map->capacity) {
+        if (!fallback_font_map_grow(map)) return NULL;
+    }
+    size_t mask = map->capacity - 1;
+    size_t i = fallback_key_hash(cell, bold, italic, emoji_presentation) & mask;
+    for (; map->entries[i] != NULL; i = (i + 1) & mask) {
+        FallbackFontEntry *e = map->entries[i];
+        // chain ids are interned, so equal content means equal id
+        if (e->ch == cell->ch && e->cc_idx == cell->cc_idx &&
+            e->bold == bold && e->italic == italic && e->emoji_presentation == emoji_presentation) return e;
+    }
+    FallbackFontEntry *e = calloc(1, sizeof(FallbackFontEntry));
+    if (e == NULL) return NULL;
+    e->ch = cell->ch;
+    e->cc_idx = cell->cc_idx;
+    e->bold = bold; e->italic = italic; e->emoji_presentation = emoji_presentation;
+    map->entries[i] = e;
+    map->count++;
+    *created = true;
+    return e;
+}
+
 static inline ssize_t
 fallback_font(FontGroup *fg, CPUCell *cpu_cell, GPUCell *gpu_cell) {
     bool bold = (gpu_cell->attrs >> BOLD_SHIFT) & 1;
     bool italic = (gpu_cell->attrs >> ITALIC_SHIFT) & 1;
     bool emoji_presentation = has_emoji_presentation(cpu_cell, gpu_cell);
+    bool created;
+    FallbackFontEntry *e = fallback_font_map_for(fg, cpu_cell, bold, italic, emoji_presentation, &created);
+    if (e && !created) {
+        if (global_state.debug_font_fallback && e->font_idx > -1) output_cell_fallback_data(cpu_cell, bold, italic, emoji_presentation, fg->fonts[e->font_idx].face, false);
+        return e->font_idx;
+    }
 
+    ssize_t ans = MISSING_FONT;
     // Check if one of the existing fallback fonts has this text
     for (size_t i = 0, j = fg->first_fallback_font_idx; i < fg->fallback_fonts_count; i++, j++)  {
         Font *ff = fg->fonts +j;
         if (ff->bold == bold && ff->italic == italic && ff->emoji_presentation == emoji_presentation && has_cell_text(ff, cpu_cell)) {
             if (global_state.debug_font_fallback) output_cell_fallback_data(cpu_cell, bold, italic, emoji_presentation, ff->face, false);
-            return j;
+            ans = j;
+            break;
         }
     }
-
-    return load_fallback_font(fg, cpu_cell, bold, italic, emoji_presentation);
+    if (ans == MISSING_FONT) ans = load_fallback_font(fg, cpu_cell, bold, italic, emoji_presentation);
+    if (e) e->font_idx = ans;
+    return ans;
 }
 
 static inline ssize_t
@@ -693,20 +830,29 @@ render_box_cell(FontGroup *fg, CPUCell *cpu_cell, GPUCell *gpu_cell) {
     Py_DECREF(ret);
 }
 
+static inline index_type
+serialize_run_codepoints(CPUCell **cpu_cell, GPUCell **gpu_cell, index_type *num_cells, char_type *buf, index_type limit) {
+    // Write the codepoint sequence harfbuzz should shape for a run of cells
+    // into buf, advancing the cell pointers past the cells consumed
+    index_type num = 0;
+    attrs_type prev_width = 0;
+    for (; *num_cells && num < limit; (*cpu_cell)++, (*gpu_cell)++, (*num_cells)--) {
+        if (prev_width == 2) { prev_width = 0; continue; }
+        buf[num++] = (*cpu_cell)->ch;
+        prev_width = (*gpu_cell)->attrs & WIDTH_MASK;
+        for (unsigned i = 0, cn = num_combining_marks((*cpu_cell)->cc_idx); i < cn; i++) {
+            buf[num++] = codepoint_for_mark(combining_mark_at((*cpu_cell)->cc_idx, i));
+        }
+    }
+    return num;
+}
+
 static inline void
 load_hb_buffer(CPUCell *first_cpu_cell, GPUCell *first_gpu_cell, index_type num_cells) {
     index_type num;
     hb_buffer_clear_contents(harfbuzz_buffer);
     while (num_cells) {
-        attrs_type prev_width = 0;
-        for (num = 0; num_cells && num < arraysz(shape_buffer) - 20 - arraysz(first_cpu_cell->cc_idx); first_cpu_cell++, first_gpu_cell++, num_cells--) {
-            if (prev_width == 2) { prev_width = 0; continue; }
-            shape_buffer[num++] = first_cpu_cell->ch;
-            prev_width = first_gpu_cell->attrs & WIDTH_MASK;
-            for (unsigned i = 0; i < arraysz(first_cpu_cell->cc_idx) && first_cpu_cell->cc_idx[i]; i++) {
-                shape_buffer[num++] = codepoint_for_mark(first_cpu_cell->cc_idx[i]);
-            }
-        }
+        num = serialize_run_codepoints(&first_cpu_cell, &first_gpu_cell, &num_cells, shape_buffer, arraysz(shape_buffer) - 20 - MAX_COMBINING_CHARS_PER_CELL);
         hb_buffer_add_utf32(harfbuzz_buffer, shape_buffer, num, 0, num);
     }
     hb_buffer_guess_segment_properties(harfbuzz_buffer);
@@ -720,6 +866,110 @@ set_cell_sprite(GPUCell *cell, SpritePosition *sp) {
     if (sp->colored) cell->sprite_z |= 0x4000;
 }
 
+// Rendered glyph bitmap cache {{{
+// Rasterized sprites are kept in a DiskCache keyed by face, cell geometry and
+// glyph key, so that when the sprite maps are dropped (font or window resize,
+// font group rebuild) previously seen glyphs are blitted from the cache
+// instead of going through shaping and rasterization again. The cache lives
+// in an unlinked temp file, so it costs almost no RSS and vanishes with the
+// process.
+static PyObject *glyph_bitmap_cache = NULL;
+
+typedef struct {
+    uint64_t face_key;
+    uint32_t cell_width, cell_height, baseline;
+    glyph_index glyph;
+    ExtraGlyphs extra_glyphs;
+    uint8_t ligature_index;
+} GlyphBitmapCacheKey;
+
+static inline void
+glyph_bitmap_cache_key(GlyphBitmapCacheKey *key, FontGroup *fg, Font *font, glyph_index glyph, ExtraGlyphs *extra_glyphs, uint8_t ligature_index) {
+    memset(key, 0, sizeof(*key));  // padding bytes are part of the hash key
+    key->face_key = font->face_key;
+    key->cell_width = fg->cell_width; key->cell_height = fg->cell_height; key->baseline = fg->baseline;
+    key->glyph = glyph;
+    memcpy(&key->extra_glyphs, extra_glyphs, sizeof(ExtraGlyphs));
+    key->ligature_index = ligature_index;
+}
+
+static bool
+send_sprite_from_bitmap_cache(FontGroup *fg, Font *font, SpritePosition *sp, glyph_index glyph, ExtraGlyphs *extra_glyphs, bool *was_colored) {
+    if (!glyph_bitmap_cache || !font->face_key) return false;
+    GlyphBitmapCacheKey key;
+    glyph_bitmap_cache_key(&key, fg, font, glyph, extra_glyphs, sp->ligature_index);
+    // the colored flag is stored after the bitmap, so the pixel data stays aligned
+    const size_t expected_sz = (size_t)fg->cell_width * fg->cell_height * sizeof(pixel) + 1;
+    static uint8_t *data = NULL; static size_t data_sz = 0;
+    if (data_sz < expected_sz) {
+        uint8_t *q = realloc(data, expected_sz);
+        if (!q) return false;
+        data = q; data_sz = expected_sz;
+    }
+    // reads into our reused buffer, failing if the cached size does not match
+    if (!read_from_disk_cache_into(glyph_bitmap_cache, &key, sizeof(key), data, expected_sz)) { PyErr_Clear(); return false; }
+    *was_colored = data[expected_sz - 1] != 0;
+    current_send_sprite_to_gpu((FONTS_DATA_HANDLE)fg, sp->x, sp->y, sp->z, (pixel*)data);
+    return true;
+}
+
+static void
+add_sprite_to_bitmap_cache(FontGroup *fg, Font *font, glyph_index glyph, ExtraGlyphs *extra_glyphs, uint8_t ligature_index, bool was_colored, const pixel *buf) {
+    if (!font->face_key) return;
+    if (!glyph_bitmap_cache) {
+        glyph_bitmap_cache = create_disk_cache();
+        if (!glyph_bitmap_cache) { PyErr_Clear(); return; }
+    }
+    GlyphBitmapCacheKey key;
+    glyph_bitmap_cache_key(&key, fg, font, glyph, extra_glyphs, ligature_index);
+    const size_t bitmap_sz = (size_t)fg->cell_width * fg->cell_height * sizeof(pixel);
+    uint8_t *data = malloc(bitmap_sz + 1);
+    if (!data) return;
+    memcpy(data, buf, bitmap_sz);
+    data[bitmap_sz] = was_colored ? 1 : 0;
+    if (!add_to_disk_cache(glyph_bitmap_cache, &key, sizeof(key), data, bitmap_sz + 1)) PyErr_Clear();
+    free(data);
+}
+// }}}
+
+// Frame budgeted rasterization {{{
+// Rasterizing a screenful of never before seen glyphs (paging through CJK
+// text) inside a single frame causes a visible frame time spike. Instead of
+// moving rasterization to other threads, which would race with HarfBuzz
+// using the same faces and require sprite uploads away from the GL context,
+// the cell data update arms a time budget. Once it is exhausted render_group
+// uploads blank placeholder sprites, leaves the glyphs marked unrendered and
+// the lines dirty, and the remainder is rasterized over the following
+// frames.
+#define GLYPH_RASTER_FRAME_BUDGET ms_to_monotonic_t(5ll)
+static monotonic_t glyph_raster_deadline = 0;  // 0 means unbudgeted
+static bool glyph_raster_deferred = false;
+
+void
+begin_frame_glyph_rasterization(void) {
+    glyph_raster_deadline = monotonic() + GLYPH_RASTER_FRAME_BUDGET;
+}
+
+void
+end_frame_glyph_rasterization(void) {
+    glyph_raster_deadline = 0;
+}
+
+static inline bool
+glyph_raster_budget_exhausted(void) {
+    return glyph_raster_deadline && monotonic() > glyph_raster_deadline;
+}
+
+// When a screen is scrolling much faster than it renders, frames are drawn
+// without HarfBuzz shaping, using the nominal glyph of each cell's base
+// codepoint instead, see render_cells_degraded(). The caller re-renders the
+// resting screenful with full shaping once the flood subsides.
+static bool degraded_text_shaping = false;
+
+void
+set_degraded_text_shaping(bool on) { degraded_text_shaping = on; }
+// }}}
+
 static inline pixel*
 extract_cell_from_canvas(FontGroup *fg, unsigned int i, unsigned int num_cells) {
     pixel *ans = fg->canvas + (fg->cell_width * fg->cell_height * (CELLS_IN_CANVAS - 1)), *dest = ans, *src = fg->canvas + (i * fg->cell_width);
@@ -742,8 +992,34 @@ render_group(FontGroup *fg, unsigned int num_cells, unsigned int num_glyphs, CPU
         return;
     }
 
-    clear_canvas(fg);
     bool was_colored = (gpu_cells->attrs & WIDTH_MASK) == 2 && is_emoji(cpu_cells->ch);
+    unsigned int num_from_cache = 0;
+    while (num_from_cache < num_cells && send_sprite_from_bitmap_cache(fg, font, sprite_position[num_from_cache], glyph, extra_glyphs, &was_colored)) num_from_cache++;
+    if (num_from_cache == num_cells) {
+        for (unsigned int i = 0; i < num_cells; i++) {
+            sprite_position[i]->rendered = true;
+            sprite_position[i]->colored = was_colored;
+            set_cell_sprite(gpu_cells + i, sprite_position[i]);
+        }
+        return;
+    }
+    if (glyph_raster_budget_exhausted()) {
+        // out of budget for this frame: upload blank placeholders, leave the
+        // sprites unrendered and finish the group on a later frame
+        clear_canvas(fg);
+        for (unsigned int i = 0; i < num_cells; i++) {
+            set_cell_sprite(gpu_cells + i, sprite_position[i]);
+            current_send_sprite_to_gpu((FONTS_DATA_HANDLE)fg, sprite_position[i]->x, sprite_position[i]->y, sprite_position[i]->z, fg->canvas);
+        }
+        glyph_raster_deferred = true;
+        return;
+    }
+
+    // a partial cache hit just re-renders the whole group, the sprites sent
+    // from the cache above are simply overwritten
+    was_colored = (gpu_cells->attrs & WIDTH_MASK) == 2 && is_emoji(cpu_cells->ch);
+
+    clear_canvas(fg);
     render_glyphs_in_cells(font->face, font->bold, font->italic, info, positions, num_glyphs, fg->canvas, fg->cell_width, fg->cell_height, num_cells, fg->baseline, &was_colored, (FONTS_DATA_HANDLE)fg, center_glyph);
     if (PyErr_Occurred()) PyErr_Print();
 
@@ -753,6 +1029,7 @@ render_group(FontGroup *fg, unsigned int num_cells, unsigned int num_glyphs, CPU
         set_cell_sprite(gpu_cells + i, sprite_position[i]);
         pixel *buf = num_cells == 1 ? fg->canvas : extract_cell_from_canvas(fg, i, num_cells);
         current_send_sprite_to_gpu((FONTS_DATA_HANDLE)fg, sprite_position[i]->x, sprite_position[i]->y, sprite_position[i]->z, buf);
+        add_sprite_to_bitmap_cache(fg, font, glyph, extra_glyphs, sprite_position[i]->ligature_index, was_colored, buf);
     }
 
 }
@@ -786,11 +1063,130 @@ static GroupState group_state = {0};
 
 static inline unsigned int
 num_codepoints_in_cell(CPUCell *cell) {
-    unsigned int ans = 1;
-    for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) ans++;
-    return ans;
+    return 1 + num_combining_marks(cell->cc_idx);
+}
+
+// Shaped run cache {{{
+// Identical runs of text (keywords, prompts, log prefixes) are shaped over
+// and over as lines are rendered. Shaping output depends only on the
+// codepoint sequence, the face, its scale and the feature set, so we cache
+// the glyph info and position arrays keyed on those and skip hb_shape()
+// entirely on a hit. The cache is cleared wholesale when it reaches
+// MAX_SHAPED_RUNS entries, which bounds it to a few MB.
+
+typedef struct {
+    uint64_t face_key;
+    int x_scale, y_scale;
+    bool ligatures_disabled, forced_ltr, filled;
+    unsigned int num_codepoints, num_glyphs;
+    char_type *codepoints;
+    hb_glyph_info_t *info;
+    hb_glyph_position_t *positions;
+} ShapedRun;
+
+typedef struct {
+    ShapedRun **entries;
+    size_t capacity, count;
+} ShapedRunCache;
+
+static ShapedRunCache shaped_run_cache = {0};
+#define MAX_SHAPED_RUNS 4096u
+
+static inline uint64_t
+shaped_run_hash(uint64_t face_key, int x_scale, int y_scale, const char_type *codepoints, unsigned int num_codepoints, bool ligatures_disabled, bool forced_ltr) {
+    uint64_t h = 0xcbf29ce484222325ull;
+#define STEP(x) { h ^= (uint64_t)(x); h *= 0x100000001b3ull; }
+    STEP(face_key); STEP(x_scale); STEP(y_scale);
+    STEP((ligatures_disabled ? 2 : 0) | (forced_ltr ? 1 : 0));
+    for (unsigned int i = 0; i < num_codepoints; i++) STEP(codepoints[i]);
+#undef STEP
+    return h;
+}
+
+static void
+free_shaped_run(ShapedRun *sr) {
+    free(sr->codepoints); free(sr->info); free(sr->positions); free(sr);
+}
+
+static void
+clear_shaped_run_cache(void) {
+    for (size_t i = 0; i < shaped_run_cache.capacity; i++) {
+        if (shaped_run_cache.entries[i]) { free_shaped_run(shaped_run_cache.entries[i]); shaped_run_cache.entries[i] = NULL; }
+    }
+    shaped_run_cache.count = 0;
+}
+
+static bool
+shaped_run_cache_grow(void) {
+    size_t capacity = shaped_run_cache.capacity ? 2 * shaped_run_cache.capacity : 1024u;
+    ShapedRun **entries = calloc(capacity, sizeof(ShapedRun*));
+    if (entries == NULL) return false;
+    for (size_t i = 0; i < shaped_run_cache.capacity; i++) {
+        ShapedRun *sr = shaped_run_cache.entries[i];
+        if (!sr) continue;
+        size_t j = shaped_run_hash(sr->face_key, sr->x_scale, sr->y_scale, sr->codepoints, sr->num_codepoints, sr->ligatures_disabled, sr->forced_ltr) & (capacity - 1);
+        while (entries[j]) j = (j + 1) & (capacity - 1);
+        entries[j] = sr;
+    }
+    free(shaped_run_cache.entries);
+    shaped_run_cache.entries = entries;
+    shaped_run_cache.capacity = capacity;
+    return true;
+}
+
+static ShapedRun*
+shaped_run_cache_for(hb_font_t *hb_font, Font *fobj, const char_type *codepoints, unsigned int num_codepoints, bool disable_ligature) {
+    // Returns the cache entry for the specified run, creating an unfilled one
+    // if not present. NULL means: shape without caching.
+    if (!fobj->face_key || !num_codepoints) return NULL;
+    int x_scale, y_scale;
+    hb_font_get_scale(hb_font, &x_scale, &y_scale);
+    bool forced_ltr = OPT(force_ltr) != 0;
+    if (4 * (shaped_run_cache.count + 1) > 3 * shaped_run_cache.capacity) {
+        if (!shaped_run_cache_grow()) return NULL;
+    }
+    uint64_t hash = shaped_run_hash(fobj->face_key, x_scale, y_scale, codepoints, num_codepoints, disable_ligature, forced_ltr);
+    size_t mask = shaped_run_cache.capacity - 1;
+    size_t i = hash & mask;
+    for (; shaped_run_cache.entries[i] != NULL; i = (i + 1) & mask) {
+        ShapedRun *sr = shaped_run_cache.entries[i];
+        if (sr->face_key == fobj->face_key && sr->x_scale == x_scale && sr->y_scale == y_scale &&
+            sr->ligatures_disabled == disable_ligature && sr->forced_ltr == forced_ltr &&
+            sr->num_codepoints == num_codepoints && memcmp(sr->codepoints, codepoints, num_codepoints * sizeof(char_type)) == 0) return sr;
+    }
+    if (shaped_run_cache.count >= MAX_SHAPED_RUNS) {
+        // Unlikely in practice: a terminal rarely displays this many distinct
+        // runs. Discarding everything is simpler than tracking use recency.
+        clear_shaped_run_cache();
+        i = hash & mask;
+    }
+    ShapedRun *sr = calloc(1, sizeof(ShapedRun));
+    if (sr == NULL) return NULL;
+    sr->codepoints = malloc(num_codepoints * sizeof(char_type));
+    if (sr->codepoints == NULL) { free(sr); return NULL; }
+    memcpy(sr->codepoints, codepoints, num_codepoints * sizeof(char_type));
+    sr->num_codepoints = num_codepoints;
+    sr->face_key = fobj->face_key; sr->x_scale = x_scale; sr->y_scale = y_scale;
+    sr->ligatures_disabled = disable_ligature; sr->forced_ltr = forced_ltr;
+    shaped_run_cache.entries[i] = sr;
+    shaped_run_cache.count++;
+    return sr;
 }
 
+static void
+fill_shaped_run(ShapedRun *sr, const hb_glyph_info_t *info, const hb_glyph_position_t *positions, unsigned int num_glyphs) {
+    if (num_glyphs) {
+        sr->info = malloc(num_glyphs * sizeof(hb_glyph_info_t));
+        sr->positions = malloc(num_glyphs * sizeof(hb_glyph_position_t));
+        if (!sr->info || !sr->positions) { free(sr->info); sr->info = NULL; free(sr->positions); sr->positions = NULL; return; }
+        memcpy(sr->info, info, num_glyphs * sizeof(hb_glyph_info_t));
+        memcpy(sr->positions, positions, num_glyphs * sizeof(hb_glyph_position_t));
+    }
+    sr->num_glyphs = num_glyphs;
+    sr->filled = true;
+}
+// }}}
+
 static inline void
 shape(CPUCell *first_cpu_cell, GPUCell *first_gpu_cell, index_type num_cells, hb_font_t *font, Font *fobj, bool disable_ligature) {
     if (group_state.groups_capacity <= 2 * num_cells) {
@@ -815,7 +1211,26 @@ shape(CPUCell *first_cpu_cell, GPUCell *first_gpu_cell, index_type num_cells, hb
     group_state.first_gpu_cell = first_gpu_cell;
     group_state.last_cpu_cell = first_cpu_cell + (num_cells ? num_cells - 1 : 0);
     group_state.last_gpu_cell = first_gpu_cell + (num_cells ? num_cells - 1 : 0);
-    load_hb_buffer(first_cpu_cell, first_gpu_cell, num_cells);
+
+    // Serialize the run and look for a previously cached shaping of it. Runs
+    // too long for shape_buffer are shaped in chunks without caching.
+    CPUCell *cpu_cell = first_cpu_cell; GPUCell *gpu_cell = first_gpu_cell;
+    index_type cells_left = num_cells;
+    index_type num_codepoints = serialize_run_codepoints(&cpu_cell, &gpu_cell, &cells_left, shape_buffer, arraysz(shape_buffer) - 20 - MAX_COMBINING_CHARS_PER_CELL);
+    ShapedRun *sr = cells_left ? NULL : shaped_run_cache_for(font, fobj, shape_buffer, num_codepoints, disable_ligature);
+    if (sr && sr->filled) {
+        group_state.info = sr->info;
+        group_state.positions = sr->positions;
+        group_state.num_glyphs = sr->num_glyphs;
+        return;
+    }
+    if (cells_left) load_hb_buffer(first_cpu_cell, first_gpu_cell, num_cells);
+    else {
+        hb_buffer_clear_contents(harfbuzz_buffer);
+        hb_buffer_add_utf32(harfbuzz_buffer, shape_buffer, num_codepoints, 0, num_codepoints);
+        hb_buffer_guess_segment_properties(harfbuzz_buffer);
+        if (OPT(force_ltr)) hb_buffer_set_direction(harfbuzz_buffer, HB_DIRECTION_LTR);
+    }
 
     size_t num_features = fobj->num_ffs_hb_features;
     if (num_features && !disable_ligature) num_features--;  // the last feature is always -calt
@@ -826,6 +1241,7 @@ shape(CPUCell *first_cpu_cell, GPUCell *first_gpu_cell, index_type num_cells, hb
     group_state.positions = hb_buffer_get_glyph_positions(harfbuzz_buffer, &positions_length);
     if (!group_state.info || !group_state.positions) group_state.num_glyphs = 0;
     else group_state.num_glyphs = MIN(info_length, positions_length);
+    if (sr) fill_shaped_run(sr, group_state.info, group_state.positions, group_state.num_glyphs);
 }
 
 static inline bool
@@ -876,7 +1292,7 @@ check_cell_consumed(CellData *cell_data, CPUCell *last_cpu_cell) {
                 cell_data->current_codepoint = cell_data->cpu_cell->ch;
                 break;
             default: {
-                index_type mark = cell_data->cpu_cell->cc_idx[cell_data->codepoints_consumed - 1];
+                index_type mark = combining_mark_at(cell_data->cpu_cell->cc_idx, cell_data->codepoints_consumed - 1);
                 // VS15/16 cause rendering to break, as they get marked as
                 // special glyphs, so map to 0, to avoid that
                 cell_data->current_codepoint = (mark == VS15 || mark == VS16) ? 0 : codepoint_for_mark(mark);
@@ -1105,10 +1521,29 @@ test_shape(PyObject UNUSED *self, PyObject *args) {
 }
 #undef G
 
+static inline void
+render_cells_degraded(FontGroup *fg, Font *font, CPUCell *cpu_cells, GPUCell *gpu_cells, index_type num_cells) {
+    // the fast-scroll path: no shaping, every cell gets the sprite for its
+    // base codepoint's nominal glyph, which for plain text is the same
+    // sprite full shaping produces, so the cache is shared. Ligatures,
+    // combining mark placement and multi-cell ligatures are skipped.
+    static ExtraGlyphs no_extra_glyphs = {{0}};
+    for (index_type i = 0; i < num_cells;) {
+        unsigned int width = gpu_cells[i].attrs & WIDTH_MASK;
+        if (!width) width = 1;
+        glyph_index glyph = (glyph_index)glyph_id_for_codepoint(font->face, cpu_cells[i].ch);
+        hb_glyph_info_t info = {.codepoint=glyph};
+        hb_glyph_position_t position = {0};
+        render_group(fg, width, 1, cpu_cells + i, gpu_cells + i, &info, &position, font, glyph, &no_extra_glyphs, false);
+        i += width;
+    }
+}
+
 static inline void
 render_run(FontGroup *fg, CPUCell *first_cpu_cell, GPUCell *first_gpu_cell, index_type num_cells, ssize_t font_idx, bool pua_space_ligature, bool center_glyph, int cursor_offset, DisableLigature disable_ligature_strategy) {
     switch(font_idx) {
         default:
+            if (degraded_text_shaping) { render_cells_degraded(fg, &fg->fonts[font_idx], first_cpu_cell, first_gpu_cell, num_cells); break; }
             shape_run(first_cpu_cell, first_gpu_cell, num_cells, &fg->fonts[font_idx], disable_ligature_strategy == DISABLE_LIGATURES_ALWAYS);
             if (pua_space_ligature) merge_groups_for_pua_space_ligature();
             else if (cursor_offset > -1) { // false if DISABLE_LIGATURES_NEVER
@@ -1147,7 +1582,7 @@ is_non_emoji_dingbat(char_type ch) {
     return 0x2700 <= ch && ch <= 0x27bf && !is_emoji(ch);
 }
 
-void
+bool
 render_line(FONTS_DATA_HANDLE fg_, Line *line, index_type lnum, Cursor *cursor, DisableLigature disable_ligature_strategy) {
 #define RENDER if (run_font_idx != NO_FONT && i > first_cell_in_run) { \
     int cursor_offset = -1; \
@@ -1157,6 +1592,7 @@ render_line(FONTS_DATA_HANDLE fg_, Line *line, index_type lnum, Cursor *cursor,
     FontGroup *fg = (FontGroup*)fg_;
     ssize_t run_font_idx = NO_FONT;
     bool center_glyph = false;
+    glyph_raster_deferred = false;
     bool disable_ligature_at_cursor = cursor != NULL && disable_ligature_strategy == DISABLE_LIGATURES_CURSOR && lnum == cursor->y;
     index_type first_cell_in_run, i;
     attrs_type prev_width = 0;
@@ -1216,6 +1652,7 @@ render_line(FONTS_DATA_HANDLE fg_, Line *line, index_type lnum, Cursor *cursor,
     }
     RENDER
 #undef RENDER
+    return !glyph_raster_deferred;
 }
 
 StringCanvas
@@ -1325,12 +1762,40 @@ initialize_font_group(FontGroup *fg) {
 }
 
 
+static void
+prewarm_common_glyphs(FontGroup *fg) {
+    // Rasterize the glyphs almost every session needs (printable ASCII, box
+    // drawing, powerline) into the sprite texture before any text arrives,
+    // so the first prompt paint does not pay for them. This runs on the
+    // render thread during the first, blank, frame of a new sprite map,
+    // overlapping with shell startup: GL uploads and the FreeType faces
+    // cannot be used from any other thread. It also fills the shaped run and
+    // glyph bitmap caches, making later font groups cheap to warm.
+    CPUCell cpu = {0};
+    GPUCell gpu = {0};
+    gpu.attrs = 1;  // width 1
+    for (char_type ch = '!'; ch <= '~'; ch++) {
+        // one cell per run, so ligature fonts do not combine neighbors
+        cpu.ch = ch;
+        render_run(fg, &cpu, &gpu, 1, fg->medium_font_idx, false, false, -1, DISABLE_LIGATURES_NEVER);
+    }
+    for (char_type ch = 0x2500; ch <= 0x259f; ch++) {  // box drawing and blocks
+        cpu.ch = ch;
+        render_box_cell(fg, &cpu, &gpu);
+    }
+    for (char_type ch = 0xe0b0; ch <= 0xe0b4; ch++) {  // powerline
+        cpu.ch = ch;
+        render_box_cell(fg, &cpu, &gpu);
+    }
+}
+
 void
 send_prerendered_sprites_for_window(OSWindow *w) {
     FontGroup *fg = (FontGroup*)w->fonts_data;
     if (!fg->sprite_map) {
         fg->sprite_map = alloc_sprite_map(fg->cell_width, fg->cell_height);
         send_prerendered_sprites(fg);
+        prewarm_common_glyphs(fg);
     }
 }
 
@@ -1342,6 +1807,7 @@ load_fonts_data(double font_sz_in_pts, double dpi_x, double dpi_y) {
 
 static void
 finalize(void) {
+    Py_CLEAR(glyph_bitmap_cache);
     Py_CLEAR(python_send_to_gpu_impl);
     clear_symbol_maps();
     Py_CLEAR(box_drawing_function);
@@ -1351,6 +1817,8 @@ finalize(void) {
     free_font_groups();
     if (harfbuzz_buffer) { hb_buffer_destroy(harfbuzz_buffer); harfbuzz_buffer = NULL; }
     free(group_state.groups); group_state.groups = NULL; group_state.groups_capacity = 0;
+    clear_shaped_run_cache();
+    free(shaped_run_cache.entries); shaped_run_cache.entries = NULL; shaped_run_cache.capacity = 0;
 }
 
 static PyObject*
@@ -1465,10 +1933,10 @@ get_fallback_font(PyObject UNUSED *self, PyObject *args) {
     if (!PyArg_ParseTuple(args, "Upp", &text, &bold, &italic)) return NULL;
     CPUCell cpu_cell = {0};
     GPUCell gpu_cell = {0};
-    static Py_UCS4 char_buf[2 + arraysz(cpu_cell.cc_idx)];
+    static Py_UCS4 char_buf[2 + MAX_COMBINING_CHARS_PER_CELL];
     if (!PyUnicode_AsUCS4(text, char_buf, arraysz(char_buf), 1)) return NULL;
     cpu_cell.ch = char_buf[0];
-    for (unsigned i = 0; i + 1 < (unsigned) PyUnicode_GetLength(text) && i < arraysz(cpu_cell.cc_idx); i++) cpu_cell.cc_idx[i] = mark_for_codepoint(char_buf[i + 1]);
+    for (unsigned i = 0; i + 1 < (unsigned) PyUnicode_GetLength(text) && i < MAX_COMBINING_CHARS_PER_CELL; i++) cpu_cell.cc_idx = add_combining_mark(cpu_cell.cc_idx, mark_for_codepoint(char_buf[i + 1]));
     if (bold) gpu_cell.attrs |= 1 << BOLD_SHIFT;
     if (italic) gpu_cell.attrs |= 1 << ITALIC_SHIFT;
     FontGroup *fg = font_groups;
@@ -1493,6 +1961,13 @@ free_font_data(PyObject *self UNUSED, PyObject *args UNUSED) {
     Py_RETURN_NONE;
 }
 
+static PyObject*
+glyph_cache_memory_used(PyObject *self UNUSED, PyObject *args UNUSED) {
+    size_t in_ram = 0, on_disk = 0;
+    if (glyph_bitmap_cache) disk_cache_size_of(glyph_bitmap_cache, &in_ram, &on_disk);
+    return Py_BuildValue("(nn)", (Py_ssize_t)in_ram, (Py_ssize_t)on_disk);
+}
+
 static PyObject*
 parse_font_feature(PyObject *self UNUSED, PyObject *feature) {
     if (!PyUnicode_Check(feature)) {
@@ -1520,6 +1995,7 @@ static PyMethodDef module_methods[] = {
     METHODB(set_send_sprite_to_gpu, METH_O),
     METHODB(test_shape, METH_VARARGS),
     METHODB(current_fonts, METH_NOARGS),
+    METHODB(glyph_cache_memory_used, METH_NOARGS),
     METHODB(test_render_line, METH_VARARGS),
     METHODB(get_fallback_font, METH_VARARGS),
     {NULL, NULL, 0, NULL}        /* Sentinel */
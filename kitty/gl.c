@@ -236,8 +236,14 @@ alloc_buffer(ssize_t idx, GLsizeiptr size, GLenum usage) {
 
 static inline void*
 map_buffer(ssize_t idx, GLenum access) {
-    void *ans = glMapBuffer(buffers[idx].usage, access);
-    return ans;
+    // Write maps invalidate the whole buffer, the driver can then hand back
+    // fresh or renamed storage immediately instead of stalling until the GPU
+    // is done reading the previous frame's data, which is what
+    // glMapBuffer(GL_WRITE_ONLY) does. Callers must therefore rewrite the
+    // entire buffer on every write map.
+    Buffer *b = buffers + idx;
+    if (access == GL_WRITE_ONLY && b->size) return glMapBufferRange(b->usage, 0, b->size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    return glMapBuffer(b->usage, access);
 }
 
 static inline void
@@ -361,6 +367,14 @@ alloc_and_map_vao_buffer(ssize_t vao_idx, GLsizeiptr size, size_t bufnum, GLenum
     return map_buffer(buf_idx, access);
 }
 
+void
+update_vao_buffer(ssize_t vao_idx, size_t bufnum, GLintptr offset, GLsizeiptr size, const void *data) {
+    ssize_t buf_idx = vaos[vao_idx].buffers[bufnum];
+    bind_buffer(buf_idx);
+    glBufferSubData(buffers[buf_idx].usage, offset, size, data);
+    unbind_buffer(buf_idx);
+}
+
 void
 bind_vao_uniform_buffer(ssize_t vao_idx, size_t bufnum, GLuint block_index) {
     ssize_t buf_idx = vaos[vao_idx].buffers[bufnum];
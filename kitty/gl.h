@@ -50,6 +50,7 @@ size_t add_buffer_to_vao(ssize_t vao_idx, GLenum usage);
 void add_attribute_to_vao(int p, ssize_t vao_idx, const char *name, GLint size, GLenum data_type, GLsizei stride, void *offset, GLuint divisor);
 ssize_t alloc_vao_buffer(ssize_t vao_idx, GLsizeiptr size, size_t bufnum, GLenum usage);
 void* alloc_and_map_vao_buffer(ssize_t vao_idx, GLsizeiptr size, size_t bufnum, GLenum usage, GLenum access);
+void update_vao_buffer(ssize_t vao_idx, size_t bufnum, GLintptr offset, GLsizeiptr size, const void *data);
 void unmap_vao_buffer(ssize_t vao_idx, size_t bufnum);
 void* map_vao_buffer(ssize_t vao_idx, size_t bufnum, GLenum access);
 void bind_program(int program);
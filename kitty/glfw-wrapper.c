@@ -2,12 +2,606 @@
 #define GFW_EXTERN
 #include "data-types.h"
 #include "glfw-wrapper.h"
+
+#define fail(msg, ...) { snprintf(buf, sizeof(buf), msg, __VA_ARGS__); return buf; }
+
+#ifdef KITTY_STATIC_GLFW
+// The GLFW backend is linked into this binary, bind the wrapper pointers
+// directly to its symbols instead of dlopen()ing a backend library,
+// removing the dlsym indirection and letting LTO see across the boundary.
+
+#ifdef __APPLE__
+#define SYM(x) "_" x
+#else
+#define SYM(x) x
+#endif
+#define WEAK __attribute__((weak))
+
+extern int glfwInit_static(monotonic_t) __asm__(SYM("glfwInit")) WEAK;
+extern void glfwRunMainLoop_static(GLFWtickcallback, void*) __asm__(SYM("glfwRunMainLoop")) WEAK;
+extern void glfwStopMainLoop_static(void) __asm__(SYM("glfwStopMainLoop")) WEAK;
+extern unsigned long long glfwAddTimer_static(monotonic_t, bool, GLFWuserdatafun, void *, GLFWuserdatafun) __asm__(SYM("glfwAddTimer")) WEAK;
+extern void glfwUpdateTimer_static(unsigned long long, monotonic_t, bool) __asm__(SYM("glfwUpdateTimer")) WEAK;
+extern void glfwRemoveTimer_static(unsigned long) __asm__(SYM("glfwRemoveTimer")) WEAK;
+extern unsigned long long glfwAddLoopWatch_static(int, int, GLFWloopwatchfun, void*) __asm__(SYM("glfwAddLoopWatch")) WEAK;
+extern void glfwRemoveLoopWatch_static(unsigned long long) __asm__(SYM("glfwRemoveLoopWatch")) WEAK;
+extern void glfwToggleLoopWatch_static(unsigned long long, bool) __asm__(SYM("glfwToggleLoopWatch")) WEAK;
+extern void glfwTerminate_static(void) __asm__(SYM("glfwTerminate")) WEAK;
+extern void glfwInitHint_static(int, int) __asm__(SYM("glfwInitHint")) WEAK;
+extern void glfwGetVersion_static(int*, int*, int*) __asm__(SYM("glfwGetVersion")) WEAK;
+extern const char* glfwGetVersionString_static(void) __asm__(SYM("glfwGetVersionString")) WEAK;
+extern int glfwGetError_static(const char**) __asm__(SYM("glfwGetError")) WEAK;
+extern GLFWerrorfun glfwSetErrorCallback_static(GLFWerrorfun) __asm__(SYM("glfwSetErrorCallback")) WEAK;
+extern GLFWmonitor** glfwGetMonitors_static(int*) __asm__(SYM("glfwGetMonitors")) WEAK;
+extern GLFWmonitor* glfwGetPrimaryMonitor_static(void) __asm__(SYM("glfwGetPrimaryMonitor")) WEAK;
+extern void glfwGetMonitorPos_static(GLFWmonitor*, int*, int*) __asm__(SYM("glfwGetMonitorPos")) WEAK;
+extern void glfwGetMonitorWorkarea_static(GLFWmonitor*, int*, int*, int*, int*) __asm__(SYM("glfwGetMonitorWorkarea")) WEAK;
+extern void glfwGetMonitorPhysicalSize_static(GLFWmonitor*, int*, int*) __asm__(SYM("glfwGetMonitorPhysicalSize")) WEAK;
+extern void glfwGetMonitorContentScale_static(GLFWmonitor*, float*, float*) __asm__(SYM("glfwGetMonitorContentScale")) WEAK;
+extern const char* glfwGetMonitorName_static(GLFWmonitor*) __asm__(SYM("glfwGetMonitorName")) WEAK;
+extern void glfwSetMonitorUserPointer_static(GLFWmonitor*, void*) __asm__(SYM("glfwSetMonitorUserPointer")) WEAK;
+extern void* glfwGetMonitorUserPointer_static(GLFWmonitor*) __asm__(SYM("glfwGetMonitorUserPointer")) WEAK;
+extern GLFWmonitorfun glfwSetMonitorCallback_static(GLFWmonitorfun) __asm__(SYM("glfwSetMonitorCallback")) WEAK;
+extern const GLFWvidmode* glfwGetVideoModes_static(GLFWmonitor*, int*) __asm__(SYM("glfwGetVideoModes")) WEAK;
+extern const GLFWvidmode* glfwGetVideoMode_static(GLFWmonitor*) __asm__(SYM("glfwGetVideoMode")) WEAK;
+extern void glfwSetGamma_static(GLFWmonitor*, float) __asm__(SYM("glfwSetGamma")) WEAK;
+extern const GLFWgammaramp* glfwGetGammaRamp_static(GLFWmonitor*) __asm__(SYM("glfwGetGammaRamp")) WEAK;
+extern void glfwSetGammaRamp_static(GLFWmonitor*, const GLFWgammaramp*) __asm__(SYM("glfwSetGammaRamp")) WEAK;
+extern void glfwDefaultWindowHints_static(void) __asm__(SYM("glfwDefaultWindowHints")) WEAK;
+extern void glfwWindowHint_static(int, int) __asm__(SYM("glfwWindowHint")) WEAK;
+extern void glfwWindowHintString_static(int, const char*) __asm__(SYM("glfwWindowHintString")) WEAK;
+extern GLFWwindow* glfwCreateWindow_static(int, int, const char*, GLFWmonitor*, GLFWwindow*) __asm__(SYM("glfwCreateWindow")) WEAK;
+extern bool glfwToggleFullscreen_static(GLFWwindow*, unsigned int) __asm__(SYM("glfwToggleFullscreen")) WEAK;
+extern void glfwDestroyWindow_static(GLFWwindow*) __asm__(SYM("glfwDestroyWindow")) WEAK;
+extern int glfwWindowShouldClose_static(GLFWwindow*) __asm__(SYM("glfwWindowShouldClose")) WEAK;
+extern void glfwSetWindowShouldClose_static(GLFWwindow*, int) __asm__(SYM("glfwSetWindowShouldClose")) WEAK;
+extern void glfwSetWindowTitle_static(GLFWwindow*, const char*) __asm__(SYM("glfwSetWindowTitle")) WEAK;
+extern void glfwSetWindowIcon_static(GLFWwindow*, int, const GLFWimage*) __asm__(SYM("glfwSetWindowIcon")) WEAK;
+extern void glfwGetWindowPos_static(GLFWwindow*, int*, int*) __asm__(SYM("glfwGetWindowPos")) WEAK;
+extern void glfwSetWindowPos_static(GLFWwindow*, int, int) __asm__(SYM("glfwSetWindowPos")) WEAK;
+extern void glfwGetWindowSize_static(GLFWwindow*, int*, int*) __asm__(SYM("glfwGetWindowSize")) WEAK;
+extern void glfwSetWindowSizeLimits_static(GLFWwindow*, int, int, int, int) __asm__(SYM("glfwSetWindowSizeLimits")) WEAK;
+extern void glfwSetWindowSizeIncrements_static(GLFWwindow*, int, int) __asm__(SYM("glfwSetWindowSizeIncrements")) WEAK;
+extern void glfwSetWindowAspectRatio_static(GLFWwindow*, int, int) __asm__(SYM("glfwSetWindowAspectRatio")) WEAK;
+extern void glfwSetWindowSize_static(GLFWwindow*, int, int) __asm__(SYM("glfwSetWindowSize")) WEAK;
+extern void glfwGetFramebufferSize_static(GLFWwindow*, int*, int*) __asm__(SYM("glfwGetFramebufferSize")) WEAK;
+extern void glfwGetWindowFrameSize_static(GLFWwindow*, int*, int*, int*, int*) __asm__(SYM("glfwGetWindowFrameSize")) WEAK;
+extern void glfwGetWindowContentScale_static(GLFWwindow*, float*, float*) __asm__(SYM("glfwGetWindowContentScale")) WEAK;
+extern monotonic_t glfwGetDoubleClickInterval_static(GLFWwindow*) __asm__(SYM("glfwGetDoubleClickInterval")) WEAK;
+extern float glfwGetWindowOpacity_static(GLFWwindow*) __asm__(SYM("glfwGetWindowOpacity")) WEAK;
+extern void glfwSetWindowOpacity_static(GLFWwindow*, float) __asm__(SYM("glfwSetWindowOpacity")) WEAK;
+extern void glfwIconifyWindow_static(GLFWwindow*) __asm__(SYM("glfwIconifyWindow")) WEAK;
+extern void glfwRestoreWindow_static(GLFWwindow*) __asm__(SYM("glfwRestoreWindow")) WEAK;
+extern void glfwMaximizeWindow_static(GLFWwindow*) __asm__(SYM("glfwMaximizeWindow")) WEAK;
+extern void glfwShowWindow_static(GLFWwindow*) __asm__(SYM("glfwShowWindow")) WEAK;
+extern void glfwHideWindow_static(GLFWwindow*) __asm__(SYM("glfwHideWindow")) WEAK;
+extern void glfwFocusWindow_static(GLFWwindow*) __asm__(SYM("glfwFocusWindow")) WEAK;
+extern void glfwRequestWindowAttention_static(GLFWwindow*) __asm__(SYM("glfwRequestWindowAttention")) WEAK;
+extern int glfwWindowBell_static(GLFWwindow*) __asm__(SYM("glfwWindowBell")) WEAK;
+extern GLFWmonitor* glfwGetWindowMonitor_static(GLFWwindow*) __asm__(SYM("glfwGetWindowMonitor")) WEAK;
+extern void glfwSetWindowMonitor_static(GLFWwindow*, GLFWmonitor*, int, int, int, int, int) __asm__(SYM("glfwSetWindowMonitor")) WEAK;
+extern int glfwGetWindowAttrib_static(GLFWwindow*, int) __asm__(SYM("glfwGetWindowAttrib")) WEAK;
+extern void glfwSetWindowAttrib_static(GLFWwindow*, int, int) __asm__(SYM("glfwSetWindowAttrib")) WEAK;
+extern void glfwSetWindowUserPointer_static(GLFWwindow*, void*) __asm__(SYM("glfwSetWindowUserPointer")) WEAK;
+extern void* glfwGetWindowUserPointer_static(GLFWwindow*) __asm__(SYM("glfwGetWindowUserPointer")) WEAK;
+extern GLFWwindowposfun glfwSetWindowPosCallback_static(GLFWwindow*, GLFWwindowposfun) __asm__(SYM("glfwSetWindowPosCallback")) WEAK;
+extern GLFWwindowsizefun glfwSetWindowSizeCallback_static(GLFWwindow*, GLFWwindowsizefun) __asm__(SYM("glfwSetWindowSizeCallback")) WEAK;
+extern GLFWwindowclosefun glfwSetWindowCloseCallback_static(GLFWwindow*, GLFWwindowclosefun) __asm__(SYM("glfwSetWindowCloseCallback")) WEAK;
+extern GLFWapplicationclosefun glfwSetApplicationCloseCallback_static(GLFWapplicationclosefun) __asm__(SYM("glfwSetApplicationCloseCallback")) WEAK;
+extern GLFWwindowrefreshfun glfwSetWindowRefreshCallback_static(GLFWwindow*, GLFWwindowrefreshfun) __asm__(SYM("glfwSetWindowRefreshCallback")) WEAK;
+extern GLFWwindowfocusfun glfwSetWindowFocusCallback_static(GLFWwindow*, GLFWwindowfocusfun) __asm__(SYM("glfwSetWindowFocusCallback")) WEAK;
+extern GLFWwindowocclusionfun glfwSetWindowOcclusionCallback_static(GLFWwindow*, GLFWwindowocclusionfun) __asm__(SYM("glfwSetWindowOcclusionCallback")) WEAK;
+extern GLFWwindowiconifyfun glfwSetWindowIconifyCallback_static(GLFWwindow*, GLFWwindowiconifyfun) __asm__(SYM("glfwSetWindowIconifyCallback")) WEAK;
+extern GLFWwindowmaximizefun glfwSetWindowMaximizeCallback_static(GLFWwindow*, GLFWwindowmaximizefun) __asm__(SYM("glfwSetWindowMaximizeCallback")) WEAK;
+extern GLFWframebuffersizefun glfwSetFramebufferSizeCallback_static(GLFWwindow*, GLFWframebuffersizefun) __asm__(SYM("glfwSetFramebufferSizeCallback")) WEAK;
+extern GLFWwindowcontentscalefun glfwSetWindowContentScaleCallback_static(GLFWwindow*, GLFWwindowcontentscalefun) __asm__(SYM("glfwSetWindowContentScaleCallback")) WEAK;
+extern void glfwPostEmptyEvent_static(void) __asm__(SYM("glfwPostEmptyEvent")) WEAK;
+extern int glfwGetInputMode_static(GLFWwindow*, int) __asm__(SYM("glfwGetInputMode")) WEAK;
+extern void glfwSetInputMode_static(GLFWwindow*, int, int) __asm__(SYM("glfwSetInputMode")) WEAK;
+extern int glfwRawMouseMotionSupported_static(void) __asm__(SYM("glfwRawMouseMotionSupported")) WEAK;
+extern const char* glfwGetKeyName_static(int, int) __asm__(SYM("glfwGetKeyName")) WEAK;
+extern int glfwGetNativeKeyForKey_static(int) __asm__(SYM("glfwGetNativeKeyForKey")) WEAK;
+extern int glfwGetKey_static(GLFWwindow*, int) __asm__(SYM("glfwGetKey")) WEAK;
+extern int glfwGetMouseButton_static(GLFWwindow*, int) __asm__(SYM("glfwGetMouseButton")) WEAK;
+extern void glfwGetCursorPos_static(GLFWwindow*, double*, double*) __asm__(SYM("glfwGetCursorPos")) WEAK;
+extern void glfwSetCursorPos_static(GLFWwindow*, double, double) __asm__(SYM("glfwSetCursorPos")) WEAK;
+extern GLFWcursor* glfwCreateCursor_static(const GLFWimage*, int, int, int) __asm__(SYM("glfwCreateCursor")) WEAK;
+extern GLFWcursor* glfwCreateStandardCursor_static(GLFWCursorShape) __asm__(SYM("glfwCreateStandardCursor")) WEAK;
+extern void glfwDestroyCursor_static(GLFWcursor*) __asm__(SYM("glfwDestroyCursor")) WEAK;
+extern void glfwSetCursor_static(GLFWwindow*, GLFWcursor*) __asm__(SYM("glfwSetCursor")) WEAK;
+extern GLFWkeyboardfun glfwSetKeyboardCallback_static(GLFWwindow*, GLFWkeyboardfun) __asm__(SYM("glfwSetKeyboardCallback")) WEAK;
+extern void glfwUpdateIMEState_static(GLFWwindow*, int, int, int, int, int) __asm__(SYM("glfwUpdateIMEState")) WEAK;
+extern GLFWmousebuttonfun glfwSetMouseButtonCallback_static(GLFWwindow*, GLFWmousebuttonfun) __asm__(SYM("glfwSetMouseButtonCallback")) WEAK;
+extern GLFWcursorposfun glfwSetCursorPosCallback_static(GLFWwindow*, GLFWcursorposfun) __asm__(SYM("glfwSetCursorPosCallback")) WEAK;
+extern GLFWcursorenterfun glfwSetCursorEnterCallback_static(GLFWwindow*, GLFWcursorenterfun) __asm__(SYM("glfwSetCursorEnterCallback")) WEAK;
+extern GLFWscrollfun glfwSetScrollCallback_static(GLFWwindow*, GLFWscrollfun) __asm__(SYM("glfwSetScrollCallback")) WEAK;
+extern GLFWdropfun glfwSetDropCallback_static(GLFWwindow*, GLFWdropfun) __asm__(SYM("glfwSetDropCallback")) WEAK;
+extern GLFWliveresizefun glfwSetLiveResizeCallback_static(GLFWwindow*, GLFWliveresizefun) __asm__(SYM("glfwSetLiveResizeCallback")) WEAK;
+extern int glfwJoystickPresent_static(int) __asm__(SYM("glfwJoystickPresent")) WEAK;
+extern const float* glfwGetJoystickAxes_static(int, int*) __asm__(SYM("glfwGetJoystickAxes")) WEAK;
+extern const unsigned char* glfwGetJoystickButtons_static(int, int*) __asm__(SYM("glfwGetJoystickButtons")) WEAK;
+extern const unsigned char* glfwGetJoystickHats_static(int, int*) __asm__(SYM("glfwGetJoystickHats")) WEAK;
+extern const char* glfwGetJoystickName_static(int) __asm__(SYM("glfwGetJoystickName")) WEAK;
+extern const char* glfwGetJoystickGUID_static(int) __asm__(SYM("glfwGetJoystickGUID")) WEAK;
+extern void glfwSetJoystickUserPointer_static(int, void*) __asm__(SYM("glfwSetJoystickUserPointer")) WEAK;
+extern void* glfwGetJoystickUserPointer_static(int) __asm__(SYM("glfwGetJoystickUserPointer")) WEAK;
+extern int glfwJoystickIsGamepad_static(int) __asm__(SYM("glfwJoystickIsGamepad")) WEAK;
+extern GLFWjoystickfun glfwSetJoystickCallback_static(GLFWjoystickfun) __asm__(SYM("glfwSetJoystickCallback")) WEAK;
+extern int glfwUpdateGamepadMappings_static(const char*) __asm__(SYM("glfwUpdateGamepadMappings")) WEAK;
+extern const char* glfwGetGamepadName_static(int) __asm__(SYM("glfwGetGamepadName")) WEAK;
+extern int glfwGetGamepadState_static(int, GLFWgamepadstate*) __asm__(SYM("glfwGetGamepadState")) WEAK;
+extern void glfwSetClipboardString_static(GLFWwindow*, const char*) __asm__(SYM("glfwSetClipboardString")) WEAK;
+extern const char* glfwGetClipboardString_static(GLFWwindow*) __asm__(SYM("glfwGetClipboardString")) WEAK;
+extern bool glfwRequestClipboardString_static(GLFWwindow*, bool, GLFWclipboardchunkfun, void*) __asm__(SYM("glfwRequestClipboardString")) WEAK;
+extern void glfwResumeClipboardRequest_static(void) __asm__(SYM("glfwResumeClipboardRequest")) WEAK;
+extern monotonic_t glfwGetTime_static(void) __asm__(SYM("glfwGetTime")) WEAK;
+extern void glfwMakeContextCurrent_static(GLFWwindow*) __asm__(SYM("glfwMakeContextCurrent")) WEAK;
+extern GLFWwindow* glfwGetCurrentContext_static(void) __asm__(SYM("glfwGetCurrentContext")) WEAK;
+extern void glfwSwapBuffers_static(GLFWwindow*) __asm__(SYM("glfwSwapBuffers")) WEAK;
+extern bool glfwSwapBuffersWithDamage_static(GLFWwindow*, const GLFWDamageRect*, int) __asm__(SYM("glfwSwapBuffersWithDamage")) WEAK;
+extern void glfwSwapInterval_static(int) __asm__(SYM("glfwSwapInterval")) WEAK;
+extern int glfwExtensionSupported_static(const char*) __asm__(SYM("glfwExtensionSupported")) WEAK;
+extern GLFWglproc glfwGetProcAddress_static(const char*) __asm__(SYM("glfwGetProcAddress")) WEAK;
+extern int glfwVulkanSupported_static(void) __asm__(SYM("glfwVulkanSupported")) WEAK;
+extern const char** glfwGetRequiredInstanceExtensions_static(uint32_t*) __asm__(SYM("glfwGetRequiredInstanceExtensions")) WEAK;
+extern void* glfwGetCocoaWindow_static(GLFWwindow*) __asm__(SYM("glfwGetCocoaWindow")) WEAK;
+extern void glfwHideCocoaTitlebar_static(GLFWwindow*, bool) __asm__(SYM("glfwHideCocoaTitlebar")) WEAK;
+extern void* glfwGetNSGLContext_static(GLFWwindow*) __asm__(SYM("glfwGetNSGLContext")) WEAK;
+extern uint32_t glfwGetCocoaMonitor_static(GLFWmonitor*) __asm__(SYM("glfwGetCocoaMonitor")) WEAK;
+extern GLFWcocoatextinputfilterfun glfwSetCocoaTextInputFilter_static(GLFWwindow*, GLFWcocoatextinputfilterfun) __asm__(SYM("glfwSetCocoaTextInputFilter")) WEAK;
+extern GLFWcocoatogglefullscreenfun glfwSetCocoaToggleFullscreenIntercept_static(GLFWwindow*, GLFWcocoatogglefullscreenfun) __asm__(SYM("glfwSetCocoaToggleFullscreenIntercept")) WEAK;
+extern GLFWapplicationshouldhandlereopenfun glfwSetApplicationShouldHandleReopen_static(GLFWapplicationshouldhandlereopenfun) __asm__(SYM("glfwSetApplicationShouldHandleReopen")) WEAK;
+extern GLFWapplicationwillfinishlaunchingfun glfwSetApplicationWillFinishLaunching_static(GLFWapplicationwillfinishlaunchingfun) __asm__(SYM("glfwSetApplicationWillFinishLaunching")) WEAK;
+extern void glfwGetCocoaKeyEquivalent_static(int, int, char*, size_t, int*) __asm__(SYM("glfwGetCocoaKeyEquivalent")) WEAK;
+extern void glfwCocoaRequestRenderFrame_static(GLFWwindow*, GLFWcocoarenderframefun) __asm__(SYM("glfwCocoaRequestRenderFrame")) WEAK;
+extern void* glfwGetX11Display_static(void) __asm__(SYM("glfwGetX11Display")) WEAK;
+extern int32_t glfwGetX11Window_static(GLFWwindow*) __asm__(SYM("glfwGetX11Window")) WEAK;
+extern void glfwSetPrimarySelectionString_static(GLFWwindow*, const char*) __asm__(SYM("glfwSetPrimarySelectionString")) WEAK;
+extern const char* glfwGetPrimarySelectionString_static(GLFWwindow*) __asm__(SYM("glfwGetPrimarySelectionString")) WEAK;
+extern int glfwGetNativeKeyForName_static(const char*, int) __asm__(SYM("glfwGetNativeKeyForName")) WEAK;
+extern void glfwRequestWaylandFrameEvent_static(GLFWwindow*, unsigned long long, GLFWwaylandframecallbackfunc) __asm__(SYM("glfwRequestWaylandFrameEvent")) WEAK;
+extern int glfwX11FrameEventsAvailable_static(void) __asm__(SYM("glfwX11FrameEventsAvailable")) WEAK;
+extern void glfwRequestX11FrameEvent_static(GLFWwindow*, unsigned long long, GLFWwaylandframecallbackfunc) __asm__(SYM("glfwRequestX11FrameEvent")) WEAK;
+extern unsigned long long glfwDBusUserNotify_static(const char*, const char*, const char*, const char*, const char*, int32_t, GLFWDBusnotificationcreatedfun, void*) __asm__(SYM("glfwDBusUserNotify")) WEAK;
+extern void glfwDBusSetUserNotificationHandler_static(GLFWDBusnotificationactivatedfun) __asm__(SYM("glfwDBusSetUserNotificationHandler")) WEAK;
+
+const char*
+load_glfw(const char* path UNUSED) {
+    static char buf[2048];
+
+    glfwInit_impl = glfwInit_static;
+    if (glfwInit_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwInit");
+
+    glfwRunMainLoop_impl = glfwRunMainLoop_static;
+    if (glfwRunMainLoop_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRunMainLoop");
+
+    glfwStopMainLoop_impl = glfwStopMainLoop_static;
+    if (glfwStopMainLoop_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwStopMainLoop");
+
+    glfwAddTimer_impl = glfwAddTimer_static;
+    if (glfwAddTimer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwAddTimer");
+
+    glfwUpdateTimer_impl = glfwUpdateTimer_static;
+    if (glfwUpdateTimer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwUpdateTimer");
+
+    glfwRemoveTimer_impl = glfwRemoveTimer_static;
+    if (glfwRemoveTimer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRemoveTimer");
+
+    glfwAddLoopWatch_impl = glfwAddLoopWatch_static;
+    if (glfwAddLoopWatch_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwAddLoopWatch");
+
+    glfwRemoveLoopWatch_impl = glfwRemoveLoopWatch_static;
+    if (glfwRemoveLoopWatch_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRemoveLoopWatch");
+
+    glfwToggleLoopWatch_impl = glfwToggleLoopWatch_static;
+    if (glfwToggleLoopWatch_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwToggleLoopWatch");
+
+    glfwTerminate_impl = glfwTerminate_static;
+    if (glfwTerminate_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwTerminate");
+
+    glfwInitHint_impl = glfwInitHint_static;
+    if (glfwInitHint_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwInitHint");
+
+    glfwGetVersion_impl = glfwGetVersion_static;
+    if (glfwGetVersion_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetVersion");
+
+    glfwGetVersionString_impl = glfwGetVersionString_static;
+    if (glfwGetVersionString_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetVersionString");
+
+    glfwGetError_impl = glfwGetError_static;
+    if (glfwGetError_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetError");
+
+    glfwSetErrorCallback_impl = glfwSetErrorCallback_static;
+    if (glfwSetErrorCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetErrorCallback");
+
+    glfwGetMonitors_impl = glfwGetMonitors_static;
+    if (glfwGetMonitors_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitors");
+
+    glfwGetPrimaryMonitor_impl = glfwGetPrimaryMonitor_static;
+    if (glfwGetPrimaryMonitor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetPrimaryMonitor");
+
+    glfwGetMonitorPos_impl = glfwGetMonitorPos_static;
+    if (glfwGetMonitorPos_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitorPos");
+
+    glfwGetMonitorWorkarea_impl = glfwGetMonitorWorkarea_static;
+    if (glfwGetMonitorWorkarea_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitorWorkarea");
+
+    glfwGetMonitorPhysicalSize_impl = glfwGetMonitorPhysicalSize_static;
+    if (glfwGetMonitorPhysicalSize_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitorPhysicalSize");
+
+    glfwGetMonitorContentScale_impl = glfwGetMonitorContentScale_static;
+    if (glfwGetMonitorContentScale_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitorContentScale");
+
+    glfwGetMonitorName_impl = glfwGetMonitorName_static;
+    if (glfwGetMonitorName_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitorName");
+
+    glfwSetMonitorUserPointer_impl = glfwSetMonitorUserPointer_static;
+    if (glfwSetMonitorUserPointer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetMonitorUserPointer");
+
+    glfwGetMonitorUserPointer_impl = glfwGetMonitorUserPointer_static;
+    if (glfwGetMonitorUserPointer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMonitorUserPointer");
+
+    glfwSetMonitorCallback_impl = glfwSetMonitorCallback_static;
+    if (glfwSetMonitorCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetMonitorCallback");
+
+    glfwGetVideoModes_impl = glfwGetVideoModes_static;
+    if (glfwGetVideoModes_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetVideoModes");
+
+    glfwGetVideoMode_impl = glfwGetVideoMode_static;
+    if (glfwGetVideoMode_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetVideoMode");
+
+    glfwSetGamma_impl = glfwSetGamma_static;
+    if (glfwSetGamma_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetGamma");
+
+    glfwGetGammaRamp_impl = glfwGetGammaRamp_static;
+    if (glfwGetGammaRamp_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetGammaRamp");
+
+    glfwSetGammaRamp_impl = glfwSetGammaRamp_static;
+    if (glfwSetGammaRamp_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetGammaRamp");
+
+    glfwDefaultWindowHints_impl = glfwDefaultWindowHints_static;
+    if (glfwDefaultWindowHints_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwDefaultWindowHints");
+
+    glfwWindowHint_impl = glfwWindowHint_static;
+    if (glfwWindowHint_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwWindowHint");
+
+    glfwWindowHintString_impl = glfwWindowHintString_static;
+    if (glfwWindowHintString_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwWindowHintString");
+
+    glfwCreateWindow_impl = glfwCreateWindow_static;
+    if (glfwCreateWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwCreateWindow");
+
+    glfwToggleFullscreen_impl = glfwToggleFullscreen_static;
+    if (glfwToggleFullscreen_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwToggleFullscreen");
+
+    glfwDestroyWindow_impl = glfwDestroyWindow_static;
+    if (glfwDestroyWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwDestroyWindow");
+
+    glfwWindowShouldClose_impl = glfwWindowShouldClose_static;
+    if (glfwWindowShouldClose_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwWindowShouldClose");
+
+    glfwSetWindowShouldClose_impl = glfwSetWindowShouldClose_static;
+    if (glfwSetWindowShouldClose_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowShouldClose");
+
+    glfwSetWindowTitle_impl = glfwSetWindowTitle_static;
+    if (glfwSetWindowTitle_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowTitle");
+
+    glfwSetWindowIcon_impl = glfwSetWindowIcon_static;
+    if (glfwSetWindowIcon_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowIcon");
+
+    glfwGetWindowPos_impl = glfwGetWindowPos_static;
+    if (glfwGetWindowPos_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowPos");
+
+    glfwSetWindowPos_impl = glfwSetWindowPos_static;
+    if (glfwSetWindowPos_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowPos");
+
+    glfwGetWindowSize_impl = glfwGetWindowSize_static;
+    if (glfwGetWindowSize_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowSize");
+
+    glfwSetWindowSizeLimits_impl = glfwSetWindowSizeLimits_static;
+    if (glfwSetWindowSizeLimits_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowSizeLimits");
+
+    glfwSetWindowSizeIncrements_impl = glfwSetWindowSizeIncrements_static;
+    if (glfwSetWindowSizeIncrements_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowSizeIncrements");
+
+    glfwSetWindowAspectRatio_impl = glfwSetWindowAspectRatio_static;
+    if (glfwSetWindowAspectRatio_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowAspectRatio");
+
+    glfwSetWindowSize_impl = glfwSetWindowSize_static;
+    if (glfwSetWindowSize_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowSize");
+
+    glfwGetFramebufferSize_impl = glfwGetFramebufferSize_static;
+    if (glfwGetFramebufferSize_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetFramebufferSize");
+
+    glfwGetWindowFrameSize_impl = glfwGetWindowFrameSize_static;
+    if (glfwGetWindowFrameSize_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowFrameSize");
+
+    glfwGetWindowContentScale_impl = glfwGetWindowContentScale_static;
+    if (glfwGetWindowContentScale_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowContentScale");
+
+    glfwGetDoubleClickInterval_impl = glfwGetDoubleClickInterval_static;
+    if (glfwGetDoubleClickInterval_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetDoubleClickInterval");
+
+    glfwGetWindowOpacity_impl = glfwGetWindowOpacity_static;
+    if (glfwGetWindowOpacity_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowOpacity");
+
+    glfwSetWindowOpacity_impl = glfwSetWindowOpacity_static;
+    if (glfwSetWindowOpacity_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowOpacity");
+
+    glfwIconifyWindow_impl = glfwIconifyWindow_static;
+    if (glfwIconifyWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwIconifyWindow");
+
+    glfwRestoreWindow_impl = glfwRestoreWindow_static;
+    if (glfwRestoreWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRestoreWindow");
+
+    glfwMaximizeWindow_impl = glfwMaximizeWindow_static;
+    if (glfwMaximizeWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwMaximizeWindow");
+
+    glfwShowWindow_impl = glfwShowWindow_static;
+    if (glfwShowWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwShowWindow");
+
+    glfwHideWindow_impl = glfwHideWindow_static;
+    if (glfwHideWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwHideWindow");
+
+    glfwFocusWindow_impl = glfwFocusWindow_static;
+    if (glfwFocusWindow_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwFocusWindow");
+
+    glfwRequestWindowAttention_impl = glfwRequestWindowAttention_static;
+    if (glfwRequestWindowAttention_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRequestWindowAttention");
+
+    glfwWindowBell_impl = glfwWindowBell_static;
+    if (glfwWindowBell_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwWindowBell");
+
+    glfwGetWindowMonitor_impl = glfwGetWindowMonitor_static;
+    if (glfwGetWindowMonitor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowMonitor");
+
+    glfwSetWindowMonitor_impl = glfwSetWindowMonitor_static;
+    if (glfwSetWindowMonitor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowMonitor");
+
+    glfwGetWindowAttrib_impl = glfwGetWindowAttrib_static;
+    if (glfwGetWindowAttrib_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowAttrib");
+
+    glfwSetWindowAttrib_impl = glfwSetWindowAttrib_static;
+    if (glfwSetWindowAttrib_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowAttrib");
+
+    glfwSetWindowUserPointer_impl = glfwSetWindowUserPointer_static;
+    if (glfwSetWindowUserPointer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowUserPointer");
+
+    glfwGetWindowUserPointer_impl = glfwGetWindowUserPointer_static;
+    if (glfwGetWindowUserPointer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetWindowUserPointer");
+
+    glfwSetWindowPosCallback_impl = glfwSetWindowPosCallback_static;
+    if (glfwSetWindowPosCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowPosCallback");
+
+    glfwSetWindowSizeCallback_impl = glfwSetWindowSizeCallback_static;
+    if (glfwSetWindowSizeCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowSizeCallback");
+
+    glfwSetWindowCloseCallback_impl = glfwSetWindowCloseCallback_static;
+    if (glfwSetWindowCloseCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowCloseCallback");
+
+    glfwSetApplicationCloseCallback_impl = glfwSetApplicationCloseCallback_static;
+    if (glfwSetApplicationCloseCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetApplicationCloseCallback");
+
+    glfwSetWindowRefreshCallback_impl = glfwSetWindowRefreshCallback_static;
+    if (glfwSetWindowRefreshCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowRefreshCallback");
+
+    glfwSetWindowFocusCallback_impl = glfwSetWindowFocusCallback_static;
+    if (glfwSetWindowFocusCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowFocusCallback");
+
+    glfwSetWindowOcclusionCallback_impl = glfwSetWindowOcclusionCallback_static;
+    if (glfwSetWindowOcclusionCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowOcclusionCallback");
+
+    glfwSetWindowIconifyCallback_impl = glfwSetWindowIconifyCallback_static;
+    if (glfwSetWindowIconifyCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowIconifyCallback");
+
+    glfwSetWindowMaximizeCallback_impl = glfwSetWindowMaximizeCallback_static;
+    if (glfwSetWindowMaximizeCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowMaximizeCallback");
+
+    glfwSetFramebufferSizeCallback_impl = glfwSetFramebufferSizeCallback_static;
+    if (glfwSetFramebufferSizeCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetFramebufferSizeCallback");
+
+    glfwSetWindowContentScaleCallback_impl = glfwSetWindowContentScaleCallback_static;
+    if (glfwSetWindowContentScaleCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetWindowContentScaleCallback");
+
+    glfwPostEmptyEvent_impl = glfwPostEmptyEvent_static;
+    if (glfwPostEmptyEvent_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwPostEmptyEvent");
+
+    glfwGetInputMode_impl = glfwGetInputMode_static;
+    if (glfwGetInputMode_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetInputMode");
+
+    glfwSetInputMode_impl = glfwSetInputMode_static;
+    if (glfwSetInputMode_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetInputMode");
+
+    glfwRawMouseMotionSupported_impl = glfwRawMouseMotionSupported_static;
+    if (glfwRawMouseMotionSupported_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRawMouseMotionSupported");
+
+    glfwGetKeyName_impl = glfwGetKeyName_static;
+    if (glfwGetKeyName_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetKeyName");
+
+    glfwGetNativeKeyForKey_impl = glfwGetNativeKeyForKey_static;
+    if (glfwGetNativeKeyForKey_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetNativeKeyForKey");
+
+    glfwGetKey_impl = glfwGetKey_static;
+    if (glfwGetKey_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetKey");
+
+    glfwGetMouseButton_impl = glfwGetMouseButton_static;
+    if (glfwGetMouseButton_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetMouseButton");
+
+    glfwGetCursorPos_impl = glfwGetCursorPos_static;
+    if (glfwGetCursorPos_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetCursorPos");
+
+    glfwSetCursorPos_impl = glfwSetCursorPos_static;
+    if (glfwSetCursorPos_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetCursorPos");
+
+    glfwCreateCursor_impl = glfwCreateCursor_static;
+    if (glfwCreateCursor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwCreateCursor");
+
+    glfwCreateStandardCursor_impl = glfwCreateStandardCursor_static;
+    if (glfwCreateStandardCursor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwCreateStandardCursor");
+
+    glfwDestroyCursor_impl = glfwDestroyCursor_static;
+    if (glfwDestroyCursor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwDestroyCursor");
+
+    glfwSetCursor_impl = glfwSetCursor_static;
+    if (glfwSetCursor_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetCursor");
+
+    glfwSetKeyboardCallback_impl = glfwSetKeyboardCallback_static;
+    if (glfwSetKeyboardCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetKeyboardCallback");
+
+    glfwUpdateIMEState_impl = glfwUpdateIMEState_static;
+    if (glfwUpdateIMEState_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwUpdateIMEState");
+
+    glfwSetMouseButtonCallback_impl = glfwSetMouseButtonCallback_static;
+    if (glfwSetMouseButtonCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetMouseButtonCallback");
+
+    glfwSetCursorPosCallback_impl = glfwSetCursorPosCallback_static;
+    if (glfwSetCursorPosCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetCursorPosCallback");
+
+    glfwSetCursorEnterCallback_impl = glfwSetCursorEnterCallback_static;
+    if (glfwSetCursorEnterCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetCursorEnterCallback");
+
+    glfwSetScrollCallback_impl = glfwSetScrollCallback_static;
+    if (glfwSetScrollCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetScrollCallback");
+
+    glfwSetDropCallback_impl = glfwSetDropCallback_static;
+    if (glfwSetDropCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetDropCallback");
+
+    glfwSetLiveResizeCallback_impl = glfwSetLiveResizeCallback_static;
+    if (glfwSetLiveResizeCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetLiveResizeCallback");
+
+    glfwJoystickPresent_impl = glfwJoystickPresent_static;
+    if (glfwJoystickPresent_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwJoystickPresent");
+
+    glfwGetJoystickAxes_impl = glfwGetJoystickAxes_static;
+    if (glfwGetJoystickAxes_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetJoystickAxes");
+
+    glfwGetJoystickButtons_impl = glfwGetJoystickButtons_static;
+    if (glfwGetJoystickButtons_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetJoystickButtons");
+
+    glfwGetJoystickHats_impl = glfwGetJoystickHats_static;
+    if (glfwGetJoystickHats_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetJoystickHats");
+
+    glfwGetJoystickName_impl = glfwGetJoystickName_static;
+    if (glfwGetJoystickName_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetJoystickName");
+
+    glfwGetJoystickGUID_impl = glfwGetJoystickGUID_static;
+    if (glfwGetJoystickGUID_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetJoystickGUID");
+
+    glfwSetJoystickUserPointer_impl = glfwSetJoystickUserPointer_static;
+    if (glfwSetJoystickUserPointer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetJoystickUserPointer");
+
+    glfwGetJoystickUserPointer_impl = glfwGetJoystickUserPointer_static;
+    if (glfwGetJoystickUserPointer_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetJoystickUserPointer");
+
+    glfwJoystickIsGamepad_impl = glfwJoystickIsGamepad_static;
+    if (glfwJoystickIsGamepad_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwJoystickIsGamepad");
+
+    glfwSetJoystickCallback_impl = glfwSetJoystickCallback_static;
+    if (glfwSetJoystickCallback_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetJoystickCallback");
+
+    glfwUpdateGamepadMappings_impl = glfwUpdateGamepadMappings_static;
+    if (glfwUpdateGamepadMappings_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwUpdateGamepadMappings");
+
+    glfwGetGamepadName_impl = glfwGetGamepadName_static;
+    if (glfwGetGamepadName_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetGamepadName");
+
+    glfwGetGamepadState_impl = glfwGetGamepadState_static;
+    if (glfwGetGamepadState_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetGamepadState");
+
+    glfwSetClipboardString_impl = glfwSetClipboardString_static;
+    if (glfwSetClipboardString_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSetClipboardString");
+
+    glfwGetClipboardString_impl = glfwGetClipboardString_static;
+    if (glfwGetClipboardString_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetClipboardString");
+
+    glfwRequestClipboardString_impl = glfwRequestClipboardString_static;
+    if (glfwRequestClipboardString_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwRequestClipboardString");
+
+    glfwResumeClipboardRequest_impl = glfwResumeClipboardRequest_static;
+    if (glfwResumeClipboardRequest_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwResumeClipboardRequest");
+
+    glfwGetTime_impl = glfwGetTime_static;
+    if (glfwGetTime_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetTime");
+
+    glfwMakeContextCurrent_impl = glfwMakeContextCurrent_static;
+    if (glfwMakeContextCurrent_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwMakeContextCurrent");
+
+    glfwGetCurrentContext_impl = glfwGetCurrentContext_static;
+    if (glfwGetCurrentContext_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetCurrentContext");
+
+    glfwSwapBuffers_impl = glfwSwapBuffers_static;
+    if (glfwSwapBuffers_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSwapBuffers");
+
+    glfwSwapBuffersWithDamage_impl = glfwSwapBuffersWithDamage_static;
+    if (glfwSwapBuffersWithDamage_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSwapBuffersWithDamage");
+
+    glfwSwapInterval_impl = glfwSwapInterval_static;
+    if (glfwSwapInterval_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwSwapInterval");
+
+    glfwExtensionSupported_impl = glfwExtensionSupported_static;
+    if (glfwExtensionSupported_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwExtensionSupported");
+
+    glfwGetProcAddress_impl = glfwGetProcAddress_static;
+    if (glfwGetProcAddress_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetProcAddress");
+
+    glfwVulkanSupported_impl = glfwVulkanSupported_static;
+    if (glfwVulkanSupported_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwVulkanSupported");
+
+    glfwGetRequiredInstanceExtensions_impl = glfwGetRequiredInstanceExtensions_static;
+    if (glfwGetRequiredInstanceExtensions_impl == NULL) fail("The statically linked GLFW is missing the function %s", "glfwGetRequiredInstanceExtensions");
+
+    glfwGetCocoaWindow_impl = glfwGetCocoaWindow_static;
+
+    glfwHideCocoaTitlebar_impl = glfwHideCocoaTitlebar_static;
+
+    glfwGetNSGLContext_impl = glfwGetNSGLContext_static;
+
+    glfwGetCocoaMonitor_impl = glfwGetCocoaMonitor_static;
+
+    glfwSetCocoaTextInputFilter_impl = glfwSetCocoaTextInputFilter_static;
+
+    glfwSetCocoaToggleFullscreenIntercept_impl = glfwSetCocoaToggleFullscreenIntercept_static;
+
+    glfwSetApplicationShouldHandleReopen_impl = glfwSetApplicationShouldHandleReopen_static;
+
+    glfwSetApplicationWillFinishLaunching_impl = glfwSetApplicationWillFinishLaunching_static;
+
+    glfwGetCocoaKeyEquivalent_impl = glfwGetCocoaKeyEquivalent_static;
+
+    glfwCocoaRequestRenderFrame_impl = glfwCocoaRequestRenderFrame_static;
+
+    glfwGetX11Display_impl = glfwGetX11Display_static;
+
+    glfwGetX11Window_impl = glfwGetX11Window_static;
+
+    glfwSetPrimarySelectionString_impl = glfwSetPrimarySelectionString_static;
+
+    glfwGetPrimarySelectionString_impl = glfwGetPrimarySelectionString_static;
+
+    glfwGetNativeKeyForName_impl = glfwGetNativeKeyForName_static;
+
+    glfwRequestWaylandFrameEvent_impl = glfwRequestWaylandFrameEvent_static;
+
+    glfwX11FrameEventsAvailable_impl = glfwX11FrameEventsAvailable_static;
+
+    glfwRequestX11FrameEvent_impl = glfwRequestX11FrameEvent_static;
+
+    glfwDBusUserNotify_impl = glfwDBusUserNotify_static;
+
+    glfwDBusSetUserNotificationHandler_impl = glfwDBusSetUserNotificationHandler_static;
+
+    return NULL;
+}
+
+void
+unload_glfw(void) {}
+
+#else  // dlopen based loading
+
 #include <dlfcn.h>
 
 static void* handle = NULL;
 
-#define fail(msg, ...) { snprintf(buf, sizeof(buf), msg, __VA_ARGS__); return buf; }
-
 const char*
 load_glfw(const char* path) {
     static char buf[2048];
@@ -33,6 +627,15 @@ load_glfw(const char* path) {
     *(void **) (&glfwRemoveTimer_impl) = dlsym(handle, "glfwRemoveTimer");
     if (glfwRemoveTimer_impl == NULL) fail("Failed to load glfw function glfwRemoveTimer with error: %s", dlerror());
 
+    *(void **) (&glfwAddLoopWatch_impl) = dlsym(handle, "glfwAddLoopWatch");
+    if (glfwAddLoopWatch_impl == NULL) fail("Failed to load glfw function glfwAddLoopWatch with error: %s", dlerror());
+
+    *(void **) (&glfwRemoveLoopWatch_impl) = dlsym(handle, "glfwRemoveLoopWatch");
+    if (glfwRemoveLoopWatch_impl == NULL) fail("Failed to load glfw function glfwRemoveLoopWatch with error: %s", dlerror());
+
+    *(void **) (&glfwToggleLoopWatch_impl) = dlsym(handle, "glfwToggleLoopWatch");
+    if (glfwToggleLoopWatch_impl == NULL) fail("Failed to load glfw function glfwToggleLoopWatch with error: %s", dlerror());
+
     *(void **) (&glfwTerminate_impl) = dlsym(handle, "glfwTerminate");
     if (glfwTerminate_impl == NULL) fail("Failed to load glfw function glfwTerminate with error: %s", dlerror());
 
@@ -351,6 +954,12 @@ load_glfw(const char* path) {
     *(void **) (&glfwGetClipboardString_impl) = dlsym(handle, "glfwGetClipboardString");
     if (glfwGetClipboardString_impl == NULL) fail("Failed to load glfw function glfwGetClipboardString with error: %s", dlerror());
 
+    *(void **) (&glfwRequestClipboardString_impl) = dlsym(handle, "glfwRequestClipboardString");
+    if (glfwRequestClipboardString_impl == NULL) fail("Failed to load glfw function glfwRequestClipboardString with error: %s", dlerror());
+
+    *(void **) (&glfwResumeClipboardRequest_impl) = dlsym(handle, "glfwResumeClipboardRequest");
+    if (glfwResumeClipboardRequest_impl == NULL) fail("Failed to load glfw function glfwResumeClipboardRequest with error: %s", dlerror());
+
     *(void **) (&glfwGetTime_impl) = dlsym(handle, "glfwGetTime");
     if (glfwGetTime_impl == NULL) fail("Failed to load glfw function glfwGetTime with error: %s", dlerror());
 
@@ -363,6 +972,9 @@ load_glfw(const char* path) {
     *(void **) (&glfwSwapBuffers_impl) = dlsym(handle, "glfwSwapBuffers");
     if (glfwSwapBuffers_impl == NULL) fail("Failed to load glfw function glfwSwapBuffers with error: %s", dlerror());
 
+    *(void **) (&glfwSwapBuffersWithDamage_impl) = dlsym(handle, "glfwSwapBuffersWithDamage");
+    if (glfwSwapBuffersWithDamage_impl == NULL) fail("Failed to load glfw function glfwSwapBuffersWithDamage with error: %s", dlerror());
+
     *(void **) (&glfwSwapInterval_impl) = dlsym(handle, "glfwSwapInterval");
     if (glfwSwapInterval_impl == NULL) fail("Failed to load glfw function glfwSwapInterval with error: %s", dlerror());
 
@@ -410,6 +1022,10 @@ load_glfw(const char* path) {
 
     *(void **) (&glfwRequestWaylandFrameEvent_impl) = dlsym(handle, "glfwRequestWaylandFrameEvent");
 
+    *(void **) (&glfwX11FrameEventsAvailable_impl) = dlsym(handle, "glfwX11FrameEventsAvailable");
+
+    *(void **) (&glfwRequestX11FrameEvent_impl) = dlsym(handle, "glfwRequestX11FrameEvent");
+
     *(void **) (&glfwDBusUserNotify_impl) = dlsym(handle, "glfwDBusUserNotify");
 
     *(void **) (&glfwDBusSetUserNotificationHandler_impl) = dlsym(handle, "glfwDBusSetUserNotificationHandler");
@@ -421,3 +1037,4 @@ void
 unload_glfw(void) {
     if (handle) { dlclose(handle); handle = NULL; }
 }
+#endif
@@ -1499,6 +1499,8 @@ typedef void (* GLFWjoystickfun)(int,int);
 
 typedef void (* GLFWuserdatafun)(unsigned long long, void*);
 typedef void (* GLFWtickcallback)(void*);
+typedef void (* GLFWloopwatchfun)(int fd, int events, void *data);
+typedef bool (* GLFWclipboardchunkfun)(const char *data, size_t sz, void *user_data);
 
 /*! @brief Video mode type.
  *
@@ -1589,6 +1591,26 @@ typedef struct GLFWimage
     unsigned char* pixels;
 } GLFWimage;
 
+/*! @brief Damage rectangle
+ *
+ *  This describes a rectangular region of a window's framebuffer that
+ *  changed since the previous swap, in framebuffer coordinates with the
+ *  origin at the bottom-left, matching OpenGL and EGL conventions.
+ *
+ *  @sa @ref glfwSwapBuffersWithDamage
+ *
+ *  @ingroup window
+ */
+typedef struct GLFWDamageRect
+{
+    /*! The bottom-left corner of this rectangle, in pixels.
+     */
+    int x, y;
+    /*! The size, in pixels, of this rectangle.
+     */
+    int width, height;
+} GLFWDamageRect;
+
 /*! @brief Gamepad input state
  *
  *  This describes the input state of a gamepad.
@@ -1683,6 +1705,18 @@ typedef void (*glfwRemoveTimer_func)(unsigned long);
 GFW_EXTERN glfwRemoveTimer_func glfwRemoveTimer_impl;
 #define glfwRemoveTimer glfwRemoveTimer_impl
 
+typedef unsigned long long (*glfwAddLoopWatch_func)(int, int, GLFWloopwatchfun, void*);
+GFW_EXTERN glfwAddLoopWatch_func glfwAddLoopWatch_impl;
+#define glfwAddLoopWatch glfwAddLoopWatch_impl
+
+typedef void (*glfwRemoveLoopWatch_func)(unsigned long long);
+GFW_EXTERN glfwRemoveLoopWatch_func glfwRemoveLoopWatch_impl;
+#define glfwRemoveLoopWatch glfwRemoveLoopWatch_impl
+
+typedef void (*glfwToggleLoopWatch_func)(unsigned long long, bool);
+GFW_EXTERN glfwToggleLoopWatch_func glfwToggleLoopWatch_impl;
+#define glfwToggleLoopWatch glfwToggleLoopWatch_impl
+
 typedef void (*glfwTerminate_func)(void);
 GFW_EXTERN glfwTerminate_func glfwTerminate_impl;
 #define glfwTerminate glfwTerminate_impl
@@ -2107,6 +2141,14 @@ typedef const char* (*glfwGetClipboardString_func)(GLFWwindow*);
 GFW_EXTERN glfwGetClipboardString_func glfwGetClipboardString_impl;
 #define glfwGetClipboardString glfwGetClipboardString_impl
 
+typedef bool (*glfwRequestClipboardString_func)(GLFWwindow*, bool, GLFWclipboardchunkfun, void*);
+GFW_EXTERN glfwRequestClipboardString_func glfwRequestClipboardString_impl;
+#define glfwRequestClipboardString glfwRequestClipboardString_impl
+
+typedef void (*glfwResumeClipboardRequest_func)(void);
+GFW_EXTERN glfwResumeClipboardRequest_func glfwResumeClipboardRequest_impl;
+#define glfwResumeClipboardRequest glfwResumeClipboardRequest_impl
+
 typedef monotonic_t (*glfwGetTime_func)(void);
 GFW_EXTERN glfwGetTime_func glfwGetTime_impl;
 #define glfwGetTime glfwGetTime_impl
@@ -2123,6 +2165,10 @@ typedef void (*glfwSwapBuffers_func)(GLFWwindow*);
 GFW_EXTERN glfwSwapBuffers_func glfwSwapBuffers_impl;
 #define glfwSwapBuffers glfwSwapBuffers_impl
 
+typedef bool (*glfwSwapBuffersWithDamage_func)(GLFWwindow*, const GLFWDamageRect*, int);
+GFW_EXTERN glfwSwapBuffersWithDamage_func glfwSwapBuffersWithDamage_impl;
+#define glfwSwapBuffersWithDamage glfwSwapBuffersWithDamage_impl
+
 typedef void (*glfwSwapInterval_func)(int);
 GFW_EXTERN glfwSwapInterval_func glfwSwapInterval_impl;
 #define glfwSwapInterval glfwSwapInterval_impl
@@ -2207,6 +2253,14 @@ typedef void (*glfwRequestWaylandFrameEvent_func)(GLFWwindow*, unsigned long lon
 GFW_EXTERN glfwRequestWaylandFrameEvent_func glfwRequestWaylandFrameEvent_impl;
 #define glfwRequestWaylandFrameEvent glfwRequestWaylandFrameEvent_impl
 
+typedef int (*glfwX11FrameEventsAvailable_func)(void);
+GFW_EXTERN glfwX11FrameEventsAvailable_func glfwX11FrameEventsAvailable_impl;
+#define glfwX11FrameEventsAvailable glfwX11FrameEventsAvailable_impl
+
+typedef void (*glfwRequestX11FrameEvent_func)(GLFWwindow*, unsigned long long, GLFWwaylandframecallbackfunc);
+GFW_EXTERN glfwRequestX11FrameEvent_func glfwRequestX11FrameEvent_impl;
+#define glfwRequestX11FrameEvent glfwRequestX11FrameEvent_impl
+
 typedef unsigned long long (*glfwDBusUserNotify_func)(const char*, const char*, const char*, const char*, const char*, int32_t, GLFWDBusnotificationcreatedfun, void*);
 GFW_EXTERN glfwDBusUserNotify_func glfwDBusUserNotify_impl;
 #define glfwDBusUserNotify glfwDBusUserNotify_impl
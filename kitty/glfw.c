@@ -163,8 +163,10 @@ window_close_callback(GLFWwindow* window) {
 }
 
 static void
-window_occlusion_callback(GLFWwindow *window, bool occluded UNUSED) {
+window_occlusion_callback(GLFWwindow *window, bool occluded) {
     if (!set_callback_window(window)) return;
+    // rendering is suppressed while occluded, so redraw immediately on reveal
+    if (!occluded) global_state.callback_os_window->is_damaged = true;
     request_tick_callback();
     global_state.callback_os_window = NULL;
 }
@@ -189,6 +191,61 @@ live_resize_callback(GLFWwindow *w, bool started) {
     global_state.callback_os_window = NULL;
 }
 
+static monotonic_t
+refresh_period_for_monitor(GLFWmonitor *m) {
+    if (m) {
+        const GLFWvidmode *mode = glfwGetVideoMode(m);
+        if (mode && mode->refreshRate > 0) return s_to_monotonic_t(1ll) / mode->refreshRate;
+    }
+    return 0;
+}
+
+static GLFWmonitor*
+monitor_for_os_window(OSWindow *w) {
+    GLFWmonitor *ans = glfwGetWindowMonitor(w->handle);
+    if (ans) return ans;  // fullscreen windows know their monitor
+    int num_monitors, wx, wy, wwidth, wheight;
+    GLFWmonitor **monitors = glfwGetMonitors(&num_monitors);
+    if (!monitors) return NULL;
+    glfwGetWindowPos(w->handle, &wx, &wy);
+    glfwGetWindowSize(w->handle, &wwidth, &wheight);
+    long best_overlap = 0;
+    for (int i = 0; i < num_monitors; i++) {
+        const GLFWvidmode *mode = glfwGetVideoMode(monitors[i]);
+        if (!mode) continue;
+        int mx, my;
+        glfwGetMonitorPos(monitors[i], &mx, &my);
+        long overlap_width = MIN(wx + wwidth, mx + mode->width) - MAX(wx, mx);
+        long overlap_height = MIN(wy + wheight, my + mode->height) - MAX(wy, my);
+        if (overlap_width > 0 && overlap_height > 0 && overlap_width * overlap_height > best_overlap) {
+            best_overlap = overlap_width * overlap_height;
+            ans = monitors[i];
+        }
+    }
+    return ans;
+}
+
+static void
+update_refresh_period(OSWindow *w) {
+    // the render cadence follows the monitor the window is currently on, see
+    // render() in child-monitor.c
+    if (w->handle) w->refresh_period = refresh_period_for_monitor(monitor_for_os_window(w));
+}
+
+static void
+window_pos_callback(GLFWwindow *w, int x UNUSED, int y UNUSED) {
+    if (!set_callback_window(w)) return;
+    // moving the window can change which monitor it is on
+    update_refresh_period(global_state.callback_os_window);
+    global_state.callback_os_window = NULL;
+}
+
+static void
+monitors_changed_callback(GLFWmonitor *monitor UNUSED, int event UNUSED) {
+    for (size_t i = 0; i < global_state.num_os_windows; i++) update_refresh_period(global_state.os_windows + i);
+    request_tick_callback();
+}
+
 static void
 framebuffer_size_callback(GLFWwindow *w, int width, int height) {
     if (!set_callback_window(w)) return;
@@ -201,6 +258,7 @@ framebuffer_size_callback(GLFWwindow *w, int width, int height) {
         window->live_resize.num_of_resize_events++;
         make_os_window_context_current(window);
         update_surface_size(width, height, window->offscreen_texture_id);
+        update_refresh_period(window);
         request_tick_callback();
     } else log_error("Ignoring resize request for tiny size: %dx%d", width, height);
     global_state.callback_os_window = NULL;
@@ -214,6 +272,7 @@ dpi_change_callback(GLFWwindow *w, float x_scale UNUSED, float y_scale UNUSED) {
     OSWindow *window = global_state.callback_os_window;
     window->live_resize.in_progress = true; global_state.has_pending_resizes = true;
     window->live_resize.last_resize_event_at = monotonic();
+    update_refresh_period(window);
     global_state.callback_os_window = NULL;
     request_tick_callback();
 }
@@ -274,7 +333,7 @@ cursor_enter_callback(GLFWwindow *w, int entered) {
     if (!set_callback_window(w)) return;
     if (entered) {
         show_mouse_cursor(w);
-        monotonic_t now = monotonic();
+        monotonic_t now = stamp_coarse_monotonic();
         global_state.callback_os_window->last_mouse_activity_at = now;
         if (is_window_ready_for_callbacks()) enter_event();
         request_tick_callback();
@@ -287,7 +346,7 @@ mouse_button_callback(GLFWwindow *w, int button, int action, int mods) {
     if (!set_callback_window(w)) return;
     show_mouse_cursor(w);
     mods_at_last_key_or_button_event = mods;
-    monotonic_t now = monotonic();
+    monotonic_t now = stamp_coarse_monotonic();
     global_state.callback_os_window->last_mouse_activity_at = now;
     if (button >= 0 && (unsigned int)button < arraysz(global_state.callback_os_window->mouse_button_pressed)) {
         global_state.callback_os_window->mouse_button_pressed[button] = action == GLFW_PRESS ? true : false;
@@ -301,7 +360,7 @@ static void
 cursor_pos_callback(GLFWwindow *w, double x, double y) {
     if (!set_callback_window(w)) return;
     show_mouse_cursor(w);
-    monotonic_t now = monotonic();
+    monotonic_t now = stamp_coarse_monotonic();
     global_state.callback_os_window->last_mouse_activity_at = now;
     global_state.callback_os_window->cursor_blink_zero_time = now;
     global_state.callback_os_window->mouse_x = x * global_state.callback_os_window->viewport_x_ratio;
@@ -315,7 +374,7 @@ static void
 scroll_callback(GLFWwindow *w, double xoffset, double yoffset, int flags, int mods) {
     if (!set_callback_window(w)) return;
     show_mouse_cursor(w);
-    monotonic_t now = monotonic();
+    monotonic_t now = stamp_coarse_monotonic();
     global_state.callback_os_window->last_mouse_activity_at = now;
     if (is_window_ready_for_callbacks()) scroll_event(xoffset, yoffset, flags, mods);
     request_tick_callback();
@@ -622,7 +681,11 @@ create_os_window(PyObject UNUSED *self, PyObject *args) {
     // changing, in case the background color is not black
     blank_canvas(is_semi_transparent ? OPT(background_opacity) : 1.0f, OPT(background));
 #ifndef __APPLE__
-    if (is_first_window) glfwSwapInterval(OPT(sync_to_monitor) && !global_state.is_wayland ? 1 : 0);
+    // with render frame events pacing is driven by presentation feedback,
+    // so swap with interval 0 and never block in SwapBuffers; without them
+    // (X11 servers lacking the Present extension) fall back to a blocking
+    // vsynced swap
+    if (is_first_window) glfwSwapInterval(OPT(sync_to_monitor) && !global_state.has_render_frames ? 1 : 0);
 #endif
     glfwSwapBuffers(glfw_window);
     if (!global_state.is_wayland) {
@@ -674,7 +737,8 @@ create_os_window(PyObject UNUSED *self, PyObject *args) {
     if (logo.pixels && logo.width && logo.height) glfwSetWindowIcon(glfw_window, 1, &logo);
     glfwSetCursor(glfw_window, standard_cursor);
     update_os_window_viewport(w, false);
-    // missing pos callback
+    update_refresh_period(w);
+    glfwSetWindowPosCallback(glfw_window, window_pos_callback);
     // missing size callback
     glfwSetWindowCloseCallback(glfw_window, window_close_callback);
     glfwSetWindowRefreshCallback(glfw_window, refresh_callback);
@@ -827,10 +891,17 @@ glfw_init(PyObject UNUSED *self, PyObject *args) {
 #endif
     PyObject *ans = glfwInit(monotonic_start_time) ? Py_True: Py_False;
     if (ans == Py_True) {
+        glfwSetMonitorCallback(monitors_changed_callback);
         OSWindow w = {0};
         set_os_window_dpi(&w);
         global_state.default_dpi.x = w.logical_dpi_x;
         global_state.default_dpi.y = w.logical_dpi_y;
+#ifndef __APPLE__
+        // on X11 render frames are driven by the Present extension, which
+        // may be missing on old servers
+        if (!global_state.is_wayland && glfwX11FrameEventsAvailable && glfwX11FrameEventsAvailable())
+            global_state.has_render_frames = true;
+#endif
     }
     Py_INCREF(ans);
     return ans;
@@ -889,6 +960,38 @@ get_clipboard_string(PYNOARG) {
     return Py_BuildValue("s", "");
 }
 
+static bool
+clipboard_chunk_callback(const char *data, size_t sz, void *user_data UNUSED) {
+    bool keep_going = true;
+    if (global_state.boss) {
+        PyObject *ret;
+        if (sz) ret = PyObject_CallMethod(global_state.boss, "clipboard_chunk_received", "y#", data, (Py_ssize_t)sz);
+        else ret = PyObject_CallMethod(global_state.boss, "clipboard_chunk_received", "O", Py_None);
+        if (ret == NULL) PyErr_Print();
+        else { keep_going = ret != Py_False; Py_DECREF(ret); }
+    }
+    return keep_going;
+}
+
+static PyObject*
+request_clipboard_string(PyObject UNUSED *self, PyObject *args) {
+    int primary = 0;
+    if (!PyArg_ParseTuple(args, "|p", &primary)) return NULL;
+    if (!glfwRequestClipboardString) {
+        log_error("Failed to load glfwRequestClipboardString");
+        Py_RETURN_FALSE;
+    }
+    OSWindow *w = current_os_window();
+    if (w && glfwRequestClipboardString(w->handle, primary != 0, clipboard_chunk_callback, NULL)) Py_RETURN_TRUE;
+    Py_RETURN_FALSE;
+}
+
+static PyObject*
+resume_clipboard_request(PYNOARG) {
+    if (glfwResumeClipboardRequest) glfwResumeClipboardRequest();
+    Py_RETURN_NONE;
+}
+
 static void
 ring_audio_bell(void) {
     static monotonic_t last_bell_at = -1;
@@ -982,7 +1085,27 @@ is_mouse_hidden(OSWindow *w) {
 
 void
 swap_window_buffers(OSWindow *os_window) {
-    glfwSwapBuffers(os_window->handle);
+    bool swapped = false;
+    if (os_window->frame_damage.count && !os_window->frame_damage.full) {
+        GLFWDamageRect rects[arraysz(os_window->frame_damage.rects)];
+        int count = 0;
+        for (size_t i = 0; i < os_window->frame_damage.count; i++) {
+            int left = MAX(0, os_window->frame_damage.rects[i].x);
+            int top = MAX(0, os_window->frame_damage.rects[i].y);
+            int right = MIN(os_window->frame_damage.rects[i].x + os_window->frame_damage.rects[i].width, os_window->viewport_width);
+            int bottom = MIN(os_window->frame_damage.rects[i].y + os_window->frame_damage.rects[i].height, os_window->viewport_height);
+            if (right <= left || bottom <= top) continue;
+            // flip from top-left origin to the GL convention of bottom-left
+            rects[count].x = left; rects[count].y = os_window->viewport_height - bottom;
+            rects[count].width = right - left; rects[count].height = bottom - top;
+            count++;
+        }
+        // falls back to a full swap internally when the platform cannot
+        // report damage, so no second swap is needed
+        if (count) { glfwSwapBuffersWithDamage(os_window->handle, rects, count); swapped = true; }
+    }
+    if (!swapped) glfwSwapBuffers(os_window->handle);
+    os_window->frame_damage.count = 0; os_window->frame_damage.full = false;
 }
 
 void
@@ -1141,7 +1264,7 @@ request_frame_render(OSWindow *w) {
 #else
 
 static void
-wayland_frame_request_callback(id_type os_window_id) {
+frame_request_callback(id_type os_window_id) {
     for (size_t i = 0; i < global_state.num_os_windows; i++) {
         if (global_state.os_windows[i].id == os_window_id) {
             global_state.os_windows[i].render_state = RENDER_FRAME_READY;
@@ -1157,7 +1280,8 @@ request_frame_render(OSWindow *w) {
     // Some Wayland compositors are too fragile to handle multiple
     // render frame requests, see https://github.com/kovidgoyal/kitty/issues/2329
     if (w->render_state != RENDER_FRAME_REQUESTED) {
-        glfwRequestWaylandFrameEvent(w->handle, w->id, wayland_frame_request_callback);
+        if (global_state.is_wayland) glfwRequestWaylandFrameEvent(w->handle, w->id, frame_request_callback);
+        else glfwRequestX11FrameEvent(w->handle, w->id, frame_request_callback);
         w->render_state = RENDER_FRAME_REQUESTED;
     }
 }
@@ -1220,6 +1344,8 @@ static PyMethodDef module_methods[] = {
     METHODB(create_os_window, METH_VARARGS),
     METHODB(set_default_window_icon, METH_VARARGS),
     METHODB(get_clipboard_string, METH_NOARGS),
+    METHODB(request_clipboard_string, METH_VARARGS),
+    METHODB(resume_clipboard_request, METH_NOARGS),
     METHODB(get_content_scale_for_window, METH_NOARGS),
     METHODB(ring_bell, METH_NOARGS),
     METHODB(set_clipboard_string, METH_VARARGS),
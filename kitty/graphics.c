@@ -8,6 +8,9 @@
 #include "graphics.h"
 #include "state.h"
 #include "disk-cache.h"
+#include "threading.h"
+#include "tracepoints.h"
+#include "uthash.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -39,9 +42,42 @@ grman_alloc() {
     }
     self->disk_cache = create_disk_cache();
     if (!self->disk_cache) { Py_CLEAR(self); return NULL; }
+    self->lru_head = NO_LRU_LINK; self->lru_tail = NO_LRU_LINK;
+    self->free_slot_head = NO_LRU_LINK;
     return self;
 }
 
+// Hash indices mapping client and internal ids to slots in the images array,
+// so that lookups, which run for every graphics escape code, do not scan the
+// whole array. Entries are allocated separately since the array itself moves
+// when it is reallocated.
+typedef struct ImageIndex {
+    id_type key;
+    size_t idx;
+    UT_hash_handle hh;
+} ImageIndex;
+
+static inline void
+image_index_add(ImageIndex **head, id_type key, size_t idx) {
+    ImageIndex *e = malloc(sizeof(ImageIndex));
+    if (e == NULL) fatal("Out of memory allocating image index entry");
+    e->key = key; e->idx = idx;
+    HASH_ADD(hh, *head, key, sizeof(e->key), e);
+}
+
+static inline ImageIndex*
+image_index_find(ImageIndex *head, id_type key) {
+    ImageIndex *e;
+    HASH_FIND(hh, head, &key, sizeof(key), e);
+    return e;
+}
+
+static inline void
+image_index_del(ImageIndex **head, id_type key) {
+    ImageIndex *e = image_index_find(*head, key);
+    if (e) { HASH_DEL(*head, e); free(e); }
+}
+
 static inline void
 free_refs_data(Image *img) {
     free(img->refs); img->refs = NULL;
@@ -55,24 +91,174 @@ free_load_data(LoadData *ld) {
 
     if (ld->mapped_file) munmap(ld->mapped_file, ld->mapped_file_sz);
     ld->mapped_file = NULL; ld->mapped_file_sz = 0;
+    if (ld->zstream) { inflateEnd(ld->zstream); free(ld->zstream); ld->zstream = NULL; }
+    ld->inflation_complete = false;
+}
+
+// Image atlas {{{
+
+// Small images are packed into one shared texture so placements of many of
+// them, such as inline icons and chart glyphs, render without a texture bind
+// per image. Regions are handed out by a shelf allocator with a one pixel
+// gutter so GL_NEAREST sampling cannot bleed between neighbours, and regions
+// of removed images are kept on a free list for first fit reuse.
+
+#define ATLAS_SIZE 2048u
+#define ATLAS_MAX_IMAGE_DIM 128u
+
+static bool
+atlas_alloc(ImageAtlas *atlas, uint32_t width, uint32_t height, uint32_t *x, uint32_t *y) {
+    uint32_t w = width + 1, h = height + 1;
+    for (size_t i = 0; i < atlas->free_rect_count; i++) {
+        AtlasRect *r = atlas->free_rects + i;
+        if (r->width >= w && r->height >= h) {
+            *x = r->x; *y = r->y;
+            remove_i_from_array(atlas->free_rects, i, atlas->free_rect_count);
+            return true;
+        }
+    }
+    if (atlas->row_x + w > atlas->width) { atlas->row_y += atlas->row_height; atlas->row_x = 0; atlas->row_height = 0; }
+    if (atlas->row_y + h > atlas->height || w > atlas->width) return false;
+    *x = atlas->row_x; *y = atlas->row_y;
+    atlas->row_x += w;
+    if (h > atlas->row_height) atlas->row_height = h;
+    return true;
+}
+
+static void
+atlas_free_region(ImageAtlas *atlas, AtlasRect rect) {
+    ensure_space_for(atlas, free_rects, AtlasRect, atlas->free_rect_count + 1, free_rect_capacity, 16, true);
+    rect.width += 1; rect.height += 1;  // include the gutter
+    atlas->free_rects[atlas->free_rect_count++] = rect;
+}
+
+// }}}
+
+// Shared textures {{{
+
+// Clients tend to retransmit identical images under fresh ids, so decoded
+// bitmaps are hashed and identical ones share a single refcounted GL texture,
+// making a retransmission cost a hash instead of a VRAM upload. Shared data
+// is counted once against the storage quota, via the shared entry rather
+// than the individual images.
+
+typedef struct SharedTexture {
+    uint64_t key;  // hash of the decoded bitmap
+    uint32_t texture_id;
+    uint32_t width, height;
+    size_t data_sz, refcnt;
+    bool in_atlas;
+    AtlasRect atlas_rect;
+    UT_hash_handle hh;
+} SharedTexture;
+
+static uint64_t
+bitmap_hash(const uint8_t *data, size_t sz) {
+    // FNV-1a 64-bit
+    uint64_t ans = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < sz; i++) {
+        ans ^= data[i];
+        ans *= 0x100000001b3ull;
+    }
+    return ans;
+}
+
+static void
+release_image_texture(GraphicsManager *self, Image *img) {
+    if (img->bitmap_hash) {
+        SharedTexture *st;
+        HASH_FIND(hh, self->shared_textures, &img->bitmap_hash, sizeof(img->bitmap_hash), st);
+        if (st && !--st->refcnt) {
+            if (st->in_atlas) atlas_free_region(&self->atlas, st->atlas_rect);
+            else if (st->texture_id) free_texture(&st->texture_id);
+            self->used_storage -= st->data_sz;
+            HASH_DEL(self->shared_textures, st);
+            free(st);
+        }
+        img->texture_id = 0; img->bitmap_hash = 0; img->in_atlas = false;
+    } else if (img->in_atlas) {
+        atlas_free_region(&self->atlas, img->atlas_rect);
+        img->texture_id = 0; img->in_atlas = false;
+    } else if (img->texture_id) free_texture(&img->texture_id);
 }
 
+static void
+upload_image_bitmap(GraphicsManager *self, Image *img, uint64_t hash, size_t required_sz) {
+    release_image_texture(self, img);  // retransmission into an image that already has a texture
+    SharedTexture *st = NULL;
+    if (hash) HASH_FIND(hh, self->shared_textures, &hash, sizeof(hash), st);
+    if (st && (st->width != img->width || st->height != img->height || st->data_sz != required_sz)) { st = NULL; hash = 0; }  // hash collision, do not share
+    if (st) {
+        st->refcnt++;
+        img->texture_id = st->texture_id;
+        img->bitmap_hash = hash;
+        img->in_atlas = st->in_atlas; img->atlas_rect = st->atlas_rect;
+    } else {
+        AtlasRect rect = {.width=img->width, .height=img->height};
+        bool in_atlas = false;
+        if (!img->load_data.is_opaque && img->width <= ATLAS_MAX_IMAGE_DIM && img->height <= ATLAS_MAX_IMAGE_DIM) {
+            if (!self->atlas.texture_id) {
+                self->atlas.width = ATLAS_SIZE; self->atlas.height = ATLAS_SIZE;
+                create_image_atlas_texture(&self->atlas.texture_id, ATLAS_SIZE, ATLAS_SIZE);
+            }
+            in_atlas = atlas_alloc(&self->atlas, img->width, img->height, &rect.x, &rect.y);
+        }
+        if (in_atlas) {
+            send_image_to_gpu_atlas_region(self->atlas.texture_id, img->load_data.data, rect.x, rect.y, img->width, img->height, img->load_data.is_4byte_aligned);
+            img->texture_id = self->atlas.texture_id;
+            img->in_atlas = true; img->atlas_rect = rect;
+        } else {
+            send_image_to_gpu(&img->texture_id, img->load_data.data, img->width, img->height, img->load_data.is_opaque, img->load_data.is_4byte_aligned, false, REPEAT_CLAMP);
+        }
+        if (hash) {
+            st = malloc(sizeof(SharedTexture));
+            if (st == NULL) fatal("Out of memory allocating shared texture entry");
+            st->key = hash; st->texture_id = img->texture_id;
+            st->width = img->width; st->height = img->height;
+            st->data_sz = required_sz; st->refcnt = 1;
+            st->in_atlas = in_atlas; st->atlas_rect = rect;
+            HASH_ADD(hh, self->shared_textures, key, sizeof(st->key), st);
+            img->bitmap_hash = hash;
+        }
+        self->used_storage += required_sz;
+    }
+    free_load_data(&img->load_data);
+    img->used_storage = 0;  // shared data is accounted for on the SharedTexture entry
+}
+
+// }}}
+
 static inline void
 free_image(GraphicsManager *self, Image *img) {
-    if (img->texture_id) free_texture(&img->texture_id);
+    release_image_texture(self, img);
     free_refs_data(img);
     free_load_data(&(img->load_data));
     self->used_storage -= img->used_storage;
 }
 
 
+static void cancel_decode_jobs(GraphicsManager *self);
+
 static void
 dealloc(GraphicsManager* self) {
     size_t i;
+    cancel_decode_jobs(self);
     if (self->images) {
-        for (i = 0; i < self->image_count; i++) free_image(self, self->images + i);
+        for (i = 0; i < self->image_slot_count; i++) {
+            if (self->images[i].internal_id) free_image(self, self->images + i);
+        }
         free(self->images);
     }
+    ImageIndex *e, *tmp;
+    HASH_ITER(hh, self->by_client_id, e, tmp) { HASH_DEL(self->by_client_id, e); free(e); }
+    HASH_ITER(hh, self->by_internal_id, e, tmp) { HASH_DEL(self->by_internal_id, e); free(e); }
+    SharedTexture *st, *stmp;
+    HASH_ITER(hh, self->shared_textures, st, stmp) {
+        if (st->texture_id && !st->in_atlas) free_texture(&st->texture_id);
+        HASH_DEL(self->shared_textures, st); free(st);
+    }
+    if (self->atlas.texture_id) free_texture(&self->atlas.texture_id);
+    free(self->atlas.free_rects);
     free(self->render_data);
     Py_CLEAR(self->disk_cache);
     Py_TYPE(self)->tp_free((PyObject*)self);
@@ -82,42 +268,84 @@ static id_type internal_id_counter = 1;
 
 static inline Image*
 img_by_internal_id(GraphicsManager *self, id_type id) {
-    for (size_t i = 0; i < self->image_count; i++) {
-        if (self->images[i].internal_id == id) return self->images + i;
-    }
-    return NULL;
+    ImageIndex *e = image_index_find(self->by_internal_id, id);
+    return e ? self->images + e->idx : NULL;
 }
 
 static inline Image*
 img_by_client_id(GraphicsManager *self, uint32_t id) {
-    for (size_t i = 0; i < self->image_count; i++) {
-        if (self->images[i].client_id == id) return self->images + i;
-    }
-    return NULL;
+    ImageIndex *e = image_index_find(self->by_client_id, id);
+    return e ? self->images + e->idx : NULL;
 }
 
 static inline Image*
 img_by_client_number(GraphicsManager *self, uint32_t number) {
-    // get the newest image with the specified number
-    for (size_t i = self->image_count; i-- > 0; ) {
-        if (self->images[i].client_number == number) return self->images + i;
+    // get the newest image with the specified number, internal ids are
+    // monotonic so the largest one wins
+    Image *ans = NULL;
+    for (size_t i = 0; i < self->image_slot_count; i++) {
+        Image *img = self->images + i;
+        if (img->client_number == number && img->internal_id && (!ans || img->internal_id > ans->internal_id)) ans = img;
     }
-    return NULL;
+    return ans;
 }
 
 
+// The images array is threaded as a doubly linked LRU list of array indices,
+// most recently used at the head, so that storage quota enforcement can evict
+// from the tail without sorting. Every image in the array is always on the
+// list, and the stored indices are patched up when removal compacts the array.
+
+static inline void
+lru_unlink(GraphicsManager *self, size_t idx) {
+    Image *img = self->images + idx;
+    if (img->lru_prev != NO_LRU_LINK) self->images[img->lru_prev].lru_next = img->lru_next;
+    else self->lru_head = img->lru_next;
+    if (img->lru_next != NO_LRU_LINK) self->images[img->lru_next].lru_prev = img->lru_prev;
+    else self->lru_tail = img->lru_prev;
+    img->lru_prev = NO_LRU_LINK; img->lru_next = NO_LRU_LINK;
+}
+
+static inline void
+lru_push_front(GraphicsManager *self, size_t idx) {
+    Image *img = self->images + idx;
+    img->lru_prev = NO_LRU_LINK; img->lru_next = self->lru_head;
+    if (self->lru_head != NO_LRU_LINK) self->images[self->lru_head].lru_prev = idx;
+    self->lru_head = idx;
+    if (self->lru_tail == NO_LRU_LINK) self->lru_tail = idx;
+}
+
+static inline void
+mark_image_used(GraphicsManager *self, Image *img) {
+    img->atime = coarse_monotonic();
+    size_t idx = img - self->images;
+    if (self->lru_head == idx) return;
+    lru_unlink(self, idx);
+    lru_push_front(self, idx);
+}
+
 static inline void
 remove_image(GraphicsManager *self, size_t idx) {
-    free_image(self, self->images + idx);
-    remove_i_from_array(self->images, idx, self->image_count);
+    Image *img = self->images + idx;
+    if (!img->internal_id) return;  // already a tombstone
+    lru_unlink(self, idx);
+    image_index_del(&self->by_internal_id, img->internal_id);
+    if (img->client_id) image_index_del(&self->by_client_id, img->client_id);
+    free_image(self, img);
+    // leave a tombstone and put the slot on the free list for reuse, instead
+    // of compacting the array, so that slot indices stay stable
+    zero_at_ptr(img);
+    img->lru_next = self->free_slot_head;
+    self->free_slot_head = idx;
+    self->image_count--;
     self->layers_dirty = true;
 }
 
 static inline void
 remove_images(GraphicsManager *self, bool(*predicate)(Image*), id_type skip_image_internal_id) {
-    for (size_t i = self->image_count; i-- > 0;) {
+    for (size_t i = self->image_slot_count; i-- > 0;) {
         Image *img = self->images + i;
-        if (img->internal_id != skip_image_internal_id && predicate(img)) {
+        if (img->internal_id && img->internal_id != skip_image_internal_id && predicate(img)) {
             remove_image(self, i);
         }
     }
@@ -128,25 +356,25 @@ remove_images(GraphicsManager *self, bool(*predicate)(Image*), id_type skip_imag
 
 static bool
 trim_predicate(Image *img) {
+    if (img->decode_pending) return false;
     return !img->data_loaded || !img->refcnt;
 }
 
 
-static int
-oldest_last(const void* a, const void *b) {
-    monotonic_t ans = ((Image*)(b))->atime - ((Image*)(a))->atime;
-    return ans < 0 ? -1 : (ans == 0 ? 0 : 1);
-}
-
 static inline void
 apply_storage_quota(GraphicsManager *self, size_t storage_limit, id_type currently_added_image_internal_id) {
     // First remove unreferenced images, even if they have an id
     remove_images(self, trim_predicate, currently_added_image_internal_id);
     if (self->used_storage < storage_limit) return;
 
-    qsort(self->images, self->image_count, sizeof(self->images[0]), oldest_last);
-    while (self->used_storage > storage_limit && self->image_count > 0) {
-        remove_image(self, self->image_count - 1);
+    // Evict least recently used images from the tail of the LRU list. The
+    // currently added image is never evicted, the command processing it is
+    // still in progress.
+    size_t idx = self->lru_tail;
+    while (self->used_storage > storage_limit && idx != NO_LRU_LINK) {
+        size_t prev = self->images[idx].lru_prev;
+        if (self->images[idx].internal_id != currently_added_image_internal_id) remove_image(self, idx);
+        idx = prev;
     }
     if (!self->image_count) self->used_storage = 0;  // sanity check
 }
@@ -230,6 +458,35 @@ err:
     return ok;
 }
 
+// Inflate a chunk of a compressed direct transmission as it arrives,
+// appending the decompressed output straight into the destination buffer,
+// which is pre-sized from the expected width * height * bytes-per-pixel. This
+// avoids holding the full compressed payload alongside the decompressed one
+// and the one shot inflate at the end of transmission.
+static inline bool
+inflate_zlib_chunk(Image *img, const uint8_t *buf, size_t bufsz, bool is_last) {
+    LoadData *ld = &img->load_data;
+    z_stream *z = ld->zstream;
+    z->avail_in = bufsz;
+    z->next_in = (Bytef*)buf;
+    z->avail_out = ld->buf_capacity - ld->buf_used;
+    z->next_out = ld->buf + ld->buf_used;
+    int ret = inflate(z, is_last ? Z_FINISH : Z_NO_FLUSH);
+    if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) ABRT(EINVAL, "Failed to inflate image data with error: %s", zlib_strerror(ret));
+    if (z->avail_in && !z->avail_out) ABRT(EFBIG, "Image data post inflation is larger than the expected size");
+    ld->buf_used = ld->buf_capacity - z->avail_out;
+    if (is_last) {
+        if (ret != Z_STREAM_END) ABRT(EINVAL, "Compressed image data stream is incomplete");
+        if (z->avail_out) ABRT(EINVAL, "Image data size post inflation does not match expected size");
+        inflateEnd(z); free(z); ld->zstream = NULL;
+        ld->inflation_complete = true;
+    }
+    return true;
+err:
+    inflateEnd(z); free(z); ld->zstream = NULL;
+    return false;
+}
+
 static void
 png_error_handler(const char *code, const char *msg) {
     set_command_failed_response(code, "%s", msg);
@@ -256,9 +513,193 @@ inflate_png(GraphicsManager UNUSED *self, Image *img, uint8_t *buf, size_t bufsz
 
 static bool
 add_trim_predicate(Image *img) {
+    if (img->decode_pending) return false;
     return !img->data_loaded || (!img->client_id && !img->refcnt);
 }
 
+// Asynchronous decoding {{{
+
+// Decoding a large PNG or inflating a large zlib compressed payload can take
+// long enough to noticeably stall rendering, so once transmission is complete
+// the data is handed to a worker thread and the response to the client is
+// delivered when decoding finishes. Only whole payloads are handed off,
+// chunked zlib transmissions are already inflated incrementally as the chunks
+// arrive.
+
+enum FORMATS { RGB=24, RGBA=32, PNG=100 };
+
+typedef struct DecodeJob {
+    struct DecodeJob *next;
+    GraphicsManager *grman;  // set to NULL if the manager is deallocated while the job is outstanding
+    id_type image_id, window_id;
+    GraphicsCommand cmd;
+    bool is_query;
+    uint32_t q_iid;
+
+    uint8_t *input; size_t input_sz;  // owned by the job
+    bool input_is_mapped;
+    size_t expected_sz;  // the expected size of the zlib decompressed data
+    uint32_t fmt;
+    unsigned char compressed;
+
+    bool ok;
+    uint8_t *output; size_t output_sz;
+    uint32_t width, height;
+    uint64_t bitmap_hash;  // hash of the decoded bitmap, computed off the main thread
+    char error[512];
+} DecodeJob;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+    DecodeJob *pending, *completed, *currently_decoding;
+} decoder = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
+#define decoder_mutex(op) pthread_mutex_##op(&decoder.lock)
+
+static void wait_for_image_decode(GraphicsManager *self, Image *img);
+
+static void
+free_decode_job(DecodeJob *j) {
+    if (j->input) {
+        if (j->input_is_mapped) munmap(j->input, j->input_sz);
+        else free(j->input);
+    }
+    free(j->output);
+    free(j);
+}
+
+static void
+set_decode_job_failed(DecodeJob *j, const char *code, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int num = snprintf(j->error, sizeof(j->error), "%s:", code);
+    vsnprintf(j->error + num, sizeof(j->error) - num, fmt, args);
+    va_end(args);
+}
+
+// inflate_png_inner() reports errors via a callback that has no closure
+// argument, so the job being decoded is tracked in a variable private to the
+// decode thread
+static DecodeJob *current_decode_job = NULL;
+
+static void
+decode_job_error_handler(const char *code, const char *msg) {
+    snprintf(current_decode_job->error, sizeof(current_decode_job->error), "%s:%s", code, msg);
+}
+
+static void
+run_decode_job(DecodeJob *j) {
+    if (j->compressed == 'z') {
+        uint8_t *decompressed = malloc(j->expected_sz);
+        if (decompressed == NULL) fatal("Out of memory allocating decompression buffer");
+        z_stream z = {.avail_in=j->input_sz, .next_in=(Bytef*)j->input, .avail_out=j->expected_sz, .next_out=decompressed};
+        int ret;
+        if ((ret = inflateInit(&z)) != Z_OK) {
+            set_decode_job_failed(j, "ENOMEM", "Failed to initialize inflate with error: %s", zlib_strerror(ret));
+            free(decompressed); return;
+        }
+        if ((ret = inflate(&z, Z_FINISH)) != Z_STREAM_END) {
+            set_decode_job_failed(j, "EINVAL", "Failed to inflate image data with error: %s", zlib_strerror(ret));
+            inflateEnd(&z); free(decompressed); return;
+        }
+        bool size_mismatch = z.avail_out != 0;
+        inflateEnd(&z);
+        if (size_mismatch) {
+            set_decode_job_failed(j, "EINVAL", "Image data size post inflation does not match expected size");
+            free(decompressed); return;
+        }
+        if (j->input_is_mapped) { munmap(j->input, j->input_sz); j->input_is_mapped = false; }
+        else free(j->input);
+        j->input = decompressed; j->input_sz = j->expected_sz;
+    }
+    if (j->fmt == PNG) {
+        png_read_data d = {.err_handler=decode_job_error_handler};
+        current_decode_job = j;
+        inflate_png_inner(&d, j->input, j->input_sz);
+        current_decode_job = NULL;
+        free(d.row_pointers);
+        if (!d.ok) { free(d.decompressed); return; }
+        j->output = d.decompressed; j->output_sz = d.sz;
+        j->width = d.width; j->height = d.height;
+    } else {
+        j->output = j->input; j->output_sz = j->input_sz;
+        j->input = NULL; j->input_is_mapped = false;
+    }
+    j->bitmap_hash = bitmap_hash(j->output, j->output_sz);
+    j->ok = true;
+}
+
+static void*
+decode_loop(void *data UNUSED) {
+    set_thread_name("KittyImageDecode");
+    while (true) {
+        decoder_mutex(lock);
+        while (!decoder.pending) pthread_cond_wait(&decoder.cond, &decoder.lock);
+        DecodeJob *j = decoder.pending;
+        decoder.pending = j->next; j->next = NULL;
+        decoder.currently_decoding = j;
+        decoder_mutex(unlock);
+        run_decode_job(j);
+        decoder_mutex(lock);
+        decoder.currently_decoding = NULL;
+        DecodeJob **p = &decoder.completed;
+        while (*p) p = &(*p)->next;
+        *p = j;
+        // both the main thread in wait_for_image_decode() and this thread
+        // wait on the same condition, so always broadcast
+        pthread_cond_broadcast(&decoder.cond);
+        decoder_mutex(unlock);
+        wakeup_main_loop();
+    }
+    return NULL;
+}
+
+static bool
+queue_decode_job(GraphicsManager *self, Image *img, uint32_t fmt, bool is_query, uint32_t q_iid) {
+    if (!decoder.thread_started) {
+        if (pthread_create(&decoder.thread, NULL, decode_loop, NULL) != 0) return false;
+        decoder.thread_started = true;
+    }
+    DecodeJob *j = calloc(1, sizeof(DecodeJob));
+    if (j == NULL) return false;
+    LoadData *ld = &img->load_data;
+    if (ld->buf) {
+        j->input = ld->buf; j->input_sz = ld->buf_used;
+        ld->buf = NULL; ld->buf_used = 0; ld->buf_capacity = 0;
+    } else {
+        j->input = ld->mapped_file; j->input_sz = ld->mapped_file_sz;
+        j->input_is_mapped = true;
+        ld->mapped_file = NULL; ld->mapped_file_sz = 0;
+    }
+    j->grman = self; j->image_id = img->internal_id; j->window_id = self->window_id;
+    j->cmd = self->last_init_graphics_command;
+    j->is_query = is_query; j->q_iid = q_iid;
+    j->expected_sz = ld->data_sz;
+    j->fmt = fmt; j->compressed = self->last_init_graphics_command.compressed;
+    img->decode_pending = true;
+    decoder_mutex(lock);
+    DecodeJob **p = &decoder.pending;
+    while (*p) p = &(*p)->next;
+    *p = j;
+    pthread_cond_broadcast(&decoder.cond);
+    decoder_mutex(unlock);
+    return true;
+}
+
+static void
+cancel_decode_jobs(GraphicsManager *self) {
+    if (!decoder.thread_started) return;
+    decoder_mutex(lock);
+    for (DecodeJob *j = decoder.pending; j; j = j->next) if (j->grman == self) j->grman = NULL;
+    for (DecodeJob *j = decoder.completed; j; j = j->next) if (j->grman == self) j->grman = NULL;
+    if (decoder.currently_decoding && decoder.currently_decoding->grman == self) decoder.currently_decoding->grman = NULL;
+    decoder_mutex(unlock);
+}
+
+// }}}
+
 bool
 png_path_to_bitmap(const char* path, uint8_t** data, unsigned int* width, unsigned int* height, size_t* sz) {
     FILE* fp = fopen(path, "r");
@@ -306,17 +747,22 @@ png_path_to_bitmap(const char* path, uint8_t** data, unsigned int* width, unsign
 static inline Image*
 find_or_create_image(GraphicsManager *self, uint32_t id, bool *existing) {
     if (id) {
-        for (size_t i = 0; i < self->image_count; i++) {
-            if (self->images[i].client_id == id) {
-                *existing = true;
-                return self->images + i;
-            }
-        }
+        Image *img = img_by_client_id(self, id);
+        if (img) { *existing = true; return img; }
     }
     *existing = false;
-    ensure_space_for(self, images, Image, self->image_count + 1, images_capacity, 64, true);
-    Image *ans = self->images + self->image_count++;
+    size_t idx;
+    if (self->free_slot_head != NO_LRU_LINK) {
+        idx = self->free_slot_head;
+        self->free_slot_head = self->images[idx].lru_next;
+    } else {
+        ensure_space_for(self, images, Image, self->image_slot_count + 1, images_capacity, 64, true);
+        idx = self->image_slot_count++;
+    }
+    self->image_count++;
+    Image *ans = self->images + idx;
     zero_at_ptr(ans);
+    lru_push_front(self, idx);
     return ans;
 }
 
@@ -331,9 +777,9 @@ get_free_client_id(const GraphicsManager *self) {
     if (!self->image_count) return 1;
     uint32_t *client_ids = malloc(sizeof(uint32_t) * self->image_count);
     size_t count = 0;
-    for (size_t i = 0; i < self->image_count; i++) {
+    for (size_t i = 0; i < self->image_slot_count; i++) {
         Image *q = self->images + i;
-        if (q->client_id) client_ids[count++] = q->client_id;
+        if (q->internal_id && q->client_id) client_ids[count++] = q->client_id;
     }
     if (!count) { free(client_ids); return 1; }
     qsort(client_ids, count, sizeof(uint32_t), cmp_client_ids);
@@ -350,13 +796,14 @@ get_free_client_id(const GraphicsManager *self) {
 
 static Image*
 handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_t *payload, bool *is_dirty, uint32_t iid) {
+    TRACE_EVENT2(graphics_add_command, iid, g->payload_sz);
 #define ABRT(code, ...) { set_command_failed_response(#code, __VA_ARGS__); self->loading_image = 0; if (img) img->data_loaded = false; return NULL; }
 #define MAX_DATA_SZ (4u * 100000000u)
     bool existing, init_img = true;
     Image *img = NULL;
     unsigned char tt = g->transmission_type ? g->transmission_type : 'd';
-    enum FORMATS { RGB=24, RGBA=32, PNG=100 };
     uint32_t fmt = g->format ? g->format : RGBA;
+    const uint32_t client_cmd_id = g->id;
     if (tt == 'd' && self->loading_image) init_img = false;
     if (init_img) {
         self->last_init_graphics_command = *g;
@@ -366,6 +813,7 @@ handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_
         remove_images(self, add_trim_predicate, 0);
         img = find_or_create_image(self, iid, &existing);
         if (existing) {
+            if (img->decode_pending) wait_for_image_decode(self, img);
             free_load_data(&img->load_data);
             img->data_loaded = false;
             free_refs_data(img);
@@ -379,8 +827,10 @@ handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_
                 img->client_id = get_free_client_id(self);
                 self->last_init_graphics_command.id = img->client_id;
             }
+            image_index_add(&self->by_internal_id, img->internal_id, (size_t)(img - self->images));
+            if (img->client_id) image_index_add(&self->by_client_id, img->client_id, (size_t)(img - self->images));
         }
-        img->atime = monotonic(); img->used_storage = 0;
+        mark_image_used(self, img); img->used_storage = 0;
         img->width = g->data_width; img->height = g->data_height;
         switch(fmt) {
             case PNG:
@@ -401,13 +851,25 @@ handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_
         }
         if (tt == 'd') {
             if (g->more) self->loading_image = img->internal_id;
-            img->load_data.buf_capacity = img->load_data.data_sz + (g->compressed ? 1024 : 10);  // compression header
+            bool streaming_inflate = g->compressed == 'z' && fmt != PNG;
+            // for streaming inflate the buffer holds decompressed output and
+            // is sized exactly from the expected image dimensions
+            img->load_data.buf_capacity = streaming_inflate ? img->load_data.data_sz : img->load_data.data_sz + (g->compressed ? 1024 : 10);  // compression header
             img->load_data.buf = malloc(img->load_data.buf_capacity);
             img->load_data.buf_used = 0;
             if (img->load_data.buf == NULL) {
                 ABRT(ENOMEM, "Out of memory");
                 img->load_data.buf_capacity = 0; img->load_data.buf_used = 0;
             }
+            if (streaming_inflate) {
+                img->load_data.zstream = calloc(1, sizeof(z_stream));
+                if (img->load_data.zstream == NULL) ABRT(ENOMEM, "Out of memory");
+                int ret = inflateInit(img->load_data.zstream);
+                if (ret != Z_OK) {
+                    free(img->load_data.zstream); img->load_data.zstream = NULL;
+                    ABRT(ENOMEM, "Failed to initialize inflate with error: %s", zlib_strerror(ret));
+                }
+            }
         }
     } else {
         self->last_init_graphics_command.more = g->more;
@@ -425,6 +887,14 @@ handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_
     static char fname[2056] = {0};
     switch(tt) {
         case 'd':  // direct
+            if (img->load_data.zstream) {
+                if (!inflate_zlib_chunk(img, payload, g->payload_sz, !g->more)) {
+                    self->loading_image = 0; img->data_loaded = false;
+                    return NULL;
+                }
+                if (!g->more) { img->data_loaded = true; self->loading_image = 0; }
+                break;
+            }
             if (img->load_data.buf_capacity - img->load_data.buf_used < g->payload_sz) {
                 if (img->load_data.buf_used + g->payload_sz > MAX_DATA_SZ || fmt != PNG) ABRT(EFBIG, "Too much data");
                 img->load_data.buf_capacity = MIN(2 * img->load_data.buf_capacity, MAX_DATA_SZ);
@@ -461,10 +931,17 @@ handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_
     self->loading_image = 0;
     bool needs_processing = g->compressed || fmt == PNG;
     if (needs_processing) {
+        bool has_decode_work = fmt == PNG || (g->compressed && !img->load_data.inflation_complete);
+        bool async_eligible = g->action == 0 || g->action == 't' || g->action == 'q';  // 'T' needs the decoded dimensions at the cursor position
+        if (send_to_gpu && has_decode_work && async_eligible && queue_decode_job(self, img, fmt, self->last_init_graphics_command.action == 'q', client_cmd_id)) {
+            img->data_loaded = false;  // becomes true when the decode completes
+            return img;
+        }
         uint8_t *buf; size_t bufsz;
 #define IB { if (img->load_data.buf) { buf = img->load_data.buf; bufsz = img->load_data.buf_used; } else { buf = img->load_data.mapped_file; bufsz = img->load_data.mapped_file_sz; } }
         switch(g->compressed) {
             case 'z':
+                if (img->load_data.inflation_complete) break;  // decompressed incrementally as chunks arrived
                 IB;
                 if (!inflate_zlib(self, img, buf, bufsz)) {
                     img->data_loaded = false; return NULL;
@@ -507,10 +984,7 @@ handle_add_command(GraphicsManager *self, const GraphicsCommand *g, const uint8_
     size_t required_sz = (size_t)(img->load_data.is_opaque ? 3 : 4) * img->width * img->height;
     if (img->load_data.data_sz != required_sz) ABRT(EINVAL, "Image dimensions: %ux%u do not match data size: %zu, expected size: %zu", img->width, img->height, img->load_data.data_sz, required_sz);
     if (LIKELY(img->data_loaded && send_to_gpu)) {
-        send_image_to_gpu(&img->texture_id, img->load_data.data, img->width, img->height, img->load_data.is_opaque, img->load_data.is_4byte_aligned, false, REPEAT_CLAMP);
-        free_load_data(&img->load_data);
-        self->used_storage += required_sz;
-        img->used_storage = required_sz;
+        upload_image_bitmap(self, img, bitmap_hash(img->load_data.data, required_sz), required_sz);
     }
     return img;
 #undef MAX_DATA_SZ
@@ -542,6 +1016,95 @@ finish_command_response(const GraphicsCommand *g, bool data_loaded, uint32_t iid
     return NULL;
 }
 
+// Finishing asynchronous decodes {{{
+
+static void
+send_decode_job_response(DecodeJob *j, bool data_loaded) {
+    const char *resp = j->is_query ? finish_command_response(&j->cmd, data_loaded, j->q_iid, 0, 0)
+        : finish_command_response(&j->cmd, data_loaded, j->cmd.id, j->cmd.placement_id, j->cmd.image_number);
+    if (resp && j->window_id) schedule_write_to_child(j->window_id, 3, "\033_", 2, resp, strlen(resp), "\033\\", 2);
+}
+
+static void
+handle_decode_job_result(DecodeJob *j) {
+    GraphicsManager *self = j->grman;
+    if (self == NULL) return;  // the manager was deallocated while the job was outstanding
+    command_response[0] = 0;
+    Image *img = img_by_internal_id(self, j->image_id);
+    if (img == NULL || !img->decode_pending) {
+        set_command_failed_response("ENOENT", "Image was removed before its data could be decoded");
+        send_decode_job_response(j, false);
+        return;
+    }
+    img->decode_pending = false;
+    bool ok = j->ok;
+    if (!ok) snprintf(command_response, sizeof(command_response)/sizeof(command_response[0]), "%s", j->error);
+    else {
+        free_load_data(&img->load_data);
+        img->load_data.buf = j->output; j->output = NULL;
+        img->load_data.buf_used = j->output_sz;
+        img->load_data.buf_capacity = j->output_sz;
+        img->load_data.data = img->load_data.buf;
+        if (j->fmt == PNG) {
+            img->load_data.data_sz = j->output_sz;
+            img->width = j->width; img->height = j->height;
+        }
+        size_t required_sz = (size_t)(img->load_data.is_opaque ? 3 : 4) * img->width * img->height;
+        if (img->load_data.buf_used < img->load_data.data_sz) {
+            set_command_failed_response("ENODATA", "Insufficient image data: %zu < %zu", img->load_data.buf_used, img->load_data.data_sz);
+            ok = false;
+        } else if (img->load_data.data_sz != required_sz) {
+            set_command_failed_response("EINVAL", "Image dimensions: %ux%u do not match data size: %zu, expected size: %zu", img->width, img->height, img->load_data.data_sz, required_sz);
+            ok = false;
+        } else if (send_to_gpu) {
+            upload_image_bitmap(self, img, j->bitmap_hash, required_sz);
+        }
+    }
+    img->data_loaded = ok;
+    send_decode_job_response(j, ok);
+    id_type added_image_id = ok ? img->internal_id : 0;
+    if (j->cmd.action == 'q') remove_images(self, add_trim_predicate, 0);
+    if (self->used_storage > STORAGE_LIMIT) apply_storage_quota(self, STORAGE_LIMIT, added_image_id);
+}
+
+// Called on the main thread after every parse pass, delivers finished decodes
+void
+grman_process_decoded_images(void) {
+    if (!decoder.thread_started) return;
+    decoder_mutex(lock);
+    DecodeJob *completed = decoder.completed;
+    decoder.completed = NULL;
+    decoder_mutex(unlock);
+    while (completed) {
+        DecodeJob *j = completed;
+        completed = j->next; j->next = NULL;
+        handle_decode_job_result(j);
+        free_decode_job(j);
+    }
+}
+
+// Block until the outstanding decode job for img completes, processing it
+// inline. Needed when a command that must be answered synchronously, such as
+// a put or a re-transmission, refers to an image whose decode is in flight.
+static void
+wait_for_image_decode(GraphicsManager *self, Image *img) {
+    if (!decoder.thread_started) { img->decode_pending = false; return; }
+    while (img->decode_pending) {
+        DecodeJob *found = NULL;
+        decoder_mutex(lock);
+        while (true) {
+            DecodeJob **p = &decoder.completed;
+            while (*p && !((*p)->grman == self && (*p)->image_id == img->internal_id)) p = &(*p)->next;
+            if (*p) { found = *p; *p = found->next; found->next = NULL; break; }
+            pthread_cond_wait(&decoder.cond, &decoder.lock);
+        }
+        decoder_mutex(unlock);
+        handle_decode_job_result(found);
+        free_decode_job(found);
+    }
+    command_response[0] = 0;  // do not leak the decode response into the command being processed
+}
+
 // }}}
 
 // Displaying images {{{
@@ -580,6 +1143,7 @@ handle_put_command(GraphicsManager *self, const GraphicsCommand *g, Cursor *c, b
         else if (g->image_number) img = img_by_client_number(self, g->image_number);
         if (img == NULL) { set_command_failed_response("ENOENT", "Put command refers to non-existent image with id: %u and number: %u", g->id, g->image_number); return g->id; }
     }
+    if (img->decode_pending) wait_for_image_decode(self, img);
     if (!img->data_loaded) { set_command_failed_response("ENOENT", "Put command refers to image with id: %u that could not load its data", g->id); return img->client_id; }
     ensure_space_for(img, refs, ImageRef, img->refcnt + 1, refcap, 16, true);
     *is_dirty = true;
@@ -597,7 +1161,7 @@ handle_put_command(GraphicsManager *self, const GraphicsCommand *g, Cursor *c, b
         ref = img->refs + img->refcnt++;
         zero_at_ptr(ref);
     }
-    img->atime = monotonic();
+    mark_image_used(self, img);
     ref->src_x = g->x_offset; ref->src_y = g->y_offset; ref->src_width = g->width ? g->width : img->width; ref->src_height = g->height ? g->height : img->height;
     ref->src_width = MIN(ref->src_width, img->width - (img->width > ref->src_x ? ref->src_x : img->width));
     ref->src_height = MIN(ref->src_height, img->height - (img->height > ref->src_y ? ref->src_y : img->height));
@@ -618,6 +1182,9 @@ static int
 cmp_by_zindex_and_image(const void *a_, const void *b_) {
     const ImageRenderData *a = (const ImageRenderData*)a_, *b = (const ImageRenderData*)b_;
     int ans = a->z_index - b->z_index;
+    // group images sharing a texture, such as atlas packed ones, together so
+    // they draw with a single bind
+    if (ans == 0 && a->texture_id != b->texture_id) ans = a->texture_id < b->texture_id ? -1 : 1;
     if (ans == 0) ans = a->image_id - b->image_id;
     return ans;
 }
@@ -660,7 +1227,7 @@ grman_update_layers(GraphicsManager *self, unsigned int scrolled_by, float scree
 
     // Iterate over all visible refs and create render data
     self->count = 0;
-    for (i = 0; i < self->image_count; i++) { img = self->images + i; for (j = 0; j < img->refcnt; j++) { ref = img->refs + j;
+    for (i = 0; i < self->image_slot_count; i++) { img = self->images + i; for (j = 0; j < img->refcnt; j++) { ref = img->refs + j;
         r.top = y0 - ref->start_row * dy - dy * (float)ref->cell_y_offset / (float)cell.height;
         if (ref->num_rows > 0) r.bottom = y0 - (ref->start_row + (int32_t)ref->num_rows) * dy;
         else r.bottom = r.top - screen_height * (float)ref->src_height / screen_height_px;
@@ -683,6 +1250,13 @@ grman_update_layers(GraphicsManager *self, unsigned int scrolled_by, float scree
         self->count++;
         rd->z_index = ref->z_index; rd->image_id = img->internal_id;
         rd->texture_id = img->texture_id;
+        if (img->in_atlas) {
+            // remap the texture coordinates from image space into atlas space
+            for (int v = 0; v < 4; v++) {
+                rd->vertices[v*4] = ((float)img->atlas_rect.x + rd->vertices[v*4] * (float)img->atlas_rect.width) / (float)self->atlas.width;
+                rd->vertices[v*4 + 1] = ((float)img->atlas_rect.y + rd->vertices[v*4 + 1] * (float)img->atlas_rect.height) / (float)self->atlas.height;
+            }
+        }
     }}
     if (!self->count) return false;
     // Sort visible refs in draw order (z-index, img)
@@ -707,7 +1281,7 @@ grman_update_layers(GraphicsManager *self, unsigned int scrolled_by, float scree
 static inline void
 filter_refs(GraphicsManager *self, const void* data, bool free_images, bool (*filter_func)(const ImageRef*, Image*, const void*, CellPixelSize), CellPixelSize cell, bool only_first_image) {
     bool matched = false;
-    for (size_t i = self->image_count; i-- > 0;) {
+    for (size_t i = self->image_slot_count; i-- > 0;) {
         Image *img = self->images + i;
         for (size_t j = img->refcnt; j-- > 0;) {
             ImageRef *ref = img->refs + j;
@@ -725,7 +1299,7 @@ filter_refs(GraphicsManager *self, const void* data, bool free_images, bool (*fi
 
 static inline void
 modify_refs(GraphicsManager *self, const void* data, bool free_images, bool (*filter_func)(ImageRef*, Image*, const void*, CellPixelSize), CellPixelSize cell) {
-    for (size_t i = self->image_count; i-- > 0;) {
+    for (size_t i = self->image_slot_count; i-- > 0;) {
         Image *img = self->images + i;
         for (size_t j = img->refcnt; j-- > 0;) {
             if (filter_func(img->refs + j, img, data, cell)) remove_i_from_array(img->refs, j, img->refcnt);
@@ -896,7 +1470,7 @@ void
 grman_rescale(GraphicsManager *self, CellPixelSize cell) {
     ImageRef *ref; Image *img;
     self->layers_dirty = true;
-    for (size_t i = self->image_count; i-- > 0;) {
+    for (size_t i = self->image_slot_count; i-- > 0;) {
         img = self->images + i;
         for (size_t j = img->refcnt; j-- > 0;) {
             ref = img->refs + j;
@@ -926,6 +1500,7 @@ grman_handle_command(GraphicsManager *self, const GraphicsCommand *g, const uint
             bool is_query = g->action == 'q';
             if (is_query) { iid = 0; if (!q_iid) { REPORT_ERROR("Query graphics command without image id"); break; } }
             Image *image = handle_add_command(self, g, payload, is_dirty, iid);
+            if (image && image->decode_pending) break;  // the response is sent when the decode completes
             if (is_query) ret = finish_command_response(g, image != NULL,  q_iid, 0, 0);
             else ret = finish_command_response(g, image != NULL, self->last_init_graphics_command.id, self->last_init_graphics_command.placement_id, self->last_init_graphics_command.image_number);
             if (self->last_init_graphics_command.action == 'T' && image && image->data_loaded) handle_put_command(self, &self->last_init_graphics_command, c, is_dirty, image, cell);
@@ -1038,12 +1613,29 @@ W(update_layers) {
     return ans;
 }
 
+W(memory_used) {
+    (void)args;
+    size_t cache_ram = 0, cache_disk = 0, image_data = 0;
+    if (self->disk_cache) disk_cache_size_of(self->disk_cache, &cache_ram, &cache_disk);
+    for (size_t i = 0; i < self->image_slot_count; i++) {
+        Image *img = self->images + i;
+        if (!img->internal_id) continue;
+        image_data += img->load_data.buf_capacity + img->load_data.mapped_file_sz;
+    }
+    return Py_BuildValue("{sn sn sn sn}",
+        "texture_bytes", (Py_ssize_t)self->used_storage,
+        "image_data_bytes", (Py_ssize_t)image_data,
+        "disk_cache_ram_bytes", (Py_ssize_t)cache_ram,
+        "disk_cache_disk_bytes", (Py_ssize_t)cache_disk);
+}
+
 #define M(x, va) {#x, (PyCFunction)py##x, va, ""}
 
 static PyMethodDef methods[] = {
     M(image_for_client_id, METH_O),
     M(image_for_client_number, METH_O),
     M(update_layers, METH_VARARGS),
+    M(memory_used, METH_NOARGS),
     {NULL}  /* Sentinel */
 };
 
@@ -16,6 +16,8 @@ typedef struct {
     size_t payload_sz;
 } GraphicsCommand;
 
+struct z_stream_s;
+
 typedef struct {
     uint8_t *buf;
     size_t buf_capacity, buf_used;
@@ -27,6 +29,10 @@ typedef struct {
     uint8_t *data;
     bool is_4byte_aligned;
     bool is_opaque;
+    // Streaming decompression of chunked direct transmissions, active while
+    // zstream is non-NULL, with inflation_complete set once the stream ends
+    struct z_stream_s *zstream;
+    bool inflation_complete;
 } LoadData;
 
 typedef struct {
@@ -43,11 +49,41 @@ typedef struct {
 } ImageRef;
 
 
+// absent link in the intrusive LRU list threading GraphicsManager.images
+#define NO_LRU_LINK SIZE_MAX
+
+typedef struct {
+    uint32_t x, y, width, height;
+} AtlasRect;
+
+// A single large texture that small images are packed into with a shelf
+// allocator, so that placements of many small images can render from one
+// texture instead of paying a bind per image.
+typedef struct {
+    uint32_t texture_id;
+    uint32_t width, height;
+    uint32_t row_x, row_y, row_height;  // shelf allocation cursor
+    AtlasRect *free_rects;  // regions returned by removed images, reused on a first fit basis
+    size_t free_rect_count, free_rect_capacity;
+} ImageAtlas;
+
 typedef struct {
     uint32_t texture_id, client_id, client_number, width, height;
     id_type internal_id;
+    // hash of the decoded bitmap when texture_id is shared with other images,
+    // zero otherwise
+    uint64_t bitmap_hash;
+    // region of the atlas holding this image's bitmap, when texture_id is the
+    // atlas texture
+    bool in_atlas;
+    AtlasRect atlas_rect;
+    // indices into GraphicsManager.images forming a doubly linked LRU list
+    size_t lru_prev, lru_next;
 
     bool data_loaded;
+    // Transmission is complete but the data is being decoded on the decode
+    // thread, with the client response deferred until decoding finishes
+    bool decode_pending;
     LoadData load_data;
 
     ImageRef *refs;
@@ -70,13 +106,26 @@ typedef struct {
     id_type image_id;
 } ImageRenderData;
 
+struct ImageIndex;
+struct SharedTexture;
+
 typedef struct {
     PyObject_HEAD
 
-    size_t image_count, images_capacity;
+    size_t image_count, images_capacity;  // image_count is the number of live images
     id_type loading_image;
     GraphicsCommand last_init_graphics_command;
     Image *images;
+    // high water mark of used slots in images, including tombstones
+    size_t image_slot_count;
+    // head of the free list threaded through lru_next of tombstoned slots
+    size_t free_slot_head;
+    size_t lru_head, lru_tail;  // most and least recently used image indices
+    // hash indices for O(1) image lookup
+    struct ImageIndex *by_client_id, *by_internal_id;
+    // refcounted textures shared between images with identical decoded bitmaps
+    struct SharedTexture *shared_textures;
+    ImageAtlas atlas;
     size_t count, capacity;
     ImageRenderData *render_data;
     bool layers_dirty;
@@ -85,6 +134,9 @@ typedef struct {
     unsigned int last_scrolled_by;
     size_t used_storage;
     PyObject *disk_cache;
+    // The id of the window this manager renders into, needed to deliver
+    // responses for asynchronously decoded images
+    id_type window_id;
 } GraphicsManager;
 
 
@@ -101,5 +153,6 @@ bool grman_update_layers(GraphicsManager *self, unsigned int scrolled_by, float
 void grman_scroll_images(GraphicsManager *self, const ScrollData*, CellPixelSize fg);
 void grman_resize(GraphicsManager*, index_type, index_type, index_type, index_type);
 void grman_rescale(GraphicsManager *self, CellPixelSize fg);
+void grman_process_decoded_images(void);
 void gpu_data_for_centered_image(ImageRenderData *ans, unsigned int screen_width_px, unsigned int screen_height_px, unsigned int width, unsigned int height);
 bool png_path_to_bitmap(const char *path, uint8_t** data, unsigned int* width, unsigned int* height, size_t* sz);
@@ -10,22 +10,236 @@
 #include "charsets.h"
 #include <structmember.h>
 #include "ringbuf.h"
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 extern PyTypeObject Line_Type;
 #define SEGMENT_SIZE 2048
+// Scrollbacks whose cells would use more memory than this get their segments
+// backed by unlinked temp files, so that cold history can be paged out by the
+// kernel under memory pressure instead of pinning RSS (or needing swap)
+#define MMAP_SCROLLBACK_THRESHOLD (8u * 1024u * 1024u)
+
+// Process wide accounting of history cell storage, so that many windows with
+// deep scrollbacks can be kept under a single memory budget. The counter is
+// atomic so the accounting cannot silently corrupt if a background thread
+// ever touches history cells; compression and budget sweeps themselves must
+// still happen only on the main thread (see the cell pack pool in shaders.c)
+static _Atomic(size_t) total_resident_cell_bytes = 0;
+static size_t scrollback_memory_budget = 0;  // 0 means no limit
+static HistoryBuf *history_buffers = NULL;   // most recently grown first
+
+static inline size_t
+segment_raw_sz(const HistoryBuf *self) { return (size_t)self->xnum * SEGMENT_SIZE * (sizeof(CPUCell) + sizeof(GPUCell)); }
+
+static void enforce_scrollback_budget(HistoryBuf *just_touched);
+
+static void
+lru_unlink(HistoryBuf *self) {
+    if (history_buffers == self) { history_buffers = self->lru_next; self->lru_next = NULL; return; }
+    for (HistoryBuf *h = history_buffers; h; h = h->lru_next) {
+        if (h->lru_next == self) { h->lru_next = self->lru_next; self->lru_next = NULL; return; }
+    }
+}
+
+static void
+lru_touch(HistoryBuf *self) {
+    if (history_buffers == self) return;
+    lru_unlink(self);
+    self->lru_next = history_buffers;
+    history_buffers = self;
+}
+
+static inline void*
+alloc_mmap_block(size_t sz) {
+    char tfile[2048];
+    const char *tdir = getenv("TMPDIR");
+    if (!tdir || !tdir[0] || strlen(tdir) + 32 > sizeof(tfile)) tdir = "/tmp";
+    snprintf(tfile, sizeof(tfile), "%s/kitty-scrollback-XXXXXX", tdir);
+    int fd = mkstemp(tfile);
+    if (fd < 0) return NULL;
+    unlink(tfile);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    void *ans = NULL;
+    if (ftruncate(fd, sz) == 0) {
+        ans = mmap(0, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ans == MAP_FAILED) ans = NULL;
+    }
+    safe_close(fd, __FILE__, __LINE__);
+    return ans;
+}
+
+static inline void
+alloc_segment_cells(HistoryBuf *self, HistoryBufSegment *s) {
+    const size_t cpu_sz = (size_t)self->xnum * SEGMENT_SIZE * sizeof(CPUCell);
+    const size_t gpu_sz = (size_t)self->xnum * SEGMENT_SIZE * sizeof(GPUCell);
+    s->mmap_block = NULL; s->mmap_block_sz = 0;
+    if ((size_t)self->xnum * self->ynum * (sizeof(CPUCell) + sizeof(GPUCell)) >= MMAP_SCROLLBACK_THRESHOLD) {
+        s->mmap_block = alloc_mmap_block(cpu_sz + gpu_sz);
+        if (s->mmap_block) {
+            s->mmap_block_sz = cpu_sz + gpu_sz;
+            s->cpu_cells = s->mmap_block;  // mmap gives zeroed pages, like calloc
+            s->gpu_cells = (GPUCell*)((uint8_t*)s->mmap_block + cpu_sz);
+            // the newest segment is the hot window, it is about to be written
+            posix_madvise(s->mmap_block, s->mmap_block_sz, POSIX_MADV_WILLNEED);
+        }
+    }
+    if (!s->mmap_block) {  // small scrollback, or mmap failed
+        s->cpu_cells = PyMem_RawCalloc(self->xnum * SEGMENT_SIZE, sizeof(CPUCell));
+        s->gpu_cells = PyMem_RawCalloc(self->xnum * SEGMENT_SIZE, sizeof(GPUCell));
+        if (s->cpu_cells == NULL || s->gpu_cells == NULL) fatal("Out of memory allocating new history buffer segment");
+    }
+    total_resident_cell_bytes += cpu_sz + gpu_sz;
+    lru_touch(self);
+}
 
 static inline void
 add_segment(HistoryBuf *self) {
     self->num_segments += 1;
-    self->segments = PyMem_Realloc(self->segments, sizeof(HistoryBufSegment) * self->num_segments);
+    self->segments = PyMem_RawRealloc(self->segments, sizeof(HistoryBufSegment) * self->num_segments);
     if (self->segments == NULL) fatal("Out of memory allocating new history buffer segment");
     HistoryBufSegment *s = self->segments + self->num_segments - 1;
-    s->cpu_cells = PyMem_Calloc(self->xnum * SEGMENT_SIZE, sizeof(CPUCell));
-    s->gpu_cells = PyMem_Calloc(self->xnum * SEGMENT_SIZE, sizeof(GPUCell));
-    s->line_attrs = PyMem_Calloc(SEGMENT_SIZE, sizeof(line_attrs_type));
-    if (s->cpu_cells == NULL || s->gpu_cells == NULL || s->line_attrs == NULL) fatal("Out of memory allocating new history buffer segment");
+    alloc_segment_cells(self, s);
+    s->compressed = NULL; s->compressed_sz = 0; s->recently_used = true;
+    // line_attrs are kept on the heap, they are scanned by dirty_lines() and
+    // the URL summary machinery and must stay cheap to touch
+    s->line_attrs = PyMem_RawCalloc(SEGMENT_SIZE, sizeof(line_attrs_type));
+    if (s->line_attrs == NULL) fatal("Out of memory allocating new history buffer segment");
+    enforce_scrollback_budget(self);
+}
+
+// Cold segment compression {{{
+// Segments that have not been read or written for a while have their cell
+// storage replaced by a PackBits style RLE compressed copy. Scrollback cell
+// data is dominated by runs of blank cells and of zero bytes inside cells, so
+// even this simple byte level scheme typically shrinks it several fold,
+// without pulling in an external compression library. Compression is done
+// synchronously, but only when the write cursor crosses a segment boundary,
+// so its cost is amortized over SEGMENT_SIZE line pushes.
+
+static size_t
+rle_compress(const uint8_t *src, size_t sz, uint8_t *dst) {
+    // control byte c: c < 0x80 means c + 1 literal bytes follow, otherwise
+    // the next byte is repeated (c & 0x7f) + 3 times
+    size_t i = 0, o = 0;
+    while (i < sz) {
+        size_t run = 1;
+        while (i + run < sz && run < 130u && src[i + run] == src[i]) run++;
+        if (run >= 3) {
+            dst[o++] = (uint8_t)(0x80u | (run - 3));
+            dst[o++] = src[i];
+            i += run;
+        } else {
+            size_t start = i;
+            while (i < sz && i - start < 128u) {
+                if (i + 2 < sz && src[i] == src[i + 1] && src[i] == src[i + 2]) break;
+                i++;
+            }
+            dst[o++] = (uint8_t)(i - start - 1);
+            memcpy(dst + o, src + start, i - start);
+            o += i - start;
+        }
+    }
+    return o;
+}
+
+static size_t
+rle_decompress(const uint8_t *src, uint8_t *dst, size_t dst_sz) {
+    // decompresses exactly dst_sz bytes, returning the number of source bytes
+    // consumed, so the cpu and gpu cell streams can be stored back to back
+    size_t i = 0, o = 0;
+    while (o < dst_sz) {
+        uint8_t c = src[i++];
+        if (c & 0x80) {
+            size_t run = (size_t)(c & 0x7f) + 3;
+            memset(dst + o, src[i++], run); o += run;
+        } else {
+            memcpy(dst + o, src + i, c + 1u); i += c + 1u; o += c + 1u;
+        }
+    }
+    return i;
+}
+
+static void
+compress_segment(HistoryBuf *self, HistoryBufSegment *s) {
+    const size_t cpu_sz = (size_t)self->xnum * SEGMENT_SIZE * sizeof(CPUCell);
+    const size_t gpu_sz = (size_t)self->xnum * SEGMENT_SIZE * sizeof(GPUCell);
+    const size_t raw_sz = cpu_sz + gpu_sz;
+    uint8_t *buf = PyMem_RawMalloc(raw_sz + raw_sz / 128 + 4);  // worst case RLE expansion
+    if (buf == NULL) return;  // no memory, just leave the segment uncompressed
+    size_t sz = rle_compress((const uint8_t*)s->cpu_cells, cpu_sz, buf);
+    sz += rle_compress((const uint8_t*)s->gpu_cells, gpu_sz, buf + sz);
+    uint8_t *shrunk = PyMem_RawRealloc(buf, sz);
+    s->compressed = shrunk ? shrunk : buf;
+    s->compressed_sz = sz;
+    if (s->mmap_block) { munmap(s->mmap_block, s->mmap_block_sz); s->mmap_block = NULL; s->mmap_block_sz = 0; }
+    else { PyMem_RawFree(s->cpu_cells); PyMem_RawFree(s->gpu_cells); }
+    s->cpu_cells = NULL; s->gpu_cells = NULL;
+    total_resident_cell_bytes -= raw_sz;
+}
+
+static void
+decompress_segment(HistoryBuf *self, HistoryBufSegment *s) {
+    const size_t cpu_sz = (size_t)self->xnum * SEGMENT_SIZE * sizeof(CPUCell);
+    const size_t gpu_sz = (size_t)self->xnum * SEGMENT_SIZE * sizeof(GPUCell);
+    alloc_segment_cells(self, s);
+    size_t consumed = rle_decompress(s->compressed, (uint8_t*)s->cpu_cells, cpu_sz);
+    rle_decompress(s->compressed + consumed, (uint8_t*)s->gpu_cells, gpu_sz);
+    PyMem_RawFree(s->compressed);
+    s->compressed = NULL; s->compressed_sz = 0;
+    enforce_scrollback_budget(self);
+}
+
+static inline HistoryBufSegment*
+cells_segment(HistoryBuf *self, index_type seg_num) {
+    // All access to segment cell storage must go through here, so that
+    // compressed segments are transparently made resident
+    HistoryBufSegment *s = self->segments + seg_num;
+    if (UNLIKELY(s->compressed)) decompress_segment(self, s);
+    s->recently_used = true;
+    return s;
+}
+
+static inline bool
+line_is_in_segment(HistoryBuf *self, HistoryBufSegment *s) {
+    // does the shared line object currently point into this segment's storage
+    const CPUCell *p = self->line->cpu_cells;
+    return s->cpu_cells && p >= s->cpu_cells && p < s->cpu_cells + (size_t)self->xnum * SEGMENT_SIZE;
 }
 
+static void
+compress_cold_segments(HistoryBuf *self, index_type hot_seg) {
+    // Second chance sweep: a segment touched since the previous sweep
+    // survives this one, so the hot window covers at least the last
+    // SEGMENT_SIZE pushed lines plus anything recently read
+    for (index_type i = 0; i < self->num_segments; i++) {
+        HistoryBufSegment *s = self->segments + i;
+        if (i == hot_seg || s->compressed || s->cpu_cells == NULL || line_is_in_segment(self, s)) continue;
+        if (s->recently_used) s->recently_used = false;
+        else compress_segment(self, s);
+    }
+}
+
+static void
+enforce_scrollback_budget(HistoryBuf *just_touched) {
+    if (!scrollback_memory_budget || total_resident_cell_bytes <= scrollback_memory_budget) return;
+    // Sweep the least recently grown buffers first, so idle windows give
+    // their memory back to the busy ones. The budget is a soft target:
+    // segments in a hot window are never evicted and a sweep only compresses
+    // what a previous sweep has already marked cold.
+    HistoryBuf *stop = NULL;
+    while (total_resident_cell_bytes > scrollback_memory_budget) {
+        HistoryBuf *tail = NULL;
+        for (HistoryBuf *h = history_buffers; h && h != stop; h = h->lru_next) tail = h;
+        if (tail == NULL) break;
+        if (tail != just_touched) compress_cold_segments(tail, tail->active_segment);
+        stop = tail;
+    }
+}
+// }}}
+
 static inline index_type
 segment_for(HistoryBuf *self, index_type y) {
     index_type seg_num = y / SEGMENT_SIZE;
@@ -42,12 +256,14 @@ segment_for(HistoryBuf *self, index_type y) {
 
 static inline CPUCell*
 cpu_lineptr(HistoryBuf *self, index_type y) {
-    seg_ptr(cpu_cells, self->xnum);
+    index_type seg_num = segment_for(self, y);
+    return cells_segment(self, seg_num)->cpu_cells + (y - seg_num * SEGMENT_SIZE) * self->xnum;
 }
 
 static inline GPUCell*
 gpu_lineptr(HistoryBuf *self, index_type y) {
-    seg_ptr(gpu_cells, self->xnum);
+    index_type seg_num = segment_for(self, y);
+    return cells_segment(self, seg_num)->gpu_cells + (y - seg_num * SEGMENT_SIZE) * self->xnum;
 }
 
 
@@ -60,39 +276,62 @@ static inline PagerHistoryBuf*
 alloc_pagerhist(size_t pagerhist_sz) {
     PagerHistoryBuf *ph;
     if (!pagerhist_sz) return NULL;
-    ph = PyMem_Calloc(1, sizeof(PagerHistoryBuf));
+    ph = PyMem_RawCalloc(1, sizeof(PagerHistoryBuf));
     if (!ph) return NULL;
     size_t sz = MIN(1024u * 1024u, pagerhist_sz);
     ph->ringbuf = ringbuf_new(sz);
-    if (!ph->ringbuf) { PyMem_Free(ph); return NULL; }
+    if (!ph->ringbuf) { PyMem_RawFree(ph); return NULL; }
     ph->maximum_size = pagerhist_sz;
     return ph;
 }
 
+typedef struct {
+    ringbuf_t src;  // not yet rewrapped text, oldest first; new pushes are appended here
+    index_type width;  // the target width of this pass
+    index_type num_in_current_line;
+    WCSState wcs_state;
+} PagerRewrapState;
+
+static inline void
+pagerhist_discard_rewrap(PagerHistoryBuf *ph) {
+    PagerRewrapState *rs = ph->rewrap_state;
+    if (rs) {
+        ringbuf_free(&rs->src);
+        PyMem_RawFree(rs);
+        ph->rewrap_state = NULL;
+    }
+}
+
 static inline void
 free_pagerhist(HistoryBuf *self) {
-    if (self->pagerhist && self->pagerhist->ringbuf) ringbuf_free((ringbuf_t*)&self->pagerhist->ringbuf);
-    PyMem_Free(self->pagerhist);
+    if (self->pagerhist) {
+        pagerhist_discard_rewrap(self->pagerhist);
+        if (self->pagerhist->ringbuf) ringbuf_free((ringbuf_t*)&self->pagerhist->ringbuf);
+    }
+    PyMem_RawFree(self->pagerhist);
     self->pagerhist = NULL;
 }
 
 static inline bool
-pagerhist_extend(PagerHistoryBuf *ph, size_t minsz) {
-    size_t buffer_size = ringbuf_capacity(ph->ringbuf);
+pagerhist_extend(PagerHistoryBuf *ph, ringbuf_t *rb, size_t minsz) {
+    size_t buffer_size = ringbuf_capacity(*rb);
     if (buffer_size >= ph->maximum_size) return false;
     size_t newsz = MIN(ph->maximum_size, buffer_size + MAX(1024u * 1024u, minsz));
     ringbuf_t newbuf = ringbuf_new(newsz);
     if (!newbuf) return false;
-    size_t count = ringbuf_bytes_used(ph->ringbuf);
-    if (count) ringbuf_copy(newbuf, ph->ringbuf, count);
-    ringbuf_free((ringbuf_t*)&ph->ringbuf);
-    ph->ringbuf = newbuf;
+    size_t count = ringbuf_bytes_used(*rb);
+    if (count) ringbuf_copy(newbuf, *rb, count);
+    ringbuf_free(rb);
+    *rb = newbuf;
     return true;
 }
 
 static inline void
 pagerhist_clear(HistoryBuf *self) {
-    if (self->pagerhist && self->pagerhist->ringbuf) ringbuf_reset(self->pagerhist->ringbuf);
+    if (self->pagerhist) {
+        pagerhist_discard_rewrap(self->pagerhist);
+        if (self->pagerhist->ringbuf) ringbuf_reset(self->pagerhist->ringbuf);
+    }
 }
 
 static HistoryBuf*
@@ -125,12 +364,21 @@ new(PyTypeObject *type, PyObject *args, PyObject UNUSED *kwds) {
 static void
 dealloc(HistoryBuf* self) {
     Py_CLEAR(self->line);
+    Py_CLEAR(self->deferred_rewrap_src);
+    lru_unlink(self);
     for (size_t i = 0; i < self->num_segments; i++) {
-        PyMem_Free(self->segments[i].cpu_cells);
-        PyMem_Free(self->segments[i].gpu_cells);
-        PyMem_Free(self->segments[i].line_attrs);
+        if (self->segments[i].cpu_cells) total_resident_cell_bytes -= segment_raw_sz(self);
+        if (self->segments[i].mmap_block) munmap(self->segments[i].mmap_block, self->segments[i].mmap_block_sz);
+        else {
+            PyMem_RawFree(self->segments[i].cpu_cells);
+            PyMem_RawFree(self->segments[i].gpu_cells);
+        }
+        PyMem_RawFree(self->segments[i].compressed);
+        PyMem_RawFree(self->segments[i].line_attrs);
     }
-    PyMem_Free(self->segments);
+    PyMem_RawFree(self->search.needle);
+    free(self->search.matches);
+    PyMem_RawFree(self->segments);
     free_pagerhist(self);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -155,11 +403,13 @@ init_line(HistoryBuf *self, index_type num, Line *l) {
 
 void
 historybuf_init_line(HistoryBuf *self, index_type lnum, Line *l) {
+    historybuf_resolve_deferred_rewrap(self);
     init_line(self, index_of(self, lnum), l);
 }
 
 CPUCell*
 historybuf_cpu_cells(HistoryBuf *self, index_type lnum) {
+    historybuf_resolve_deferred_rewrap(self);
     return cpu_lineptr(self, index_of(self, lnum));
 }
 
@@ -172,26 +422,54 @@ historybuf_mark_line_clean(HistoryBuf *self, index_type y) {
 void
 historybuf_mark_line_dirty(HistoryBuf *self, index_type y) {
     line_attrs_type *p = attrptr(self, index_of(self, y));
+    *p &= ~(URL_SCANNED_MASK | HAS_URL_ANCHOR_MASK);
     *p |= TEXT_DIRTY_MASK;
 }
 
+bool
+historybuf_line_may_have_url(HistoryBuf *self, index_type lnum) {
+    historybuf_resolve_deferred_rewrap(self);
+    line_attrs_type *p = attrptr(self, index_of(self, lnum));
+    if (!(*p & URL_SCANNED_MASK)) {
+        init_line(self, index_of(self, lnum), self->line);
+        *p |= URL_SCANNED_MASK | (line_has_url_anchor(self->line) ? HAS_URL_ANCHOR_MASK : 0);
+    }
+    return (*p & HAS_URL_ANCHOR_MASK) != 0;
+}
+
 void
 historybuf_clear(HistoryBuf *self) {
     pagerhist_clear(self);
+    Py_CLEAR(self->deferred_rewrap_src);
     self->count = 0;
     self->start_of_data = 0;
+    PyMem_RawFree(self->search.needle);
+    self->search.needle = NULL; self->search.needle_len = 0; self->search.num_matches = 0;
+}
+
+static inline ringbuf_t*
+pagerhist_write_target(PagerHistoryBuf *ph) {
+    // While a chunked rewrap is in progress new text must go after the not
+    // yet rewrapped portion, so oldest to newest ordering is preserved
+    PagerRewrapState *rs = ph->rewrap_state;
+    return rs ? &rs->src : (ringbuf_t*)&ph->ringbuf;
 }
 
 static inline bool
-pagerhist_write_bytes(PagerHistoryBuf *ph, const uint8_t *buf, size_t sz) {
+pagerhist_write_bytes_to(PagerHistoryBuf *ph, ringbuf_t *rb, const uint8_t *buf, size_t sz) {
     if (sz > ph->maximum_size) return false;
     if (!sz) return true;
-    size_t space_in_ringbuf = ringbuf_bytes_free(ph->ringbuf);
-    if (sz > space_in_ringbuf) pagerhist_extend(ph, sz);
-    ringbuf_memcpy_into(ph->ringbuf, buf, sz);
+    size_t space_in_ringbuf = ringbuf_bytes_free(*rb);
+    if (sz > space_in_ringbuf) pagerhist_extend(ph, rb, sz);
+    ringbuf_memcpy_into(*rb, buf, sz);
     return true;
 }
 
+static inline bool
+pagerhist_write_bytes(PagerHistoryBuf *ph, const uint8_t *buf, size_t sz) {
+    return pagerhist_write_bytes_to(ph, pagerhist_write_target(ph), buf, sz);
+}
+
 static inline bool
 pagerhist_ensure_start_is_valid_utf8(PagerHistoryBuf *ph) {
     uint8_t scratch[8];
@@ -211,25 +489,149 @@ pagerhist_ensure_start_is_valid_utf8(PagerHistoryBuf *ph) {
     return false;
 }
 
+static inline bool
+pagerhist_write_v(PagerHistoryBuf *ph, const struct iovec *iov, int iovcnt) {
+    size_t sz = 0;
+    for (int i = 0; i < iovcnt; i++) sz += iov[i].iov_len;
+    if (sz > ph->maximum_size) return false;
+    if (!sz) return true;
+    ringbuf_t *rb = pagerhist_write_target(ph);
+    if (sz > ringbuf_bytes_free(*rb)) pagerhist_extend(ph, rb, sz);
+    ringbuf_memcpy_intov(*rb, iov, iovcnt);
+    return true;
+}
+
 static inline bool
 pagerhist_write_ucs4(PagerHistoryBuf *ph, const Py_UCS4 *buf, size_t sz) {
-    uint8_t scratch[4];
+    uint8_t scratch[4096];
+    size_t used = 0;
     for (size_t i = 0; i < sz; i++) {
-        unsigned int num = encode_utf8(buf[i], (char*)scratch);
-        if (!pagerhist_write_bytes(ph, scratch, num)) return false;
+        if (used + 4 > sizeof(scratch)) {
+            if (!pagerhist_write_bytes(ph, scratch, used)) return false;
+            used = 0;
+        }
+        used += encode_utf8(buf[i], (char*)(scratch + used));
+    }
+    return pagerhist_write_bytes(ph, scratch, used);
+}
+
+static inline char_type
+pagerhist_remove_char(ringbuf_t src, unsigned *count, uint8_t record[8]) {
+    uint32_t codep, state = UTF8_ACCEPT;
+    *count = 0;
+    size_t num = ringbuf_bytes_used(src);
+    while (num--) {
+        record[*count] = ringbuf_move_char(src);
+        decode_utf8(&state, &codep, record[*count]);
+        *count += 1;
+        if (state == UTF8_REJECT) { codep = 0; break; }
+        if (state == UTF8_ACCEPT) break;
+    }
+    return codep;
+}
+
+// Min amount of pending rewrap work retired on every pagerhist push, so a
+// reflow is usually complete by the time the pager history is next viewed
+#define PAGERHIST_REWRAP_CHUNK_SIZE (32u * 1024u)
+
+static bool
+pagerhist_rewrap_start(HistoryBuf *self, index_type cells_in_line) {
+    // Begins a chunked rewrap pass: the current contents are moved aside and
+    // transferred back in bounded pieces by pagerhist_rewrap_step(), so a
+    // large pager history never has to reflow in one synchronous pass. As
+    // with the old one-shot rewrap, both buffers are alive during a pass, so
+    // peak memory use is transiently doubled.
+    PagerHistoryBuf *ph = self->pagerhist;
+    if (ph->rewrap_state) return true;
+    ph->rewrap_needed = false;
+    if (!ph->ringbuf || !ringbuf_bytes_used(ph->ringbuf)) return false;
+    pagerhist_ensure_start_is_valid_utf8(ph);
+    PagerRewrapState *rs = PyMem_RawCalloc(1, sizeof(PagerRewrapState));
+    if (!rs) { ph->rewrap_needed = true; return false; }
+    ringbuf_t nrb = ringbuf_new(MIN(ph->maximum_size, ringbuf_capacity(ph->ringbuf) + 4096));
+    if (!nrb) { PyMem_RawFree(rs); ph->rewrap_needed = true; return false; }
+    rs->src = ph->ringbuf;
+    ph->ringbuf = nrb;
+    rs->width = cells_in_line;
+    initialize_wcs_state(&rs->wcs_state);
+    ph->rewrap_state = rs;
+    return true;
+}
+
+static bool
+pagerhist_rewrap_step(PagerHistoryBuf *ph, size_t max_bytes) {
+    // Transfers up to max_bytes of the old contents back into the ringbuf,
+    // reflowed to the width of this pass. Returns true once nothing remains.
+    PagerRewrapState *rs = ph->rewrap_state;
+    if (!rs) return true;
+    ssize_t ch_width = 0;
+    unsigned count;
+    uint8_t record[8];
+    char_type ch;
+    size_t processed = 0;
+
+#define WRITE_CHAR() { \
+    if (rs->num_in_current_line + ch_width > rs->width) { \
+        pagerhist_write_bytes_to(ph, (ringbuf_t*)&ph->ringbuf, (const uint8_t*)"\r", 1); \
+        rs->num_in_current_line = 0; \
+    }\
+    if (ch_width >= 0 || (int)rs->num_in_current_line >= -ch_width) rs->num_in_current_line += ch_width; \
+    pagerhist_write_bytes_to(ph, (ringbuf_t*)&ph->ringbuf, record, count); \
+}
+
+    while (ringbuf_bytes_used(rs->src) && processed < max_bytes) {
+        ch = pagerhist_remove_char(rs->src, &count, record);
+        processed += count;
+        if (ch == '\n') {
+            initialize_wcs_state(&rs->wcs_state);
+            ch_width = 1;
+            WRITE_CHAR();
+            rs->num_in_current_line = 0;
+        } else if (ch != '\r') {
+            ch_width = wcswidth_step(&rs->wcs_state, ch);
+            WRITE_CHAR();
+        }
     }
+#undef WRITE_CHAR
+    if (ringbuf_bytes_used(rs->src)) return false;
+    pagerhist_discard_rewrap(ph);
     return true;
 }
 
+static void
+pagerhist_rewrap_to(HistoryBuf *self, index_type cells_in_line) {
+    PagerHistoryBuf *ph = self->pagerhist;
+    // finish any pass already in progress before starting one at the new width
+    pagerhist_rewrap_step(ph, SIZE_MAX);
+    if (pagerhist_rewrap_start(self, cells_in_line)) pagerhist_rewrap_step(ph, SIZE_MAX);
+}
+
 static inline void
 pagerhist_push(HistoryBuf *self, ANSIBuf *as_ansi_buf) {
     PagerHistoryBuf *ph = self->pagerhist;
     if (!ph) return;
+    if (ph->rewrap_needed && !ph->rewrap_state) pagerhist_rewrap_start(self, self->xnum);
+    pagerhist_rewrap_step(ph, PAGERHIST_REWRAP_CHUNK_SIZE);
     const GPUCell *prev_cell = NULL;
     Line l = {.xnum=self->xnum};
     init_line(self, self->start_of_data, &l);
     line_as_ansi(&l, as_ansi_buf, &prev_cell);
-    if (ringbuf_bytes_used(ph->ringbuf) && !l.continued) pagerhist_write_bytes(ph, (const uint8_t*)"\n", 1);
+    const bool needs_newline = ringbuf_bytes_used(*pagerhist_write_target(ph)) && !l.continued;
+    uint8_t scratch[4096];
+    if (as_ansi_buf->len <= sizeof(scratch) / 4) {
+        // the common case: the whole line fits in the scratch buffer, append
+        // separator, SGR reset, text and carriage return as a single write
+        size_t used = 0;
+        for (size_t i = 0; i < as_ansi_buf->len; i++) used += encode_utf8(as_ansi_buf->buf[i], (char*)(scratch + used));
+        struct iovec iov[4]; int iovcnt = 0;
+        if (needs_newline) iov[iovcnt++] = (struct iovec){.iov_base=(void*)"\n", .iov_len=1};
+        iov[iovcnt++] = (struct iovec){.iov_base=(void*)"\x1b[m", .iov_len=3};
+        iov[iovcnt++] = (struct iovec){.iov_base=scratch, .iov_len=used};
+        iov[iovcnt++] = (struct iovec){.iov_base=(void*)"\r", .iov_len=1};
+        pagerhist_write_v(ph, iov, iovcnt);
+        return;
+    }
+    if (needs_newline) pagerhist_write_bytes(ph, (const uint8_t*)"\n", 1);
     pagerhist_write_bytes(ph, (const uint8_t*)"\x1b[m", 3);
     if (pagerhist_write_ucs4(ph, as_ansi_buf->buf, as_ansi_buf->len)) pagerhist_write_bytes(ph, (const uint8_t*)"\r", 1);
 }
@@ -237,6 +639,14 @@ pagerhist_push(HistoryBuf *self, ANSIBuf *as_ansi_buf) {
 static inline index_type
 historybuf_push(HistoryBuf *self, ANSIBuf *as_ansi_buf) {
     index_type idx = (self->start_of_data + self->count) % self->ynum;
+    index_type seg_num = idx / SEGMENT_SIZE;
+    if (UNLIKELY(seg_num != self->active_segment)) {
+        // the write cursor has moved into a new segment, compress whatever
+        // has gone cold. Do this before init_line() so that self->line cannot
+        // be left pointing into freed storage.
+        self->active_segment = seg_num;
+        compress_cold_segments(self, seg_num);
+    }
     init_line(self, idx, self->line);
     if (self->count == self->ynum) {
         pagerhist_push(self, as_ansi_buf);
@@ -255,6 +665,7 @@ historybuf_add_line(HistoryBuf *self, const Line *line, ANSIBuf *as_ansi_buf) {
 static PyObject*
 line(HistoryBuf *self, PyObject *val) {
 #define line_doc "Return the line with line number val. This buffer grows upwards, i.e. 0 is the most recently added line"
+    historybuf_resolve_deferred_rewrap(self);
     if (self->count == 0) { PyErr_SetString(PyExc_IndexError, "This buffer is empty"); return NULL; }
     index_type lnum = PyLong_AsUnsignedLong(val);
     if (lnum >= self->count) { PyErr_SetString(PyExc_IndexError, "Out of bounds"); return NULL; }
@@ -265,6 +676,7 @@ line(HistoryBuf *self, PyObject *val) {
 
 static PyObject*
 __str__(HistoryBuf *self) {
+    historybuf_resolve_deferred_rewrap(self);
     PyObject *lines = PyTuple_New(self->count);
     if (lines == NULL) return PyErr_NoMemory();
     for (index_type i = 0; i < self->count; i++) {
@@ -293,6 +705,7 @@ push(HistoryBuf *self, PyObject *args) {
 static PyObject*
 as_ansi(HistoryBuf *self, PyObject *callback) {
 #define as_ansi_doc "as_ansi(callback) -> The contents of this buffer as ANSI escaped text. callback is called with each successive line."
+    historybuf_resolve_deferred_rewrap(self);
     Line l = {.xnum=self->xnum};
     const GPUCell *prev_cell = NULL;
     ANSIBuf output = {0};
@@ -322,64 +735,6 @@ end:
 static inline Line*
 get_line(HistoryBuf *self, index_type y, Line *l) { init_line(self, index_of(self, self->count - y - 1), l); return l; }
 
-static inline char_type
-pagerhist_remove_char(PagerHistoryBuf *ph, unsigned *count, uint8_t record[8]) {
-    uint32_t codep, state = UTF8_ACCEPT;
-    *count = 0;
-    size_t num = ringbuf_bytes_used(ph->ringbuf);
-    while (num--) {
-        record[*count] = ringbuf_move_char(ph->ringbuf);
-        decode_utf8(&state, &codep, record[*count]);
-        *count += 1;
-        if (state == UTF8_REJECT) { codep = 0; break; }
-        if (state == UTF8_ACCEPT) break;
-    }
-    return codep;
-}
-
-static void
-pagerhist_rewrap_to(HistoryBuf *self, index_type cells_in_line) {
-    PagerHistoryBuf *ph = self->pagerhist;
-    if (!ph->ringbuf || !ringbuf_bytes_used(ph->ringbuf)) return;
-    PagerHistoryBuf *nph = PyMem_Calloc(sizeof(PagerHistoryBuf), 1);
-    if (!nph) return;
-    nph->maximum_size = ph->maximum_size;
-    nph->ringbuf = ringbuf_new(MIN(ph->maximum_size, ringbuf_capacity(ph->ringbuf) + 4096));
-    if (!nph->ringbuf) { PyMem_Free(nph); return ; }
-    ssize_t ch_width = 0;
-    unsigned count;
-    uint8_t record[8];
-    index_type num_in_current_line = 0;
-    char_type ch;
-    WCSState wcs_state;
-    initialize_wcs_state(&wcs_state);
-
-#define WRITE_CHAR() { \
-    if (num_in_current_line + ch_width > cells_in_line) { \
-        pagerhist_write_bytes(nph, (const uint8_t*)"\r", 1); \
-        num_in_current_line = 0; \
-    }\
-    if (ch_width >= 0 || (int)num_in_current_line >= -ch_width) num_in_current_line += ch_width; \
-    pagerhist_write_bytes(nph, record, count); \
-}
-
-    while (ringbuf_bytes_used(ph->ringbuf)) {
-        ch = pagerhist_remove_char(ph, &count, record);
-        if (ch == '\n') {
-            initialize_wcs_state(&wcs_state);
-            ch_width = 1;
-            WRITE_CHAR();
-            num_in_current_line = 0;
-        } else if (ch != '\r') {
-            ch_width = wcswidth_step(&wcs_state, ch);
-            WRITE_CHAR();
-        }
-    }
-    free_pagerhist(self);
-    self->pagerhist = nph;
-#undef WRITE_CHAR
-}
-
 static PyObject*
 pagerhist_write(HistoryBuf *self, PyObject *what) {
     if (self->pagerhist && self->pagerhist->maximum_size) {
@@ -388,7 +743,7 @@ pagerhist_write(HistoryBuf *self, PyObject *what) {
             Py_UCS4 *buf = PyUnicode_AsUCS4Copy(what);
             if (buf) {
                 pagerhist_write_ucs4(self->pagerhist, buf, PyUnicode_GET_LENGTH(what));
-                PyMem_Free(buf);
+                PyMem_RawFree(buf);
             }
         }
     }
@@ -398,9 +753,11 @@ pagerhist_write(HistoryBuf *self, PyObject *what) {
 static PyObject*
 pagerhist_as_bytes(HistoryBuf *self, PyObject *args UNUSED) {
     PagerHistoryBuf *ph = self->pagerhist;
-    if (!ph || !ringbuf_bytes_used(ph->ringbuf)) return PyBytes_FromStringAndSize("", 0);
-    pagerhist_ensure_start_is_valid_utf8(ph);
+    if (!ph) return PyBytes_FromStringAndSize("", 0);
+    pagerhist_rewrap_step(ph, SIZE_MAX);  // finish any in-progress chunked rewrap
     if (ph->rewrap_needed) pagerhist_rewrap_to(self, self->xnum);
+    if (!ringbuf_bytes_used(ph->ringbuf)) return PyBytes_FromStringAndSize("", 0);
+    pagerhist_ensure_start_is_valid_utf8(ph);
 
     Line l = {.xnum=self->xnum}; get_line(self, 0, &l);
     size_t sz = ringbuf_bytes_used(ph->ringbuf);
@@ -438,6 +795,7 @@ get_line_wrapper(void *x, int y) {
 
 static PyObject*
 as_text(HistoryBuf *self, PyObject *args) {
+    historybuf_resolve_deferred_rewrap(self);
     GetLineWrapper glw = {.self=self};
     glw.line.xnum = self->xnum;
     ANSIBuf output = {0};
@@ -447,9 +805,28 @@ as_text(HistoryBuf *self, PyObject *args) {
 }
 
 
+static PyObject*
+find_text(HistoryBuf *self, PyObject *args) {
+#define find_text_doc "find_text(needle, no_case=False) -> Tuple of (y, x) match positions, y in the same visual (oldest first) order as as_text(). Matches follow wrapped line boundaries. Successive calls with a longer needle only re-verify the cached matches."
+    historybuf_resolve_deferred_rewrap(self);
+    if (self->search.needle && (self->search.count_snapshot != self->count || self->search.start_snapshot != self->start_of_data)) {
+        // lines were pushed or the buffer was rewrapped, cached match
+        // positions are no longer valid
+        PyMem_RawFree(self->search.needle); self->search.needle = NULL;
+        self->search.needle_len = 0; self->search.num_matches = 0;
+    }
+    GetLineWrapper glw = {.self=self};
+    glw.line.xnum = self->xnum;
+    PyObject *ans = search_generic(args, &glw, get_line_wrapper, self->count, &self->search);
+    self->search.count_snapshot = self->count;
+    self->search.start_snapshot = self->start_of_data;
+    return ans;
+}
+
 static PyObject*
 dirty_lines(HistoryBuf *self, PyObject *a UNUSED) {
 #define dirty_lines_doc "dirty_lines() -> Line numbers of all lines that have dirty text."
+    historybuf_resolve_deferred_rewrap(self);
     PyObject *ans = PyList_New(0);
     for (index_type i = 0; i < self->count; i++) {
         if (*attrptr(self, i) & TEXT_DIRTY_MASK) {
@@ -459,6 +836,25 @@ dirty_lines(HistoryBuf *self, PyObject *a UNUSED) {
     return ans;
 }
 
+static PyObject*
+memory_used(HistoryBuf *self, PyObject *a UNUSED) {
+#define memory_used_doc "memory_used() -> Number of bytes of cell storage used by this buffer, including compressed segments."
+    size_t ans = 0;
+    for (size_t i = 0; i < self->num_segments; i++) {
+        if (self->segments[i].cpu_cells) ans += segment_raw_sz(self);
+        ans += self->segments[i].compressed_sz;
+    }
+    return PyLong_FromSize_t(ans);
+}
+
+static PyObject*
+pagerhist_memory_used(HistoryBuf *self, PyObject *a UNUSED) {
+#define pagerhist_memory_used_doc "pagerhist_memory_used() -> Number of bytes used by the pager history ring buffer."
+    size_t ans = self->pagerhist && self->pagerhist->ringbuf ? ringbuf_buffer_size(self->pagerhist->ringbuf) : 0;
+    if (self->pagerhist && self->pagerhist->rewrap_state) ans += ringbuf_buffer_size(((PagerRewrapState*)self->pagerhist->rewrap_state)->src);
+    return PyLong_FromSize_t(ans);
+}
+
 static PyObject*
 pagerhist_rewrap(HistoryBuf *self, PyObject *xnum) {
     if (self->pagerhist) {
@@ -480,7 +876,10 @@ static PyMethodDef methods[] = {
     METHODB(pagerhist_as_text, METH_NOARGS),
     METHODB(pagerhist_as_bytes, METH_NOARGS),
     METHODB(as_text, METH_VARARGS),
+    METHOD(find_text, METH_VARARGS)
     METHOD(dirty_lines, METH_NOARGS)
+    METHOD(memory_used, METH_NOARGS)
+    METHOD(pagerhist_memory_used, METH_NOARGS)
     METHOD(push, METH_VARARGS)
     METHOD(rewrap, METH_VARARGS)
     {NULL, NULL, 0, NULL}  /* Sentinel */
@@ -493,6 +892,26 @@ static PyMemberDef members[] = {
     {NULL}  /* Sentinel */
 };
 
+static PyObject*
+set_scrollback_memory_budget(PyObject *self UNUSED, PyObject *val) {
+    if (!PyLong_Check(val)) { PyErr_SetString(PyExc_TypeError, "budget must be an integer number of bytes"); return NULL; }
+    scrollback_memory_budget = PyLong_AsSize_t(val);
+    if (PyErr_Occurred()) return NULL;
+    enforce_scrollback_budget(NULL);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+scrollback_memory_used(PyObject *self UNUSED, PyObject *a UNUSED) {
+    return PyLong_FromSize_t(total_resident_cell_bytes);
+}
+
+static PyMethodDef module_methods[] = {
+    METHODB(set_scrollback_memory_budget, METH_O),
+    METHODB(scrollback_memory_used, METH_NOARGS),
+    {NULL, NULL, 0, NULL}  /* Sentinel */
+};
+
 PyTypeObject HistoryBuf_Type = {
     PyVarObject_HEAD_INIT(NULL, 0)
     .tp_name = "fast_data_types.HistoryBuf",
@@ -506,6 +925,8 @@ PyTypeObject HistoryBuf_Type = {
     .tp_new = new
 };
 
+#undef EXTRA_INIT
+#define EXTRA_INIT if (PyModule_AddFunctions(module, module_methods) != 0) return 0
 INIT_TYPE(HistoryBuf)
 
 HistoryBuf *alloc_historybuf(unsigned int lines, unsigned int columns, unsigned int pagerhist_sz) {
@@ -513,10 +934,35 @@ HistoryBuf *alloc_historybuf(unsigned int lines, unsigned int columns, unsigned
 }
 // }}}
 
+static void
+release_consumed_segments(HistoryBuf *self, index_type num_consumed) {
+    // A rewrap into another buffer walks this buffer's lines oldest first.
+    // When this buffer is an orphan about to be freed, release the storage of
+    // every segment the walk has fully consumed, so that the transient
+    // memory overhead of a rewrap is bounded by a segment of overlap instead
+    // of a second full copy of the scrollback
+    if (LIKELY(!self->free_segments_as_rewrap_consumes) || num_consumed == 0) return;
+    index_type prev_seg = ((self->start_of_data + num_consumed - 1) % self->ynum) / SEGMENT_SIZE;
+    if (num_consumed < self->count && ((self->start_of_data + num_consumed) % self->ynum) / SEGMENT_SIZE == prev_seg) return;
+    // the walk re-enters the segment containing start_of_data after the ring
+    // wraps around, that one is left for dealloc to free
+    if (prev_seg == self->start_of_data / SEGMENT_SIZE) return;
+    HistoryBufSegment *s = self->segments + prev_seg;
+    PyMem_RawFree(s->compressed); s->compressed = NULL; s->compressed_sz = 0;
+    if (s->cpu_cells) {
+        total_resident_cell_bytes -= segment_raw_sz(self);
+        if (s->mmap_block) { munmap(s->mmap_block, s->mmap_block_sz); s->mmap_block = NULL; s->mmap_block_sz = 0; }
+        else { PyMem_RawFree(s->cpu_cells); PyMem_RawFree(s->gpu_cells); }
+        s->cpu_cells = NULL; s->gpu_cells = NULL;
+    }
+}
+
 #define BufType HistoryBuf
 
 #define map_src_index(y) ((src->start_of_data + y) % src->ynum)
 
+#define src_line_was_consumed(num_consumed) release_consumed_segments(src, num_consumed);
+
 #define init_src_line(src_y) init_line(src, map_src_index(src_y), src->line);
 
 #define is_src_line_continued(src_y) (map_src_index(src_y) < src->ynum - 1 ? (*attrptr(src, map_src_index(src_y + 1)) & CONTINUED_MASK) : false)
@@ -528,13 +974,16 @@ HistoryBuf *alloc_historybuf(unsigned int lines, unsigned int columns, unsigned
 #include "rewrap.h"
 
 void historybuf_rewrap(HistoryBuf *self, HistoryBuf *other, ANSIBuf *as_ansi_buf) {
+    historybuf_resolve_deferred_rewrap(self);
+    historybuf_resolve_deferred_rewrap(other);
     while(other->num_segments < self->num_segments) add_segment(other);
     if (other->xnum == self->xnum && other->ynum == self->ynum) {
         // Fast path
         for (index_type i = 0; i < self->num_segments; i++) {
-            memcpy(other->segments[i].cpu_cells, self->segments[i].cpu_cells, SEGMENT_SIZE * self->xnum * sizeof(CPUCell));
-            memcpy(other->segments[i].gpu_cells, self->segments[i].gpu_cells, SEGMENT_SIZE * self->xnum * sizeof(GPUCell));
-            memcpy(other->segments[i].line_attrs, self->segments[i].line_attrs, SEGMENT_SIZE * sizeof(line_attrs_type));
+            HistoryBufSegment *src = cells_segment(self, i), *dest = cells_segment(other, i);
+            memcpy(dest->cpu_cells, src->cpu_cells, SEGMENT_SIZE * self->xnum * sizeof(CPUCell));
+            memcpy(dest->gpu_cells, src->gpu_cells, SEGMENT_SIZE * self->xnum * sizeof(GPUCell));
+            memcpy(dest->line_attrs, src->line_attrs, SEGMENT_SIZE * sizeof(line_attrs_type));
         }
         other->count = self->count; other->start_of_data = self->start_of_data;
         return;
@@ -558,3 +1007,74 @@ rewrap(HistoryBuf *self, PyObject *args) {
     free(as_ansi_buf.buf);
     Py_RETURN_NONE;
 }
+
+void
+historybuf_defer_rewrap(HistoryBuf *self, HistoryBuf *dest) {
+    // Reflowing the whole scrollback on every step of an interactive resize
+    // is far too expensive, so it is put off until the scrollback is next
+    // accessed, in the same spirit as PagerHistoryBuf::rewrap_needed.
+    if (dest->pagerhist && dest->xnum != self->xnum && ringbuf_bytes_used(dest->pagerhist->ringbuf))
+        dest->pagerhist->rewrap_needed = true;
+    // skip over intermediate buffers that never received any lines of their own
+    HistoryBuf *src = self;
+    while (src->count == 0 && src->deferred_rewrap_src) src = (HistoryBuf*)src->deferred_rewrap_src;
+    if (src->count) {
+        Py_INCREF(src);
+        // src is now an orphan kept alive only until it is rewrapped into
+        // dest, so the rewrap may free its segments as it consumes them
+        src->free_segments_as_rewrap_consumes = true;
+        dest->deferred_rewrap_src = (PyObject*)src;
+    }
+}
+
+static void
+append_rewrap(HistoryBuf *src, HistoryBuf *dest, ANSIBuf *as_ansi_buf) {
+    // oldest content first: walk to the bottom of the chain of deferred
+    // buffers before appending the lines src itself received
+    if (src->deferred_rewrap_src) {
+        HistoryBuf *deeper = (HistoryBuf*)src->deferred_rewrap_src;
+        src->deferred_rewrap_src = NULL;
+        append_rewrap(deeper, dest, as_ansi_buf);
+        Py_DECREF(deeper);
+    }
+    if (src->count) {
+        index_type x = 0, y = 0;
+        rewrap_inner(src, dest, src->count, NULL, &x, &y, as_ansi_buf);
+    }
+}
+
+void
+historybuf_resolve_deferred_rewrap(HistoryBuf *self) {
+    if (LIKELY(self->deferred_rewrap_src == NULL)) return;
+    HistoryBuf *src = (HistoryBuf*)self->deferred_rewrap_src;
+    self->deferred_rewrap_src = NULL;
+    ANSIBuf as_ansi_buf = {0};
+    // stash the lines added since the resize, they have to end up after the
+    // rewrapped older content
+    index_type num_pushed = self->count;
+    CPUCell *cpu = NULL; GPUCell *gpu = NULL; line_attrs_type *attrs = NULL;
+    if (num_pushed) {
+        cpu = PyMem_RawMalloc(num_pushed * self->xnum * sizeof(CPUCell));
+        gpu = PyMem_RawMalloc(num_pushed * self->xnum * sizeof(GPUCell));
+        attrs = PyMem_RawMalloc(num_pushed * sizeof(line_attrs_type));
+        if (cpu == NULL || gpu == NULL || attrs == NULL) fatal("Out of memory resolving deferred scrollback rewrap");
+        for (index_type i = 0; i < num_pushed; i++) {
+            index_type idx = (self->start_of_data + i) % self->ynum;
+            memcpy(cpu + i * self->xnum, cpu_lineptr(self, idx), self->xnum * sizeof(CPUCell));
+            memcpy(gpu + i * self->xnum, gpu_lineptr(self, idx), self->xnum * sizeof(GPUCell));
+            attrs[i] = *attrptr(self, idx);
+        }
+    }
+    self->count = 0; self->start_of_data = 0;
+    append_rewrap(src, self, &as_ansi_buf);
+    Py_DECREF(src);
+    for (index_type i = 0; i < self->count; i++) *attrptr(self, (self->start_of_data + i) % self->ynum) |= TEXT_DIRTY_MASK;
+    for (index_type i = 0; i < num_pushed; i++) {
+        index_type idx = historybuf_push(self, &as_ansi_buf);
+        memcpy(cpu_lineptr(self, idx), cpu + i * self->xnum, self->xnum * sizeof(CPUCell));
+        memcpy(gpu_lineptr(self, idx), gpu + i * self->xnum, self->xnum * sizeof(GPUCell));
+        *attrptr(self, idx) = attrs[i];
+    }
+    if (num_pushed) { PyMem_RawFree(cpu); PyMem_RawFree(gpu); PyMem_RawFree(attrs); }
+    free(as_ansi_buf.buf);
+}
@@ -11,20 +11,21 @@
 
 #define MAX_KEY_LEN 2048
 #define MAX_ID_LEN 256
-#define MAX_ADDS_BEFORE_GC 256
 #undef uthash_fatal
 #define uthash_fatal(msg) fatal(msg)
 
 typedef struct {
     const char *key;
     hyperlink_id_type id;
-    UT_hash_handle hh;
+    UT_hash_handle hh;     // keyed by the id:url string
+    UT_hash_handle hh_id;  // keyed by the id, for O(1) reverse lookups
 } HyperLinkEntry;
 
 
 typedef struct {
-    HyperLinkEntry *hyperlinks;
-    unsigned int max_link_id, num_of_adds_since_garbage_collection;
+    HyperLinkEntry *hyperlinks;        // by string key
+    HyperLinkEntry *hyperlinks_by_id;  // by id
+    unsigned int max_link_id;
 } HyperLinkPool;
 
 
@@ -34,13 +35,19 @@ free_hyperlink_entry(HyperLinkEntry *s) {
     free(s);
 }
 
+static inline void
+remove_entry(HyperLinkPool *pool, HyperLinkEntry *s) {
+    HASH_DEL(pool->hyperlinks, s);
+    HASH_DELETE(hh_id, pool->hyperlinks_by_id, s);
+    free_hyperlink_entry(s);
+}
+
 static void
 clear_pool(HyperLinkPool *pool) {
     if (pool->hyperlinks) {
         HyperLinkEntry *tmp, *s;
         HASH_ITER(hh, pool->hyperlinks, s, tmp) {
-            HASH_DEL(pool->hyperlinks, s);
-            free_hyperlink_entry(s); s = NULL;
+            remove_entry(pool, s); s = NULL;
         }
         pool->max_link_id = 0;
     }
@@ -73,8 +80,12 @@ free_hyperlink_pool(HYPERLINK_POOL_HANDLE h) {
 
 void
 screen_garbage_collect_hyperlink_pool(Screen *screen) {
+    // mark and sweep: entries no longer referenced from any cell, including
+    // cleared scrollback, are released and the surviving ids are compacted
+    // down from 1. Cells are written with bulk copies and memsets all over
+    // the line buffers, so per cell reference counts are not tracked,
+    // instead this runs when the id space is exhausted.
     HyperLinkPool *pool = (HyperLinkPool*)screen->hyperlink_pool;
-    pool->num_of_adds_since_garbage_collection = 0;
     if (!pool->max_link_id) return;
     hyperlink_id_type *map = calloc(HYPERLINK_MAX_NUMBER + 4, sizeof(hyperlink_id_type));
     if (!map) fatal("Out of memory");
@@ -82,9 +93,11 @@ screen_garbage_collect_hyperlink_pool(Screen *screen) {
     if (num) {
         HyperLinkEntry *s, *tmp;
         pool->max_link_id = 0;
+        HASH_CLEAR(hh_id, pool->hyperlinks_by_id);
         HASH_ITER(hh, pool->hyperlinks, s, tmp) {
             if (map[s->id]) {
                 s->id = map[s->id];
+                HASH_ADD(hh_id, pool->hyperlinks_by_id, id, sizeof(s->id), s);
                 pool->max_link_id = MAX(pool->max_link_id, s->id);
             } else {
                 HASH_DEL(pool->hyperlinks, s);
@@ -117,13 +130,15 @@ get_id_for_hyperlink(Screen *screen, const char *id, const char *url) {
         }
     }
     hyperlink_id_type new_id = 0;
-    if (pool->num_of_adds_since_garbage_collection >= MAX_ADDS_BEFORE_GC) screen_garbage_collect_hyperlink_pool(screen);
-    if (pool->max_link_id >= HYPERLINK_MAX_NUMBER && pool->hyperlinks) {
-        log_error("Too many hyperlinks, discarding oldest, this means some hyperlinks might be incorrect");
-        new_id = pool->hyperlinks->id;
-        HyperLinkEntry *s = pool->hyperlinks;
-        HASH_DEL(pool->hyperlinks, s);
-        free_hyperlink_entry(s); s = NULL;
+    if (pool->max_link_id >= HYPERLINK_MAX_NUMBER) {
+        // the id space is exhausted, compact it by dropping entries no
+        // longer referenced from any cell
+        screen_garbage_collect_hyperlink_pool(screen);
+        if (pool->max_link_id >= HYPERLINK_MAX_NUMBER && pool->hyperlinks) {
+            log_error("Too many hyperlinks, discarding oldest, this means some hyperlinks might be incorrect");
+            new_id = pool->hyperlinks->id;
+            remove_entry(pool, pool->hyperlinks);
+        }
     }
     s = malloc(sizeof(HyperLinkEntry));
     if (!s) fatal("Out of memory");
@@ -132,18 +147,17 @@ get_id_for_hyperlink(Screen *screen, const char *id, const char *url) {
     memcpy((void*)s->key, key, keylen + 1);
     s->id = new_id ? new_id : ++pool->max_link_id;
     HASH_ADD_KEYPTR(hh, pool->hyperlinks, s->key, keylen, s);
-    pool->num_of_adds_since_garbage_collection++;
+    HASH_ADD(hh_id, pool->hyperlinks_by_id, id, sizeof(s->id), s);
     return s->id;
 }
 
 const char*
 get_hyperlink_for_id(const HYPERLINK_POOL_HANDLE handle, hyperlink_id_type id, bool only_url) {
-    const HyperLinkPool *pool = (HyperLinkPool*)handle;
-    HyperLinkEntry *s, *tmp;
-    HASH_ITER(hh, pool->hyperlinks, s, tmp) {
-        if (s->id == id) return only_url ? strstr(s->key, ":") + 1 : s->key;
-    }
-    return NULL;
+    HyperLinkPool *pool = (HyperLinkPool*)handle;
+    HyperLinkEntry *s;
+    HASH_FIND(hh_id, pool->hyperlinks_by_id, &id, sizeof(id), s);
+    if (!s) return NULL;
+    return only_url ? strstr(s->key, ":") + 1 : s->key;
 }
 
 
@@ -75,7 +75,7 @@ is_modifier_key(int key) {
     }
 }
 
-static inline void
+static inline bool
 send_key_to_child(Window *w, int key, int mods, int action) {
     Screen *screen = w->render_data.screen;
     const char *data = key_to_bytes(key, screen->modes.mDECCKM, screen->modes.mEXTENDED_KEYBOARD, mods, action);
@@ -88,7 +88,44 @@ send_key_to_child(Window *w, int key, int mods, int action) {
                 write_escape_code_to_child(screen, CSI, data + 3);
             } else schedule_write_to_child(w->id, 1, (data + 1), *data);
         }
+        return true;
+    }
+    return false;
+}
+
+// stamp for keypress-to-pixel latency measurement, see key_latency in
+// screen.h; only the oldest outstanding keystroke is tracked so that a fast
+// typist does not keep resetting the clock
+static inline void
+stamp_key_latency(Screen *screen) {
+    if (!screen->key_latency.pressed_at) screen->key_latency.pressed_at = monotonic();
+}
+
+static size_t
+encode_key_to_buf(Screen *screen, int key, int mods, int action, char *buf, size_t capacity) {
+    // the same byte stream send_key_to_child() produces, only appended to a
+    // buffer so multiple key events can be sent to the child in one write
+    const char *data = key_to_bytes(key, screen->modes.mDECCKM, screen->modes.mEXTENDED_KEYBOARD, mods, action);
+    if (data == NULL) return 0;
+    size_t pos = 0;
+#define add_bytes(s, n) { size_t sz_ = (n); if (pos + sz_ > capacity) return 0; memcpy(buf + pos, s, sz_); pos += sz_; }
+#define add_str(s) add_bytes(s, strlen(s))
+    if (screen->modes.mEXTENDED_KEYBOARD) {
+        if (*data == 1) { add_bytes(data + 1, 1); }
+        else {
+            add_str(screen->modes.eight_bit_controls ? "\x9f" : "\033_");
+            add_str(data + 1);
+            add_str(screen->modes.eight_bit_controls ? "\x9c" : "\033\\");
+        }
+    } else {
+        if (*data > 2 && data[1] == 0x1b && data[2] == '[') { // CSI code
+            add_str(screen->modes.eight_bit_controls ? "\x9b" : "\033[");
+            add_str(data + 3);
+        } else add_bytes(data + 1, *data);
     }
+    return pos;
+#undef add_str
+#undef add_bytes
 }
 
 static inline bool
@@ -144,6 +181,7 @@ on_key_input(GLFWkeyevent *ev) {
         case 2:  // commit text
             if (*text) {
                 schedule_write_to_child(w->id, 1, text, strlen(text));
+                stamp_key_latency(screen);
                 debug("committed pre-edit text: %s\n", text);
             } else debug("committed pre-edit text: (null)\n");
             screen_draw_overlay_text(screen, NULL);
@@ -193,9 +231,10 @@ on_key_input(GLFWkeyevent *ev) {
     if (ok_to_send) {
         if (has_text) {
             schedule_write_to_child(w->id, 1, text, strlen(text));
+            stamp_key_latency(screen);
             debug("sent text to child\n");
         } else {
-            send_key_to_child(w, key, mods, action);
+            if (send_key_to_child(w, key, mods, action)) stamp_key_latency(screen);
             debug("sent key to child\n");
         }
     } else {
@@ -205,12 +244,24 @@ on_key_input(GLFWkeyevent *ev) {
 
 void
 fake_scroll(Window *w, int amount, bool upwards) {
-    if (!w) return;
+    if (!w || amount < 1) return;
     int key = upwards ? GLFW_KEY_UP : GLFW_KEY_DOWN;
+    Screen *screen = w->render_data.screen;
+    // encode the repeated arrow key once and send all the repeats in a
+    // single write, high resolution wheels generate many lines per event
+    // and a separate locked write with an io thread wakeup per line is
+    // needless overhead
+    char one[64];
+    size_t one_sz = encode_key_to_buf(screen, key, 0, GLFW_PRESS, one, sizeof(one));
+    one_sz += encode_key_to_buf(screen, key, 0, GLFW_RELEASE, one + one_sz, sizeof(one) - one_sz);
+    if (!one_sz) return;
+    char buf[8192];
+    size_t pos = 0;
     while (amount-- > 0) {
-        send_key_to_child(w, key, 0, GLFW_PRESS);
-        send_key_to_child(w, key, 0, GLFW_RELEASE);
+        if (pos + one_sz > sizeof(buf)) { write_data_to_child(screen, buf, pos); pos = 0; }
+        memcpy(buf + pos, one, one_sz); pos += one_sz;
     }
+    if (pos) write_data_to_child(screen, buf, pos);
 }
 
 #define PYWRAP1(name) static PyObject* py##name(PyObject UNUSED *self, PyObject *args)
@@ -29,26 +29,47 @@ clear_chars_to(LineBuf* linebuf, index_type y, char_type ch) {
 
 void
 linebuf_clear(LineBuf *self, char_type ch) {
-    zero_at_ptr_count(self->cpu_cell_buf, self->xnum * self->ynum);
-    zero_at_ptr_count(self->gpu_cell_buf, self->xnum * self->ynum);
-    zero_at_ptr_count(self->line_attrs, self->ynum);
-    for (index_type i = 0; i < self->ynum; i++) self->line_map[i] = i;
-    if (ch != 0) {
-        for (index_type i = 0; i < self->ynum; i++) {
-            clear_chars_to(self, i, ch);
-            self->line_attrs[i] = TEXT_DIRTY_MASK;
-        }
+    if (ch == 0) {
+        zero_at_ptr_count(self->cpu_cell_buf, self->xnum * self->ynum);
+        zero_at_ptr_count(self->gpu_cell_buf, self->xnum * self->ynum);
+    } else {
+        // every cell gets the same contents, fill the whole buffer in one go
+        clear_chars_in_line(self->cpu_cell_buf, self->gpu_cell_buf, self->xnum * self->ynum, ch);
+    }
+    for (index_type i = 0; i < self->ynum; i++) {
+        self->line_map[i] = i;
+        self->line_attrs[i] = TEXT_DIRTY_MASK | GPU_DIRTY_MASK;
     }
 }
 
 void
 linebuf_mark_line_dirty(LineBuf *self, index_type y) {
-    self->line_attrs[y] |= TEXT_DIRTY_MASK;
+    self->line_attrs[y] &= ~(URL_SCANNED_MASK | HAS_URL_ANCHOR_MASK);
+    self->line_attrs[y] |= TEXT_DIRTY_MASK | GPU_DIRTY_MASK;
+}
+
+bool
+linebuf_line_may_have_url(LineBuf *self, index_type y) {
+    if (!(self->line_attrs[y] & URL_SCANNED_MASK)) {
+        linebuf_init_line(self, y);
+        self->line_attrs[y] |= URL_SCANNED_MASK | (line_has_url_anchor(self->line) ? HAS_URL_ANCHOR_MASK : 0);
+    }
+    return (self->line_attrs[y] & HAS_URL_ANCHOR_MASK) != 0;
 }
 
 void
 linebuf_mark_line_clean(LineBuf *self, index_type y) {
-    self->line_attrs[y] &= ~TEXT_DIRTY_MASK;
+    self->line_attrs[y] &= ~(TEXT_DIRTY_MASK | GPU_DIRTY_MASK);
+}
+
+void
+linebuf_mark_line_gpu_clean(LineBuf *self, index_type y) {
+    self->line_attrs[y] &= ~GPU_DIRTY_MASK;
+}
+
+bool
+linebuf_line_is_dirty(LineBuf *self, index_type y) {
+    return (self->line_attrs[y] & (TEXT_DIRTY_MASK | GPU_DIRTY_MASK)) != 0;
 }
 
 void
@@ -155,7 +176,7 @@ void
 linebuf_set_attribute(LineBuf *self, unsigned int shift, unsigned int val) {
     for (index_type y = 0; y < self->ynum; y++) {
         set_attribute_on_line(gpu_lineptr(self, y), shift, val, self->xnum);
-        self->line_attrs[y] |= TEXT_DIRTY_MASK;
+        self->line_attrs[y] |= TEXT_DIRTY_MASK | GPU_DIRTY_MASK;
     }
 }
 
@@ -260,7 +281,7 @@ linebuf_clear_line(LineBuf *self, index_type y) {
     Line l;
     init_line(self, &l, self->line_map[y]);
     clear_line_(&l, self->xnum);
-    self->line_attrs[y] = 0;
+    self->line_attrs[y] = GPU_DIRTY_MASK | URL_SCANNED_MASK;  // a blank line has no URL
 }
 
 static PyObject*
@@ -283,6 +304,41 @@ linebuf_index(LineBuf* self, index_type top, index_type bottom) {
     }
     self->line_map[bottom] = old_top;
     self->line_attrs[bottom] = old_attrs;
+    // every line in the region now shows different content
+    for (index_type i = top; i <= bottom; i++) self->line_attrs[i] |= GPU_DIRTY_MASK;
+}
+
+void
+linebuf_index_n(LineBuf* self, index_type top, index_type bottom, index_type n) {
+    // Rotate the region [top, bottom] upwards by n lines in a single pass,
+    // instead of n one line rotations. The attrs of the n lines rotated to
+    // the bottom are left stale, the caller must clear those lines.
+    if (top >= self->ynum - 1 || bottom >= self->ynum || bottom <= top || n == 0) return;
+    index_type num = bottom + 1 - top;
+    if (n < num) {
+        memcpy(self->scratch, self->line_map + top, n * sizeof(index_type));
+        memmove(self->line_map + top, self->line_map + top + n, (num - n) * sizeof(index_type));
+        memcpy(self->line_map + bottom + 1 - n, self->scratch, n * sizeof(index_type));
+        memmove(self->line_attrs + top, self->line_attrs + top + n, (num - n) * sizeof(line_attrs_type));
+    }  // n == num is the identity rotation
+    // every line in the region now shows different content
+    for (index_type i = top; i <= bottom; i++) self->line_attrs[i] |= GPU_DIRTY_MASK;
+}
+
+void
+linebuf_reverse_index_n(LineBuf* self, index_type top, index_type bottom, index_type n) {
+    // The inverse of linebuf_index_n(), the n lines rotated to the top must
+    // be cleared by the caller.
+    if (top >= self->ynum - 1 || bottom >= self->ynum || bottom <= top || n == 0) return;
+    index_type num = bottom + 1 - top;
+    if (n < num) {
+        memcpy(self->scratch, self->line_map + bottom + 1 - n, n * sizeof(index_type));
+        memmove(self->line_map + top + n, self->line_map + top, (num - n) * sizeof(index_type));
+        memcpy(self->line_map + top, self->scratch, n * sizeof(index_type));
+        memmove(self->line_attrs + top + n, self->line_attrs + top, (num - n) * sizeof(line_attrs_type));
+    }
+    // every line in the region now shows different content
+    for (index_type i = top; i <= bottom; i++) self->line_attrs[i] |= GPU_DIRTY_MASK;
 }
 
 static PyObject*
@@ -305,6 +361,8 @@ linebuf_reverse_index(LineBuf *self, index_type top, index_type bottom) {
     }
     self->line_map[top] = old_bottom;
     self->line_attrs[top] = old_attrs;
+    // every line in the region now shows different content
+    for (index_type i = top; i <= bottom; i++) self->line_attrs[i] |= GPU_DIRTY_MASK;
 }
 
 static PyObject*
@@ -350,6 +408,8 @@ linebuf_insert_lines(LineBuf *self, unsigned int num, unsigned int y, unsigned i
             clear_line_(&l, self->xnum);
             self->line_attrs[i] = 0;
         }
+        // every line in the region now shows different content
+        for (i = y; i < ylimit; i++) self->line_attrs[i] |= GPU_DIRTY_MASK;
     }
 }
 
@@ -385,6 +445,8 @@ linebuf_delete_lines(LineBuf *self, index_type num, index_type y, index_type bot
         clear_line_(&l, self->xnum);
         self->line_attrs[i] = 0;
     }
+    // every line in the region now shows different content
+    for (i = y; i < ylimit; i++) self->line_attrs[i] |= GPU_DIRTY_MASK;
 }
 
 static PyObject*
@@ -447,6 +509,12 @@ as_text(LineBuf *self, PyObject *args) {
     return ans;
 }
 
+static PyObject*
+find_text(LineBuf *self, PyObject *args) {
+#define find_text_doc "find_text(needle, no_case=False) -> Tuple of (y, x) match positions. Matches follow wrapped line boundaries. The screen is small, so no match cache is kept, unlike HistoryBuf.find_text()."
+    return search_generic(args, self, get_line, self->ynum, NULL);
+}
+
 
 static PyObject*
 __str__(LineBuf *self) {
@@ -464,6 +532,14 @@ __str__(LineBuf *self) {
     return ans;
 }
 
+static PyObject*
+memory_used(LineBuf *self, PyObject *a UNUSED) {
+#define memory_used_doc "memory_used() -> Number of bytes of cell storage used by this buffer."
+    size_t ans = (size_t)self->xnum * self->ynum * (sizeof(CPUCell) + sizeof(GPUCell));
+    ans += (size_t)self->ynum * (2 * sizeof(index_type) + sizeof(line_attrs_type));
+    return PyLong_FromSize_t(ans);
+}
+
 // Boilerplate {{{
 static PyObject*
 copy_old(LineBuf *self, PyObject *y);
@@ -483,9 +559,11 @@ static PyMethodDef methods[] = {
     METHOD(clear, METH_NOARGS)
     METHOD(as_ansi, METH_O)
     METHODB(as_text, METH_VARARGS),
+    METHOD(find_text, METH_VARARGS)
     METHOD(set_attribute, METH_VARARGS)
     METHOD(set_continued, METH_VARARGS)
     METHOD(dirty_lines, METH_NOARGS)
+    METHOD(memory_used, METH_NOARGS)
     {"index", (PyCFunction)pyw_index, METH_VARARGS, NULL},
     METHOD(reverse_index, METH_VARARGS)
     METHOD(insert_lines, METH_VARARGS)
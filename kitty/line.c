@@ -7,8 +7,10 @@
 
 #include "state.h"
 #include "unicode-data.h"
+#include "combining-chars.h"
 #include "lineops.h"
 #include "charsets.h"
+#include <regex.h>
 
 extern PyTypeObject Cursor_Type;
 
@@ -40,9 +42,9 @@ PyObject*
 cell_text(CPUCell *cell) {
     PyObject *ans;
     unsigned num = 1;
-    static Py_UCS4 buf[arraysz(cell->cc_idx) + 1];
+    static Py_UCS4 buf[MAX_COMBINING_CHARS_PER_CELL + 1];
     buf[0] = cell->ch;
-    for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) buf[num++] = codepoint_for_mark(cell->cc_idx[i]);
+    for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) buf[num++] = codepoint_for_mark(combining_mark_at(cell->cc_idx, i));
     ans = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, buf, num);
     return ans;
 }
@@ -150,6 +152,16 @@ line_startswith_url_chars(Line *self) {
     return is_url_char(self->cpu_cells[0].ch);
 }
 
+bool
+line_has_url_anchor(Line *self) {
+    // Both URL detection passes need a :// somewhere in the line, so its
+    // absence means the line cannot contain the start of a URL
+    for (index_type i = 2; i < self->xnum; i++) {
+        if (self->cpu_cells[i].ch == '/' && self->cpu_cells[i - 1].ch == '/' && self->cpu_cells[i - 2].ch == ':') return true;
+    }
+    return false;
+}
+
 
 static PyObject*
 url_start_at(Line *self, PyObject *x) {
@@ -180,7 +192,7 @@ cell_as_unicode(CPUCell *cell, bool include_cc, Py_UCS4 *buf, char_type zero_cha
     size_t n = 1;
     buf[0] = cell->ch ? cell->ch : zero_char;
     if (include_cc) {
-        for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) buf[n++] = codepoint_for_mark(cell->cc_idx[i]);
+        for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) buf[n++] = codepoint_for_mark(combining_mark_at(cell->cc_idx, i));
     }
     return n;
 }
@@ -190,8 +202,9 @@ cell_as_unicode_for_fallback(CPUCell *cell, Py_UCS4 *buf) {
     size_t n = 1;
     buf[0] = cell->ch ? cell->ch : ' ';
     if (buf[0] != '\t') {
-        for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) {
-            if (cell->cc_idx[i] != VS15 && cell->cc_idx[i] != VS16) buf[n++] = codepoint_for_mark(cell->cc_idx[i]);
+        for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) {
+            combining_type m = combining_mark_at(cell->cc_idx, i);
+            if (m != VS15 && m != VS16) buf[n++] = codepoint_for_mark(m);
         }
     } else buf[0] = ' ';
     return n;
@@ -203,7 +216,7 @@ cell_as_utf8(CPUCell *cell, bool include_cc, char *buf, char_type zero_char) {
     if (ch == '\t') { include_cc = false; }
     size_t n = encode_utf8(ch, buf);
     if (include_cc) {
-        for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) n += encode_utf8(codepoint_for_mark(cell->cc_idx[i]), buf + n);
+        for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) n += encode_utf8(codepoint_for_mark(combining_mark_at(cell->cc_idx, i)), buf + n);
     }
     buf[n] = 0;
     return n;
@@ -216,9 +229,10 @@ cell_as_utf8_for_fallback(CPUCell *cell, char *buf) {
     if (ch == '\t') { ch = ' '; include_cc = false; }
     size_t n = encode_utf8(ch, buf);
     if (include_cc) {
-        for (unsigned i = 0; i < arraysz(cell->cc_idx) && cell->cc_idx[i]; i++) {
-            if (cell->cc_idx[i] != VS15 && cell->cc_idx[i] != VS16) {
-                n += encode_utf8(codepoint_for_mark(cell->cc_idx[i]), buf + n);
+        for (unsigned i = 0, cn = num_combining_marks(cell->cc_idx); i < cn; i++) {
+            combining_type m = combining_mark_at(cell->cc_idx, i);
+            if (m != VS15 && m != VS16) {
+                n += encode_utf8(codepoint_for_mark(m), buf + n);
             }
         }
     }
@@ -228,20 +242,19 @@ cell_as_utf8_for_fallback(CPUCell *cell, char *buf) {
 
 
 
-PyObject*
-unicode_in_range(Line *self, index_type start, index_type limit, bool include_cc, char leading_char) {
+static size_t
+text_in_range(Line *self, index_type start, index_type limit, bool include_cc, char leading_char, Py_UCS4 *buf, size_t buf_sz) {
     size_t n = 0;
-    static Py_UCS4 buf[4096];
     if (leading_char) buf[n++] = leading_char;
     char_type previous_width = 0;
-    for(index_type i = start; i < limit && n < arraysz(buf) - 2 - arraysz(self->cpu_cells->cc_idx); i++) {
+    for(index_type i = start; i < limit && n < buf_sz - 2 - MAX_COMBINING_CHARS_PER_CELL; i++) {
         char_type ch = self->cpu_cells[i].ch;
         if (ch == 0) {
             if (previous_width == 2) { previous_width = 0; continue; };
         }
         if (ch == '\t') {
             buf[n++] = '\t';
-            unsigned num_cells_to_skip_for_tab = self->cpu_cells[i].cc_idx[0];
+            unsigned num_cells_to_skip_for_tab = self->cpu_cells[i].cc_idx;
             while (num_cells_to_skip_for_tab && i + 1 < limit && self->cpu_cells[i+1].ch == ' ') {
                 i++;
                 num_cells_to_skip_for_tab--;
@@ -251,6 +264,13 @@ unicode_in_range(Line *self, index_type start, index_type limit, bool include_cc
         }
         previous_width = self->gpu_cells[i].attrs & WIDTH_MASK;
     }
+    return n;
+}
+
+PyObject*
+unicode_in_range(Line *self, index_type start, index_type limit, bool include_cc, char leading_char) {
+    static Py_UCS4 buf[4096];
+    size_t n = text_in_range(self, start, limit, include_cc, leading_char, buf, arraysz(buf));
     return PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, buf, n);
 }
 
@@ -340,13 +360,13 @@ line_as_ansi(Line *self, ANSIBuf *output, const GPUCell** prev_cell) {
         *prev_cell = cell;
         WRITE_CH(ch);
         if (ch == '\t') {
-            unsigned num_cells_to_skip_for_tab = self->cpu_cells[pos].cc_idx[0];
+            unsigned num_cells_to_skip_for_tab = self->cpu_cells[pos].cc_idx;
             while (num_cells_to_skip_for_tab && pos + 1 < limit && self->cpu_cells[pos+1].ch == ' ') {
                 num_cells_to_skip_for_tab--; pos++;
             }
         } else {
-            for(unsigned c = 0; c < arraysz(self->cpu_cells[pos].cc_idx) && self->cpu_cells[pos].cc_idx[c]; c++) {
-                WRITE_CH(codepoint_for_mark(self->cpu_cells[pos].cc_idx[c]));
+            for(unsigned c = 0, cn = num_combining_marks(self->cpu_cells[pos].cc_idx); c < cn; c++) {
+                WRITE_CH(codepoint_for_mark(combining_mark_at(self->cpu_cells[pos].cc_idx, c)));
             }
         }
         previous_width = cell->attrs & WIDTH_MASK;
@@ -403,10 +423,7 @@ line_add_combining_char(Line *self, uint32_t ch, unsigned int x) {
         if (x > 0 && (self->gpu_cells[x-1].attrs & WIDTH_MASK) == 2 && self->cpu_cells[x-1].ch) cell = self->cpu_cells + x - 1;
         else return; // don't allow adding combining chars to a null cell
     }
-    for (unsigned i = 0; i < arraysz(cell->cc_idx); i++) {
-        if (!cell->cc_idx[i]) { cell->cc_idx[i] = mark_for_codepoint(ch); return; }
-    }
-    cell->cc_idx[arraysz(cell->cc_idx) - 1] = mark_for_codepoint(ch);
+    cell->cc_idx = add_combining_mark(cell->cc_idx, mark_for_codepoint(ch));
 }
 
 static PyObject*
@@ -457,7 +474,7 @@ set_text(Line* self, PyObject *args) {
         self->gpu_cells[i].fg = fg;
         self->gpu_cells[i].bg = bg;
         self->gpu_cells[i].decoration_fg = dfg;
-        memset(self->cpu_cells[i].cc_idx, 0, sizeof(self->cpu_cells[i].cc_idx));
+        self->cpu_cells[i].cc_idx = 0;
     }
 
     Py_RETURN_NONE;
@@ -487,9 +504,13 @@ cursor_from(Line* self, PyObject *args) {
 void
 line_clear_text(Line *self, unsigned int at, unsigned int num, char_type ch) {
     attrs_type width = ch ? 1 : 0;
-    for (index_type i = at; i < MIN(self->xnum, at + num); i++) {
-        self->cpu_cells[i].ch = ch; memset(self->cpu_cells[i].cc_idx, 0, sizeof(self->cpu_cells[i].cc_idx));
-        self->cpu_cells[i].hyperlink_id = 0;
+    if (at >= self->xnum) return;
+    num = MIN(self->xnum - at, num);
+    // Cleared CPU cells are all identical so they can be filled in bulk, the
+    // GPU cells keep their per-cell attributes and must be walked
+    const CPUCell blank = {.ch=ch};
+    fill_cpu_cells(self->cpu_cells + at, num, &blank);
+    for (index_type i = at; i < at + num; i++) {
         self->gpu_cells[i].attrs = (self->gpu_cells[i].attrs & ATTRS_MASK_WITHOUT_WIDTH) | width;
     }
 }
@@ -509,21 +530,19 @@ line_apply_cursor(Line *self, Cursor *cursor, unsigned int at, unsigned int num,
     char_type attrs = CURSOR_TO_ATTRS(cursor, 1);
     color_type fg = (cursor->fg & COL_MASK), bg = (cursor->bg & COL_MASK);
     color_type dfg = cursor->decoration_fg & COL_MASK;
-    if (!clear_char) attrs = attrs & ATTRS_MASK_WITHOUT_WIDTH;
-
-    for (index_type i = at; i < self->xnum && i < at + num; i++) {
-        if (clear_char) {
-            self->cpu_cells[i].ch = BLANK_CHAR;
-            self->cpu_cells[i].hyperlink_id = 0;
-            memset(self->cpu_cells[i].cc_idx, 0, sizeof(self->cpu_cells[i].cc_idx));
-            self->gpu_cells[i].attrs = attrs;
-            clear_sprite_position(self->gpu_cells[i]);
-        } else {
+    if (clear_char) {
+        // Cleared cells are all identical, build one blank pair and replicate it
+        const CPUCell blank_cpu = {.ch=BLANK_CHAR};
+        const GPUCell blank_gpu = {.attrs=(attrs_type)attrs, .fg=fg, .bg=bg, .decoration_fg=dfg};
+        if (at < self->xnum) fill_cells(self->cpu_cells + at, self->gpu_cells + at, MIN(self->xnum - at, num), &blank_cpu, &blank_gpu);
+    } else {
+        attrs = attrs & ATTRS_MASK_WITHOUT_WIDTH;
+        for (index_type i = at; i < self->xnum && i < at + num; i++) {
             attrs_type w = self->gpu_cells[i].attrs & WIDTH_MASK;
             self->gpu_cells[i].attrs = attrs | w;
+            self->gpu_cells[i].fg = fg; self->gpu_cells[i].bg = bg;
+            self->gpu_cells[i].decoration_fg = dfg;
         }
-        self->gpu_cells[i].fg = fg; self->gpu_cells[i].bg = bg;
-        self->gpu_cells[i].decoration_fg = dfg;
     }
 }
 
@@ -600,7 +619,7 @@ line_set_char(Line *self, unsigned int at, uint32_t ch, unsigned int width, Curs
     }
     self->cpu_cells[at].ch = ch;
     self->cpu_cells[at].hyperlink_id = hyperlink_id;
-    memset(self->cpu_cells[at].cc_idx, 0, sizeof(self->cpu_cells[at].cc_idx));
+    self->cpu_cells[at].cc_idx = 0;
 }
 
 static PyObject*
@@ -657,8 +676,8 @@ decoration_as_sgr(uint8_t decoration) {
 }
 
 
-const char*
-cell_as_sgr(const GPUCell *cell, const GPUCell *prev) {
+static const char*
+cell_as_sgr_uncached(const GPUCell *cell, const GPUCell *prev) {
     static char buf[128];
 #define SZ sizeof(buf) - (p - buf) - 2
 #define P(s) { size_t len = strlen(s); if (SZ > len) { memcpy(p, s, len); p += len; } }
@@ -696,6 +715,44 @@ cell_as_sgr(const GPUCell *cell, const GPUCell *prev) {
     return buf;
 }
 
+// Cache of computed SGR strings. The escape depends only on the attribute
+// and color differences between a cell and its predecessor, and styled
+// output cycles through a small set of such transitions, so a small direct
+// mapped cache eliminates nearly all of the snprintf work when serializing
+// large amounts of styled text.
+#define SGR_RELEVANT_ATTRS ( \
+        (1u << BOLD_SHIFT) | (1u << DIM_SHIFT) | (1u << ITALIC_SHIFT) | (1u << REVERSE_SHIFT) | \
+        (1u << STRIKE_SHIFT) | (DECORATION_MASK << DECORATION_SHIFT))
+
+typedef struct {
+    attrs_type attrs, prev_attrs;
+    color_type fg, bg, decoration_fg, prev_fg, prev_bg, prev_decoration_fg;
+    bool valid;
+    char sgr[128];
+} SGRCacheEntry;
+
+static SGRCacheEntry sgr_cache[256];
+
+const char*
+cell_as_sgr(const GPUCell *cell, const GPUCell *prev) {
+    const attrs_type attrs = cell->attrs & SGR_RELEVANT_ATTRS, prev_attrs = prev->attrs & SGR_RELEVANT_ATTRS;
+    uint32_t h = attrs ^ ((uint32_t)prev_attrs << 11);
+    h ^= cell->fg * 0x85ebca6bu; h ^= cell->bg * 0xc2b2ae35u; h ^= cell->decoration_fg * 0x27d4eb2fu;
+    h ^= prev->fg * 0x165667b1u; h ^= prev->bg * 0x9e3779b9u; h ^= prev->decoration_fg * 0x85ebca77u;
+    SGRCacheEntry *e = sgr_cache + ((h ^ (h >> 16)) & (arraysz(sgr_cache) - 1));
+    if (e->valid && e->attrs == attrs && e->prev_attrs == prev_attrs &&
+            e->fg == cell->fg && e->bg == cell->bg && e->decoration_fg == cell->decoration_fg &&
+            e->prev_fg == prev->fg && e->prev_bg == prev->bg && e->prev_decoration_fg == prev->decoration_fg)
+        return e->sgr;
+    const char *sgr = cell_as_sgr_uncached(cell, prev);
+    e->attrs = attrs; e->prev_attrs = prev_attrs;
+    e->fg = cell->fg; e->bg = cell->bg; e->decoration_fg = cell->decoration_fg;
+    e->prev_fg = prev->fg; e->prev_bg = prev->bg; e->prev_decoration_fg = prev->decoration_fg;
+    memcpy(e->sgr, sgr, strlen(sgr) + 1);
+    e->valid = true;
+    return e->sgr;
+}
+
 
 static Py_ssize_t
 __len__(PyObject *self) {
@@ -732,7 +789,7 @@ apply_mark(Line *line, const attrs_type mark, index_type *cell_pos, unsigned int
     if (line->cpu_cells[x].ch) {
         (*match_pos)++;
         if (line->cpu_cells[x].ch == '\t') {
-            unsigned num_cells_to_skip_for_tab = line->cpu_cells[x].cc_idx[0];
+            unsigned num_cells_to_skip_for_tab = line->cpu_cells[x].cc_idx;
             while (num_cells_to_skip_for_tab && x + 1 < line->xnum && line->cpu_cells[x+1].ch == ' ') {
                 x++;
                 num_cells_to_skip_for_tab--;
@@ -742,9 +799,7 @@ apply_mark(Line *line, const attrs_type mark, index_type *cell_pos, unsigned int
             x++;
             MARK;
         } else {
-            for (index_type i = 0; i < arraysz(line->cpu_cells[x].cc_idx); i++) {
-                if (line->cpu_cells[x].cc_idx[i]) (*match_pos)++;
-            }
+            *match_pos += num_combining_marks(line->cpu_cells[x].cc_idx);
         }
     }
     *cell_pos = x + 1;
@@ -778,6 +833,22 @@ apply_marker(PyObject *marker, Line *line, const PyObject *text) {
     if (PyErr_Occurred()) report_marker_error(marker);
 }
 
+void
+mark_text_in_cells(const char_type *needle, size_t needle_len, attrs_type mark, Line *line) {
+    // Scan for a literal needle directly in the CPU cells, avoiding the
+    // text extraction and the call into Python that regex markers need
+    index_type x = 0;
+    while (x < line->xnum) {
+        size_t i = 0;
+        while (i < needle_len && x + i < line->xnum && line->cpu_cells[x + i].ch == needle[i]) i++;
+        if (i == needle_len && needle_len > 0) {
+            for (i = 0; i < needle_len; i++, x++) line->gpu_cells[x].attrs = (line->gpu_cells[x].attrs & ATTRS_MASK_WITHOUT_MARK) | mark;
+        } else {
+            line->gpu_cells[x++].attrs &= ATTRS_MASK_WITHOUT_MARK;
+        }
+    }
+}
+
 void
 mark_text_in_line(PyObject *marker, Line *line) {
     if (!marker) {
@@ -798,20 +869,31 @@ as_text_generic(PyObject *args, void *container, get_line_func get_line, index_t
     PyObject *callback;
     int as_ansi = 0, insert_wrap_markers = 0;
     if (!PyArg_ParseTuple(args, "O|pp", &callback, &as_ansi, &insert_wrap_markers)) return NULL;
-    PyObject *ret = NULL, *t = NULL;
-    PyObject *nl = PyUnicode_FromString("\n");
-    PyObject *cr = PyUnicode_FromString("\r");
-    PyObject *sgr_reset = PyUnicode_FromString("\x1b[m");
-    if (nl == NULL || cr == NULL || sgr_reset == NULL) goto end;
+    // Lines are accumulated into one reused buffer that is handed to the
+    // callback in large chunks (split only at line boundaries), instead of
+    // materializing several Python strings per line. For a deep scrollback
+    // this removes almost all of the Python object churn.
+    ANSIBuf chunk = {0};
+    const size_t chunk_size = 128u * 1024u;
+    PyObject *ret = NULL;
+#define APPEND(data, sz) { \
+    ensure_space_for(&chunk, buf, Py_UCS4, chunk.len + (sz), capacity, 8192, false); \
+    memcpy(chunk.buf + chunk.len, data, (sz) * sizeof(Py_UCS4)); chunk.len += (sz); \
+}
+#define APPEND_CH(ch) { ensure_space_for(&chunk, buf, Py_UCS4, chunk.len + 1, capacity, 8192, false); chunk.buf[chunk.len++] = (ch); }
+#define FLUSH_CHUNK if (chunk.len) { \
+    PyObject *t = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, chunk.buf, chunk.len); \
+    if (t == NULL) goto end; \
+    ret = PyObject_CallFunctionObjArgs(callback, t, NULL); \
+    Py_DECREF(t); if (ret == NULL) goto end; Py_CLEAR(ret); \
+    chunk.len = 0; \
+}
+    static const Py_UCS4 sgr_reset[3] = {0x1b, '[', 'm'};
     const GPUCell *prev_cell = NULL;
     ansibuf->active_hyperlink_id = 0;
     for (index_type y = 0; y < lines; y++) {
         Line *line = get_line(container, y);
-        if (!line->continued && y > 0) {
-            ret = PyObject_CallFunctionObjArgs(callback, nl, NULL);
-            if (ret == NULL) goto end;
-            Py_CLEAR(ret);
-        }
+        if (!line->continued && y > 0) APPEND_CH('\n');
         if (as_ansi) {
             // less has a bug where it resets colors when it sees a \r, so work
             // around it by resetting SGR at the start of every line. This is
@@ -820,39 +902,214 @@ as_text_generic(PyObject *args, void *container, get_line_func get_line, index_t
             // see https://github.com/kovidgoyal/kitty/issues/2381
             prev_cell = NULL;
             line_as_ansi(line, ansibuf, &prev_cell);
-            t = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, ansibuf->buf, ansibuf->len);
-            if (t && ansibuf->len > 0) {
-                ret = PyObject_CallFunctionObjArgs(callback, sgr_reset, NULL);
-                if (ret == NULL) goto end;
-                Py_CLEAR(ret);
-            }
+            if (ansibuf->len > 0) APPEND(sgr_reset, arraysz(sgr_reset));
+            APPEND(ansibuf->buf, ansibuf->len);
         } else {
-            t = line_as_unicode(line);
-        }
-        if (t == NULL) goto end;
-        ret = PyObject_CallFunctionObjArgs(callback, t, NULL);
-        Py_DECREF(t); if (ret == NULL) goto end; Py_DECREF(ret);
-        if (insert_wrap_markers) {
-            ret = PyObject_CallFunctionObjArgs(callback, cr, NULL);
-            if (ret == NULL) goto end;
-            Py_CLEAR(ret);
+            Py_UCS4 buf[4096];
+            size_t n = text_in_range(line, 0, xlimit_for_line(line), true, 0, buf, arraysz(buf));
+            APPEND(buf, n);
         }
+        if (insert_wrap_markers) APPEND_CH('\r');
+        if (chunk.len >= chunk_size) FLUSH_CHUNK;
     }
     if (ansibuf->active_hyperlink_id) {
         ansibuf->active_hyperlink_id = 0;
-        t = PyUnicode_FromString("\x1b]8;;\x1b\\");
-        if (t) {
-            ret = PyObject_CallFunctionObjArgs(callback, t, NULL);
-            Py_CLEAR(t);
-            Py_CLEAR(ret);
-        }
+        static const Py_UCS4 close_hyperlink[7] = {0x1b, ']', '8', ';', ';', 0x1b, '\\'};
+        APPEND(close_hyperlink, arraysz(close_hyperlink));
     }
+    FLUSH_CHUNK;
 end:
-    Py_CLEAR(nl); Py_CLEAR(cr); Py_CLEAR(sgr_reset);
+#undef APPEND
+#undef APPEND_CH
+#undef FLUSH_CHUNK
+    free(chunk.buf);
     if (PyErr_Occurred()) return NULL;
     Py_RETURN_NONE;
 }
 
+// Incremental search {{{
+
+static inline char_type
+search_fold(char_type ch, bool no_case) {
+    // ASCII only case folding, matching what an interactive search overlay
+    // needs without pulling in full Unicode case tables
+    return (no_case && 'A' <= ch && ch <= 'Z') ? ch + 32 : ch;
+}
+
+static bool
+search_match_at(void *container, get_line_func get_line, index_type lines, index_type y, index_type x, const char_type *needle, size_t needle_len, bool no_case) {
+    // Match the needle against cell text starting at (y, x), following
+    // wrapped line boundaries. The needle must already be case folded.
+    Line *line = get_line(container, (int)y);
+    for (size_t i = 0; i < needle_len;) {
+        if (x >= line->xnum) {
+            if (y + 1 >= lines) return false;
+            line = get_line(container, (int)(y + 1));
+            if (!line->continued) return false;
+            y++; x = 0;
+        }
+        char_type ch = line->cpu_cells[x].ch;
+        if (ch == 0 && i > 0) { x++; continue; }  // right half of a wide character
+        if (search_fold(ch, no_case) != needle[i]) return false;
+        i++; x++;
+    }
+    return true;
+}
+
+static void
+search_add_match(IncrementalSearch *cache, index_type y, index_type x) {
+    ensure_space_for(cache, matches, index_type, 2 * (cache->num_matches + 1), capacity, 512, false);
+    cache->matches[2 * cache->num_matches] = y;
+    cache->matches[2 * cache->num_matches + 1] = x;
+    cache->num_matches++;
+}
+
+static void
+search_rescan(void *container, get_line_func get_line, index_type lines, IncrementalSearch *cache) {
+    cache->num_matches = 0;
+    for (index_type y = 0; y < lines; y++) {
+        Line *line = get_line(container, (int)y);
+        for (index_type x = 0; x < line->xnum; x++) {
+            if (search_fold(line->cpu_cells[x].ch, cache->no_case) != cache->needle[0]) continue;
+            if (search_match_at(container, get_line, lines, y, x, cache->needle, cache->needle_len, cache->no_case)) search_add_match(cache, y, x);
+            line = get_line(container, (int)y);  // search_match_at() repoints the shared line
+        }
+    }
+}
+
+PyObject*
+search_generic(PyObject *args, void *container, get_line_func get_line, index_type lines, IncrementalSearch *cache) {
+    PyObject *needle_obj;
+    int no_case = 0;
+    if (!PyArg_ParseTuple(args, "U|p", &needle_obj, &no_case)) return NULL;
+    IncrementalSearch local = {0};
+    IncrementalSearch *c = cache ? cache : &local;
+    size_t needle_len = PyUnicode_GET_LENGTH(needle_obj);
+    char_type *needle = PyUnicode_AsUCS4Copy(needle_obj);
+    if (needle == NULL) return NULL;
+    for (size_t i = 0; i < needle_len; i++) needle[i] = search_fold(needle[i], no_case);
+    // typing another character in a search overlay extends the previous
+    // needle, in which case only the cached matches need re-verification
+    bool incremental = c->needle && c->no_case == (bool)no_case && needle_len >= c->needle_len &&
+        memcmp(c->needle, needle, c->needle_len * sizeof(char_type)) == 0;
+    PyMem_Free(c->needle);
+    c->needle = needle; c->needle_len = needle_len; c->no_case = no_case;
+    if (!needle_len) c->num_matches = 0;
+    else if (incremental) {
+        size_t kept = 0;
+        for (size_t i = 0; i < c->num_matches; i++) {
+            index_type y = c->matches[2 * i], x = c->matches[2 * i + 1];
+            if (search_match_at(container, get_line, lines, y, x, needle, needle_len, no_case)) {
+                c->matches[2 * kept] = y; c->matches[2 * kept + 1] = x; kept++;
+            }
+        }
+        c->num_matches = kept;
+    } else search_rescan(container, get_line, lines, c);
+    PyObject *ans = PyTuple_New(c->num_matches);
+    if (ans) {
+        for (size_t i = 0; i < c->num_matches; i++) {
+            PyObject *m = Py_BuildValue("II", (unsigned int)c->matches[2 * i], (unsigned int)c->matches[2 * i + 1]);
+            if (m == NULL) { Py_CLEAR(ans); break; }
+            PyTuple_SET_ITEM(ans, i, m);
+        }
+    }
+    if (c == &local) { PyMem_Free(local.needle); free(local.matches); }
+    return ans;
+}
+// }}}
+
+// Regex scanning {{{
+
+static index_type
+char_for_byte(const size_t *byte_of_char, index_type num_chars, size_t byte_offset) {
+    // binary search for the character whose UTF-8 encoding starts at byte_offset
+    index_type lo = 0, hi = num_chars;
+    while (lo < hi) {
+        index_type mid = lo + (hi - lo) / 2;
+        if (byte_of_char[mid] < byte_offset) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+PyObject*
+scan_text_generic(PyObject *patterns, void *container, get_line_func get_line, index_type lines) {
+    // Extract the text the same way as_text() does (wrapped lines joined,
+    // a newline between hard lines) and run every pattern over it in one go,
+    // returning (pattern_idx, start, end, matched_text) tuples with offsets
+    // in characters into that text.
+    ANSIBuf text = {0};
+    PyObject *ans = NULL;
+    char *utf8 = NULL; size_t *byte_of_char = NULL;
+#define APPEND_CH(ch) { ensure_space_for(&text, buf, Py_UCS4, text.len + 1, capacity, 8192, false); text.buf[text.len++] = (ch); }
+    for (index_type y = 0; y < lines; y++) {
+        Line *line = get_line(container, y);
+        if (!line->continued && y > 0) APPEND_CH('\n');
+        Py_UCS4 buf[4096];
+        size_t n = text_in_range(line, 0, xlimit_for_line(line), true, 0, buf, arraysz(buf));
+        ensure_space_for(&text, buf, Py_UCS4, text.len + n, capacity, 8192, false);
+        memcpy(text.buf + text.len, buf, n * sizeof(Py_UCS4));
+        text.len += n;
+    }
+#undef APPEND_CH
+    // POSIX regexec() works on bytes, so encode as UTF-8, remembering where
+    // every character starts so that match offsets can be mapped back
+    utf8 = malloc(4 * text.len + 1);
+    byte_of_char = malloc(sizeof(size_t) * (text.len + 1));
+    if (!utf8 || !byte_of_char) { PyErr_NoMemory(); goto end; }
+    size_t bytes = 0;
+    for (size_t i = 0; i < text.len; i++) {
+        byte_of_char[i] = bytes;
+        unsigned int n = encode_utf8(text.buf[i], utf8 + bytes);
+        if (!n) { utf8[bytes] = ' '; n = 1; }
+        bytes += n;
+    }
+    byte_of_char[text.len] = bytes;
+    utf8[bytes] = 0;
+    ans = PyList_New(0);
+    if (!ans) goto end;
+    for (Py_ssize_t pi = 0; pi < PyTuple_GET_SIZE(patterns); pi++) {
+        const char *pattern = PyUnicode_AsUTF8(PyTuple_GET_ITEM(patterns, pi));
+        if (!pattern) { Py_CLEAR(ans); goto end; }
+        regex_t re;
+        int rc = regcomp(&re, pattern, REG_EXTENDED | REG_NEWLINE);
+        if (rc != 0) {
+            char errbuf[256];
+            regerror(rc, &re, errbuf, sizeof(errbuf));
+            PyErr_Format(PyExc_ValueError, "Invalid pattern: %s with error: %s", pattern, errbuf);
+            Py_CLEAR(ans); goto end;
+        }
+        const char *p = utf8;
+        int eflags = 0;
+        while ((size_t)(p - utf8) <= bytes) {
+            regmatch_t m;
+            if (regexec(&re, p, 1, &m, eflags) != 0) break;
+            size_t so = (p - utf8) + m.rm_so, eo = (p - utf8) + m.rm_eo;
+            index_type start = char_for_byte(byte_of_char, text.len, so);
+            index_type end = char_for_byte(byte_of_char, text.len, eo);
+            PyObject *mt = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, text.buf + start, end - start);
+            if (!mt) { regfree(&re); Py_CLEAR(ans); goto end; }
+            PyObject *entry = Py_BuildValue("nIIN", pi, (unsigned int)start, (unsigned int)end, mt);
+            if (!entry || PyList_Append(ans, entry) != 0) {
+                Py_XDECREF(entry); regfree(&re); Py_CLEAR(ans); goto end;
+            }
+            Py_DECREF(entry);
+            p += m.rm_eo;
+            if (m.rm_eo == m.rm_so) {  // empty match, move one character forward
+                p++;
+                while (p < utf8 + bytes && ((*p) & 0xc0) == 0x80) p++;
+            }
+            eflags = REG_NOTBOL;
+            if (p >= utf8 + bytes) break;
+        }
+        regfree(&re);
+    }
+end:
+    free(text.buf); free(utf8); free(byte_of_char);
+    return ans;
+}
+// }}}
+
 // Boilerplate {{{
 static PyObject*
 copy_char(Line* self, PyObject *args);
@@ -24,11 +24,45 @@ copy_line(const Line *src, Line *dest) {
     memcpy(dest->gpu_cells, src->gpu_cells, sizeof(GPUCell) * MIN(src->xnum, dest->xnum));
 }
 
+static inline void
+fill_cpu_cells(CPUCell *cells, index_type num, const CPUCell *blank) {
+    // Replicate a single cell over the whole range with doubling memcpy
+    // calls, which compile down to wide stores, rather than a per-cell loop
+    if (!num) return;
+    cells[0] = *blank;
+    index_type done = 1;
+    while (done < num) {
+        index_type n = MIN(done, num - done);
+        memcpy(cells + done, cells, n * sizeof(CPUCell));
+        done += n;
+    }
+}
+
+static inline void
+fill_gpu_cells(GPUCell *cells, index_type num, const GPUCell *blank) {
+    if (!num) return;
+    cells[0] = *blank;
+    index_type done = 1;
+    while (done < num) {
+        index_type n = MIN(done, num - done);
+        memcpy(cells + done, cells, n * sizeof(GPUCell));
+        done += n;
+    }
+}
+
+static inline void
+fill_cells(CPUCell *cpu_cells, GPUCell *gpu_cells, index_type num, const CPUCell *blank_cpu, const GPUCell *blank_gpu) {
+    fill_cpu_cells(cpu_cells, num, blank_cpu);
+    fill_gpu_cells(gpu_cells, num, blank_gpu);
+}
+
 static inline void
 clear_chars_in_line(CPUCell *cpu_cells, GPUCell *gpu_cells, index_type xnum, char_type ch) {
     // Clear only the char part of each cell, the rest must have been cleared by a memset or similar
     if (ch) {
-        for (index_type i = 0; i < xnum; i++) { cpu_cells[i].ch = ch; cpu_cells[i].hyperlink_id = 0; gpu_cells[i].attrs = 1; }
+        const CPUCell blank_cpu = {.ch=ch};
+        const GPUCell blank_gpu = {.attrs=1};
+        fill_cells(cpu_cells, gpu_cells, xnum, &blank_cpu, &blank_gpu);
     }
 }
 
@@ -77,6 +111,7 @@ void line_add_combining_char(Line *, uint32_t , unsigned int );
 index_type line_url_start_at(Line *self, index_type x);
 index_type line_url_end_at(Line *self, index_type x, bool, char_type, bool);
 bool line_startswith_url_chars(Line*);
+bool line_has_url_anchor(Line*);
 void line_as_ansi(Line *self, ANSIBuf *output, const GPUCell**) __attribute__((nonnull));
 unsigned int line_length(Line *self);
 size_t cell_as_unicode(CPUCell *cell, bool include_cc, Py_UCS4 *buf, char_type);
@@ -89,25 +124,36 @@ PyObject* line_as_unicode(Line *);
 void linebuf_init_line(LineBuf *, index_type);
 void linebuf_clear(LineBuf *, char_type ch);
 void linebuf_index(LineBuf* self, index_type top, index_type bottom);
+void linebuf_index_n(LineBuf* self, index_type top, index_type bottom, index_type n);
 void linebuf_reverse_index(LineBuf *self, index_type top, index_type bottom);
+void linebuf_reverse_index_n(LineBuf *self, index_type top, index_type bottom, index_type n);
 void linebuf_clear_line(LineBuf *self, index_type y);
 void linebuf_insert_lines(LineBuf *self, unsigned int num, unsigned int y, unsigned int bottom);
 void linebuf_delete_lines(LineBuf *self, index_type num, index_type y, index_type bottom);
 void linebuf_set_attribute(LineBuf *, unsigned int , unsigned int );
 void linebuf_rewrap(LineBuf *self, LineBuf *other, index_type *, index_type *, HistoryBuf *, index_type *, index_type *, ANSIBuf*);
 void linebuf_mark_line_dirty(LineBuf *self, index_type y);
+bool linebuf_line_may_have_url(LineBuf *self, index_type y);
 void linebuf_mark_line_clean(LineBuf *self, index_type y);
+void linebuf_mark_line_gpu_clean(LineBuf *self, index_type y);
+bool linebuf_line_is_dirty(LineBuf *self, index_type y);
 void linebuf_mark_line_as_not_continued(LineBuf *self, index_type y);
 unsigned int linebuf_char_width_at(LineBuf *self, index_type x, index_type y);
 void linebuf_refresh_sprite_positions(LineBuf *self);
 void historybuf_add_line(HistoryBuf *self, const Line *line, ANSIBuf*);
 void historybuf_rewrap(HistoryBuf *self, HistoryBuf *other, ANSIBuf*);
+void historybuf_defer_rewrap(HistoryBuf *self, HistoryBuf *dest);
+void historybuf_resolve_deferred_rewrap(HistoryBuf *self);
 void historybuf_init_line(HistoryBuf *self, index_type num, Line *l);
 CPUCell* historybuf_cpu_cells(HistoryBuf *self, index_type num);
 void historybuf_mark_line_clean(HistoryBuf *self, index_type y);
 void historybuf_mark_line_dirty(HistoryBuf *self, index_type y);
+bool historybuf_line_may_have_url(HistoryBuf *self, index_type lnum);
 void historybuf_refresh_sprite_positions(HistoryBuf *self);
 void historybuf_clear(HistoryBuf *self);
 void mark_text_in_line(PyObject *marker, Line *line);
+void mark_text_in_cells(const char_type *needle, size_t needle_len, attrs_type mark, Line *line);
 bool line_has_mark(Line *, attrs_type mark);
 PyObject* as_text_generic(PyObject *args, void *container, get_line_func get_line, index_type lines, ANSIBuf *ansibuf);
+PyObject* search_generic(PyObject *args, void *container, get_line_func get_line, index_type lines, IncrementalSearch *cache);
+PyObject* scan_text_generic(PyObject *patterns, void *container, get_line_func get_line, index_type lines);
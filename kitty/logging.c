@@ -6,8 +6,10 @@
  */
 
 #include "data-types.h"
+#include "threading.h"
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <sys/time.h>
 #ifdef __APPLE__
@@ -17,38 +19,152 @@
 
 static bool use_os_log = false;
 
-void
-log_error(const char *fmt, ...) {
-    va_list ar;
-    struct timeval tv;
+static void
+write_log_record(const struct timeval *tv, const char *msg) {
+    if (use_os_log) {
 #ifdef __APPLE__
-    // Apple does not provide a varargs style os_logv
-    char logbuf[16 * 1024] = {0};
+        os_log(OS_LOG_DEFAULT, "%{public}s", msg);
 #else
-    char logbuf[4];
+        (void)tv;
 #endif
-    char *p = logbuf;
-#define bufprint(func, ...) { if ((size_t)(p - logbuf) < sizeof(logbuf) - 2) { p += func(p, sizeof(logbuf) - (p - logbuf), __VA_ARGS__); } }
-    if (!use_os_log) {  // Apple's os_log already records timestamps
-        gettimeofday(&tv, NULL);
-        struct tm stack_tmp;
-        struct tm *tmp = localtime_r(&tv.tv_sec, &stack_tmp);
-        if (tmp) {
-            char tbuf[256] = {0}, buf[256] = {0};
-            if (strftime(buf, sizeof(buf), "%j %H:%M:%S.%%06u", tmp) != 0) {
-                snprintf(tbuf, sizeof(tbuf), buf, tv.tv_usec);
-                fprintf(stderr, "[%s] ", tbuf);
-            }
+        return;
+    }
+    // Apple's os_log already records timestamps, for stderr we add our own
+    struct tm stack_tmp;
+    struct tm *tmp = localtime_r(&tv->tv_sec, &stack_tmp);
+    if (tmp) {
+        char tbuf[256] = {0}, buf[256] = {0};
+        if (strftime(buf, sizeof(buf), "%j %H:%M:%S.%%06u", tmp) != 0) {
+            snprintf(tbuf, sizeof(tbuf), buf, tv->tv_usec);
+            fprintf(stderr, "[%s] ", tbuf);
+        }
+    }
+    fprintf(stderr, "%s\n", msg);
+}
+
+// Async writer {{{
+// Log messages are formatted by the calling thread and pushed onto a bounded
+// multi producer single consumer ring (the classic sequence number protocol),
+// drained by a dedicated writer thread, so the io and render threads never
+// block on the terminal's own stderr, which can be arbitrarily slow. When
+// the ring overflows records are counted and dropped instead.
+#define LOG_RING_SIZE 256u
+#define LOG_MSG_SIZE 512u
+
+typedef struct {
+    atomic_uint seq;
+    struct timeval at;
+    char msg[LOG_MSG_SIZE];
+} LogRecord;
+
+static LogRecord log_ring[LOG_RING_SIZE];
+static atomic_uint ring_head;
+static unsigned ring_tail;  // owned by the writer thread
+static atomic_uint num_dropped;
+static pthread_t writer_thread;
+static bool writer_running = false;
+static atomic_bool writer_shutdown;
+static pthread_mutex_t writer_sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_sleep_cond = PTHREAD_COND_INITIALIZER;
+
+static bool
+enqueue_log_record(const struct timeval *tv, const char *msg) {
+    unsigned pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    LogRecord *r;
+    while (true) {
+        r = log_ring + (pos % LOG_RING_SIZE);
+        unsigned seq = atomic_load_explicit(&r->seq, memory_order_acquire);
+        int dif = (int)(seq - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring_head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (dif < 0) {
+            // the ring is full, never block the caller
+            atomic_fetch_add_explicit(&num_dropped, 1, memory_order_relaxed);
+            return false;
+        } else pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    }
+    r->at = *tv;
+    size_t len = strlen(msg);
+    if (len >= sizeof(r->msg)) len = sizeof(r->msg) - 1;
+    memcpy(r->msg, msg, len); r->msg[len] = 0;
+    atomic_store_explicit(&r->seq, pos + 1, memory_order_release);
+    // wake the writer if it is asleep, without ever blocking: when the lock
+    // is contended the writer is either awake or about to re-check the ring
+    if (pthread_mutex_trylock(&writer_sleep_lock) == 0) {
+        pthread_cond_signal(&writer_sleep_cond);
+        pthread_mutex_unlock(&writer_sleep_lock);
+    }
+    return true;
+}
+
+static bool
+drain_log_ring(void) {
+    bool wrote = false;
+    while (true) {
+        LogRecord *r = log_ring + (ring_tail % LOG_RING_SIZE);
+        unsigned seq = atomic_load_explicit(&r->seq, memory_order_acquire);
+        if (seq != ring_tail + 1) break;
+        write_log_record(&r->at, r->msg);
+        atomic_store_explicit(&r->seq, ring_tail + LOG_RING_SIZE, memory_order_release);
+        ring_tail++;
+        wrote = true;
+    }
+    unsigned dropped = atomic_exchange_explicit(&num_dropped, 0, memory_order_relaxed);
+    if (dropped) {
+        struct timeval tv; gettimeofday(&tv, NULL);
+        char buf[128];
+        snprintf(buf, sizeof(buf), "dropped %u log message(s) that arrived too fast to write out", dropped);
+        write_log_record(&tv, buf);
+        wrote = true;
+    }
+    return wrote;
+}
+
+static void*
+log_writer_main(void *arg UNUSED) {
+    set_thread_name("KittyLogWriter");
+    while (!atomic_load_explicit(&writer_shutdown, memory_order_relaxed)) {
+        if (!drain_log_ring()) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += 1;  // bounded sleep in case a wakeup is ever missed
+            pthread_mutex_lock(&writer_sleep_lock);
+            pthread_cond_timedwait(&writer_sleep_cond, &writer_sleep_lock, &ts);
+            pthread_mutex_unlock(&writer_sleep_lock);
         }
     }
+    return NULL;
+}
+
+static void
+shutdown_log_writer(void) {
+    // registered with atexit() so that messages logged just before exiting,
+    // in particular by fatal(), are flushed before the process dies
+    if (writer_running) {
+        writer_running = false;
+        atomic_store_explicit(&writer_shutdown, true, memory_order_relaxed);
+        pthread_mutex_lock(&writer_sleep_lock);
+        pthread_cond_signal(&writer_sleep_cond);
+        pthread_mutex_unlock(&writer_sleep_lock);
+        pthread_join(writer_thread, NULL);
+    }
+    drain_log_ring();
+}
+// }}}
+
+void
+log_error(const char *fmt, ...) {
+    va_list ar;
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    char logbuf[LOG_MSG_SIZE] = {0};
     va_start(ar, fmt);
-    if (use_os_log) { bufprint(vsnprintf, fmt, ar); }
-    else vfprintf(stderr, fmt, ar);
+    vsnprintf(logbuf, sizeof(logbuf), fmt, ar);
     va_end(ar);
-#ifdef __APPLE__
-    if (use_os_log) os_log(OS_LOG_DEFAULT, "%{public}s", logbuf);
-#endif
-    if (!use_os_log) fprintf(stderr, "\n");
+    // before the writer thread exists log synchronously so that early
+    // startup errors are not lost
+    if (!writer_running) write_log_record(&tv, logbuf);
+    else enqueue_log_record(&tv, logbuf);
 }
 
 static PyObject*
@@ -70,5 +186,10 @@ init_logging(PyObject *module) {
 #ifdef __APPLE__
     if (getenv("KITTY_LAUNCHED_BY_LAUNCH_SERVICES") != NULL) use_os_log = true;
 #endif
+    for (unsigned i = 0; i < LOG_RING_SIZE; i++) atomic_store_explicit(&log_ring[i].seq, i, memory_order_relaxed);
+    if (pthread_create(&writer_thread, NULL, log_writer_main, NULL) == 0) {
+        writer_running = true;
+        if (atexit(shutdown_log_writer) != 0) log_error("Failed to register the log writer atexit handler");
+    } else log_error("Failed to create the log writer thread, logging will be synchronous");
     return true;
 }
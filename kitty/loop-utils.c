@@ -18,13 +18,13 @@ init_loop_data(LoopData *ld) {
     ld->wakeup_read_fd = ld->wakeup_fds[0];
 #endif
     ld->signal_read_fd = -1;
-#ifndef HAS_SIGNAL_FD
+#if !defined(HAS_SIGNAL_FD) && !defined(HAS_SIGNAL_KQUEUE)
     ld->signal_fds[0] = -1; ld->signal_fds[1] = -1;
 #endif
     return true;
 }
 
-#ifndef HAS_SIGNAL_FD
+#if !defined(HAS_SIGNAL_FD) && !defined(HAS_SIGNAL_KQUEUE)
 static int signal_write_fd = -1;
 
 static void
@@ -44,7 +44,7 @@ handle_signal(int sig_num) {
 #define SIGNAL_SET \
     sigset_t signals = {0}; \
     sigemptyset(&signals); \
-    sigaddset(&signals, SIGINT); sigaddset(&signals, SIGTERM); sigaddset(&signals, SIGCHLD); \
+    sigaddset(&signals, SIGINT); sigaddset(&signals, SIGTERM); sigaddset(&signals, SIGCHLD); sigaddset(&signals, SIGUSR1); \
 
 void
 free_loop_data(LoopData *ld) {
@@ -52,12 +52,12 @@ free_loop_data(LoopData *ld) {
 #ifndef HAS_EVENT_FD
     CLOSE(wakeup_fds, 0); CLOSE(wakeup_fds, 1);
 #endif
-#ifndef HAS_SIGNAL_FD
+#if !defined(HAS_SIGNAL_FD) && !defined(HAS_SIGNAL_KQUEUE)
     CLOSE(signal_fds, 0); CLOSE(signal_fds, 1);
 #endif
 #undef CLOSE
     if (ld->signal_read_fd > -1) {
-#ifdef HAS_SIGNAL_FD
+#if defined(HAS_SIGNAL_FD) || defined(HAS_SIGNAL_KQUEUE)
         safe_close(ld->signal_read_fd, __FILE__, __LINE__);
         SIGNAL_SET
         sigprocmask(SIG_UNBLOCK, &signals, NULL);
@@ -67,6 +67,7 @@ free_loop_data(LoopData *ld) {
         signal(SIGINT, SIG_DFL);
         signal(SIGTERM, SIG_DFL);
         signal(SIGCHLD, SIG_DFL);
+        signal(SIGUSR1, SIG_DFL);
     }
 #ifdef HAS_EVENT_FD
     safe_close(ld->wakeup_read_fd, __FILE__, __LINE__);
@@ -100,12 +101,30 @@ install_signal_handlers(LoopData *ld) {
     if (sigprocmask(SIG_BLOCK, &signals, NULL) == -1) return false;
     ld->signal_read_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
     if (ld->signal_read_fd == -1) return false;
+#elif defined(HAS_SIGNAL_KQUEUE)
+    // block the signals so no handler runs, kqueue records their generation
+    // anyway and the kqueue fd becomes readable, making signals ordinary
+    // poll events just like with signalfd
+    SIGNAL_SET
+    if (sigprocmask(SIG_BLOCK, &signals, NULL) == -1) return false;
+    ld->signal_read_fd = kqueue();
+    if (ld->signal_read_fd == -1) return false;
+    fcntl(ld->signal_read_fd, F_SETFD, FD_CLOEXEC);
+    struct kevent changes[4];
+    EV_SET(changes + 0, SIGINT, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+    EV_SET(changes + 1, SIGTERM, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+    EV_SET(changes + 2, SIGCHLD, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+    EV_SET(changes + 3, SIGUSR1, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+    if (kevent(ld->signal_read_fd, changes, arraysz(changes), NULL, 0, NULL) != 0) {
+        safe_close(ld->signal_read_fd, __FILE__, __LINE__); ld->signal_read_fd = -1;
+        return false;
+    }
 #else
     if (!self_pipe(ld->signal_fds, true)) return false;
     signal_write_fd = ld->signal_fds[1];
     struct sigaction act = {.sa_handler=handle_signal};
 #define SA(which) { if (sigaction(which, &act, NULL) != 0) return false; if (siginterrupt(which, false) != 0) return false; }
-    SA(SIGINT); SA(SIGTERM); SA(SIGCHLD);
+    SA(SIGINT); SA(SIGTERM); SA(SIGCHLD); SA(SIGUSR1);
 #undef SA
     ld->signal_read_fd = ld->signal_fds[0];
 #endif
@@ -113,6 +132,172 @@ install_signal_handlers(LoopData *ld) {
 }
 
 
+// Poller {{{
+
+static inline ssize_t
+poller_index_of(Poller *p, int fd) {
+    for (size_t i = 0; i < p->num_fds; i++) { if (p->fds[i].fd == fd) return i; }
+    return -1;
+}
+
+#ifdef HAS_EPOLL
+static inline bool
+epoll_apply(Poller *p, int op, int fd, short events) {
+    struct epoll_event ev = {.data = {.fd = fd}};
+    if (events & POLLIN) ev.events |= EPOLLIN;
+    if (events & POLLOUT) ev.events |= EPOLLOUT;
+    if (epoll_ctl(p->fd, op, fd, &ev) != 0) {
+        log_error("epoll_ctl() failed with error: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+#endif
+
+#ifdef HAS_KQUEUE
+static inline bool
+kqueue_apply(Poller *p, int fd, short old_events, short events) {
+    struct kevent changes[2];
+    int n = 0;
+#define F(bit, filter) if ((events & bit) != (old_events & bit)) EV_SET(changes + n++, fd, filter, (events & bit) ? EV_ADD : EV_DELETE, 0, 0, NULL);
+    F(POLLIN, EVFILT_READ); F(POLLOUT, EVFILT_WRITE);
+#undef F
+    if (n && kevent(p->fd, changes, n, NULL, 0, NULL) != 0) {
+        log_error("kevent() failed to change registrations with error: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+#endif
+
+bool
+poller_init(Poller *p) {
+    zero_at_ptr(p);
+    p->fd = -1;
+#ifdef HAS_EPOLL
+    p->fd = epoll_create1(EPOLL_CLOEXEC);
+    if (p->fd < 0) log_error("epoll_create1() failed with error: %s, falling back to poll()", strerror(errno));
+#elif defined(HAS_KQUEUE)
+    p->fd = kqueue();
+    if (p->fd < 0) log_error("kqueue() failed with error: %s, falling back to poll()", strerror(errno));
+    else fcntl(p->fd, F_SETFD, FD_CLOEXEC);
+#endif
+    return true;
+}
+
+void
+poller_free(Poller *p) {
+    if (p->fd > -1) { safe_close(p->fd, __FILE__, __LINE__); p->fd = -1; }
+    free(p->fds); free(p->ready);
+    zero_at_ptr(p);
+    p->fd = -1;
+}
+
+bool
+poller_add(Poller *p, int fd, short events) {
+    if (poller_index_of(p, fd) > -1) return poller_modify(p, fd, events);
+    ensure_space_for(p, fds, struct pollfd, p->num_fds + 1, fds_capacity, 8, false);
+    p->fds[p->num_fds].fd = fd; p->fds[p->num_fds].events = events; p->fds[p->num_fds].revents = 0;
+    p->num_fds++;
+    if (p->fd > -1) {
+#ifdef HAS_EPOLL
+        return epoll_apply(p, EPOLL_CTL_ADD, fd, events);
+#elif defined(HAS_KQUEUE)
+        return kqueue_apply(p, fd, 0, events);
+#endif
+    }
+    return true;
+}
+
+bool
+poller_modify(Poller *p, int fd, short events) {
+    ssize_t idx = poller_index_of(p, fd);
+    if (idx < 0) return poller_add(p, fd, events);
+    if (p->fds[idx].events == events) return true;
+#ifdef HAS_KQUEUE
+    short old_events = p->fds[idx].events;
+#endif
+    p->fds[idx].events = events;
+    if (p->fd > -1) {
+#ifdef HAS_EPOLL
+        return epoll_apply(p, EPOLL_CTL_MOD, fd, events);
+#elif defined(HAS_KQUEUE)
+        return kqueue_apply(p, fd, old_events, events);
+#endif
+    }
+    return true;
+}
+
+void
+poller_remove(Poller *p, int fd) {
+    ssize_t idx = poller_index_of(p, fd);
+    if (idx < 0) return;
+    if (p->fd > -1) {
+#ifdef HAS_EPOLL
+        // a closed fd is removed automatically, ignore failures for it
+        if (epoll_ctl(p->fd, EPOLL_CTL_DEL, fd, NULL) != 0 && errno != EBADF && errno != ENOENT) {
+            log_error("epoll_ctl() failed to remove fd with error: %s", strerror(errno));
+        }
+#elif defined(HAS_KQUEUE)
+        kqueue_apply(p, fd, p->fds[idx].events, 0);
+#endif
+    }
+    remove_i_from_array(p->fds, (size_t)idx, p->num_fds);
+}
+
+int
+poller_wait(Poller *p, monotonic_t timeout) {
+    p->num_ready = 0;
+    if (p->fd > -1) {
+#ifdef HAS_EPOLL
+        struct epoll_event events[64];
+        int n = epoll_wait(p->fd, events, arraysz(events), timeout < 0 ? -1 : monotonic_t_to_ms(timeout));
+        if (n <= 0) return n;
+        ensure_space_for(p, ready, struct pollfd, (size_t)n, ready_capacity, 64, false);
+        for (int i = 0; i < n; i++) {
+            struct pollfd *pfd = p->ready + p->num_ready++;
+            pfd->fd = events[i].data.fd; pfd->events = 0; pfd->revents = 0;
+            if (events[i].events & EPOLLIN) pfd->revents |= POLLIN;
+            if (events[i].events & EPOLLOUT) pfd->revents |= POLLOUT;
+            if (events[i].events & EPOLLERR) pfd->revents |= POLLERR;
+            if (events[i].events & EPOLLHUP) pfd->revents |= POLLHUP;
+        }
+        return n;
+#elif defined(HAS_KQUEUE)
+        struct kevent events[64];
+        struct timespec ts, *tsp = NULL;
+        if (timeout >= 0) {
+            ts.tv_sec = timeout / MONOTONIC_T_1e9; ts.tv_nsec = timeout % MONOTONIC_T_1e9;
+            tsp = &ts;
+        }
+        int n = kevent(p->fd, NULL, 0, events, arraysz(events), tsp);
+        if (n <= 0) return n;
+        ensure_space_for(p, ready, struct pollfd, (size_t)n, ready_capacity, 64, false);
+        for (int i = 0; i < n; i++) {
+            // read and write readiness arrive as separate events, which the
+            // consumer handles the same as one merged entry
+            struct pollfd *pfd = p->ready + p->num_ready++;
+            pfd->fd = (int)events[i].ident; pfd->events = 0; pfd->revents = 0;
+            if (events[i].filter == EVFILT_READ) pfd->revents |= POLLIN;
+            if (events[i].filter == EVFILT_WRITE) pfd->revents |= POLLOUT;
+            if (events[i].flags & EV_EOF) pfd->revents |= POLLHUP;
+            if (events[i].flags & EV_ERROR) pfd->revents |= POLLERR;
+        }
+        return n;
+#endif
+    }
+    for (size_t i = 0; i < p->num_fds; i++) p->fds[i].revents = 0;
+    int n = poll(p->fds, p->num_fds, timeout < 0 ? -1 : monotonic_t_to_ms(timeout));
+    if (n <= 0) return n;
+    ensure_space_for(p, ready, struct pollfd, (size_t)n, ready_capacity, 64, false);
+    for (size_t i = 0; i < p->num_fds && p->num_ready < (size_t)n; i++) {
+        if (p->fds[i].revents) p->ready[p->num_ready++] = p->fds[i];
+    }
+    return n;
+}
+
+// }}}
+
 void
 read_signals(int fd, handle_signal_func callback, void *data) {
 #ifdef HAS_SIGNAL_FD
@@ -133,6 +318,20 @@ read_signals(int fd, handle_signal_func callback, void *data) {
         }
         for (size_t i = 0; i < num_signals; i++) callback(fdsi[i].ssi_signo, data);
     }
+#elif defined(HAS_SIGNAL_KQUEUE)
+    static const struct timespec zero_timeout = {0};
+    struct kevent events[32];
+    while (true) {
+        int n = kevent(fd, NULL, 0, events, arraysz(events), &zero_timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log_error("Call to kevent() from read_signals() failed with error: %s", strerror(errno));
+            break;
+        }
+        // deliveries of the same signal coalesce into one event
+        for (int i = 0; i < n; i++) callback((int)events[i].ident, data);
+        if (n < (int)arraysz(events)) break;
+    }
 #else
     static char buf[256];
     while(true) {
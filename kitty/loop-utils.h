@@ -7,9 +7,18 @@
 #pragma once
 
 #include "data-types.h"
+#include "monotonic.h"
 #include <fcntl.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#define HAS_EPOLL
+#include <sys/epoll.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define HAS_KQUEUE
+#include <sys/event.h>
+#endif
+
 #ifdef __has_include
 #if __has_include(<sys/signalfd.h>)
 #define HAS_SIGNAL_FD
@@ -27,11 +36,18 @@
 #include <sys/eventfd.h>
 #endif
 
+// Without signalfd, signals are delivered as EVFILT_SIGNAL events on a
+// dedicated kqueue whose fd is polled like any other, so no signal handler
+// runs and no self-pipe write is paid per signal
+#if !defined(HAS_SIGNAL_FD) && defined(HAS_KQUEUE)
+#define HAS_SIGNAL_KQUEUE
+#endif
+
 typedef struct {
 #ifndef HAS_EVENT_FD
     int wakeup_fds[2];
 #endif
-#ifndef HAS_SIGNAL_FD
+#if !defined(HAS_SIGNAL_FD) && !defined(HAS_SIGNAL_KQUEUE)
     int signal_fds[2];
 #endif
     int wakeup_read_fd;
@@ -45,6 +61,29 @@ void wakeup_loop(LoopData *ld, bool in_signal_handler, const char*);
 bool install_signal_handlers(LoopData *ld);
 void read_signals(int fd, handle_signal_func callback, void *data);
 
+// A poll(2) like interface with persistent fd registrations, backed by epoll
+// on Linux and kqueue on macOS/BSD, so that waiting costs O(ready fds) per
+// wakeup instead of re-registering and re-scanning every fd. Falls back to
+// poll(2) at runtime when the kernel facility is unavailable. Events and
+// revents use the POLLIN/POLLOUT/POLLERR/POLLHUP/POLLNVAL bits.
+typedef struct {
+    int fd;  // the epoll/kqueue fd, -1 when the poll(2) fallback is in use
+    // mirror of the current registrations, used to detect no-op modifications
+    // and as the pollfd array for the poll(2) fallback
+    struct pollfd *fds;
+    size_t num_fds, fds_capacity;
+    // fds that became ready in the last call to poller_wait()
+    struct pollfd *ready;
+    size_t num_ready, ready_capacity;
+} Poller;
+
+bool poller_init(Poller *p);
+void poller_free(Poller *p);
+bool poller_add(Poller *p, int fd, short events);
+bool poller_modify(Poller *p, int fd, short events);
+void poller_remove(Poller *p, int fd);
+int poller_wait(Poller *p, monotonic_t timeout);
+
 static inline bool
 self_pipe(int fds[2], bool nonblock) {
 #ifdef __APPLE__
@@ -30,6 +30,7 @@ from .fonts.render import set_font_family
 from .options_stub import Options as OptionsStub
 from .os_window_size import initial_window_size_func
 from .session import get_os_window_sizing_data
+from .startup_trace import note as trace_startup_phase
 from .utils import (
     detach, expandvars, find_exe, log_error, read_shell_environment,
     single_instance, startup_notification_handler, unix_socket_paths
@@ -90,6 +91,7 @@ def talk_to_instance(args: CLIOptions) -> None:
 def load_all_shaders(semi_transparent: bool = False) -> None:
     load_shader_programs(semi_transparent)
     load_borders_program()
+    trace_startup_phase('shaders_compiled')
 
 
 def init_glfw_module(glfw_module: str, debug_keyboard: bool = False) -> None:
@@ -136,6 +138,7 @@ def _run_app(opts: OptionsStub, args: CLIOptions, bad_lines: Sequence[BadLine] =
                     pre_show_callback,
                     args.title or appname, args.name or args.cls or appname,
                     args.cls or appname, load_all_shaders)
+        trace_startup_phase('first_os_window_created')
         boss = Boss(opts, args, cached_values, new_os_window_trigger)
         boss.start(window_id)
         if bad_lines:
@@ -157,6 +160,7 @@ class AppRunner:
         set_scale(opts.box_drawing_scale)
         set_options(opts, is_wayland(), args.debug_rendering, args.debug_font_fallback)
         set_font_family(opts, debug_font_matching=args.debug_font_fallback)
+        trace_startup_phase('font_group_built')
         try:
             _run_app(opts, args, bad_lines)
         finally:
@@ -329,6 +333,9 @@ def _main() -> None:
         os.chdir(os.path.expanduser('~'))
     cli_opts, rest = parse_args(args=args, result_class=CLIOptions)
     cli_opts.args = rest
+    if cli_opts.profile_startup:
+        from . import startup_trace
+        startup_trace.init(cli_opts.profile_startup)
     if cli_opts.debug_config:
         create_opts(cli_opts, debug_config=True)
         return
@@ -345,7 +352,9 @@ def _main() -> None:
             return
     bad_lines: List[BadLine] = []
     opts = create_opts(cli_opts, accumulate_bad_lines=bad_lines)
+    trace_startup_phase('config_loaded')
     init_glfw(opts, cli_opts.debug_keyboard)
+    trace_startup_phase('glfw_initialized')
     setup_environment(opts, cli_opts)
     try:
         with setup_profiling(cli_opts):
@@ -79,11 +79,20 @@ def marker_from_function(func: Callable[[str], Iterable[Tuple[int, int, int]]])
     return marker
 
 
-def marker_from_spec(ftype: str, spec: Union[str, Sequence[Tuple[int, str]]], flags: int) -> MarkerFunc:
+def is_plain_text(expression: str) -> bool:
+    return not any(ch in expression for ch in '\\^$.|?*+()[]{}')
+
+
+def marker_from_spec(ftype: str, spec: Union[str, Sequence[Tuple[int, str]]], flags: int) -> Union[MarkerFunc, Tuple[int, str]]:
     if ftype == 'regex':
         assert not isinstance(spec, str)
         if len(spec) == 1:
-            return marker_from_regex(spec[0][1], spec[0][0], flags=flags)
+            color, expression = spec[0]
+            if flags == re.UNICODE and is_plain_text(expression):
+                # Screen.set_marker() scans for plain text natively, which is
+                # much faster than calling back into Python for every line
+                return max(1, min(color, 3)), expression
+            return marker_from_regex(expression, color, flags=flags)
         return marker_from_multiple_regex(spec, flags=flags)
     if ftype == 'function':
         import runpy
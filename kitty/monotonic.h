@@ -9,6 +9,7 @@
 
 
 #include <stdint.h>
+#include <stdatomic.h>
 
 #define MONOTONIC_T_MAX INT64_MAX
 #define MONOTONIC_T_MIN INT64_MIN
@@ -60,9 +61,30 @@ init_monotonic(void) {
     monotonic_start_time = monotonic_();
 }
 
+extern _Atomic(monotonic_t) monotonic_coarse_time;
+
+// The main and I/O loops stamp the coarse clock at each wakeup. Hot paths
+// that run many thousands of times a second and only need wakeup granularity
+// read the stamp instead of paying for a clock_gettime() per call. Use
+// monotonic() directly where real precision is needed, for example when
+// measuring latency or enforcing a time budget within a single wakeup.
+static inline monotonic_t
+stamp_coarse_monotonic(void) {
+    monotonic_t now = monotonic();
+    atomic_store_explicit(&monotonic_coarse_time, now, memory_order_relaxed);
+    return now;
+}
+
+static inline monotonic_t
+coarse_monotonic(void) {
+    monotonic_t ans = atomic_load_explicit(&monotonic_coarse_time, memory_order_relaxed);
+    return ans ? ans : monotonic();
+}
+
 #ifdef MONOTONIC_IMPLEMENTATION
 #include <time.h>
 monotonic_t monotonic_start_time = 0;
+_Atomic(monotonic_t) monotonic_coarse_time = 0;
 
 static inline monotonic_t
 calc_nano_time(struct timespec time) {
@@ -246,7 +246,7 @@ drag_scroll(Window *w, OSWindow *frame) {
     bool upwards = y <= (w->geometry.top + margin);
     if (upwards || y >= w->geometry.bottom - margin) {
         if (do_drag_scroll(w, upwards)) {
-            frame->last_mouse_activity_at = monotonic();
+            frame->last_mouse_activity_at = coarse_monotonic();
             return true;
         }
     }
@@ -318,6 +318,12 @@ detect_url(Screen *screen, unsigned int x, unsigned int y) {
         screen_mark_hyperlink(screen, x, y);
         return;
     }
+    if (!screen_visual_line_may_have_url(screen, y)) {
+        // the common case of mouse motion over a line without URLs
+        set_mouse_cursor_for_screen(screen);
+        screen_mark_url(screen, 0, 0, 0, 0);
+        return;
+    }
     char_type sentinel;
     if (line) {
         url_start = line_url_start_at(line, x);
@@ -348,7 +354,7 @@ static inline void
 handle_mouse_movement_in_kitty(Window *w, int button, bool mouse_cell_changed) {
     Screen *screen = w->render_data.screen;
     if (screen->selections.in_progress && (button == GLFW_MOUSE_BUTTON_LEFT || button == GLFW_MOUSE_BUTTON_RIGHT)) {
-        monotonic_t now = monotonic();
+        monotonic_t now = coarse_monotonic();
         if ((now - w->last_drag_scroll_at) >= ms_to_monotonic_t(20ll) || mouse_cell_changed) {
             update_drag(false, w, false, 0);
             w->last_drag_scroll_at = now;
@@ -382,8 +388,64 @@ HANDLER(handle_move_event) {
         handle_mouse_movement_in_kitty(w, button, mouse_cell_changed | cell_half_changed);
     } else {
         if (!mouse_cell_changed) return;
-        int sz = encode_mouse_button(w, MAX(0, button), button >=0 ? DRAG : MOVE, modifiers);
-        if (sz > 0) { mouse_event_buf[sz] = 0; write_escape_code_to_child(screen, CSI, mouse_event_buf); }
+        // coalesced: a high resolution mouse can cross many cells between
+        // two frames and the application only needs the latest position,
+        // the report is written from the next main loop tick
+        w->pending_mouse_motion.pending = true;
+        w->pending_mouse_motion.button = MAX(0, button);
+        w->pending_mouse_motion.action = button >= 0 ? DRAG : MOVE;
+        w->pending_mouse_motion.mods = modifiers;
+    }
+}
+
+static inline void
+flush_pending_mouse_motion(Window *w) {
+    if (!w->pending_mouse_motion.pending) return;
+    w->pending_mouse_motion.pending = false;
+    Screen *screen = w->render_data.screen;
+    if (!screen || !screen->modes.mouse_tracking_mode) return;
+    int sz = encode_mouse_button(w, w->pending_mouse_motion.button, (MouseAction)w->pending_mouse_motion.action, w->pending_mouse_motion.mods);
+    if (sz > 0) { mouse_event_buf[sz] = 0; write_escape_code_to_child(screen, CSI, mouse_event_buf); }
+}
+
+static inline void
+flush_pending_scroll(Window *w) {
+    int s = w->pending_scroll.lines;
+    if (!s) return;
+    w->pending_scroll.lines = 0;
+    Screen *screen = w->render_data.screen;
+    if (!screen) return;
+    bool upwards = s > 0;
+    if (screen->modes.mouse_tracking_mode) {
+        // a scroll report must not be re-ordered before a motion report that
+        // preceded it
+        flush_pending_mouse_motion(w);
+        // one report per accumulated tick, so applications that count events
+        // still see the full scroll distance
+        int sz = encode_mouse_scroll(w, upwards, w->pending_scroll.mods);
+        if (sz > 0) {
+            mouse_event_buf[sz] = 0;
+            for (s = abs(s); s > 0; s--) write_escape_code_to_child(screen, CSI, mouse_event_buf);
+        }
+    } else {
+        if (screen->linebuf == screen->main_linebuf) screen_history_scroll(screen, abs(s), upwards);
+        else fake_scroll(w, abs(s), upwards);
+    }
+}
+
+void
+send_pending_mouse_motion_reports(void) {
+    // called once per main loop tick, so coalesced motion reports and wheel
+    // scrolls go out at most one frame after the raw events that produced them
+    for (size_t o = 0; o < global_state.num_os_windows; o++) {
+        OSWindow *os_window = global_state.os_windows + o;
+        for (size_t t = 0; t < os_window->num_tabs; t++) {
+            Tab *tab = os_window->tabs + t;
+            for (size_t i = 0; i < tab->num_windows; i++) {
+                flush_pending_mouse_motion(tab->windows + i);
+                flush_pending_scroll(tab->windows + i);
+            }
+        }
     }
 }
 
@@ -423,7 +485,7 @@ clear_click_queue(Window *w) {
 HANDLER(add_click) {
     ClickQueue *q = &w->click_queue;
     if (q->length == CLICK_QUEUE_SZ) { memmove(q->clicks, q->clicks + 1, sizeof(Click) * (CLICK_QUEUE_SZ - 1)); q->length--; }
-    monotonic_t now = monotonic();
+    monotonic_t now = coarse_monotonic();
 #define N(n) (q->clicks[q->length - n])
     N(0).at = now; N(0).button = button; N(0).modifiers = modifiers; N(0).x = w->mouse_pos.x; N(0).y = w->mouse_pos.y;
     q->length++;
@@ -484,6 +546,9 @@ HANDLER(handle_button_event) {
     }
     Screen *screen = w->render_data.screen;
     if (!screen) return;
+    // apply any coalesced wheel scroll first so that a button transition is
+    // never re-ordered before the scrolling that preceded it
+    flush_pending_scroll(w);
     const int ts1 = OPT(terminal_select_modifiers), ts2 = OPT(terminal_select_modifiers) | OPT(rectangle_select_modifiers);
     bool handle_in_kitty = (
             modifiers == ts1 || modifiers == ts2 ||
@@ -492,6 +557,9 @@ HANDLER(handle_button_event) {
         );
     if (handle_in_kitty) handle_button_event_in_kitty(w, button, modifiers, is_release);
     else {
+        // a button transition must not be re-ordered before a motion report
+        // that preceded it, so flush any coalesced motion first
+        flush_pending_mouse_motion(w);
         int sz = encode_mouse_button(w, button, is_release ? RELEASE : PRESS, modifiers);
         if (sz > 0) { mouse_event_buf[sz] = 0; write_escape_code_to_child(screen, CSI, mouse_event_buf); }
     }
@@ -717,19 +785,13 @@ scroll_event(double UNUSED xoffset, double yoffset, int flags, int modifiers) {
         screen->pending_scroll_pixels = 0;
     }
     if (s == 0) return;
-    bool upwards = s > 0;
-    if (screen->modes.mouse_tracking_mode) {
-        int sz = encode_mouse_scroll(w, upwards, modifiers);
-        if (sz > 0) {
-            mouse_event_buf[sz] = 0;
-            for (s = abs(s); s > 0; s--) {
-                write_escape_code_to_child(screen, CSI, mouse_event_buf);
-            }
-        }
-    } else {
-        if (screen->linebuf == screen->main_linebuf) screen_history_scroll(screen, abs(s), upwards);
-        else fake_scroll(w, abs(s), upwards);
-    }
+    // Wheel ticks are coalesced per frame: a free spinning wheel or touchpad
+    // delivers hundreds of events a second and applying each one separately
+    // scrolls the screen and marks damage once per tick. Only the net amount
+    // accumulates here, flush_pending_scroll() applies it from the main loop.
+    if (w->pending_scroll.lines && w->pending_scroll.mods != modifiers) flush_pending_scroll(w);
+    w->pending_scroll.lines += s;
+    w->pending_scroll.mods = modifiers;
 }
 
 static PyObject*
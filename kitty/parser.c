@@ -13,7 +13,14 @@
 #include "graphics.h"
 #include "charsets.h"
 #include "monotonic.h"
+#include "tracepoints.h"
 #include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
 
 extern PyTypeObject Screen_Type;
 
@@ -143,7 +150,9 @@ _report_params(PyObject *dump_callback, const char *name, unsigned int *params,
 
 #endif
 
-#define SET_STATE(state) screen->parser_state = state; screen->parser_buf_pos = 0;
+#define SET_STATE(state) screen->parser_state = state; screen->parser_buf_pos = 0; \
+    screen->parser_csi.num_params = 0; screen->parser_csi.current = 0; \
+    screen->parser_csi.has_current = false; screen->parser_csi.is_simple = true;
 // }}}
 
 // Normal mode {{{
@@ -329,13 +338,14 @@ parse_osc_8(char *buf, char **id, char **url) {
 static inline void
 dispatch_hyperlink(Screen *screen, size_t pos, size_t size, PyObject DUMP_UNUSED *dump_callback) {
     // since the spec says only ASCII printable chars are allowed in OSC 8, we
-    // can just convert to char* directly
+    // can just use the accumulated bytes directly
     if (!size) return;  // ignore empty OSC 8 since it must have two semi-colons to be valid, which means one semi-colon here
+    const uint8_t *buf = (const uint8_t*)screen->parser_buf;
     char *id = NULL, *url = NULL;
     char *data = malloc(size + 1);
     if (!data) fatal("Out of memory");
     for (size_t i = 0; i < size; i++) {
-        data[i] = screen->parser_buf[i + pos] & 0x7f;
+        data[i] = buf[i + pos] & 0x7f;
         if (data[i] < 32 || data[i] > 126) data[i] = '_';
     }
     data[size] = 0;
@@ -350,24 +360,48 @@ dispatch_hyperlink(Screen *screen, size_t pos, size_t size, PyObject DUMP_UNUSED
     free(data);
 }
 
+static inline void
+dispatch_osc52_chunk(Screen *screen, PyObject DUMP_UNUSED *dump_callback, bool is_partial) {
+    // Stream an over long OSC 52 payload to the clipboard handler in chunks
+    // instead of truncating it, so that clipboard writes are not limited by
+    // the parser buffer size. The first chunk includes the "where;" prefix,
+    // continuation chunks are raw base64.
+    const uint8_t *buf = (const uint8_t*)screen->parser_buf;
+    const unsigned int limit = screen->parser_buf_pos;
+    unsigned int i = screen->parser_osc52_pending ? 0 : 3;  // skip the leading "52;"
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyObject *string = PyUnicode_FromStringAndSize((const char*)buf + i, limit > i ? limit - i : 0);
+    if (string) {
+        REPORT_OSC(clipboard_control, string);
+        clipboard_control(screen, string, is_partial);
+        Py_CLEAR(string);
+    }
+    PyErr_Clear();
+    PyGILState_Release(gstate);
+    screen->parser_osc52_pending = is_partial;
+}
+
 static inline void
 dispatch_osc(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
+    if (screen->parser_osc52_pending) { dispatch_osc52_chunk(screen, dump_callback, false); return; }
 #define DISPATCH_OSC_WITH_CODE(name) REPORT_OSC2(name, code, string); name(screen, code, string);
 #define DISPATCH_OSC(name) REPORT_OSC(name, string); name(screen, string);
+// OSC dispatch needs Python, which the GIL-free parse hot path does not hold
 #define START_DISPATCH {\
-    PyObject *string = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, screen->parser_buf + i, limit - i); \
+    PyGILState_STATE dispatch_gstate = PyGILState_Ensure(); \
+    PyObject *string = PyUnicode_FromStringAndSize((const char*)buf + i, limit - i); \
     if (string) {
-#define END_DISPATCH Py_CLEAR(string); } PyErr_Clear(); break; }
+#define END_DISPATCH Py_CLEAR(string); } PyErr_Clear(); PyGILState_Release(dispatch_gstate); break; }
 
+    // the payload is accumulated as UTF-8 bytes, see accumulate_osc()
+    const uint8_t *buf = (const uint8_t*)screen->parser_buf;
     const unsigned int limit = screen->parser_buf_pos;
     unsigned int code=0, i;
     for (i = 0; i < MIN(limit, 5u); i++) {
-        if (screen->parser_buf[i] < '0' || screen->parser_buf[i] > '9') break;
-    }
-    if (i > 0) {
-        code = utoi(screen->parser_buf, i);
-        if (i < limit && screen->parser_buf[i] == ';') i++;
+        if (buf[i] < '0' || buf[i] > '9') break;
+        code = code * 10 + (buf[i] - '0');
     }
+    if (i > 0 && i < limit && buf[i] == ';') i++;
     switch(code) {
         case 0:
             START_DISPATCH
@@ -410,7 +444,8 @@ dispatch_osc(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
             END_DISPATCH
         case 52:
             START_DISPATCH
-            DISPATCH_OSC(clipboard_control);
+            REPORT_OSC(clipboard_control, string);
+            clipboard_control(screen, string, false);
             END_DISPATCH
         case 30001:
             REPORT_COMMAND(screen_push_dynamic_colors);
@@ -433,7 +468,6 @@ dispatch_osc(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
 
 // CSI mode {{{
 #define CSI_SECONDARY \
-        case ';': \
         case ':': \
         case '"': \
         case '*': \
@@ -465,6 +499,44 @@ repr_csi_params(unsigned int *params, unsigned int num_params) {
     return buf;
 }
 
+#ifndef DUMP_COMMANDS
+// Cache of parsed SGR sequences. Real workloads (ls --color, syntax
+// highlighted pagers) emit the same few dozen SGR strings millions of times,
+// so map the raw sequence directly to the parsed parameter groups and skip
+// parsing entirely on a hit. Disabled in dump builds, which must report
+// every parse step.
+#define SGR_CACHE_KEY_MAX 32
+#define SGR_CACHE_MAX_PARAMS 48
+#define SGR_CACHE_MAX_GROUPS 8
+typedef struct SGRCacheEntry {
+    unsigned int key_len, num_params, num_groups;
+    uint32_t key[SGR_CACHE_KEY_MAX];
+    unsigned int params[SGR_CACHE_MAX_PARAMS];
+    uint8_t group_sizes[SGR_CACHE_MAX_GROUPS];
+} SGRCacheEntry;
+static SGRCacheEntry sgr_cache[128] = {{0}};  // direct mapped
+
+static inline SGRCacheEntry*
+sgr_cache_entry_for(const uint32_t *buf, unsigned int num) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (unsigned int i = 0; i < num; i++) { h ^= buf[i]; h *= 16777619u; }
+    return sgr_cache + (h & (arraysz(sgr_cache) - 1));
+}
+
+static inline bool
+sgr_cache_record(SGRCacheEntry *e, const unsigned int *params, unsigned int num_params) {
+    if (e->num_groups >= SGR_CACHE_MAX_GROUPS || e->num_params + num_params > SGR_CACHE_MAX_PARAMS) return false;
+    memcpy(e->params + e->num_params, params, num_params * sizeof(params[0]));
+    e->num_params += num_params;
+    e->group_sizes[e->num_groups++] = (uint8_t)num_params;
+    return true;
+}
+
+#define SGR_CACHE_RECORD(p, n) if (cache_entry && !sgr_cache_record(cache_entry, p, n)) cache_entry = NULL;
+#else
+#define SGR_CACHE_RECORD(p, n)
+#endif
+
 #ifdef DUMP_COMMANDS
 static
 #endif
@@ -473,9 +545,26 @@ parse_sgr(Screen *screen, uint32_t *buf, unsigned int num, unsigned int *params,
     enum State { START, NORMAL, MULTIPLE, COLOR, COLOR1, COLOR3 };
     enum State state = START;
     unsigned int num_params, num_start, i;
+    bool sgr_ok UNUSED = true;
+#ifndef DUMP_COMMANDS
+    SGRCacheEntry *cache_entry = NULL;
+    if (!region && num && num <= SGR_CACHE_KEY_MAX) {
+        SGRCacheEntry *e = sgr_cache_entry_for(buf, num);
+        if (e->key_len == num && memcmp(e->key, buf, num * sizeof(buf[0])) == 0) {
+            for (unsigned int g = 0, pos = 0; g < e->num_groups; pos += e->group_sizes[g], g++) {
+                select_graphic_rendition(screen, e->params + pos, e->group_sizes[g], NULL);
+            }
+            return;
+        }
+        // (re)record this slot; key_len is only set once parsing succeeds
+        memcpy(e->key, buf, num * sizeof(buf[0]));
+        e->key_len = 0; e->num_params = 0; e->num_groups = 0;
+        cache_entry = e;
+    }
+#endif
 
 #define READ_PARAM { params[num_params++] = utoi(buf + num_start, i - num_start); }
-#define SEND_SGR { REPORT_PARAMS(report_name, params, num_params, region); select_graphic_rendition(screen, params, num_params, region); state = START; num_params = 0; }
+#define SEND_SGR { REPORT_PARAMS(report_name, params, num_params, region); SGR_CACHE_RECORD(params, num_params); select_graphic_rendition(screen, params, num_params, region); state = START; num_params = 0; }
 
     for (i=0, num_start=0, num_params=0; i < num && num_params < MAX_PARAMS; i++) {
         switch(buf[i]) {
@@ -576,21 +665,26 @@ parse_sgr(Screen *screen, uint32_t *buf, unsigned int num, unsigned int *params,
         case MULTIPLE:
             if (i > num_start && num_params < MAX_PARAMS) { READ_PARAM; }
             if (num_params) { SEND_SGR; }
-            else { REPORT_ERROR("Incomplete SGR code"); }
+            else { REPORT_ERROR("Incomplete SGR code"); sgr_ok = false; }
             break;
         case COLOR:
             REPORT_ERROR("Invalid SGR code containing incomplete semi-colon separated color sequence");
+            sgr_ok = false;
             break;
         case COLOR3:
             if (i > num_start && num_params < MAX_PARAMS) READ_PARAM;
             if (num_params != 5) {
                 REPORT_ERROR("Invalid SGR code containing incomplete semi-colon separated color sequence");
+                sgr_ok = false;
                 break;
             }
             if (num_params) { SEND_SGR; }
-            else { REPORT_ERROR("Incomplete SGR code"); }
+            else { REPORT_ERROR("Incomplete SGR code"); sgr_ok = false; }
             break;
     }
+#ifndef DUMP_COMMANDS
+    if (cache_entry && sgr_ok) cache_entry->key_len = num;
+#endif
 #undef READ_PARAM
 #undef SEND_SGR
 }
@@ -629,6 +723,43 @@ parse_region(Region *r, uint32_t *buf, unsigned int num) {
     return i;
 }
 
+typedef struct CSICommand {
+    const char *name;
+    void (*one_param)(Screen*, unsigned int);
+    void (*two_params)(Screen*, unsigned int, unsigned int);
+    unsigned int defval1, defval2;
+} CSICommand;
+
+// Dispatch table, indexed by the final byte, for CSI codes that have no
+// modifiers and purely numeric semi-colon separated parameters. Everything
+// else falls back to the switch in dispatch_csi().
+static const CSICommand csi_commands[128] = {
+    [ICH] = {.name="screen_insert_characters", .one_param=screen_insert_characters, .defval1=1},
+    [CUU] = {.name="screen_cursor_up2", .one_param=screen_cursor_up2, .defval1=1},
+    [CUD] = {.name="screen_cursor_down", .one_param=screen_cursor_down, .defval1=1},
+    [VPR] = {.name="screen_cursor_down", .one_param=screen_cursor_down, .defval1=1},
+    [CUF] = {.name="screen_cursor_forward", .one_param=screen_cursor_forward, .defval1=1},
+    [HPR] = {.name="screen_cursor_forward", .one_param=screen_cursor_forward, .defval1=1},
+    [CUB] = {.name="screen_cursor_back1", .one_param=screen_cursor_back1, .defval1=1},
+    [CNL] = {.name="screen_cursor_down1", .one_param=screen_cursor_down1, .defval1=1},
+    [CPL] = {.name="screen_cursor_up1", .one_param=screen_cursor_up1, .defval1=1},
+    [CHA] = {.name="screen_cursor_to_column", .one_param=screen_cursor_to_column, .defval1=1},
+    [HPA] = {.name="screen_cursor_to_column", .one_param=screen_cursor_to_column, .defval1=1},
+    [VPA] = {.name="screen_cursor_to_line", .one_param=screen_cursor_to_line, .defval1=1},
+    [CBT] = {.name="screen_backtab", .one_param=screen_backtab, .defval1=1},
+    [CHT] = {.name="screen_tabn", .one_param=screen_tabn, .defval1=1},
+    [REP] = {.name="screen_repeat_character", .one_param=screen_repeat_character, .defval1=1},
+    [IL] = {.name="screen_insert_lines", .one_param=screen_insert_lines, .defval1=1},
+    [DL] = {.name="screen_delete_lines", .one_param=screen_delete_lines, .defval1=1},
+    [DCH] = {.name="screen_delete_characters", .one_param=screen_delete_characters, .defval1=1},
+    [ECH] = {.name="screen_erase_characters", .one_param=screen_erase_characters, .defval1=1},
+    [TBC] = {.name="screen_clear_tab_stop", .one_param=screen_clear_tab_stop, .defval1=0},
+    [SU] = {.name="screen_scroll", .one_param=screen_scroll, .defval1=1},
+    [SD] = {.name="screen_reverse_scroll", .one_param=screen_reverse_scroll, .defval1=1},
+    [CUP] = {.name="screen_cursor_position", .two_params=screen_cursor_position, .defval1=1, .defval2=1},
+    [HVP] = {.name="screen_cursor_position", .two_params=screen_cursor_position, .defval1=1, .defval2=1},
+};
+
 static inline void
 dispatch_csi(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
 #define CALL_CSI_HANDLER1(name, defval) \
@@ -683,6 +814,25 @@ dispatch_csi(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
     unsigned int num = screen->parser_buf_pos, start, i, num_params=0, p1, p2;
     static unsigned int params[MAX_PARAMS] = {0};
     bool private;
+    if (screen->parser_csi.is_simple && code < arraysz(csi_commands)) {
+        // table-driven dispatch using the incrementally parsed parameters
+        const CSICommand *cmd = csi_commands + code;
+        if (cmd->one_param || cmd->two_params) {
+            unsigned int *pp = screen->parser_csi.params;
+            unsigned int n = screen->parser_csi.num_params;
+            if (screen->parser_csi.has_current && n < MAX_PARAMS) pp[n++] = screen->parser_csi.current;
+            p1 = n > 0 ? pp[0] : cmd->defval1;
+            if (cmd->one_param) {
+                REPORT_VA_COMMAND("si", cmd->name, (int)p1);
+                cmd->one_param(screen, p1);
+            } else {
+                p2 = n > 1 ? pp[1] : cmd->defval2;
+                REPORT_VA_COMMAND("sii", cmd->name, (int)p1, (int)p2);
+                cmd->two_params(screen, p1, p2);
+            }
+            return;
+        }
+    }
     if (buf[0] == '>' || buf[0] == '?' || buf[0] == '!' || buf[0] == '=' || buf[0] == '-') {
         start_modifier = (char)screen->parser_buf[0];
         buf++; num--;
@@ -702,6 +852,7 @@ dispatch_csi(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
 
     if (num > 0) {
         switch(buf[num-1]) {
+            case ';':
             CSI_SECONDARY
                 end_modifier = (char)buf[--num];
         }
@@ -884,13 +1035,10 @@ dispatch_csi(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
 // DCS mode {{{
 
 static inline bool
-startswith(const uint32_t *string, size_t sz, const char *prefix) {
+startswith(const uint8_t *string, size_t sz, const char *prefix) {
     size_t l = strlen(prefix);
     if (sz < l) return false;
-    for (size_t i = 0; i < l; i++) {
-        if (string[i] != (unsigned char)prefix[i]) return false;
-    }
-    return true;
+    return memcmp(string, prefix, l) == 0;
 }
 
 #define PENDING_MODE_CHAR '='
@@ -898,24 +1046,28 @@ startswith(const uint32_t *string, size_t sz, const char *prefix) {
 static inline void
 dispatch_dcs(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
     if (screen->parser_buf_pos < 2) return;
-    switch(screen->parser_buf[0]) {
+    // the payload is accumulated as bytes, see accumulate_dcs()
+    const uint8_t *buf = (const uint8_t*)screen->parser_buf;
+    switch(buf[0]) {
         case '+':
         case '$':
-            if (screen->parser_buf[1] == 'q') {
-                PyObject *string = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, screen->parser_buf + 2, screen->parser_buf_pos - 2);
+            if (buf[1] == 'q') {
+                PyGILState_STATE gstate = PyGILState_Ensure();
+                PyObject *string = PyUnicode_FromStringAndSize((const char*)buf + 2, screen->parser_buf_pos - 2);
                 if (string != NULL) {
-                    REPORT_OSC2(screen_request_capabilities, (char)screen->parser_buf[0], string);
-                    screen_request_capabilities(screen, (char)screen->parser_buf[0], string);
+                    REPORT_OSC2(screen_request_capabilities, (char)buf[0], string);
+                    screen_request_capabilities(screen, (char)buf[0], string);
                     Py_DECREF(string);
                 } else PyErr_Clear();
+                PyGILState_Release(gstate);
             } else {
-                REPORT_ERROR("Unrecognized DCS %c code: 0x%x", (char)screen->parser_buf[0], screen->parser_buf[1]);
+                REPORT_ERROR("Unrecognized DCS %c code: 0x%x", (char)buf[0], buf[1]);
             }
             break;
         case PENDING_MODE_CHAR:
-            if (screen->parser_buf_pos > 2 && (screen->parser_buf[1] == '1' || screen->parser_buf[1] == '2') && screen->parser_buf[2] == 's') {
-                if (screen->parser_buf[1] == '1') {
-                    screen->pending_mode.activated_at = monotonic();
+            if (screen->parser_buf_pos > 2 && (buf[1] == '1' || buf[1] == '2') && buf[2] == 's') {
+                if (buf[1] == '1') {
+                    screen->pending_mode.activated_at = coarse_monotonic();
                     REPORT_COMMAND(screen_start_pending_mode);
                 } else {
                     // ignore stop without matching start, see _queue_pending_bytes()
@@ -924,35 +1076,39 @@ dispatch_dcs(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
                     REPORT_COMMAND(screen_stop_pending_mode);
                 }
             } else {
-                REPORT_ERROR("Unrecognized DCS %c code: 0x%x", (char)screen->parser_buf[0], screen->parser_buf[1]);
+                REPORT_ERROR("Unrecognized DCS %c code: 0x%x", (char)buf[0], buf[1]);
             }
             break;
         case '@':
 #define CMD_PREFIX "kitty-cmd{"
-            if (startswith(screen->parser_buf + 1, screen->parser_buf_pos - 2, CMD_PREFIX)) {
-                PyObject *cmd = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, screen->parser_buf + 10, screen->parser_buf_pos - 10);
+            if (startswith(buf + 1, screen->parser_buf_pos - 2, CMD_PREFIX)) {
+                PyGILState_STATE gstate = PyGILState_Ensure();
+                PyObject *cmd = PyUnicode_FromStringAndSize((const char*)buf + 10, screen->parser_buf_pos - 10);
                 if (cmd != NULL) {
-                    REPORT_OSC2(screen_handle_cmd, (char)screen->parser_buf[0], cmd);
+                    REPORT_OSC2(screen_handle_cmd, (char)buf[0], cmd);
                     screen_handle_cmd(screen, cmd);
                     Py_DECREF(cmd);
                 } else PyErr_Clear();
+                PyGILState_Release(gstate);
 #undef CMD_PREFIX
 #define PRINT_PREFIX "kitty-print|"
-            } else if (startswith(screen->parser_buf + 1, screen->parser_buf_pos - 1, PRINT_PREFIX)) {
+            } else if (startswith(buf + 1, screen->parser_buf_pos - 1, PRINT_PREFIX)) {
                 const size_t pp_size = sizeof(PRINT_PREFIX);
-                PyObject *msg = PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, screen->parser_buf + pp_size, screen->parser_buf_pos - pp_size);
+                PyGILState_STATE gstate = PyGILState_Ensure();
+                PyObject *msg = PyUnicode_FromStringAndSize((const char*)buf + pp_size, screen->parser_buf_pos - pp_size);
                 if (msg != NULL) {
-                    REPORT_OSC2(screen_handle_print, (char)screen->parser_buf[0], msg);
+                    REPORT_OSC2(screen_handle_print, (char)buf[0], msg);
                     screen_handle_print(screen, msg);
                     Py_DECREF(msg);
                 } else PyErr_Clear();
+                PyGILState_Release(gstate);
             } else {
-                REPORT_ERROR("Unrecognized DCS @ code: 0x%x", screen->parser_buf[1]);
+                REPORT_ERROR("Unrecognized DCS @ code: 0x%x", buf[1]);
             }
             break;
 #undef PRINT_PREFIX
         default:
-            REPORT_ERROR("Unrecognized DCS code: 0x%x", screen->parser_buf[0]);
+            REPORT_ERROR("Unrecognized DCS code: 0x%x", buf[0]);
             break;
     }
 }
@@ -966,9 +1122,13 @@ static inline void
 dispatch_apc(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
     if (screen->parser_buf_pos < 2) return;
     switch(screen->parser_buf[0]) {
-        case 'G':
+        case 'G': {
+            // the graphics machinery lazily initializes its Python backed
+            // disk cache and reports failures via the error indicator
+            PyGILState_STATE gstate = PyGILState_Ensure();
             parse_graphics_code(screen, dump_callback);
-            break;
+            PyGILState_Release(gstate);
+        }   break;
         default:
             REPORT_ERROR("Unrecognized APC code: 0x%x", screen->parser_buf[0]);
             break;
@@ -995,6 +1155,9 @@ dispatch_pm(Screen *screen, PyObject DUMP_UNUSED *dump_callback) {
 
 static inline bool
 accumulate_osc(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback) {
+    // the payload is accumulated as UTF-8 bytes, re-using the parser buffer
+    // as a byte buffer, so that dispatch needs no narrowing pass
+    uint8_t *buf = (uint8_t*)screen->parser_buf;
     switch(ch) {
         case ST:
             return true;
@@ -1004,17 +1167,28 @@ accumulate_osc(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback)
         case DEL:
             break;
         case ESC_ST:
-            if (screen->parser_buf_pos > 0 && screen->parser_buf[screen->parser_buf_pos - 1] == ESC) {
+            if (screen->parser_buf_pos > 0 && buf[screen->parser_buf_pos - 1] == ESC) {
                 screen->parser_buf_pos--;
                 return true;
             }
             /* fallthrough */
         default:
-            if (screen->parser_buf_pos >= PARSER_BUF_SZ - 1) {
-                REPORT_ERROR("OSC sequence too long, truncating.");
-                return true;
+            if (screen->parser_buf_pos >= sizeof(screen->parser_buf) - 4) {
+                if (screen->parser_osc52_pending || (screen->parser_buf_pos > 3 && buf[0] == '5' && buf[1] == '2' && buf[2] == ';')) {
+                    // stream clipboard data out in chunks instead of truncating,
+                    // keeping a trailing ESC back in case it is the start of the
+                    // ESC \ terminator
+                    bool trailing_esc = buf[screen->parser_buf_pos - 1] == ESC;
+                    if (trailing_esc) screen->parser_buf_pos--;
+                    dispatch_osc52_chunk(screen, dump_callback, true);
+                    screen->parser_buf_pos = 0;
+                    if (trailing_esc) buf[screen->parser_buf_pos++] = ESC;
+                } else {
+                    REPORT_ERROR("OSC sequence too long, truncating.");
+                    return true;
+                }
             }
-            screen->parser_buf[screen->parser_buf_pos++] = ch;
+            screen->parser_buf_pos += encode_utf8(ch, (char*)buf + screen->parser_buf_pos);
             break;
     }
     return false;
@@ -1022,6 +1196,8 @@ accumulate_osc(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback)
 
 static inline bool
 accumulate_dcs(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback) {
+    // only printable ASCII is allowed in a DCS payload, accumulated as bytes
+    uint8_t *buf = (uint8_t*)screen->parser_buf;
     switch(ch) {
         case ST:
             return true;
@@ -1032,16 +1208,16 @@ accumulate_dcs(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback)
 START_ALLOW_CASE_RANGE
         case 32 ... 126:
 END_ALLOW_CASE_RANGE
-            if (screen->parser_buf_pos > 0 && screen->parser_buf[screen->parser_buf_pos-1] == ESC) {
+            if (screen->parser_buf_pos > 0 && buf[screen->parser_buf_pos-1] == ESC) {
                 if (ch == '\\') { screen->parser_buf_pos--; return true; }
                 REPORT_ERROR("DCS sequence contained non-printable character: 0x%x ignoring the sequence", ESC);
                 SET_STATE(ESC); return false;
             }
-            if (screen->parser_buf_pos >= PARSER_BUF_SZ - 1) {
+            if (screen->parser_buf_pos >= sizeof(screen->parser_buf) - 1) {
                 REPORT_ERROR("DCS sequence too long, truncating.");
                 return true;
             }
-            screen->parser_buf[screen->parser_buf_pos++] = ch;
+            buf[screen->parser_buf_pos++] = ch;
             break;
         default:
             REPORT_ERROR("DCS sequence contained non-printable character: 0x%x ignoring the sequence", ch);
@@ -1084,8 +1260,29 @@ accumulate_csi(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback)
 
     switch(ch) {
         IS_DIGIT
+            ENSURE_SPACE;
+            if (LIKELY(screen->parser_csi.is_simple)) {
+                if (UNLIKELY(screen->parser_csi.current > (UINT_MAX - 9) / 10)) screen->parser_csi.is_simple = false;
+                else {
+                    screen->parser_csi.current = screen->parser_csi.current * 10 + (ch - '0');
+                    screen->parser_csi.has_current = true;
+                }
+            }
+            screen->parser_buf[screen->parser_buf_pos++] = ch;
+            break;
+        case ';':
+            ENSURE_SPACE;
+            if (screen->parser_csi.is_simple) {
+                if (LIKELY(screen->parser_csi.num_params < MAX_PARAMS)) {
+                    screen->parser_csi.params[screen->parser_csi.num_params++] = screen->parser_csi.has_current ? screen->parser_csi.current : 0;
+                    screen->parser_csi.current = 0; screen->parser_csi.has_current = false;
+                } else screen->parser_csi.is_simple = false;
+            }
+            screen->parser_buf[screen->parser_buf_pos++] = ch;
+            break;
         CSI_SECONDARY
             ENSURE_SPACE;
+            screen->parser_csi.is_simple = false;
             screen->parser_buf[screen->parser_buf_pos++] = ch;
             break;
         case '?':
@@ -1099,6 +1296,7 @@ accumulate_csi(Screen *screen, uint32_t ch, PyObject DUMP_UNUSED *dump_callback)
                 return false;
             }
             ENSURE_SPACE;
+            screen->parser_csi.is_simple = false;
             screen->parser_buf[screen->parser_buf_pos++] = ch;
             break;
 START_ALLOW_CASE_RANGE
@@ -1170,14 +1368,123 @@ END_ALLOW_CASE_RANGE
 
 extern uint32_t *latin1_charset;
 
+// Find the number of leading bytes in buf that are printable ASCII
+// (0x20 - 0x7e), using SIMD when available. Bulk plain text, which is the
+// overwhelmingly common case, can then bypass the per-byte state machine.
+static inline size_t
+find_printable_ascii_run(const uint8_t *buf, size_t sz) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(0x20), del = _mm_set1_epi8(0x7f);
+    while (i + 16 <= sz) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(buf + i));
+        // signed compare, so bytes >= 0x80 are negative and also < 0x20
+        __m128i non_printable = _mm_or_si128(_mm_cmplt_epi8(chunk, space), _mm_cmpeq_epi8(chunk, del));
+        int mask = _mm_movemask_epi8(non_printable);
+        if (mask) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t space = vdupq_n_u8(0x20), tilde = vdupq_n_u8(0x7e);
+    while (i + 16 <= sz) {
+        uint8x16_t chunk = vld1q_u8(buf + i);
+        uint8x16_t non_printable = vorrq_u8(vcltq_u8(chunk, space), vcgtq_u8(chunk, tilde));
+        uint64x2_t m = vreinterpretq_u64_u8(non_printable);
+        if (vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) break;
+        i += 16;
+    }
+#endif
+    while (i < sz && 0x20 <= buf[i] && buf[i] <= 0x7e) i++;
+    return i;
+}
+
+// Find the number of leading bytes in buf that cannot be C0 controls or DEL,
+// i.e. that are either printable ASCII or part of a (possibly invalid) UTF-8
+// sequence, and so can be handed to the bulk UTF-8 decoder.
+static inline size_t
+find_utf8_text_run(const uint8_t *buf, size_t sz) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i c0_max = _mm_set1_epi8(0x1f), del = _mm_set1_epi8(0x7f);
+    while (i + 16 <= sz) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(buf + i));
+        // unsigned chunk <= 0x1f, via min
+        __m128i is_c0 = _mm_cmpeq_epi8(_mm_min_epu8(chunk, c0_max), chunk);
+        __m128i non_text = _mm_or_si128(is_c0, _mm_cmpeq_epi8(chunk, del));
+        int mask = _mm_movemask_epi8(non_text);
+        if (mask) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t c0_max = vdupq_n_u8(0x1f), del = vdupq_n_u8(0x7f);
+    while (i + 16 <= sz) {
+        uint8x16_t chunk = vld1q_u8(buf + i);
+        uint8x16_t non_text = vorrq_u8(vcleq_u8(chunk, c0_max), vceqq_u8(chunk, del));
+        uint64x2_t m = vreinterpretq_u64_u8(non_text);
+        if (vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) break;
+        i += 16;
+    }
+#endif
+    while (i < sz && buf[i] >= 0x20 && buf[i] != 0x7f) i++;
+    return i;
+}
+
+#define TEXT_CHUNK_SZ 4096
+
+static inline void
+draw_codepoint_run(Screen *screen, const uint32_t *chars, size_t num, PyObject DUMP_UNUSED *dump_callback) {
+#ifdef DUMP_COMMANDS
+    for (size_t i = 0; i < num; i++) { REPORT_DRAW(chars[i]); }
+#endif
+    screen_draw_run(screen, chars, num);
+}
+
+static inline void
+draw_printable_ascii_run(Screen *screen, const uint8_t *buf, size_t num, PyObject DUMP_UNUSED *dump_callback) {
+    // printable ASCII is mapped to itself by all charset translation tables,
+    // including Latin-1, so the bytes only need widening to char_type
+    uint32_t chars[TEXT_CHUNK_SZ];
+    while (num) {
+        size_t sz = MIN(num, (size_t)TEXT_CHUNK_SZ);
+        for (size_t i = 0; i < sz; i++) chars[i] = buf[i];
+        draw_codepoint_run(screen, chars, sz, dump_callback);
+        buf += sz; num -= sz;
+    }
+}
+
+#define PRINTABLE_ASCII_FAST_PATH(pos, remaining) \
+    if (!screen->parser_state && (screen->use_latin1 || screen->utf8_state == UTF8_ACCEPT)) { \
+        size_t run_sz = find_printable_ascii_run(buf + pos, remaining); \
+        if (run_sz) { \
+            draw_printable_ascii_run(screen, buf + pos, run_sz, dump_callback); \
+            pos += run_sz; \
+            continue; \
+        } \
+        if (!screen->use_latin1 && buf[pos] >= 0x80) { \
+            size_t text_sz = find_utf8_text_run(buf + pos, MIN(remaining, (size_t)TEXT_CHUNK_SZ)); \
+            if (text_sz) { \
+                uint32_t chars[TEXT_CHUNK_SZ]; size_t chunk_consumed; \
+                size_t num_chars = decode_utf8_chunk(buf + pos, text_sz, chars, &chunk_consumed); \
+                if (chunk_consumed) { \
+                    draw_codepoint_run(screen, chars, num_chars, dump_callback); \
+                    pos += chunk_consumed; \
+                    continue; \
+                } \
+            } \
+        } \
+    }
+
 static inline void
 _parse_bytes(Screen *screen, const uint8_t *buf, Py_ssize_t len, PyObject DUMP_UNUSED *dump_callback) {
     uint32_t prev = screen->utf8_state;
-    for (unsigned int i = 0; i < (unsigned int)len; i++) {
+    size_t i = 0;
+    while (i < (size_t)len) {
+        PRINTABLE_ASCII_FAST_PATH(i, (size_t)len - i);
+        uint8_t ch = buf[i++];
         if (screen->use_latin1) {
-            dispatch_unicode_char(latin1_charset[buf[i]], ;);
+            dispatch_unicode_char(latin1_charset[ch], ;);
         } else {
-            switch (decode_utf8(&screen->utf8_state, &screen->utf8_codepoint, buf[i])) {
+            switch (decode_utf8(&screen->utf8_state, &screen->utf8_codepoint, ch)) {
                 case UTF8_ACCEPT:
                     dispatch_unicode_char(screen->utf8_codepoint, ;);
                     break;
@@ -1197,6 +1504,7 @@ _parse_bytes_watching_for_pending(Screen *screen, const uint8_t *buf, Py_ssize_t
     uint32_t prev = screen->utf8_state;
     size_t i = 0;
     while(i < (size_t)len) {
+        PRINTABLE_ASCII_FAST_PATH(i, (size_t)len - i);
         uint8_t ch = buf[i++];
         if (screen->use_latin1) {
             dispatch_unicode_char(latin1_charset[ch], if (screen->pending_mode.activated_at) goto end);
@@ -1277,7 +1585,7 @@ _queue_pending_bytes(Screen *screen, const uint8_t *buf, size_t len, PyObject *d
                         goto end;
                     } else {
                         REPORT_COMMAND(screen_start_pending_mode);
-                        screen->pending_mode.activated_at = monotonic();
+                        screen->pending_mode.activated_at = coarse_monotonic();
                     }
                 } else {
                     state = NORMAL;
@@ -1298,6 +1606,7 @@ do_parse_bytes(Screen *screen, const uint8_t *read_buf, const size_t read_buf_sz
     enum STATE {START, PARSE_PENDING, PARSE_READ_BUF, QUEUE_PENDING};
     enum STATE state = START;
     size_t read_buf_pos = 0;
+    TRACE_EVENT2(parse_bytes_start, screen->window_id, read_buf_sz);
 
     do {
         switch(state) {
@@ -1342,7 +1651,7 @@ do_parse_bytes(Screen *screen, const uint8_t *read_buf, const size_t read_buf_sz
             }   break;
         }
     } while(read_buf_pos < read_buf_sz || (!screen->pending_mode.activated_at && screen->pending_mode.used));
-
+    TRACE_EVENT2(parse_bytes_end, screen->window_id, read_buf_sz);
 }
 
 // }}}
@@ -1369,15 +1678,38 @@ FNAME(parse_bytes)(PyObject UNUSED *self, PyObject *args) {
 }
 
 
+// Maximum time one screen may spend parsing per main loop tick. A screen
+// with a monster read buffer yields the main thread to rendering and input
+// handling for other windows, and is re-scheduled immediately by do_parse().
+#define PARSE_TIME_BUDGET ms_to_monotonic_t(2ll)
+#define PARSE_CHUNK_SZ (64u * 1024u)
+
 void
-FNAME(parse_worker)(Screen *screen, PyObject *dump_callback, monotonic_t now) {
+FNAME(parse_worker)(Screen *screen, PyObject *dump_callback, monotonic_t now, size_t max_sz) {
+    // The read buffer is a ring shared with the I/O thread, which appends at
+    // the tail; only this thread moves the head. Called with the read lock
+    // held. The lock is dropped while a chunk is being parsed -- the chunk
+    // lies in the occupied region, which the producer never writes into --
+    // and re-taken only for the head bookkeeping, so a long parse holds up
+    // the producer for O(1) work per chunk instead of a whole parse quantum.
+    // Parser state carries over between the calls.
+    const monotonic_t deadline = now + PARSE_TIME_BUDGET;
+    size_t remaining = MIN(screen->read_buf_sz, max_sz);
+    while (remaining) {
+        size_t contiguous = MIN(remaining, READ_BUF_SZ - screen->read_buf_start);
+        contiguous = MIN(contiguous, (size_t)PARSE_CHUNK_SZ);
+        const uint8_t *chunk = screen->read_buf + screen->read_buf_start;
+        pthread_mutex_unlock(&screen->read_buf_lock);
 #ifdef DUMP_COMMANDS
-    if (screen->read_buf_sz) {
-        Py_XDECREF(PyObject_CallFunction(dump_callback, "sy#", "bytes", screen->read_buf, screen->read_buf_sz)); PyErr_Clear();
-    }
+        Py_XDECREF(PyObject_CallFunction(dump_callback, "sy#", "bytes", chunk, contiguous)); PyErr_Clear();
 #endif
-    do_parse_bytes(screen, screen->read_buf, screen->read_buf_sz, now, dump_callback);
-    screen->read_buf_sz = 0;
+        do_parse_bytes(screen, chunk, contiguous, now, dump_callback);
+        pthread_mutex_lock(&screen->read_buf_lock);
+        screen->read_buf_start = (screen->read_buf_start + contiguous) % READ_BUF_SZ;
+        screen->read_buf_sz -= contiguous;
+        remaining -= contiguous;
+        if (remaining && monotonic() >= deadline) break;  // budget exhausted
+    }
 }
 #undef FNAME
 // }}}
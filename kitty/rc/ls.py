@@ -3,7 +3,7 @@
 # License: GPLv3 Copyright: 2020, Kovid Goyal <kovid at kovidgoyal.net>
 
 import json
-from typing import Any, Optional
+from typing import TYPE_CHECKING, Optional
 
 from kitty.constants import appname
 
@@ -12,10 +12,13 @@ from .base import (
     ResponseType, Window
 )
 
+if TYPE_CHECKING:
+    from kitty.cli_stub import LSRCOptions as CLIOptions
+
 
 class LS(RemoteCommand):
     '''
-    No payload
+    fields: The list of per-window fields to include in the listing, or null for all fields
     '''
 
     short_desc = 'List all tabs/windows'
@@ -27,13 +30,25 @@ class LS(RemoteCommand):
         ' :italic:`command-line` and :italic:`environment` of the process running in the window.\n\n'
         'You can use these criteria to select windows/tabs for the other commands.'
     )
+    options_spec = '''\
+--fields
+A comma separated list of the per-window fields to include in the listing.
+The fields other than id, is_focused and title require reading process
+information for the window, which can be expensive with many windows, so
+scripts that run this command frequently should ask only for the fields they
+need. Available fields: pid, cwd, cmdline, env, foreground_processes. By
+default all fields are included.
+'''
     argspec = ''
 
-    def message_to_kitty(self, global_opts: RCOptions, opts: Any, args: ArgsType) -> PayloadType:
-        pass
+    def message_to_kitty(self, global_opts: RCOptions, opts: 'CLIOptions', args: ArgsType) -> PayloadType:
+        if opts.fields:
+            return {'fields': list(filter(None, opts.fields.split(',')))}
+        return None
 
     def response_from_kitty(self, boss: Boss, window: Optional[Window], payload_get: PayloadGetType) -> ResponseType:
-        data = list(boss.list_os_windows())
+        fields = payload_get('fields')
+        data = list(boss.list_os_windows(frozenset(fields) if fields else None))
         return json.dumps(data, indent=2, sort_keys=True)
 
 
@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+# vim:fileencoding=utf-8
+# License: GPLv3 Copyright: 2021, Kovid Goyal <kovid at kovidgoyal.net>
+
+import json
+from typing import TYPE_CHECKING, Any, Dict, Optional
+
+from .base import (
+    MATCH_WINDOW_OPTION, ArgsType, Boss, MatchError, PayloadGetType,
+    PayloadType, RCOptions, RemoteCommand, ResponseType, Window
+)
+
+if TYPE_CHECKING:
+    from kitty.cli_stub import MemoryStatsRCOptions as CLIOptions
+
+
+class MemoryStats(RemoteCommand):
+
+    '''
+    match: Which windows to report on
+    '''
+
+    short_desc = 'Report per-window memory use'
+    desc = (
+        'Report the number of bytes of memory used by each window, broken'
+        ' down by subsystem: screen cells, scrollback, pager history and'
+        ' graphics, along with process wide totals for scrollback and the'
+        ' glyph cache. All sizes are in bytes. The report is returned as JSON.'
+    )
+    options_spec = MATCH_WINDOW_OPTION
+    argspec = ''
+
+    def message_to_kitty(self, global_opts: RCOptions, opts: 'CLIOptions', args: ArgsType) -> PayloadType:
+        return {'match': opts.match}
+
+    def response_from_kitty(self, boss: Boss, window: Optional[Window], payload_get: PayloadGetType) -> ResponseType:
+        from kitty.fast_data_types import (
+            glyph_cache_memory_used, scrollback_memory_used
+        )
+        match = payload_get('match')
+        if match:
+            windows = list(boss.match_windows(match))
+            if not windows:
+                raise MatchError(match)
+        else:
+            windows = list(boss.all_windows)
+        wdata = []
+        totals: Dict[str, int] = {}
+        for w in windows:
+            stats = w.memory_stats()
+            for k, v in stats.items():
+                totals[k] = totals.get(k, 0) + v
+            wdata.append({'id': w.id, 'title': w.override_title or w.title, **stats})
+        glyph_ram, glyph_disk = glyph_cache_memory_used()
+        data: Dict[str, Any] = {
+            'windows': wdata,
+            'totals': totals,
+            'scrollback_resident_bytes': scrollback_memory_used(),
+            'glyph_cache_ram_bytes': glyph_ram,
+            'glyph_cache_disk_bytes': glyph_disk,
+        }
+        return json.dumps(data, indent=2, sort_keys=True)
+
+
+memory_stats = MemoryStats()
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+# vim:fileencoding=utf-8
+# License: GPLv3 Copyright: 2020, Kovid Goyal <kovid at kovidgoyal.net>
+
+import json
+from typing import Any, Optional
+
+from .base import (
+    ArgsType, Boss, PayloadGetType, PayloadType, RCOptions, RemoteCommand,
+    ResponseType, Window
+)
+
+
+class PerfStats(RemoteCommand):
+    '''
+    No payload
+    '''
+
+    short_desc = 'Report event loop performance counters'
+    desc = (
+        'Report the internal event loop performance counters, as JSON. The counters'
+        ' are grouped per thread: :italic:`io` (child output reads/writes), :italic:`talk`'
+        ' (remote control peers) and :italic:`main` (ticks, frames rendered, timer fires,'
+        ' parse time and wakeup-to-tick latency distributions). Counts are cumulative'
+        ' since startup, times are in nanoseconds and the :italic:`hist_log2_us` lists'
+        ' are histograms over power-of-two microsecond buckets.'
+    )
+    argspec = ''
+
+    def message_to_kitty(self, global_opts: RCOptions, opts: Any, args: ArgsType) -> PayloadType:
+        pass
+
+    def response_from_kitty(self, boss: Boss, window: Optional[Window], payload_get: PayloadGetType) -> ResponseType:
+        from kitty.fast_data_types import perf_counters
+        return json.dumps(perf_counters(), indent=2, sort_keys=True)
+
+
+perf_stats = PerfStats()
@@ -0,0 +1,38 @@
+#!/usr/bin/env python
+# vim:fileencoding=utf-8
+# License: GPLv3 Copyright: 2021, Kovid Goyal <kovid at kovidgoyal.net>
+
+import json
+from typing import Any, Optional
+
+from kitty.fast_data_types import get_render_timings
+
+from .base import (
+    ArgsType, Boss, PayloadGetType, PayloadType, RCOptions, RemoteCommand,
+    ResponseType, Window
+)
+
+
+class RenderTimings(RemoteCommand):
+    '''
+    No payload
+    '''
+
+    short_desc = 'Report frame render timing statistics'
+    desc = (
+        'Report per OS window render timing statistics, as JSON. For every OS window the'
+        ' CPU time spent preparing cell data and updating uniforms and the GPU time spent'
+        ' executing the cell draw calls are reported, as totals, maxima and histograms.'
+        ' Histogram bucket :italic:`i` counts frames that took between 2^i and 2^(i+1) microseconds.'
+    )
+    argspec = ''
+
+    def message_to_kitty(self, global_opts: RCOptions, opts: Any, args: ArgsType) -> PayloadType:
+        pass
+
+    def response_from_kitty(self, boss: Boss, window: Optional[Window], payload_get: PayloadGetType) -> ResponseType:
+        data = {os_window_id: get_render_timings(os_window_id) for os_window_id in boss.os_window_map}
+        return json.dumps(data, indent=2, sort_keys=True)
+
+
+render_timings = RenderTimings()
@@ -67,6 +67,16 @@ def encode_send(send: Any) -> bytes:
     return b'\x1bP' + es + b'\x1b\\'
 
 
+def encode_frame(send: Any) -> bytes:
+    # A length prefixed binary frame. Only usable over sockets, the advantage
+    # over the escape code format is that kitty responds with a frame per
+    # command that carries an id (and nothing for fire-and-forget commands),
+    # so many commands can be pipelined onto a single connection instead of
+    # paying a connection round-trip each
+    payload = json.dumps(send).encode('utf-8')
+    return b'\x00' + len(payload).to_bytes(4, 'little') + payload
+
+
 class SocketIO:
 
     def __init__(self, to: str):
@@ -107,6 +117,21 @@ class SocketIO:
             raise TimeoutError('Timed out while waiting to read cmd response')
         return bytes(m.group(1))
 
+    def recv_frames(self, count: int, timeout: float) -> List[bytes]:
+        self.socket.settimeout(timeout)
+        ans: List[bytes] = []
+        with self.socket.makefile('rb') as src:
+            for _ in range(count):
+                header = src.read(5)
+                if len(header) < 5 or header[0] != 0:
+                    raise OSError('Invalid or missing response frame from kitty')
+                sz = int.from_bytes(header[1:], 'little')
+                payload = src.read(sz)
+                if len(payload) < sz:
+                    raise OSError('Truncated response frame from kitty')
+                ans.append(payload)
+        return ans
+
 
 class RCIO(TTYIO):
 
@@ -138,6 +163,34 @@ def do_io(to: Optional[str], send: Dict, no_response: bool) -> Dict[str, Any]:
     return cast(Dict[str, Any], json.loads(received.decode('ascii')))
 
 
+def do_batch_io(to: str, sends: List[Dict], timeout: float = 10) -> List[Optional[Dict[str, Any]]]:
+    # Pipeline multiple commands over a single socket connection, as length
+    # prefixed binary frames. Commands created with no_response are
+    # fire-and-forget: kitty sends no response frame for them at all. All
+    # other commands are tagged with an id that kitty echoes back in its
+    # response frame, so responses are correlated by id rather than counted.
+    # The returned list is in command order, with None entries for
+    # fire-and-forget commands.
+    index_for_id: Dict[int, int] = {}
+    for i, send in enumerate(sends):
+        if send.get('no_response'):
+            send.pop('id', None)
+        else:
+            send['id'] = i + 1
+            index_for_id[i + 1] = i
+    ans: List[Optional[Dict[str, Any]]] = [None] * len(sends)
+    io = SocketIO(to)
+    with io:
+        io.send(b''.join(map(encode_frame, sends)))
+        for frame in io.recv_frames(len(index_for_id), timeout):
+            response = json.loads(frame.decode('utf-8'))
+            idx = index_for_id.get(response.get('id'))
+            if idx is None:
+                raise OSError('Response frame with unknown id received from kitty')
+            ans[idx] = response
+    return ans
+
+
 cli_msg = (
         'Control {appname} by sending it commands. Set the'
         ' :opt:`allow_remote_control` option to yes in :file:`kitty.conf` for this'
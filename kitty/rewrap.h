@@ -42,6 +42,12 @@
 #define is_src_line_continued(src_y) (src_y < src->ynum - 1 ? (src->line_attrs[src_y + 1] & CONTINUED_MASK) : false)
 #endif
 
+// called after every source line has been copied out, with the number of
+// lines consumed so far, so the source buffer can release storage early
+#ifndef src_line_was_consumed
+#define src_line_was_consumed(num_consumed)
+#endif
+
 static inline void
 copy_range(Line *src, index_type src_at, Line* dest, index_type dest_at, index_type num) {
     memcpy(dest->cpu_cells + dest_at, src->cpu_cells + src_at, num * sizeof(CPUCell));
@@ -77,6 +83,7 @@ rewrap_inner(BufType *src, BufType *dest, const index_type src_limit, HistoryBuf
             src_x += num; dest_x += num;
         }
         src_y++; src_x = 0;
+        src_line_was_consumed(src_y);
         if (!src_line_is_continued && src_y < src_limit) { next_dest_line(false); dest_x = 0; }
     } while (src_y < src_limit);
     dest->line->ynum = dest_y;
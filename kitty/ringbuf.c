@@ -151,12 +151,15 @@ static uint8_t *
 ringbuf_nextp(ringbuf_t rb, const uint8_t *p)
 {
     /*
-     * The assert guarantees the expression (++p - rb->buf) is
-     * non-negative; therefore, the modulus operation is safe and
-     * portable.
+     * p is always inside the buffer, so the increment can wrap at most
+     * once and a compare-and-subtract avoids an integer division on
+     * arbitrary (not power of two) buffer sizes.
      */
     assert((p >= rb->buf) && (p < ringbuf_end(rb)));
-    return rb->buf + ((++p - rb->buf) % ringbuf_buffer_size(rb));
+    size_t idx = ++p - rb->buf;
+    if (idx >= ringbuf_buffer_size(rb))
+        idx -= ringbuf_buffer_size(rb);
+    return rb->buf + idx;
 }
 
 size_t
@@ -167,8 +170,11 @@ ringbuf_findchr(const struct ringbuf_t *rb, int c, size_t offset)
     if (offset >= bytes_used)
         return bytes_used;
 
-    const uint8_t *start = rb->buf +
-        (((rb->tail - rb->buf) + offset) % ringbuf_buffer_size(rb));
+    /* offset is less than bytes_used, so the sum wraps at most once */
+    size_t start_idx = (rb->tail - rb->buf) + offset;
+    if (start_idx >= ringbuf_buffer_size(rb))
+        start_idx -= ringbuf_buffer_size(rb);
+    const uint8_t *start = rb->buf + start_idx;
     assert(bufend > start);
     size_t n = size_t_min(bufend - start, bytes_used - offset);
     const uint8_t *found = memchr(start, c, n);
@@ -237,6 +243,40 @@ ringbuf_memcpy_into(ringbuf_t dst, const void *src, size_t count)
     return dst->head;
 }
 
+void *
+ringbuf_memcpy_intov(ringbuf_t dst, const struct iovec *iov, int iovcnt)
+{
+    const uint8_t *bufend = ringbuf_end(dst);
+    size_t count = 0;
+    for (int i = 0; i < iovcnt; i++)
+        count += iov[i].iov_len;
+    int overflow = count > ringbuf_bytes_free(dst);
+
+    for (int i = 0; i < iovcnt; i++) {
+        const uint8_t *u8src = iov[i].iov_base;
+        size_t nread = 0;
+        while (nread != iov[i].iov_len) {
+            /* don't copy beyond the end of the buffer */
+            assert(bufend > dst->head);
+            size_t n = size_t_min(bufend - dst->head, iov[i].iov_len - nread);
+            memcpy(dst->head, u8src + nread, n);
+            dst->head += n;
+            nread += n;
+
+            /* wrap? */
+            if (dst->head == bufend)
+                dst->head = dst->buf;
+        }
+    }
+
+    if (overflow) {
+        dst->tail = ringbuf_nextp(dst, dst->head);
+        assert(ringbuf_is_full(dst));
+    }
+
+    return dst->head;
+}
+
 ssize_t
 ringbuf_read(int fd, ringbuf_t rb, size_t count)
 {
@@ -26,6 +26,7 @@
 
 #include <stddef.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 typedef struct ringbuf_t *ringbuf_t;
 
@@ -153,6 +154,16 @@ ringbuf_memset(ringbuf_t dst, int c, size_t len);
 void *
 ringbuf_memcpy_into(ringbuf_t dst, const void *src, size_t count);
 
+/*
+ * Copy the memory regions described by the iovec array iov (as used
+ * by writev(2)) into the ring buffer dst, as one logical append. This
+ * is equivalent to calling ringbuf_memcpy_into() once per iovec entry
+ * but performs the overflow bookkeeping only once. Returns the ring
+ * buffer's new head pointer.
+ */
+void *
+ringbuf_memcpy_intov(ringbuf_t dst, const struct iovec *iov, int iovcnt);
+
 /*
  * This convenience function calls read(2) on the file descriptor fd,
  * using the ring buffer rb as the destination buffer for the read,
@@ -20,6 +20,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include "unicode-data.h"
+#include "combining-chars.h"
+#include "uthash.h"
 #include "modes.h"
 #include "wcwidth-std.h"
 #include "control-codes.h"
@@ -36,6 +38,7 @@ clear_selection(Selections *selections) {
     selections->in_progress = false;
     selections->extend_mode = EXTEND_CELL;
     selections->count = 0;
+    selections->generation++;
 }
 
 static inline void
@@ -70,10 +73,14 @@ init_overlay_line(Screen *self, index_type columns) {
         self->utf8_state = 0; \
         self->utf8_codepoint = 0; \
         self->use_latin1 = false;
+// The parser runs with the GIL released, so the rare dispatches that need to
+// call into Python re-acquire it for just the duration of the call
 #define CALLBACK(...) \
     if (self->callbacks != Py_None) { \
+        PyGILState_STATE callback_gstate_ = PyGILState_Ensure(); \
         PyObject *callback_ret = PyObject_CallMethod(self->callbacks, __VA_ARGS__); \
         if (callback_ret == NULL) PyErr_Print(); else Py_DECREF(callback_ret); \
+        PyGILState_Release(callback_gstate_); \
     }
 
 static PyObject*
@@ -112,7 +119,8 @@ new(PyTypeObject *type, PyObject *args, PyObject UNUSED *kwds) {
         self->test_child = test_child; Py_INCREF(test_child);
         self->cursor = alloc_cursor();
         self->color_profile = alloc_color_profile();
-        self->main_linebuf = alloc_linebuf(lines, columns); self->alt_linebuf = alloc_linebuf(lines, columns);
+        // the alternate screen is only allocated if the window ever switches to it
+        self->main_linebuf = alloc_linebuf(lines, columns); self->alt_linebuf = NULL;
         self->linebuf = self->main_linebuf;
         self->historybuf = alloc_historybuf(MAX(scrollback, lines), columns, OPT(scrollback_pager_history_size));
         self->main_grman = grman_alloc();
@@ -124,12 +132,13 @@ new(PyTypeObject *type, PyObject *args, PyObject UNUSED *kwds) {
         self->disable_ligatures = OPT(disable_ligatures);
         self->main_tabstops = PyMem_Calloc(2 * self->columns, sizeof(bool));
         if (
-            self->cursor == NULL || self->main_linebuf == NULL || self->alt_linebuf == NULL ||
+            self->cursor == NULL || self->main_linebuf == NULL ||
             self->main_tabstops == NULL || self->historybuf == NULL || self->main_grman == NULL ||
             self->alt_grman == NULL || self->color_profile == NULL
         ) {
             Py_CLEAR(self); return NULL;
         }
+        self->main_grman->window_id = self->window_id; self->alt_grman->window_id = self->window_id;
         self->alt_tabstops = self->main_tabstops + self->columns;
         self->tabstops = self->main_tabstops;
         init_tabstops(self->main_tabstops, self->columns);
@@ -144,6 +153,7 @@ new(PyTypeObject *type, PyObject *args, PyObject UNUSED *kwds) {
 
 static void deactivate_overlay_line(Screen *self);
 static inline Line* range_line_(Screen *self, int y);
+static void invalidate_word_cache(Screen *self);
 
 void
 screen_reset(Screen *self) {
@@ -184,17 +194,19 @@ screen_dirty_sprite_positions(Screen *self) {
     self->is_dirty = true;
     for (index_type i = 0; i < self->lines; i++) {
         linebuf_mark_line_dirty(self->main_linebuf, i);
-        linebuf_mark_line_dirty(self->alt_linebuf, i);
+        if (self->alt_linebuf) linebuf_mark_line_dirty(self->alt_linebuf, i);
     }
     for (index_type i = 0; i < self->historybuf->count; i++) historybuf_mark_line_dirty(self->historybuf, i);
 }
 
 static inline HistoryBuf*
-realloc_hb(HistoryBuf *old, unsigned int lines, unsigned int columns, ANSIBuf *as_ansi_buf) {
+realloc_hb(HistoryBuf *old, unsigned int lines, unsigned int columns) {
+    if (columns == old->xnum && lines == old->ynum) { Py_INCREF(old); return old; }
     HistoryBuf *ans = alloc_historybuf(lines, columns, 0);
     if (ans == NULL) { PyErr_NoMemory(); return NULL; }
     ans->pagerhist = old->pagerhist; old->pagerhist = NULL;
-    historybuf_rewrap(old, ans, as_ansi_buf);
+    // rewrapping the scrollback is done lazily, on first access
+    historybuf_defer_rewrap(old, ans);
     return ans;
 }
 
@@ -224,9 +236,11 @@ screen_resize(Screen *self, unsigned int lines, unsigned int columns) {
     if (!init_overlay_line(self, columns)) return false;
 
     // Resize main linebuf
-    HistoryBuf *nh = realloc_hb(self->historybuf, self->historybuf->ynum, columns, &self->as_ansi_buf);
+    HistoryBuf *nh = realloc_hb(self->historybuf, self->historybuf->ynum, columns);
     if (nh == NULL) return false;
     Py_CLEAR(self->historybuf); self->historybuf = nh;
+    // when the user is viewing the scrollback it has to be rewrapped now
+    if (self->scrolled_by) historybuf_resolve_deferred_rewrap(self->historybuf);
     index_type x = self->cursor->x, y = self->cursor->y;
     LineBuf *n = realloc_lb(self->main_linebuf, lines, columns, &num_content_lines_before, &num_content_lines_after, self->historybuf, &x, &y, &self->as_ansi_buf);
     if (n == NULL) return false;
@@ -234,12 +248,14 @@ screen_resize(Screen *self, unsigned int lines, unsigned int columns) {
     if (is_main) setup_cursor();
     grman_resize(self->main_grman, self->lines, lines, self->columns, columns);
 
-    // Resize alt linebuf
-    x = self->cursor->x, y = self->cursor->y;
-    n = realloc_lb(self->alt_linebuf, lines, columns, &num_content_lines_before, &num_content_lines_after, NULL, &x, &y, &self->as_ansi_buf);
-    if (n == NULL) return false;
-    Py_CLEAR(self->alt_linebuf); self->alt_linebuf = n;
-    if (!is_main) setup_cursor();
+    // Resize alt linebuf, if it exists
+    if (self->alt_linebuf) {
+        x = self->cursor->x, y = self->cursor->y;
+        n = realloc_lb(self->alt_linebuf, lines, columns, &num_content_lines_before, &num_content_lines_after, NULL, &x, &y, &self->as_ansi_buf);
+        if (n == NULL) return false;
+        Py_CLEAR(self->alt_linebuf); self->alt_linebuf = n;
+        if (!is_main) setup_cursor();
+    }
     grman_resize(self->alt_grman, self->lines, lines, self->columns, columns);
 #undef setup_cursor
 
@@ -283,6 +299,8 @@ reset_callbacks(Screen *self, PyObject *a UNUSED) {
     Py_RETURN_NONE;
 }
 
+static void truecolor_table_reset(Screen *self);
+
 static void
 dealloc(Screen* self) {
     pthread_mutex_destroy(&self->read_buf_lock);
@@ -290,22 +308,31 @@ dealloc(Screen* self) {
     Py_CLEAR(self->main_grman);
     Py_CLEAR(self->alt_grman);
     PyMem_RawFree(self->write_buf);
+    free(self->spare_read_buf);
     Py_CLEAR(self->callbacks);
     Py_CLEAR(self->test_child);
+    Py_CLEAR(self->pending_title);
+    Py_CLEAR(self->last_reported_title);
     Py_CLEAR(self->cursor);
     Py_CLEAR(self->main_linebuf);
     Py_CLEAR(self->alt_linebuf);
     Py_CLEAR(self->historybuf);
     Py_CLEAR(self->color_profile);
     Py_CLEAR(self->marker);
+    PyMem_Free(self->text_marker.needle);
     PyMem_Free(self->overlay_line.cpu_cells);
     PyMem_Free(self->overlay_line.gpu_cells);
     PyMem_Free(self->main_tabstops);
     free(self->pending_mode.buf);
     free(self->selections.items);
     free(self->url_ranges.items);
+    free(self->word_cache.bits);
+    free(self->word_cache.line_built);
+    free(self->selection_map.buf);
     free_hyperlink_pool(self->hyperlink_pool);
     free(self->as_ansi_buf.buf);
+    truecolor_table_reset(self);
+    free(self->truecolor_table.triples);
     Py_TYPE(self)->tp_free((PyObject*)self);
 } // }}}
 
@@ -409,8 +436,10 @@ remap_hyperlink_ids(Screen *self, hyperlink_id_type *map) {
         }
     }
     LineBuf *second = self->linebuf, *first = second == self->main_linebuf ? self->alt_linebuf : self->main_linebuf;
-    for (index_type i = 0; i < self->lines * self->columns; i++) {
-        PROCESS_CELL(first->cpu_cell_buf[i]);
+    if (first) {
+        for (index_type i = 0; i < self->lines * self->columns; i++) {
+            PROCESS_CELL(first->cpu_cell_buf[i]);
+        }
     }
     for (index_type i = 0; i < self->lines * self->columns; i++) {
         PROCESS_CELL(second->cpu_cell_buf[i]);
@@ -437,7 +466,7 @@ draw_second_flag_codepoint(Screen *self, char_type ch) {
 
     linebuf_init_line(self->linebuf, ypos);
     CPUCell *cell = self->linebuf->line->cpu_cells + xpos;
-    if (!is_flag_pair(cell->ch, ch) || cell->cc_idx[0]) return false;
+    if (!is_flag_pair(cell->ch, ch) || cell->cc_idx) return false;
     line_add_combining_char(self->linebuf->line, ch, xpos);
     self->is_dirty = true;
     if (selection_has_screen_line(&self->selections, ypos)) clear_selection(&self->selections);
@@ -479,7 +508,7 @@ draw_combining_char(Screen *self, char_type ch) {
         if (ch == 0xfe0f) {  // emoji presentation variation marker makes default text presentation emoji (narrow emoji) into wide emoji
             CPUCell *cpu_cell = self->linebuf->line->cpu_cells + xpos;
             GPUCell *gpu_cell = self->linebuf->line->gpu_cells + xpos;
-            if ((gpu_cell->attrs & WIDTH_MASK) != 2 && cpu_cell->cc_idx[0] == VS16 && is_emoji_presentation_base(cpu_cell->ch)) {
+            if ((gpu_cell->attrs & WIDTH_MASK) != 2 && first_combining_mark(cpu_cell->cc_idx) == VS16 && is_emoji_presentation_base(cpu_cell->ch)) {
                 if (self->cursor->x <= self->columns - 1) line_set_char(self->linebuf->line, self->cursor->x, 0, 0, self->cursor, self->active_hyperlink_id);
                 gpu_cell->attrs = (gpu_cell->attrs & !WIDTH_MASK) | 2;
                 if (xpos == self->columns - 1) move_widened_char(self, cpu_cell, gpu_cell, xpos, ypos);
@@ -495,7 +524,7 @@ draw_combining_char(Screen *self, char_type ch) {
                 gpu_cell = self->linebuf->line->gpu_cells + xpos;
             }
 
-            if ((gpu_cell->attrs & WIDTH_MASK) == 2 && cpu_cell->cc_idx[0] == VS15 && is_emoji_presentation_base(cpu_cell->ch)) {
+            if ((gpu_cell->attrs & WIDTH_MASK) == 2 && first_combining_mark(cpu_cell->cc_idx) == VS15 && is_emoji_presentation_base(cpu_cell->ch)) {
                 gpu_cell->attrs = (gpu_cell->attrs & !WIDTH_MASK) | 1;
             }
         }
@@ -548,6 +577,69 @@ screen_draw(Screen *self, uint32_t och) {
     linebuf_mark_line_dirty(self->linebuf, self->cursor->y);
 }
 
+extern uint32_t *latin1_charset;  // the identity translation table
+
+static inline bool
+is_simple_char(char_type ch) {
+    // A char that is width 1 and needs none of the special handling in
+    // screen_draw(), so it can be blasted into the cell arrays directly
+    if (LIKELY(' ' <= ch && ch < DEL)) return true;
+    if (ch < 0xa0) return false;
+    return !(unicode_classification(ch) & (UNICODE_CATEGORY_IGNORED | UNICODE_CATEGORY_M)) && !is_flag_codepoint(ch) && wcwidth_std(ch) == 1;
+}
+
+void
+screen_draw_run(Screen *self, const char_type *chars, size_t num) {
+    // Draw a run of text with one bounds check, attribute evaluation and
+    // dirty marking per line of output instead of per character. Characters
+    // that need the full machinery (combining and wide chars, insert mode,
+    // charset remappings that produce them) fall back to screen_draw().
+    if (!num) return;
+    if (!self->has_activity_since_last_focus && !self->has_focus) {
+        self->has_activity_since_last_focus = true;
+    }
+    // charset designations arrive via escape codes, so the active table
+    // cannot change within a run. The overwhelmingly common case is the
+    // identity table, hoisting the test out of the loop turns it into a
+    // straight copy with no per-character table lookup
+    const bool translate_chars = self->g_charset != latin1_charset;
+    size_t i = 0;
+    while (i < num) {
+        if (UNLIKELY(self->modes.mIRM || self->cursor->x >= self->columns)) {
+            // insert mode or a pending wrap, let screen_draw() deal with it
+            screen_draw(self, chars[i++]);
+            continue;
+        }
+        linebuf_init_line(self->linebuf, self->cursor->y);
+        Line *line = self->linebuf->line;
+        const index_type avail = self->columns - self->cursor->x;
+        GPUCell g = {
+            .attrs = CURSOR_TO_ATTRS(self->cursor, 1),
+            .fg = self->cursor->fg & COL_MASK, .bg = self->cursor->bg & COL_MASK,
+            .decoration_fg = self->cursor->decoration_fg & COL_MASK
+        };
+        CPUCell *cpu_cells = line->cpu_cells + self->cursor->x;
+        GPUCell *gpu_cells = line->gpu_cells + self->cursor->x;
+        index_type run = 0;
+        while (run < avail && i + run < num) {
+            char_type ch = chars[i + run];
+            if (UNLIKELY(translate_chars) && ch < 256) ch = self->g_charset[ch];
+            if (UNLIKELY(!is_simple_char(ch))) break;
+            cpu_cells[run].ch = ch;
+            cpu_cells[run].hyperlink_id = self->active_hyperlink_id;
+            cpu_cells[run].cc_idx = 0;
+            gpu_cells[run] = g;
+            run++;
+        }
+        if (run) {
+            self->cursor->x += run; i += run;
+            self->is_dirty = true;
+            if (selection_has_screen_line(&self->selections, self->cursor->y)) clear_selection(&self->selections);
+            linebuf_mark_line_dirty(self->linebuf, self->cursor->y);
+        } else screen_draw(self, chars[i++]);  // not a simple char
+    }
+}
+
 void
 screen_draw_overlay_text(Screen *self, const char *utf8_text) {
     if (self->overlay_line.is_active) deactivate_overlay_line(self);
@@ -614,14 +706,21 @@ select_graphic_rendition(Screen *self, unsigned int *params, unsigned int count,
             region.top += self->margin_top; region.bottom += self->margin_top;
         }
         region.left -= 1; region.top -= 1; region.right -= 1; region.bottom -= 1;  // switch to zero based indexing
+        // compute the attribute transform once and sweep it over the region,
+        // instead of re-walking the params for every line. Only the touched
+        // lines are marked dirty, so just the region is re-uploaded.
+        SGRTransform t;
+        sgr_transform_from_params(&t, params, count);
         if (self->modes.mDECSACE) {
             index_type x = MIN(region.left, self->columns - 1);
             index_type num = region.right >= x ? region.right - x + 1 : 0;
             num = MIN(num, self->columns - x);
             for (index_type y = region.top; y < MIN(region.bottom + 1, self->lines); y++) {
                 linebuf_init_line(self->linebuf, y);
-                apply_sgr_to_cells(self->linebuf->line->gpu_cells + x, num, params, count);
+                sgr_transform_apply(&t, self->linebuf->line->gpu_cells + x, num);
+                linebuf_mark_line_dirty(self->linebuf, y);
             }
+            self->is_dirty = true;
         } else {
             index_type x, num;
             for (index_type y = region.top; y < MIN(region.bottom + 1, self->lines); y++) {
@@ -629,15 +728,19 @@ select_graphic_rendition(Screen *self, unsigned int *params, unsigned int count,
                 else if (y == region.bottom) { x = 0; num = MIN(region.right + 1, self->columns); }
                 else { x = 0; num = self->columns; }
                 linebuf_init_line(self->linebuf, y);
-                apply_sgr_to_cells(self->linebuf->line->gpu_cells + x, num, params, count);
+                sgr_transform_apply(&t, self->linebuf->line->gpu_cells + x, num);
+                linebuf_mark_line_dirty(self->linebuf, y);
             }
+            self->is_dirty = true;
         }
     } else cursor_from_sgr(self->cursor, params, count);
 }
 
 static inline void
 write_to_test_child(Screen *self, const char *data, size_t sz) {
+    PyGILState_STATE gstate = PyGILState_Ensure();
     PyObject *r = PyObject_CallMethod(self->test_child, "write", "y#", data, sz); if (r == NULL) PyErr_Print(); Py_CLEAR(r);
+    PyGILState_Release(gstate);
 }
 
 static inline void
@@ -646,6 +749,11 @@ write_to_child(Screen *self, const char *data, size_t sz) {
     if (self->test_child != Py_None) { write_to_test_child(self, data, sz); }
 }
 
+void
+write_data_to_child(Screen *self, const char *data, size_t sz) {
+    write_to_child(self, data, sz);
+}
+
 void
 write_escape_code_to_child(Screen *self, unsigned char which, const char *data) {
     const char *prefix, *suffix = self->modes.eight_bit_controls ? "\x9c" : "\033\\";
@@ -710,7 +818,18 @@ screen_toggle_screen_buffer(Screen *self, bool save_cursor, bool clear_alt_scree
     self->active_hyperlink_id = 0;
     grman_clear(self->alt_grman, true, self->cell_size);  // always clear the alt buffer graphics to free up resources, since it has to be cleared when switching back to it anyway
     if (to_alt) {
-        if (clear_alt_screen) linebuf_clear(self->alt_linebuf, BLANK_CHAR);
+        if (self->alt_linebuf == NULL) {
+            // we are reached from the GIL-free parse path and constructing a
+            // LineBuf is Python API, so take the GIL for just the allocation
+            PyGILState_STATE gstate = PyGILState_Ensure();
+            self->alt_linebuf = alloc_linebuf(self->lines, self->columns);
+            if (self->alt_linebuf == NULL && PyErr_Occurred()) PyErr_Print();
+            PyGILState_Release(gstate);
+            if (self->alt_linebuf == NULL) {
+                log_error("Out of memory allocating alternate screen, ignoring switch to it");
+                return;
+            }
+        } else if (clear_alt_screen) linebuf_clear(self->alt_linebuf, BLANK_CHAR);
         if (save_cursor) screen_save_cursor(self);
         self->linebuf = self->alt_linebuf;
         self->tabstops = self->alt_tabstops;
@@ -722,12 +841,32 @@ screen_toggle_screen_buffer(Screen *self, bool save_cursor, bool clear_alt_scree
         self->tabstops = self->main_tabstops;
         if (save_cursor) screen_restore_cursor(self);
         self->grman = self->main_grman;
+        // an alt screen that is cleared on entry anyway need not be kept
+        // alive while unused, see screen_free_stale_alt_linebuf()
+        self->alt_screen_exited_at = clear_alt_screen ? monotonic() : 0;
     }
     screen_history_scroll(self, SCROLL_FULL, false);
     self->is_dirty = true;
+    // the viewport now shows a different buffer, force a full cell data upload
+    self->scroll_changed = true;
     clear_selection(&self->selections);
 }
 
+void
+screen_free_stale_alt_linebuf(Screen *self, monotonic_t now) {
+    // Most windows never use the alternate screen and those that do (pagers,
+    // editors) spend most of their life outside it, so its cell arrays are
+    // freed again once it has been unused for a while. Only alt screens that
+    // would be cleared on re-entry anyway are eligible, contents entered via
+    // modes 47/1047 must survive an exit/re-entry cycle.
+#define ALT_SCREEN_LINGER_TIME s_double_to_monotonic_t(30.0)
+    if (self->alt_linebuf == NULL || self->linebuf == self->alt_linebuf || !self->alt_screen_exited_at) return;
+    if (now - self->alt_screen_exited_at < ALT_SCREEN_LINGER_TIME) return;
+    Py_CLEAR(self->alt_linebuf);
+    self->alt_screen_exited_at = 0;
+#undef ALT_SCREEN_LINGER_TIME
+}
+
 void screen_normal_keypad_mode(Screen UNUSED *self) {} // Not implemented as this is handled by the GUI
 void screen_alternate_keypad_mode(Screen UNUSED *self) {}  // Not implemented as this is handled by the GUI
 
@@ -874,10 +1013,10 @@ screen_tab(Screen *self) {
             if (ok) {
                 for (combining_type i = 0; i < diff; i++) {
                     CPUCell *c = cpu_cell + i;
-                    c->ch = ' '; zero_at_ptr_count(c->cc_idx, arraysz(c->cc_idx));
+                    c->ch = ' '; c->cc_idx = 0;
                 }
                 cpu_cell->ch = '\t';
-                cpu_cell->cc_idx[0] = diff;
+                cpu_cell->cc_idx = diff;
             }
         }
         self->cursor->x = found;
@@ -970,6 +1109,7 @@ screen_cursor_to_column(Screen *self, unsigned int column) {
 
 static inline void
 index_selection(const Screen *self, Selections *selections, bool up) {
+    if (selections->count) selections->generation++;
     for (size_t i = 0; i < selections->count; i++) {
         Selection *s = selections->items + i;
         if (!is_selection_empty(s)) {
@@ -997,53 +1137,47 @@ index_selection(const Screen *self, Selections *selections, bool up) {
     grman_scroll_images(self->grman, &s, self->cell_size); \
 }
 
-#define INDEX_UP \
-    if (self->overlay_line.is_active) deactivate_overlay_line(self); \
-    linebuf_index(self->linebuf, top, bottom); \
-    INDEX_GRAPHICS(-1) \
-    if (self->linebuf == self->main_linebuf && self->margin_top == 0) { \
-        /* Only add to history when no top margin has been set */ \
-        linebuf_init_line(self->linebuf, bottom); \
-        historybuf_add_line(self->historybuf, self->linebuf->line, &self->as_ansi_buf); \
-        self->history_line_added_count++; \
-    } \
-    linebuf_clear_line(self->linebuf, bottom); \
-    self->is_dirty = true; \
-    index_selection(self, &self->selections, true);
-
 void
 screen_index(Screen *self) {
     // Move cursor down one line, scrolling screen if needed
-    unsigned int top = self->margin_top, bottom = self->margin_bottom;
-    if (self->cursor->y == bottom) {
-        INDEX_UP;
+    if (self->cursor->y == self->margin_bottom) {
+        screen_scroll(self, 1);
     } else screen_cursor_down(self, 1);
 }
 
 void
 screen_scroll(Screen *self, unsigned int count) {
-    // Scroll the screen up by count lines, not moving the cursor
+    // Scroll the screen up by count lines, not moving the cursor. Rather
+    // than rotating the region once per line, rotate it by up to a full
+    // region in a single pass.
     unsigned int top = self->margin_top, bottom = self->margin_bottom;
+    if (self->overlay_line.is_active) deactivate_overlay_line(self);
+    const unsigned int num = bottom + 1 - top;
     while (count > 0) {
-        count--;
-        INDEX_UP;
+        const unsigned int n = MIN(count, num);
+        count -= n;
+        if (self->linebuf == self->main_linebuf && self->margin_top == 0) {
+            // Only add to history when no top margin has been set
+            for (unsigned int i = 0; i < n; i++) {
+                linebuf_init_line(self->linebuf, top + i);
+                historybuf_add_line(self->historybuf, self->linebuf->line, &self->as_ansi_buf);
+                self->history_line_added_count++;
+            }
+        }
+        linebuf_index_n(self->linebuf, top, bottom, n);
+        for (unsigned int i = 0; i < n; i++) linebuf_clear_line(self->linebuf, bottom - i);
+        INDEX_GRAPHICS(-(int32_t)n)
+        self->lines_scrolled_since_render += n;
+        self->is_dirty = true;
+        for (unsigned int i = 0; i < n; i++) index_selection(self, &self->selections, true);
     }
 }
 
-#define INDEX_DOWN \
-    if (self->overlay_line.is_active) deactivate_overlay_line(self); \
-    linebuf_reverse_index(self->linebuf, top, bottom); \
-    linebuf_clear_line(self->linebuf, top); \
-    INDEX_GRAPHICS(1) \
-    self->is_dirty = true; \
-    index_selection(self, &self->selections, false);
-
 void
 screen_reverse_index(Screen *self) {
     // Move cursor up one line, scrolling screen if needed
-    unsigned int top = self->margin_top, bottom = self->margin_bottom;
-    if (self->cursor->y == top) {
-        INDEX_DOWN;
+    if (self->cursor->y == self->margin_top) {
+        screen_reverse_scroll(self, 1);
     } else screen_cursor_up(self, 1, false, -1);
 }
 
@@ -1052,9 +1186,16 @@ screen_reverse_scroll(Screen *self, unsigned int count) {
     // Scroll the screen down by count lines, not moving the cursor
     count = MIN(self->lines, count);
     unsigned int top = self->margin_top, bottom = self->margin_bottom;
+    if (self->overlay_line.is_active) deactivate_overlay_line(self);
+    const unsigned int num = bottom + 1 - top;
     while (count > 0) {
-        count--;
-        INDEX_DOWN;
+        const unsigned int n = MIN(count, num);
+        count -= n;
+        linebuf_reverse_index_n(self->linebuf, top, bottom, n);
+        for (unsigned int i = 0; i < n; i++) linebuf_clear_line(self->linebuf, top + i);
+        INDEX_GRAPHICS((int32_t)n)
+        self->is_dirty = true;
+        for (unsigned int i = 0; i < n; i++) index_selection(self, &self->selections, false);
     }
 }
 
@@ -1391,7 +1532,7 @@ bool
 screen_invert_colors(Screen *self) {
     bool inverted = false;
     if (self->start_visual_bell_at > 0) {
-        if (monotonic() - self->start_visual_bell_at <= OPT(visual_bell_duration)) inverted = true;
+        if (coarse_monotonic() - self->start_visual_bell_at <= OPT(visual_bell_duration)) inverted = true;
         else self->start_visual_bell_at = 0;
     }
     if (self->modes.mDECSCNM) inverted = inverted ? false : true;
@@ -1400,8 +1541,20 @@ screen_invert_colors(Screen *self) {
 
 void
 screen_bell(Screen *self) {
+    // a runaway child dumping a binary file emits thousands of BEL bytes a
+    // second, so the full bell path of attention request, sound playback and
+    // Python callback runs at most once per cooldown interval. The visual
+    // bell timestamp is still refreshed every time, extending the inversion
+    // for as long as the storm lasts, and suppressed bells are counted so the
+    // activity indicator does not miss them
+    monotonic_t now = coarse_monotonic();
+    if (OPT(visual_bell_duration) > 0.0f) self->start_visual_bell_at = now;
+    if (self->last_bell_at && now - self->last_bell_at < ms_to_monotonic_t(50ll)) {
+        self->suppressed_bells++;
+        return;
+    }
+    self->last_bell_at = now;
     request_window_attention(self->window_id, OPT(enable_audio_bell));
-    if (OPT(visual_bell_duration) > 0.0f) self->start_visual_bell_at = monotonic();
     CALLBACK("on_bell", NULL);
 }
 
@@ -1558,6 +1711,27 @@ screen_set_cursor(Screen *self, unsigned int mode, uint8_t secondary) {
 
 void
 set_title(Screen *self, PyObject *title) {
+    // shells that set the title per prompt, or even per keystroke, generate a
+    // steady stream of updates, most of them identical. Identical ones are
+    // dropped here without crossing into Python, distinct ones are stashed
+    // and reported at most once per frame, last writer wins, from
+    // screen_flush_pending_title()
+    PyObject *current = self->pending_title ? self->pending_title : self->last_reported_title;
+    if (current) {
+        int eq = PyObject_RichCompareBool(title, current, Py_EQ);
+        if (eq == 1) return;
+        if (eq == -1) PyErr_Clear();
+    }
+    Py_INCREF(title);
+    Py_XSETREF(self->pending_title, title);
+}
+
+void
+screen_flush_pending_title(Screen *self) {
+    if (!self->pending_title) return;
+    PyObject *title = self->pending_title;
+    self->pending_title = NULL;
+    Py_XSETREF(self->last_reported_title, title);
     CALLBACK("title_changed", "O", title);
 }
 
@@ -1578,8 +1752,8 @@ set_dynamic_color(Screen *self, unsigned int code, PyObject *color) {
 }
 
 void
-clipboard_control(Screen *self, PyObject *data) {
-    CALLBACK("clipboard_control", "O", data);
+clipboard_control(Screen *self, PyObject *data, bool is_partial) {
+    CALLBACK("clipboard_control", "OO", data, is_partial ? Py_True : Py_False);
 }
 
 void
@@ -1659,55 +1833,223 @@ screen_request_capabilities(Screen *self, char c, PyObject *q) {
 // }}}
 
 // Rendering {{{
+
+// Packed cell colors: a palette color fits in 10 bits, the low byte holding
+// the payload and bits 8-9 the color type, mirroring the cell color encoding.
+// Truecolor does not fit and is diverted to the per-screen side table.
+#define TRUECOLOR_ESCAPE 0x80000000u
+#define TRUECOLOR_TABLE_MAX_ENTRIES (1u << 16)
+
+typedef struct {
+    uint32_t key[3];
+    uint32_t index;
+    UT_hash_handle hh;
+} TrueColorLookupEntry;
+
+static void
+truecolor_table_reset(Screen *self) {
+    TrueColorLookupEntry *head = self->truecolor_table.lookup, *s, *tmp;
+    HASH_ITER(hh, head, s, tmp) {
+        HASH_DEL(head, s);
+        free(s);
+    }
+    self->truecolor_table.lookup = NULL;
+    self->truecolor_table.count = 0;
+    self->truecolor_table.generation++;
+    self->truecolor_table.needs_reset = false;
+}
+
+static uint32_t
+truecolor_table_index(Screen *self, const GPUCell *c) {
+    uint32_t key[3] = {c->fg, c->bg, c->decoration_fg};
+    TrueColorLookupEntry *head = self->truecolor_table.lookup, *e = NULL;
+    HASH_FIND(hh, head, key, sizeof(key), e);
+    if (e) return e->index;
+    if (self->truecolor_table.count >= TRUECOLOR_TABLE_MAX_ENTRIES) {
+        // pathological screen with more distinct truecolor triples than the
+        // table holds, reuse the first entry for this frame and rebuild the
+        // table from scratch on the next full upload
+        self->truecolor_table.needs_reset = true;
+        return 0;
+    }
+    if (self->truecolor_table.count >= self->truecolor_table.capacity) {
+        uint32_t capacity = MAX(256u, 2 * self->truecolor_table.capacity);
+        uint32_t *triples = realloc(self->truecolor_table.triples, 3 * sizeof(uint32_t) * capacity);
+        if (!triples) return 0;
+        self->truecolor_table.triples = triples; self->truecolor_table.capacity = capacity;
+    }
+    e = calloc(1, sizeof(TrueColorLookupEntry));
+    if (!e) return 0;
+    memcpy(e->key, key, sizeof(key));
+    e->index = self->truecolor_table.count++;
+    memcpy(self->truecolor_table.triples + 3 * e->index, key, sizeof(key));
+    HASH_ADD(hh, head, key, sizeof(key), e);
+    self->truecolor_table.lookup = head;
+    self->truecolor_table.generation++;
+    return e->index;
+}
+
+static inline uint32_t
+pack_cell_color(color_type c) {
+    switch (c & 0xff) {
+        case 1: return 0x100u | ((c >> 8) & 0xff);  // palette color
+        case 2: return TRUECOLOR_ESCAPE;
+        default: return 0;  // default color
+    }
+}
+
+void
+screen_pack_cells(Screen *self, const GPUCell *src, PackedGPUCell *dest, index_type count) {
+    for (index_type i = 0; i < count; i++) {
+        const GPUCell *c = src + i;
+        PackedGPUCell *p = dest + i;
+        p->sprite_x = c->sprite_x; p->sprite_y = c->sprite_y; p->sprite_z = c->sprite_z;
+        p->attrs = c->attrs;
+        uint32_t fg = pack_cell_color(c->fg), bg = pack_cell_color(c->bg), decoration_fg = pack_cell_color(c->decoration_fg);
+        if ((fg | bg | decoration_fg) & TRUECOLOR_ESCAPE) p->colors = TRUECOLOR_ESCAPE | truecolor_table_index(self, c);
+        else p->colors = fg | (bg << 10) | (decoration_fg << 20);
+    }
+}
+
 static inline void
-update_line_data(Line *line, unsigned int dest_y, uint8_t *data) {
-    size_t base = sizeof(GPUCell) * dest_y * line->xnum;
-    memcpy(data + base, line->gpu_cells, line->xnum * sizeof(GPUCell));
+update_line_data(Screen *self, Line *line, unsigned int dest_y, uint8_t *data) {
+    screen_pack_cells(self, line->gpu_cells, (PackedGPUCell*)data + (size_t)dest_y * line->xnum, line->xnum);
 }
 
 
 static inline void
 screen_reset_dirty(Screen *self) {
+    if (self->is_dirty) invalidate_word_cache(self);
     self->is_dirty = false;
     self->history_line_added_count = 0;
 }
 
 static inline bool
 screen_has_marker(Screen *self) {
-    return self->marker != NULL;
+    return self->marker != NULL || self->text_marker.needle != NULL;
+}
+
+static inline void
+screen_apply_marker(Screen *self, Line *line) {
+    if (self->text_marker.needle) mark_text_in_cells(self->text_marker.needle, self->text_marker.needle_len, self->text_marker.mark, line);
+    else mark_text_in_line(self->marker, line);
 }
 
 
 void
-screen_update_cell_data(Screen *self, void *address, FONTS_DATA_HANDLE fonts_data, bool cursor_has_moved) {
+screen_prepare_cell_data(Screen *self, FONTS_DATA_HANDLE fonts_data, bool cursor_has_moved) {
+    // the serial phase of a full cell data update: glyph rasterization
+    // touches the shared font caches and uploads sprites to the GPU, so it
+    // must run on the main thread. The packing of the prepared cells is pure
+    // per screen CPU work and is done separately, possibly on a worker
+    // thread, by screen_pack_cell_data()
     unsigned int history_line_added_count = self->history_line_added_count;
     index_type lnum;
-    bool was_dirty = self->is_dirty;
+    bool was_dirty = self->is_dirty, rasterization_deferred = false;
+    // a full upload re-packs every cell, so stale side table indices cannot survive it
+    if (self->truecolor_table.needs_reset) truecolor_table_reset(self);
     if (self->scrolled_by) self->scrolled_by = MIN(self->scrolled_by + history_line_added_count, self->historybuf->count);
     screen_reset_dirty(self);
     self->scroll_changed = false;
+    // More than a few screenfuls scrolled past since the last frame means
+    // the intermediate frame is a blur: render it from cached per codepoint
+    // sprites without shaping. The lines are left dirty below so the
+    // resting screenful gets a full-shaping pass once the flood subsides.
+    bool degraded_shaping = !self->scrolled_by && self->lines_scrolled_since_render > 3 * self->lines;
+    self->lines_scrolled_since_render = 0;
+    set_degraded_text_shaping(degraded_shaping);
+    begin_frame_glyph_rasterization();
     for (index_type y = 0; y < MIN(self->lines, self->scrolled_by); y++) {
         lnum = self->scrolled_by - 1 - y;
         historybuf_init_line(self->historybuf, lnum, self->historybuf->line);
         if (self->historybuf->line->has_dirty_text) {
-            render_line(fonts_data, self->historybuf->line, lnum, self->cursor, self->disable_ligatures);
-            if (screen_has_marker(self)) mark_text_in_line(self->marker, self->historybuf->line);
-            historybuf_mark_line_clean(self->historybuf, lnum);
+            if (render_line(fonts_data, self->historybuf->line, lnum, self->cursor, self->disable_ligatures)) historybuf_mark_line_clean(self->historybuf, lnum);
+            else rasterization_deferred = true;
+            if (screen_has_marker(self)) screen_apply_marker(self, self->historybuf->line);
         }
-        update_line_data(self->historybuf->line, y, address);
     }
     for (index_type y = self->scrolled_by; y < self->lines; y++) {
         lnum = y - self->scrolled_by;
         linebuf_init_line(self->linebuf, lnum);
         if (self->linebuf->line->has_dirty_text ||
             (cursor_has_moved && (self->cursor->y == lnum || self->last_rendered.cursor_y == lnum))) {
-            render_line(fonts_data, self->linebuf->line, lnum, self->cursor, self->disable_ligatures);
-            if (self->linebuf->line->has_dirty_text && screen_has_marker(self)) mark_text_in_line(self->marker, self->linebuf->line);
+            bool complete = render_line(fonts_data, self->linebuf->line, lnum, self->cursor, self->disable_ligatures) && !degraded_shaping;
+            if (self->linebuf->line->has_dirty_text && screen_has_marker(self)) screen_apply_marker(self, self->linebuf->line);
 
-            linebuf_mark_line_clean(self->linebuf, lnum);
+            if (complete) linebuf_mark_line_clean(self->linebuf, lnum);
+            else rasterization_deferred = true;
         }
-        update_line_data(self->linebuf->line, y, address);
     }
+    end_frame_glyph_rasterization();
+    set_degraded_text_shaping(false);
+    if (was_dirty) clear_selection(&self->url_ranges);
+    if (rasterization_deferred) {
+        // lines with deferred glyphs, or rendered without shaping during a
+        // fast-scroll flood, were left dirty: schedule another frame to
+        // finish them
+        self->is_dirty = true;
+        wakeup_main_loop();
+    }
+}
+
+void
+screen_pack_cell_data(Screen *self, void *address) {
+    // pack every row into the mapped GPU buffer. Touches only this screen's
+    // state, no GL and no Python, so packs for different screens can run
+    // concurrently on worker threads -- but only when not scrolled back:
+    // reading history lines can decompress cold segments and sweep the
+    // scrollback memory budget, which is main thread only work
+    index_type lnum;
+    for (index_type y = 0; y < MIN(self->lines, self->scrolled_by); y++) {
+        lnum = self->scrolled_by - 1 - y;
+        historybuf_init_line(self->historybuf, lnum, self->historybuf->line);
+        update_line_data(self, self->historybuf->line, y, address);
+    }
+    for (index_type y = self->scrolled_by; y < self->lines; y++) {
+        lnum = y - self->scrolled_by;
+        linebuf_init_line(self->linebuf, lnum);
+        update_line_data(self, self->linebuf->line, y, address);
+        // when not scrolled, the GPU buffer now matches the line buffer rows
+        if (!self->scrolled_by) linebuf_mark_line_gpu_clean(self->linebuf, lnum);
+    }
+}
+
+void
+screen_update_cell_data(Screen *self, void *address, FONTS_DATA_HANDLE fonts_data, bool cursor_has_moved) {
+    screen_prepare_cell_data(self, fonts_data, cursor_has_moved);
+    screen_pack_cell_data(self, address);
+}
+
+bool
+screen_update_line_data_if_dirty(Screen *self, index_type lnum, FONTS_DATA_HANDLE fonts_data, PackedGPUCell *dest) {
+    if (!linebuf_line_is_dirty(self->linebuf, lnum)) return false;
+    linebuf_init_line(self->linebuf, lnum);
+    bool complete = true;
+    if (self->linebuf->line->has_dirty_text) {
+        // this path runs without a rasterization budget, so deferred glyphs
+        // from the previous frame are finished here
+        complete = render_line(fonts_data, self->linebuf->line, lnum, self->cursor, self->disable_ligatures);
+        if (screen_has_marker(self)) screen_apply_marker(self, self->linebuf->line);
+    }
+    if (complete) linebuf_mark_line_clean(self->linebuf, lnum);
+    else self->is_dirty = true;
+    screen_pack_cells(self, self->linebuf->line->gpu_cells, dest, self->linebuf->line->xnum);
+    return true;
+}
+
+// With disable_ligatures=cursor only the lines the cursor left and entered
+// need re-shaping, mark them so the dirty row upload path picks them up
+void
+screen_mark_cursor_dirty_lines(Screen *self) {
+    if (self->cursor->y < self->lines) linebuf_mark_line_dirty(self->linebuf, self->cursor->y);
+    if (self->last_rendered.cursor_y < self->lines && self->last_rendered.cursor_y != self->cursor->y)
+        linebuf_mark_line_dirty(self->linebuf, self->last_rendered.cursor_y);
+}
+
+void
+screen_finish_partial_update(Screen *self) {
+    bool was_dirty = self->is_dirty;
+    screen_reset_dirty(self);
     if (was_dirty) clear_selection(&self->url_ranges);
 }
 
@@ -1875,17 +2217,75 @@ screen_has_selection(Screen *self) {
     return false;
 }
 
+static uint8_t*
+ensure_selection_map(Screen *self) {
+    size_t sz = (size_t)self->lines * self->columns;
+    if (self->selection_map.sz != sz) {
+        uint8_t *q = realloc(self->selection_map.buf, sz);
+        if (!q) fatal("Out of memory");
+        self->selection_map.buf = q; self->selection_map.sz = sz;
+    }
+    return self->selection_map.buf;
+}
+
 void
 screen_apply_selection(Screen *self, void *address, size_t size) {
-    memset(address, 0, size);
+    uint8_t *map = ensure_selection_map(self);
+    memset(map, 0, self->selection_map.sz);
     for (size_t i = 0; i < self->selections.count; i++) {
-        apply_selection(self, address, self->selections.items + i, 1);
+        apply_selection(self, map, self->selections.items + i, 1);
     }
-    self->selections.last_rendered_count = self->selections.count;
+    self->selections.last_rendered_generation = self->selections.generation;
     for (size_t i = 0; i < self->url_ranges.count; i++) {
-        apply_selection(self, address, self->url_ranges.items + i, 2);
+        apply_selection(self, map, self->url_ranges.items + i, 2);
     }
-    self->url_ranges.last_rendered_count = self->url_ranges.count;
+    self->url_ranges.last_rendered_generation = self->url_ranges.generation;
+    memcpy(address, map, MIN(size, self->selection_map.sz));
+}
+
+static inline bool
+xranges_equal(const XRange *a, const XRange *b) { return a->x == b->x && a->x_limit == b->x_limit; }
+
+// Re-apply only the lines whose selection membership changed since the last
+// render, diffing the previously rendered iteration data against the current
+// boundaries. This covers both normal and rectangle selections, since both
+// reduce to per-line x ranges. Returns false when an incremental update is
+// not possible and the full map must be rebuilt. On success [first_row,
+// row_limit) is the range of lines that was modified and needs re-uploading.
+bool
+screen_update_selection_map_incremental(Screen *self, index_type *first_row, index_type *row_limit) {
+    *first_row = 0; *row_limit = 0;
+    size_t sz = (size_t)self->lines * self->columns;
+    if (!self->selection_map.buf || self->selection_map.sz != sz) return false;
+    // a scroll moves every line's membership, no point diffing
+    if (self->scrolled_by != self->last_rendered.scrolled_by) return false;
+    if (self->url_ranges.generation != self->url_ranges.last_rendered_generation) return false;
+    if (self->selections.count != 1) return false;
+    if (self->selections.generation == self->selections.last_rendered_generation) return true;
+    Selection *s = self->selections.items;
+    IterationData old = s->last_rendered, idata;
+    iteration_data(self, s, &idata, -self->historybuf->count, true);
+    // apply_selection clamps the stored y, so if either span reaches into the
+    // scrollback the per-row x ranges cannot be reconstructed reliably
+    if (old.y <= 0 || idata.y < 0) return false;
+    int start = MIN(old.y, idata.y), limit = MIN(MAX(old.y_limit, idata.y_limit), (int)self->lines);
+    int first_changed = -1, last_changed = -1;
+    for (int y = start; y < limit; y++) {
+        Line *line = visual_line_(self, y);
+        XRange oldr = (old.y <= y && y < old.y_limit) ? xrange_for_iteration(&old, y, line) : (XRange){0, 0};
+        XRange newr = (idata.y <= y && y < idata.y_limit) ? xrange_for_iteration(&idata, y, line) : (XRange){0, 0};
+        if (xranges_equal(&oldr, &newr)) continue;
+        uint8_t *row = self->selection_map.buf + (size_t)self->columns * y;
+        for (index_type x = oldr.x; x < oldr.x_limit; x++) row[x] &= ~1;
+        for (index_type x = newr.x; x < newr.x_limit; x++) row[x] |= 1;
+        if (first_changed < 0) first_changed = y;
+        last_changed = y;
+    }
+    s->last_rendered = idata;
+    s->last_rendered.y = MAX(0, s->last_rendered.y);
+    self->selections.last_rendered_generation = self->selections.generation;
+    if (first_changed >= 0) { *first_row = first_changed; *row_limit = last_changed + 1; }
+    return true;
 }
 
 static inline PyObject*
@@ -2058,12 +2458,37 @@ as_text_generic_wrapper(Screen *self, PyObject *args, get_line_func get_line) {
 static PyObject*
 as_text_alternate(Screen *self, PyObject *args) {
     LineBuf *original = self->linebuf;
+    if (original == self->main_linebuf && self->alt_linebuf == NULL) Py_RETURN_NONE;  // no alt screen, nothing to output
     self->linebuf = original == self->main_linebuf ? self->alt_linebuf : self->main_linebuf;
     PyObject *ans = as_text_generic_wrapper(self, args, get_range_line);
     self->linebuf = original;
     return ans;
 }
 
+typedef struct ScanTextContainer {
+    Screen *screen;
+    index_type history_lines;
+} ScanTextContainer;
+
+static Line*
+get_scan_line(void *x, int y) {
+    ScanTextContainer *c = x;
+    return range_line_(c->screen, y - (int)c->history_lines);
+}
+
+static PyObject*
+scan_text(Screen *self, PyObject *args) {
+#define scan_text_doc "scan_text(patterns, scrollback_lines=0) -> Run the POSIX extended regex patterns over the screen text plus the last scrollback_lines lines of scrollback in a single scan, returning a list of (pattern_idx, start, end, matched_text) tuples. Offsets are in characters into the text in the same form as produced by as_text()."
+    PyObject *patterns;
+    unsigned int scrollback_lines = 0;
+    if (!PyArg_ParseTuple(args, "O!|I", &PyTuple_Type, &patterns, &scrollback_lines)) return NULL;
+    historybuf_resolve_deferred_rewrap(self->historybuf);
+    // the scrollback belongs to the main screen only
+    if (self->linebuf == self->alt_linebuf) scrollback_lines = 0;
+    ScanTextContainer c = {.screen=self, .history_lines=MIN(scrollback_lines, self->historybuf->count)};
+    return scan_text_generic(patterns, &c, get_scan_line, c.history_lines + self->lines);
+}
+
 
 
 static PyObject*
@@ -2126,6 +2551,13 @@ screen_visual_line(Screen *self, index_type y) {
     return visual_line_(self, y);
 }
 
+bool
+screen_visual_line_may_have_url(Screen *self, index_type y) {
+    if (y >= self->lines) return false;
+    if (self->scrolled_by && y < self->scrolled_by) return historybuf_line_may_have_url(self->historybuf, self->scrolled_by - 1 - y);
+    return linebuf_line_may_have_url(self->linebuf, y - self->scrolled_by);
+}
+
 static PyObject*
 visual_line(Screen *self, PyObject *args) {
     // The line corresponding to the yth visual line, taking into account scrolling
@@ -2350,14 +2782,59 @@ is_char_ok_for_word_extension(Line* line, index_type x) {
     return false;
 }
 
+static void
+invalidate_word_cache(Screen *self) {
+    if (self->word_cache.line_built) memset(self->word_cache.line_built, 0, self->word_cache.lines);
+    self->word_cache.scrolled_by = self->scrolled_by;
+}
+
+static const uint8_t*
+word_cache_bits_for_line(Screen *self, index_type y) {
+    // Bitmap of the cells at visual line y that can extend a word-wise
+    // selection, built lazily on first query so that drag selection tests
+    // a bit per cell instead of re-classifying every cell on every mouse
+    // event. Cells already aggregate combining chars so cell boundaries are
+    // grapheme boundaries, only the char class needs caching. Content
+    // changes are detected via the dirty flag, which also drops the cache
+    // when it is reset at render time in screen_reset_dirty().
+    size_t stride = (self->columns + 7) / 8;
+    if (self->word_cache.lines != self->lines || self->word_cache.columns != self->columns) {
+        free(self->word_cache.bits); free(self->word_cache.line_built);
+        self->word_cache.bits = calloc(self->lines, stride);
+        self->word_cache.line_built = calloc(self->lines, 1);
+        if (!self->word_cache.bits || !self->word_cache.line_built) fatal("Out of memory.");
+        self->word_cache.lines = self->lines; self->word_cache.columns = self->columns;
+        self->word_cache.scrolled_by = self->scrolled_by;
+    }
+    bool opts_changed = self->word_cache.opt_chars_count != OPT(select_by_word_characters_count) || memcmp(
+            self->word_cache.opt_chars, OPT(select_by_word_characters), OPT(select_by_word_characters_count) * sizeof(char_type)) != 0;
+    if (self->is_dirty || self->word_cache.scrolled_by != self->scrolled_by || opts_changed) {
+        invalidate_word_cache(self);
+        if (opts_changed) {
+            self->word_cache.opt_chars_count = OPT(select_by_word_characters_count);
+            memcpy(self->word_cache.opt_chars, OPT(select_by_word_characters), self->word_cache.opt_chars_count * sizeof(char_type));
+        }
+    }
+    uint8_t *bits = self->word_cache.bits + (size_t)y * stride;
+    if (!self->word_cache.line_built[y]) {
+        Line *line = visual_line_(self, y);
+        memset(bits, 0, stride);
+        for (index_type x = 0; x < self->columns; x++) {
+            if (is_char_ok_for_word_extension(line, x)) bits[x >> 3] |= 1 << (x & 7);
+        }
+        self->word_cache.line_built[y] = true;
+    }
+    return bits;
+}
+
 bool
 screen_selection_range_for_word(Screen *self, const index_type x, const index_type y, index_type *y1, index_type *y2, index_type *s, index_type *e, bool initial_selection) {
     if (y >= self->lines || x >= self->columns) return false;
     index_type start, end;
-    Line *line = visual_line_(self, y);
+    const uint8_t *bits = word_cache_bits_for_line(self, y);
     *y1 = y;
     *y2 = y;
-#define is_ok(x) is_char_ok_for_word_extension(line, x)
+#define is_ok(x) (bits[(x) >> 3] & (1 << ((x) & 7)))
     if (!is_ok(x)) {
         if (initial_selection) return false;
         *s = x; *e = x;
@@ -2366,17 +2843,18 @@ screen_selection_range_for_word(Screen *self, const index_type x, const index_ty
     start = x; end = x;
     while(true) {
         while(start > 0 && is_ok(start - 1)) start--;
-        if (start > 0 || !line->continued || *y1 == 0) break;
-        line = visual_line_(self, *y1 - 1);
+        if (start > 0 || *y1 == 0 || !visual_line_(self, *y1)->continued) break;
+        bits = word_cache_bits_for_line(self, *y1 - 1);
         if (!is_ok(self->columns - 1)) break;
         (*y1)--; start = self->columns - 1;
     }
-    line = visual_line_(self, *y2);
+    bits = word_cache_bits_for_line(self, *y2);
     while(true) {
         while(end < self->columns - 1 && is_ok(end + 1)) end++;
         if (end < self->columns - 1 || *y2 >= self->lines - 1) break;
-        line = visual_line_(self, *y2 + 1);
-        if (!line->continued || !is_ok(0)) break;
+        if (!visual_line_(self, *y2 + 1)->continued) break;
+        bits = word_cache_bits_for_line(self, *y2 + 1);
+        if (!is_ok(0)) break;
         (*y2)++; end = 0;
     }
     *s = start; *e = end;
@@ -2386,6 +2864,7 @@ screen_selection_range_for_word(Screen *self, const index_type x, const index_ty
 
 bool
 screen_history_scroll(Screen *self, int amt, bool upwards) {
+    historybuf_resolve_deferred_rewrap(self->historybuf);
     switch(amt) {
         case SCROLL_LINE:
             amt = 1;
@@ -2424,17 +2903,12 @@ scroll(Screen *self, PyObject *args) {
 
 bool
 screen_is_selection_dirty(Screen *self) {
-    IterationData q;
+    // Every mutation of a Selections object bumps its generation counter, so
+    // rendered iteration data stays valid until the generation or the scroll
+    // position changes, no need to recompute it every frame
     if (self->scrolled_by != self->last_rendered.scrolled_by) return true;
-    if (self->selections.last_rendered_count != self->selections.count || self->url_ranges.last_rendered_count != self->url_ranges.count) return true;
-    for (size_t i = 0; i < self->selections.count; i++) {
-        iteration_data(self, self->selections.items + i, &q, 0, true);
-        if (memcmp(&q, &self->selections.items[i].last_rendered, sizeof(IterationData)) != 0) return true;
-    }
-    for (size_t i = 0; i < self->url_ranges.count; i++) {
-        iteration_data(self, self->url_ranges.items + i, &q, 0, true);
-        if (memcmp(&q, &self->url_ranges.items[i].last_rendered, sizeof(IterationData)) != 0) return true;
-    }
+    if (self->selections.generation != self->selections.last_rendered_generation) return true;
+    if (self->url_ranges.generation != self->url_ranges.last_rendered_generation) return true;
     return false;
 }
 
@@ -2444,6 +2918,7 @@ screen_start_selection(Screen *self, index_type x, index_type y, bool in_left_ha
     ensure_space_for(&self->selections, items, Selection, self->selections.count + 1, capacity, 1, false);
     memset(self->selections.items, 0, sizeof(Selection));
     self->selections.count = 1;
+    self->selections.generation++;
     self->selections.in_progress = true;
     self->selections.extend_mode = extend_mode;
     self->selections.items[0].last_rendered.y = INT_MAX;
@@ -2458,6 +2933,7 @@ static inline void
 add_url_range(Screen *self, index_type start_x, index_type start_y, index_type end_x, index_type end_y) {
 #define A(attr, val) r->attr = val;
     ensure_space_for(&self->url_ranges, items, Selection, self->url_ranges.count + 8, capacity, 8, false);
+    self->url_ranges.generation++;
     Selection *r = self->url_ranges.items + self->url_ranges.count++;
     memset(r, 0, sizeof(Selection));
     r->last_rendered.y = INT_MAX;
@@ -2470,6 +2946,7 @@ add_url_range(Screen *self, index_type start_x, index_type start_y, index_type e
 void
 screen_mark_url(Screen *self, index_type start_x, index_type start_y, index_type end_x, index_type end_y) {
     self->url_ranges.count = 0;
+    self->url_ranges.generation++;
     if (start_x || start_y || end_x || end_y) add_url_range(self, start_x, start_y, end_x, end_y);
 }
 
@@ -2519,6 +2996,7 @@ sort_ranges(const Screen *self, Selections *s) {
 hyperlink_id_type
 screen_mark_hyperlink(Screen *self, index_type x, index_type y) {
     self->url_ranges.count = 0;
+    self->url_ranges.generation++;
     Line *line = screen_visual_line(self, y);
     hyperlink_id_type id = line->cpu_cells[x].hyperlink_id;
     if (!id) return 0;
@@ -2543,6 +3021,7 @@ screen_mark_hyperlink(Screen *self, index_type x, index_type y) {
 void
 screen_update_selection(Screen *self, index_type x, index_type y, bool in_left_half_of_cell, bool ended, bool start_extended_selection) {
     if (!self->selections.count) return;
+    self->selections.generation++;
     self->selections.in_progress = !ended;
     Selection *s = self->selections.items;
     s->input_current.x = x; s->input_current.y = y;
@@ -2637,15 +3116,17 @@ static inline void
 screen_mark_all(Screen *self) {
     for (index_type y = 0; y < self->main_linebuf->ynum; y++) {
         linebuf_init_line(self->main_linebuf, y);
-        mark_text_in_line(self->marker, self->main_linebuf->line);
+        screen_apply_marker(self, self->main_linebuf->line);
     }
-    for (index_type y = 0; y < self->alt_linebuf->ynum; y++) {
-        linebuf_init_line(self->alt_linebuf, y);
-        mark_text_in_line(self->marker, self->alt_linebuf->line);
+    if (self->alt_linebuf) {
+        for (index_type y = 0; y < self->alt_linebuf->ynum; y++) {
+            linebuf_init_line(self->alt_linebuf, y);
+            screen_apply_marker(self, self->alt_linebuf->line);
+        }
     }
     for (index_type y = 0; y < self->historybuf->count; y++) {
         historybuf_init_line(self->historybuf, y, self->historybuf->line);
-        mark_text_in_line(self->marker, self->historybuf->line);
+        screen_apply_marker(self, self->historybuf->line);
     }
     self->is_dirty = true;
 }
@@ -2654,15 +3135,29 @@ static PyObject*
 set_marker(Screen *self, PyObject *args) {
     PyObject *marker = NULL;
     if (!PyArg_ParseTuple(args, "|O", &marker)) return NULL;
-    if (!marker) {
-        if (self->marker) {
-            Py_CLEAR(self->marker);
-            screen_mark_all(self);
-        }
+    bool had_marker = screen_has_marker(self);
+    Py_CLEAR(self->marker);
+    if (self->text_marker.needle) {
+        PyMem_Free(self->text_marker.needle);
+        self->text_marker.needle = NULL; self->text_marker.needle_len = 0;
+    }
+    if (!marker || marker == Py_None) {
+        if (had_marker) screen_mark_all(self);
+        Py_RETURN_NONE;
+    }
+    if (PyTuple_Check(marker)) {
+        // a (color, text) tuple specifying a plain text marker, scanned in C
+        unsigned long color; PyObject *text;
+        if (!PyArg_ParseTuple(marker, "kU", &color, &text)) return NULL;
+        self->text_marker.needle = PyUnicode_AsUCS4Copy(text);
+        if (!self->text_marker.needle) return NULL;
+        self->text_marker.needle_len = PyUnicode_GET_LENGTH(text);
+        self->text_marker.mark = (MAX(1ul, MIN(color, (unsigned long)MARK_MASK)) & MARK_MASK) << MARK_SHIFT;
+        screen_mark_all(self);
         Py_RETURN_NONE;
     }
     if (!PyCallable_Check(marker)) {
-        PyErr_SetString(PyExc_TypeError, "marker must be a callable");
+        PyErr_SetString(PyExc_TypeError, "marker must be a callable or a (color, text) tuple");
         return NULL;
     }
     self->marker = marker;
@@ -2837,6 +3332,7 @@ static PyMethodDef methods[] = {
     MND(as_text, METH_VARARGS)
     MND(as_text_non_visual, METH_VARARGS)
     MND(as_text_alternate, METH_VARARGS)
+    MND(scan_text, METH_VARARGS)
     MND(tab, METH_NOARGS)
     MND(backspace, METH_NOARGS)
     MND(linefeed, METH_NOARGS)
@@ -2905,6 +3401,7 @@ static PyMemberDef members[] = {
     {"margin_top", T_UINT, offsetof(Screen, margin_top), READONLY, "margin_top"},
     {"margin_bottom", T_UINT, offsetof(Screen, margin_bottom), READONLY, "margin_bottom"},
     {"history_line_added_count", T_UINT, offsetof(Screen, history_line_added_count), 0, "history_line_added_count"},
+    {"suppressed_bells", T_UINT, offsetof(Screen, suppressed_bells), 0, "suppressed_bells"},
     {NULL}
 };
 
@@ -46,7 +46,10 @@ typedef struct {
 
 typedef struct {
     Selection *items;
-    size_t count, capacity, last_rendered_count;
+    size_t count, capacity;
+    // generation is incremented on every mutation, comparing it to
+    // last_rendered_generation tells us if a re-render is needed
+    unsigned int generation, last_rendered_generation;
     bool in_progress;
     SelectionExtendMode extend_mode;
 } Selections;
@@ -86,34 +89,94 @@ typedef struct {
     uint32_t utf8_state, utf8_codepoint, *g0_charset, *g1_charset, *g_charset;
     unsigned int current_charset;
     Selections selections, url_ranges;
+    // cpu side copy of the per-cell selection byte map sent to the gpu, kept
+    // so that a drag can re-apply only the lines whose membership changed
+    struct { uint8_t *buf; size_t sz; } selection_map;
     struct {
         unsigned int cursor_x, cursor_y, scrolled_by;
         index_type lines, columns;
     } last_rendered;
+    // set when this frame's cell data was already prepared ahead of the draw
+    // call by start_cell_data_prep(), consumed by send_cell_data_to_gpu()
+    struct { bool done, changed; } render_prep;
     bool use_latin1, is_dirty, scroll_changed, reload_all_gpu_data;
     Cursor *cursor;
     Savepoint main_savepoint, alt_savepoint;
     SavemodesBuffer modes_savepoints;
     PyObject *callbacks, *test_child;
+    // OSC 0/2 title updates are deduplicated against the last reported title
+    // and coalesced so that at most one, the latest, crosses into Python per
+    // frame, see screen_flush_pending_title()
+    PyObject *pending_title, *last_reported_title;
+    // alt_linebuf is allocated lazily on the first switch to the alternate
+    // screen and freed again after it has been unused for a while, most
+    // windows never use it
     LineBuf *linebuf, *main_linebuf, *alt_linebuf;
+    monotonic_t alt_screen_exited_at;
     GraphicsManager *grman, *main_grman, *alt_grman;
+    // side table of (fg, bg, decoration_fg) triples for cells with truecolor
+    // colors, which do not fit in the packed GPU cell record. Grows append
+    // only so published indices stay valid, entries are deduplicated
+    struct {
+        uint32_t *triples;  // 3 values per entry
+        void *lookup;  // hash table mapping triple to index
+        uint32_t count, capacity, generation;
+        bool needs_reset;
+    } truecolor_table;
     HistoryBuf *historybuf;
     unsigned int history_line_added_count;
+    // lines scrolled since the last cell data update, used to detect
+    // fast-scroll floods, see screen_prepare_cell_data()
+    unsigned int lines_scrolled_since_render;
     bool *tabstops, *main_tabstops, *alt_tabstops;
     ScreenModes modes;
     ColorProfile *color_profile;
     monotonic_t start_visual_bell_at;
+    // bell storms are coalesced: the full bell path runs at most once per
+    // cooldown interval, suppressed_bells counts the rest, see screen_bell()
+    monotonic_t last_bell_at;
+    unsigned int suppressed_bells;
 
     uint32_t parser_buf[PARSER_BUF_SZ];
     unsigned int parser_state, parser_text_start, parser_buf_pos;
     bool parser_has_pending_text;
+    // set when an over long OSC 52 payload is being streamed out in chunks,
+    // the final dispatch must then also go to the clipboard chunk handler
+    bool parser_osc52_pending;
+    // CSI parameters accumulated incrementally as digits arrive, valid only
+    // while is_simple is true, otherwise dispatch re-parses parser_buf
+    struct {
+        unsigned int params[MAX_PARAMS];
+        unsigned int num_params, current;
+        bool has_current, is_simple;
+    } parser_csi;
+    // ring buffer: the io thread appends at (read_buf_start + read_buf_sz) %
+    // READ_BUF_SZ, the parser consumes from read_buf_start, so no memmove of
+    // leftover bytes is ever needed
+    // write_buf is also a ring: the main thread appends at (write_buf_start +
+    // write_buf_used) % write_buf_sz, the io thread flushes from
+    // write_buf_start with writev(), so partial writes never memmove
     uint8_t read_buf[READ_BUF_SZ], *write_buf;
+    // second read buffer, allocated the first time the ring fills up and
+    // spilled into by readv() so a fast producer's pty stays drained while
+    // the parser catches up; only ever touched by the io thread
+    uint8_t *spare_read_buf;
     monotonic_t new_input_at;
-    size_t read_buf_sz, write_buf_sz, write_buf_used;
+    size_t read_buf_start, read_buf_sz, spare_read_buf_sz, write_buf_start, write_buf_sz, write_buf_used;
+    // protected by write_buf_lock: requested is set by the main thread when a
+    // Python producer wants to know once the write buffer drains below the
+    // watermark, the io thread converts it to pending when that happens
+    struct { bool requested, pending; } write_drain_notify;
     pthread_mutex_t read_buf_lock, write_buf_lock;
 
     CursorRenderInfo cursor_render_info;
 
+    // keypress-to-pixel latency tracking: pressed_at is stamped when a
+    // keystroke is written to the child, promoted to echoed when the next
+    // output from the child is parsed, and sampled once the frame containing
+    // that damage is swapped; all three steps run on the main thread
+    struct { monotonic_t pressed_at; bool echoed; } key_latency;
+
     struct {
         size_t capacity, used, stop_buf_pos;
         uint8_t *buf;
@@ -123,6 +186,23 @@ typedef struct {
     } pending_mode;
     DisableLigature disable_ligatures;
     PyObject *marker;
+    // plain text markers are scanned natively, without calling into Python
+    struct {
+        char_type *needle;
+        size_t needle_len;
+        attrs_type mark;
+    } text_marker;
+    // lazily built per visual line bitmaps of the cells that can extend a
+    // word-wise selection, so drag selection does not re-classify the same
+    // cells on every mouse event, see screen_selection_range_for_word()
+    struct {
+        uint8_t *bits;        // lines rows of (columns + 7) / 8 bytes each
+        uint8_t *line_built;  // one byte per visual line
+        index_type lines, columns;  // dimensions bits was allocated for
+        unsigned int scrolled_by;   // scroll position the bitmaps were built at
+        // snapshot of select_by_word_characters the bitmaps were built with
+        char_type opt_chars[256]; size_t opt_chars_count;
+    } word_cache;
     bool has_focus;
     bool has_activity_since_last_focus;
     hyperlink_id_type active_hyperlink_id;
@@ -131,21 +211,24 @@ typedef struct {
 } Screen;
 
 
-void parse_worker(Screen *screen, PyObject *dump_callback, monotonic_t now);
-void parse_worker_dump(Screen *screen, PyObject *dump_callback, monotonic_t now);
+void parse_worker(Screen *screen, PyObject *dump_callback, monotonic_t now, size_t max_sz);
+void parse_worker_dump(Screen *screen, PyObject *dump_callback, monotonic_t now, size_t max_sz);
 void screen_align(Screen*);
 void screen_restore_cursor(Screen *);
 void screen_save_cursor(Screen *);
 void screen_restore_modes(Screen *);
 void screen_save_modes(Screen *);
 void write_escape_code_to_child(Screen *self, unsigned char which, const char *data);
+void write_data_to_child(Screen *self, const char *data, size_t sz);
 void screen_cursor_position(Screen*, unsigned int, unsigned int);
 void screen_cursor_back(Screen *self, unsigned int count/*=1*/, int move_direction/*=-1*/);
 void screen_erase_in_line(Screen *, unsigned int, bool);
 void screen_erase_in_display(Screen *, unsigned int, bool);
 void screen_draw(Screen *screen, uint32_t codepoint);
+void screen_draw_run(Screen *screen, const char_type *chars, size_t num);
 void screen_ensure_bounds(Screen *self, bool use_margins, bool cursor_was_within_margins);
 void screen_toggle_screen_buffer(Screen *self, bool, bool);
+void screen_free_stale_alt_linebuf(Screen *self, monotonic_t now);
 void screen_normal_keypad_mode(Screen *self);
 void screen_alternate_keypad_mode(Screen *self);
 void screen_change_default_color(Screen *self, unsigned int which, uint32_t col);
@@ -186,10 +269,11 @@ void screen_handle_print(Screen *, PyObject *cmd);
 void screen_designate_charset(Screen *, uint32_t which, uint32_t as);
 void screen_use_latin1(Screen *, bool);
 void set_title(Screen *self, PyObject*);
+void screen_flush_pending_title(Screen *self);
 void desktop_notify(Screen *self, unsigned int, PyObject*);
 void set_icon(Screen *self, PyObject*);
 void set_dynamic_color(Screen *self, unsigned int code, PyObject*);
-void clipboard_control(Screen *self, PyObject*);
+void clipboard_control(Screen *self, PyObject*, bool is_partial);
 void set_color_table_color(Screen *self, unsigned int code, PyObject*);
 uint32_t* translation_table(uint32_t which);
 void screen_request_capabilities(Screen *, char, PyObject *);
@@ -200,9 +284,20 @@ void report_device_status(Screen *self, unsigned int which, bool UNUSED);
 void report_mode_status(Screen *self, unsigned int which, bool);
 void screen_apply_selection(Screen *self, void *address, size_t size);
 bool screen_is_selection_dirty(Screen *self);
+bool screen_update_selection_map_incremental(Screen *self, index_type *first_row, index_type *row_limit);
 bool screen_has_selection(Screen*);
 bool screen_invert_colors(Screen *self);
 void screen_update_cell_data(Screen *self, void *address, FONTS_DATA_HANDLE, bool cursor_has_moved);
+// the two phases of screen_update_cell_data: prepare rasterizes glyphs and
+// must run on the main thread, pack only touches this screen's state and may
+// run on a worker thread, unless the screen is scrolled back (history line
+// access is main thread only)
+void screen_prepare_cell_data(Screen *self, FONTS_DATA_HANDLE, bool cursor_has_moved);
+void screen_pack_cell_data(Screen *self, void *address);
+bool screen_update_line_data_if_dirty(Screen *self, index_type lnum, FONTS_DATA_HANDLE, PackedGPUCell *dest);
+void screen_pack_cells(Screen *self, const GPUCell *src, PackedGPUCell *dest, index_type count);
+void screen_mark_cursor_dirty_lines(Screen *self);
+void screen_finish_partial_update(Screen *self);
 bool screen_is_cursor_visible(Screen *self);
 bool screen_selection_range_for_line(Screen *self, index_type y, index_type *start, index_type *end);
 bool screen_selection_range_for_word(Screen *self, const index_type x, const index_type y, index_type *, index_type *, index_type *start, index_type *end, bool);
@@ -210,6 +305,7 @@ void screen_start_selection(Screen *self, index_type x, index_type y, bool, bool
 void screen_update_selection(Screen *self, index_type x, index_type y, bool in_left_half, bool ended, bool start_extended_selection);
 bool screen_history_scroll(Screen *self, int amt, bool upwards);
 Line* screen_visual_line(Screen *self, index_type y);
+bool screen_visual_line_may_have_url(Screen *self, index_type y);
 unsigned long screen_current_char_width(Screen *self);
 void screen_mark_url(Screen *self, index_type start_x, index_type start_y, index_type end_x, index_type end_y);
 void set_active_hyperlink(Screen*, char*, char*);
@@ -7,15 +7,23 @@
 
 #include "fonts.h"
 #include "gl.h"
+#include "threading.h"
+#include "glfw-wrapper.h"
+#include "tracepoints.h"
 #include <stddef.h>
 
 enum { CELL_PROGRAM, CELL_BG_PROGRAM, CELL_SPECIAL_PROGRAM, CELL_FG_PROGRAM, BORDERS_PROGRAM, GRAPHICS_PROGRAM, GRAPHICS_PREMULT_PROGRAM, GRAPHICS_ALPHA_MASK_PROGRAM, BLIT_PROGRAM, BGIMAGE_PROGRAM, TINT_PROGRAM, NUM_PROGRAMS };
-enum { SPRITE_MAP_UNIT, GRAPHICS_UNIT, BLIT_UNIT, BGIMAGE_UNIT };
+enum { SPRITE_MAP_UNIT, GRAPHICS_UNIT, BLIT_UNIT, BGIMAGE_UNIT, TRUECOLOR_TABLE_UNIT };
 
 // Sprites {{{
 typedef struct {
     unsigned int cell_width, cell_height;
     int xnum, ynum, x, y, z, last_num_of_layers, last_ynum;
+    // layers actually backed by texture storage, grown geometrically so that
+    // sessions which keep discovering new glyphs do not re-upload the whole
+    // texture once per layer. Spare layers are safe, the shader addresses
+    // layers by index, only width and height must match the layout exactly
+    int allocated_layers;
     GLuint texture_id;
     GLint max_texture_size, max_array_texture_layers;
 } SpriteMap;
@@ -91,20 +99,22 @@ realloc_sprite_texture(FONTS_DATA_HANDLE fg) {
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    unsigned int xnum, ynum, z, znum, width, height, src_ynum;
+    unsigned int xnum, ynum, z, znum, alloc_znum, width, height, src_ynum;
     sprite_tracker_current_layout(fg, &xnum, &ynum, &z);
     znum = z + 1;
     SpriteMap *sprite_map = (SpriteMap*)fg->sprite_map;
+    alloc_znum = MAX(znum, MIN((unsigned int)sprite_map->max_array_texture_layers, 2 * (unsigned int)sprite_map->allocated_layers));
     width = xnum * sprite_map->cell_width; height = ynum * sprite_map->cell_height;
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, width, height, znum);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, width, height, alloc_znum);
     if (sprite_map->texture_id) {
-        // need to re-alloc
+        // need to re-alloc, only the layers actually in use are copied over
         src_ynum = MAX(1, sprite_map->last_ynum);
         copy_image_sub_data(sprite_map->texture_id, tex, width, src_ynum * sprite_map->cell_height, sprite_map->last_num_of_layers);
         glDeleteTextures(1, &sprite_map->texture_id);
     }
     glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     sprite_map->last_num_of_layers = znum;
+    sprite_map->allocated_layers = alloc_znum;
     sprite_map->last_ynum = ynum;
     sprite_map->texture_id = tex;
 }
@@ -124,13 +134,60 @@ send_sprite_to_gpu(FONTS_DATA_HANDLE fg, unsigned int x, unsigned int y, unsigne
     SpriteMap *sprite_map = (SpriteMap*)fg->sprite_map;
     unsigned int xnum, ynum, znum;
     sprite_tracker_current_layout(fg, &xnum, &ynum, &znum);
-    if ((int)znum >= sprite_map->last_num_of_layers || (znum == 0 && (int)ynum > sprite_map->last_ynum)) realloc_sprite_texture(fg);
+    // growing into a spare pre-allocated layer needs no realloc and no copy
+    if ((int)znum >= sprite_map->allocated_layers || (znum == 0 && (int)ynum > sprite_map->last_ynum)) realloc_sprite_texture(fg);
+    else if ((int)znum >= sprite_map->last_num_of_layers) sprite_map->last_num_of_layers = znum + 1;
     glBindTexture(GL_TEXTURE_2D_ARRAY, sprite_map->texture_id);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     x *= sprite_map->cell_width; y *= sprite_map->cell_height;
     glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, z, sprite_map->cell_width, sprite_map->cell_height, 1, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buf);
 }
 
+// Large image bitmaps are staged through a ring of pixel unpack buffers so
+// that glTexImage2D reads from driver owned memory and the upload can be
+// DMAed asynchronously, instead of stalling the GL thread on a copy out of
+// client memory. A fence per ring slot detects whether the driver is still
+// reading a buffer, in which case its storage is orphaned rather than waited
+// on. Small uploads skip the ring, the copy cost is negligible for them.
+
+#define UPLOAD_PBO_RING_SIZE 4
+#define UPLOAD_PBO_MIN_SZ (1u * 1024u * 1024u)
+
+typedef struct {
+    GLuint id;
+    GLsizeiptr capacity;
+    GLsync fence;
+} UploadPBO;
+static UploadPBO upload_pbos[UPLOAD_PBO_RING_SIZE];
+static size_t upload_pbo_idx = 0;
+
+static bool
+upload_texture_via_pbo(const void *data, GLsizeiptr sz, GLsizei width, GLsizei height, bool is_opaque) {
+    UploadPBO *pbo = upload_pbos + upload_pbo_idx;
+    upload_pbo_idx = (upload_pbo_idx + 1) % UPLOAD_PBO_RING_SIZE;
+    if (!pbo->id) glGenBuffers(1, &pbo->id);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo->id);
+    bool in_use = false;
+    if (pbo->fence) {
+        in_use = glClientWaitSync(pbo->fence, 0, 0) == GL_TIMEOUT_EXPIRED;
+        glDeleteSync(pbo->fence); pbo->fence = NULL;
+    }
+    if (pbo->capacity < sz || in_use) {
+        // (re)allocate storage, which also orphans contents the driver has
+        // not finished reading
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, sz, NULL, GL_STREAM_DRAW);
+        pbo->capacity = sz;
+    }
+    void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, sz, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped) { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); return false; }
+    memcpy(mapped, data, sz);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, is_opaque ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    pbo->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
 void
 send_image_to_gpu(GLuint *tex_id, const void* data, GLsizei width, GLsizei height, bool is_opaque, bool is_4byte_aligned, bool linear, RepeatStrategy repeat) {
     if (!(*tex_id)) { glGenTextures(1, tex_id);  }
@@ -149,9 +206,39 @@ send_image_to_gpu(GLuint *tex_id, const void* data, GLsizei width, GLsizei heigh
     }
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, r);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, r);
+    GLsizeiptr sz = (GLsizeiptr)width * height * (is_opaque ? 3 : 4);
+    if (data && sz >= (GLsizeiptr)UPLOAD_PBO_MIN_SZ && upload_texture_via_pbo(data, sz, width, height, is_opaque)) return;
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, is_opaque ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, data);
 }
 
+void
+generate_bgimage_mipmaps(uint32_t tex_id, bool linear) {
+    // minification of a large background image on small viewports reads from
+    // the mip chain instead of sparsely sampling the full resolution texture
+    glBindTexture(GL_TEXTURE_2D, tex_id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    if (linear) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void
+create_image_atlas_texture(GLuint *tex_id, GLsizei width, GLsizei height) {
+    glGenTextures(1, tex_id);
+    glBindTexture(GL_TEXTURE_2D, *tex_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+}
+
+void
+send_image_to_gpu_atlas_region(GLuint tex_id, const void* data, GLsizei x, GLsizei y, GLsizei width, GLsizei height, bool is_4byte_aligned) {
+    glBindTexture(GL_TEXTURE_2D, tex_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, is_4byte_aligned ? 4 : 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
 // }}}
 
 // Cell {{{
@@ -186,9 +273,19 @@ init_cell_program(void) {
     // Sanity check to ensure the attribute location binding worked
 #define C(p, name, expected) { int aloc = attrib_location(p, #name); if (aloc != expected && aloc != -1) fatal("The attribute location for %s is %d != %d in program: %d", #name, aloc, expected, p); }
     for (int p = CELL_PROGRAM; p < BORDERS_PROGRAM; p++) {
-        C(p, colors, 0); C(p, sprite_coords, 1); C(p, is_selected, 2);
+        C(p, packed_colors, 0); C(p, sprite_coords, 1); C(p, is_selected, 2);
     }
 #undef C
+    // the truecolor side table sampler is not on unit zero, so it has to be
+    // pointed at its unit explicitly in every cell program variant
+    for (int p = CELL_PROGRAM; p < BORDERS_PROGRAM; p++) {
+        GLint loc = glGetUniformLocation(program_id(p), "truecolor_table");
+        if (loc > -1) {
+            bind_program(p);
+            glUniform1i(loc, TRUECOLOR_TABLE_UNIT);
+        }
+    }
+    unbind_program();
     blit_vertex_array = create_vao();
     bgimage_program_layout.image_location = get_uniform_location(BGIMAGE_PROGRAM, "image");
     bgimage_program_layout.opacity_location = get_uniform_location(BGIMAGE_PROGRAM, "opacity");
@@ -201,17 +298,132 @@ init_cell_program(void) {
 
 #define CELL_BUFFERS enum { cell_data_buffer, selection_buffer, uniform_buffer };
 
+struct CellRenderData {
+    GLfloat xstart, ystart, dx, dy, sprite_dx, sprite_dy, background_opacity, cursor_text_uses_bg;
+
+    GLuint default_fg, default_bg, highlight_fg, highlight_bg, cursor_color, cursor_text_color, url_color, url_style, inverted;
+
+    GLuint xnum, ynum, cursor_fg_sprite_idx;
+    GLfloat cursor_x, cursor_y, cursor_w;
+};
+
+// CPU side shadow of the scalar part of the CellRenderData uniform block, one
+// per VAO, used to skip the buffer upload entirely when nothing changed since
+// the last draw of that window.
+typedef struct {
+    struct CellRenderData rd;
+    uint32_t color_profile_generation;
+    bool filled;
+} UniformBlockShadow;
+
+static UniformBlockShadow *uniform_block_shadows = NULL;
+static size_t uniform_block_shadow_count = 0;
+
+static UniformBlockShadow*
+uniform_block_shadow_for(ssize_t vao_idx) {
+    if ((size_t)vao_idx >= uniform_block_shadow_count) {
+        size_t count = vao_idx + 8;
+        uniform_block_shadows = realloc(uniform_block_shadows, count * sizeof(UniformBlockShadow));
+        if (!uniform_block_shadows) fatal("Out of memory");
+        memset(uniform_block_shadows + uniform_block_shadow_count, 0, (count - uniform_block_shadow_count) * sizeof(UniformBlockShadow));
+        uniform_block_shadow_count = count;
+    }
+    return uniform_block_shadows + vao_idx;
+}
+
+// Cached offscreen copy of a window's rendered cell grid, one per VAO. When
+// neither the cell data nor the uniform block changed since the last draw the
+// cached texture is blitted instead of re-running the cell programs, so one
+// busy window does not make its idle neighbors re-render every frame.
+typedef struct {
+    GLuint framebuffer, texture;
+    unsigned int width, height;
+    GLfloat inactive_text_alpha;
+    bool valid;
+} WindowContentCache;
+
+static WindowContentCache *content_caches = NULL;
+static size_t content_cache_count = 0;
+
+static WindowContentCache*
+content_cache_for(ssize_t vao_idx) {
+    if ((size_t)vao_idx >= content_cache_count) {
+        size_t count = vao_idx + 8;
+        content_caches = realloc(content_caches, count * sizeof(WindowContentCache));
+        if (!content_caches) fatal("Out of memory");
+        memset(content_caches + content_cache_count, 0, (count - content_cache_count) * sizeof(WindowContentCache));
+        content_cache_count = count;
+    }
+    return content_caches + vao_idx;
+}
+
+static inline void
+invalidate_content_cache(ssize_t vao_idx) {
+    if ((size_t)vao_idx < content_cache_count) content_caches[vao_idx].valid = false;
+}
+
+void
+remove_cell_content_cache(ssize_t vao_idx) {
+    if ((size_t)vao_idx >= content_cache_count) return;
+    WindowContentCache *cc = content_caches + vao_idx;
+    if (cc->texture) free_texture(&cc->texture);
+    if (cc->framebuffer) free_framebuffer(&cc->framebuffer);
+    memset(cc, 0, sizeof(WindowContentCache));
+}
+
+// Pools of freed VAOs, one per layout kind. A VAO released by a closed window
+// keeps its attribute layout and driver side buffer allocations, so a new
+// window picks up warm GPU allocations instead of paying GL object creation
+// and first use buffer allocation on every split.
+typedef struct { ssize_t *items; size_t count, capacity; } VAOPool;
+static VAOPool cell_vao_pool = {0}, graphics_vao_pool = {0}, border_vao_pool = {0};
+
+static bool
+vao_pool_get(VAOPool *pool, ssize_t *vao_idx) {
+    if (!pool->count) return false;
+    *vao_idx = pool->items[--pool->count];
+    return true;
+}
+
+static void
+vao_pool_put(VAOPool *pool, ssize_t vao_idx) {
+    if (vao_idx < 0) return;
+    ensure_space_for(pool, items, ssize_t, pool->count + 1, capacity, 16, false);
+    pool->items[pool->count++] = vao_idx;
+}
+
+void
+free_cell_vao(ssize_t vao_idx) { vao_pool_put(&cell_vao_pool, vao_idx); }
+
+void
+free_graphics_vao(ssize_t vao_idx) { vao_pool_put(&graphics_vao_pool, vao_idx); }
+
+void
+free_border_vao(ssize_t vao_idx) { vao_pool_put(&border_vao_pool, vao_idx); }
+
 ssize_t
 create_cell_vao() {
-    ssize_t vao_idx = create_vao();
+    ssize_t vao_idx;
+    if (vao_pool_get(&cell_vao_pool, &vao_idx)) {
+        // stale per window caches must not suppress the first upload of the
+        // new window's content
+        uniform_block_shadow_for(vao_idx)->filled = false;
+        remove_cell_content_cache(vao_idx);
+        return vao_idx;
+    }
+    vao_idx = create_vao();
+    // VAO indices are reused, so any shadow left over from a previous window
+    // must not suppress the first upload into the freshly allocated buffer
+    uniform_block_shadow_for(vao_idx)->filled = false;
+    remove_cell_content_cache(vao_idx);
 #define A(name, size, dtype, offset, stride) \
     add_attribute_to_vao(CELL_PROGRAM, vao_idx, #name, \
             /*size=*/size, /*dtype=*/dtype, /*stride=*/stride, /*offset=*/offset, /*divisor=*/1);
-#define A1(name, size, dtype, offset) A(name, size, dtype, (void*)(offsetof(GPUCell, offset)), sizeof(GPUCell))
+#define A1(name, size, dtype, offset) A(name, size, dtype, (void*)(offsetof(PackedGPUCell, offset)), sizeof(PackedGPUCell))
 
     add_buffer_to_vao(vao_idx, GL_ARRAY_BUFFER);
     A1(sprite_coords, 4, GL_UNSIGNED_SHORT, sprite_x);
-    A1(colors, 3, GL_UNSIGNED_INT, fg);
+    A1(packed_colors, 1, GL_UNSIGNED_INT, colors);
 
     add_buffer_to_vao(vao_idx, GL_ARRAY_BUFFER);
     A(is_selected, 1, GL_UNSIGNED_BYTE, NULL, 0);
@@ -226,7 +438,9 @@ create_cell_vao() {
 
 ssize_t
 create_graphics_vao() {
-    ssize_t vao_idx = create_vao();
+    ssize_t vao_idx;
+    if (vao_pool_get(&graphics_vao_pool, &vao_idx)) return vao_idx;
+    vao_idx = create_vao();
     add_buffer_to_vao(vao_idx, GL_ARRAY_BUFFER);
     add_attribute_to_vao(GRAPHICS_PROGRAM, vao_idx, "src", 4, GL_FLOAT, 0, NULL, 0);
     return vao_idx;
@@ -251,67 +465,183 @@ send_graphics_data_to_gpu(size_t image_count, ssize_t gvao_idx, const ImageRende
 
 static inline void
 cell_update_uniform_block(ssize_t vao_idx, Screen *screen, int uniform_buffer, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, CursorRenderInfo *cursor, bool inverted, OSWindow *os_window) {
-    struct CellRenderData {
-        GLfloat xstart, ystart, dx, dy, sprite_dx, sprite_dy, background_opacity, cursor_text_uses_bg;
-
-        GLuint default_fg, default_bg, highlight_fg, highlight_bg, cursor_color, cursor_text_color, url_color, url_style, inverted;
-
-        GLuint xnum, ynum, cursor_fg_sprite_idx;
-        GLfloat cursor_x, cursor_y, cursor_w;
-    };
-    static struct CellRenderData *rd;
-
-    // Send the uniform data
-    rd = (struct CellRenderData*)map_vao_buffer(vao_idx, uniform_buffer, GL_WRITE_ONLY);
-    if (UNLIKELY(screen->color_profile->dirty || screen->reload_all_gpu_data)) {
-        copy_color_table_to_buffer(screen->color_profile, (GLuint*)rd, cell_program_layouts[CELL_PROGRAM].color_table.offset / sizeof(GLuint), cell_program_layouts[CELL_PROGRAM].color_table.stride / sizeof(GLuint));
-    }
+    struct CellRenderData rd;
+    zero_at_ptr(&rd);
     // Cursor position
     enum { BLOCK_IDX = 0, BEAM_IDX = 6, UNDERLINE_IDX = 7, UNFOCUSED_IDX = 8 };
     if (cursor->is_visible) {
-        rd->cursor_x = screen->cursor->x, rd->cursor_y = screen->cursor->y;
+        rd.cursor_x = screen->cursor->x, rd.cursor_y = screen->cursor->y;
         if (cursor->is_focused) {
             switch(cursor->shape) {
                 default:
-                    rd->cursor_fg_sprite_idx = BLOCK_IDX; break;
+                    rd.cursor_fg_sprite_idx = BLOCK_IDX; break;
                 case CURSOR_BEAM:
-                    rd->cursor_fg_sprite_idx = BEAM_IDX; break;
+                    rd.cursor_fg_sprite_idx = BEAM_IDX; break;
                 case CURSOR_UNDERLINE:
-                    rd->cursor_fg_sprite_idx = UNDERLINE_IDX; break;
+                    rd.cursor_fg_sprite_idx = UNDERLINE_IDX; break;
             }
-        } else rd->cursor_fg_sprite_idx = UNFOCUSED_IDX;
-    } else rd->cursor_x = screen->columns, rd->cursor_y = screen->lines;
-    rd->cursor_w = rd->cursor_x;
+        } else rd.cursor_fg_sprite_idx = UNFOCUSED_IDX;
+    } else rd.cursor_x = screen->columns, rd.cursor_y = screen->lines;
+    rd.cursor_w = rd.cursor_x;
     if (
-            (rd->cursor_fg_sprite_idx == BLOCK_IDX || rd->cursor_fg_sprite_idx == UNDERLINE_IDX) &&
+            (rd.cursor_fg_sprite_idx == BLOCK_IDX || rd.cursor_fg_sprite_idx == UNDERLINE_IDX) &&
             screen_current_char_width(screen) > 1
-    ) rd->cursor_w += 1;
+    ) rd.cursor_w += 1;
 
-    rd->xnum = screen->columns; rd->ynum = screen->lines;
+    rd.xnum = screen->columns; rd.ynum = screen->lines;
 
-    rd->xstart = xstart; rd->ystart = ystart; rd->dx = dx; rd->dy = dy;
+    rd.xstart = xstart; rd.ystart = ystart; rd.dx = dx; rd.dy = dy;
     unsigned int x, y, z;
     sprite_tracker_current_layout(os_window->fonts_data, &x, &y, &z);
-    rd->sprite_dx = 1.0f / (float)x; rd->sprite_dy = 1.0f / (float)y;
-    rd->inverted = inverted ? 1 : 0;
-    rd->background_opacity = os_window->is_semi_transparent ? os_window->background_opacity : 1.0f;
+    rd.sprite_dx = 1.0f / (float)x; rd.sprite_dy = 1.0f / (float)y;
+    rd.inverted = inverted ? 1 : 0;
+    rd.background_opacity = os_window->is_semi_transparent ? os_window->background_opacity : 1.0f;
 
 #define COLOR(name) colorprofile_to_color(screen->color_profile, screen->color_profile->overridden.name, screen->color_profile->configured.name)
-    rd->default_fg = COLOR(default_fg); rd->default_bg = COLOR(default_bg); rd->highlight_fg = COLOR(highlight_fg); rd->highlight_bg = COLOR(highlight_bg);
-    rd->cursor_text_color = COLOR(cursor_text_color);
+    rd.default_fg = COLOR(default_fg); rd.default_bg = COLOR(default_bg); rd.highlight_fg = COLOR(highlight_fg); rd.highlight_bg = COLOR(highlight_bg);
+    rd.cursor_text_color = COLOR(cursor_text_color);
 #undef COLOR
-    rd->cursor_color = cursor->color; rd->url_color = OPT(url_color); rd->url_style = OPT(url_style);
-    rd->cursor_text_uses_bg = cursor_text_as_bg(screen->color_profile);
+    rd.cursor_color = cursor->color; rd.url_color = OPT(url_color); rd.url_style = OPT(url_style);
+    rd.cursor_text_uses_bg = cursor_text_as_bg(screen->color_profile);
+
+    // Skip the upload when the GPU side copy is already current. A skipped
+    // frame never maps the buffer, so the previous contents, including the
+    // color table, stay valid on the GPU.
+    UniformBlockShadow *shadow = uniform_block_shadow_for(vao_idx);
+    if (shadow->filled && shadow->color_profile_generation == screen->color_profile->generation
+            && !screen->reload_all_gpu_data && memcmp(&rd, &shadow->rd, sizeof(rd)) == 0) return;
+
+    // Send the uniform data. The write map invalidates the buffer so the
+    // color table must be rewritten every time, not just when dirty.
+    GLuint *buf = map_vao_buffer(vao_idx, uniform_buffer, GL_WRITE_ONLY);
+    copy_color_table_to_buffer(screen->color_profile, buf, cell_program_layouts[CELL_PROGRAM].color_table.offset / sizeof(GLuint), cell_program_layouts[CELL_PROGRAM].color_table.stride / sizeof(GLuint));
+    memcpy(buf, &rd, sizeof(rd));
+    unmap_vao_buffer(vao_idx, uniform_buffer); buf = NULL;
+    shadow->rd = rd; shadow->color_profile_generation = screen->color_profile->generation; shadow->filled = true;
+    invalidate_content_cache(vao_idx);
+}
+
+// The truecolor side tables of all screens share one texture buffer, it is
+// re-uploaded before a draw whenever the screen being drawn or its table
+// changed. The tables are at most a few KB so this is cheap.
+static struct {
+    GLuint buffer, texture;
+    const Screen *uploaded_for;
+    uint32_t uploaded_generation;
+} truecolor_table_tbo = {0};
 
-    unmap_vao_buffer(vao_idx, uniform_buffer); rd = NULL;
+static void
+ensure_truecolor_table(Screen *screen) {
+    if (!truecolor_table_tbo.texture) {
+        glGenBuffers(1, &truecolor_table_tbo.buffer);
+        glGenTextures(1, &truecolor_table_tbo.texture);
+        glBindTexture(GL_TEXTURE_BUFFER, truecolor_table_tbo.texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, truecolor_table_tbo.buffer);
+        // a texture buffer must have a non-zero data store before it is used
+        static const uint32_t empty[3] = {0};
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(empty), empty, GL_STREAM_DRAW);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, truecolor_table_tbo.buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    // have to rebind every time as the texture may never have been bound in
+    // the context of the current OSWindow
+    glActiveTexture(GL_TEXTURE0 + TRUECOLOR_TABLE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, truecolor_table_tbo.texture);
+    if (screen->truecolor_table.count && (
+                truecolor_table_tbo.uploaded_for != screen ||
+                truecolor_table_tbo.uploaded_generation != screen->truecolor_table.generation)) {
+        glBindBuffer(GL_TEXTURE_BUFFER, truecolor_table_tbo.buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 3 * sizeof(uint32_t) * screen->truecolor_table.count, screen->truecolor_table.triples, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        truecolor_table_tbo.uploaded_for = screen;
+        truecolor_table_tbo.uploaded_generation = screen->truecolor_table.generation;
+    }
 }
 
-static inline bool
-cell_prepare_to_render(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, FONTS_DATA_HANDLE fonts_data) {
+// Cell data pack worker pool {{{
+// With many dirty windows (broadcast typing, synchronized panes) the per
+// window CPU prep bounds frame rate, not the GPU. The glyph rasterization
+// phase and all GL calls stay on the main thread, workers run only
+// screen_pack_cell_data(), which touches nothing but its own screen and the
+// mapped buffer it writes into, so packs for different windows are
+// independent and can run concurrently. Screens that are scrolled back are
+// never handed to the pool, since packing them reads history lines and the
+// compressed segment machinery behind those is main thread only.
+#define MAX_PACK_THREADS 8
+typedef struct { Screen *screen; void *address; } PackJob;
+static struct {
+    pthread_t threads[MAX_PACK_THREADS];
+    unsigned int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_available, work_done;
+    PackJob jobs[MAX_CHILDREN + 1];
+    size_t num_jobs, next_job, num_running;
+    bool started;
+} pack_pool = {.lock = PTHREAD_MUTEX_INITIALIZER, .work_available = PTHREAD_COND_INITIALIZER, .work_done = PTHREAD_COND_INITIALIZER};
+
+static void*
+pack_worker(void *data UNUSED) {
+    set_thread_name("KittyCellPack");
+    pthread_mutex_lock(&pack_pool.lock);
+    while (true) {
+        if (pack_pool.next_job >= pack_pool.num_jobs) { pthread_cond_wait(&pack_pool.work_available, &pack_pool.lock); continue; }
+        PackJob j = pack_pool.jobs[pack_pool.next_job++];
+        pack_pool.num_running++;
+        pthread_mutex_unlock(&pack_pool.lock);
+        screen_pack_cell_data(j.screen, j.address);
+        pthread_mutex_lock(&pack_pool.lock);
+        pack_pool.num_running--;
+        if (pack_pool.next_job >= pack_pool.num_jobs && !pack_pool.num_running) pthread_cond_signal(&pack_pool.work_done);
+    }
+    return NULL;
+}
+
+static void
+pack_pool_start(void) {
+    if (pack_pool.started) return;
+    pack_pool.started = true;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    // the main thread keeps working while the pool packs, so leave it a core
+    unsigned int n = cores > 1 ? (unsigned int)MIN((long)MAX_PACK_THREADS, cores - 1) : 0;
+    for (unsigned int i = 0; i < n; i++) {
+        if (pthread_create(pack_pool.threads + pack_pool.num_threads, NULL, pack_worker, NULL) == 0) pack_pool.num_threads++;
+        else break;
+    }
+}
+
+static void
+pack_pool_submit(Screen *screen, void *address) {
+    pack_pool_start();
+    if (!pack_pool.num_threads || pack_pool.num_jobs >= arraysz(pack_pool.jobs)) { screen_pack_cell_data(screen, address); return; }
+    pthread_mutex_lock(&pack_pool.lock);
+    pack_pool.jobs[pack_pool.num_jobs++] = (PackJob){.screen=screen, .address=address};
+    pthread_cond_signal(&pack_pool.work_available);
+    pthread_mutex_unlock(&pack_pool.lock);
+}
+
+static void
+pack_pool_wait(void) {
+    if (!pack_pool.num_jobs) return;
+    pthread_mutex_lock(&pack_pool.lock);
+    while (pack_pool.next_job < pack_pool.num_jobs || pack_pool.num_running) pthread_cond_wait(&pack_pool.work_done, &pack_pool.lock);
+    pack_pool.num_jobs = 0; pack_pool.next_job = 0;
+    pthread_mutex_unlock(&pack_pool.lock);
+}
+
+// windows whose pack job is in flight, their buffers are unmapped and their
+// truecolor tables uploaded once the pool is done, in finish_cell_data_prep()
+static struct {
+    struct { ssize_t vao_idx; Screen *screen; } items[MAX_CHILDREN + 1];
+    size_t count;
+} deferred_packs = {0};
+// }}}
+
+static bool
+cell_prepare_to_render(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, FONTS_DATA_HANDLE fonts_data, bool defer_pack) {
     size_t sz;
     CELL_BUFFERS;
     void *address;
-    bool changed = false;
+    bool changed = false, pack_deferred = false;
 
     ensure_sprite_map(fonts_data);
 
@@ -320,13 +650,51 @@ cell_prepare_to_render(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen, GLfloa
     bool disable_ligatures = screen->disable_ligatures == DISABLE_LIGATURES_CURSOR;
     bool screen_resized = screen->last_rendered.columns != screen->columns || screen->last_rendered.lines != screen->lines;
 
-    if (screen->reload_all_gpu_data || screen->scroll_changed || screen->is_dirty || screen_resized || (disable_ligatures && cursor_pos_changed)) {
-        sz = sizeof(GPUCell) * screen->lines * screen->columns;
+    bool cursor_needs_render = disable_ligatures && cursor_pos_changed;
+    if (screen->reload_all_gpu_data || screen->scroll_changed || screen_resized || screen->truecolor_table.needs_reset || ((screen->is_dirty || cursor_needs_render) && screen->scrolled_by)) {
+        sz = sizeof(PackedGPUCell) * screen->lines * screen->columns;
         address = alloc_and_map_vao_buffer(vao_idx, sz, cell_data_buffer, GL_STREAM_DRAW, GL_WRITE_ONLY);
-        screen_update_cell_data(screen, address, fonts_data, disable_ligatures && cursor_pos_changed);
-        unmap_vao_buffer(vao_idx, cell_data_buffer); address = NULL;
+        screen_prepare_cell_data(screen, fonts_data, cursor_needs_render);
+        // a scrolled viewport packs history lines, and reading those can
+        // decompress cold segments and trigger a budget sweep, both of which
+        // mutate state shared between all history buffers and so must stay on
+        // the main thread: pack scrolled screens inline
+        if (defer_pack && !screen->scrolled_by && address && deferred_packs.count < arraysz(deferred_packs.items)) {
+            // hand the packing to the pool, the buffer stays mapped until
+            // finish_cell_data_prep()
+            pack_pool_submit(screen, address);
+            deferred_packs.items[deferred_packs.count].vao_idx = vao_idx;
+            deferred_packs.items[deferred_packs.count++].screen = screen;
+            pack_deferred = true;
+        } else {
+            screen_pack_cell_data(screen, address);
+            unmap_vao_buffer(vao_idx, cell_data_buffer);
+        }
+        address = NULL;
         changed = true;
+    } else if (screen->is_dirty || cursor_needs_render) {
+        if (cursor_needs_render) screen_mark_cursor_dirty_lines(screen);
+        // the buffer on the GPU still holds the previous frame, as it is only
+        // re-allocated on resize, so upload just the rows that changed
+        static PackedGPUCell *packed_row = NULL;
+        static size_t packed_row_capacity = 0;
+        if (packed_row_capacity < screen->columns) {
+            packed_row_capacity = screen->columns;
+            packed_row = realloc(packed_row, sizeof(PackedGPUCell) * packed_row_capacity);
+            if (!packed_row) fatal("Out of memory");
+        }
+        size_t row_sz = sizeof(PackedGPUCell) * screen->columns;
+        for (index_type y = 0; y < screen->lines; y++) {
+            if (screen_update_line_data_if_dirty(screen, y, fonts_data, packed_row)) {
+                update_vao_buffer(vao_idx, cell_data_buffer, y * row_sz, row_sz, packed_row);
+                changed = true;
+            }
+        }
+        screen_finish_partial_update(screen);
     }
+    // an in flight pack job may still be adding entries to the truecolor
+    // table, so its upload waits for the pool in finish_cell_data_prep()
+    if (!pack_deferred) ensure_truecolor_table(screen);
 
     if (cursor_pos_changed) {
         screen->last_rendered.cursor_x = screen->cursor->x;
@@ -335,10 +703,21 @@ cell_prepare_to_render(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen, GLfloa
 
     if (screen->reload_all_gpu_data || screen_resized || screen_is_selection_dirty(screen)) {
         sz = (size_t)screen->lines * screen->columns;
-        address = alloc_and_map_vao_buffer(vao_idx, sz, selection_buffer, GL_STREAM_DRAW, GL_WRITE_ONLY);
-        screen_apply_selection(screen, address, sz);
-        unmap_vao_buffer(vao_idx, selection_buffer); address = NULL;
-        changed = true;
+        index_type first_row, row_limit;
+        // during a drag only the lines entering or leaving the selection are
+        // re-applied and re-uploaded, the rest of the buffer is untouched
+        if (!screen->reload_all_gpu_data && !screen_resized && screen_update_selection_map_incremental(screen, &first_row, &row_limit)) {
+            if (row_limit > first_row) {
+                update_vao_buffer(vao_idx, selection_buffer, (size_t)first_row * screen->columns,
+                        (size_t)(row_limit - first_row) * screen->columns, screen->selection_map.buf + (size_t)first_row * screen->columns);
+                changed = true;
+            }
+        } else {
+            address = alloc_and_map_vao_buffer(vao_idx, sz, selection_buffer, GL_STREAM_DRAW, GL_WRITE_ONLY);
+            screen_apply_selection(screen, address, sz);
+            unmap_vao_buffer(vao_idx, selection_buffer); address = NULL;
+            changed = true;
+        }
     }
 
     if (gvao_idx && grman_update_layers(screen->grman, screen->scrolled_by, xstart, ystart, dx, dy, screen->columns, screen->lines, screen->cell_size)) {
@@ -351,9 +730,11 @@ cell_prepare_to_render(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen, GLfloa
     return changed;
 }
 
+#define BLEND_ONTO_OPAQUE  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // blending onto opaque colors
+#define BLEND_PREMULT glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);  // blending of pre-multiplied colors
+
 static void
-draw_bg(OSWindow *w) {
-    blank_canvas(w->is_semi_transparent ? OPT(background_opacity) : 1.0f, OPT(background));
+draw_bg_image(OSWindow *w) {
     bind_program(BGIMAGE_PROGRAM);
     bind_vertex_array(blit_vertex_array);
 
@@ -375,6 +756,55 @@ draw_bg(OSWindow *w) {
     unbind_program();
 }
 
+static void
+draw_bg(OSWindow *w) {
+    // The background layer (clear color + background image) is static
+    // between resizes and image changes, so it is rendered once into a
+    // viewport sized texture and composited from there every frame, instead
+    // of resampling the source image on every pixel of every frame
+    unsigned int width = w->viewport_width, height = w->viewport_height;
+    if (!w->bgimage_cache.texture || w->bgimage_cache.width != width || w->bgimage_cache.height != height || w->bgimage_cache.source_texture != w->bgimage->texture_id) {
+        if (!w->bgimage_cache.framebuffer) glGenFramebuffers(1, &w->bgimage_cache.framebuffer);
+        if (!w->bgimage_cache.texture || w->bgimage_cache.width != width || w->bgimage_cache.height != height) {
+            if (!w->bgimage_cache.texture) glGenTextures(1, &w->bgimage_cache.texture);
+            glBindTexture(GL_TEXTURE_2D, w->bgimage_cache.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, w->bgimage_cache.framebuffer);
+        glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, w->bgimage_cache.texture, 0);
+        glViewport(0, 0, width, height);
+        // the caller has blending enabled, so this replicates exactly what
+        // drawing directly to the default framebuffer used to produce
+        blank_canvas(w->is_semi_transparent ? OPT(background_opacity) : 1.0f, OPT(background));
+        draw_bg_image(w);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glViewport(0, 0, w->viewport_width, w->viewport_height);
+        w->bgimage_cache.width = width; w->bgimage_cache.height = height;
+        w->bgimage_cache.source_texture = w->bgimage->texture_id;
+    }
+    // composite the cached layer, it already contains the final background
+    // pixels so blending is not wanted
+    glDisable(GL_BLEND);
+    bind_program(BLIT_PROGRAM); bind_vertex_array(blit_vertex_array);
+    static bool bg_blit_constants_set = false;
+    if (!bg_blit_constants_set) {
+        glUniform1i(glGetUniformLocation(program_id(BLIT_PROGRAM), "image"), BLIT_UNIT);
+        bg_blit_constants_set = true;
+    }
+    glActiveTexture(GL_TEXTURE0 + BLIT_UNIT);
+    glBindTexture(GL_TEXTURE_2D, w->bgimage_cache.texture);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    unbind_vertex_array();
+    unbind_program();
+    glEnable(GL_BLEND);
+    BLEND_ONTO_OPAQUE;
+}
+
 static void
 draw_graphics(int program, ssize_t vao_idx, ssize_t gvao_idx, ImageRenderData *data, GLuint start, GLuint count) {
     bind_program(program);
@@ -383,9 +813,12 @@ draw_graphics(int program, ssize_t vao_idx, ssize_t gvao_idx, ImageRenderData *d
 
     GLuint base = 4 * start;
     glEnable(GL_SCISSOR_TEST);
+    GLuint bound_texture = 0;
     for (GLuint i=0; i < count;) {
         ImageRenderData *rd = data + start + i;
-        glBindTexture(GL_TEXTURE_2D, rd->texture_id);
+        // consecutive groups often share a texture, notably when the images
+        // are packed into the atlas
+        if (rd->texture_id != bound_texture) { glBindTexture(GL_TEXTURE_2D, rd->texture_id); bound_texture = rd->texture_id; }
         // You could reduce the number of draw calls by using
         // glDrawArraysInstancedBaseInstance but Apple chose to abandon OpenGL
         // before implementing it.
@@ -395,9 +828,6 @@ draw_graphics(int program, ssize_t vao_idx, ssize_t gvao_idx, ImageRenderData *d
     bind_vertex_array(vao_idx);
 }
 
-#define BLEND_ONTO_OPAQUE  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);  // blending onto opaque colors
-#define BLEND_PREMULT glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);  // blending of pre-multiplied colors
-
 void
 draw_centered_alpha_mask(OSWindow *os_window, size_t screen_width, size_t screen_height, size_t width, size_t height, uint8_t *canvas) {
     static ImageRenderData data = {.group_count=1};
@@ -429,13 +859,18 @@ draw_centered_alpha_mask(OSWindow *os_window, size_t screen_width, size_t screen
 }
 
 static void
-draw_cells_simple(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen) {
+draw_cells_simple(ssize_t vao_idx, ssize_t gvao_idx, Screen *screen, bool premult_graphics) {
     bind_program(CELL_PROGRAM);
     glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, screen->lines * screen->columns);
     if (screen->grman->count) {
         glEnable(GL_BLEND);
-        BLEND_ONTO_OPAQUE;
-        draw_graphics(GRAPHICS_PROGRAM, vao_idx, gvao_idx, screen->grman->render_data, 0, screen->grman->count);
+        if (premult_graphics) {
+            BLEND_PREMULT;
+            draw_graphics(GRAPHICS_PREMULT_PROGRAM, vao_idx, gvao_idx, screen->grman->render_data, 0, screen->grman->count);
+        } else {
+            BLEND_ONTO_OPAQUE;
+            draw_graphics(GRAPHICS_PROGRAM, vao_idx, gvao_idx, screen->grman->render_data, 0, screen->grman->count);
+        }
         glDisable(GL_BLEND);
     }
 }
@@ -595,6 +1030,37 @@ set_cell_uniforms(float current_inactive_text_alpha, bool force) {
     }
 }
 
+void
+snapshot_frame_for_resize(OSWindow *os_window) {
+    // Copy the frame that is about to be presented into a texture, so that
+    // interim frames during a live resize can be drawn by scaling it instead
+    // of re-rendering, see render() in child-monitor.c
+    if (!os_window->resize_snapshot_texture_id) {
+        glGenTextures(1, &os_window->resize_snapshot_texture_id);
+        glBindTexture(GL_TEXTURE_2D, os_window->resize_snapshot_texture_id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else glBindTexture(GL_TEXTURE_2D, os_window->resize_snapshot_texture_id);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 0, 0, os_window->viewport_width, os_window->viewport_height, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void
+draw_resize_snapshot(OSWindow *os_window) {
+    bind_program(BLIT_PROGRAM); bind_vertex_array(blit_vertex_array);
+    static bool snapshot_blit_constants_set = false;
+    if (!snapshot_blit_constants_set) {
+        glUniform1i(glGetUniformLocation(program_id(BLIT_PROGRAM), "image"), BLIT_UNIT);
+        snapshot_blit_constants_set = true;
+    }
+    glActiveTexture(GL_TEXTURE0 + BLIT_UNIT);
+    glBindTexture(GL_TEXTURE_2D, os_window->resize_snapshot_texture_id);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
 void
 blank_canvas(float background_opacity, color_type color) {
     // See https://github.com/glfw/glfw/issues/1538 for why we use pre-multiplied alpha
@@ -604,26 +1070,204 @@ blank_canvas(float background_opacity, color_type color) {
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
+// Render timing instrumentation {{{
+// CPU timings are taken with monotonic(), GPU timings with pairs of
+// GL_TIMESTAMP queries whose results are collected on later frames so the
+// instrumentation never stalls the pipeline. Everything accumulates into
+// the per OS window RenderTimings, reported via the render-timings remote
+// control command.
+
+static inline unsigned
+render_timing_bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    unsigned bucket = 0;
+    while (us > 1 && bucket < RENDER_TIMING_HIST_BUCKETS - 1) { us >>= 1; bucket++; }
+    return bucket;
+}
+
+static inline void
+accumulate_cpu_timing(monotonic_t *total, monotonic_t *max, uint32_t *hist, monotonic_t duration) {
+    if (duration < 0) return;
+    *total += duration;
+    if (duration > *max) *max = duration;
+    hist[render_timing_bucket((uint64_t)duration)]++;
+}
+
+static void
+collect_gpu_timings(RenderTimings *rt) {
+    if (!rt->gpu_queries_created) return;
+    for (unsigned i = 0; i < RENDER_TIMING_MAX_GPU_QUERIES; i++) {
+        if (!rt->gpu_query_in_flight[i]) continue;
+        GLuint available = 0;
+        glGetQueryObjectuiv(rt->gpu_query_ids[2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(rt->gpu_query_ids[2 * i], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(rt->gpu_query_ids[2 * i + 1], GL_QUERY_RESULT, &end);
+        rt->gpu_query_in_flight[i] = false;
+        if (end <= start) continue;
+        uint64_t ns = end - start;
+        rt->gpu_draw_total_ns += ns;
+        if (ns > rt->gpu_draw_max_ns) rt->gpu_draw_max_ns = ns;
+        rt->gpu_draw_samples++;
+        rt->gpu_draw_hist[render_timing_bucket(ns)]++;
+    }
+}
+
+static int
+begin_gpu_timing(RenderTimings *rt) {
+    if (!rt->gpu_queries_created) {
+        glGenQueries(arraysz(rt->gpu_query_ids), rt->gpu_query_ids);
+        rt->gpu_queries_created = true;
+    }
+    collect_gpu_timings(rt);
+    for (unsigned i = 0; i < RENDER_TIMING_MAX_GPU_QUERIES; i++) {
+        if (rt->gpu_query_in_flight[i]) continue;
+        glQueryCounter(rt->gpu_query_ids[2 * i], GL_TIMESTAMP);
+        return (int)i;
+    }
+    return -1;  // all query pairs still in flight, skip this sample
+}
+
+static void
+end_gpu_timing(RenderTimings *rt, int slot) {
+    if (slot < 0) return;
+    glQueryCounter(rt->gpu_query_ids[2 * slot + 1], GL_TIMESTAMP);
+    rt->gpu_query_in_flight[slot] = true;
+}
+// }}}
+
+void
+start_cell_data_prep(ssize_t vao_idx, ssize_t gvao_idx, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, Screen *screen, OSWindow *os_window) {
+    if (!os_window->fonts_data || screen->render_prep.done) return;
+    monotonic_t started_at = monotonic();
+    screen->render_prep.changed = cell_prepare_to_render(vao_idx, gvao_idx, screen, xstart, ystart, dx, dy, os_window->fonts_data, true);
+    screen->render_prep.done = true;
+    RenderTimings *rt = &os_window->render_timings;
+    accumulate_cpu_timing(&rt->cpu_prepare_total, &rt->cpu_prepare_max, rt->cpu_prepare_hist, monotonic() - started_at);
+}
+
+void
+finish_cell_data_prep(void) {
+    pack_pool_wait();
+    CELL_BUFFERS;
+    for (size_t i = 0; i < deferred_packs.count; i++) {
+        unmap_vao_buffer(deferred_packs.items[i].vao_idx, cell_data_buffer);
+        ensure_truecolor_table(deferred_packs.items[i].screen);
+    }
+    deferred_packs.count = 0;
+}
+
 bool
 send_cell_data_to_gpu(ssize_t vao_idx, ssize_t gvao_idx, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, Screen *screen, OSWindow *os_window) {
     bool changed = false;
+    if (screen->render_prep.done) {
+        // prepared ahead of the draw, possibly on the worker pool
+        screen->render_prep.done = false;
+        changed = screen->render_prep.changed;
+        if (changed) invalidate_content_cache(vao_idx);
+        return changed;
+    }
     if (os_window->fonts_data) {
-        if (cell_prepare_to_render(vao_idx, gvao_idx, screen, xstart, ystart, dx, dy, os_window->fonts_data)) changed = true;
+        monotonic_t started_at = monotonic();
+        if (cell_prepare_to_render(vao_idx, gvao_idx, screen, xstart, ystart, dx, dy, os_window->fonts_data, false)) { changed = true; invalidate_content_cache(vao_idx); }
+        RenderTimings *rt = &os_window->render_timings;
+        accumulate_cpu_timing(&rt->cpu_prepare_total, &rt->cpu_prepare_max, rt->cpu_prepare_hist, monotonic() - started_at);
     }
     return changed;
 }
 
+static void
+draw_cells_from_cache(ssize_t vao_idx, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, Screen *screen, OSWindow *os_window, bool inverted, float current_inactive_text_alpha, RenderTimings *rt) {
+    CELL_BUFFERS;
+    // The uniform block is uploaded with coordinates that map the cell grid
+    // over the whole cache texture, so window position changes (resizes,
+    // layout switches) do not by themselves force a re-render
+    monotonic_t uniforms_started_at = monotonic();
+    cell_update_uniform_block(vao_idx, screen, uniform_buffer, -1.f, 1.f, 2.f / (GLfloat)screen->columns, 2.f / (GLfloat)screen->lines, &screen->cursor_render_info, inverted, os_window);
+    accumulate_cpu_timing(&rt->cpu_uniforms_total, &rt->cpu_uniforms_max, rt->cpu_uniforms_hist, monotonic() - uniforms_started_at);
+
+    WindowContentCache *cc = content_cache_for(vao_idx);
+    unsigned int width = screen->columns * os_window->fonts_data->cell_width, height = screen->lines * os_window->fonts_data->cell_height;
+    if (!cc->valid || cc->width != width || cc->height != height || cc->inactive_text_alpha != current_inactive_text_alpha) {
+        if (!cc->framebuffer) glGenFramebuffers(1, &cc->framebuffer);
+        if (!cc->texture || cc->width != width || cc->height != height) {
+            if (!cc->texture) glGenTextures(1, &cc->texture);
+            glBindTexture(GL_TEXTURE_2D, cc->texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        bind_vao_uniform_buffer(vao_idx, uniform_buffer, cell_program_layouts[CELL_PROGRAM].render_data.index);
+        bind_vertex_array(vao_idx);
+        set_cell_uniforms(current_inactive_text_alpha, screen->reload_all_gpu_data);
+        screen->reload_all_gpu_data = false;
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cc->framebuffer);
+        glFramebufferTexture(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, cc->texture, 0);
+        glViewport(0, 0, width, height);
+        int timing_slot = begin_gpu_timing(rt);
+        draw_cells_simple(vao_idx, 0, screen, false);
+        end_gpu_timing(rt, timing_slot);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glViewport(0, 0, os_window->viewport_width, os_window->viewport_height);
+        cc->valid = true; cc->width = width; cc->height = height; cc->inactive_text_alpha = current_inactive_text_alpha;
+    }
+    // Composite the cached texture into the window's rectangle. During a
+    // static live resize dx/dy are pre-scaled by the caller so the cached
+    // content is stretched into the new rectangle, matching the non-cached
+    // paths.
+#define SCALE(w, x) ((GLfloat)(os_window->viewport_##w) * (GLfloat)(x))
+    GLfloat w = (GLfloat)screen->columns * dx, h = (GLfloat)screen->lines * dy;
+    glViewport(
+        (GLint)roundf(SCALE(width, (xstart + 1.f)/2.f)),
+        (GLint)roundf(SCALE(height, (ystart - h + 1.f)/2.f)),
+        (GLsizei)roundf(SCALE(width, w / 2.f)),
+        (GLsizei)roundf(SCALE(height, h / 2.f))
+    );
+#undef SCALE
+    bind_program(BLIT_PROGRAM); bind_vertex_array(blit_vertex_array);
+    static bool cache_blit_constants_set = false;
+    if (!cache_blit_constants_set) {
+        glUniform1i(glGetUniformLocation(program_id(BLIT_PROGRAM), "image"), BLIT_UNIT);
+        cache_blit_constants_set = true;
+    }
+    glActiveTexture(GL_TEXTURE0 + BLIT_UNIT);
+    glBindTexture(GL_TEXTURE_2D, cc->texture);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    glViewport(0, 0, os_window->viewport_width, os_window->viewport_height);
+    unbind_vertex_array();
+    unbind_program();
+}
+
 void
 draw_cells(ssize_t vao_idx, ssize_t gvao_idx, GLfloat xstart, GLfloat ystart, GLfloat dx, GLfloat dy, Screen *screen, OSWindow *os_window, bool is_active_window, bool can_be_focused) {
     CELL_BUFFERS;
     bool inverted = screen_invert_colors(screen);
+    RenderTimings *rt = &os_window->render_timings;
+    rt->frame_count++;
+    TRACE_EVENT2(draw_cells, screen->window_id, screen->lines * screen->columns);
+
+    float current_inactive_text_alpha = (!can_be_focused || screen->cursor_render_info.is_focused) && is_active_window ? 1.0f : (float)OPT(inactive_text_alpha);
+    // Windows whose content is fully produced by the single pass cell program
+    // are rendered through the offscreen content cache, so clean windows cost
+    // one textured quad instead of re-running the cell programs every frame.
+    // Graphics, background images and semi-transparency compose against other
+    // content and are drawn directly.
+    if (!os_window->is_semi_transparent && !has_bgimage(os_window) && !screen->grman->count && os_window->fonts_data) {
+        draw_cells_from_cache(vao_idx, xstart, ystart, dx, dy, screen, os_window, inverted, current_inactive_text_alpha, rt);
+        return;
+    }
 
+    monotonic_t uniforms_started_at = monotonic();
     cell_update_uniform_block(vao_idx, screen, uniform_buffer, xstart, ystart, dx, dy, &screen->cursor_render_info, inverted, os_window);
+    accumulate_cpu_timing(&rt->cpu_uniforms_total, &rt->cpu_uniforms_max, rt->cpu_uniforms_hist, monotonic() - uniforms_started_at);
 
     bind_vao_uniform_buffer(vao_idx, uniform_buffer, cell_program_layouts[CELL_PROGRAM].render_data.index);
     bind_vertex_array(vao_idx);
 
-    float current_inactive_text_alpha = (!can_be_focused || screen->cursor_render_info.is_focused) && is_active_window ? 1.0f : (float)OPT(inactive_text_alpha);
     set_cell_uniforms(current_inactive_text_alpha, screen->reload_all_gpu_data);
     screen->reload_all_gpu_data = false;
     GLfloat w = (GLfloat)screen->columns * dx, h = (GLfloat)screen->lines * dy;
@@ -641,15 +1285,23 @@ draw_cells(ssize_t vao_idx, ssize_t gvao_idx, GLfloat xstart, GLfloat ystart, GL
         (GLsizei)roundf(SCALE(height, h / 2.f)) // height
     );
 #undef SCALE
+    // The multi-pass paths are only needed when images have to be composited
+    // under or between the text z-levels or a background image is present.
+    // Images entirely above the text are blended on top of the single cell
+    // pass, which also avoids the offscreen framebuffer round trip for
+    // semi-transparent windows.
+    bool images_straddle_text = screen->grman->num_of_negative_refs || screen->grman->num_of_below_refs;
+    int timing_slot = begin_gpu_timing(rt);
     if (os_window->is_semi_transparent) {
-        if (screen->grman->count || has_bgimage(os_window)) draw_cells_interleaved_premult(
+        if (images_straddle_text || has_bgimage(os_window)) draw_cells_interleaved_premult(
                 vao_idx, gvao_idx, screen, os_window, xstart, ystart, w, h);
-        else draw_cells_simple(vao_idx, gvao_idx, screen);
+        else draw_cells_simple(vao_idx, gvao_idx, screen, true);
     } else {
-        if (screen->grman->num_of_negative_refs || screen->grman->num_of_below_refs || has_bgimage(os_window)) draw_cells_interleaved(
+        if (images_straddle_text || has_bgimage(os_window)) draw_cells_interleaved(
                 vao_idx, gvao_idx, screen, os_window, xstart, ystart, w, h);
-        else draw_cells_simple(vao_idx, gvao_idx, screen);
+        else draw_cells_simple(vao_idx, gvao_idx, screen, false);
     }
+    end_gpu_timing(rt, timing_slot);
 }
 // }}}
 
@@ -671,7 +1323,9 @@ init_borders_program(void) {
 
 ssize_t
 create_border_vao(void) {
-    ssize_t vao_idx = create_vao();
+    ssize_t vao_idx;
+    if (vao_pool_get(&border_vao_pool, &vao_idx)) return vao_idx;
+    vao_idx = create_vao();
 
     add_buffer_to_vao(vao_idx, GL_ARRAY_BUFFER);
     add_attribute_to_vao(BORDERS_PROGRAM, vao_idx, "rect",
@@ -718,6 +1372,116 @@ draw_borders(ssize_t vao_idx, unsigned int num_border_rects, BorderRect *rect_bu
 
 // }}}
 
+// Program binary cache {{{
+// The generated GL loader targets core 3.3 so the ARB_get_program_binary
+// entry points are resolved at runtime via the windowing layer. When the
+// extension is missing everything falls back to plain source compilation.
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+
+typedef void (*glGetProgramBinary_func)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (*glProgramBinary_func)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (*glProgramParameteri_func)(GLuint program, GLenum pname, GLint value);
+static glGetProgramBinary_func get_program_binary = NULL;
+static glProgramBinary_func program_binary = NULL;
+static glProgramParameteri_func program_parameteri = NULL;
+static bool program_binary_functions_resolved = false;
+static char program_binary_cache_dir[2048] = {0};
+
+typedef struct {
+    uint64_t driver_hash, source_hash;
+    GLenum binary_format;
+    uint32_t binary_length;
+} ProgramBinaryHeader;
+
+static uint64_t
+shader_cache_hash(uint64_t h, const char *s) {
+    if (s) while (*s) { h ^= (unsigned char)(*s++); h *= 0x100000001b3ull; }
+    return h;
+}
+
+static uint64_t
+shader_cache_driver_hash(void) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    h = shader_cache_hash(h, (const char*)glGetString(GL_VENDOR));
+    h = shader_cache_hash(h, (const char*)glGetString(GL_RENDERER));
+    h = shader_cache_hash(h, (const char*)glGetString(GL_VERSION));
+    return h;
+}
+
+static bool
+program_binary_caching_available(void) {
+    if (!program_binary_cache_dir[0]) return false;
+    if (!program_binary_functions_resolved) {
+        program_binary_functions_resolved = true;
+        if (glfwExtensionSupported("GL_ARB_get_program_binary")) {
+            get_program_binary = (glGetProgramBinary_func)glfwGetProcAddress("glGetProgramBinary");
+            program_binary = (glProgramBinary_func)glfwGetProcAddress("glProgramBinary");
+            program_parameteri = (glProgramParameteri_func)glfwGetProcAddress("glProgramParameteri");
+        }
+    }
+    return get_program_binary && program_binary && program_parameteri;
+}
+
+static bool
+load_program_from_binary_cache(Program *program, int which, uint64_t source_hash) {
+    char path[sizeof(program_binary_cache_dir) + 64];
+    snprintf(path, sizeof(path), "%s/%d.bin", program_binary_cache_dir, which);
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    bool ok = false;
+    void *blob = NULL;
+    ProgramBinaryHeader h;
+    if (
+        fread(&h, sizeof(h), 1, f) == 1 && h.driver_hash == shader_cache_driver_hash() &&
+        h.source_hash == source_hash && h.binary_length > 0 && h.binary_length <= 64u * 1024u * 1024u &&
+        (blob = malloc(h.binary_length)) != NULL && fread(blob, 1, h.binary_length, f) == h.binary_length
+    ) {
+        program->id = glCreateProgram();
+        program_binary(program->id, h.binary_format, blob, h.binary_length);
+        GLint ret = GL_FALSE;
+        glGetProgramiv(program->id, GL_LINK_STATUS, &ret);
+        if (ret == GL_TRUE) ok = true;
+        else { glDeleteProgram(program->id); program->id = 0; }
+    }
+    free(blob); fclose(f);
+    return ok;
+}
+
+static void
+save_program_to_binary_cache(Program *program, int which, uint64_t source_hash) {
+    GLint capacity = 0;
+    glGetProgramiv(program->id, GL_PROGRAM_BINARY_LENGTH, &capacity);
+    if (capacity <= 0) return;
+    void *blob = malloc(capacity);
+    if (!blob) return;
+    ProgramBinaryHeader h = {.driver_hash = shader_cache_driver_hash(), .source_hash = source_hash};
+    GLsizei length = 0;
+    get_program_binary(program->id, capacity, &length, &h.binary_format, blob);
+    if (length > 0) {
+        h.binary_length = length;
+        char path[sizeof(program_binary_cache_dir) + 64], tmp[sizeof(program_binary_cache_dir) + 64];
+        snprintf(path, sizeof(path), "%s/%d.bin", program_binary_cache_dir, which);
+        snprintf(tmp, sizeof(tmp), "%s/%d.bin.tmp", program_binary_cache_dir, which);
+        FILE *f = fopen(tmp, "wb");
+        if (f) {
+            bool written = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(blob, 1, h.binary_length, f) == h.binary_length;
+            fclose(f);
+            if (written) rename(tmp, path); else unlink(tmp);
+        }
+    }
+    free(blob);
+}
+
+static PyObject*
+set_shader_program_cache_directory(PyObject UNUSED *self, PyObject *args) {
+    const char *path;
+    if (!PyArg_ParseTuple(args, "s", &path)) return NULL;
+    strncpy(program_binary_cache_dir, path, sizeof(program_binary_cache_dir) - 1);
+    Py_RETURN_NONE;
+}
+// }}}
+
 // Python API {{{
 static PyObject*
 compile_program(PyObject UNUSED *self, PyObject *args) {
@@ -728,11 +1492,21 @@ compile_program(PyObject UNUSED *self, PyObject *args) {
     if (which < 0 || which >= NUM_PROGRAMS) { PyErr_Format(PyExc_ValueError, "Unknown program: %d", which); return NULL; }
     Program *program = program_ptr(which);
     if (program->id != 0) { PyErr_SetString(PyExc_ValueError, "program already compiled"); return NULL; }
+    uint64_t source_hash = 0;
+    bool use_binary_cache = program_binary_caching_available();
+    if (use_binary_cache) {
+        source_hash = shader_cache_hash(shader_cache_hash(0xcbf29ce484222325ull, vertex_shader), fragment_shader);
+        if (load_program_from_binary_cache(program, which, source_hash)) {
+            init_uniforms(which);
+            return Py_BuildValue("I", program->id);
+        }
+    }
     program->id = glCreateProgram();
     vertex_shader_id = compile_shader(GL_VERTEX_SHADER, vertex_shader);
     fragment_shader_id = compile_shader(GL_FRAGMENT_SHADER, fragment_shader);
     glAttachShader(program->id, vertex_shader_id);
     glAttachShader(program->id, fragment_shader_id);
+    if (use_binary_cache) program_parameteri(program->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(program->id);
     GLint ret = GL_FALSE;
     glGetProgramiv(program->id, GL_LINK_STATUS, &ret);
@@ -745,6 +1519,7 @@ compile_program(PyObject UNUSED *self, PyObject *args) {
         goto end;
     }
     init_uniforms(which);
+    if (use_binary_cache) save_program_to_binary_cache(program, which, source_hash);
 
 end:
     if (vertex_shader_id != 0) glDeleteShader(vertex_shader_id);
@@ -778,6 +1553,43 @@ NO_ARG(init_borders_program)
 
 NO_ARG(init_cell_program)
 
+static PyObject*
+timing_hist_tuple(const uint32_t *hist) {
+    PyObject *t = PyTuple_New(RENDER_TIMING_HIST_BUCKETS);
+    if (!t) return NULL;
+    for (Py_ssize_t i = 0; i < RENDER_TIMING_HIST_BUCKETS; i++) PyTuple_SET_ITEM(t, i, PyLong_FromUnsignedLong(hist[i]));
+    return t;
+}
+
+static PyObject*
+get_render_timings(PyObject UNUSED *self, PyObject *args) {
+    unsigned long long os_window_id;
+    if (!PyArg_ParseTuple(args, "K", &os_window_id)) return NULL;
+    for (size_t i = 0; i < global_state.num_os_windows; i++) {
+        OSWindow *w = global_state.os_windows + i;
+        if (w->id != os_window_id) continue;
+        RenderTimings *rt = &w->render_timings;
+        return Py_BuildValue(
+            "{sK s{sd sd sN} s{sd sd sN} s{sK sd sd sN}}",
+            "frame_count", (unsigned long long)rt->frame_count,
+            "cell_prepare_cpu",
+                "total", monotonic_t_to_s_double(rt->cpu_prepare_total),
+                "max", monotonic_t_to_s_double(rt->cpu_prepare_max),
+                "histogram_us", timing_hist_tuple(rt->cpu_prepare_hist),
+            "uniforms_cpu",
+                "total", monotonic_t_to_s_double(rt->cpu_uniforms_total),
+                "max", monotonic_t_to_s_double(rt->cpu_uniforms_max),
+                "histogram_us", timing_hist_tuple(rt->cpu_uniforms_hist),
+            "draw_gpu",
+                "samples", (unsigned long long)rt->gpu_draw_samples,
+                "total", (double)rt->gpu_draw_total_ns / 1e9,
+                "max", (double)rt->gpu_draw_max_ns / 1e9,
+                "histogram_us", timing_hist_tuple(rt->gpu_draw_hist)
+        );
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject*
 sprite_map_set_limits(PyObject UNUSED *self, PyObject *args) {
     unsigned int w, h;
@@ -794,6 +1606,8 @@ sprite_map_set_limits(PyObject UNUSED *self, PyObject *args) {
 static PyMethodDef module_methods[] = {
     M(compile_program, METH_VARARGS),
     M(sprite_map_set_limits, METH_VARARGS),
+    M(get_render_timings, METH_VARARGS),
+    M(set_shader_program_cache_directory, METH_VARARGS),
     MW(create_vao, METH_NOARGS),
     MW(bind_vertex_array, METH_O),
     MW(unbind_vertex_array, METH_NOARGS),
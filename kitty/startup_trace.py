@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+# vim:fileencoding=utf-8
+# License: GPL v3 Copyright: 2020, Kovid Goyal <kovid at kovidgoyal.net>
+
+import os
+import sys
+from typing import List, Tuple
+
+from .fast_data_types import monotonic_ns, monotonic_start_time_ns
+
+# Timestamps use the same monotonic clock as the C side, with zero at
+# extension module load, so events recorded in C (first frame, first parse)
+# line up with events recorded here without any conversion.
+
+enabled = False
+events: List[Tuple[str, int]] = []
+# popped at import time so child processes never see it, the launcher sets it
+# unconditionally as it cannot know whether profiling was requested
+launched_at = os.environ.pop('KITTY_LAUNCHED_AT', None)
+
+
+def note(name: str) -> None:
+    # only the first occurrence of a phase is recorded, so instrumentation
+    # points that run again later in the process lifetime stay cheap
+    if enabled and all(n != name for n, _ in events):
+        events.append((name, monotonic_ns()))
+
+
+def init(output_path: str) -> None:
+    global enabled
+    enabled = True
+    if launched_at is not None:
+        events.append(('launcher_exec', int(launched_at) - monotonic_start_time_ns()))
+    events.append(('interpreter_ready', monotonic_ns()))
+    import atexit
+    atexit.register(flush, output_path)
+
+
+def as_chrome_trace() -> str:
+    import json
+    all_events = list(events)
+    try:
+        from .fast_data_types import perf_counters
+        main = perf_counters()['main']
+        for name, key in (('first_bytes_parsed', 'first_parse_at_ns'), ('first_frame_rendered', 'first_frame_at_ns')):
+            if main[key]:
+                all_events.append((name, main[key]))
+    except Exception:
+        pass  # the child monitor never started, e.g. when startup failed
+    all_events.sort(key=lambda x: x[1])
+    trace = []
+    prev_ts = all_events[0][1] if all_events else 0
+    for name, ts in all_events:
+        # each phase is emitted as a complete event spanning from the end of
+        # the previous phase, named for what finished at its end
+        trace.append({
+            'name': name, 'ph': 'X', 'pid': os.getpid(), 'tid': 1,
+            'ts': prev_ts // 1000, 'dur': (ts - prev_ts) // 1000,
+        })
+        prev_ts = ts
+    return json.dumps({'traceEvents': trace}, indent=2)
+
+
+def flush(output_path: str) -> None:
+    data = as_chrome_trace()
+    if output_path == '-':
+        print(data, file=sys.stderr)
+    else:
+        try:
+            with open(output_path, 'w') as f:
+                f.write(data)
+        except OSError as e:
+            print('Failed to write startup trace: {}'.format(e), file=sys.stderr)
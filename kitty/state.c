@@ -6,10 +6,48 @@
  */
 
 #include "state.h"
+#include "uthash.h"
 #include <math.h>
+#undef uthash_fatal
+#define uthash_fatal(msg) fatal(msg)
 
 GlobalState global_state = {{0}};
 
+// Window id index {{{
+// Maps kitty window id -> the ids of the containing OS window and tab. The
+// os_windows/tabs/windows arrays are reallocated and compacted as windows
+// come and go, so the index stores ids rather than pointers and lookups
+// resolve them with a scan over the handful of OS windows and tabs instead
+// of over every window in every tab.
+typedef struct WindowIndexEntry {
+    id_type window_id, os_window_id, tab_id;
+    UT_hash_handle hh;
+} WindowIndexEntry;
+
+static WindowIndexEntry *window_index = NULL;
+
+static inline void
+window_index_add(id_type window_id, id_type os_window_id, id_type tab_id) {
+    WindowIndexEntry *e = calloc(1, sizeof(WindowIndexEntry));
+    if (e == NULL) fatal("Out of memory");
+    e->window_id = window_id; e->os_window_id = os_window_id; e->tab_id = tab_id;
+    HASH_ADD(hh, window_index, window_id, sizeof(e->window_id), e);
+}
+
+static inline WindowIndexEntry*
+window_index_lookup(id_type window_id) {
+    WindowIndexEntry *e = NULL;
+    HASH_FIND(hh, window_index, &window_id, sizeof(window_id), e);
+    return e;
+}
+
+static inline void
+window_index_remove(id_type window_id) {
+    WindowIndexEntry *e = window_index_lookup(window_id);
+    if (e) { HASH_DEL(window_index, e); free(e); }
+}
+// }}}
+
 #define REMOVER(array, qid, count, destroy, capacity) { \
     for (size_t i = 0; i < count; i++) { \
         if (array[i].id == qid) { \
@@ -72,13 +110,11 @@ current_os_window() {
 
 OSWindow*
 os_window_for_kitty_window(id_type kitty_window_id) {
-    for (size_t i = 0; i < global_state.num_os_windows; i++) {
-        OSWindow *w = global_state.os_windows + i;
-        for (size_t t = 0; t < w->num_tabs; t++) {
-            Tab *tab = w->tabs + t;
-            for (size_t c = 0; c < tab->num_windows; c++) {
-                if (tab->windows[c].id == kitty_window_id) return w;
-            }
+    WindowIndexEntry *e = window_index_lookup(kitty_window_id);
+    if (e) {
+        for (size_t i = 0; i < global_state.num_os_windows; i++) {
+            OSWindow *w = global_state.os_windows + i;
+            if (w->id == e->os_window_id) return w;
         }
     }
     return NULL;
@@ -99,6 +135,7 @@ send_bgimage_to_gpu(BackgroundImageLayout layout, BackgroundImage *bgimage) {
     bgimage->texture_id = 0;
     send_image_to_gpu(&bgimage->texture_id, bgimage->bitmap, bgimage->width,
             bgimage->height, false, true, OPT(background_image_linear), r);
+    generate_bgimage_mipmaps(bgimage->texture_id, OPT(background_image_linear));
     free(bgimage->bitmap); bgimage->bitmap = NULL;
 }
 
@@ -169,9 +206,12 @@ create_gpu_resources_for_window(Window *w) {
 
 static inline void
 release_gpu_resources_for_window(Window *w) {
-    if (w->render_data.vao_idx > -1) remove_vao(w->render_data.vao_idx);
+    if (w->render_data.vao_idx > -1) remove_cell_content_cache(w->render_data.vao_idx);
+    // VAOs go back to their pools, windows are churned constantly by split
+    // workflows and re-using them keeps the driver side buffer allocations warm
+    free_cell_vao(w->render_data.vao_idx);
     w->render_data.vao_idx = -1;
-    if (w->render_data.gvao_idx > -1) remove_vao(w->render_data.gvao_idx);
+    free_graphics_vao(w->render_data.gvao_idx);
     w->render_data.gvao_idx = -1;
 }
 
@@ -195,7 +235,9 @@ add_window(id_type os_window_id, id_type tab_id, PyObject *title) {
         make_os_window_context_current(osw);
         zero_at_i(tab->windows, tab->num_windows);
         initialize_window(tab->windows + tab->num_windows, title, true);
-        return tab->windows[tab->num_windows++].id;
+        id_type wid = tab->windows[tab->num_windows++].id;
+        window_index_add(wid, osw->id, tab->id);
+        return wid;
     END_WITH_TAB;
     return 0;
 }
@@ -245,6 +287,7 @@ static inline void
 remove_window_inner(Tab *tab, id_type id) {
     id_type active_window_id = 0;
     if (tab->active_window < tab->num_windows) active_window_id = tab->windows[tab->active_window].id;
+    window_index_remove(id);
     REMOVER(tab->windows, id, tab->num_windows, destroy_window, tab->capacity);
     if (active_window_id) {
         for (unsigned int w = 0; w < tab->num_windows; w++) {
@@ -285,6 +328,7 @@ detach_window(id_type os_window_id, id_type tab_id, id_type id) {
                 make_os_window_context_current(osw);
                 release_gpu_resources_for_window(&tab->windows[i]);
                 add_detached_window(tab->windows + i);
+                window_index_remove(id);
                 zero_at_i(tab->windows, i);
                 remove_i_from_array(tab->windows, i, tab->num_windows);
                 break;
@@ -314,6 +358,7 @@ attach_window(id_type os_window_id, id_type tab_id, id_type id) {
                 memcpy(w, detached_windows.windows + i, sizeof(Window));
                 zero_at_i(detached_windows.windows, i);
                 remove_i_from_array(detached_windows.windows, i, detached_windows.num_windows);
+                window_index_add(id, osw->id, tab->id);
                 make_os_window_context_current(osw);
                 create_gpu_resources_for_window(w);
                 if (
@@ -331,7 +376,7 @@ attach_window(id_type os_window_id, id_type tab_id, id_type id) {
 static inline void
 destroy_tab(Tab *tab) {
     for (size_t i = tab->num_windows; i > 0; i--) remove_window_inner(tab, tab->windows[i - 1].id);
-    remove_vao(tab->border_rects.vao_idx);
+    free_border_vao(tab->border_rects.vao_idx);
     free(tab->border_rects.rect_buf); tab->border_rects.rect_buf = NULL;
     free(tab->windows); tab->windows = NULL;
 }
@@ -366,9 +411,13 @@ destroy_os_window_item(OSWindow *w) {
     }
     Py_CLEAR(w->window_title); Py_CLEAR(w->tab_bar_render_data.screen);
     if (w->offscreen_texture_id) free_texture(&w->offscreen_texture_id);
+    if (w->resize_snapshot_texture_id) free_texture(&w->resize_snapshot_texture_id);
     if (w->offscreen_framebuffer) free_framebuffer(&w->offscreen_framebuffer);
-    remove_vao(w->tab_bar_render_data.vao_idx);
-    remove_vao(w->gvao_idx);
+    if (w->bgimage_cache.texture) free_texture(&w->bgimage_cache.texture);
+    if (w->bgimage_cache.framebuffer) free_framebuffer(&w->bgimage_cache.framebuffer);
+    remove_cell_content_cache(w->tab_bar_render_data.vao_idx);
+    free_cell_vao(w->tab_bar_render_data.vao_idx);
+    free_graphics_vao(w->gvao_idx);
     free(w->tabs); w->tabs = NULL;
     free_bgimage(&w->bgimage, true);
     w->bgimage = NULL;
@@ -421,14 +470,25 @@ static void
 add_borders_rect(id_type os_window_id, id_type tab_id, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom, uint32_t color) {
     WITH_TAB(os_window_id, tab_id)
         BorderRects *br = &tab->border_rects;
-        br->is_dirty = true;
-        if (!left && !top && !right && !bottom) { br->num_border_rects = 0; return; }
-        ensure_space_for(br, rect_buf, BorderRect, br->num_border_rects + 1, capacity, 32, false);
-        BorderRect *r = br->rect_buf + br->num_border_rects++;
-        r->left = left; r->right = right; r->top = top; r->bottom = bottom; r->color = color;
+        if (!left && !top && !right && !bottom) { br->num_pending = 0; br->pending_changed = false; return; }
+        ensure_space_for(br, rect_buf, BorderRect, br->num_pending + 1, capacity, 32, false);
+        // rects overwrite the committed set in place, comparing as they go;
+        // commit_pending_border_rects() marks the VAO dirty only on a change
+        BorderRect r = {.left=left, .top=top, .right=right, .bottom=bottom, .color=color};
+        if (br->num_pending >= br->num_border_rects || memcmp(br->rect_buf + br->num_pending, &r, sizeof(BorderRect)) != 0) br->pending_changed = true;
+        br->rect_buf[br->num_pending++] = r;
     END_WITH_TAB
 }
 
+void
+commit_pending_border_rects(BorderRects *br) {
+    if (br->pending_changed || br->num_pending != br->num_border_rects) {
+        br->num_border_rects = br->num_pending;
+        br->pending_changed = false;
+        br->is_dirty = true;
+    }
+}
+
 
 void
 os_window_regions(OSWindow *os_window, Region *central, Region *tab_bar) {
@@ -686,6 +746,7 @@ PYWRAP1(set_options) {
     S(bell_border_color, color_as_int);
     S(repaint_delay, parse_ms_long_to_monotonic_t);
     S(input_delay, parse_ms_long_to_monotonic_t);
+    S(unfocused_output_limit, PyLong_AsUnsignedLong);
     S(sync_to_monitor, PyObject_IsTrue);
     S(close_on_child_death, PyObject_IsTrue);
     S(window_alert_on_bell, PyObject_IsTrue);
@@ -36,6 +36,7 @@ typedef struct {
     color_type url_color, background, foreground, active_border_color, inactive_border_color, bell_border_color;
     color_type mark1_foreground, mark1_background, mark2_foreground, mark2_background, mark3_foreground, mark3_background;
     monotonic_t repaint_delay, input_delay;
+    unsigned long unfocused_output_limit;
     bool focus_follows_mouse;
     unsigned int hide_window_decorations;
     bool macos_hide_from_tasks, macos_quit_when_last_window_closed, macos_window_resizable, macos_traditional_fullscreen;
@@ -109,6 +110,20 @@ typedef struct {
         double x, y;
         bool in_left_half_of_cell;
     } mouse_pos;
+    // motion tracking reports are coalesced per frame: only the latest
+    // position is stashed here and flushed from the main loop tick, see
+    // send_pending_mouse_motion_reports()
+    struct {
+        bool pending;
+        int button, mods;
+        int action;  // a MouseAction, DRAG or MOVE
+    } pending_mouse_motion;
+    // wheel events are coalesced the same way: ticks accumulate here and the
+    // net scroll is applied in one batch from the main loop tick
+    struct {
+        int lines;  // net accumulated scroll, positive means upwards
+        int mods;
+    } pending_scroll;
     struct {
         unsigned int left, top, right, bottom;
     } padding;
@@ -124,6 +139,11 @@ typedef struct {
 typedef struct {
     BorderRect *rect_buf;
     unsigned int num_border_rects, capacity;
+    // rects are recomputed on every layout, focus or bell change but usually
+    // come out identical, so newly computed ones are compared against the
+    // committed set and the VAO is re-uploaded only on an actual change
+    unsigned int num_pending;
+    bool pending_changed;
     bool is_dirty;
     ssize_t vao_idx;
 } BorderRects;
@@ -154,6 +174,24 @@ typedef struct {
 } LiveResizeInfo;
 
 
+#define RENDER_TIMING_HIST_BUCKETS 16
+#define RENDER_TIMING_MAX_GPU_QUERIES 4
+
+// Accumulated render pass timings for one OS window, maintained in
+// shaders.c and reported via the render-timings remote control command.
+// Histogram bucket i counts samples in [2**i, 2**(i+1)) microseconds.
+typedef struct {
+    uint64_t frame_count;
+    monotonic_t cpu_prepare_total, cpu_prepare_max;
+    monotonic_t cpu_uniforms_total, cpu_uniforms_max;
+    uint64_t gpu_draw_total_ns, gpu_draw_max_ns, gpu_draw_samples;
+    uint32_t cpu_prepare_hist[RENDER_TIMING_HIST_BUCKETS], cpu_uniforms_hist[RENDER_TIMING_HIST_BUCKETS], gpu_draw_hist[RENDER_TIMING_HIST_BUCKETS];
+    // rings of GL timestamp query pairs, results are collected when available
+    uint32_t gpu_query_ids[2 * RENDER_TIMING_MAX_GPU_QUERIES];
+    bool gpu_query_in_flight[RENDER_TIMING_MAX_GPU_QUERIES];
+    bool gpu_queries_created;
+} RenderTimings;
+
 typedef struct {
     void *handle;
     id_type id;
@@ -178,6 +216,12 @@ typedef struct {
     LiveResizeInfo live_resize;
     bool has_pending_resizes, is_semi_transparent, shown_once, is_damaged;
     uint32_t offscreen_texture_id;
+    // copy of the last fully rendered frame, blitted scaled during live
+    // resize with resize_draw_strategy scale
+    uint32_t resize_snapshot_texture_id;
+    // the background layer (clear color + background image) rendered once at
+    // viewport size, composited per frame instead of resampling the source image
+    struct { uint32_t framebuffer, texture, source_texture; unsigned int width, height; } bgimage_cache;
     unsigned int clear_count;
     color_type last_titlebar_color;
     float background_opacity;
@@ -185,10 +229,22 @@ typedef struct {
     id_type temp_font_group_id;
     enum RENDER_STATE render_state;
     monotonic_t last_render_frame_received_at;
+    // the refresh period of the monitor the window is currently on, zero
+    // when unknown, used to pace rendering when render frames are not in use
+    monotonic_t refresh_period, last_render_at;
     uint64_t render_calls;
     id_type last_focused_counter;
     ssize_t gvao_idx;
     CloseRequest close_request;
+    RenderTimings render_timings;
+    struct {
+        // regions of the framebuffer changed since the last swap, in pixels
+        // with origin at the top-left, converted to the GL convention and
+        // reported to the compositor at swap time
+        struct { int x, y, width, height; } rects[16];
+        size_t count;
+        bool full;
+    } frame_damage;
 } OSWindow;
 
 
@@ -243,16 +299,30 @@ OSWindow* current_os_window(void);
 void os_window_regions(OSWindow*, Region *main, Region *tab_bar);
 bool drag_scroll(Window *, OSWindow*);
 void draw_borders(ssize_t vao_idx, unsigned int num_border_rects, BorderRect *rect_buf, bool rect_data_is_dirty, uint32_t viewport_width, uint32_t viewport_height, color_type, unsigned int, bool, OSWindow *w);
+void commit_pending_border_rects(BorderRects *br);
 ssize_t create_cell_vao(void);
+void remove_cell_content_cache(ssize_t);
 ssize_t create_graphics_vao(void);
 ssize_t create_border_vao(void);
+// freed VAOs are pooled by layout kind and handed back out by the create
+// functions above, keeping their driver side buffer allocations warm
+void free_cell_vao(ssize_t vao_idx);
+void free_graphics_vao(ssize_t vao_idx);
+void free_border_vao(ssize_t vao_idx);
 bool send_cell_data_to_gpu(ssize_t, ssize_t, float, float, float, float, Screen *, OSWindow *);
+void start_cell_data_prep(ssize_t, ssize_t, float, float, float, float, Screen *, OSWindow *);
+void finish_cell_data_prep(void);
 void draw_cells(ssize_t, ssize_t, float, float, float, float, Screen *, OSWindow *, bool, bool);
 void draw_centered_alpha_mask(OSWindow *w, size_t screen_width, size_t screen_height, size_t width, size_t height, uint8_t *canvas);
 void update_surface_size(int, int, uint32_t);
+void snapshot_frame_for_resize(OSWindow *w);
+void draw_resize_snapshot(OSWindow *w);
 void free_texture(uint32_t*);
 void free_framebuffer(uint32_t*);
 void send_image_to_gpu(uint32_t*, const void*, int32_t, int32_t, bool, bool, bool, RepeatStrategy);
+void generate_bgimage_mipmaps(uint32_t, bool);
+void create_image_atlas_texture(uint32_t*, int32_t, int32_t);
+void send_image_to_gpu_atlas_region(uint32_t, const void*, int32_t, int32_t, int32_t, int32_t, bool);
 void send_sprite_to_gpu(FONTS_DATA_HANDLE fg, unsigned int, unsigned int, unsigned int, pixel*);
 void blank_canvas(float, color_type);
 void blank_os_window(OSWindow *);
@@ -282,3 +352,4 @@ void os_window_update_size_increments(OSWindow *window);
 void set_os_window_title_from_window(Window *w, OSWindow *os_window);
 void update_os_window_title(OSWindow *os_window);
 void fake_scroll(Window *w, int amount, bool upwards);
+void send_pending_mouse_motion_reports(void);
@@ -245,6 +245,8 @@ class TabBar:
         self.data_buffer_size = 0
         self.laid_out_once = False
         self.dirty = True
+        self.last_drawn_data: Optional[Tuple[TabBarData, ...]] = None
+        self.last_drawn_columns = 0
         self.screen = s = Screen(None, 1, 10, 0, self.cell_width, cell_height)
         s.color_profile.update_ansi_color_table(build_ansi_color_table(opts))
         s.color_profile.set_configured_colors(
@@ -294,6 +296,7 @@ class TabBar:
             self.draw_data = self.draw_data._replace(default_bg=color_from_int(spec['tab_bar_background']))
         elif 'background' in spec and not self.opts.tab_bar_background:
             self.draw_data = self.draw_data._replace(default_bg=color_from_int(spec['background']))
+        self.last_drawn_data = None
         fg = spec.get('inactive_tab_foreground', color_as_int(self.opts.inactive_tab_foreground))
         bg = spec.get('tab_bar_background', False)
         if bg is None:
@@ -313,6 +316,7 @@ class TabBar:
         s.resize(1, ncells)
         s.reset_mode(DECAWM)
         self.laid_out_once = True
+        self.last_drawn_data = None
         margin = (viewport_width - ncells * cell_width) // 2 + self.margin_width
         self.window_geometry = g = WindowGeometry(
             margin, tab_bar.top, viewport_width - margin, tab_bar.bottom, s.columns, s.lines)
@@ -327,13 +331,31 @@ class TabBar:
         if not self.laid_out_once:
             return
         s = self.screen
-        s.cursor.x = 0
-        s.erase_in_line(2, False)
+        data = tuple(data)
+        ld = self.last_drawn_data
+        if ld == data and self.last_drawn_columns == s.columns:
+            return  # the rendered row is already up-to-date
+        # Tab widths depend on the tab count, so the prefix of unchanged tabs
+        # can be re-used only when the count is the same and the last render
+        # did not overflow. An active tab draws into the cells of its
+        # predecessor in some styles, so start one tab before the first change.
+        first_changed = 0
+        if ld is not None and len(ld) == len(data) and self.last_drawn_columns == s.columns and len(self.cell_ranges) == len(ld):
+            while first_changed < len(data) and ld[first_changed] == data[first_changed]:
+                first_changed += 1
+            first_changed = max(0, first_changed - 1)
+        if first_changed:
+            cr = self.cell_ranges[:first_changed]
+            s.cursor.x = self.cell_ranges[first_changed][0]
+        else:
+            cr = []
+            s.cursor.x = 0
+        s.cursor.bg = s.cursor.fg = 0
+        s.erase_in_line(0 if first_changed else 2, False)
         max_title_length = max(1, (self.screen_geometry.xnum // max(1, len(data))) - 1)
-        cr = []
         last_tab = data[-1] if data else None
 
-        for i, t in enumerate(data):
+        for i, t in enumerate(data[first_changed:], first_changed):
             s.cursor.bg = self.active_bg if t.is_active else 0
             s.cursor.fg = self.active_fg if t.is_active else 0
             s.cursor.bold, s.cursor.italic = self.active_font_style if t.is_active else self.inactive_font_style
@@ -349,6 +371,8 @@ class TabBar:
                 break
         s.erase_in_line(0, False)  # Ensure no long titles bleed after the last tab
         self.cell_ranges = cr
+        self.last_drawn_data = data
+        self.last_drawn_columns = s.columns
 
     def destroy(self) -> None:
         self.screen.reset_callbacks()
@@ -4,16 +4,16 @@
 
 import weakref
 from collections import deque
-from contextlib import suppress
+from contextlib import contextmanager, suppress
 from functools import partial
 from operator import attrgetter
 from typing import (
-    Any, Deque, Dict, Generator, Iterator, List, NamedTuple, Optional, Pattern,
-    Sequence, Tuple, Union, cast
+    Any, Container, Deque, Dict, Generator, Iterator, List, NamedTuple,
+    Optional, Pattern, Sequence, Tuple, Union, cast
 )
 
 from .borders import Borders
-from .child import Child
+from .child import Child, KittenChild
 from .cli_stub import CLIOptions
 from .constants import appname
 from .fast_data_types import (
@@ -49,6 +49,7 @@ class SpecialWindowInstance(NamedTuple):
     overlay_for: Optional[int]
     env: Optional[Dict[str, str]]
     watchers: Optional[Watchers]
+    hosted_kitten: bool
 
 
 def SpecialWindow(
@@ -59,9 +60,10 @@ def SpecialWindow(
     cwd: Optional[str] = None,
     overlay_for: Optional[int] = None,
     env: Optional[Dict[str, str]] = None,
-    watchers: Optional[Watchers] = None
+    watchers: Optional[Watchers] = None,
+    hosted_kitten: bool = False
 ) -> SpecialWindowInstance:
-    return SpecialWindowInstance(cmd, stdin, override_title, cwd_from, cwd, overlay_for, env, watchers)
+    return SpecialWindowInstance(cmd, stdin, override_title, cwd_from, cwd, overlay_for, env, watchers, hosted_kitten)
 
 
 def add_active_id_to_history(items: Deque[int], item_id: int, maxlen: int = 64) -> None:
@@ -92,6 +94,7 @@ class Tab:  # {{{
         self.enabled_layouts = [x.lower() for x in getattr(session_tab, 'enabled_layouts', None) or self.opts.enabled_layouts]
         self.borders = Borders(self.os_window_id, self.id, self.opts)
         self.windows = WindowList(self)
+        self.relayout_on_window_add = True
         for i, which in enumerate('first second third fourth fifth sixth seventh eighth ninth tenth'.split()):
             setattr(self, which + '_window', partial(self.nth_window, num=i))
         self._last_used_layout: Optional[str] = None
@@ -135,9 +138,21 @@ class Tab:  # {{{
         self._current_layout_name = layout_name
         self.mark_tab_bar_dirty()
 
+    @contextmanager
+    def batch_window_adds(self) -> Generator[None, None, None]:
+        ' Defer the layout pass while adding multiple windows, doing a single one at the end '
+        self.relayout_on_window_add = False
+        try:
+            yield
+        finally:
+            self.relayout_on_window_add = True
+        self.mark_tab_bar_dirty()
+        self.relayout()
+
     def startup(self, session_tab: 'SessionTab') -> None:
-        for cmd in session_tab.windows:
-            self.new_special_window(cmd)
+        with self.batch_window_adds():
+            for cmd in session_tab.windows:
+                self.new_special_window(cmd)
         self.windows.set_active_window_group_for(self.windows.all_windows[session_tab.active_window_idx])
 
     def serialize_state(self) -> Dict[str, Any]:
@@ -271,7 +286,8 @@ class Tab:  # {{{
         cwd_from: Optional[int] = None,
         cwd: Optional[str] = None,
         env: Optional[Dict[str, str]] = None,
-        allow_remote_control: bool = False
+        allow_remote_control: bool = False,
+        hosted_kitten: bool = False
     ) -> Child:
         if cmd is None:
             if use_shell:
@@ -285,14 +301,16 @@ class Tab:  # {{{
         pwid = platform_window_id(self.os_window_id)
         if pwid is not None:
             fenv['WINDOWID'] = str(pwid)
-        ans = Child(cmd, cwd or self.cwd, self.opts, stdin, fenv, cwd_from, allow_remote_control=allow_remote_control)
+        child_cls = KittenChild if hosted_kitten else Child
+        ans = child_cls(cmd, cwd or self.cwd, self.opts, stdin, fenv, cwd_from, allow_remote_control=allow_remote_control)
         ans.fork()
         return ans
 
     def _add_window(self, window: Window, location: Optional[str] = None, overlay_for: Optional[int] = None) -> None:
         self.current_layout.add_window(self.windows, window, location, overlay_for)
-        self.mark_tab_bar_dirty()
-        self.relayout()
+        if self.relayout_on_window_add:
+            self.mark_tab_bar_dirty()
+            self.relayout()
 
     def new_window(
         self,
@@ -308,10 +326,12 @@ class Tab:  # {{{
         copy_colors_from: Optional[Window] = None,
         allow_remote_control: bool = False,
         marker: Optional[str] = None,
-        watchers: Optional[Watchers] = None
+        watchers: Optional[Watchers] = None,
+        hosted_kitten: bool = False
     ) -> Window:
         child = self.launch_child(
-            use_shell=use_shell, cmd=cmd, stdin=stdin, cwd_from=cwd_from, cwd=cwd, env=env, allow_remote_control=allow_remote_control)
+            use_shell=use_shell, cmd=cmd, stdin=stdin, cwd_from=cwd_from, cwd=cwd, env=env,
+            allow_remote_control=allow_remote_control, hosted_kitten=hosted_kitten)
         window = Window(
             self, child, self.opts, self.args, override_title=override_title,
             copy_colors_from=copy_colors_from, watchers=watchers
@@ -339,7 +359,8 @@ class Tab:  # {{{
             override_title=special_window.override_title,
             cwd_from=special_window.cwd_from, cwd=special_window.cwd, overlay_for=special_window.overlay_for,
             env=special_window.env, location=location, copy_colors_from=copy_colors_from,
-            allow_remote_control=allow_remote_control, watchers=special_window.watchers
+            allow_remote_control=allow_remote_control, watchers=special_window.watchers,
+            hosted_kitten=special_window.hosted_kitten
         )
 
     def close_window(self) -> None:
@@ -449,9 +470,9 @@ class Tab:  # {{{
     def move_window_backward(self) -> None:
         self.move_window(-1)
 
-    def list_windows(self, active_window: Optional[Window]) -> Generator[WindowDict, None, None]:
+    def list_windows(self, active_window: Optional[Window], window_fields: Optional[Container[str]] = None) -> Generator[WindowDict, None, None]:
         for w in self:
-            yield w.as_dict(is_focused=w is active_window)
+            yield w.as_dict(is_focused=w is active_window, fields=window_fields)
 
     def matches(self, field: str, pat: Pattern) -> bool:
         if field == 'id':
@@ -622,14 +643,14 @@ class TabManager:  # {{{
     def __len__(self) -> int:
         return len(self.tabs)
 
-    def list_tabs(self, active_tab: Optional[Tab], active_window: Optional[Window]) -> Generator[TabDict, None, None]:
+    def list_tabs(self, active_tab: Optional[Tab], active_window: Optional[Window], window_fields: Optional[Container[str]] = None) -> Generator[TabDict, None, None]:
         for tab in self:
             yield {
                 'id': tab.id,
                 'is_focused': tab is active_tab,
                 'title': tab.name or tab.title,
                 'layout': str(tab.current_layout.name),
-                'windows': list(tab.list_windows(active_window)),
+                'windows': list(tab.list_windows(active_window, window_fields)),
                 'active_window_history': list(tab.windows.active_window_history),
             }
 
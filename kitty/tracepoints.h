@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2021 Kovid Goyal <kovid at kovidgoyal.net>
+ *
+ * Distributed under terms of the GPL3 license.
+ */
+
+#pragma once
+
+// Static tracepoints for the hot paths, under the "kitty" provider. They are
+// nop instructions until a tracer (bpftrace, systemtap, dtrace) attaches, so
+// production builds can carry them at no cost. For example, to see which
+// window is generating parser load on a live kitty:
+//
+//   bpftrace -e 'usdt:/path/to/kitty:kitty:parse_bytes_start { @[arg0] = sum(arg1); }'
+//
+// When the sdt.h header is not installed at build time they compile to nothing.
+
+#if defined(__has_include) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TRACE_EVENT(name) DTRACE_PROBE(kitty, name)
+#define TRACE_EVENT1(name, a) DTRACE_PROBE1(kitty, name, a)
+#define TRACE_EVENT2(name, a, b) DTRACE_PROBE2(kitty, name, a, b)
+#define TRACE_EVENT3(name, a, b, c) DTRACE_PROBE3(kitty, name, a, b, c)
+#else
+#define TRACE_EVENT(name)
+#define TRACE_EVENT1(name, a)
+#define TRACE_EVENT2(name, a, b)
+#define TRACE_EVENT3(name, a, b, c)
+#endif
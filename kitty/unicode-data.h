@@ -3,14 +3,43 @@
 #define VS15 1285
 #define VS16 1286
 
-bool is_combining_char(char_type ch);
-bool is_ignored_char(char_type ch);
-bool is_word_char(char_type ch);
-bool is_CZ_category(char_type);
-bool is_P_category(char_type);
+// Category classification bits, all categories for a codepoint are fetched
+// together from a two stage lookup table in unicode-data.c
+#define UNICODE_CATEGORY_M 1u        // marks, including skin tone modifiers and ZWJ
+#define UNICODE_CATEGORY_IGNORED 2u  // Cc, Cf, Cs and non-characters, excluding ZWJ
+#define UNICODE_CATEGORY_WORD 4u     // L and N categories
+#define UNICODE_CATEGORY_CZ 8u       // C and Z categories
+#define UNICODE_CATEGORY_P 16u       // punctuation
+
+uint8_t unicode_classification(char_type ch);
 char_type codepoint_for_mark(combining_type m);
 combining_type mark_for_codepoint(char_type c);
 
+static inline bool
+is_combining_char(char_type ch) {
+    return unicode_classification(ch) & UNICODE_CATEGORY_M;
+}
+
+static inline bool
+is_ignored_char(char_type ch) {
+    return unicode_classification(ch) & UNICODE_CATEGORY_IGNORED;
+}
+
+static inline bool
+is_word_char(char_type ch) {
+    return unicode_classification(ch) & UNICODE_CATEGORY_WORD;
+}
+
+static inline bool
+is_CZ_category(char_type ch) {
+    return unicode_classification(ch) & UNICODE_CATEGORY_CZ;
+}
+
+static inline bool
+is_P_category(char_type ch) {
+    return unicode_classification(ch) & UNICODE_CATEGORY_P;
+}
+
 static inline bool
 is_url_char(uint32_t ch) {
     return ch && !is_CZ_category(ch);
@@ -118,18 +118,53 @@ wcswidth_step(WCSState *state, const char_type ch) {
     return ans;
 }
 
+static inline bool
+all_printable_ascii(uint64_t w) {
+    // true if every byte of w is in [0x20, 0x7e], using the usual SWAR
+    // range checks, carries can only cause false negatives which just means
+    // falling back to the per char state machine
+#define ONES UINT64_C(0x0101010101010101)
+#define HIGH UINT64_C(0x8080808080808080)
+    uint64_t lt_space = (w - (ONES * 0x20)) & ~w;  // high bit set in bytes < 0x20
+    uint64_t gt_tilde = (w + ONES) | w;  // high bit set in bytes > 0x7e
+    return ((lt_space | gt_tilde) & HIGH) == 0;
+#undef ONES
+#undef HIGH
+}
+
 PyObject *
 wcswidth_std(PyObject UNUSED *self, PyObject *str) {
     if (PyUnicode_READY(str) != 0) return NULL;
     int kind = PyUnicode_KIND(str);
     void *data = PyUnicode_DATA(str);
-    Py_ssize_t len = PyUnicode_GET_LENGTH(str), i;
+    Py_ssize_t len = PyUnicode_GET_LENGTH(str), i = 0;
     WCSState state;
     initialize_wcs_state(&state);
     size_t ans = 0;
-    for (i = 0; i < len; i++) {
-        char_type ch = PyUnicode_READ(kind, data, i);
-        ans += wcswidth_step(&state, ch);
+    if (kind == PyUnicode_1BYTE_KIND) {
+        const uint8_t *d = data;
+        while (i < len) {
+            // a block of printable ASCII is sixteen cells of width one and
+            // leaves the state machine where it was, so classify sixteen
+            // bytes at a time and only run the state machine over blocks
+            // containing control bytes. Combining chars, flags and emoji
+            // cannot occur in a one byte kind unicode string.
+            if (state.parser_state == NORMAL && i + 16 <= len) {
+                uint64_t w1, w2;
+                memcpy(&w1, d + i, sizeof(w1)); memcpy(&w2, d + i + 8, sizeof(w2));
+                if (all_printable_ascii(w1) && all_printable_ascii(w2)) {
+                    ans += 16; i += 16;
+                    state.prev_ch = d[i - 1]; state.prev_width = 1;
+                    continue;
+                }
+            }
+            ans += wcswidth_step(&state, d[i]); i++;
+        }
+    } else {
+        for (; i < len; i++) {
+            char_type ch = PyUnicode_READ(kind, data, i);
+            ans += wcswidth_step(&state, ch);
+        }
     }
     return PyLong_FromSize_t(ans);
 }
@@ -12,14 +12,16 @@ from functools import partial
 from gettext import gettext as _
 from itertools import chain
 from typing import (
-    Any, Callable, Deque, Dict, Iterable, List, Optional, Pattern, Sequence,
-    Tuple, Union
+    Any, Callable, Container, Deque, Dict, Iterable, List, Optional, Pattern,
+    Sequence, Tuple, Union, cast
 )
 
 from .child import ProcessDesc
 from .cli_stub import CLIOptions
 from .config import build_ansi_color_table
-from .constants import ScreenGeometry, WindowGeometry, appname, wakeup
+from .constants import (
+    ScreenGeometry, WindowGeometry, appname, cache_dir, wakeup
+)
 from .fast_data_types import (
     BGIMAGE_PROGRAM, BLIT_PROGRAM, CELL_BG_PROGRAM, CELL_FG_PROGRAM,
     CELL_PROGRAM, CELL_SPECIAL_PROGRAM, DCS, DECORATION, DIM,
@@ -27,7 +29,8 @@ from .fast_data_types import (
     MARK, MARK_MASK, OSC, REVERSE, SCROLL_FULL, SCROLL_LINE, SCROLL_PAGE,
     STRIKETHROUGH, TINT_PROGRAM, Screen, add_timer, add_window,
     cell_size_for_window, compile_program, get_boss, get_clipboard_string,
-    init_cell_program, pt_to_px, set_clipboard_string, set_titlebar_color,
+    init_cell_program, pt_to_px, resume_clipboard_request, set_clipboard_string,
+    set_shader_program_cache_directory, set_titlebar_color,
     set_window_padding, set_window_render_data, update_window_title,
     update_window_visibility, viewport_for_window
 )
@@ -44,6 +47,7 @@ from .utils import (
 )
 
 MatchPatternType = Union[Pattern[str], Tuple[Pattern[str], Optional[Pattern[str]]]]
+WRITE_STREAM_CHUNK_SZ = 1024 * 1024
 
 
 class WindowDict(TypedDict):
@@ -179,6 +183,12 @@ class LoadShaderPrograms:
     use_selection_fg = True
 
     def __call__(self, semi_transparent: bool = False) -> None:
+        try:
+            spcd = os.path.join(cache_dir(), 'shaders')
+            os.makedirs(spcd, exist_ok=True)
+            set_shader_program_cache_directory(spcd)
+        except OSError:
+            pass  # caching shader binaries is only an optimization
         compile_program(BLIT_PROGRAM, *load_shaders('blit'))
         v, f = load_shaders('cell')
 
@@ -313,6 +323,12 @@ class Window:
         self.os_window_id = tab.os_window_id
         self.tabref: Callable[[], Optional[TabType]] = weakref.ref(tab)
         self.clipboard_control_buffers = {'p': '', 'c': ''}
+        self.pending_clipboard_write: Optional[Dict[str, Any]] = None
+        self.write_stream_queue: Deque[memoryview] = deque()
+        self.paste_stream_tail = b''
+        self.paste_stream_bracketed = False
+        self.paste_stream_started = False
+        self.clipboard_transfer_paused = False
         self.destroyed = False
         self.geometry: WindowGeometry = WindowGeometry(0, 0, 0, 0, 0, 0)
         self.needs_layout = True
@@ -379,17 +395,42 @@ class Window:
         return 'Window(title={}, id={})'.format(
                 self.title, self.id)
 
-    def as_dict(self, is_focused: bool = False) -> WindowDict:
-        return dict(
+    def as_dict(self, is_focused: bool = False, fields: Optional[Container[str]] = None) -> WindowDict:
+        def wanted(field: str) -> bool:
+            return fields is None or field in fields
+        ans: Dict[str, Any] = dict(
             id=self.id,
             is_focused=is_focused,
             title=self.override_title or self.title,
-            pid=self.child.pid,
-            cwd=self.child.current_cwd or self.child.cwd,
-            cmdline=self.child.cmdline,
-            env=self.child.environ,
-            foreground_processes=self.child.foreground_processes
         )
+        # the remaining fields require reading process information, which can
+        # be expensive, so gather them only when asked for
+        if wanted('pid'):
+            ans['pid'] = self.child.pid
+        if wanted('cwd'):
+            ans['cwd'] = self.child.current_cwd or self.child.cwd
+        if wanted('cmdline'):
+            ans['cmdline'] = self.child.cmdline
+        if wanted('env'):
+            ans['env'] = self.child.environ
+        if wanted('foreground_processes'):
+            ans['foreground_processes'] = self.child.foreground_processes
+        return cast(WindowDict, ans)
+
+    def memory_stats(self) -> Dict[str, int]:
+        ' Bytes of memory used by this window, broken down by subsystem '
+        s = self.screen
+        ans: Dict[str, int] = {
+            'screen_bytes': s.linebuf.memory_used(),
+            'scrollback_bytes': s.historybuf.memory_used(),
+            'pager_history_bytes': s.historybuf.pagerhist_memory_used(),
+        }
+        if s.linebuf is not s.main_linebuf:
+            # the alternate screen is active, count the main screen too
+            ans['screen_bytes'] += s.main_linebuf.memory_used()
+        for k, v in s.grman.memory_used().items():
+            ans[f'graphics_{k}'] = v
+        return ans
 
     def serialize_state(self) -> Dict[str, Any]:
         return {
@@ -502,6 +543,41 @@ class Window:
             if get_boss().child_monitor.needs_write(self.id, data) is not True:
                 print('Failed to write to child %d as it does not exist' % self.id, file=sys.stderr)
 
+    def stream_to_child(self, data: Union[str, bytes]) -> None:
+        # Feed data to the child in chunks, waiting for the write buffer to
+        # drain between chunks, so that a multi-MB write is never buffered
+        # whole on the C side
+        if isinstance(data, str):
+            data = data.encode('utf-8')
+        if data:
+            self.write_stream_queue.append(memoryview(data))
+            if len(self.write_stream_queue) == 1:
+                self.flush_write_stream()
+
+    def flush_write_stream(self) -> None:
+        cm = get_boss().child_monitor
+        q = self.write_stream_queue
+        while q:
+            buf = q[0]
+            chunk = buf[:WRITE_STREAM_CHUNK_SZ]
+            if len(buf) > WRITE_STREAM_CHUNK_SZ:
+                q[0] = buf[WRITE_STREAM_CHUNK_SZ:]
+            else:
+                q.popleft()
+            if cm.needs_write(self.id, chunk) is not True:
+                q.clear()
+                print('Failed to write to child %d as it does not exist' % self.id, file=sys.stderr)
+                return
+            if q and cm.request_write_drain_notify(self.id):
+                return  # resumed by on_write_buffer_drained()
+
+    def on_write_buffer_drained(self) -> None:
+        if self.write_stream_queue and not self.destroyed:
+            self.flush_write_stream()
+        if self.clipboard_transfer_paused and not self.write_stream_queue:
+            self.clipboard_transfer_paused = False
+            resume_clipboard_request()
+
     def title_updated(self) -> None:
         update_window_title(self.os_window_id, self.tab_id, self.id, self.title)
         t = self.tabref()
@@ -590,7 +666,12 @@ class Window:
                     tab.relayout_borders()
 
     def title_changed(self, new_title: Optional[str]) -> None:
-        self.child_title = sanitize_title(new_title or self.default_title)
+        # shells commonly re-send the same title via OSC 0 on every prompt,
+        # dont trigger tab bar/window title updates in that case
+        title = sanitize_title(new_title or self.default_title)
+        if title == self.child_title:
+            return
+        self.child_title = title
         if self.override_title is None:
             self.title_updated()
 
@@ -719,7 +800,14 @@ class Window:
     def send_cmd_response(self, response: Any) -> None:
         self.screen.send_escape_code_to_child(DCS, '@kitty-cmd' + json.dumps(response))
 
-    def clipboard_control(self, data: str) -> None:
+    def clipboard_control(self, data: str, is_partial: bool = False) -> None:
+        if is_partial or self.pending_clipboard_write is not None:
+            # an over long payload being streamed out of the parser in chunks,
+            # see dispatch_osc52_chunk() in parser.c
+            chunk = self.clipboard_write_chunk(data, is_partial)
+            if chunk is not None:
+                self.write_clipboard_text(*chunk)
+            return
         where, text = data.partition(';')[::2]
         if not where:
             where = 's0'
@@ -742,26 +830,57 @@ class Window:
                 text = standard_b64decode(text).decode('utf-8')
             except Exception:
                 text = ''
-
-            def write(key: str, func: Callable[[str], None]) -> None:
-                if text:
-                    if ('no-append' in self.opts.clipboard_control or
-                            len(self.clipboard_control_buffers[key]) > 1024*1024):
-                        self.clipboard_control_buffers[key] = ''
-                    self.clipboard_control_buffers[key] += text
-                else:
+            self.write_clipboard_text(where, text)
+
+    def clipboard_write_chunk(self, data: str, is_partial: bool) -> Optional[Tuple[str, str]]:
+        # Accumulate a streamed OSC 52 payload, decoding base64 incrementally
+        # so that the undecoded payload is never held in full. Returns the
+        # (where, text) pair once the final chunk has arrived.
+        p = self.pending_clipboard_write
+        if p is None:
+            where, payload = data.partition(';')[::2]
+            p = self.pending_clipboard_write = {'where': where or 's0', 'carry': '', 'decoded': []}
+        else:
+            payload = data
+        payload = p['carry'] + payload
+        keep = len(payload) - len(payload) % 4
+        p['carry'] = payload[keep:]
+        if keep:
+            from base64 import standard_b64decode
+            try:
+                p['decoded'].append(standard_b64decode(payload[:keep]))
+            except Exception:
+                pass
+        if is_partial:
+            return None
+        self.pending_clipboard_write = None
+        try:
+            text = b''.join(p['decoded']).decode('utf-8')
+        except Exception:
+            text = ''
+        return p['where'], text
+
+    def write_clipboard_text(self, where: str, text: str) -> None:
+
+        def write(key: str, func: Callable[[str], None]) -> None:
+            if text:
+                if ('no-append' in self.opts.clipboard_control or
+                        len(self.clipboard_control_buffers[key]) > 1024*1024):
                     self.clipboard_control_buffers[key] = ''
-                func(self.clipboard_control_buffers[key])
-
-            if 's' in where or 'c' in where:
+                self.clipboard_control_buffers[key] += text
+            else:
+                self.clipboard_control_buffers[key] = ''
+            func(self.clipboard_control_buffers[key])
+
+        if 's' in where or 'c' in where:
+            if 'write-clipboard' in self.opts.clipboard_control:
+                write('c', set_clipboard_string)
+        if 'p' in where:
+            if self.opts.copy_on_select == 'clipboard':
                 if 'write-clipboard' in self.opts.clipboard_control:
                     write('c', set_clipboard_string)
-            if 'p' in where:
-                if self.opts.copy_on_select == 'clipboard':
-                    if 'write-clipboard' in self.opts.clipboard_control:
-                        write('c', set_clipboard_string)
-                if 'write-primary' in self.opts.clipboard_control:
-                    write('p', set_primary_selection)
+            if 'write-primary' in self.opts.clipboard_control:
+                write('p', set_primary_selection)
 
     def manipulate_title_stack(self, pop: bool, title: str, icon: Any) -> None:
         if title:
@@ -793,6 +912,10 @@ class Window:
     def destroy(self) -> None:
         self.call_watchers(self.watchers.on_close, {})
         self.destroyed = True
+        if self.clipboard_transfer_paused:
+            # unblock the clipboard transfer, its remaining data is discarded
+            self.clipboard_transfer_paused = False
+            resume_clipboard_request()
         if hasattr(self, 'screen'):
             # Remove cycles so that screen is de-allocated immediately
             self.screen.reset_callbacks()
@@ -874,7 +997,71 @@ class Window:
                 # Workaround for broken editors like nano that cannot handle
                 # newlines in pasted text see https://github.com/kovidgoyal/kitty/issues/994
                 text = text.replace(b'\r\n', b'\n').replace(b'\n', b'\r')
-            self.screen.paste(text)
+            if len(text) > WRITE_STREAM_CHUNK_SZ:
+                # stream large pastes so the write buffer never has to hold
+                # the whole paste at once
+                if self.screen.in_bracketed_paste_mode:
+                    text = b'\x1b[200~' + text + b'\x1b[201~'
+                self.stream_to_child(text)
+            else:
+                self.screen.paste(text)
+
+    def start_clipboard_paste(self) -> None:
+        self.paste_stream_tail = b''
+        self.paste_stream_bracketed = self.screen.in_bracketed_paste_mode
+        self.paste_stream_started = False
+        self.clipboard_transfer_paused = False
+
+    def process_paste_chunk(self, chunk: bytes, final: bool) -> bytes:
+        data = self.paste_stream_tail + chunk
+        self.paste_stream_tail = b''
+        if self.paste_stream_bracketed:
+            while True:
+                new_data = data.replace(b'\033[201~', b'').replace(b'\x9b201~', b'')
+                if len(new_data) == len(data):
+                    break
+                data = new_data
+            if not final:
+                # hold back a partial end marker so one split across chunks
+                # cannot sneak through
+                for n in range(min(len(data), 5), 0, -1):
+                    tail = data[-n:]
+                    if b'\033[201~'.startswith(tail) or b'\x9b201~'.startswith(tail):
+                        self.paste_stream_tail = tail
+                        data = data[:-n]
+                        break
+        else:
+            if not final and data.endswith(b'\r'):
+                # a \r\n pair could be split across chunks
+                self.paste_stream_tail = b'\r'
+                data = data[:-1]
+            data = data.replace(b'\r\n', b'\n').replace(b'\n', b'\r')
+        return data
+
+    def clipboard_paste_chunk(self, data: Optional[bytes]) -> bool:
+        # Receives clipboard data as it arrives from the source client, a
+        # None chunk marks the end of the transfer. Returning False pauses
+        # the transfer until the write buffer drains.
+        if self.destroyed:
+            return True  # let the transfer complete, discarding the data
+        final = data is None
+        out = self.process_paste_chunk(data or b'', final)
+        if self.paste_stream_bracketed:
+            if not self.paste_stream_started and out:
+                out = b'\x1b[200~' + out
+            if final and (self.paste_stream_started or out):
+                out += b'\x1b[201~'
+        if out:
+            self.paste_stream_started = True
+            self.stream_to_child(out)
+        if final:
+            return True
+        if self.write_stream_queue:
+            # the child is reading more slowly than the source is sending,
+            # leave the source waiting until the write buffer drains
+            self.clipboard_transfer_paused = True
+            return False
+        return True
 
     def copy_to_clipboard(self) -> None:
         text = self.text_for_selection()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# vim:fileencoding=utf-8
+# License: GPL v3 Copyright: 2021, Kovid Goyal <kovid at kovidgoyal.net>
+
+from argparse import ArgumentParser
+from random import Random
+from time import monotonic
+
+from . import BaseTest
+
+
+def plain_text_stream(rng):
+    # lines of mixed ASCII and unicode text, as produced by cat on a log file
+    words = ['error', 'warning', 'info', 'debug', '/usr/lib/libfoo.so.2', '1234', 'flügel', '日本語', 'x' * 40]
+    lines = []
+    cells = 0
+    for _ in range(2000):
+        w = rng.choices(words, k=rng.randint(2, 12))
+        line = ' '.join(w)
+        cells += sum(2 if ord(ch) > 0xffff or 0x2e80 <= ord(ch) <= 0x9fff else 1 for ch in line) + 1
+        lines.append(line)
+    return '\r\n'.join(lines).encode('utf-8'), cells
+
+
+def sgr_storm_stream(rng):
+    # colored output as produced by ls --color or grep on a large tree
+    sgrs = ['\x1b[31m', '\x1b[1;32m', '\x1b[0m', '\x1b[38;5;214m', '\x1b[38:2:100:50:25m', '\x1b[m']
+    chunks = []
+    cells = 0
+    for _ in range(5000):
+        word = 'word' * rng.randint(1, 4)
+        chunks.append(rng.choice(sgrs) + word + '\x1b[0m ')
+        cells += len(word) + 1
+    return (''.join(chunks) + '\r\n').encode('ascii'), cells
+
+
+def csi_heavy_stream(rng):
+    # full screen TUI redraws: lots of cursor positioning and clearing
+    chunks = []
+    cells = 0
+    for _ in range(3000):
+        y, x = rng.randint(1, 24), rng.randint(1, 80)
+        text = 'cell content'[:rng.randint(4, 12)]
+        chunks.append('\x1b[{};{}H\x1b[K{}'.format(y, x, text))
+        cells += len(text)
+    return ''.join(chunks).encode('ascii'), cells
+
+
+def osc_heavy_stream(rng):
+    # shell integration style output: titles and hyperlinks around short text
+    chunks = []
+    cells = 0
+    for i in range(2000):
+        text = 'file-{}.txt'.format(i)
+        chunks.append('\x1b]2;window title {}\x07'.format(i))
+        chunks.append('\x1b]8;;https://example.com/{}\x1b\\{}\x1b]8;;\x1b\\\r\n'.format(i, text))
+        cells += len(text) + 1
+    return ''.join(chunks).encode('ascii'), cells
+
+
+all_streams = {
+    'plain-text': plain_text_stream,
+    'sgr-storm': sgr_storm_stream,
+    'csi-heavy': csi_heavy_stream,
+    'osc-heavy': osc_heavy_stream,
+}
+
+
+def load_stream(name, seed='kitty-bench'):
+    rng = Random()
+    rng.seed(seed)
+    return all_streams[name](rng)
+
+
+class Benchmark(BaseTest):
+
+    def runTest(self):
+        pass
+
+
+def run_one(screen, data, cells, repetitions):
+    from kitty.fast_data_types import parse_bytes
+    parse_bytes(screen, b'\x1b[H\x1b[2J')
+    start = monotonic()
+    for _ in range(repetitions):
+        parse_bytes(screen, data)
+    duration = monotonic() - start
+    return len(data) * repetitions / duration, cells * repetitions / duration
+
+
+def main(args=()):
+    parser = ArgumentParser(description='Benchmark the VT escape code parser')
+    parser.add_argument('--repetitions', default=20, type=int, help='Number of times to replay each stream')
+    parser.add_argument('--seed', default='kitty-bench', type=str, help='Seed used to generate the streams')
+    parser.add_argument('streams', nargs='*', default=list(all_streams), help='Which streams to benchmark. Default is all of: {}'.format(', '.join(all_streams)))
+    opts = parser.parse_args(list(args))
+
+    bench = Benchmark()
+    screen = bench.create_screen(cols=80, lines=24, scrollback=1000)
+    for name in opts.streams:
+        data, cells = load_stream(name, opts.seed)
+        run_one(screen, data, cells, 1)  # warmup
+        bytes_per_sec, cells_per_sec = run_one(screen, data, cells, opts.repetitions)
+        print('{:12s} {:8.1f} MB/s {:10.2f} million cells/s'.format(name, bytes_per_sec / 1e6, cells_per_sec / 1e6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+# vim:fileencoding=utf-8
+# License: GPL v3 Copyright: 2021, Kovid Goyal <kovid at kovidgoyal.net>
+
+import json
+from argparse import ArgumentParser
+from statistics import mean, stdev
+from time import monotonic
+
+from . import BaseTest
+
+
+class Benchmark(BaseTest):
+
+    def runTest(self):
+        pass
+
+
+def timed(func, repetitions):
+    ans = []
+    for _ in range(repetitions):
+        st = monotonic()
+        func()
+        ans.append(monotonic() - st)
+    return ans
+
+
+def summarize(timings):
+    return {
+        'best_s': min(timings), 'worst_s': max(timings), 'mean_s': mean(timings),
+        'stdev_s': stdev(timings) if len(timings) > 1 else 0.,
+        'repetitions': len(timings),
+    }
+
+
+def sample_text(columns):
+    words = 'error /usr/lib/libfoo.so.2 undefined symbol 1234 warning flügel '
+    return (words * (columns // len(words) + 1))[:columns - 1]
+
+
+def fill_screen(screen, num_lines):
+    text = sample_text(screen.columns)
+    for _ in range(num_lines):
+        screen.draw(text)
+        screen.carriage_return()
+        screen.linefeed()
+
+
+def bench_scroll(bench, opts):
+    # lines/sec through screen_index with lines being pushed into history
+    s = bench.create_screen(cols=opts.columns, lines=24, scrollback=opts.scrollback)
+    num_lines = 10000
+
+    def run():
+        fill_screen(s, num_lines)
+
+    run()  # warmup, also moves the cursor to the last line
+    timings = timed(run, opts.repetitions)
+    ans = summarize(timings)
+    ans['lines_per_sec'] = num_lines / ans['mean_s']
+    return ans
+
+
+def bench_rewrap(bench, opts):
+    # resize at various scrollback depths. The rewrap of history is deferred
+    # until the scrollback is accessed, so time the two phases separately.
+    ans = {}
+    for depth in opts.depths:
+        s = bench.create_screen(cols=opts.columns, lines=24, scrollback=depth)
+        fill_screen(s, depth + 24)
+        resize_timings, rewrap_timings = [], []
+        for i in range(opts.repetitions):
+            columns = opts.columns + (i % 2) + 1  # alternate widths to force a rewrap
+            st = monotonic()
+            s.resize(24, columns)
+            resize_timings.append(monotonic() - st)
+            st = monotonic()
+            s.historybuf.line(0)  # resolves the deferred rewrap
+            rewrap_timings.append(monotonic() - st)
+        ans[str(depth)] = {'resize': summarize(resize_timings), 'rewrap': summarize(rewrap_timings)}
+    return ans
+
+
+def bench_as_text(bench, opts):
+    # selection/extraction throughput over the screen and its scrollback
+    s = bench.create_screen(cols=opts.columns, lines=24, scrollback=opts.scrollback)
+    fill_screen(s, opts.scrollback + 24)
+    ans = {}
+    for name, as_ansi in (('plain', False), ('ansi', True)):
+        chars = 0
+
+        def run():
+            nonlocal chars
+            lines = []
+            s.as_text_non_visual(lines.append, as_ansi, False)
+            chars = sum(map(len, lines))
+
+        run()  # warmup
+        timings = timed(run, opts.repetitions)
+        q = summarize(timings)
+        q['chars_per_sec'] = chars / q['mean_s']
+        ans[name] = q
+    return ans
+
+
+def bench_render(bench, opts):
+    # cost of rendering every line of a full-damage frame.
+    # screen_update_cell_data is not callable from python, render_line is the
+    # bulk of its work for a fully dirty screen
+    from kitty.fast_data_types import test_render_line
+    from kitty.fonts.render import setup_for_testing
+    with setup_for_testing():
+        s = bench.create_screen(cols=opts.columns, lines=24, scrollback=0)
+        fill_screen(s, 24)
+
+        def run():
+            for i in range(s.lines):
+                test_render_line(s.line(i))
+
+        run()  # warmup, fills the glyph cache as a steady-state frame would find it
+        timings = timed(run, opts.repetitions)
+        ans = summarize(timings)
+        ans['lines_per_sec'] = s.lines / ans['mean_s']
+        return ans
+
+
+all_benchmarks = {
+    'scroll': bench_scroll,
+    'rewrap': bench_rewrap,
+    'as-text': bench_as_text,
+    'render': bench_render,
+}
+
+
+def main(args=()):
+    parser = ArgumentParser(description='Benchmark screen scrolling, rewrap, text extraction and rendering')
+    parser.add_argument('--repetitions', default=20, type=int, help='Number of times to repeat each measurement')
+    parser.add_argument('--columns', default=100, type=int, help='Number of columns in the benchmarked screens')
+    parser.add_argument('--scrollback', default=10000, type=int, help='Scrollback size for the screens')
+    parser.add_argument('--depths', default=[100, 1000, 10000], type=int, nargs='*', help='Scrollback depths for the rewrap benchmark')
+    parser.add_argument(
+        'benchmarks', nargs='*', default=list(all_benchmarks),
+        help='Which benchmarks to run. Default is all of: {}'.format(', '.join(all_benchmarks)))
+    opts = parser.parse_args(list(args))
+
+    bench = Benchmark()
+    report = {name: all_benchmarks[name](bench, opts) for name in opts.benchmarks}
+    print(json.dumps(report, indent=2, sort_keys=True))
+
+
+if __name__ == '__main__':
+    main()
@@ -170,9 +170,9 @@ class TestDataTypes(BaseTest):
         l0.add_combining_char(0, '\U000e0100')
         self.ae(l0[0], ' \u0300\U000e0100')
         l0.add_combining_char(0, '\u0302')
-        self.ae(l0[0], ' \u0300\u0302')
+        self.ae(l0[0], ' \u0300\U000e0100\u0302')
         self.ae(l0[1], '\0')
-        self.ae(str(l0), ' \u0300\u0302')
+        self.ae(str(l0), ' \u0300\U000e0100\u0302')
         t = 'Testing with simple text'
         lb = LineBuf(2, len(t))
         l0 = lb.line(0)
@@ -478,6 +478,21 @@ class TestDataTypes(BaseTest):
         hb2 = HistoryBuf(large_hb.ynum, large_hb.xnum)
         large_hb.rewrap(hb2)
 
+    def test_find_text(self):
+        hb = filled_history_buf(5, 5)
+        # visual order, y == 0 is the oldest line, so '3' is on visual line 3
+        self.ae(hb.find_text('33'), ((3, 0), (3, 1), (3, 2), (3, 3)))
+        # extending the needle re-verifies the cached matches
+        self.ae(hb.find_text('333'), ((3, 0), (3, 1), (3, 2)))
+        self.ae(hb.find_text('3333'), ((3, 0), (3, 1)))
+        self.ae(hb.find_text('9'), ())
+        self.ae(hb.find_text(''), ())
+        # matches follow wrapped line boundaries
+        lb = create_lbuf('aaa', 'ab')
+        self.ae(lb.find_text('aab'), ((0, 2),))
+        self.ae(lb.find_text('AB'), ())
+        self.ae(lb.find_text('AB', True), ((1, 0),))
+
     def test_ansi_repr(self):
         lb = filled_line_buf()
         l0 = lb.line(0)
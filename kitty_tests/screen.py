@@ -444,6 +444,25 @@ class TestScreen(BaseTest):
         s.scroll(2, True)
         self.ae(s.text_for_selection(), expected)
 
+    def test_scan_text(self):
+        s = self.create_screen()
+        s.draw('xab12cd')
+        s.carriage_return(), s.linefeed()
+        s.draw('ef34')
+        self.ae(s.scan_text(('[0-9]+',)), [(0, 3, 5, '12'), (0, 10, 12, '34')])
+        self.ae(s.scan_text(('xab', 'ef')), [(0, 0, 3, 'xab'), (1, 8, 10, 'ef')])
+        self.assertRaises(ValueError, s.scan_text, ('[',))
+        # matches spanning wrapped lines and the scrollback
+        s = self.create_screen(cols=5, lines=2, scrollback=3)
+        for i in range(5):
+            if i != 0:
+                s.carriage_return(), s.linefeed()
+            s.draw('l{}'.format(i))
+        self.ae(s.scan_text(('l[0-9]',)), [(0, 0, 2, 'l3'), (0, 3, 5, 'l4')])
+        self.ae(
+            s.scan_text(('l[0-9]',), 2),
+            [(0, 0, 2, 'l1'), (0, 3, 5, 'l2'), (0, 6, 8, 'l3'), (0, 9, 11, 'l4')])
+
     def test_variation_selectors(self):
         s = self.create_screen()
         s.draw('\U0001f610')
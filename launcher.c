@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <libgen.h>
 #include <string.h>
 #include <errno.h>
@@ -99,6 +100,56 @@ end:
     if (Py_FinalizeEx() < 0) ret = 120;
     return ret;
 }
+#elif defined(FROZEN_MODULES)
+// Generated by setup.py: a single frozen module containing the bytecode of
+// the kitty and kittens packages and an importer that serves them from
+// memory, so cold start does not stat or read hundreds of files
+extern const struct _frozen kitty_frozen_modules[];
+
+static bool
+install_frozen_modules(void) {
+    // PyImport_FrozenModules holds the interpreter's own bootstrap modules,
+    // prepend ours in a merged table so those keep working
+    size_t ours = 0, builtin = 0;
+    while (kitty_frozen_modules[ours].name) ours++;
+    if (PyImport_FrozenModules) { while (PyImport_FrozenModules[builtin].name) builtin++; }
+    struct _frozen *merged = calloc(ours + builtin + 1, sizeof(struct _frozen));
+    if (merged == NULL) { fprintf(stderr, "Out of memory merging frozen module tables\n"); return false; }
+    memcpy(merged, kitty_frozen_modules, ours * sizeof(struct _frozen));
+    if (builtin) memcpy(merged + ours, PyImport_FrozenModules, builtin * sizeof(struct _frozen));
+    PyImport_FrozenModules = merged;
+    return true;
+}
+
+static int run_embedded(const char* exe_dir_, const char *libpath, int argc, wchar_t **argv, const char *lc_ctype) {
+    (void)libpath;
+    int ret = 1;
+    if (!install_frozen_modules()) return 1;
+    Py_SetProgramName(L"kitty");
+    wchar_t *exe_dir = Py_DecodeLocale(exe_dir_, NULL);
+    if (exe_dir == NULL) { fprintf(stderr, "Fatal error: cannot decode exe_dir: %s\n", exe_dir_); return 1; }
+    bool from_source = false;
+#ifdef FROM_SOURCE
+    from_source = true;
+#endif
+    Py_Initialize();
+    set_xoptions(exe_dir, lc_ctype, from_source);
+    PyMem_RawFree(exe_dir);
+    // same sys.argv as the Py_Main() based launcher, argv[1] is the lib dir
+    PySys_SetArgvEx(argc - 1, argv + 1, 0);
+    PyObject *importer = PyImport_ImportModule("kitty_frozen_importer");
+    if (importer == NULL) { PyErr_Print(); fprintf(stderr, "Unable to import the frozen module importer\n"); goto end; }
+    Py_CLEAR(importer);
+    PyObject *main_module = PyImport_ImportModule("__kitty_main__");
+    if (main_module == NULL) { PyErr_Print(); goto end; }
+    PyObject *res = PyObject_CallMethod(main_module, "main", NULL);
+    Py_CLEAR(main_module);
+    if (res == NULL) PyErr_Print();
+    else { ret = 0; Py_CLEAR(res); }
+end:
+    if (Py_FinalizeEx() < 0) ret = 120;
+    return ret;
+}
 #else
 static int run_embedded(const char* exe_dir_, const char *libpath, int argc, wchar_t **argv, const char *lc_ctype) {
     (void)libpath;
@@ -176,9 +227,28 @@ read_exe_path(char *exe, size_t buf_sz) {
 }
 #endif // }}}
 
+static void
+record_launch_time(void) {
+    // startup profiling (kitty/startup_trace.py) reads this to measure the
+    // time from exec to the interpreter being ready, same clock as
+    // kitty/monotonic.h
+    struct timespec ts = {0};
+#ifdef CLOCK_HIGHRES
+    clock_gettime(CLOCK_HIGHRES, &ts);
+#elif CLOCK_MONOTONIC_RAW
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", ((long long)ts.tv_sec * 1000000000ll) + (long long)ts.tv_nsec);
+    setenv("KITTY_LAUNCHED_AT", buf, 1);
+}
+
 int main(int argc, char *argv[]) {
     char exe[PATH_MAX+1] = {0};
     const char *lc_ctype = NULL;
+    record_launch_time();
 #ifdef __APPLE__
     lc_ctype = getenv("LC_CTYPE");
 #endif
@@ -62,10 +62,13 @@ class Options(argparse.Namespace):
     prefix: str = './linux-package'
     incremental: bool = True
     profile: bool = False
+    frozen_launcher: bool = False
     for_freeze: bool = False
     libdir_name: str = 'lib'
     extra_logging: List[str] = []
     link_time_optimization: bool = 'KITTY_NO_LTO' not in os.environ
+    static_glfw: bool = False
+    pgo: Optional[str] = None
     update_check_interval: float = 24
     egl_library: Optional[str] = os.getenv('KITTY_EGL_LIBRARY')
     startup_notification_library: Optional[str] = os.getenv('KITTY_STARTUP_NOTIFICATION_LIBRARY')
@@ -245,7 +248,8 @@ def init_env(
     egl_library: Optional[str] = None,
     startup_notification_library: Optional[str] = None,
     canberra_library: Optional[str] = None,
-    extra_logging: Iterable[str] = ()
+    extra_logging: Iterable[str] = (),
+    pgo: Optional[str] = None
 ) -> Env:
     native_optimizations = native_optimizations and not sanitize and not debug
     if native_optimizations and is_macos and is_arm:
@@ -303,6 +307,14 @@ def init_env(
         # See https://github.com/google/sanitizers/issues/647
         cflags.append('-flto')
         ldflags.append('-flto')
+    if pgo is not None:
+        which = '-fprofile-generate' if pgo == 'generate' else '-fprofile-use'
+        cflags.append(which)
+        ldflags.append(which)
+        if pgo == 'use' and cc == 'gcc':
+            # profiles collected from a threaded program are slightly
+            # inconsistent, gcc errors out on them without this
+            cflags.append('-fprofile-correction')
 
     if debug:
         cflags.append('-DKITTY_DEBUG_BUILD')
@@ -601,14 +613,14 @@ class CompilationDatabase:
             json.dump([{'output': c.key, 'arguments': c.cmd, 'directory': base} for c in self.link_commands], f, indent=2, sort_keys=True)
 
 
-def compile_c_extension(
+def compile_objects(
     kenv: Env,
     module: str,
     compilation_database: CompilationDatabase,
     sources: List[str],
     headers: List[str],
     desc_prefix: str = ''
-) -> None:
+) -> List[str]:
     prefix = os.path.basename(module)
     objects = [
         os.path.join(build_dir, prefix + '-' + os.path.basename(src) + '.o')
@@ -630,6 +642,19 @@ def compile_c_extension(
         key = CompileKey(original_src, os.path.basename(dest))
         desc = 'Compiling {} ...'.format(emphasis(desc_prefix + src))
         compilation_database.add_command(desc, cmd, partial(newer, dest, *dependecies_for(src, dest, headers)), key=key, keyfile=src)
+    return objects
+
+
+def compile_c_extension(
+    kenv: Env,
+    module: str,
+    compilation_database: CompilationDatabase,
+    sources: List[str],
+    headers: List[str],
+    desc_prefix: str = '',
+    extra_objects: Sequence[str] = ()
+) -> None:
+    objects = compile_objects(kenv, module, compilation_database, sources, headers, desc_prefix) + list(extra_objects)
     dest = os.path.join(build_dir, module + '.so')
     real_dest = module + '.so'
     os.makedirs(os.path.dirname(dest), exist_ok=True)
@@ -731,15 +756,31 @@ def init_env_from_args(args: Options, native_optimizations: bool = False) -> Non
     env = init_env(
         args.debug, args.sanitize, native_optimizations, args.link_time_optimization, args.profile,
         args.egl_library, args.startup_notification_library, args.canberra_library,
-        args.extra_logging
+        args.extra_logging, args.pgo
     )
 
 
 def build(args: Options, native_optimizations: bool = True) -> None:
     init_env_from_args(args, native_optimizations)
     sources, headers = find_c_files()
+    kenv = kitty_env()
+    extra_objects: List[str] = []
+    if args.static_glfw:
+        # compile the primary platform backend into the extension itself,
+        # glfw-wrapper.c then binds its function pointers to the linked
+        # symbols instead of dlopen()ing a backend library
+        module = 'cocoa' if is_macos else 'x11'
+        genv = glfw.init_env(env, pkg_config, at_least_version, test_compile, module)
+        kenv.cppflags.append('-DKITTY_STATIC_GLFW')
+        kenv.ldpaths += genv.ldpaths
+        glfw_sources = [os.path.join('glfw', x) for x in genv.sources]
+        glfw_headers = [os.path.join('glfw', x) for x in genv.all_headers]
+        extra_objects = compile_objects(
+            genv, 'kitty/glfw-{}-static'.format(module), args.compilation_database,
+            glfw_sources, glfw_headers, desc_prefix='[{} static] '.format(module))
     compile_c_extension(
-        kitty_env(), 'kitty/fast_data_types', args.compilation_database, sources, headers
+        kenv, 'kitty/fast_data_types', args.compilation_database, sources, headers,
+        extra_objects=extra_objects
     )
     compile_glfw(args.compilation_database)
     compile_kittens(args.compilation_database)
@@ -749,6 +790,100 @@ def safe_makedirs(path: str) -> None:
     os.makedirs(path, exist_ok=True)
 
 
+FROZEN_IMPORTER = '''\
+import marshal
+import os
+import sys
+from importlib.machinery import ModuleSpec
+
+_modules = marshal.loads(PAYLOAD)
+
+
+class KittyFrozenFinder:
+    # Serves the kitty and kittens packages from code objects embedded in the
+    # launcher binary, so importing them does not stat the filesystem or
+    # decode .pyc files. Extension modules and data files are not embedded,
+    # packages keep their real on disk locations so imports of
+    # fast_data_types and friends fall through to the normal path machinery.
+
+    def find_spec(self, name, path=None, target=None):
+        entry = _modules.get(name)
+        if entry is None:
+            return None
+        is_package, _, filename = entry
+        spec = ModuleSpec(name, self, origin=filename, is_package=is_package)
+        spec.has_location = True
+        if is_package:
+            spec.submodule_search_locations = [os.path.dirname(filename)]
+        return spec
+
+    def create_module(self, spec):
+        return None
+
+    def exec_module(self, module):
+        exec(_modules[module.__name__][1], module.__dict__)
+
+    def get_source(self, name):
+        # used by tracebacks, read from the real source files
+        entry = _modules.get(name)
+        if entry is None:
+            return None
+        try:
+            with open(entry[2]) as f:
+                return f.read()
+        except OSError:
+            return None
+
+
+sys.meta_path.insert(0, KittyFrozenFinder())
+'''
+
+
+def generate_frozen_modules() -> str:
+    import marshal
+    dest = os.path.join(build_dir, 'frozen-modules.c')
+    py_files = ['__main__.py']
+    for pkg in ('kitty', 'kittens'):
+        for root, dirs, files in os.walk(pkg):
+            dirs[:] = [d for d in dirs if d != '__pycache__']
+            py_files.extend(os.path.join(root, f) for f in sorted(files) if f.endswith('.py'))
+    if not newer(dest, *py_files):
+        return dest
+
+    def freeze(name: str, path: str, is_package: bool) -> Tuple[bool, object, str]:
+        path = os.path.abspath(path)
+        with open(path, 'rb') as f:
+            return is_package, compile(f.read(), path, 'exec'), path
+
+    table = {'__kitty_main__': freeze('__kitty_main__', '__main__.py', False)}
+    for path in py_files[1:]:
+        name = path[:-len('.py')].replace(os.sep, '.')
+        is_package = name.endswith('.__init__')
+        if is_package:
+            name = name[:-len('.__init__')]
+        table[name] = freeze(name, path, is_package)
+    src = FROZEN_IMPORTER.replace('PAYLOAD', repr(marshal.dumps(table)))
+    code = marshal.dumps(compile(src, '<frozen kitty_frozen_importer>', 'exec'))
+    lines = [
+        '/* Generated by setup.py, do not edit */',
+        '#include <Python.h>',
+        'static const unsigned char frozen_importer_code[] = {',
+    ]
+    for i in range(0, len(code), 24):
+        lines.append('    ' + ''.join('{},'.format(b) for b in code[i:i + 24]))
+    lines.extend((
+        '};',
+        'const struct _frozen kitty_frozen_modules[] = {',
+        '    {{"kitty_frozen_importer", frozen_importer_code, {}}},'.format(len(code)),
+        '    {0, 0, 0},',
+        '};',
+    ))
+    safe_makedirs(build_dir)
+    with open(dest, 'w') as f:
+        f.write('\n'.join(lines))
+    return dest
+
+
 def build_launcher(args: Options, launcher_dir: str = '.', bundle_type: str = 'source') -> None:
     cflags = '-Wall -Werror -fpie'.split()
     cppflags = []
@@ -788,11 +923,15 @@ def build_launcher(args: Options, launcher_dir: str = '.', bundle_type: str = 's
     os.makedirs(launcher_dir, exist_ok=True)
     dest = os.path.join(launcher_dir, 'kitty')
     src = 'launcher.c'
-    cmd = [env.cc] + cppflags + cflags + [
-           src, '-o', dest] + ldflags + libs + pylib
+    srcs = [src]
+    if args.frozen_launcher and bundle_type == 'source':
+        cppflags.append('-DFROZEN_MODULES')
+        srcs.append(generate_frozen_modules())
+    cmd = [env.cc] + cppflags + cflags + srcs + [
+           '-o', dest] + ldflags + libs + pylib
     key = CompileKey('launcher.c', 'kitty')
     desc = 'Building {}...'.format(emphasis('launcher'))
-    args.compilation_database.add_command(desc, cmd, partial(newer, dest, src), key=key, keyfile=src)
+    args.compilation_database.add_command(desc, cmd, partial(newer, dest, *srcs), key=key, keyfile=src)
     args.compilation_database.build_all()
 
 
@@ -1128,6 +1267,14 @@ def option_parser() -> argparse.ArgumentParser:  # {{{
         action='store_true',
         help='Use the -pg compile flag to add profiling information'
     )
+    p.add_argument(
+        '--frozen-launcher',
+        default=Options.frozen_launcher,
+        action='store_true',
+        help='Embed the bytecode of the kitty and kittens packages into the launcher binary,'
+        ' avoiding the filesystem stat storm and .pyc decoding during startup. Speeds up cold'
+        ' start significantly on slow (e.g. network) filesystems. Only used for source builds.'
+    )
     p.add_argument(
         '--for-freeze',
         default=Options.for_freeze,
@@ -1182,6 +1329,24 @@ def option_parser() -> argparse.ArgumentParser:  # {{{
         action='store_false',
         help='Turn off Link Time Optimization (LTO).'
     )
+    p.add_argument(
+        '--link-glfw-statically',
+        dest='static_glfw',
+        default=Options.static_glfw,
+        action='store_true',
+        help='Link the primary platform GLFW backend (cocoa on macOS, X11 elsewhere) directly'
+        ' into the kitty C extension instead of dlopen()ing it at startup, binding the wrapper'
+        ' function pointers to the linked symbols and letting LTO work across the boundary.'
+        ' Only for deployments that always ship the bundled GLFW; the other backends are not'
+        ' usable in such a build.'
+    )
+    p.add_argument(
+        '--pgo',
+        choices=('generate', 'use'),
+        default=Options.pgo,
+        help='Profile Guided Optimization. Build once with "generate", run a representative'
+        ' workload, then rebuild with "use" to optimize using the collected profiles.'
+    )
     return p
 # }}}
 
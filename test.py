@@ -77,8 +77,21 @@ def type_check() -> NoReturn:
     os.execlp(sys.executable, 'python', '-m', 'mypy', '--pretty')
 
 
+def run_benchmarks(args: Sequence[str]) -> None:
+    init_env()
+    from kitty_tests import bench_parser, bench_screen  # type: ignore
+    available = {'parser': bench_parser.main, 'screen': bench_screen.main}
+    if args and args[0] in available:
+        available[args[0]](args[1:])
+    else:
+        for bench_main in available.values():
+            bench_main(args)
+
+
 def run_tests() -> None:
     import argparse
+    if sys.argv[1:2] == ['bench']:
+        return run_benchmarks(sys.argv[2:])
     parser = argparse.ArgumentParser()
     parser.add_argument(
         'name', nargs='*', default=[],